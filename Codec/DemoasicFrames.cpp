@@ -150,6 +150,7 @@ void FastSharpeningBlurVW13A( short *Aptr,
 
 #define DEBAYER5x5		1
 #define CF_ENHANCE		1	//CineForm Enhancement Debayer
+#define DEBAYER_SSE2	1	//Vectorized interior of the demosaic rows (bit exact)
 
 inline void REDCELL(unsigned short *rgbptr, unsigned short *bayerptr, int width)
 {
@@ -340,6 +341,236 @@ inline void BLUCELL(unsigned short *rgbptr, unsigned short *bayerptr, int width)
 }
 
 
+#if DEBAYER_SSE2
+
+// Bayer sites that alternate along a row of the mosaic
+#define CELL_RED		0
+#define CELL_GRN_R		1	// green site on a red row
+#define CELL_GRN_B		2	// green site on a blue row
+#define CELL_BLU		3
+
+// Load the four samples at bayerptr[offset], bayerptr[offset+2], ... as 32-bit lanes.
+// Only the seven samples from offset to offset+6 are read since the first and last
+// cells of a row may be at the start or end of the buffer.
+static inline __m128i BayerSamples4(unsigned short *bayerptr, int offset)
+{
+	__m128i lo = _mm_loadl_epi64((__m128i *)&bayerptr[offset]);
+	__m128i hi = _mm_loadl_epi64((__m128i *)&bayerptr[offset+3]);
+
+	return _mm_unpacklo_epi64(_mm_and_si128(lo, _mm_set1_epi32(0xffff)), _mm_srli_epi32(hi, 16));
+}
+
+// Absolute difference of two vectors of 16-bit samples held in 32-bit lanes
+static inline __m128i AbsDiff4(__m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a));
+}
+
+// Low 32 bits of the lane products (SSE2 has no pmulld)
+static inline __m128i Multiply4(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+							  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+// Integer division truncated toward zero like the C operator.  The quotient of
+// two 32-bit integers is exact in double precision, so truncation matches.
+static inline __m128i Divide4(__m128i n, __m128i d)
+{
+	__m128d lo = _mm_div_pd(_mm_cvtepi32_pd(n), _mm_cvtepi32_pd(d));
+	__m128d hi = _mm_div_pd(_mm_cvtepi32_pd(_mm_srli_si128(n, 8)), _mm_cvtepi32_pd(_mm_srli_si128(d, 8)));
+
+	return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+}
+
+// Same for the small adaptive filter weights; numerators are below 2^24 so single precision is exact
+static inline __m128i DivideSmall4(__m128i n, __m128i d)
+{
+	return _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(n), _mm_cvtepi32_ps(d)));
+}
+
+// Square of values below 2^15 held in 32-bit lanes
+#define SQUARE4(a)		_mm_madd_epi16(a, a)
+
+// Compute the missing colors for four cells of the same type at bayerptr[0], [2], [4] and [6],
+// bit exact with REDCELL, GRNREDCELL, GRNBLUCELL and BLUCELL or the bilinear interpolation
+static inline void DebayerCell4(int cell, unsigned short *bayerptr, int width, int highquality,
+								__m128i *r, __m128i *g, __m128i *b)
+{
+	__m128i p0 = BayerSamples4(bayerptr, 0);
+	__m128i h1a = BayerSamples4(bayerptr, -1);
+	__m128i h1b = BayerSamples4(bayerptr, 1);
+	__m128i v1a = BayerSamples4(bayerptr, -width);
+	__m128i v1b = BayerSamples4(bayerptr, width);
+	__m128i h1 = _mm_add_epi32(h1a, h1b);
+	__m128i v1 = _mm_add_epi32(v1a, v1b);
+
+	if(cell == CELL_RED || cell == CELL_BLU)
+	{
+		__m128i d1a = BayerSamples4(bayerptr, -width-1);
+		__m128i d1b = BayerSamples4(bayerptr, width+1);
+		__m128i diag = _mm_add_epi32(_mm_add_epi32(d1a, d1b),
+									_mm_add_epi32(BayerSamples4(bayerptr, -width+1), BayerSamples4(bayerptr, width-1)));
+		__m128i cross = _mm_add_epi32(h1, v1);
+		__m128i same, other;
+
+		if(highquality)
+		{
+#if CF_ENHANCE
+			__m128i h2a = BayerSamples4(bayerptr, -2);
+			__m128i h2b = BayerSamples4(bayerptr, 2);
+			__m128i x2 = _mm_add_epi32(_mm_add_epi32(h2a, h2b),
+									 _mm_add_epi32(BayerSamples4(bayerptr, -2*width), BayerSamples4(bayerptr, 2*width)));
+			__m128i dS = SQUARE4(_mm_srli_epi32(AbsDiff4(h2a, h2b), 10));
+			__m128i dG = SQUARE4(_mm_srli_epi32(AbsDiff4(h1a, h1b), 10));
+			__m128i dO = SQUARE4(_mm_srli_epi32(AbsDiff4(d1a, d1b), 10));
+			__m128i two = _mm_set1_epi32(2);
+			__m128i factorG = _mm_add_epi32(two, DivideSmall4(_mm_slli_epi32(dS, 1), _mm_add_epi32(two, dG)));
+			__m128i factorO = _mm_add_epi32(_mm_set1_epi32(4), DivideSmall4(_mm_slli_epi32(dG, 2), _mm_add_epi32(two, dO)));
+			__m128i sum;
+
+			sum = _mm_sub_epi32(_mm_add_epi32(Multiply4(cross, factorG), _mm_slli_epi32(p0, 2)), x2);
+			same = Divide4(sum, _mm_slli_epi32(factorG, 2));
+
+			sum = _mm_sub_epi32(_mm_add_epi32(Multiply4(diag, factorO), Multiply4(p0, _mm_set1_epi32(12))),
+								Multiply4(x2, _mm_set1_epi32(3)));
+			other = Divide4(sum, _mm_slli_epi32(factorO, 2));
+#else
+			assert(0);
+			same = other = p0;
+#endif
+		}
+		else
+		{
+			same = _mm_srli_epi32(_mm_add_epi32(cross, _mm_set1_epi32(2)), 2);
+			other = _mm_srli_epi32(_mm_add_epi32(diag, _mm_set1_epi32(2)), 2);
+		}
+
+		*g = same;
+		if(cell == CELL_RED)
+			*r = p0, *b = other;
+		else
+			*b = p0, *r = other;
+	}
+	else
+	{
+		__m128i hval, vval;
+
+		if(highquality)
+		{
+#if CF_ENHANCE
+			__m128i h2a = BayerSamples4(bayerptr, -2);
+			__m128i h2b = BayerSamples4(bayerptr, 2);
+			__m128i v2a = BayerSamples4(bayerptr, -2*width);
+			__m128i v2b = BayerSamples4(bayerptr, 2*width);
+			__m128i h2 = _mm_add_epi32(h2a, h2b);
+			__m128i v2 = _mm_add_epi32(v2a, v2b);
+			__m128i diag = _mm_add_epi32(_mm_add_epi32(BayerSamples4(bayerptr, -width-1), BayerSamples4(bayerptr, -width+1)),
+										_mm_add_epi32(BayerSamples4(bayerptr, width-1), BayerSamples4(bayerptr, width+1)));
+			__m128i dG = (cell == CELL_GRN_R) ? AbsDiff4(h2a, h2b) : AbsDiff4(v2a, v2b);
+			__m128i dH = SQUARE4(_mm_srli_epi32(AbsDiff4(h1a, h1b), 10));
+			__m128i dV = SQUARE4(_mm_srli_epi32(AbsDiff4(v1a, v1b), 10));
+			__m128i two = _mm_set1_epi32(2);
+			__m128i eight = _mm_set1_epi32(8);
+			__m128i factorH, factorV, common, sum;
+
+			dG = _mm_slli_epi32(SQUARE4(_mm_srli_epi32(dG, 10)), 2);
+			factorH = _mm_add_epi32(eight, DivideSmall4(dG, _mm_add_epi32(two, dH)));
+			factorV = _mm_add_epi32(eight, DivideSmall4(dG, _mm_add_epi32(two, dV)));
+
+			// 10*center - 2*diagonals is shared by both colors
+			common = _mm_sub_epi32(Multiply4(p0, _mm_set1_epi32(10)), _mm_slli_epi32(diag, 1));
+
+			sum = _mm_add_epi32(_mm_sub_epi32(_mm_add_epi32(common, v2), _mm_slli_epi32(h2, 1)), Multiply4(h1, factorH));
+			hval = Divide4(sum, _mm_slli_epi32(factorH, 1));
+
+			sum = _mm_add_epi32(_mm_sub_epi32(_mm_add_epi32(common, h2), _mm_slli_epi32(v2, 1)), Multiply4(v1, factorV));
+			vval = Divide4(sum, _mm_slli_epi32(factorV, 1));
+#else
+			assert(0);
+			hval = vval = p0;
+#endif
+		}
+		else
+		{
+			hval = _mm_srli_epi32(_mm_add_epi32(h1, _mm_set1_epi32(1)), 1);
+			vval = _mm_srli_epi32(_mm_add_epi32(v1, _mm_set1_epi32(1)), 1);
+		}
+
+		*g = p0;
+		if(cell == CELL_GRN_R)
+			*r = hval, *b = vval;
+		else
+			*r = vval, *b = hval;
+	}
+}
+
+// Saturate the lanes of two vectors of four cells to 16 bits and interleave into eight pixels
+static inline __m128i BayerPixels8(__m128i even, __m128i odd)
+{
+	__m128i bias = _mm_set1_epi32(32768);
+	__m128i pixels = _mm_packs_epi32(_mm_sub_epi32(even, bias), _mm_sub_epi32(odd, bias));
+
+	pixels = _mm_xor_si128(pixels, _mm_set1_epi16((short)0x8000));
+	return _mm_unpacklo_epi16(pixels, _mm_srli_si128(pixels, 8));
+}
+
+// Demosaic the interior of a row eight pixels at a time and return the number of
+// pixels processed.  The caller finishes the remaining pixels with the scalar code.
+static int DebayerCellsSSE2(unsigned short *rgbptr, unsigned short *bayerptr, int width, int pixels,
+							int evencell, int oddcell, int highquality)
+{
+	__m128i zero = _mm_setzero_si128();
+	int count;
+
+	for(count = 0; count + 8 <= pixels; count += 8)
+	{
+		__m128i r0, g0, b0, r1, g1, b1;
+		__m128i R, G, B, RG, BZ, rgb;
+
+		DebayerCell4(evencell, bayerptr, width, highquality, &r0, &g0, &b0);
+		DebayerCell4(oddcell, bayerptr + 1, width, highquality, &r1, &g1, &b1);
+
+		R = BayerPixels8(r0, r1);
+		G = BayerPixels8(g0, g1);
+		B = BayerPixels8(b0, b1);
+
+		// Write pixels of four components, the fourth is overwritten by the next pixel
+		RG = _mm_unpacklo_epi16(R, G);
+		BZ = _mm_unpacklo_epi16(B, zero);
+		rgb = _mm_unpacklo_epi32(RG, BZ);
+		_mm_storel_epi64((__m128i *)&rgbptr[0], rgb);
+		_mm_storel_epi64((__m128i *)&rgbptr[3], _mm_srli_si128(rgb, 8));
+		rgb = _mm_unpackhi_epi32(RG, BZ);
+		_mm_storel_epi64((__m128i *)&rgbptr[6], rgb);
+		_mm_storel_epi64((__m128i *)&rgbptr[9], _mm_srli_si128(rgb, 8));
+
+		RG = _mm_unpackhi_epi16(R, G);
+		BZ = _mm_unpackhi_epi16(B, zero);
+		rgb = _mm_unpacklo_epi32(RG, BZ);
+		_mm_storel_epi64((__m128i *)&rgbptr[12], rgb);
+		_mm_storel_epi64((__m128i *)&rgbptr[15], _mm_srli_si128(rgb, 8));
+		rgb = _mm_unpackhi_epi32(RG, BZ);
+		_mm_storel_epi64((__m128i *)&rgbptr[18], rgb);
+
+		// Do not write past the last pixel
+		rgbptr[21] = (unsigned short)_mm_extract_epi16(rgb, 4);
+		rgbptr[22] = (unsigned short)_mm_extract_epi16(rgb, 5);
+		rgbptr[23] = (unsigned short)_mm_extract_epi16(rgb, 6);
+
+		bayerptr += 8;
+		rgbptr += 8*3;
+	}
+
+	return count;
+}
+
+#endif
+
+
 void FastSharpeningBlurHinplace(int width, unsigned short *sptr, int sharpness)
 {
 	int i=0,shift=2,B,C;
@@ -2958,7 +3189,14 @@ void DoDEBAYER_ORDER_RED_GRN(
 				blu[rgboffset] = (basebayer[offset-width]+basebayer[offset+width] + 1)>>1;
 				offset++, rgboffset+=pixelstride;
 
-				for(x=2;x<width-2;x+=2)
+				x = 2;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-2-x, CELL_RED, CELL_GRN_R, highquality);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-2;x+=2)
 				{
 					/*red cell*/
 					REDCELL(&red[rgboffset],&basebayer[offset], width);
@@ -2995,7 +3233,14 @@ void DoDEBAYER_ORDER_RED_GRN(
 				blu[rgboffset] = (basebayer[offset-width+1]+basebayer[offset+width+1] + 1)>>1;
 				offset++, rgboffset+=pixelstride;
 
-				for(x=1;x<width-1;x+=2)
+				x = 1;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-1-x, CELL_GRN_R, CELL_RED, 0);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-1;x+=2)
 				{
 					/*grn cell*/
 					grn[rgboffset] = basebayer[offset];
@@ -3065,7 +3310,14 @@ void DoDEBAYER_ORDER_RED_GRN(
 				blu[rgboffset] = basebayer[offset];
 				offset++, rgboffset+=pixelstride;
 
-				for(x=2;x<width-2;x+=2)
+				x = 2;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-2-x, CELL_GRN_B, CELL_BLU, highquality);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-2;x+=2)
 				{
 					/*grn*/
 					GRNBLUCELL(&red[rgboffset],&basebayer[offset], width);
@@ -3102,7 +3354,14 @@ void DoDEBAYER_ORDER_RED_GRN(
 				blu[rgboffset] = basebayer[offset+1];
 				offset++, rgboffset+=pixelstride;
 
-				for(x=1;x<width-1;x+=2)
+				x = 1;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-1-x, CELL_BLU, CELL_GRN_B, 0);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-1;x+=2)
 				{
 					/* blu */
 					grn[rgboffset] = (basebayer[offset-1]+basebayer[offset+1]+basebayer[offset-width]+basebayer[offset+width] + 2)>>2;
@@ -3222,7 +3481,14 @@ void DoDEBAYER_ORDER_GRN_BLU(
 				offset++, rgboffset+=pixelstride;
 
 
-				for(x=2;x<width-2;x+=2)
+				x = 2;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-2-x, CELL_GRN_B, CELL_BLU, highquality);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-2;x+=2)
 				{
 					/*grn cell*/
 					GRNBLUCELL(&red[rgboffset],&basebayer[offset], width);
@@ -3262,7 +3528,14 @@ void DoDEBAYER_ORDER_GRN_BLU(
 				offset++, rgboffset+=pixelstride;
 
 
-				for(x=1;x<width-1;x+=2)
+				x = 1;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-1-x, CELL_BLU, CELL_GRN_B, 0);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-1;x+=2)
 				{
 					/* blu */
 					grn[rgboffset] = (basebayer[offset-1]+basebayer[offset+1]+basebayer[offset-width]+basebayer[offset+width] + 2)>>2;
@@ -3331,7 +3604,14 @@ void DoDEBAYER_ORDER_GRN_BLU(
 				blu[rgboffset] = (basebayer[offset-width]+basebayer[offset+width] + 1)>>1;
 				offset++, rgboffset+=pixelstride;
 
-				for(x=2;x<width-2;x+=2)
+				x = 2;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-2-x, CELL_RED, CELL_GRN_R, highquality);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-2;x+=2)
 				{
 					/*red cell*/
 					REDCELL(&red[rgboffset],&basebayer[offset], width);
@@ -3369,7 +3649,14 @@ void DoDEBAYER_ORDER_GRN_BLU(
 				blu[rgboffset] = (basebayer[offset-width+1]+basebayer[offset+width+1] + 1)>>1;
 				offset++, rgboffset+=pixelstride;
 
-				for(x=1;x<width-1;x+=2)
+				x = 1;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-1-x, CELL_GRN_R, CELL_RED, 0);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-1;x+=2)
 				{
 					/*grn*/
 					grn[rgboffset] = basebayer[offset];
@@ -3487,7 +3774,14 @@ void DoDEBAYER_ORDER_GRN_RED(
 				blu[rgboffset] = (basebayer[offset-width-1]+basebayer[offset-width+1]+basebayer[offset+width-1]+basebayer[offset+width+1] + 2)>>2;
 				offset++, rgboffset+=pixelstride;
 
-				for(x=2;x<width-2;x+=2)
+				x = 2;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-2-x, CELL_GRN_R, CELL_RED, highquality);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-2;x+=2)
 				{
 					/*grn cell*/
 					GRNREDCELL(&red[rgboffset],&basebayer[offset], width);
@@ -3525,7 +3819,14 @@ void DoDEBAYER_ORDER_GRN_RED(
 				offset++, rgboffset+=pixelstride;
 
 
-				for(x=1;x<width-1;x+=2)
+				x = 1;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-1-x, CELL_RED, CELL_GRN_R, 0);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-1;x+=2)
 				{
 					/*red cell*/
 					grn[rgboffset] = (basebayer[offset-1]+basebayer[offset+1]+basebayer[offset-width]+basebayer[offset+width] + 2)>>2;
@@ -3594,7 +3895,14 @@ void DoDEBAYER_ORDER_GRN_RED(
 				blu[rgboffset] = (basebayer[offset-1]+basebayer[offset+1] + 1)>>1;
 				offset++, rgboffset+=pixelstride;
 
-				for(x=2;x<width-2;x+=2)
+				x = 2;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-2-x, CELL_BLU, CELL_GRN_B, highquality);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-2;x+=2)
 				{
 					/*blu*/
 					BLUCELL(&red[rgboffset],&basebayer[offset], width);
@@ -3632,7 +3940,14 @@ void DoDEBAYER_ORDER_GRN_RED(
 				blu[rgboffset] = basebayer[offset];
 				offset++, rgboffset+=pixelstride;
 
-				for(x=1;x<width-1;x+=2)
+				x = 1;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-1-x, CELL_GRN_B, CELL_BLU, 0);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-1;x+=2)
 				{
 					/*grn*/
 					grn[rgboffset] = basebayer[offset];
@@ -3750,7 +4065,14 @@ void DoDEBAYER_ORDER_BLU_GRN(
 				red[rgboffset] = (basebayer[offset-width]+basebayer[offset+width] + 1)>>1;
 				offset++, rgboffset+=pixelstride;
 
-				for(x=2;x<width-2;x+=2)
+				x = 2;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-2-x, CELL_BLU, CELL_GRN_B, highquality);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-2;x+=2)
 				{
 					/*b cell*/
 					BLUCELL(&red[rgboffset],&basebayer[offset], width);
@@ -3788,7 +4110,14 @@ void DoDEBAYER_ORDER_BLU_GRN(
 				red[rgboffset] = (basebayer[offset-width+1]+basebayer[offset+width+1] + 1)>>1;
 				offset++, rgboffset+=pixelstride;
 
-				for(x=1;x<width-1;x+=2)
+				x = 1;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-1-x, CELL_GRN_B, CELL_BLU, 0);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-1;x+=2)
 				{
 					/*grn cell*/
 					grn[rgboffset] = basebayer[offset];
@@ -3858,7 +4187,14 @@ void DoDEBAYER_ORDER_BLU_GRN(
 				red[rgboffset] = basebayer[offset];
 				offset++, rgboffset+=pixelstride;
 
-				for(x=2;x<width-2;x+=2)
+				x = 2;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-2-x, CELL_GRN_R, CELL_RED, highquality);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-2;x+=2)
 				{
 					/*grn*/
 					GRNREDCELL(&red[rgboffset],&basebayer[offset], width);
@@ -3896,7 +4232,14 @@ void DoDEBAYER_ORDER_BLU_GRN(
 				red[rgboffset] = basebayer[offset+1];
 				offset++, rgboffset+=pixelstride;
 
-				for(x=1;x<width-1;x+=2)
+				x = 1;
+#if DEBAYER_SSE2
+				{
+					int done = DebayerCellsSSE2(&red[rgboffset], &basebayer[offset], width, width-1-x, CELL_RED, CELL_GRN_R, 0);
+					x += done, offset += done, rgboffset += done*pixelstride;
+				}
+#endif
+				for(;x<width-1;x+=2)
 				{
 					/* r */
 					grn[rgboffset] = (basebayer[offset-1]+basebayer[offset+1]+basebayer[offset-width]+basebayer[offset+width] + 2)>>2;
@@ -5327,18 +5670,23 @@ void UpdateCFHDDATA(DECODER *decoder, unsigned char *ptr, int len, int delta, in
 
 			if (!found)
 			{
-		#if _ALLOCATOR
-				if (decoder->mdc[decoder->metadatachunks])
+				// The chunk list is rebuilt on every frame so keep the buffer if it is large enough
+				if (decoder->mdc[decoder->metadatachunks] == NULL || decoder->mdc_limit[decoder->metadatachunks] < (unsigned int)len)
 				{
-					Free(decoder->allocator, decoder->mdc[decoder->metadatachunks]);
-					decoder->mdc_size[decoder->metadatachunks] = NULL;
-				}
-				decoder->mdc[decoder->metadatachunks] = (unsigned char *)Alloc(decoder->allocator, len);
+		#if _ALLOCATOR
+					if (decoder->mdc[decoder->metadatachunks])
+					{
+						Free(decoder->allocator, decoder->mdc[decoder->metadatachunks]);
+						decoder->mdc_size[decoder->metadatachunks] = 0;
+					}
+					decoder->mdc[decoder->metadatachunks] = (unsigned char *)Alloc(decoder->allocator, len);
 		#else
-				if(decoder->mdc[decoder->metadatachunks])
-					MEMORY_FREE(decoder->mdc[decoder->metadatachunks]);
-				decoder->mdc[decoder->metadatachunks] = (unsigned char *)MEMORY_ALLOC(len);
+					if(decoder->mdc[decoder->metadatachunks])
+						MEMORY_FREE(decoder->mdc[decoder->metadatachunks]);
+					decoder->mdc[decoder->metadatachunks] = (unsigned char *)MEMORY_ALLOC(len);
 		#endif
+					decoder->mdc_limit[decoder->metadatachunks] = decoder->mdc[decoder->metadatachunks] ? len : 0;
+				}
 				if (decoder->mdc[decoder->metadatachunks])
 				{
 					memcpy(decoder->mdc[decoder->metadatachunks], ptr, len);
@@ -6551,6 +6899,7 @@ void UpdateCFHDDATA(DECODER *decoder, unsigned char *ptr, int len, int delta, in
 						{
 							memcpy(decoder->DataBases[localpri], data, size);
 							decoder->DataBasesSize[localpri] = (unsigned int)size;
+							decoder->DataBasesGeneration[localpri] = 0;
 						}
 						else
 						{
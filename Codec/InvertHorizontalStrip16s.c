@@ -12924,9 +12924,10 @@ void InvertHorizontalStrip16sRGB2YR16(HorizontalFilterParams)
 
 		colptr = (uint8_t *)outptr;
 
-		Yptr = (PIXEL16U *)outptr;
-		Vptr = Yptr + width*2;
-		Uptr = Vptr + (width);
+		// Continue the planes where the vector loop stopped
+		Yptr = (PIXEL16U *)Yptr128;
+		Vptr = (PIXEL16U *)Vptr128;
+		Uptr = (PIXEL16U *)Uptr128;
 
 #endif
 
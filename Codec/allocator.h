@@ -100,6 +100,7 @@ static INLINE void *Alloc(ALLOCATOR *allocator, size_t size)
 #if _ALLOCATOR
 	//assert(allocator != NULL);
 	if (allocator != NULL) {
+		CountMemoryAllocation();
 		return allocator->vtable->unaligned_malloc(allocator, size);
 	}
 #else
@@ -152,6 +153,7 @@ static INLINE void *AllocAligned(ALLOCATOR *allocator, size_t size, size_t align
 #if _ALLOCATOR
 	//assert(allocator != NULL);
 	if (allocator != NULL) {
+		CountMemoryAllocation();
 		return allocator->vtable->aligned_malloc(allocator, size, alignment);
 	}
 #else
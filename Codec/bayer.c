@@ -4700,7 +4700,7 @@ void DoBuildLUTCurves(DECODER *decoder, int thread_index, int max_units)
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -5179,7 +5179,7 @@ void DoBuildCube(DECODER *decoder, int thread_index, int max_units)
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -5271,7 +5271,7 @@ void DoBuild1DCurves2Linear(DECODER *decoder, int thread_index, int max_units)
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -5536,7 +5536,7 @@ void DoBuild1DLinear2Curves(DECODER *decoder, int thread_index, int max_units)
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -5642,6 +5642,7 @@ void ComputeCube(DECODER *decoder)
 	int cube_base = decoder->cube_base;
 	int cube_depth = ((1<<cube_base));
 	int i,j;
+	uint64_t telemetry_start;
 
 /*	if(decoder->codec.encoded_format >= ENCODED_FORMAT_RGBA_4444 && decoder->codec.num_channels >= 4)
 	{
@@ -5669,6 +5670,9 @@ void ComputeCube(DECODER *decoder)
 	if(decoder->basic_only)
 		return;
 
+	// Only time the color processing when the cube is rebuilt
+	telemetry_start = TELEMETRY_START(decoder->telemetry);
+
 	memcpy(&decoder->Cube_cfhddata, &decoder->cfhddata, sizeof(CFHDDATA));
 	decoder->Cube_format = decoder->frame.format;
 	decoder->Cube_output_colorspace = decoder->frame.colorspace;
@@ -6334,11 +6338,11 @@ void ComputeCube(DECODER *decoder)
 			BuildCube(decoder, 0,1);
 #else
 		#if _DELAY_THREAD_START
-			if(decoder->worker_thread.pool.thread_count == 0)
+			if(decoder->worker_thread.pool->thread_count == 0)
 			{
 				CreateLock(&decoder->worker_thread.lock);
 				// Initialize the pool of transform worker threads
-				ThreadPoolCreate(&decoder->worker_thread.pool,
+				ThreadPoolCreate(decoder->worker_thread.pool,
 								decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 								WorkerThreadProc,
 								decoder);
@@ -6349,20 +6353,24 @@ void ComputeCube(DECODER *decoder)
 				WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 				mailbox->jobType = JOB_TYPE_BUILD_LUT_CURVES; 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of cpus
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, decoder->thread_cntrl.capabilities >> 16/*cpus*/);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, decoder->thread_cntrl.capabilities >> 16/*cpus*/);
 				// Start the worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 
 				mailbox->jobType = JOB_TYPE_BUILD_CUBE; 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of cpus
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, decoder->thread_cntrl.capabilities >> 16/*cpus*/);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, decoder->thread_cntrl.capabilities >> 16/*cpus*/);
 				// Start the worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 
 				decoder->RawCubeThree1Ds = TestCubeFor1Dness(decoder);
 			}
@@ -6851,11 +6859,11 @@ void ComputeCube(DECODER *decoder)
 	#else
 
 		#if _DELAY_THREAD_START
-			if(decoder->worker_thread.pool.thread_count == 0)
+			if(decoder->worker_thread.pool->thread_count == 0)
 			{
 				CreateLock(&decoder->worker_thread.lock);
 				// Initialize the pool of transform worker threads
-				ThreadPoolCreate(&decoder->worker_thread.pool,
+				ThreadPoolCreate(decoder->worker_thread.pool,
 								decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 								WorkerThreadProc,
 								decoder);
@@ -6866,20 +6874,24 @@ void ComputeCube(DECODER *decoder)
 				WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 				mailbox->jobType = JOB_TYPE_BUILD_1DS_2LINEAR; 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of cpus
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, decoder->thread_cntrl.capabilities >> 16/*cpus*/);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, decoder->thread_cntrl.capabilities >> 16/*cpus*/);
 				// Start the worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 
 				mailbox->jobType = JOB_TYPE_BUILD_1DS_2CURVE; 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of cpus
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, decoder->thread_cntrl.capabilities >> 16/*cpus*/);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, decoder->thread_cntrl.capabilities >> 16/*cpus*/);
 				// Start the worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 			}
 	#endif
 
@@ -7123,6 +7135,18 @@ void ComputeCube(DECODER *decoder)
 		MEMORY_FREE(LUT);
 #endif
 	}
+	else if(LUT && LUT == decoder->LUTcache && decoder->low_memory)
+	{
+		// The look is only needed again if the cube is rebuilt
+#if _ALLOCATOR
+		Free(decoder->allocator, LUT);
+#else
+		MEMORY_FREE(LUT);
+#endif
+		decoder->LUTcache = NULL;
+		decoder->LUTcacheCRC = 0;
+		decoder->LUTcacheSize = 0;
+	}
 
 	if(retcode == false)
 	{
@@ -7156,6 +7180,8 @@ void ComputeCube(DECODER *decoder)
 
 	cfhddata->process_path_flags = process_path_flags;
 
+	TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_COLOR, -1, telemetry_start);
+
 	return;
 }
 
@@ -9336,6 +9362,133 @@ void FastSharpeningBlurV(unsigned short *Aptr,
 
 #if _THREADED
 
+#define DEMOSAIC_STRIP_PAIRS	16		// Maximum Bayer row pairs per strip in the fused demosaic/filter/output pass
+
+// Number of Bayer row pairs per strip for the fused pass.  The first and last pair of a
+// strip go through RGBFilterBuffer16 so the neighbouring strips can filter against them,
+// the interior pairs and the two output scanlines must fit into the thread scratch buffer.
+// Returns zero if the strips would be too short to be worthwhile, use the frame buffer path then.
+static int DemosaicStripPairs(FRAME_INFO *info, int scratchsize)
+{
+	int rowsize = (info->width*2)*3*sizeof(unsigned short);
+	int pairs = ((scratchsize / rowsize) - 3)/2 + 2;
+
+	if(pairs > DEMOSAIC_STRIP_PAIRS)
+		pairs = DEMOSAIC_STRIP_PAIRS;
+	if(pairs < 4)
+		pairs = 0;
+
+	return pairs;
+}
+
+// Debayer the first and last row pair of a strip into the frame buffer
+static void DemosaicStripEdgesRAW(DECODER *decoder, FRAME_INFO *info, int strip, int pairs,
+								  int bayer_format, int highquality, int sharpening)
+{
+	int width = info->width*2;
+	int height = info->height;
+	int first = strip;
+	int last = strip + pairs - 1;
+	unsigned short *RGBbuffer = decoder->RGBFilterBuffer16;
+
+	if(last > height-1)
+		last = height-1;
+
+	DebayerLine(width, height*2, first*2, decoder->RawBayer16, bayer_format,
+		RGBbuffer + first*2*width*3, highquality, sharpening);
+
+	if(last > first)
+	{
+		DebayerLine(width, height*2, last*2, decoder->RawBayer16, bayer_format,
+			RGBbuffer + last*2*width*3, highquality, sharpening);
+	}
+}
+
+// Debayer the interior of a strip into scratch and vertically filter, color process and
+// output the whole strip while the RGB rows are still in cache, rather than round tripping
+// every row through RGBFilterBuffer16.  Only the strip edges (and those of the neighbouring
+// strips) are read from the frame buffer, the result matches the frame buffer path exactly.
+static void DemosaicStripRAW(DECODER *decoder, FRAME_INFO *info, int strip, int pairs,
+							 uint8_t *output, int pitch, uint8_t *scratch,
+							 int bayer_format, int highquality, int sharpening)
+{
+	int width = info->width*2;
+	int height = info->height;
+	int rgbpitch16 = width*3;
+	int first = strip;
+	int last = strip + pairs;
+	int top, bottom;
+	int y, row;
+	unsigned short *RGBbuffer = decoder->RGBFilterBuffer16;
+	unsigned short *scanline = (unsigned short *)scratch;
+	unsigned short *scanline2 = scanline + rgbpitch16;
+	unsigned short *RGBstrip = scanline2 + rgbpitch16*2;
+	unsigned short *rows[(DEMOSAIC_STRIP_PAIRS+2)*2];
+
+	if(last > height)
+		last = height;
+
+	top = first > 0 ? first - 1 : first;
+	bottom = last < height ? last + 1 : last;
+
+	for(y=top; y<bottom; y++)
+	{
+		unsigned short *rgb;
+
+		if(y > first && y < last-1)
+		{
+			rgb = RGBstrip + (y-first-1)*2*rgbpitch16;
+			DebayerLine(width, height*2, y*2, decoder->RawBayer16, bayer_format,
+				rgb, highquality, sharpening);
+		}
+		else
+		{
+			rgb = RGBbuffer + y*2*rgbpitch16;
+		}
+
+		rows[(y-top)*2] = rgb;
+		rows[(y-top)*2+1] = rgb + rgbpitch16;
+	}
+
+	for(y=first; y<last; y++)
+	{
+		uint8_t *line = output + y * pitch * 2;
+
+		for(row=0; row<2; row++)
+		{
+			// Same neighbouring rows (clamped at the frame edges) as the frame buffer path
+			int c = (y-top)*2 + row;
+			unsigned short *Aptr = rows[y>=1 ? c-2 : c];
+			unsigned short *Bptr = rows[y>=1 ? c-1 : c];
+			unsigned short *Cptr = rows[c];
+			unsigned short *Dptr = rows[y<height-1 ? c+1 : c];
+			unsigned short *Eptr = rows[y<height-1 ? c+2 : c];
+			unsigned short *sptr = scanline;
+			int flags = 0;
+			int whitebitdepth = 16;
+
+			if(sharpening == 0)
+			{
+				FastBlurV(Bptr, Cptr, Dptr, scanline, width);
+			}
+			else
+			{
+				FastSharpeningBlurV(Aptr, Bptr, Cptr, Dptr, Eptr,
+						scanline, width, sharpening);
+			}
+
+			if(decoder->apply_color_active_metadata)
+				sptr = ApplyActiveMetaData(decoder, width, 1, y*2+row,
+					(uint32_t *)scanline, (uint32_t *)scanline2, info->format, &whitebitdepth, &flags);
+
+			ConvertLinesToOutput(decoder, width, 1, y, sptr, line, pitch,
+					info->format, whitebitdepth, flags);
+
+			line += pitch;
+		}
+	}
+}
+
 void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *output, int pitch, uint8_t *scratch, int scratchsize)
 {
 	//int bayer_format = decoder->cfhddata.bayer_format;
@@ -9346,6 +9499,7 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 	uint8_t *scratchptr = scratch;
 	//int scratchremain = scratchsize;
 	int debayerfilter = (decoder->cfhddata.process_path_flags_mask >> 16) & 0xf; // 8-bit debayer selector
+	int strip_pairs = 0;
 
 /*	if(info->format == COLOR_FORMAT_YUYV)
 	{
@@ -9439,6 +9593,9 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 	if(decoder->sample_uncompressed)
 		deripple = 0;
 
+	if(sharpening >= 0 && decoder->RGBFilterBuffer16)
+		strip_pairs = DemosaicStripPairs(info, scratchsize);
+
 	for (;;)
 	{
 		int work_index;
@@ -9449,7 +9606,7 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 		//int row;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -9478,7 +9635,7 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 			if(deripple)
 			{
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index1, thread_index, job, 3))
 				{
 					y = work_index1;
@@ -9498,7 +9655,7 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 			{
 				// job level 2
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index2, thread_index, job, 3))
 				{
 					unsigned short *sptr;
@@ -9545,11 +9702,39 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 							info->format, whitebitdepth, flags);
 				}
 			}
+			else if(strip_pairs)
+			{
+				// One work index per Bayer row pair, the first row pair of each strip does the work
+
+				// job level 2
+				job++;
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
+					&work_index2, thread_index, job, strip_pairs+3))
+				{
+					if((work_index2 % strip_pairs) == 0)
+					{
+						DemosaicStripEdgesRAW(decoder, info, work_index2, strip_pairs,
+							bayer_format, highquality, sharpening);
+					}
+				}
+
+				// job level 3
+				job++;
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
+					&work_index3, thread_index, job, strip_pairs))
+				{
+					if((work_index3 % strip_pairs) == 0)
+					{
+						DemosaicStripRAW(decoder, info, work_index3, strip_pairs, output, pitch,
+							scratchptr, bayer_format, highquality, sharpening);
+					}
+				}
+			}
 			else
 			{
 				// job level 2
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index2, thread_index, job, 3))
 				{
 					//unsigned short *sptr;
@@ -9565,7 +9750,7 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 
 				// job level 3
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index3, thread_index, job, 3))
 				{
 					int y = work_index3;
@@ -9678,7 +9863,7 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 			if(deripple)
 			{
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index1, thread_index, job, 3))
 				{
 					y = work_index1;
@@ -9698,7 +9883,7 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 			if(sharpening < 0 || decoder->frame.generate_look)
 			{
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index2, thread_index, job, 3))
 				{
 					int y = work_index2;
@@ -9742,11 +9927,39 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 				}
 			}
 
+			else if(strip_pairs)
+			{
+				// One work index per Bayer row pair, the first row pair of each strip does the work
+
+				// job level 2
+				job++;
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
+					&work_index2, thread_index, job, strip_pairs+3))
+				{
+					if((work_index2 % strip_pairs) == 0)
+					{
+						DemosaicStripEdgesRAW(decoder, info, work_index2, strip_pairs,
+							bayer_format, highquality, sharpening);
+					}
+				}
+
+				// job level 3
+				job++;
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
+					&work_index3, thread_index, job, strip_pairs))
+				{
+					if((work_index3 % strip_pairs) == 0)
+					{
+						DemosaicStripRAW(decoder, info, work_index3, strip_pairs, output, pitch,
+							scratchptr, bayer_format, highquality, sharpening);
+					}
+				}
+			}
 			else
 			{
 				// job level 2
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index2, thread_index, job, 3))
 				{
 					//unsigned short *sptr;
@@ -9762,7 +9975,7 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
 
 				// job level 3
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index3, thread_index, job, 3))
 				{
 
@@ -9885,7 +10098,7 @@ void VerticalOnlyDemosaicRAWFast(DECODER *decoder, FRAME_INFO *info, int thread_
 		//int row;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -9912,7 +10125,7 @@ void VerticalOnlyDemosaicRAWFast(DECODER *decoder, FRAME_INFO *info, int thread_
 
 			// job level 2
 			job++;
-			while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+			while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 				&work_index2, thread_index, job, 3))
 			{
 				unsigned short *sptr;
@@ -9999,7 +10212,7 @@ void VerticalOnlyDemosaicRAWFast(DECODER *decoder, FRAME_INFO *info, int thread_
 			// job level 2
 			{
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index2, thread_index, job, 3))
 				{
 					int y = work_index2;
@@ -10093,7 +10306,7 @@ void NoDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t
 		//int row;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -10380,7 +10593,7 @@ void VerticalOnlyDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_inde
 		//int row;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -10409,7 +10622,7 @@ void VerticalOnlyDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_inde
 			if(deripple)
 			{
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index1, thread_index, job, 3))
 				{
 					y = work_index1;
@@ -10427,7 +10640,7 @@ void VerticalOnlyDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_inde
 			{
 				// job level 2
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index2, thread_index, job, 3))
 				{
 					//unsigned short *sptr;
@@ -10443,7 +10656,7 @@ void VerticalOnlyDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_inde
 
 				// job level 3
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index3, thread_index, job, 3))
 				{
 					int y = work_index3;
@@ -10556,7 +10769,7 @@ void VerticalOnlyDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_inde
 			if(deripple)
 			{
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index1, thread_index, job, 3))
 				{
 					y = work_index1;
@@ -10576,7 +10789,7 @@ void VerticalOnlyDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_inde
 			if(sharpening < 0 || decoder->frame.generate_look)
 			{
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index2, thread_index, job, 3))
 				{
 					int y = work_index2;
@@ -10624,7 +10837,7 @@ void VerticalOnlyDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_inde
 			{
 				// job level 2
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index2, thread_index, job, 3))
 				{
 					//unsigned short *sptr;
@@ -10640,7 +10853,7 @@ void VerticalOnlyDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_inde
 
 				// job level 3
 				job++;
-				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(&decoder->worker_thread.pool,
+				while(THREAD_ERROR_OKAY == PoolThreadGetDependentJob(decoder->worker_thread.pool,
 					&work_index3, thread_index, job, 3))
 				{
 
@@ -10790,7 +11003,7 @@ void Do3DWork(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *out
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -10834,7 +11047,7 @@ void DoWarp(DECODER *decoder, void *mesh, uint8_t *output, int *lens_correct_buf
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -10866,7 +11079,7 @@ void DoWarpCache(DECODER *decoder, void *mesh, int thread_index, int line_max, i
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -10896,7 +11109,7 @@ void DoWarpBlurV(DECODER *decoder, void *mesh, int thread_index, int line_max, i
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -10952,7 +11165,7 @@ void DoVertSharpen(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -11056,7 +11269,7 @@ void Do3DVerticalWork(DECODER *decoder, FRAME_INFO *info, int thread_index, uint
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -11314,7 +11527,7 @@ void DoHistogramWork(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -11354,7 +11567,7 @@ void DoBurninWork(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -11446,7 +11659,7 @@ void QuarterRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *o
 		int work_index;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -11546,7 +11759,7 @@ void Row16uUncompressed2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thr
 		{
 			int work_index;
 			// Wait for one row from each channel to process
-			error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+			error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 			if (error != THREAD_ERROR_OKAY)
 				return; // No more work to do
 
@@ -11949,7 +12162,7 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
 		{
 			int work_index;
 			// Wait for one row from each channel to process
-			error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+			error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 			if (error != THREAD_ERROR_OKAY)
 				return; // No more work to do
 
@@ -12249,7 +12462,7 @@ void Row16uHalf2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
 		{
 			int work_index;
 			// Wait for one row from each channel to process
-			error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+			error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 			if (error != THREAD_ERROR_OKAY)
 				return; // No more work to do
 
@@ -12723,7 +12936,7 @@ void Row16uQuarter2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_i
 		{
 			int work_index;
 			// Wait for one row from each channel to process
-			error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+			error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 			if (error != THREAD_ERROR_OKAY)
 				return; // No more work to do
 
@@ -13198,11 +13411,11 @@ void ConvertRow16uToOutput(DECODER *decoder, int frame_index, int num_channels,
 		WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 	#if _DELAY_THREAD_START
-		if(decoder->worker_thread.pool.thread_count == 0)
+		if(decoder->worker_thread.pool->thread_count == 0)
 		{
 			CreateLock(&decoder->worker_thread.lock);
 			// Initialize the pool of transform worker threads
-			ThreadPoolCreate(&decoder->worker_thread.pool,
+			ThreadPoolCreate(decoder->worker_thread.pool,
 							decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 							WorkerThreadProc,
 							decoder);
@@ -13214,14 +13427,16 @@ void ConvertRow16uToOutput(DECODER *decoder, int frame_index, int num_channels,
 		memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
 		mailbox->jobType = JOB_TYPE_OUTPUT;
 
+		ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 		// Set the work count to the number of rows to process
-		ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+		ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 		// Start the transform worker threads
-		ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+		ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 		// Wait for all of the worker threads to finish
-		ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+		ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+		ThreadPoolEndJob(decoder->worker_thread.pool);
 	}
 #else
 	{
@@ -13252,7 +13467,7 @@ void GenerateBYR2(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t
 		//int row;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
@@ -13545,7 +13760,7 @@ void GenerateHalfBYR2(DECODER *decoder, FRAME_INFO *info, int thread_index,
 		{
 			int work_index;
 			// Wait for one row from each channel to process
-			error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+			error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 			if (error != THREAD_ERROR_OKAY)
 				return; // No more work to do
 
@@ -13664,6 +13879,7 @@ extern void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_
 THREAD_PROC(WorkerThreadProc, lpParam)
 {
 	DECODER *decoder = (DECODER *)lpParam;
+	THREAD_POOL *pool = decoder->worker_thread.pool;
 	WORKER_THREAD_DATA *data = &decoder->worker_thread.data;
 	THREAD_ERROR error = THREAD_ERROR_OKAY;
 	int thread_index;
@@ -13682,18 +13898,18 @@ THREAD_PROC(WorkerThreadProc, lpParam)
 	SetDefaultExceptionHandler();
 
 	// Determine the index of this worker thread
-	error = PoolThreadGetIndex(&decoder->worker_thread.pool, &thread_index);
+	error = PoolThreadGetIndex(pool, &thread_index);
 	assert(error == THREAD_ERROR_OKAY);
 
 	// Check that the thread index is consistent with the size of the thread pool
-	assert(0 <= thread_index && thread_index < decoder->worker_thread.pool.thread_count);
+	assert(0 <= thread_index && thread_index < pool->thread_count);
 	
 	// The worker thread stays active while waiting for a message to start processing
 	for (;;)
 	{
 		// Wait for the signal to begin processing a transform
 		THREAD_MESSAGE message = THREAD_MESSAGE_NONE;
-		error = PoolThreadWaitForMessage(&decoder->worker_thread.pool, thread_index, &message);
+		error = PoolThreadWaitForMessage(pool, thread_index, &message);
 
 		// Received a signal to begin inverse transform processing?
 		if (error == THREAD_ERROR_OKAY && message == THREAD_MESSAGE_START)
@@ -13725,6 +13941,12 @@ THREAD_PROC(WorkerThreadProc, lpParam)
 			int fine_vertical = 0;
 			// Inverse horizontal filter that produces the correct output format
 			HorizontalInverseFilterOutputProc horizontal_filter_proc;
+			void *job_param = NULL;
+
+			// Process the job for the decoder that submitted it (the pool is shared by the decoders for both eyes)
+			PoolThreadGetJobParam(pool, &job_param);
+			decoder = (DECODER *)job_param;
+			data = &decoder->worker_thread.data;
 
 			// Lock access to the transform data
 			Lock(&decoder->worker_thread.lock);
@@ -13801,22 +14023,22 @@ THREAD_PROC(WorkerThreadProc, lpParam)
 			}		  
 			else if(jobType == JOB_TYPE_BUILD_1DS_2LINEAR)
 			{
-				line_max = decoder->worker_thread.pool.work_start_count;
+				line_max = decoder->worker_thread.pool->work_start_count;
 				DoBuild1DCurves2Linear(decoder, thread_index, line_max);
 			}		  
 			else if(jobType == JOB_TYPE_BUILD_1DS_2CURVE)
 			{
-				line_max = decoder->worker_thread.pool.work_start_count;
+				line_max = decoder->worker_thread.pool->work_start_count;
 				DoBuild1DLinear2Curves(decoder, thread_index, line_max);
 			}		  
 			else if(jobType == JOB_TYPE_BUILD_LUT_CURVES)
 			{
-				line_max = decoder->worker_thread.pool.work_start_count;
+				line_max = decoder->worker_thread.pool->work_start_count;
 				DoBuildLUTCurves(decoder, thread_index, line_max);
 			}		  
 			else if(jobType == JOB_TYPE_BUILD_CUBE)
 			{
-				line_max = decoder->worker_thread.pool.work_start_count;
+				line_max = decoder->worker_thread.pool->work_start_count;
 				DoBuildCube(decoder, thread_index, line_max);
 			}
 #if WARPSTUFF
@@ -13916,7 +14138,7 @@ THREAD_PROC(WorkerThreadProc, lpParam)
 			  assert(0); //unknown job
 		  }
 			// Signal that this thread is done
-			PoolThreadSignalDone(&decoder->worker_thread.pool, thread_index);
+			PoolThreadSignalDone(pool, thread_index);
 
 			// Loop and wait for the next message
 		}
@@ -345,6 +345,21 @@ uint32_t  GetLong(BITSTREAM *stream)
 	return longword;
 }
 
+// Load four bytes from the bitstream in big endian order without any alignment requirement
+static inline uint32_t LoadLongBtoN(const uint8_t *lpCurrentWord)
+{
+	uint32_t longword;
+	memcpy(&longword, lpCurrentWord, sizeof(longword));
+	return SwapInt32BtoN(longword);
+}
+
+// Can four bytes be loaded at the current position without reading past the end of the block?
+static inline bool CanLoadLong(BITSTREAM *stream, uint8_t *lpCurrentWord)
+{
+	// A position before the start of the block wraps around to a large unsigned offset
+	return ((size_t)(lpCurrentWord - stream->lpCurrentBuffer) + sizeof(uint32_t) <= (size_t)stream->dwBlockLength);
+}
+
 #if _BITSTREAM_BUFFER_BYTE
 
 // Read the specified number of bits from the stream
@@ -366,6 +381,28 @@ uint32_t  GetBits(BITSTREAM *stream, int nBits)
 		nBitsInBuffer = BITSTREAM_WORD_SIZE;
 	}
 
+	// Load the remaining bits with one unaligned read unless GetWord must refill the block
+	if (nBits > nBitsInBuffer && stream->nWordsUsed >= (int)sizeof(uint32_t))
+	{
+		int nBitsRemaining = nBits - nBitsInBuffer;
+		int nBytes = (nBitsRemaining + 7) >> 3;
+		uint32_t  dwLoad = LoadLongBtoN(stream->lpCurrentWord);
+
+		// Bits from the buffer followed by the bits from the bytes that were loaded
+		output = wBuffer;
+		dwLoad >>= (32 - 8 * nBytes);
+		nBitsInBuffer = 8 * nBytes - nBitsRemaining;
+		output = (output << nBitsRemaining) | (dwLoad >> nBitsInBuffer);
+
+		stream->lpCurrentWord += nBytes;
+		stream->nWordsUsed -= nBytes;
+
+		stream->wBuffer = (uint8_t )(dwLoad & BITMASK(nBitsInBuffer));
+		stream->nBitsFree = BITSTREAM_WORD_SIZE - nBitsInBuffer;
+
+		return output;
+	}
+
 	while (nBits > nBitsInBuffer)
 	{
 		// Shift bits from the buffer into the output
@@ -418,6 +455,29 @@ uint32_t  GetBits(BITSTREAM *stream, int nBits)
 	uint32_t  dwOutput;
 	uint32_t  dwOverflow = 0;
 
+	if (nBits > nBitsInBuffer && CanLoadLong(stream, lpCurrentWord))
+	{
+		// Number of whole bytes that must be consumed to satisfy the request
+		int nBytes = (nBits - nBitsInBuffer + 7) >> 3;
+
+		// Refill from a single big endian load, dropping the lookahead bytes that are not consumed
+		uint64_t qwBuffer = ((uint64_t)dwBuffer << 32) | LoadLongBtoN(lpCurrentWord);
+		qwBuffer >>= (32 - 8 * nBytes);
+		lpCurrentWord += nBytes;
+		nBitsInBuffer += 8 * nBytes - nBits;
+
+		// The buffer only holds valid bits so the output does not need to be masked
+		dwOutput = (uint32_t )(qwBuffer >> nBitsInBuffer);
+		dwBuffer = (uint32_t )qwBuffer & BITMASK(nBitsInBuffer);
+
+		stream->wBuffer = dwBuffer;
+		stream->nBitsFree = BITSTREAM_BUFFER_SIZE - nBitsInBuffer;
+		stream->lpCurrentWord = lpCurrentWord;
+
+		return dwOutput;
+	}
+
+	// Byte at a time near the end of the block
 	while (nBits > nBitsInBuffer)
 	{
 		// Save the high byte in the buffer
@@ -453,17 +513,35 @@ uint32_t  GetBits(BITSTREAM *stream, int nBits)
 
 TAGVALUE GetTagValue(BITSTREAM *stream)
 {
+	uint8_t  *lpCurrentWord = stream->lpCurrentWord;
+	int nWordsUsed = stream->nWordsUsed;
 	TAGVALUE segment;
 
-	for (;;)
+	// This routine assumes that the buffer is empty
+	assert(stream->nBitsFree == BITSTREAM_LONG_SIZE);
+
+	// Scan the tag value pairs in place instead of calling GetLong for each pair
+	while (nWordsUsed >= (int)sizeof(uint32_t))
 	{
-		// Get the next tag value pair
-		segment.longword = GetLong(stream);
+		segment.longword = LoadLongBtoN(lpCurrentWord);
+		lpCurrentWord += sizeof(uint32_t);
+		nWordsUsed -= sizeof(uint32_t);
 
 		// Discard optional tag value pairs
-		if (segment.tuple.tag > 0) break;
+		if (segment.tuple.tag > 0)
+		{
+			stream->lpCurrentWord = lpCurrentWord;
+			stream->nWordsUsed = nWordsUsed;
+			return segment;
+		}
 	}
 
+	// Ran out of tag value pairs (same result as GetLong on underflow)
+	stream->lpCurrentWord = lpCurrentWord;
+	stream->nWordsUsed = nWordsUsed;
+	stream->error = BITSTREAM_ERROR_UNDERFLOW;
+	segment.longword = 0x0C0C0C0C;
+
 	return segment;
 }
 
@@ -615,6 +693,21 @@ void SkipBits(BITSTREAM *stream, int nBits)
 	uint32_t  wBuffer = (uint32_t )stream->wBuffer;
 	int nBitsInBuffer = BITSTREAM_BUFFER_SIZE - stream->nBitsFree;
 
+	if (nBits > nBitsInBuffer && CanLoadLong(stream, stream->lpCurrentWord))
+	{
+		int nBitsRemaining = nBits - nBitsInBuffer;
+		int nBytes = (nBitsRemaining + 7) >> 3;
+
+		// All of the bits in the buffer are skipped so only the low bits of the last byte loaded survive
+		uint32_t  dwLoad = LoadLongBtoN(stream->lpCurrentWord) >> (32 - 8 * nBytes);
+		stream->lpCurrentWord += nBytes;
+		nBitsInBuffer = 8 * nBytes - nBitsRemaining;
+
+		stream->wBuffer = dwLoad & BITMASK(nBitsInBuffer);
+		stream->nBitsFree = BITSTREAM_BUFFER_SIZE - nBitsInBuffer;
+		return;
+	}
+
 	while(nBits > nBitsInBuffer)
 	{
 		wBuffer <<= 8;
@@ -676,6 +769,13 @@ output:
 
 	assert(nBits < 17);
 
+	if (nBitsInBuffer < nBits && CanLoadLong(stream, lpCurrent))
+	{
+		// Peek at the bits that follow the buffer without changing the bitstream
+		uint64_t qwBuffer = ((uint64_t)wBuffer << 32) | LoadLongBtoN(lpCurrent);
+		return (uint32_t )(qwBuffer >> (nBitsInBuffer + 32 - nBits));
+	}
+
 	if (nBitsInBuffer < nBits) {
 		nBitsInBuffer += 16;
 		wBuffer <<= 16;
@@ -1147,9 +1247,8 @@ insert_bit_field:
 // Write bits to a bitstream
 void PutBits(BITSTREAM *stream, uint32_t wBits, int nBits)
 {
-	uint32_t  wBuffer;
-	int nBitsFree;
-	//int nBitsUsed;
+	uint64_t wBuffer;
+	int nBitsUsed;
 
 #if 0
 	// Can pass a null stream to indicate that the bits should be discarded
@@ -1165,47 +1264,31 @@ void PutBits(BITSTREAM *stream, uint32_t wBits, int nBits)
 	// Routine should not be passed a word with leading bits that are nonzero
 	assert(nBits == BITSTREAM_LONG_SIZE || (wBits & ~BITMASK(nBits)) == 0);
 
-	// Move the current word into a int32_t buffer
+	// Move the current word into a 64-bit buffer so the bits can be inserted with one shift
 	wBuffer = stream->wBuffer;
 
-	// Number of bits remaining in the current word
-	nBitsFree = stream->nBitsFree;
+	// Number of bits used in the current word
+	nBitsUsed = BITSTREAM_LONG_SIZE - stream->nBitsFree;
 
-	// Will the bits fit in the int32_t buffer?
-	if (nBitsFree == BITSTREAM_LONG_SIZE) {
-		wBuffer = wBits & BITMASK(nBits);
-		nBitsFree -= nBits;
-#if (1 && TRACE_PUTBITS)
-		TracePutBits(nBits);
-#endif
-	}
-	else if (nBits <= nBitsFree) {
-		wBuffer <<= nBits;
-		wBuffer |= (wBits & BITMASK(nBits));
-		nBitsFree -= nBits;
-#if (1 && TRACE_PUTBITS)
-		TracePutBits(nBits);
-#endif
-	}
-	else {
-		// Fill the buffer with as many bits as will fit
-		wBuffer <<= nBitsFree;
-		nBits -= nBitsFree;
-
-		// Should have some bits remaining
-		assert(nBits > 0);
-
-		// Insert as many bits as will fit into the buffer
-		wBuffer |= (wBits >> nBits) & BITMASK(nBitsFree);
+	// The buffer may contain stale bits if it is empty
+	if (nBitsUsed == 0)
+		wBuffer = 0;
 
+	// Insert the bits into the buffer
+	wBuffer = (wBuffer << nBits) | (wBits & BITMASK(nBits));
+	nBitsUsed += nBits;
 #if (1 && TRACE_PUTBITS)
-		TracePutBits(nBitsFree);
+	TracePutBits(nBits);
 #endif
-		// Insert all of the bytes in the buffer into the bitstream
-		PutLong(stream, wBuffer);
 
-		wBuffer = wBits & BITMASK(nBits);
-		nBitsFree = BITSTREAM_LONG_SIZE - nBits;
+	// Insert the full doubleword into the bitstream if the bits did not fit
+	if (nBitsUsed > BITSTREAM_LONG_SIZE)
+	{
+		nBitsUsed -= BITSTREAM_LONG_SIZE;
+		PutLong(stream, (uint32_t)(wBuffer >> nBitsUsed));
+
+		// Keep only the bits that have not been written
+		wBuffer &= BITMASK(nBitsUsed);
 	}
 
 #if 0
@@ -1218,8 +1301,8 @@ void PutBits(BITSTREAM *stream, uint32_t wBits, int nBits)
 #endif
 
 	// Save the new current word and bit count in the stream
-	stream->wBuffer = wBuffer;
-	stream->nBitsFree = nBitsFree;
+	stream->wBuffer = (uint32_t)wBuffer;
+	stream->nBitsFree = BITSTREAM_LONG_SIZE - nBitsUsed;
 
 	// Count the number of bits written to the bitstream
 	//stream->cntBits += nBits;
@@ -243,6 +243,19 @@ extern "C" {
 #define BITMASK(n)		_bitmask[n]
 extern const uint32_t  _bitmask[];
 
+// Insert a codeword (no leading bits set, at most 32 bits) into a 64-bit bit buffer
+// that holds the pending bits in its least significant bits and write a big endian
+// doubleword to the output when more than 32 bits are pending (requires swap.h)
+#define PUTBITS64(wBuffer, nBitsUsed, lpCurrentWord, wBits, nBits)					\
+	{																				\
+		wBuffer = (wBuffer << (nBits)) | (wBits);									\
+		nBitsUsed += (nBits);														\
+		if (nBitsUsed > BITSTREAM_LONG_SIZE) {										\
+			nBitsUsed -= BITSTREAM_LONG_SIZE;										\
+			*((lpCurrentWord)++) = SwapInt32NtoB((uint32_t)(wBuffer >> nBitsUsed));	\
+		}																			\
+	}
+
 // Initialize the bitstream
 void InitBitstream(BITSTREAM *stream);
 
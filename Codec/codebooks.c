@@ -197,6 +197,12 @@ static int NumLeadingZeros(int number, int size)
 	return num_zeros;
 }
 
+// Return the number of bytes allocated by InitCodebooks
+size_t CodebooksSize(void)
+{
+	return CODEC_NUM_CODESETS * (sizeof(struct newcodestruct) + sizeof(struct fastbookstruct) + sizeof(struct valuebookstruct));
+}
+
 // Initialize the codebooks in a codeset
 #if _ALLOCATOR
 bool InitCodebooks(ALLOCATOR *allocator, CODESET *cs)
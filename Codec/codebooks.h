@@ -87,6 +87,9 @@ bool InitCodebooks(ALLOCATOR *allocator, CODESET *cs);
 bool InitCodebooks(CODESET *cs);
 #endif
 
+// Return the number of bytes allocated by InitCodebooks
+size_t CodebooksSize(void);
+
 bool InitDecoderFSM(struct decoder *decoder, CODESET *cs);
 
 void FreeCodebooks(struct decoder *decoder /*, CODESET *cs */);
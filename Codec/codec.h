@@ -47,6 +47,8 @@
 #include "thread.h"
 #endif
 
+#include "telemetry.h"
+
 // Compile time switches that control encoding and decoding
 #define _ENCODE_FAST_RUNS		0		// Use fast runs encoding routine
 #define _ENCODE_LONG_RUNS		1		// Encode runs of zeros across rows
@@ -1429,8 +1431,11 @@ typedef struct decoder		// Decoder state (derived from codec)
   #define ENTROPY_ENGINE_QUEUE		(3 * TRANSFORM_MAX_WAVELETS * TRANSFORM_MAX_CHANNELS)
 	struct entropy_worker_new					// Worker threads used for entropy decoding
 	{
-		// Define a pool of worker threads
-		THREAD_POOL pool;
+		// Pool of worker threads used by this decoder (the decoder for the second eye uses the pool of the first eye)
+		THREAD_POOL *pool;
+
+		// Pool of worker threads owned by this decoder
+		THREAD_POOL owned_pool;
 
 		// Control access to the transform worker thread data
 		LOCK lock;
@@ -1453,14 +1458,18 @@ typedef struct decoder		// Decoder state (derived from codec)
 			int active_codebook;
 			int difference_coding;
 			int initialized;
+			int subband;				// Subband index for the decoding statistics
 		} entropy_data[ENTROPY_ENGINE_QUEUE];
 
 	} entropy_worker_new;
 
 	struct worker_thread
 	{
-		// Define a pool of worker threads
-		THREAD_POOL pool;
+		// Pool of worker threads used by this decoder (the decoder for the second eye uses the pool of the first eye)
+		THREAD_POOL *pool;
+
+		// Pool of worker threads owned by this decoder
+		THREAD_POOL owned_pool;
 
 		// Control access to the transform worker thread data
 		LOCK lock;
@@ -1537,9 +1546,12 @@ typedef struct decoder		// Decoder state (derived from codec)
 	int apply_color_active_metadata;	// set if the cube in non-unity
 	unsigned int last_set_time;		// External Metadata is only checked every 1000ms
 	time_t last_time_t;				// External Metadata is only checked every 1000ms
+	uint64_t metadata_hash;			// Hash of the active metadata used by the last full metadata update
+	int metadata_hash_valid;		// Set if the metadata update can be skipped when the hash matches
 	int decode_resolution;
 	int basic_only;					// internal control for no active metadata.
 	int use_local_buffer;			// decoding to an interal format be applying 3D or similar corrections
+	int lowpass_output;				// set if the last frame can be output at lower resolutions from the lowpass bands
 
 	CFHDDATA cfhddata;				// Extra Information from the AVI Header
 
@@ -1581,6 +1593,7 @@ typedef struct decoder		// Decoder state (derived from codec)
 	unsigned char *DataBases[METADATA_PRIORITY_MAX+1];
 	unsigned int DataBasesAllocSize[METADATA_PRIORITY_MAX+1];
 	unsigned int DataBasesSize[METADATA_PRIORITY_MAX+1];
+	uint32_t DataBasesGeneration[METADATA_PRIORITY_MAX+1]; // Generation of the database file copied into the buffer (zero if not from disk)
 
 	unsigned char hasFileDB[METADATA_PRIORITY_MAX+1]; // Flag whether .colr existed.
 
@@ -1608,6 +1621,9 @@ typedef struct decoder		// Decoder state (derived from codec)
 	// For Stereo speed
 	struct decoder *parallelDecoder;
 
+	// Statistics for each stage of decoding (NULL if statistics are not collected)
+	TELEMETRY *telemetry;
+
 	// Aligned sample buffer
 	uint8_t *aligned_sample_buffer;
 	size_t aligned_sample_buffer_size;
@@ -1642,6 +1658,7 @@ typedef struct decoder		// Decoder state (derived from codec)
 	int metadatachunks;
 	unsigned char *mdc[METADATA_CHUNK_MAX];
 	unsigned int mdc_size[METADATA_CHUNK_MAX];
+	unsigned int mdc_limit[METADATA_CHUNK_MAX];		// Allocated size of each chunk (the buffers are reused on later frames)
 	//unsigned int mdc_crc[METADATA_CHUNK_MAX]; //DAN20100927 - removed CRC a where way to test metadata chuncks, using CompareTags now.
 
 	MDParams MDPdefault;
@@ -1663,6 +1680,7 @@ typedef struct decoder		// Decoder state (derived from codec)
 	unsigned int  LUTcacheCRC; // last LUT CRC currently loaded
 	float *LUTcache; // last LUT currently loaded
 	int LUTcacheSize; // last LUT currently loaded
+	int low_memory; // free the cached LUT after building the color cube (decoding within a memory budget)
 
 	float lastLensOffsetX;
 	float lastLensOffsetY;
@@ -147,6 +147,9 @@
 extern "C" {
 #endif
 
+// Count the heap allocations made by the codec (reported in the decoder and encoder statistics)
+void CountMemoryAllocation(void);
+
 //TODO: Replace uses of MEMORY_ALLOC and similar macros
 
 #if (0 && _ALLOCATOR)
@@ -227,18 +230,18 @@ static void *malloc22(size_t size, size_t align)
 }
 #endif
 
-#define MEMORY_ALLOC			malloc
+#define MEMORY_ALLOC(size)		(CountMemoryAllocation(), malloc(size))
 #define MEMORY_FREE				free
 
 #if DEBUG_ALLOCS
-  #define MEMORY_ALIGNED_ALLOC	_mm_malloc22
+  #define MEMORY_ALIGNED_ALLOC(size, alignment)	(CountMemoryAllocation(), _mm_malloc22(size, alignment))
   #define MEMORY_ALIGNED_FREE	_mm_free22
 #else
 	#ifdef __APPLE__
-	#define MEMORY_ALIGNED_ALLOC	malloc22
+	#define MEMORY_ALIGNED_ALLOC(size, alignment)	(CountMemoryAllocation(), malloc22(size, alignment))
 	#define MEMORY_ALIGNED_FREE		free
 	#else
-	#define MEMORY_ALIGNED_ALLOC	_mm_malloc
+	#define MEMORY_ALIGNED_ALLOC(size, alignment)	(CountMemoryAllocation(), _mm_malloc(size, alignment))
 	#define MEMORY_ALIGNED_FREE		_mm_free
 	#endif 
 #endif
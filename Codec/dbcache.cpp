@@ -0,0 +1,391 @@
+/*! @file dbcache.cpp
+
+*  @brief Process-wide cache of the color database files
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+#include "config.h"
+#include <errno.h>
+#include <string>
+#include <map>
+
+#ifdef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(__linux__)
+// Use change notification for the directories that contain the database files
+#define _INOTIFY	1
+#include <sys/inotify.h>
+#else
+#define _INOTIFY	0
+#endif
+
+#include "../Common/Lock.h"
+#include "dbcache.h"
+
+
+#ifdef _WIN32
+typedef struct _stat64 FILE_STATUS;
+#define GetFileStatus(pathname, status)		_stat64(pathname, status)
+#else
+typedef struct stat FILE_STATUS;
+#define GetFileStatus(pathname, status)		stat(pathname, status)
+#endif
+
+// Cache entry for one database file
+typedef struct disk_database_entry
+{
+	DISK_DATABASE *database;	// Current contents of the file (NULL if the file does not exist)
+	bool changed;				// The file must be checked on the next lookup
+	bool retry;					// The last attempt to read the file failed
+	int watch;					// Watch for the directory that contains the file (negative if polled)
+	uint64_t checked;			// Time when the file was last checked (in milliseconds)
+	uint64_t used;				// Time when the entry was last used (in milliseconds)
+	FILE_STATUS status;			// Status of the file when it was read
+
+} DISK_DATABASE_ENTRY;
+
+typedef std::map<std::string, DISK_DATABASE_ENTRY> DISK_DATABASE_MAP;
+
+static CSimpleLock cache_lock;
+static DISK_DATABASE_MAP cache_entries;
+static uint32_t cache_generation = 0;
+
+#if _INOTIFY
+static int notify_fd = -1;
+static bool notify_failed = false;
+static std::map<std::string, int> watch_table;		// Watch for each directory
+static std::map<int, std::string> watch_names;		// Directory for each watch
+#endif
+
+
+static uint64_t GetMilliseconds()
+{
+#ifdef _WIN32
+	return GetTickCount64();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+}
+
+static bool SameFileStatus(FILE_STATUS *a, FILE_STATUS *b)
+{
+	return (a->st_size == b->st_size &&
+			a->st_mtime == b->st_mtime &&
+			a->st_ino == b->st_ino);
+}
+
+static void ReleaseDatabaseLocked(DISK_DATABASE *database)
+{
+	if (database && --database->refcount == 0) {
+		free(database);
+	}
+}
+
+// Start change notification for the directory that contains the file
+static int WatchDirectory(const std::string &pathname)
+{
+#if _INOTIFY
+	size_t slash = pathname.rfind('/');
+	char directory[1024];
+	int watch;
+
+	if (slash == std::string::npos || slash == 0 || slash >= sizeof(directory)) {
+		return -1;
+	}
+	memcpy(directory, pathname.c_str(), slash);
+	directory[slash] = '\0';
+
+	if (notify_fd < 0)
+	{
+		if (notify_failed) {
+			return -1;
+		}
+
+		notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (notify_fd < 0)
+		{
+			notify_failed = true;
+			return -1;
+		}
+	}
+
+	// Compare with the keys directly so that polling a file does not allocate a string
+	for (std::map<std::string, int>::iterator it = watch_table.begin(); it != watch_table.end(); it++)
+	{
+		if (it->first == directory) {
+			return it->second;
+		}
+	}
+
+	// The directory may not exist yet in which case the file is polled
+	watch = inotify_add_watch(notify_fd, directory,
+							  IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+	if (watch < 0) {
+		return -1;
+	}
+
+	watch_table[directory] = watch;
+	watch_names[watch] = directory;
+	return watch;
+#else
+	(void)pathname;
+	return -1;
+#endif
+}
+
+// Mark the entries for the files that changed since the last lookup
+static void ReadNotifications()
+{
+#if _INOTIFY
+	// Buffer aligned for the notification records
+	uint32_t buffer[1024];
+
+	if (notify_fd < 0) {
+		return;
+	}
+
+	for (;;)
+	{
+		ssize_t length = read(notify_fd, buffer, sizeof(buffer));
+		char *ptr = (char *)buffer;
+
+		if (length <= 0) {
+			break;
+		}
+
+		while (ptr < (char *)buffer + length)
+		{
+			struct inotify_event *event = (struct inotify_event *)ptr;
+			ptr += sizeof(struct inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				// Events were lost so check every file
+				for (DISK_DATABASE_MAP::iterator it = cache_entries.begin(); it != cache_entries.end(); it++) {
+					it->second.changed = true;
+				}
+				continue;
+			}
+
+			std::map<int, std::string>::iterator name = watch_names.find(event->wd);
+			if (name == watch_names.end()) {
+				continue;
+			}
+
+			if (event->mask & IN_IGNORED)
+			{
+				// The directory was removed so poll the files in the directory
+				for (DISK_DATABASE_MAP::iterator it = cache_entries.begin(); it != cache_entries.end(); it++)
+				{
+					if (it->second.watch == event->wd)
+					{
+						it->second.watch = -1;
+						it->second.changed = true;
+					}
+				}
+				watch_table.erase(name->second);
+				watch_names.erase(name);
+				continue;
+			}
+
+			if (event->len > 0)
+			{
+				DISK_DATABASE_MAP::iterator it = cache_entries.find(name->second + "/" + event->name);
+				if (it != cache_entries.end()) {
+					it->second.changed = true;
+				}
+			}
+		}
+	}
+#endif
+}
+
+// Read the file if it changed since the last time the entry was checked
+static void RefreshEntry(const std::string &pathname, DISK_DATABASE_ENTRY *entry, uint64_t now)
+{
+	DISK_DATABASE *database;
+	FILE_STATUS status;
+	FILE *file;
+	size_t size;
+
+	entry->checked = now;
+
+	if (entry->watch < 0) {
+		entry->watch = WatchDirectory(pathname);
+	}
+
+	if (GetFileStatus(pathname.c_str(), &status) != 0)
+	{
+		if (errno == ENOENT || errno == ENOTDIR)
+		{
+			// The file does not exist
+			ReleaseDatabaseLocked(entry->database);
+			entry->database = NULL;
+			entry->changed = false;
+			entry->retry = false;
+		}
+		else
+		{
+			entry->retry = true;
+		}
+		return;
+	}
+
+	// Polled files are read only if the file status changed
+	if (!entry->changed && !entry->retry && entry->database && SameFileStatus(&status, &entry->status)) {
+		return;
+	}
+
+	entry->changed = false;
+	entry->retry = true;
+
+#ifdef _WIN32
+	if (fopen_s(&file, pathname.c_str(), "rb") != 0) {
+		file = NULL;
+	}
+#else
+	file = fopen(pathname.c_str(), "rb");
+#endif
+	if (file == NULL) {
+		return;
+	}
+
+	size = (size_t)status.st_size;
+	database = (DISK_DATABASE *)malloc(sizeof(DISK_DATABASE) + size);
+	if (database == NULL)
+	{
+		fclose(file);
+		return;
+	}
+	database->refcount = 1;
+	database->size = size;
+	database->data = (unsigned char *)(database + 1);
+
+	// The file may be partially written so read the file again on the next lookup
+	if (fread(database->data, 1, size, file) != size)
+	{
+		fclose(file);
+		free(database);
+		return;
+	}
+	fclose(file);
+
+	entry->retry = false;
+	entry->status = status;
+
+	// Keep the generation number if the contents did not change
+	if (entry->database && entry->database->size == size &&
+		memcmp(entry->database->data, database->data, size) == 0)
+	{
+		free(database);
+		return;
+	}
+
+	database->generation = ++cache_generation;
+	ReleaseDatabaseLocked(entry->database);
+	entry->database = database;
+}
+
+// Remove the least recently used entry if the cache is full
+static void EvictEntries()
+{
+	while (cache_entries.size() >= DISK_DATABASE_CACHE_SIZE)
+	{
+		DISK_DATABASE_MAP::iterator oldest = cache_entries.begin();
+
+		for (DISK_DATABASE_MAP::iterator it = cache_entries.begin(); it != cache_entries.end(); it++)
+		{
+			if (it->second.used < oldest->second.used) {
+				oldest = it;
+			}
+		}
+
+		ReleaseDatabaseLocked(oldest->second.database);
+		cache_entries.erase(oldest);
+	}
+}
+
+DISK_DATABASE *AcquireDiskDatabase(const char *pathname)
+{
+	DISK_DATABASE_ENTRY *entry;
+	DISK_DATABASE *database;
+	uint64_t now;
+
+	if (pathname == NULL || pathname[0] == '\0') {
+		return NULL;
+	}
+
+	CAutoLock lock(cache_lock);
+
+	now = GetMilliseconds();
+	ReadNotifications();
+
+	// Compare with the keys directly so that the lookup on every frame does not allocate a string
+	DISK_DATABASE_MAP::iterator it;
+	for (it = cache_entries.begin(); it != cache_entries.end(); it++)
+	{
+		if (it->first == pathname) {
+			break;
+		}
+	}
+	if (it == cache_entries.end())
+	{
+		std::string name(pathname);
+		DISK_DATABASE_ENTRY new_entry;
+
+		EvictEntries();
+
+		memset(&new_entry, 0, sizeof(new_entry));
+		new_entry.changed = true;
+		new_entry.watch = WatchDirectory(name);
+		it = cache_entries.insert(DISK_DATABASE_MAP::value_type(name, new_entry)).first;
+	}
+	entry = &it->second;
+
+	// Files without change notification are checked periodically
+	if (entry->changed ||
+		((entry->watch < 0 || entry->retry) && now - entry->checked >= DISK_DATABASE_POLL_TIME))
+	{
+		RefreshEntry(it->first, entry, now);
+	}
+	entry->used = now;
+
+	database = entry->database;
+	if (database) {
+		database->refcount++;
+	}
+
+	return database;
+}
+
+void ReleaseDiskDatabase(DISK_DATABASE *database)
+{
+	if (database)
+	{
+		CAutoLock lock(cache_lock);
+		ReleaseDatabaseLocked(database);
+	}
+}
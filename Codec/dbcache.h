@@ -0,0 +1,61 @@
+/*! @file dbcache.h
+
+*  @brief Process-wide cache of the color database files
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _DBCACHE_H
+#define _DBCACHE_H
+
+// Maximum number of database files in the cache
+#define DISK_DATABASE_CACHE_SIZE	64
+
+// Interval for checking files that are not covered by change notification (in milliseconds)
+#define DISK_DATABASE_POLL_TIME		100
+
+/*!
+	@brief Contents of a database file (.colr, .col1, .col2) read from disk
+
+	The contents are never modified after the file is read.  A new instance
+	with a new generation number is created when the file changes, so the
+	generation number identifies the contents across all decoders.
+*/
+typedef struct disk_database
+{
+	int refcount;				// Number of references to this copy of the file
+	uint32_t generation;		// Unique number assigned when the file was read
+	size_t size;				// Size of the file contents (in bytes)
+	unsigned char *data;		// File contents
+
+} DISK_DATABASE;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Return a reference to the contents of the database file (NULL if the file does not exist)
+DISK_DATABASE *AcquireDiskDatabase(const char *pathname);
+
+// Release the reference returned by AcquireDiskDatabase
+void ReleaseDiskDatabase(DISK_DATABASE *database);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -174,11 +174,6 @@ bool AllocDecoderBuffer(DECODER *decoder, int width, int height, int format);
 void EraseDecoderFrames(DECODER *decoder);
 TRANSFORM *AllocGroupTransform(GROUP *group, int channel);
 void EraseOutputBuffer(uint8_t *buffer, int width, int height, int32_t pitch, int format);
-#if _DEBUG
-bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int width, int height, int pitch, FILE *logfile);
-#else
-bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int width, int height, int pitch);
-#endif
 bool DecodeBandFSM16sNoGapHighByte(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int width, int height, int pitch, int quant);
 bool DecodeBandFSM16sNoGap2Pass(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int width, int height, int pitch, int quant);
 void CopyLowpassRGB444ToBuffer(DECODER *decoder, IMAGE *image_array[], int num_channels,
@@ -578,6 +573,12 @@ void InitDecoder(DECODER *decoder, FILE *logfile, CODESET *cs)
 			decoder->thread_cntrl = saved_params;
 		}
 
+#if _THREADED
+		// Use the pools of worker threads owned by this decoder
+		decoder->entropy_worker_new.pool = &decoder->entropy_worker_new.owned_pool;
+		decoder->worker_thread.pool = &decoder->worker_thread.owned_pool;
+#endif
+
 #if _TIMING
 		InitTiming();
 #endif
@@ -830,15 +831,27 @@ void ClearDecoder(DECODER *decoder)
 #endif
 
 #if _THREADED
-	if(decoder->entropy_worker_new.pool.thread_count)
+	if(decoder->entropy_worker_new.pool != &decoder->entropy_worker_new.owned_pool)
+	{
+		// The pool belongs to the decoder for the first eye
+		DeleteLock(&decoder->entropy_worker_new.lock);
+		decoder->entropy_worker_new.pool = &decoder->entropy_worker_new.owned_pool;
+	}
+	else if(decoder->entropy_worker_new.pool->thread_count)
 	{
-		ThreadPoolDelete(&decoder->entropy_worker_new.pool);
+		ThreadPoolDelete(decoder->entropy_worker_new.pool);
 		DeleteLock(&decoder->entropy_worker_new.lock);
 	}
 
-	if(decoder->worker_thread.pool.thread_count)
+	if(decoder->worker_thread.pool != &decoder->worker_thread.owned_pool)
+	{
+		// The pool belongs to the decoder for the first eye
+		DeleteLock(&decoder->worker_thread.lock);
+		decoder->worker_thread.pool = &decoder->worker_thread.owned_pool;
+	}
+	else if(decoder->worker_thread.pool->thread_count)
 	{
-		ThreadPoolDelete(&decoder->worker_thread.pool);
+		ThreadPoolDelete(decoder->worker_thread.pool);
 		DeleteLock(&decoder->worker_thread.lock);
 	}
 
@@ -1000,6 +1013,7 @@ void ClearDecoder(DECODER *decoder)
 			Free(decoder->allocator, decoder->mdc[i]);
 		decoder->mdc[i] = NULL;
 		decoder->mdc_size[i] = 0;
+		decoder->mdc_limit[i] = 0;
 	}
 	
 #else
@@ -1116,6 +1130,7 @@ void ClearDecoder(DECODER *decoder)
 			MEMORY_FREE(decoder->mdc[i]);
 		decoder->mdc[i] = NULL;
 		decoder->mdc_size[i] = 0;
+		decoder->mdc_limit[i] = 0;
 	}
 #endif
 
@@ -1175,13 +1190,11 @@ void AllocDecoderGroup(DECODER *decoder)
 	}
 }
 
-// Allocate the buffer used for intermediate results during decoding
-bool AllocDecoderBuffer(DECODER *decoder, int width, int height, int format)
+// Compute the size of the buffer used for intermediate results during decoding
+static size_t DecoderBufferSize(int width, int format, int cpus)
 {
-	int cpus;
 	size_t size;
 	size_t row_size;
-	char *buffer;
 
 #if 0
 	// Allocate a buffer large enough for six rows of cache lines
@@ -1260,12 +1273,35 @@ bool AllocDecoderBuffer(DECODER *decoder, int width, int height, int format)
 		break;
 	}
 
-	cpus = decoder->thread_cntrl.capabilities >> 16;
 	if(cpus > 4)
 		size *= 4;
 	if(cpus > 16) //DAN20120803 -- 4444 clips 
 		size *= 2;
 
+	return size;
+}
+
+// Compute the size of the buffer allocated for each debayer/color formating thread
+static size_t DecoderThreadBufferSize(int width, int height)
+{
+	size_t size = (width+16)*3*2*4*2*4;// sixteen lines
+
+	if(height*4 > width*3)  //square or tall images where running out of scratch space for zooms.
+		size *= 1 + ((height+(width/2))/width);
+
+	return size;
+}
+
+// Allocate the buffer used for intermediate results during decoding
+bool AllocDecoderBuffer(DECODER *decoder, int width, int height, int format)
+{
+	int cpus;
+	size_t size;
+	char *buffer;
+
+	cpus = decoder->thread_cntrl.capabilities >> 16;
+	size = DecoderBufferSize(width, format, cpus);
+
 	// Has a buffer already been allocated?
 	if (decoder->buffer != NULL)
 	{
@@ -1317,10 +1353,7 @@ bool AllocDecoderBuffer(DECODER *decoder, int width, int height, int format)
 	{
 		int i;
 
-		size = (width+16)*3*2*4*2*4;// sixteen lines
-
-		if(height*4 > width*3)  //square or tall images where running out of scratch space for zooms.
-			size *= 1 + ((height+(width/2))/width);
+		size = DecoderThreadBufferSize(width, height);
 
 		if (decoder->threads_buffer_size < size)
 		{
@@ -1364,6 +1397,112 @@ bool AllocDecoderBuffer(DECODER *decoder, int width, int height, int format)
 	return true;
 }
 
+// Estimate the memory allocated by a decoder for the encoded dimensions and format, the decoded
+// format and resolution, and the number of threads (not including the decoder data structure)
+size_t DecoderMemorySize(int width, int height, int encoded_format, int decoded_format,
+						 int resolution, bool group, int cpus)
+{
+	int transform_type = group ? TRANSFORM_TYPE_FIELDPLUS : TRANSFORM_TYPE_SPATIAL;
+	int num_spatial = TRANSFORM_NUM_SPATIAL - 1;
+	int num_frames = group ? 2 : 1;
+	int num_channels;
+	int channel_width;
+	int chroma_width;
+	int channel_height;
+	size_t size = 0;
+	bool quarter = (resolution == DECODED_RESOLUTION_QUARTER ||
+					resolution == DECODED_RESOLUTION_LOWPASS_ONLY ||
+					resolution == DECODED_RESOLUTION_QUARTER_NODEBAYER_SCALED);
+	int channel;
+
+	if (width <= 0 || height <= 0) {
+		return 0;
+	}
+
+	if (cpus < 1) {
+		cpus = 1;
+	}
+
+	// The encoder rounds the height up to a multiple of eight
+	height = (height + 7) & ~0x07;
+
+	switch (encoded_format)
+	{
+	case ENCODED_FORMAT_BAYER:
+		num_channels = 4;
+		channel_width = chroma_width = width / 2;
+		channel_height = height / 2;
+		break;
+
+	case ENCODED_FORMAT_RGB_444:
+		num_channels = 3;
+		channel_width = chroma_width = width;
+		channel_height = height;
+		break;
+
+	case ENCODED_FORMAT_RGBA_4444:
+	case ENCODED_FORMAT_YUVA_4444:
+		num_channels = 4;
+		channel_width = chroma_width = width;
+		channel_height = height;
+		break;
+
+	case ENCODED_FORMAT_YUV_422:
+	default:
+		num_channels = 3;
+		channel_width = width;
+		chroma_width = width / 2;
+		channel_height = height;
+		break;
+	}
+
+	// Wavelets for each channel (the frame and temporal wavelets of YUV and RGB are not decoded at quarter resolution)
+	for (channel = 0; channel < num_channels; channel++)
+	{
+		int transform_width = (channel == 0) ? channel_width : chroma_width;
+
+		size += TransformWaveletSize(transform_type, transform_width, channel_height, num_spatial);
+
+		if (quarter && encoded_format != ENCODED_FORMAT_BAYER) {
+			size -= num_frames * WaveletStackSize(transform_width / 2, channel_height / 2, WAVELET_TYPE_FRAME);
+			if (group) {
+				size -= WaveletStackSize(transform_width / 2, channel_height / 2, WAVELET_TYPE_TEMPORAL);
+			}
+		}
+	}
+
+	// Codebooks, scratch buffer and the buffers for the debayer/color formating threads
+	size += CodebooksSize();
+	size += DecoderBufferSize(width, decoded_format, cpus);
+	size += cpus * DecoderThreadBufferSize(width, height);
+
+	if (!quarter)
+	{
+		// Intermediate buffers for color conversion of the full or half resolution frame
+		switch (encoded_format)
+		{
+		case ENCODED_FORMAT_BAYER:
+			// Bayer data and the RGB filter buffers used for demosaicing
+			size += 4 * (size_t)channel_width * channel_height * 4 * sizeof(PIXEL16U);
+			break;
+
+		case ENCODED_FORMAT_YUV_422:
+			size += (size_t)width * height * 4;
+			break;
+
+		default:
+			size += (size_t)width * height * num_channels * sizeof(PIXEL16U);
+			break;
+		}
+
+		// Color cube, curve tables and a look file
+		size += 65*65*65*3*2 + (16384*3)*2 + 6 * 65536*2;
+		size += 65*65*65*3*sizeof(float);
+	}
+
+	return size;
+}
+
 bool ResizeDecoderBuffer(DECODER *decoder, int width, int height, int format)
 {
 	// Check that the dimensions are valid
@@ -1602,7 +1741,7 @@ bool DecodeInit(DECODER *decoder, int width, int height, int format, int resolut
 		CreateLock(&decoder->entropy_worker_new.lock);
 
 		// Initialize the pool of transform worker threads
-		ThreadPoolCreate(&decoder->entropy_worker_new.pool,
+		ThreadPoolCreate(decoder->entropy_worker_new.pool,
 							threads,
 							EntropyWorkerThreadProc,
 							decoder);
@@ -1611,7 +1750,7 @@ bool DecodeInit(DECODER *decoder, int width, int height, int format, int resolut
 	// Initialize the lock that controls access to the generic worker thread data
 	CreateLock(&decoder->worker_thread.lock);
 	// Initialize the pool of transform worker threads
-	ThreadPoolCreate(&decoder->worker_thread.pool,
+	ThreadPoolCreate(decoder->worker_thread.pool,
 						cpus,
 						WorkerThreadProc,
 						decoder);
@@ -1707,7 +1846,9 @@ void DecodeEntropyInit(DECODER *decoder)
 
 #if _THREADED
   #if _DELAY_THREAD_START  //start threads now if not _DELAY_THREAD_START
-	if(cpus > 1 && decoder->entropy_worker_new.pool.thread_count == 0)
+	// The decoder for the second eye uses the pool of the decoder for the first eye
+	if(cpus > 1 && decoder->entropy_worker_new.pool == &decoder->entropy_worker_new.owned_pool &&
+		decoder->entropy_worker_new.pool->thread_count == 0)
 	{
 		int threads = cpus;
 		if(threads > 4) 
@@ -1716,7 +1857,7 @@ void DecodeEntropyInit(DECODER *decoder)
 		CreateLock(&decoder->entropy_worker_new.lock);
 
 		// Initialize the pool of transform worker threads
-		ThreadPoolCreate(&decoder->entropy_worker_new.pool,
+		ThreadPoolCreate(decoder->entropy_worker_new.pool,
 							threads,
 							EntropyWorkerThreadProc,
 							decoder);
@@ -1726,6 +1867,44 @@ void DecodeEntropyInit(DECODER *decoder)
 }
 
 
+#if (_THREADED && _DELAY_THREAD_START && _DELAYED_THREAD_START)
+/*
+	The decoder for the second eye submits its entropy decoding and transform
+	jobs to the pools of worker threads owned by the decoder for the first eye.
+	The jobs of the two eyes are serialized by the pools and the worker threads
+	process each job with the job parameters, transform queue, thread buffers,
+	and finite state machines of the decoder that submitted the job.
+*/
+static void ShareWorkerThreads(DECODER *decoder, DECODER *parallelDecoder)
+{
+	// The pool must exist before the decoder for the second eye can submit jobs
+	if(decoder->worker_thread.pool->thread_count == 0)
+	{
+		CreateLock(&decoder->worker_thread.lock);
+		// Initialize the pool of transform worker threads
+		ThreadPoolCreate(decoder->worker_thread.pool,
+						decoder->thread_cntrl.capabilities >> 16/*cpus*/,
+						WorkerThreadProc,
+						decoder);
+	}
+
+	// Each worker thread uses the thread buffer of the decoder that submitted the job
+	if(decoder->worker_thread.pool->thread_count > (parallelDecoder->thread_cntrl.capabilities >> 16) ||
+		decoder->entropy_worker_new.pool->thread_count > (parallelDecoder->thread_cntrl.capabilities >> 16))
+	{
+		return;
+	}
+
+	// The locks protect the job parameters and the transform queue of each decoder
+	CreateLock(&parallelDecoder->entropy_worker_new.lock);
+	CreateLock(&parallelDecoder->worker_thread.lock);
+
+	parallelDecoder->entropy_worker_new.pool = decoder->entropy_worker_new.pool;
+	parallelDecoder->worker_thread.pool = decoder->worker_thread.pool;
+}
+#endif
+
+
 bool DecodeOverrides(DECODER *decoder, unsigned char *overrideData, int overrideSize)
 {
 	if(decoder->overrideData)
@@ -2142,6 +2321,7 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
 	TAGVALUE segment;
 	int sample_type;
 	int sample_size = 0;
+	uint8_t *sample_start;
 
 	// Group index
 	uint32_t channel_size[TRANSFORM_MAX_CHANNELS];
@@ -2195,6 +2375,7 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
 #endif
 	
 	sample_size = input->nWordsUsed;
+	sample_start = input->lpCurrentWord;
 
 	// Get the type of sample (should be the first tag value pair)
 	segment = GetTagValue(input);
@@ -2526,6 +2707,13 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
 							header->width = header->height = 0;
 							return false;
 						}
+
+						// One channel extracted from a stereo sample is a 2D sample
+						if (header->videoChannels == 2 && currentVideoChannel <= 1 &&
+							FindVideoChannel(sample_start, sample_size, 0, NULL, NULL) < 2)
+						{
+							header->videoChannels = 1;
+						}
 					}
 					break;
 					
@@ -2710,72 +2898,107 @@ bool DumpSampleHeader(BITSTREAM *input, FILE *logfile)
 	return true;
 }
 
-int SkipVideoChannel(DECODER *decoder, BITSTREAM *input, int skip_to_channel) // 3D work
+/*
+	Each channel (eye) of a stereo sample is a complete sample that ends with the
+	sample size chunk, so a channel can be decoded as a 2D sample without copying.
+	Returns the number of channels found in the sample and the location of the
+	requested channel (zero is the first channel).
+*/
+int FindVideoChannel(uint8_t *sample, size_t sample_size, int channel,
+					 size_t *channel_offset_out, size_t *channel_size_out)
 {
-	TAGWORD tag,value=1; 
-	unsigned char *pos = NULL;
-	int readsize =  input->nWordsUsed;
-	if(readsize > 4096) // only need to scan the first few tuplets
-	{
-		readsize = 4096;
-	}
-	else
-	{
-		//Tiny therefore P-frame, nothing to be read so:
-		value=decoder->real_channels; // return the last value.
-		return value;
-	}
-
-
-	pos = GetTupletAddr(input->lpCurrentBuffer, readsize, CODEC_TAG_ENCODED_CHANNELS, &value);
+	size_t start = 0;
+	int count = 0;
 
-	if(pos && value>1 && skip_to_channel>1)
+	while (start < sample_size)
 	{
-		int chunksize = 0;
-		intptr_t offset;
-		int count = 0;
+		size_t remaining = sample_size - start;
+		int readsize = (remaining > 4096) ? 4096 : (int)remaining;
+		size_t end = sample_size;
+		size_t next = sample_size;
+		int16_t value = 1;
+		uint8_t *pos;
 
-		do
+		pos = GetTupletAddr(sample + start, readsize, CODEC_TAG_ENCODED_CHANNELS, &value);
+
+		if (pos && value > 1)
 		{
-			tag = *pos++<<8;
-			tag |= *pos++;
-			value = *pos++<<8;
-			value |= *pos++;
+			TAGWORD tag = 0;
+			int chunksize = 0;
+			int tuplets = 0;
 
-			if (tag < 0)
+			// The sample size chunk follows the number of encoded channels
+			do
 			{
-				tag = NEG(tag);
-			}
-		} while((tag & 0xff00) != CODEC_TAG_SAMPLE_SIZE && count++ < 10);
+				tag = pos[0] << 8 | pos[1];
+				chunksize = pos[2] << 8 | pos[3];
+				pos += 4;
 
-		if((tag & 0xff00) == CODEC_TAG_SAMPLE_SIZE)
-		{
-			chunksize = value;
-			chunksize &= 0xffff;
-			chunksize += ((tag&0xff)<<16);
+				if (tag < 0)
+				{
+					tag = NEG(tag);
+				}
+			} while ((tag & 0xff00) != CODEC_TAG_SAMPLE_SIZE && tuplets++ < 10);
 
-			offset = ((intptr_t)pos - (intptr_t)input->lpCurrentWord) + chunksize*4;
+			if ((tag & 0xff00) == CODEC_TAG_SAMPLE_SIZE)
+			{
+				chunksize += ((tag & 0xff) << 16);
 
-			input->lpCurrentWord += offset;
-			input->nWordsUsed -= (int)offset;
+				// The channel ends with the sample size chunk
+				end = (pos - sample) + (size_t)chunksize * 4;
+				if (end > sample_size) {
+					end = sample_size;
+				}
 
-			{
-				uint8_t *tag = (uint8_t *)input->lpCurrentWord;
-			
-				// Search for first sample of the next frame
-				while((tag[1] != (uint8_t)CODEC_TAG_SAMPLE || tag[0] != 0 || tag[2] != 0) && input->nWordsUsed > 0)
+				// Search for the first tag of the next channel (after the alignment padding)
+				for (next = end; next + 4 <= sample_size; next += 4)
 				{
-					input->lpCurrentWord += 4;
-					input->nWordsUsed -= 4;
-					tag += 4;
+					uint8_t *word = sample + next;
+					if (word[0] == 0 && word[1] == (uint8_t)CODEC_TAG_SAMPLE && word[2] == 0) {
+						break;
+					}
+				}
+				if (next + 4 > sample_size) {
+					next = sample_size;
 				}
-
 			}
 		}
+
+		if (count == channel)
+		{
+			if (channel_offset_out) *channel_offset_out = start;
+			if (channel_size_out) *channel_size_out = end - start;
+		}
+
+		count++;
+		start = next;
+	}
+
+	return count;
+}
+
+int SkipVideoChannel(DECODER *decoder, BITSTREAM *input, int skip_to_channel) // 3D work
+{
+	int channels;
+	size_t offset = 0;
+
+	if(input->nWordsUsed <= 4096)
+	{
+		//Tiny therefore P-frame, nothing to be read so:
+		return decoder->real_channels; // return the last value.
+	}
+
+	// Count the channels that are actually present so that one channel of a stereo sample decodes as 2D
+	channels = FindVideoChannel(input->lpCurrentWord, input->nWordsUsed, skip_to_channel - 1, &offset, NULL);
+
+	if(skip_to_channel > 1 && channels >= skip_to_channel)
+	{
+		input->lpCurrentWord += offset;
+		input->nWordsUsed -= (int)offset;
 	}
 
 	//if(value == 0) value = 1; // old non-stereo file
-	return value;
+	return channels;
 }
 
 
@@ -8899,11 +9122,11 @@ void PaintFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 		int workunits;
 
 	#if _DELAY_THREAD_START
-		if(decoder->tools->histogram == 0 && decoder->worker_thread.pool.thread_count == 0)
+		if(decoder->tools->histogram == 0 && decoder->worker_thread.pool->thread_count == 0)
 		{
 			CreateLock(&decoder->worker_thread.lock);
 			// Initialize the pool of transform worker threads
-			ThreadPoolCreate(&decoder->worker_thread.pool,
+			ThreadPoolCreate(decoder->worker_thread.pool,
 							decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 							WorkerThreadProc,
 							decoder);
@@ -8934,14 +9157,16 @@ void PaintFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 			{
 				mailbox->jobType = JOB_TYPE_HISTOGRAM; // histogram
 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of rows to process
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 
 				// Start the transform worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 			}
 
 
@@ -9037,14 +9262,16 @@ void PaintFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 
 		mailbox->jobType = JOB_TYPE_BURNINS; // burnin
 
+		ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 		// Set the work count to the number of rows to process
-		ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+		ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 
 		// Start the transform worker threads
-		ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+		ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 		// Wait for all of the worker threads to finish
-		ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+		ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+		ThreadPoolEndJob(decoder->worker_thread.pool);
 	}
 	#else
 
@@ -9095,6 +9322,16 @@ void PaintFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 
 extern int geomesh_alloc_cache(void *gm);
 
+// Reuse the mesh and its cache when the lens parameters change (the mesh is initialized again)
+static void *CreateWarpMesh(void *mesh, int meshwidth, int meshheight)
+{
+	if (mesh == NULL)
+		return geomesh_create(meshwidth, meshheight);
+
+	geomesh_resize(mesh, meshwidth, meshheight);
+	return mesh;
+}
+
 #define DEG2RAD(d)    (PI*(d)/180.0f)
 #define RAD2DEG(r)    (180.0f*(r)/PI)
 
@@ -9141,9 +9378,12 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 	float sensorcrop = 1.0;
 	float phi, theta, rho;
 	int srcLens = HERO4;
+	uint64_t telemetry_start;
 
 	if (!cfhddata->doMesh) return;
 
+	telemetry_start = TELEMETRY_START(decoder->telemetry);
+
 	if (decoder->lastLensOffsetX != cfhddata->LensOffsetX ||
 		decoder->lastLensOffsetY != cfhddata->LensOffsetY ||
 		decoder->lastLensOffsetZ != cfhddata->LensOffsetZ ||
@@ -9157,10 +9397,6 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 		memcmp(decoder->lastLensCustomSRC, cfhddata->lensCustomSRC, sizeof(cfhddata->lensCustomSRC)) ||
 		memcmp(decoder->lastLensCustomDST, cfhddata->lensCustomDST, sizeof(cfhddata->lensCustomDST)) )
 	{
-		if (decoder->mesh)
-			geomesh_destroy(decoder->mesh);
-
-
 		width = decoder->frame.width;
 		height = decoder->frame.height;
 
@@ -9186,11 +9422,11 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 			}
 
 			if (width >= 2496)
-				decoder->mesh = geomesh_create(199, 99);
+				decoder->mesh = CreateWarpMesh(decoder->mesh, 199, 99);
 			else if (width >= 1272)
-				decoder->mesh = geomesh_create(99, 49);
+				decoder->mesh = CreateWarpMesh(decoder->mesh, 99, 49);
 			else
-				decoder->mesh = geomesh_create(49, 25);
+				decoder->mesh = CreateWarpMesh(decoder->mesh, 49, 25);
 
 			phi = cfhddata->LensOffsetX * DEG2RAD(720.0f); // +-180deg HFOV for 2:1
 			theta = cfhddata->LensOffsetY * DEG2RAD(720.0f); // +-180deg VFOV for 2:1
@@ -9202,11 +9438,11 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 			sensorcrop = 1.0;
 
 			if (width > 2880) // UHD
-				decoder->mesh = geomesh_create(159, 119);
+				decoder->mesh = CreateWarpMesh(decoder->mesh, 159, 119);
 			else if (width >= 1920) //HD/2.7K
-				decoder->mesh = geomesh_create(79, 59);
+				decoder->mesh = CreateWarpMesh(decoder->mesh, 79, 59);
 			else
-				decoder->mesh = geomesh_create(39, 29);
+				decoder->mesh = CreateWarpMesh(decoder->mesh, 39, 29);
 			phi = cfhddata->LensOffsetX * DEG2RAD(120.0f); // +-60deg HFOV for 16:9
 			theta = cfhddata->LensOffsetY * DEG2RAD(98.0f); // +-49deg VFOV for 16:9
 			rho = (cfhddata->LensOffsetZ - 1.0f)*4.0f* DEG2RAD(360.0f); // +-360deg 
@@ -9216,11 +9452,11 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 			srcLens = HERO4;
 			sensorcrop = sqrtf(1920 * 1920 + 1080 * 1080) / sqrtf(2000 * 2000 + 1500 * 1500); // 3840x2160 from 4000x3000
 			if (width > 2880) // UHD
-				decoder->mesh = geomesh_create(159, 119);
+				decoder->mesh = CreateWarpMesh(decoder->mesh, 159, 119);
 			else if (width >= 1920) //HD/2.7K
-				decoder->mesh = geomesh_create(79, 59);
+				decoder->mesh = CreateWarpMesh(decoder->mesh, 79, 59);
 			else
-				decoder->mesh = geomesh_create(39, 29);
+				decoder->mesh = CreateWarpMesh(decoder->mesh, 39, 29);
 			phi = cfhddata->LensOffsetX * DEG2RAD(120.0f); // +-60.1deg HFOV for 16:9
 			theta = cfhddata->LensOffsetY * DEG2RAD(70.0f); // +-34.75deg VFOV for 16:9
 			rho = (cfhddata->LensOffsetZ - 1.0f)*4.0f* DEG2RAD(360.0f); // +-360deg 
@@ -9347,11 +9583,11 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 			int workunits = decoder->frame.height;
 
 #if _DELAY_THREAD_START
-			if (decoder->worker_thread.pool.thread_count == 0)
+			if (decoder->worker_thread.pool->thread_count == 0)
 			{
 				CreateLock(&decoder->worker_thread.lock);
 				// Initialize the pool of transform worker threads
-				ThreadPoolCreate(&decoder->worker_thread.pool,
+				ThreadPoolCreate(decoder->worker_thread.pool,
 					decoder->thread_cntrl.capabilities >> 16,
 					WorkerThreadProc,
 					decoder);
@@ -9367,12 +9603,14 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 				workunits = (mailbox->line_max + mailbox->chunk_size - 1) / mailbox->chunk_size;
 				mailbox->jobType = JOB_TYPE_WARP_CACHE;
 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of rows to process
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 				// Start the transform worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 			}
 		}
 #endif
@@ -9406,12 +9644,14 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 		workunits = (mailbox->line_max + mailbox->chunk_size-1)/mailbox->chunk_size;
 		mailbox->jobType = JOB_TYPE_WARP;
 
+		ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 		// Set the work count to the number of rows to process
-		ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+		ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 		// Start the transform worker threads
-		ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+		ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 		// Wait for all of the worker threads to finish
-		ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+		ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+		ThreadPoolEndJob(decoder->worker_thread.pool);
 
 		if(backgroundfill) // may need to blur the filled in areas
 		{
@@ -9424,12 +9664,14 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 			workunits = (mailbox->line_max + mailbox->chunk_size-1)/mailbox->chunk_size;
 			mailbox->jobType = JOB_TYPE_WARP_BLURV;
 
+			ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 			// Set the work count to the number of rows to process
-			ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+			ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 			// Start the transform worker threads
-			ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+			ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 			// Wait for all of the worker threads to finish
-			ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+			ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+			ThreadPoolEndJob(decoder->worker_thread.pool);
 		}
 	}
 #else // not threading
@@ -9442,6 +9684,8 @@ void WarpFrame(DECODER *decoder, uint8_t *output, int pitch, int output_format)
 
 	memcpy(output, decoder->lens_correct_buffer, pitch * decoder->frame.height);
 
+	TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_WARP, -1, telemetry_start);
+
 	/*
 	if(lens_correct_buffer)
 #if _ALLOCATOR
@@ -9622,11 +9866,11 @@ void ConvertLocalToOutput(DECODER *decoder, uint8_t *output, int pitch, int outp
 		int workunits;
 
 	#if _DELAY_THREAD_START
-		if(decoder->worker_thread.pool.thread_count == 0)
+		if(decoder->worker_thread.pool->thread_count == 0)
 		{
 			CreateLock(&decoder->worker_thread.lock);
 			// Initialize the pool of transform worker threads
-			ThreadPoolCreate(&decoder->worker_thread.pool,
+			ThreadPoolCreate(decoder->worker_thread.pool,
 							decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 							WorkerThreadProc,
 							decoder);
@@ -9759,14 +10003,16 @@ void ConvertLocalToOutput(DECODER *decoder, uint8_t *output, int pitch, int outp
 
 				workunits = (mailbox->line_max + mailbox->chunk_size - 1) / mailbox->chunk_size;
 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of rows to process
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 
 				// Start the transform worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 
 
 				// Post a message to the mailbox
@@ -9782,14 +10028,16 @@ void ConvertLocalToOutput(DECODER *decoder, uint8_t *output, int pitch, int outp
 
 				workunits = (mailbox->line_max + mailbox->chunk_size - 1) / mailbox->chunk_size;
 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of rows to process
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 
 				// Start the transform worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 			}
 			else
 			{
@@ -9816,14 +10064,16 @@ void ConvertLocalToOutput(DECODER *decoder, uint8_t *output, int pitch, int outp
 
 				workunits = (mailbox->line_max + mailbox->chunk_size - 1) / mailbox->chunk_size;
 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of rows to process
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 
 				// Start the transform worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 
 			}
 		}
@@ -9847,14 +10097,16 @@ void ConvertLocalToOutput(DECODER *decoder, uint8_t *output, int pitch, int outp
 		decoder->doVerticalFilter = 0;
 		mailbox->jobType = JOB_TYPE_HORIZONAL_3D; // 3d work && horizontal and vertical flips
 
+		ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 		// Set the work count to the number of rows to process
-		ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+		ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 
 		// Start the transform worker threads
-		ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+		ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 		// Wait for all of the worker threads to finish
-		ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+		ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+		ThreadPoolEndJob(decoder->worker_thread.pool);
 
 
 
@@ -9882,14 +10134,16 @@ void ConvertLocalToOutput(DECODER *decoder, uint8_t *output, int pitch, int outp
 
 			mailbox->jobType = JOB_TYPE_SHARPEN; // 3d work && horizontal and vertical flips
 
+			ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 			// Set the work count to the number of rows to process
-			ThreadPoolSetWorkCount(&decoder->worker_thread.pool, workunits);
+			ThreadPoolSetWorkCount(decoder->worker_thread.pool, workunits);
 
 			// Start the transform worker threads
-			ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+			ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 			// Wait for all of the worker threads to finish
-			ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+			ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+			ThreadPoolEndJob(decoder->worker_thread.pool);
 		}
 	}
 #else
@@ -10105,6 +10359,7 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 
 	decoder->sample_uncompressed = 0; // set if a uncompressed sample is found.
 	decoder->image_dev_only = 0;
+	decoder->lowpass_output = 0;
 
 	if(decoder->flags & (1<<3)) // This is an image development only decode.
 	{
@@ -10147,6 +10402,7 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 	{
 		SAMPLE_HEADER header;		
 		BITSTREAM input2;
+		uint64_t telemetry_start = TELEMETRY_START(decoder->telemetry);
 		InitBitstreamBuffer(&input2, input->lpCurrentWord, input->nWordsUsed, BITSTREAM_ACCESS_READ);
 		memset(&header, 0, sizeof(SAMPLE_HEADER));
 		header.find_lowpass_bands = 2; // help finding the uncompressed flag
@@ -10157,6 +10413,7 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 			if(decoder->parallelDecoder)
 				decoder->parallelDecoder->sample_uncompressed = header.hdr_uncompressed;
 		}
+		TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_HEADER, -1, telemetry_start);
 	}
 	
 	if((uintptr_t)input->lpCurrentBuffer & 0x3)
@@ -10879,6 +11136,7 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 		if(decoder->parallelDecoder)
 		{
 			memset(decoder->parallelDecoder, 0, sizeof(DECODER));
+			decoder->parallelDecoder->thread_cntrl = decoder->thread_cntrl;
 			DecodeInit(decoder->allocator, decoder->parallelDecoder, encoded_width, encoded_height,
 							internal_format, DECODED_RESOLUTION_FULL, NULL);
 		}
@@ -10892,6 +11150,14 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 							internal_format, DECODED_RESOLUTION_FULL, NULL);
 		}
 #endif
+
+#if (_DELAY_THREAD_START && _DELAYED_THREAD_START)
+		if(decoder->parallelDecoder)
+		{
+			// Decode the second eye with the worker threads of this decoder
+			ShareWorkerThreads(decoder, decoder->parallelDecoder);
+		}
+#endif
 	}
 
 	// Using the parallel decoder?
@@ -10908,6 +11174,7 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 		decoder->parallelDecoder->channel_blend_type = decoder->channel_blend_type;
 		decoder->parallelDecoder->flags = decoder->flags;
 		decoder->parallelDecoder->frame = decoder->frame;
+		decoder->parallelDecoder->telemetry = decoder->telemetry;
 
 		decoder->parallelDecoder->use_local_buffer = use_local_buffer ? 1 : 0;
 		decoder->parallelDecoder->codec.encoded_format = decoder->codec.encoded_format;
@@ -11123,6 +11390,8 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 
 	if(use_local_buffer && output)
 	{
+		uint64_t telemetry_start;
+
 		decoder->use_local_buffer = 0;
 
 #if WARPSTUFF
@@ -11131,8 +11400,9 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 		MaskFrame(decoder, local_buffer, local_pitch, decoder->StereoBufferFormat);
 #endif
 
+		telemetry_start = TELEMETRY_START(decoder->telemetry);
 		ConvertLocalToOutput(decoder, output, pitch, output_format, local_buffer, local_pitch, abs(channel_offset));
-
+		TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_OUTPUT, -1, telemetry_start);
 	}
 	else
 	{
@@ -11168,6 +11438,13 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 	}
 #endif
 
+	// The lowpass bands match the output only if one intra frame was decoded without processing the output
+	decoder->lowpass_output = (result && output && !use_local_buffer &&
+							   decoder->channel_decodes == 1 &&
+							   decoder->gop_length == 1 &&
+							   !decoder->sample_uncompressed &&
+							   decoder->codec.encoded_format != ENCODED_FORMAT_BAYER &&
+							   decoder->cfhddata.BurninFlags == 0);
 
 	STOP(tk_decompress);
 
@@ -11337,7 +11614,7 @@ bool DecodeSampleGroup(DECODER *decoder, BITSTREAM *input, uint8_t *output, int
 #endif
 #if _THREADED_DECODER
 					// Add the temporal inverse transform to the processing queue
-					if(decoder->entropy_worker_new.pool.thread_count)
+					if(decoder->entropy_worker_new.pool->thread_count)
 					{
 						ReconstructWaveletBand(decoder, transform, channel, wavelet, temporal_index,
 							precision, &decoder->scratch, 1);
@@ -11429,6 +11706,7 @@ decoding_complete:
 		// Return the first frame in the group
 		if (!decoder->no_output)
 		{
+			uint64_t telemetry_start = TELEMETRY_START(decoder->telemetry);
 #if 0
 			// Decoding to quarter frame resolution at full frame rate?
 			if (resolution == DECODED_RESOLUTION_QUARTER)
@@ -11452,6 +11730,8 @@ decoding_complete:
 
 			// Finish computing the output frame
 			ReconstructSampleFrameToBuffer(decoder, 0, output, pitch);
+
+			TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_TRANSFORM, 0, telemetry_start);
 		}
 
 		if (decoder->error != CODEC_ERROR_OKAY) {
@@ -11542,8 +11822,10 @@ bool DecodeSampleFrame(DECODER *decoder, BITSTREAM *input, uint8_t *output, int
 		if (decoder->gop_length >= 2)
 		{
 			int frame_index = 1;	// Display the second frame in the group
+			uint64_t telemetry_start = TELEMETRY_START(decoder->telemetry);
 
 			ReconstructSampleFrameToBuffer(decoder, frame_index, output, pitch);
+			TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_TRANSFORM, 0, telemetry_start);
 			if (decoder->error != CODEC_ERROR_OKAY) {
 				result = false;
 			}
@@ -11551,8 +11833,10 @@ bool DecodeSampleFrame(DECODER *decoder, BITSTREAM *input, uint8_t *output, int
 		else if (decoder->gop_length > 0)
 		{
 			int frame_index = 0;	// Display the first frame in the group
+			uint64_t telemetry_start = TELEMETRY_START(decoder->telemetry);
 
 			ReconstructSampleFrameToBuffer(decoder, frame_index, output, pitch);
+			TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_TRANSFORM, 0, telemetry_start);
 			if (decoder->error != CODEC_ERROR_OKAY) {
 				result = false;
 			}
@@ -11751,7 +12035,7 @@ bool DecodeSampleIntraFrame(DECODER *decoder, BITSTREAM *input, uint8_t *output,
 #endif
 #if _THREADED_DECODER
 					// Add the inverse spatial transform to the processing queue
-					if(decoder->entropy_worker_new.pool.thread_count)
+					if(decoder->entropy_worker_new.pool->thread_count)
 					{
 						ReconstructWaveletBand(decoder, transform, channel, wavelet, wavelet_index,
 													precision, &decoder->scratch, 1);
@@ -11815,6 +12099,7 @@ decoding_completeI:
 		if (!decoder->no_output)
 		{
 			int uncompressed = decoder->uncompressed_chunk && decoder->uncompressed_size && decoder->sample_uncompressed;
+			uint64_t telemetry_start = TELEMETRY_START(decoder->telemetry);
 			if ( !uncompressed && resolution == DECODED_RESOLUTION_QUARTER && (decoder->codec.encoded_format != ENCODED_FORMAT_BAYER))
 			{
 				//CODEC_STATE *codec = &decoder->codec;
@@ -11835,6 +12120,8 @@ decoding_completeI:
 				// Finish computing the output frame
 				ReconstructSampleFrameToBuffer(decoder, 0, output, pitch);
 			}
+
+			TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_TRANSFORM, 0, telemetry_start);
 		}
 
 		if (decoder->error != CODEC_ERROR_OKAY) {
@@ -11943,6 +12230,7 @@ bool DecodeSampleSubband(DECODER *decoder, BITSTREAM *input, int subband)
 	IMAGE *wavelet = NULL;
 
 	bool result;
+	uint64_t telemetry_start;
 	
 	if(subband >= 7 && subband <= 10 && transform_type == TRANSFORM_TYPE_FIELDPLUS)
 		threading = 0;
@@ -12074,7 +12362,9 @@ bool DecodeSampleSubband(DECODER *decoder, BITSTREAM *input, int subband)
 		// The lowpass band must be subband zero
 		assert(subband == 0);
 
+		telemetry_start = TELEMETRY_START(decoder->telemetry);
 		result = DecodeSampleLowPassBand(decoder, input, wavelet);
+		TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_ENTROPY, 0, telemetry_start);
 		if (result)
 		{
 			// Call thread safe routine to update the band valid flags
@@ -12131,7 +12421,7 @@ bool DecodeSampleSubband(DECODER *decoder, BITSTREAM *input, int subband)
 
 		if ((transform->type == TRANSFORM_TYPE_SPATIAL && index > 0) || index >= 2)
 		{
-			if(decoder->entropy_worker_new.pool.thread_count && threading)
+			if(decoder->entropy_worker_new.pool->thread_count && threading)
 			{
 				ReconstructWaveletBand(decoder, transform, codec->channel, wavelet, index,
 											codec->precision, &decoder->scratch, 1);
@@ -12992,6 +13282,9 @@ void ReconstructWaveletBand(DECODER *decoder, TRANSFORM *transform, int channel,
 
 	PIXEL *buffer = (PIXEL *)scratch->free_ptr;
 	size_t buffer_size = scratch->free_size;
+
+	// The early returns are allocation failures that are not included in the statistics
+	uint64_t telemetry_start = TELEMETRY_START(allocations_only ? NULL : decoder->telemetry);
 	
 	// Is the current wavelet a spatial wavelet?
 	if (transform_type == TRANSFORM_TYPE_SPATIAL && index > 0)
@@ -13258,6 +13551,10 @@ void ReconstructWaveletBand(DECODER *decoder, TRANSFORM *transform, int channel,
 	#endif
 		}
 	}
+
+	if (!allocations_only) {
+		TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_TRANSFORM, index, telemetry_start);
+	}
 }
 
 // Compute the dimensions of the output buffer
@@ -13382,6 +13679,76 @@ void ComputeOutputDimensions(DECODER *decoder, int frame,
 	*decoded_height_out = decoded_height;
 }
 
+/*!
+	@brief Output the last decoded frame at a lower resolution
+
+	The lowpass band of each wavelet was computed by the inverse transform
+	while decoding the frame at the higher resolution and is the frame at a
+	lower resolution, so the frame can be output at half or quarter resolution
+	without decoding the sample again.  The output is the same as decoding the
+	sample at the lower resolution with the same decoded format.
+
+	Returns false if the last frame cannot be output from the lowpass bands,
+	for example if the frame was processed after the inverse transform.
+*/
+bool ReconstructLowpassFrameToBuffer(DECODER *decoder, int resolution, uint8_t *output, int pitch)
+{
+	FRAME_INFO saved_frame;
+	int use_active_metadata_decoder;
+	int apply_color_active_metadata;
+	int scale;
+
+	if (decoder == NULL || !decoder->lowpass_output || output == NULL || pitch == 0) {
+		return false;
+	}
+
+	// The lowpass bands are only valid for resolutions below the decoded resolution
+	if (decoder->frame.resolution == DECODED_RESOLUTION_FULL && resolution == DECODED_RESOLUTION_HALF) {
+		scale = 2;
+	}
+	else if (decoder->frame.resolution == DECODED_RESOLUTION_FULL && resolution == DECODED_RESOLUTION_QUARTER) {
+		scale = 4;
+	}
+	else if (decoder->frame.resolution == DECODED_RESOLUTION_HALF && resolution == DECODED_RESOLUTION_QUARTER) {
+		scale = 2;
+	}
+	else {
+		return false;
+	}
+
+	// Reconstructing the frame can change the frame dimensions and the active metadata flags
+	memcpy(&saved_frame, &decoder->frame, sizeof(FRAME_INFO));
+	use_active_metadata_decoder = decoder->use_active_metadata_decoder;
+	apply_color_active_metadata = decoder->apply_color_active_metadata;
+
+	decoder->frame.width /= scale;
+	decoder->frame.height /= scale;
+	decoder->frame.resolution = resolution;
+	decoder->error = CODEC_ERROR_OKAY;
+
+	// The cube is not rebuilt for the lower resolution so apply the quarter resolution rule in ComputeCube
+	if (resolution == DECODED_RESOLUTION_QUARTER && decoder->codec.encoded_format == ENCODED_FORMAT_YUV_422) {
+		decoder->use_active_metadata_decoder = true;
+	}
+
+	if (resolution == DECODED_RESOLUTION_QUARTER)
+	{
+		// Same routine as decoding an intra frame at quarter resolution
+		ConvertQuarterFrameToBuffer(decoder, decoder->transform, decoder->codec.num_channels,
+									output, pitch, &decoder->frame, decoder->codec.precision);
+	}
+	else
+	{
+		ReconstructSampleFrameToBuffer(decoder, 0, output, pitch);
+	}
+
+	memcpy(&decoder->frame, &saved_frame, sizeof(FRAME_INFO));
+	decoder->use_active_metadata_decoder = use_active_metadata_decoder;
+	decoder->apply_color_active_metadata = apply_color_active_metadata;
+
+	return (decoder->error == CODEC_ERROR_OKAY);
+}
+
 #define DEBUG_ROW16U	0
 
 void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output, int pitch)
@@ -14148,11 +14515,11 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
 					WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 	#if _DELAY_THREAD_START
-					if(decoder->worker_thread.pool.thread_count == 0)
+					if(decoder->worker_thread.pool->thread_count == 0)
 					{
 						CreateLock(&decoder->worker_thread.lock);
 						// Initialize the pool of transform worker threads
-						ThreadPoolCreate(&decoder->worker_thread.pool,
+						ThreadPoolCreate(decoder->worker_thread.pool,
 										decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 										WorkerThreadProc,
 										decoder);
@@ -14165,14 +14532,16 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
 					memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
 					mailbox->jobType = JOB_TYPE_OUTPUT;
 
+					ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 					// Set the work count to the number of rows to process
-					ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+					ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 					// Start the transform worker threads
-					ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+					ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 					// Wait for all of the worker threads to finish
-					ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+					ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+					ThreadPoolEndJob(decoder->worker_thread.pool);
 
 #else
 					//unsigned short scanline[4096*3],*sptr;
@@ -14642,12 +15011,13 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
 
 #if _THREADED				//DemosaicRAW
 							WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
+							uint64_t telemetry_start;
 	#if _DELAY_THREAD_START
-							if(decoder->worker_thread.pool.thread_count == 0)
+							if(decoder->worker_thread.pool->thread_count == 0)
 							{
 								CreateLock(&decoder->worker_thread.lock);
 								// Initialize the pool of transform worker threads
-								ThreadPoolCreate(&decoder->worker_thread.pool,
+								ThreadPoolCreate(decoder->worker_thread.pool,
 												decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 												WorkerThreadProc,
 												decoder);
@@ -14659,14 +15029,20 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
 							memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
 							mailbox->jobType = JOB_TYPE_OUTPUT;
 
+							telemetry_start = TELEMETRY_START(decoder->telemetry);
+
+							ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 							// Set the work count to the number of rows to process
-							ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+							ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 							// Start the transform worker threads
-							ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+							ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 							// Wait for all of the worker threads to finish
-							ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+							ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+							ThreadPoolEndJob(decoder->worker_thread.pool);
+
+							TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_DEMOSAIC, -1, telemetry_start);
 
 #else
 							assert(0) // old code disabled
@@ -14739,13 +15115,14 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
 						{
 #if _THREADED
 							WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
+							uint64_t telemetry_start;
 
 	#if _DELAY_THREAD_START
-							if(decoder->worker_thread.pool.thread_count == 0)
+							if(decoder->worker_thread.pool->thread_count == 0)
 							{
 								CreateLock(&decoder->worker_thread.lock);
 								// Initialize the pool of transform worker threads
-								ThreadPoolCreate(&decoder->worker_thread.pool,
+								ThreadPoolCreate(decoder->worker_thread.pool,
 												decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 												WorkerThreadProc,
 												decoder);
@@ -14757,14 +15134,20 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
 							memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
 							mailbox->jobType = JOB_TYPE_OUTPUT;
 
+							telemetry_start = TELEMETRY_START(decoder->telemetry);
+
+							ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 							// Set the work count to the number of rows to process
-							ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+							ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 							// Start the transform worker threads
-							ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+							ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 							// Wait for all of the worker threads to finish
-							ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+							ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+							ThreadPoolEndJob(decoder->worker_thread.pool);
+
+							TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_DEMOSAIC, -1, telemetry_start);
 #else
 							assert(0) // old code disabled
 						/*	{
@@ -15432,13 +15815,14 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
 						{
 #if _THREADED
 							WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
+							uint64_t telemetry_start;
 
 	#if _DELAY_THREAD_START
-							if(decoder->worker_thread.pool.thread_count == 0)
+							if(decoder->worker_thread.pool->thread_count == 0)
 							{
 								CreateLock(&decoder->worker_thread.lock);
 								// Initialize the pool of transform worker threads
-								ThreadPoolCreate(&decoder->worker_thread.pool,
+								ThreadPoolCreate(decoder->worker_thread.pool,
 												decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 												WorkerThreadProc,
 												decoder);
@@ -15450,14 +15834,20 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
 							memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
 							mailbox->jobType = JOB_TYPE_OUTPUT;
 
+							telemetry_start = TELEMETRY_START(decoder->telemetry);
+
+							ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 							// Set the work count to the number of rows to process
-							ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+							ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 							// Start the transform worker threads
-							ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+							ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 							// Wait for all of the worker threads to finish
-							ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+							ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+							ThreadPoolEndJob(decoder->worker_thread.pool);
+
+							TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_DEMOSAIC, -1, telemetry_start);
 #else
 							//unsigned short scanline[8192*3],*sptr;
 							//unsigned short scanline2[8192*3],*sptr2;
@@ -17082,11 +17472,11 @@ void ConvertQuarterFrameToBuffer(DECODER *decoder, TRANSFORM **transform_array,
 			WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 	#if _DELAY_THREAD_START
-			if(decoder->worker_thread.pool.thread_count == 0)
+			if(decoder->worker_thread.pool->thread_count == 0)
 			{
 				CreateLock(&decoder->worker_thread.lock);
 				// Initialize the pool of transform worker threads
-				ThreadPoolCreate(&decoder->worker_thread.pool,
+				ThreadPoolCreate(decoder->worker_thread.pool,
 								decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 								WorkerThreadProc,
 								decoder);
@@ -17106,14 +17496,16 @@ void ConvertQuarterFrameToBuffer(DECODER *decoder, TRANSFORM **transform_array,
 			decoder->RGBFilterBufferPhase = 1;
 
 
+			ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 			// Set the work count to the number of rows to process
-			ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+			ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 			// Start the transform worker threads
-			ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+			ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 			// Wait for all of the worker threads to finish
-			ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+			ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+			ThreadPoolEndJob(decoder->worker_thread.pool);
 
 			decoder->RGBFilterBufferPhase = 0;
 		}
@@ -17722,6 +18114,26 @@ static inline void ZeroHighPassRow(PIXEL *rowptr, int length)
  #endif
 #endif
 
+// Number of coefficients cleared at a time ahead of the 16-bit band decoders
+#define BAND_ZERO_CHUNK		2048
+
+// Clear the next chunk of the band ahead of the decoder and return the end of the cleared region.
+// Decoding one byte advances at most about a thousand coefficients, so clearing ahead in chunks
+// keeps the cleared region ahead of the decoder while the cache lines are still hot when the
+// decoded values are written, instead of clearing the entire band in a separate pass.
+static inline PIXEL16S *ZeroBandAhead(PIXEL16S *zeroptr, PIXEL16S *bandendptr)
+{
+	size_t count = bandendptr - zeroptr;
+
+	if (count > BAND_ZERO_CHUNK) {
+		count = BAND_ZERO_CHUNK;
+	}
+
+	memset(zeroptr, 0, count * sizeof(PIXEL16S));
+
+	return zeroptr + count;
+}
+
 #if (0 && _DEBUG)
 
 // Functions for the finite state machine decoder (debug version)
@@ -19538,6 +19950,7 @@ bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int wid
 	FSMENTRY *entry;
 	FSMENTRYFAST *entryfast;
 	PIXEL16S *rowptr = image;
+	PIXEL16S *zeroptr = image;
 	PIXEL16S *bandendptr;
 	PIXEL16S *fastendptr;
 	int32_t value;
@@ -19568,8 +19981,8 @@ bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int wid
 
 	pitch /= sizeof(PIXEL16S);
 
-	// Zero out the entire subband
-	ZeroHighPassRow((PIXEL *)rowptr, pitch*height*sizeof(PIXEL16S));
+	// Zero out the subband ahead of the decoder (see below)
+	//ZeroHighPassRow((PIXEL *)rowptr, pitch*height*sizeof(PIXEL16S));
 	//memset(rowptr, 0, pitch*height*sizeof(PIXEL16S));
 
 	// This Huffman decoder assumes each byte is processed as two 4-bit chunks
@@ -19593,6 +20006,11 @@ bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int wid
 	// Decode runs and magnitude values until the entire band is decoded
 	while(rowptr < fastendptr)
 	{
+		// Keep the zeroed part of the subband well ahead of the decoder
+		if (zeroptr < rowptr + BAND_ZERO_CHUNK/2) {
+			zeroptr = ZeroBandAhead(zeroptr, bandendptr);
+		}
+
 		// Read a byte from the bitstream
 		byte = *CurrentWord++;
 
@@ -19641,6 +20059,9 @@ bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int wid
 		rowptr = &rowptr[(entryfast->pre_post_skip >> 12) & 0x7];
 	}
 
+	// Zero the rest of the subband
+	memset(zeroptr, 0, (bandendptr - zeroptr) * sizeof(PIXEL16S));
+
 	offset = CurrentWord - startCurrentWord;
 	stream->lpCurrentWord += offset;
 	stream->nWordsUsed -= (int)offset;
@@ -19811,6 +20232,7 @@ bool DecodeBandFSM16sNoGapWithPeaks(FSM *fsm, BITSTREAM *stream, PIXEL16S *image
 	int index, byte;
 	FSMENTRY *entry;
 	PIXEL16S *rowptr = image;
+	PIXEL16S *zeroptr = image;
 	PIXEL16S *bandendptr;
 	PIXEL16S *fastendptr;
 	int32_t value;
@@ -19831,8 +20253,8 @@ bool DecodeBandFSM16sNoGapWithPeaks(FSM *fsm, BITSTREAM *stream, PIXEL16S *image
 
 	pitch /= sizeof(PIXEL16S);
 
-	// Zero out the entire subband
-	ZeroHighPassRow((PIXEL *)rowptr, pitch*height*sizeof(PIXEL16S));
+	// Zero out the subband ahead of the decoder (see below)
+	//ZeroHighPassRow((PIXEL *)rowptr, pitch*height*sizeof(PIXEL16S));
 
 	// This Huffman decoder assumes each byte is processed as two 4-bit chunks
 	assert(BITSTREAM_WORD_SIZE == 2 * FSM_INDEX_SIZE);
@@ -19855,6 +20277,11 @@ bool DecodeBandFSM16sNoGapWithPeaks(FSM *fsm, BITSTREAM *stream, PIXEL16S *image
 	// Decode runs and magnitude values until the entire band is decoded
 	while(rowptr < fastendptr)
 	{
+		// Keep the zeroed part of the subband well ahead of the decoder
+		if (zeroptr < rowptr + BAND_ZERO_CHUNK/2) {
+			zeroptr = ZeroBandAhead(zeroptr, bandendptr);
+		}
+
 		// Read a byte from the bitstream
 		byte = *CurrentWord++;
 
@@ -19909,6 +20336,9 @@ bool DecodeBandFSM16sNoGapWithPeaks(FSM *fsm, BITSTREAM *stream, PIXEL16S *image
 		rowptr = &rowptr[entry->pre_post_skip >> 12];
 	}
 
+	// Zero the rest of the subband
+	memset(zeroptr, 0, (bandendptr - zeroptr) * sizeof(PIXEL16S));
+
 	stream->lpCurrentWord += ((intptr_t)CurrentWord - (intptr_t)startCurrentWord);
 	stream->nWordsUsed -= (int)(((intptr_t)CurrentWord - (intptr_t)startCurrentWord));
 
@@ -20714,7 +21144,7 @@ bool DecodeFastRunsFSM16s(DECODER *decoder, BITSTREAM *stream, IMAGE *wavelet,
 	peakbase = codec->peak_table.base;
 
 #if _THREADED
-	threading = decoder->entropy_worker_new.pool.thread_count > 1 ? threading : 0;
+	threading = decoder->entropy_worker_new.pool->thread_count > 1 ? threading : 0;
 
 	if(threading)
 	{
@@ -20740,20 +21170,21 @@ bool DecodeFastRunsFSM16s(DECODER *decoder, BITSTREAM *stream, IMAGE *wavelet,
 			data->band_index = band_index;
 			data->active_codebook = active_codebook;
 			data->difference_coding = difference_coding;
+			data->subband = codec->band.subband;
 
+#if _DELAYED_THREAD_START==0
 			// Start only a particular threadid
 			if(next_queue_num == 0)
 			{
-				ThreadPoolSetWorkCount(&decoder->entropy_worker_new.pool, 1);
-
-#if _DELAYED_THREAD_START==0
-				ThreadPoolSendMessage(&decoder->entropy_worker_new.pool, THREAD_MESSAGE_START);
-#endif
+				ThreadPoolSetWorkCount(decoder->entropy_worker_new.pool, 1);
+				ThreadPoolSendMessage(decoder->entropy_worker_new.pool, THREAD_MESSAGE_START);
 			}
 			else
 			{	// Set the work count to the number of rows to process
-				ThreadPoolAddWorkCount(&decoder->entropy_worker_new.pool, 1);
+				ThreadPoolAddWorkCount(decoder->entropy_worker_new.pool, 1);
 			}
+#endif
+			// The work count is set when the threads are started (see WaitForTransformThread)
 
 			{
 				unsigned short tag = *(stream->lpCurrentWord-8) << 8;
@@ -20804,6 +21235,8 @@ continuesearch:
 	else
 #endif // _THREADED
 	{
+		uint64_t telemetry_start = TELEMETRY_START(decoder->telemetry);
+
 		DeQuantFSM(fsm, quant);
 
 		if (peaklevel && peakbase)
@@ -20834,6 +21267,7 @@ continuesearch:
 			}
 		}
 
+		TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_ENTROPY, codec->band.subband, telemetry_start);
 
 		if (result)
 		{
@@ -24084,7 +24518,7 @@ void UpdateWaveletBandValidFlags(DECODER *decoder, IMAGE *wavelet, int band)
 
 #if _THREADED_DECODER
 		// Lock access to the wavelet data
-		if(decoder->entropy_worker_new.pool.thread_count)
+		if(decoder->entropy_worker_new.pool->thread_count)
 			Lock(&decoder->entropy_worker_new.lock);
 #endif
 
@@ -24101,7 +24535,7 @@ void UpdateWaveletBandValidFlags(DECODER *decoder, IMAGE *wavelet, int band)
 #if _THREADED_DECODER
 
 		// Unlock access to the wavelet data
-		if(decoder->entropy_worker_new.pool.thread_count)
+		if(decoder->entropy_worker_new.pool->thread_count)
 			Unlock(&decoder->entropy_worker_new.lock);
 
 #endif
@@ -24120,14 +24554,14 @@ void UpdateWaveletBandStartedFlags(DECODER *decoder, IMAGE *wavelet, int band)
 	{
 		// Update the wavelet band flags
 #if _DELAYED_THREAD_START==0
-		if(decoder->entropy_worker_new.pool.thread_count)
+		if(decoder->entropy_worker_new.pool->thread_count)
 			Lock(&decoder->entropy_worker_new.lock);
 #endif
 
 		wavelet->band_started_flags |= BAND_VALID_MASK(band);
 
 #if _DELAYED_THREAD_START==0
-		if(decoder->entropy_worker_new.pool.thread_count)
+		if(decoder->entropy_worker_new.pool->thread_count)
 			Unlock(&decoder->entropy_worker_new.lock);
 #endif
 	}
@@ -24282,14 +24716,23 @@ void QueueThreadedTransform(DECODER *decoder, int channel, int index)
 #if _THREADED_DECODER
 void WaitForTransformThread(DECODER *decoder)
 {
-	if(decoder->entropy_worker_new.pool.thread_count)
+	if(decoder->entropy_worker_new.pool->thread_count)
 	{
 #if _DELAYED_THREAD_START
-		ThreadPoolSendMessage(&decoder->entropy_worker_new.pool, THREAD_MESSAGE_START);
+		// The pool may be shared with the decoder for the other eye so the bands are queued
+		// in this decoder and the pool is given the work when the threads are started
+		ThreadPoolBeginJob(decoder->entropy_worker_new.pool, decoder);
+		ThreadPoolSetWorkCount(decoder->entropy_worker_new.pool, decoder->entropy_worker_new.next_queue_num);
+		ThreadPoolSendMessage(decoder->entropy_worker_new.pool, THREAD_MESSAGE_START);
+		ThreadPoolWaitAllDone(decoder->entropy_worker_new.pool);
+		ThreadPoolEndJob(decoder->entropy_worker_new.pool);
+
+		// All of the queued bands have been decoded
+		decoder->entropy_worker_new.next_queue_num = 0;
+#else
+		ThreadPoolWaitAllDone(decoder->entropy_worker_new.pool);
 #endif
 	
-		ThreadPoolWaitAllDone(&decoder->entropy_worker_new.pool);
-	
 		decoder->transform_queue.started = 0;
 		decoder->transform_queue.num_entries = 0;
 		decoder->transform_queue.next_entry = 0;
@@ -24710,13 +25153,14 @@ CODEC_ERROR UncompressedSampleFrameBayerToBuffer(DECODER *decoder, FRAME_INFO *i
 		int inverted = false;
 		uint8_t *output = output_buffer;
 		int pitch = output_pitch;
+		uint64_t telemetry_start;
 
 	#if _DELAY_THREAD_START
-		if(decoder->worker_thread.pool.thread_count == 0)
+		if(decoder->worker_thread.pool->thread_count == 0)
 		{
 			CreateLock(&decoder->worker_thread.lock);
 			// Initialize the pool of transform worker threads
-			ThreadPoolCreate(&decoder->worker_thread.pool,
+			ThreadPoolCreate(decoder->worker_thread.pool,
 							decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 							WorkerThreadProc,
 							decoder);
@@ -24748,14 +25192,20 @@ CODEC_ERROR UncompressedSampleFrameBayerToBuffer(DECODER *decoder, FRAME_INFO *i
 		memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
 		mailbox->jobType = JOB_TYPE_OUTPUT;
 
+		telemetry_start = TELEMETRY_START(decoder->telemetry);
+
+		ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 		// Set the work count to the number of rows to process
-		ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+		ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 		// Start the transform worker threads
-		ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+		ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 		// Wait for all of the worker threads to finish
-		ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+		ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+		ThreadPoolEndJob(decoder->worker_thread.pool);
+
+		TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_DEMOSAIC, -1, telemetry_start);
 	}
 
 #else
@@ -24996,11 +25446,11 @@ CODEC_ERROR UncompressedSampleFrameYUVToBuffer(DECODER *decoder, FRAME_INFO *inf
 			WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 		#if _DELAY_THREAD_START
-			if(decoder->worker_thread.pool.thread_count == 0)
+			if(decoder->worker_thread.pool->thread_count == 0)
 			{
 				CreateLock(&decoder->worker_thread.lock);
 				// Initialize the pool of transform worker threads
-				ThreadPoolCreate(&decoder->worker_thread.pool,
+				ThreadPoolCreate(decoder->worker_thread.pool,
 								decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 								WorkerThreadProc,
 								decoder);
@@ -25013,14 +25463,16 @@ CODEC_ERROR UncompressedSampleFrameYUVToBuffer(DECODER *decoder, FRAME_INFO *inf
 			memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
 			mailbox->jobType = JOB_TYPE_OUTPUT_UNCOMPRESSED;
 
+			ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 			// Set the work count to the number of rows to process
-			ThreadPoolSetWorkCount(&decoder->worker_thread.pool, height);
+			ThreadPoolSetWorkCount(decoder->worker_thread.pool, height);
 
 			// Start the transform worker threads
-			ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+			ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 			// Wait for all of the worker threads to finish
-			ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+			ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+			ThreadPoolEndJob(decoder->worker_thread.pool);
 		}
 #else
 
@@ -25258,11 +25710,11 @@ CODEC_ERROR UncompressedSampleFrameRGBToBuffer(DECODER *decoder, FRAME_INFO *inf
 			WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 		#if _DELAY_THREAD_START
-			if(decoder->worker_thread.pool.thread_count == 0)
+			if(decoder->worker_thread.pool->thread_count == 0)
 			{
 				CreateLock(&decoder->worker_thread.lock);
 				// Initialize the pool of transform worker threads
-				ThreadPoolCreate(&decoder->worker_thread.pool,
+				ThreadPoolCreate(decoder->worker_thread.pool,
 								decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 								WorkerThreadProc,
 								decoder);
@@ -25275,14 +25727,16 @@ CODEC_ERROR UncompressedSampleFrameRGBToBuffer(DECODER *decoder, FRAME_INFO *inf
 			memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
 			mailbox->jobType = JOB_TYPE_OUTPUT_UNCOMPRESSED;
 
+			ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 			// Set the work count to the number of rows to process
-			ThreadPoolSetWorkCount(&decoder->worker_thread.pool, height);
+			ThreadPoolSetWorkCount(decoder->worker_thread.pool, height);
 
 			// Start the transform worker threads
-			ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+			ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 			// Wait for all of the worker threads to finish
-			ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+			ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+			ThreadPoolEndJob(decoder->worker_thread.pool);
 		}
 #else
 
@@ -25866,13 +26320,14 @@ CODEC_ERROR ReconstructSampleFrameDeBayerFullToBuffer(DECODER *decoder, FRAME_IN
 		int inverted = false;
 		uint8_t *output = output_buffer;
 		int pitch = output_pitch;
+		uint64_t telemetry_start;
 
 	#if _DELAY_THREAD_START
-		if(decoder->worker_thread.pool.thread_count == 0)
+		if(decoder->worker_thread.pool->thread_count == 0)
 		{
 			CreateLock(&decoder->worker_thread.lock);
 			// Initialize the pool of transform worker threads
-			ThreadPoolCreate(&decoder->worker_thread.pool,
+			ThreadPoolCreate(decoder->worker_thread.pool,
 							decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 							WorkerThreadProc,
 							decoder);
@@ -25904,14 +26359,20 @@ CODEC_ERROR ReconstructSampleFrameDeBayerFullToBuffer(DECODER *decoder, FRAME_IN
 		memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
 		mailbox->jobType = JOB_TYPE_OUTPUT;
 
+		telemetry_start = TELEMETRY_START(decoder->telemetry);
+
+		ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 		// Set the work count to the number of rows to process
-		ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+		ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 		// Start the transform worker threads
-		ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+		ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 		// Wait for all of the worker threads to finish
-		ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+		ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+		ThreadPoolEndJob(decoder->worker_thread.pool);
+
+		TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_DEMOSAIC, -1, telemetry_start);
 	}
 
 #else
@@ -26109,11 +26570,11 @@ CODEC_ERROR ReconstructSampleFrameYUV422ToBuffer(DECODER *decoder, int frame, ui
 			WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 	#if _DELAY_THREAD_START
-			if(decoder->worker_thread.pool.thread_count == 0)
+			if(decoder->worker_thread.pool->thread_count == 0)
 			{
 				CreateLock(&decoder->worker_thread.lock);
 				// Initialize the pool of transform worker threads
-				ThreadPoolCreate(&decoder->worker_thread.pool,
+				ThreadPoolCreate(decoder->worker_thread.pool,
 								decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 								WorkerThreadProc,
 								decoder);
@@ -26127,14 +26588,16 @@ CODEC_ERROR ReconstructSampleFrameYUV422ToBuffer(DECODER *decoder, int frame, ui
 			mailbox->jobType = JOB_TYPE_OUTPUT;
 			decoder->RGBFilterBufferPhase = 1;
 
+			ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 			// Set the work count to the number of rows to process
-			ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+			ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 			// Start the transform worker threads
-			ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+			ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 			// Wait for all of the worker threads to finish
-			ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+			ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+			ThreadPoolEndJob(decoder->worker_thread.pool);
 
 			decoder->RGBFilterBufferPhase = 0;
 			return CODEC_ERROR_OKAY;
@@ -26466,11 +26929,11 @@ CODEC_ERROR ReconstructSampleFrameYUV422ToBuffer(DECODER *decoder, int frame, ui
 						WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 	#if _DELAY_THREAD_START
-						if(decoder->worker_thread.pool.thread_count == 0)
+						if(decoder->worker_thread.pool->thread_count == 0)
 						{
 							CreateLock(&decoder->worker_thread.lock);
 							// Initialize the pool of transform worker threads
-							ThreadPoolCreate(&decoder->worker_thread.pool,
+							ThreadPoolCreate(decoder->worker_thread.pool,
 											decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 											WorkerThreadProc,
 											decoder);
@@ -26483,14 +26946,16 @@ CODEC_ERROR ReconstructSampleFrameYUV422ToBuffer(DECODER *decoder, int frame, ui
 						mailbox->jobType = JOB_TYPE_OUTPUT;
 						decoder->RGBFilterBufferPhase = 2; // yuv
 
+						ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 						// Set the work count to the number of rows to process
-						ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+						ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 						// Start the transform worker threads
-						ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+						ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 						// Wait for all of the worker threads to finish
-						ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+						ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+						ThreadPoolEndJob(decoder->worker_thread.pool);
 
 						decoder->RGBFilterBufferPhase = 0;
 					}
@@ -26711,11 +27176,11 @@ CODEC_ERROR ReconstructSampleFrameRGB444ToBuffer(DECODER *decoder, int frame, ui
 				WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 	#if _DELAY_THREAD_START
-				if(decoder->worker_thread.pool.thread_count == 0)
+				if(decoder->worker_thread.pool->thread_count == 0)
 				{
 					CreateLock(&decoder->worker_thread.lock);
 					// Initialize the pool of transform worker threads
-					ThreadPoolCreate(&decoder->worker_thread.pool,
+					ThreadPoolCreate(decoder->worker_thread.pool,
 									decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 									WorkerThreadProc,
 									decoder);
@@ -26729,14 +27194,16 @@ CODEC_ERROR ReconstructSampleFrameRGB444ToBuffer(DECODER *decoder, int frame, ui
 				mailbox->jobType = JOB_TYPE_OUTPUT;
 				decoder->RGBFilterBufferPhase = 1;
 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of rows to process
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 				// Start the transform worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 
 				decoder->RGBFilterBufferPhase = 0;
 			}
@@ -26819,11 +27286,11 @@ CODEC_ERROR ReconstructSampleFrameRGB444ToBuffer(DECODER *decoder, int frame, ui
 				WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
 
 	#if _DELAY_THREAD_START
-				if(decoder->worker_thread.pool.thread_count == 0)
+				if(decoder->worker_thread.pool->thread_count == 0)
 				{
 					CreateLock(&decoder->worker_thread.lock);
 					// Initialize the pool of transform worker threads
-					ThreadPoolCreate(&decoder->worker_thread.pool,
+					ThreadPoolCreate(decoder->worker_thread.pool,
 									decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 									WorkerThreadProc,
 									decoder);
@@ -26836,14 +27303,16 @@ CODEC_ERROR ReconstructSampleFrameRGB444ToBuffer(DECODER *decoder, int frame, ui
 				mailbox->jobType = JOB_TYPE_OUTPUT;
 				decoder->RGBFilterBufferPhase = 1;
 
+				ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 				// Set the work count to the number of rows to process
-				ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+				ThreadPoolSetWorkCount(decoder->worker_thread.pool, info->height);
 
 				// Start the transform worker threads
-				ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+				ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 				// Wait for all of the worker threads to finish
-				ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+				ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+				ThreadPoolEndJob(decoder->worker_thread.pool);
 
 				decoder->RGBFilterBufferPhase = 0;
 			}
@@ -27158,11 +27627,11 @@ void TransformInverseSpatialThreadedYUV422ToBuffer(DECODER *decoder, int frame_i
 	HorizontalInverseFilterOutputProc horizontal_filter_proc;
 
 #if _DELAY_THREAD_START
-	if(decoder->worker_thread.pool.thread_count == 0)
+	if(decoder->worker_thread.pool->thread_count == 0)
 	{
 		CreateLock(&decoder->worker_thread.lock);
 		// Initialize the pool of transform worker threads
-		ThreadPoolCreate(&decoder->worker_thread.pool,
+		ThreadPoolCreate(decoder->worker_thread.pool,
 						decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 						WorkerThreadProc,
 						decoder);
@@ -27191,14 +27660,16 @@ void TransformInverseSpatialThreadedYUV422ToBuffer(DECODER *decoder, int frame_i
 	mailbox->precision = precision;
 	mailbox->jobType = JOB_TYPE_WAVELET;
 
+	ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 	// Set the work count to the number of rows to process
-	ThreadPoolSetWorkCount(&decoder->worker_thread.pool, middle_row_count);
+	ThreadPoolSetWorkCount(decoder->worker_thread.pool, middle_row_count);
 
 	// Start the transform worker threads
-	ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+	ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 	// Wait for all of the worker threads to finish
-	ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+	ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+	ThreadPoolEndJob(decoder->worker_thread.pool);
 
 #if (1 && DEBUG)
 	if (logfile) {
@@ -27230,11 +27701,11 @@ void TransformInverseSpatialUniversalThreadedToRow16u(DECODER *decoder, int fram
 	HorizontalInverseFilterOutputProc horizontal_filter_proc;
 	horizontal_filter_proc = InvertHorizontalStrip16sToRow16uPlanar;
 #if _DELAY_THREAD_START
-	if(decoder->worker_thread.pool.thread_count == 0)
+	if(decoder->worker_thread.pool->thread_count == 0)
 	{
 		CreateLock(&decoder->worker_thread.lock);
 		// Initialize the pool of transform worker threads
-		ThreadPoolCreate(&decoder->worker_thread.pool,
+		ThreadPoolCreate(decoder->worker_thread.pool,
 						decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 						WorkerThreadProc,
 						decoder);
@@ -27252,14 +27723,16 @@ void TransformInverseSpatialUniversalThreadedToRow16u(DECODER *decoder, int fram
 	mailbox->precision = precision;
 	mailbox->jobType = JOB_TYPE_WAVELET;
 
+	ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 	// Set the work count to the number of rows to process
-	ThreadPoolSetWorkCount(&decoder->worker_thread.pool, middle_row_count);
+	ThreadPoolSetWorkCount(decoder->worker_thread.pool, middle_row_count);
 
 	// Start the transform worker threads
-	ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+	ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 	// Wait for all of the worker threads to finish
-	ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+	ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+	ThreadPoolEndJob(decoder->worker_thread.pool);
 }
 
 
@@ -27286,11 +27759,11 @@ void TransformInverseSpatialUniversalThreadedToOutput(
 
 	// Inverse horizontal filter that outputs the desired format
 #if _DELAY_THREAD_START
-	if(decoder->worker_thread.pool.thread_count == 0)
+	if(decoder->worker_thread.pool->thread_count == 0)
 	{
 		CreateLock(&decoder->worker_thread.lock);
 		// Initialize the pool of transform worker threads
-		ThreadPoolCreate(&decoder->worker_thread.pool,
+		ThreadPoolCreate(decoder->worker_thread.pool,
 						decoder->thread_cntrl.capabilities >> 16/*cpus*/,
 						WorkerThreadProc,
 						decoder);
@@ -27308,14 +27781,16 @@ void TransformInverseSpatialUniversalThreadedToOutput(
 	mailbox->precision = precision;
 	mailbox->jobType = JOB_TYPE_WAVELET;
 
+	ThreadPoolBeginJob(decoder->worker_thread.pool, decoder);
 	// Set the work count to the number of rows to process
-	ThreadPoolSetWorkCount(&decoder->worker_thread.pool, middle_row_count);
+	ThreadPoolSetWorkCount(decoder->worker_thread.pool, middle_row_count);
 
 	// Start the transform worker threads
-	ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+	ThreadPoolSendMessage(decoder->worker_thread.pool, THREAD_MESSAGE_START);
 
 	// Wait for all of the worker threads to finish
-	ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+	ThreadPoolWaitAllDone(decoder->worker_thread.pool);
+	ThreadPoolEndJob(decoder->worker_thread.pool);
 }
 
 // Routines for the worker threads that use the new threads API
@@ -27386,7 +27861,7 @@ void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_index,
 
 
 	// Divide the buffer space between the four threads
-	buffer_size /= decoder->worker_thread.pool.thread_count;  // used to assume max of 4
+	buffer_size /= decoder->worker_thread.pool->thread_count;  // used to assume max of 4
 	buffer += buffer_size * thread_index;
 
 	// Round the buffer pointer up to the next cache line
@@ -27497,7 +27972,7 @@ void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_index,
 									   horizontal_filter_proc);
 	}
 
-	if (thread_index == TRANSFORM_WORKER_BOTTOM_THREAD || decoder->worker_thread.pool.thread_count == 1)
+	if (thread_index == TRANSFORM_WORKER_BOTTOM_THREAD || decoder->worker_thread.pool->thread_count == 1)
 	{
 		if(last_row == last_display_row) //DAN20071218 -- Added as old 1080 RAW files would crash
 		{
@@ -27542,7 +28017,7 @@ void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_index,
 		int row;
 
 		// Wait for one row from each channel to process
-		error = PoolThreadWaitForWork(&decoder->worker_thread.pool, &work_index, thread_index);
+		error = PoolThreadWaitForWork(decoder->worker_thread.pool, &work_index, thread_index);
 
 		// Is there another row to process?
 		if (error == THREAD_ERROR_OKAY)
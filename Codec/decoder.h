@@ -229,6 +229,10 @@ unsigned char *GetTupletAddr(unsigned char *data, int datasize,
 			   unsigned short findtag, unsigned short *retvalue);
 #endif
 
+// Find one channel (eye) in a sample that contains more than one video channel
+int FindVideoChannel(uint8_t *sample, size_t sample_size, int channel,
+					 size_t *channel_offset_out, size_t *channel_size_out);
+
 void InitDecoder(DECODER *decoder, FILE *logfile, CODESET *cs);
 void ClearDecoder(DECODER *decoder);
 
@@ -255,6 +259,9 @@ bool DecodeSampleFrame(DECODER *decoder, BITSTREAM *input, uint8_t *output, int
 // Decode a sample that represents an isolated frame
 bool DecodeSampleIntraFrame(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch, ColorParam *colorparams);
 
+// Output the last decoded frame at a lower resolution from the lowpass bands of the wavelets
+bool ReconstructLowpassFrameToBuffer(DECODER *decoder, int resolution, uint8_t *output, int pitch);
+
 bool ParseSampleHeader(BITSTREAM *sample, SAMPLE_HEADER *header);
 bool DumpSampleHeader(BITSTREAM *input, FILE *logfile);
 
@@ -292,6 +299,10 @@ bool SetDecoderColorFlags(DECODER *decoder, uint32_t color_flags);
 void SetDecoderFlags(DECODER *decoder, uint32_t flags);
 bool ResizeDecoderBuffer(DECODER *decoder, int width, int height, int format);
 
+// Estimate the memory allocated by a decoder for the specified encoded and decoded frames
+size_t DecoderMemorySize(int width, int height, int encoded_format, int decoded_format,
+						 int resolution, bool group, int cpus);
+
 IMAGE *DecodeNextFrame(DECODER *decoder, BITSTREAM *input);
 #ifdef _WIN32
 bool DecodeFile(DECODER *decoder, HANDLE file);
@@ -350,6 +361,13 @@ bool DecodeSampleChannelHeader(DECODER *decoder, BITSTREAM *input);
 
 void DeQuantFSM(FSM *fsm, int quant);
 
+// Decode a band of highpass coefficients that has no gap between rows
+#if _DEBUG
+bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int width, int height, int pitch, FILE *logfile);
+#else
+bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int width, int height, int pitch);
+#endif
+
 // Routines that combine inverse wavelet transforms with color conversion
 
 // Apply the inverse horizontal-temporal transform to reconstruct the output frame
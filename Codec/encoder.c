@@ -56,6 +56,7 @@
 #include "metadata.h"
 #include "thumbnail.h"
 #include "lutpath.h"
+#include "dbcache.h"
 #include "bandfile.h"
 
 #if _RECURSIVE
@@ -178,6 +179,9 @@ void SetEncoderAffinityMask(ENCODER *encoder);
 /* Table of CRCs of all 8-bit messages. */
 uint32_t crc_tableA[256];
 
+/* Tables for the CRC of a byte followed by 1 to 7 zero bytes (slicing by eight). */
+static uint32_t crc_slicesA[7][256];
+
 /* Flag: has the table been computed? Initially false. */
 int crc_table_computedA = 0;
 
@@ -197,6 +201,13 @@ void make_crc_tableA(void)
 		}
 		crc_tableA[n] = c;
 	}
+	for (n = 0; n < 256; n++) {
+		c = crc_tableA[n];
+		for (k = 0; k < 7; k++) {
+			c = crc_tableA[c & 0xff] ^ (c >> 8);
+			crc_slicesA[k][n] = c;
+		}
+	}
 	crc_table_computedA = 1;
 }
 
@@ -213,7 +224,20 @@ uint32_t update_crcA(uint32_t crc, unsigned char *buf,
 
 	if (!crc_table_computedA)
 		make_crc_tableA();
-	for (n = 0; n < len; n++) {
+
+	/* Process eight bytes per iteration using the sliced tables */
+	for (n = 0; n + 8 <= len; n += 8) {
+		uint32_t one = c ^ ((uint32_t)buf[n] | ((uint32_t)buf[n+1] << 8) |
+							((uint32_t)buf[n+2] << 16) | ((uint32_t)buf[n+3] << 24));
+		uint32_t two = (uint32_t)buf[n+4] | ((uint32_t)buf[n+5] << 8) |
+					   ((uint32_t)buf[n+6] << 16) | ((uint32_t)buf[n+7] << 24);
+
+		c = crc_slicesA[6][one & 0xff] ^ crc_slicesA[5][(one >> 8) & 0xff] ^
+			crc_slicesA[4][(one >> 16) & 0xff] ^ crc_slicesA[3][one >> 24] ^
+			crc_slicesA[2][two & 0xff] ^ crc_slicesA[1][(two >> 8) & 0xff] ^
+			crc_slicesA[0][(two >> 16) & 0xff] ^ crc_tableA[two >> 24];
+	}
+	for (; n < len; n++) {
 		c = crc_tableA[(c ^ buf[n]) & 0xff] ^ (c >> 8);
 	}
 	return c;
@@ -430,19 +454,66 @@ void FreeMetadata(METADATA *metadata)
 	}
 }
 
+/*!
+	@brief Enlarge the metadata block so that it can hold the specified number of bytes
+
+	The limit member variable is the allocated size of the block and the
+	size member variable is the actual size of the metadata.  The block is
+	enlarged to a power of two so that the metadata that is updated on every
+	frame does not call the memory allocator once the block is large enough.
+	The metadata already in the block is preserved.
+*/
+bool ReserveMetadata(METADATA *metadata, size_t size)
+{
+	size_t limit = 256;
+	uint32_t *block;
+
+	if (metadata == NULL)
+		return false;
+
+	if (metadata->block && metadata->limit >= size)
+		return true;
+
+	while (limit < size)
+		limit <<= 1;
+
+#if _ALLOCATOR
+	block = (uint32_t *)Alloc(metadata->allocator, limit);
+#else
+	block = (uint32_t *)MEMORY_ALLOC(limit);
+#endif
+	if (block == NULL)
+		return false;
+
+	if (metadata->block)
+	{
+		memcpy(block, metadata->block, metadata->size);
+#if _ALLOCATOR
+		Free(metadata->allocator, metadata->block);
+#else
+		MEMORY_FREE(metadata->block);
+#endif
+	}
+	else
+	{
+		metadata->size = 0;
+	}
+
+	metadata->block = block;
+	metadata->limit = limit;
+
+	return true;
+}
+
 #define TAGSIZE(x) ((((((x)&0xffffff))+3)>>2)<<2)
 
 /*!
 	@brief Add the specified item of metadata to the metadata structure.
 	
 	The memory block used for metadata in the metadata structure is enlarged
-	if necessary.
-
-	@todo Start using the metadata limit member variable for the size of the
-	allocated block and use the size member variable for the actual size of
-	the metadata.  This change would allow the metadata block to be allocated
-	larger than necessary to hold the metadata.  Memory fragmentation would be
-	reduced by allocating blocks in sizes that are a power of two.
+	if necessary.  The block is allocated larger than necessary to hold the
+	metadata (see @ref ReserveMetadata) so that most additions do not call
+	the memory allocator.
 */
 bool AddMetadata(METADATA *metadata,
 				 uint32_t tag,
@@ -458,17 +529,9 @@ bool AddMetadata(METADATA *metadata,
 
 	//! Maximum allocated size of the metadata block
 	const size_t maximum_size = 65500*4;
-	
-#if _ALLOCATOR
-	ALLOCATOR *allocator = NULL;
-#endif
 
 	if(metadata == NULL) 
 		return false;
-	
-#if _ALLOCATOR
-	allocator = metadata->allocator;
-#endif
 
 	//TODO: Replace use of these variables with references to the metadata structure
 	//extended = &metadata->block;
@@ -551,44 +614,9 @@ bool AddMetadata(METADATA *metadata,
 
 		if (!found)
 		{
-			// Need to allocate the metadata block?
-			//if(*extended == NULL)
-			if (metadata->block == NULL)
-			{
-#if _ALLOCATOR
-				//*extended = (uint32_t  *)Alloc(allocator, allocsize);
-				metadata->block = (uint32_t  *)Alloc(allocator, allocsize);
-#else
-				//*extended = (uint32_t  *)MEMORY_ALLOC(allocsize);
-				metadata->block = (uint32_t  *)MEMORY_ALLOC(allocsize);
-#endif
-			}
-			else
-			{
-#if 0
-				uint32_t *last = *extended;
-#if _ALLOCATOR
-				*extended = (uint32_t  *)Alloc(allocator, *extended_size + allocsize);
-				memcpy(*extended, last, *extended_size);
-				Free(allocator, last);
-#else
-				*extended = (uint32_t  *)MEMORY_ALLOC(*extended_size + allocsize);
-				memcpy(*extended, last, *extended_size);
-				MEMORY_FREE(last);
-#endif
-#else
-				uint32_t *old_block = metadata->block;
-#if _ALLOCATOR
-				metadata->block = (uint32_t *)Alloc(allocator, new_block_size);
-				memcpy(metadata->block, old_block, metadata->size);
-				Free(allocator, old_block);
-#else
-				metadata->block = (uint32_t *)MEMORY_ALLOC(new_block_size);
-				memcpy(metadata->block, old_block, metadata->size);
-				MEMORY_FREE(old_block);
-#endif
-#endif
-			}
+			// Allocate or enlarge the metadata block if the new tag does not fit
+			if (!ReserveMetadata(metadata, new_block_size))
+				return false;
 
 			//if(*extended)
 			if (metadata->block)
@@ -689,45 +717,26 @@ void AttachMetadata(ENCODER *encoder, METADATA *dst, METADATA *src)
 {
 	if(dst == NULL || src == NULL) return;
 
-	if(dst->block)
+	if(src->size == 0)
 	{
-		if(src->size == 0)
-		{
-			FreeMetadata(dst);
-		}
-		else if(dst->size >= src->size)
-		{
-			memcpy(dst->block, src->block, src->size);
-			dst->size = src->size;
-		}
-		else
-		{
-#if _ALLOCATOR
-			FreeMetadata(dst);
-			AllocMetadata(encoder->allocator, dst, src->size);
-#else
-			FreeMetadata(dst);
-			AllocMetadata(dst, src->size);
-#endif
-			if(dst->block)
-			{
-				memcpy(dst->block, src->block, src->size);
-				dst->size = src->size;
-			}
-		}
+		// Keep the block for the metadata in later frames
+		dst->size = 0;
+		return;
 	}
-	else
-	{
+
 #if _ALLOCATOR
-		AllocMetadata(encoder->allocator, dst, src->size);
+	if(dst->block == NULL)
+		dst->allocator = encoder->allocator;
 #else
-		AllocMetadata(dst, src->size);
+	(void)encoder;
 #endif
-		if(dst->block)
-		{
-			memcpy(dst->block, src->block, src->size);
-			dst->size = src->size;
-		}
+
+	// The block is reallocated only if the metadata does not fit in the allocated size
+	dst->size = 0;
+	if(ReserveMetadata(dst, src->size))
+	{
+		memcpy(dst->block, src->block, src->size);
+		dst->size = src->size;
 	}
 }
 
@@ -837,6 +846,10 @@ size_t TotalEncodingBufferSize(int width, int height, int pitch, int format,
 	size_t rounded_height = (height + 7) & ~0x07;
 	size_t frame_size = rounded_height * pitch;
 
+	frame_size += 65536; // metadata overhead
+
+	frame_size += pitch * 18; //DAN20140922 some code paths need up to 18 addition scanlines of working space.
+
 	// Compute the size of the encoding buffer
 	size = EncodingBufferSize(width, height, pitch, format, gop_length, progressive);
 
@@ -860,23 +873,8 @@ PIXEL *CreateEncodingBuffer(int width, int height, int pitch, int format,
 							size_t *allocated_size)
 #endif
 {
-	size_t size;
+	size_t size = TotalEncodingBufferSize(width, height, pitch, format, gop_length, progressive);
 	PIXEL *buffer;
-	size_t rounded_height = (height + 7) & ~0x07;
-	size_t frame_size = rounded_height * pitch;
-
-	frame_size += 65536; // metadata overhead
-
-	frame_size += pitch * 18; //DAN20140922 some code paths need up to 18 addition scanlines of working space.
-
-
-	// Compute the size of the encoding buffer
-	size = EncodingBufferSize(width, height, pitch, format, gop_length, progressive);
-
-	// The buffer must be large enough to hold the extended input frame
-	if (size < frame_size) {
-		size = frame_size;
-	}
 
     // Allocate a buffer aligned to the cache line size
 #if _ALLOCATOR
@@ -1358,6 +1356,68 @@ void PrintEncodingParameters(ENCODING_PARAMETERS *parameters)
 
 #endif
 
+// Estimate the memory allocated by the encoder for the codebooks, the wavelet transforms,
+// and the frame that holds the converted input (not including the encoding buffer)
+size_t EncoderMemorySize(int width, int height, int encoded_format, int gop_length)
+{
+	int num_spatial = TRANSFORM_NUM_SPATIAL;
+	int transform_type;
+	int num_channels;
+	int chroma_width;
+	size_t size = 0;
+	int channel;
+
+	if (width <= 0 || height <= 0) {
+		return 0;
+	}
+
+	if (gop_length == 1) {
+		num_spatial--;
+	}
+
+	switch (encoded_format)
+	{
+	case ENCODED_FORMAT_RGB_444:
+		num_channels = 3;
+		chroma_width = width;
+		break;
+
+	case ENCODED_FORMAT_RGBA_4444:
+	case ENCODED_FORMAT_BAYER:
+		num_channels = 4;
+		chroma_width = width;
+		break;
+
+	case ENCODED_FORMAT_YUV_422:
+	default:
+		num_channels = 3;
+		chroma_width = width / 2;
+		break;
+	}
+
+	// Same rounding of the height as in InitializeEncoderWithParameters
+	height = (height + 7) & ~0x07;
+
+#if _FIELDPLUS_TRANSFORM
+	transform_type = (gop_length > 1) ? TRANSFORM_TYPE_FIELDPLUS : TRANSFORM_TYPE_SPATIAL;
+#else
+	transform_type = (gop_length > 1) ? TRANSFORM_TYPE_FIELD : TRANSFORM_TYPE_SPATIAL;
+#endif
+
+	size += CodebooksSize();
+
+	for (channel = 0; channel < num_channels; channel++)
+	{
+		int channel_width = (channel == 0) ? width : chroma_width;
+
+		// Wavelet transform and the channel in the encoder frame
+		size += TransformMemorySize(transform_type, channel_width, height, num_spatial);
+		size += ImageSize(channel_width, height);
+	}
+
+	return size;
+}
+
 #if _ALLOCATOR
 bool InitializeEncoderWithParameters(ALLOCATOR *allocator,
 									 ENCODER *encoder, TRANSFORM *transform[], int num_channels,
@@ -1904,6 +1964,7 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
 	bool result = true;
 	bool first_frame = false;
 	FRAME *frame;
+	uint64_t telemetry_start;
 
 #if DEBUG
 	FILE *logfile = stdout;
@@ -2333,6 +2394,7 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
    {
 	// Convert the packed color to planes of YUV 4:2:2 (one byte per pixel)
 	START(tk_convert);
+	telemetry_start = TELEMETRY_START(encoder->telemetry);
 	switch (origformat)
 	{
 
@@ -2864,6 +2926,7 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
 		return false;
 	}
 	STOP(tk_convert);
+	TELEMETRY_STOP(encoder->telemetry, TELEMETRY_STAGE_INPUT, -1, telemetry_start);
 
 
 	if(encoder->error)
@@ -2946,6 +3009,8 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
 	// Set the number of channels in the encoder quantization table
 	encoder->num_quant_channels = num_transforms;
 
+	telemetry_start = TELEMETRY_START(encoder->telemetry);
+
 	// Which wavelet transform should be used at the lowest level:
 	// frame transform (interlaced) or spatial transform (progressive)
 	if (!encoder->progressive)
@@ -3223,6 +3288,9 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
 #endif
 	}
 
+	// The frame wavelets for every frame in the group are recorded as level zero
+	TELEMETRY_STOP(encoder->telemetry, TELEMETRY_STAGE_TRANSFORM, 0, telemetry_start);
+
 	if(first_frame)
 	{
 		EncodeFirstSample(encoder, transform, num_transforms, frame, output, format);
@@ -4272,6 +4340,7 @@ void EncodeLowPassBand(ENCODER *encoder, BITSTREAM *output, IMAGE *wavelet, int
 	int quantization = 1;
 	int bits_per_pixel = 16;
 	int solid_color, solid = 1;
+	uint64_t telemetry_start;
 
 #if _STATS
 	int current;
@@ -4279,6 +4348,7 @@ void EncodeLowPassBand(ENCODER *encoder, BITSTREAM *output, IMAGE *wavelet, int
 #endif
 
 	//START(tk_lowpass);
+	telemetry_start = TELEMETRY_START(encoder->telemetry);
 
 #if (0 && DEBUG)
 	if (debugfile && debug['L']) {
@@ -4470,6 +4540,8 @@ void EncodeLowPassBand(ENCODER *encoder, BITSTREAM *output, IMAGE *wavelet, int
 	stats_lastbits = (int)output->cntBits;
 #endif
 
+	TELEMETRY_STOP(encoder->telemetry, TELEMETRY_STAGE_ENTROPY, subband, telemetry_start);
+
 	//STOP(tk_lowpass);
 }
 
@@ -5435,27 +5507,25 @@ void EncodeQuantLongRuns(ENCODER *encoder, BITSTREAM *stream, PIXEL *image,
 	for (row = 0; row < height; row++)
 	{
 		int index = 0;			// Start at the beginning of the row
-		//int zeros;
+		int zeros;
 		int indx;
 		int runsbook_length = runsbook->length;
 		//int valuebooklength = valuebook->length;
 		RLC *rlc = (RLC *)((char *)runsbook + sizeof(RLCBOOK));
 		VLE *table = (VLE *)((char *)valuebook + sizeof(VALBOOK));
-#if 1
-		uint32_t  wBuffer;
-		int nBitsFree;
-		//int cntBits;
-		const int nWordsPerLong = sizeof(uint32_t )/sizeof(uint8_t );
+
+		// The pending bits are kept in a 64-bit buffer so that every codeword is inserted
+		// with a single shift, the stream buffer is updated once per row (same state as PutBits)
+		uint64_t wBuffer;
+		int nBitsUsed;
 		uint32_t  *lpCurrentWord = (uint32_t  *)(stream->lpCurrentWord);
-		int nWordsUsed = stream->nWordsUsed;
-		//uint32_t  *lpStartWord = lpCurrentWord;
+		uint32_t  *lpStartWord = lpCurrentWord;
 
-		// Move the current word into a int32_t buffer
+		// Move the current word into the 64-bit buffer
 		wBuffer = stream->wBuffer;
-		// Number of bits remaining in the current word
-		nBitsFree = stream->nBitsFree;
-//		cntBits = stream->cntBits;
-#endif
+		// Number of bits used in the current word
+		nBitsUsed = BITSTREAM_LONG_SIZE - stream->nBitsFree;
+
 #if (0 && DEBUG)
 		stream->logfile = file;
 		stream->putbits_flag = true;
@@ -5468,15 +5538,34 @@ void EncodeQuantLongRuns(ENCODER *encoder, BITSTREAM *stream, PIXEL *image,
 			assert(0 <= index && index < width);
 
 			// Search the rest of the row for a nonzero value
-			for (; index < width; index++) {
-				if (rowptr[index] == 0) count++;
-				else break;
+			if (rowptr[index] == 0)
+			{
+				zeros = FindNonZero(&rowptr[index], width - index);
+				index += zeros;
+				count += zeros;
 			}
 
 			// Need to output a value?
 			if (index < width)
 			{
 				PIXEL value = rowptr[index];
+				uint32_t codeword;
+				int codesize;
+
+				//PutVlcByte(stream, value, valuebook);
+
+				//DAN20050914 -- This fixes large positive numbers (peaks) overflowing as negative non-peak value
+				if(value <= -(VALUE_TABLE_LENGTH>>1))
+					value = -((VALUE_TABLE_LENGTH>>1)-1);
+				else if(value >= (VALUE_TABLE_LENGTH>>1))
+					value = ((VALUE_TABLE_LENGTH>>1)-1);
+
+				// Negative values are indexed from the end of the table (without a branch on the sign)
+				indx = value & (VALUE_TABLE_LENGTH - 1);
+
+				// Use the packed version of the codebook entry
+				codeword = table[indx].entry & VLE_CODEWORD_MASK;
+				codesize = table[indx].entry >> VLE_CODESIZE_SHIFT;
 
 				// Need to output a run of zeros before this value?
 				if (count > 0)
@@ -5490,149 +5579,31 @@ void EncodeQuantLongRuns(ENCODER *encoder, BITSTREAM *stream, PIXEL *image,
 						// Index into the codebook to get a run length code that covers most of the run
 						indx = (count < runsbook_length) ? count : runsbook_length - 1;
 
-						// Output the run length code
-						//void PutBits(BITSTREAM *stream, uint32_t  wBits, int nBits)
-						{
-							int nBits = rlc[indx].size;
-							int wBits = rlc[indx].bits;
+						// Reduce the length of the run by the amount output
+						count -= rlc[indx].count;
 
-							if (nBits <= nBitsFree)
-							{
-								wBuffer <<= nBits;
-								wBuffer |= (wBits & BITMASK(nBits));
-								nBitsFree -= nBits;
-#if (1 && TRACE_PUTBITS)
-								TracePutBits(nBits);
-#endif
-							}
-							else
-							{
-								// Fill the buffer with as many bits as will fit
-								wBuffer <<= nBitsFree;
-								nBits -= nBitsFree;
-#if (0 && DEBUG)
-								// Count the number of bits written to the bitstream
-								stream->cntBits += nBitsFree;
-#endif
-								// Insert as many bits as will fit into the buffer
-								wBuffer |= (wBits >> nBits) & BITMASK(nBitsFree);
+						// Combine the last run length code with the value into a single codeword
+						if (count == 0 && rlc[indx].size + codesize <= BITSTREAM_LONG_SIZE)
+						{
+							codeword |= rlc[indx].bits << codesize;
+							codesize += rlc[indx].size;
+						}
+						else
+						{
+							PUTBITS64(wBuffer, nBitsUsed, lpCurrentWord, rlc[indx].bits, rlc[indx].size);
 #if (1 && TRACE_PUTBITS)
-								TracePutBits(nBitsFree);
+							TracePutBits(rlc[indx].size);
 #endif
-								// Insert all of the bytes in the buffer into the bitstream
-								//PutLong(stream, wBuffer);
-								//void PutLong(BITSTREAM *stream, uint32_t  word)
-								{
-									nWordsUsed += nWordsPerLong;
-
-								//	if (nWordsUsed <= stream->dwBlockLength) {
-										//*(lpCurrentWord++) = _bswap(wBuffer);
-										*(lpCurrentWord++) = SwapInt32NtoB(wBuffer);
-									//	stream->lpCurrentWord = (uint8_t  *)lpCurrentWord;
-									//	stream->nWordsUsed = nWordsUsed;
-								//	}
-								//	else {
-								//		stream->error = BITSTREAM_ERROR_OVERFLOW;
-								//	}
-								}
-
-								wBuffer = wBits & BITMASK(nBits);
-								nBitsFree = BITSTREAM_LONG_SIZE - nBits;
-							}
 						}
-						// Reduce the length of the run by the amount output
-						count -= rlc[indx].count;
 					}
 
 					count = 0;
 				}
 
-				//PutVlcByte(stream, value, valuebook);
-				{
-					uint32_t codeword;
-					uint32_t codesize;
-
-					//DAN20050914 -- This fixes large positive numbers (peaks) overflowing as negative non-peak value
-					if(value < 0)
-					{
-						if(value <= -(VALUE_TABLE_LENGTH>>1))
-							value = -((VALUE_TABLE_LENGTH>>1)-1);
-
-						indx = VALUE_TABLE_LENGTH + value;
-					}
-					else
-					{
-						if(value >= (VALUE_TABLE_LENGTH>>1))
-							value = ((VALUE_TABLE_LENGTH>>1)-1);
-
-						indx = value;
-					}
-
-					/*
-					if(value < 0)
-						indx = VALUE_TABLE_LENGTH + value;
-					else
-						indx = value;
-
-					if (indx < 0) indx = 0;
-					else if (indx >= valuebooklength) indx = valuebooklength - 1;*/
-
-					// Use the packed version of the codebook entry
-					codeword = table[indx].entry & VLE_CODEWORD_MASK;
-					codesize = table[indx].entry >> VLE_CODESIZE_SHIFT;
-					//void PutBits(BITSTREAM *stream, uint32_t  wBits, int nBits)
-					{
-						int nBits = codesize;
-						int wBits = codeword;
-
-						if (nBits <= nBitsFree) {
-							wBuffer <<= nBits;
-							wBuffer |= (wBits & BITMASK(nBits));
-							nBitsFree -= nBits;
-#if (1 && TRACE_PUTBITS)
-							TracePutBits(nBits);
-#endif
-						}
-						else {
-							// Fill the buffer with as many bits as will fit
-							wBuffer <<= nBitsFree;
-							nBits -= nBitsFree;
-#if (0 && DEBUG)
-							// Count the number of bits written to the bitstream
-							stream->cntBits += nBitsFree;
-#endif
-							// Insert as many bits as will fit into the buffer
-							wBuffer |= (wBits >> nBits) & BITMASK(nBitsFree);
+				PUTBITS64(wBuffer, nBitsUsed, lpCurrentWord, codeword, codesize);
 #if (1 && TRACE_PUTBITS)
-							TracePutBits(nBitsFree);
-#endif
-							// Insert all of the bytes in the buffer into the bitstream
-							//PutLong(stream, wBuffer);
-							//void PutLong(BITSTREAM *stream, uint32_t  word)
-							{
-								nWordsUsed += nWordsPerLong;
-
-							//	if (nWordsUsed <= stream->dwBlockLength) {
-									//*(lpCurrentWord++) = _bswap(wBuffer);
-									*(lpCurrentWord++) = SwapInt32NtoB(wBuffer);
-								//	stream->lpCurrentWord = (uint8_t  *)lpCurrentWord;
-								//	stream->nWordsUsed = nWordsUsed;
-							//	}
-							//	else {
-							//		stream->error = BITSTREAM_ERROR_OVERFLOW;
-							//	}
-							}
-
-							wBuffer = wBits & BITMASK(nBits);
-							nBitsFree = BITSTREAM_LONG_SIZE - nBits;
-						}
-
-#if (0 && DEBUG)
-						// Count the number of bits written to the bitstream
-						stream->cntBits += nBits;
+				TracePutBits(codesize);
 #endif
-					}
-				}
 				index++;
 			}
 
@@ -5640,16 +5611,17 @@ void EncodeQuantLongRuns(ENCODER *encoder, BITSTREAM *stream, PIXEL *image,
 			if (index == width) count += gap;
 
 		}
-#if 1
+
+		// The bits above the pending bits are zero after a doubleword has been written
+		if (lpCurrentWord != lpStartWord)
+			wBuffer &= BITMASK(nBitsUsed);
+
 		// Move the current word into a int32_t buffer
-		stream->wBuffer = wBuffer;
+		stream->wBuffer = (uint32_t)wBuffer;
 		// Number of bits remaining in the current word
-		stream->nBitsFree = nBitsFree;
-//		stream->cntBits = cntBits;
+		stream->nBitsFree = BITSTREAM_LONG_SIZE - nBitsUsed;
 		stream->lpCurrentWord = (uint8_t  *)lpCurrentWord;
-		stream->nWordsUsed = nWordsUsed;
-#endif
-
+		stream->nWordsUsed += (int)(lpCurrentWord - lpStartWord) * sizeof(uint32_t);
 		// Advance to the next row
 		rowptr += pitch;
 	}
@@ -6330,6 +6302,7 @@ void EncodeQuantizedBand(ENCODER *encoder, BITSTREAM *stream, IMAGE *wavelet,
 	int codingflags = 0;
 	int peakscounter = 0;
 	int peak_offset_tag = 0;
+	uint64_t telemetry_start = TELEMETRY_START(encoder->telemetry);
 
 #if DEBUG
 	BITCOUNT bitcount = 0;
@@ -6601,6 +6574,8 @@ void EncodeQuantizedBand(ENCODER *encoder, BITSTREAM *stream, IMAGE *wavelet,
 	if (logfile)
 		fprintf(logfile, "Finish encoder subband: %d, stream: 0x%X\n", subband, stream->lpCurrentWord);
 #endif
+
+	TELEMETRY_STOP(encoder->telemetry, TELEMETRY_STAGE_ENTROPY, subband, telemetry_start);
 }
 
 // Encode an empty band. This is called to code the temporal highpass band in the field+ transform.
@@ -6691,6 +6666,7 @@ void EncodeQuantizedBand16s(ENCODER *encoder, BITSTREAM *stream, IMAGE *wavelet,
 	int active_codebook = 0;
 	int peaks_coding = 0;
 	int codingflags = 0;
+	uint64_t telemetry_start = TELEMETRY_START(encoder->telemetry);
 
 	// This routine only implements runlength encoding
 	assert(encoding == BAND_ENCODING_16BIT);
@@ -6824,6 +6800,8 @@ void EncodeQuantizedBand16s(ENCODER *encoder, BITSTREAM *stream, IMAGE *wavelet,
 	if (logfile)
 		fprintf(logfile, "Finish encoder subband: %d, stream: 0x%X\n", subband, stream->lpCurrentWord);
 #endif
+
+	TELEMETRY_STOP(encoder->telemetry, TELEMETRY_STAGE_ENTROPY, subband, telemetry_start);
 }
 
 
@@ -7470,6 +7448,7 @@ void EncodeQuantizedGroup(ENCODER *encoder, TRANSFORM *transform[], int num_tran
 	//uint8_t  *temp;
 
 	uint32_t *channel_size_vector;		// Pointer to vector of channel sizes
+	uint64_t telemetry_start;
 
 	// Count the subbands as they are encoded
 	int subband = 0;
@@ -7495,6 +7474,7 @@ void EncodeQuantizedGroup(ENCODER *encoder, TRANSFORM *transform[], int num_tran
 	//assert(num_transforms == 3);	//DAN06302004
 
 	START(tk_encoding);
+	telemetry_start = TELEMETRY_START(encoder->telemetry);
 
 #if (DEBUG && _WIN32)
 	//OutputDebugString("EncodeQuantizedGroup");
@@ -7621,6 +7601,8 @@ void EncodeQuantizedGroup(ENCODER *encoder, TRANSFORM *transform[], int num_tran
 	PutVideoSampleFlags(output, &encoder->codec);
 #endif
 
+	TELEMETRY_STOP(encoder->telemetry, TELEMETRY_STAGE_HEADER, -1, telemetry_start);
+
 
 	if(encoder->uncompressed)
 	{
@@ -8380,6 +8362,9 @@ void ComputeGroupTransformQuant(ENCODER *encoder, TRANSFORM *transform[], int nu
 		//int precision = encoder->codec.precision;
 		//int prescale = 0;
 
+		// The levels of the spatial transform are recorded in the statistics separately
+		uint64_t telemetry_start = TELEMETRY_START(encoder->telemetry);
+
 		assert(transform[channel]->type == TRANSFORM_TYPE_SPATIAL ||
 			   transform[channel]->type == TRANSFORM_TYPE_FIELD   ||
 			   transform[channel]->type == TRANSFORM_TYPE_FIELDPLUS);
@@ -8403,12 +8388,14 @@ void ComputeGroupTransformQuant(ENCODER *encoder, TRANSFORM *transform[], int nu
 			//FinishFieldTransform(transform[channel], num_frames, num_spatial, prescale);
 			FinishFieldTransform(transform[channel], num_frames, num_spatial);
 #endif
+			TELEMETRY_STOP(encoder->telemetry, TELEMETRY_STAGE_TRANSFORM, -1, telemetry_start);
 			break;
 
 		case TRANSFORM_TYPE_FIELDPLUS:
 			//prescale = (precision == CODEC_PRECISION_DEFAULT) ? 0 : 2;
 			//FinishFieldPlusTransformQuant(encoder, transform[channel], channel, prescale);
 			FinishFieldPlusTransformQuant(encoder, transform[channel], channel);
+			TELEMETRY_STOP(encoder->telemetry, TELEMETRY_STAGE_TRANSFORM, -1, telemetry_start);
 			break;
 
 		default:	// Transform type is not supported
@@ -8738,6 +8725,7 @@ void FinishFrameTransformQuant(ENCODER *encoder, TRANSFORM *transform, int chann
 		IMAGE *wavelet;
 		//int quant[CODEC_MAX_BANDS];
 		//int *pquant;
+		uint64_t telemetry_start = TELEMETRY_START(encoder->telemetry);
 
 		assert(0 < index && index < transform->num_wavelets);
 
@@ -8778,6 +8766,8 @@ void FinishFrameTransformQuant(ENCODER *encoder, TRANSFORM *transform, int chann
 			return;
 		}
 
+		TELEMETRY_STOP(encoder->telemetry, TELEMETRY_STAGE_TRANSFORM, index, telemetry_start);
+
 		level++;
 		wavelet_index++;
 	}
@@ -8846,36 +8836,23 @@ void OverrideEncoderSettings(ENCODER *encoder)
 			len = 0;
 			if(strlen(filenameGUID))
 			{
-				int err = 0;
-				FILE *fp;
+				// Use the process-wide copy of the file that is reread only when the file changes
+				DISK_DATABASE *database = AcquireDiskDatabase(filenameGUID);
 
-#ifdef _WIN32
-				err = fopen_s(&fp, filenameGUID, "rb");
-#else
-				fp = fopen(filenameGUID, "rb");
-#endif
-				if (err == 0 && fp != NULL)
+				if (database != NULL)
 				{
 					ptr = buffer;
-					len = 0;
-					fseek (fp, 0, SEEK_END);
-					len = ftell(fp);
+					len = (int)database->size;
 
 					if(len <= MAX_ENCODE_DATADASE_LENGTH)
 					{
-						fseek (fp, 0, SEEK_SET);
-#ifdef _MSC_VER
-						len = (int)fread_s(buffer, MAX_ENCODE_DATADASE_LENGTH, 1, len, fp);
-#else
-						len = (int)fread(buffer,1,len,fp);
-#endif
+						memcpy(buffer, database->data, len);
 						*size = len;
 					}
 					else
 						*size = 0;
 
-
-					fclose(fp);
+					ReleaseDiskDatabase(database);
 				}
 				else
 					*size = 0;
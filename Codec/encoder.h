@@ -417,6 +417,9 @@ typedef struct encoder {	// Encoder state (derived from codec)
 	unsigned char forceData[MAX_ENCODE_DATADASE_LENGTH];// override user data
 	uint32_t forceDataSize; // override user data
 
+	// Statistics for each stage of encoding (NULL if statistics are not collected)
+	TELEMETRY *telemetry;
+
 #if _DEBUG
 	// Band data file and bitstream used to debug entropy coding of highpass bands
 	BANDFILE encoded_band_file;
@@ -498,6 +501,9 @@ ENCODER *CreateEncoderWithParameters(ALLOCATOR *allocator, TRANSFORM *transform[
 // Fill in defauilt values for encoding parameters that did not exist in older code
 void SetDefaultEncodingParameters(ENCODING_PARAMETERS *parameters);
 
+// Estimate the memory allocated by the encoder (not including the encoding buffer)
+size_t EncoderMemorySize(int width, int height, int encoded_format, int gop_length);
+
 #if _ALLOCATOR
 bool InitializeEncoderWithParameters(ALLOCATOR *allocator,
 									 ENCODER *encoder, TRANSFORM *transform[], int num_channels,
@@ -592,6 +598,11 @@ void OverrideEncoderSettings(ENCODER *encoder);
 int RemoveHiddenMetadata(unsigned char *ptr, int len);
 void UpdateEncoderOverrides(ENCODER *encoder, unsigned char *ptr, int len);
 
+// Compute the CRC-32 of a block of bytes (same polynomial as zip and PNG)
+uint32_t update_crcA(uint32_t crc, unsigned char *buf, int len);
+uint32_t calccrcA(unsigned char *buf, int len);
+uint32_t gencrc(unsigned char *buf, int len);
+
 
 #if _DEBUG
 
@@ -179,6 +179,8 @@ void DecodeEntropy(DECODER *decoder, int work_index, int thread_index, FSM *fsm,
 
 	if(!skip)
 	{
+		uint64_t telemetry_start = TELEMETRY_START(decoder->telemetry);
+
 		if(*initFsm != active_codebook)
 		{
 			*initFsm = active_codebook;
@@ -216,6 +218,8 @@ void DecodeEntropy(DECODER *decoder, int work_index, int thread_index, FSM *fsm,
 				line += pitch/2;
 			}
 		}
+
+		TELEMETRY_STOP(decoder->telemetry, TELEMETRY_STAGE_ENTROPY, data->subband, telemetry_start);
 	}
 
 	if (result)
@@ -292,7 +296,7 @@ void DecodeEntropy(DECODER *decoder, int work_index, int thread_index, FSM *fsm,
 
 						/*	PushScratchBuffer(&local, &decoder->scratch);
 
-							localsize = (local.free_size/decoder->entropy_worker_new.pool.thread_count) & ~15;
+							localsize = (local.free_size/decoder->entropy_worker_new.pool->thread_count) & ~15;
 
 							local.base_ptr += localsize*thread_index;
 							local.free_ptr += localsize*thread_index;
@@ -313,6 +317,7 @@ void DecodeEntropy(DECODER *decoder, int work_index, int thread_index, FSM *fsm,
 THREAD_PROC(EntropyWorkerThreadProc, lpParam)
 {
 	DECODER *decoder = (DECODER *)lpParam;
+	THREAD_POOL *pool = decoder->entropy_worker_new.pool;
 #if (1 && DEBUG)
 	FILE *logfile = decoder->logfile;
 #endif
@@ -337,24 +342,34 @@ THREAD_PROC(EntropyWorkerThreadProc, lpParam)
 	SetDefaultExceptionHandler();
 
 	// Determine the index of this worker thread
-	error = PoolThreadGetIndex(&decoder->entropy_worker_new.pool, &thread_index);
+	error = PoolThreadGetIndex(pool, &thread_index);
 	assert(error == THREAD_ERROR_OKAY);
 
 	for (;;)
 	{
 		THREAD_MESSAGE message = THREAD_MESSAGE_NONE;
-        error = PoolThreadWaitForMessage(&decoder->entropy_worker_new.pool, thread_index, &message);
+        error = PoolThreadWaitForMessage(pool, thread_index, &message);
 
 		// Received a signal to begin?
 		if(error == THREAD_ERROR_OKAY &&
 			(message == THREAD_MESSAGE_START || message == THREAD_MESSAGE_MORE_WORK))
 		{
+			void *job_param = NULL;
+
+			// Decode the bands queued by the decoder that submitted the job (the pool is shared by the decoders for both eyes)
+			PoolThreadGetJobParam(pool, &job_param);
+			if (job_param != decoder)
+			{
+				// Each decoder has its own finite state machines
+				decoder = (DECODER *)job_param;
+				initFsm = -1;
+			}
 
 			for(;;)
 			{
 				int work_index = -1;
 
-				error = PoolThreadWaitForWork(&decoder->entropy_worker_new.pool, &work_index, thread_index);
+				error = PoolThreadWaitForWork(pool, &work_index, thread_index);
 
 				// Is there another band to process?
 				if (error == THREAD_ERROR_OKAY)
@@ -363,7 +378,7 @@ THREAD_PROC(EntropyWorkerThreadProc, lpParam)
 				}
 				else if(error == THREAD_ERROR_NOWORK)
 				{
-					PoolThreadSignalDone(&decoder->entropy_worker_new.pool, thread_index);
+					PoolThreadSignalDone(pool, thread_index);
 					break;
 				}
 			}
@@ -218,6 +218,20 @@ void AllocImage(IMAGE *image, int width, int height)
 	image->pixel_type[0] = PIXEL_TYPE_16S;
 }
 
+// Return the number of bytes allocated by AllocImage for an image with the specified dimensions
+size_t ImageSize(int width, int height)
+{
+	IMAGE image;
+
+	if (width <= 0 || height <= 0) {
+		return 0;
+	}
+
+	set_image_dimensions(&image, width, height);
+
+	return (size_t)height * image.pitch;
+}
+
 // Create a new image
 #if _ALLOCATOR
 IMAGE *CreateImage(ALLOCATOR *allocator, int width, int height)
@@ -1391,14 +1405,12 @@ int FindNonZero(PIXEL *rowptr, int length)
 	PIXEL *pixptr = rowptr;
 	int index = 0;
 
-#if (0 && XMMOPT)
+#if XMMOPT
 
-	int stepsize = 8;
+	int stepsize = 16;
 
 	if (length >= stepsize)
 	{
-		__m64 *quad_ptr = (__m64 *)pixptr;
-
 		// Table that maps zero mask to position of first nonzero value
 		static const unsigned char nonzero_index[] = {
 			0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,
@@ -1419,46 +1431,40 @@ int FindNonZero(PIXEL *rowptr, int length)
 			0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 8
 		};
 
-		// Use MMX instructions to check eight coefficients at once
+		// Use SSE2 instructions to check sixteen coefficients at once
 		while ((length - index) >= stepsize)
 		{
-			__m64 quad1_pi16;
-			__m64 quad2_pi16;
-			__m64 run_pu8;
-			__m64 mask_pu8;
+			__m128i group1_epi16;
+			__m128i group2_epi16;
+			__m128i run_epi8;
 			int mask;
 			int count;
 
-			// Read eight pixels
-			quad1_pi16 = *(quad_ptr++);
-			quad2_pi16 = *(quad_ptr++);
-
-			// Pack the pixels into bytes
-			run_pu8 = _mm_packs_pi16(quad1_pi16, quad2_pi16);
+			// Read sixteen pixels
+			group1_epi16 = _mm_loadu_si128((__m128i *)&rowptr[index]);
+			group2_epi16 = _mm_loadu_si128((__m128i *)&rowptr[index + 8]);
 
-			// Compare each pixel with zero
-			mask_pu8 = _mm_cmpeq_pi8(run_pu8, _mm_setzero_si64());
+			// Pack the pixels into bytes (saturation keeps nonzero pixels nonzero)
+			run_epi8 = _mm_packs_epi16(group1_epi16, group2_epi16);
 
-			// Create an eight bit mask
-			mask = _mm_movemask_pi8(mask_pu8);
+			// Create a sixteen bit mask of the pixels that are zero
+			mask = _mm_movemask_epi8(_mm_cmpeq_epi8(run_epi8, _mm_setzero_si128()));
 
 			// Lookup the count to the first nonzero value in the run
-			count = nonzero_index[mask];
+			count = nonzero_index[mask & 0xFF];
+			if (count == 8)
+				count += nonzero_index[mask >> 8];
 
 			// Advance the index into the row of pixels
 			index += count;
 
 			// Terminate the loop if the run was not all zeros
-			if (count < stepsize) {
-				//_mm_empty();
+			if (count < stepsize)
 				goto finish;
-			}
 		}
 
-		//_mm_empty();	// Clear the mmx register state
-
 		// Update the pixel pointer with the result of the fast search
-		pixptr = (PIXEL *)quad_ptr;
+		pixptr = &rowptr[index];
 	}
 
 #endif
@@ -1498,7 +1504,9 @@ int FindNonZero(PIXEL *rowptr, int length)
 	for (; index < length; index++)
 		if (*(pixptr++) != 0) break;
 
-//finish:
+#if XMMOPT
+finish:
+#endif
 	// Either the search went past the end of the row or a nonzero value was found
 	assert((index == length) || ((index < length) && (rowptr[index] != 0)));
 
@@ -485,6 +485,9 @@ IMAGE *CreateImageFromPlanes(uint8_t *data, int width, int height, int pitch, in
 IMAGE *CreateImageFromPacked(uint8_t *data, int width, int height, int pitch, int format);
 #endif
 
+// Return the number of bytes allocated for an image with the specified dimensions
+size_t ImageSize(int width, int height);
+
 // Adjust the size of an image to the specified dimensions
 void ResizeImage(IMAGE *image, int width, int height);
 
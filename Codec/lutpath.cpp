@@ -23,7 +23,6 @@
 #include "stdafx.h"
 #include "config.h"
 #include "encoder.h"
-#include <string>
 
 #ifdef _WIN32
 // Must include the following file for Visual Studio 2005 (not required for Visual Studio 2003)
@@ -39,6 +38,8 @@
 
 #include "codec.h"
 #include "lutpath.h"
+#include "dbcache.h"
+#include "../Common/Lock.h"
 
 
 #ifdef _WIN32
@@ -117,6 +118,20 @@ const int token_table_length = sizeof(token_table) / sizeof(token_table[0]);
 
 #define STRING_LENGTH(str)	(sizeof(str)/sizeof(str[0]))
 
+// Paths from the last preferences file parsed by any decoder
+static struct
+{
+	bool valid;
+	char pathname[PATH_MAX];
+	struct stat status;
+	char OverridePathStr[260];
+	char LUTsPathStr[260];
+	char UserDBPathStr[64];
+
+} user_prefs;
+
+static CSimpleLock user_prefs_lock;
+
 
 // Safely copy a string after clearing the destination
 void CopyString(char *target, const char *source, size_t size)
@@ -127,8 +142,8 @@ void CopyString(char *target, const char *source, size_t size)
 	target[length - 1] = '\0';
 }
 
-// Open the first user preferences file that exists
-FILE *OpenUserPrefsFile(char *actual_pathname, size_t actual_size)
+// Find the first user preferences file that exists without allocating memory
+static bool FindUserPrefsFile(char *pathname, size_t size, struct stat *status)
 {
 	// The system-wide preferences files are listed in search order
 	static const char *system_preferences_path[] =
@@ -143,44 +158,44 @@ FILE *OpenUserPrefsFile(char *actual_pathname, size_t actual_size)
 	const char *home_dir = getenv("HOME");
 	if (home_dir)
 	{
-		// Initialize the preferences path with the user home directory
-		std::string pathname(home_dir);
-		pathname.append("/.cineform/dbsettings");
-
 		// Does the user have a preferences file?
-		FILE *file = fopen(pathname.c_str(), "r");
-		if (file)
-		{
-			if (actual_pathname)
-			{
-				// Return the actual preferences pathname for error messages
-				int actual_length = actual_size / sizeof(actual_pathname[0]);
-				strncpy(actual_pathname, pathname.c_str(), actual_length);
-				actual_pathname[actual_length - 1] = '\0';
-			}
-			return file;
+		int length = snprintf(pathname, size, "%s/.cineform/dbsettings", home_dir);
+		if (0 < length && length < (int)size &&
+			access(pathname, R_OK) == 0 && stat(pathname, status) == 0) {
+			return true;
 		}
 	}
 
 	// Look for a system-wide preferences file
 	for (int i = 0; i < system_preferences_path_count; i++)
 	{
-		// Try to open the preferences file
-		FILE *file = fopen(system_preferences_path[i], "r");
-		if (file)
+		if (access(system_preferences_path[i], R_OK) == 0 && stat(system_preferences_path[i], status) == 0)
 		{
-			if (actual_pathname)
-			{
-				// Return the actual preferences pathname for error messages
-				int actual_length = actual_size / sizeof(actual_pathname[0]);
-				strncpy(actual_pathname, system_preferences_path[i], actual_length);
-				actual_pathname[actual_length - 1] = '\0';
-			}
-			return file;
+			CopyString(pathname, system_preferences_path[i], size);
+			return true;
 		}
 	}
 
-	return NULL;
+	return false;
+}
+
+// Open the first user preferences file that exists
+FILE *OpenUserPrefsFile(char *actual_pathname, size_t actual_size)
+{
+	char pathname[PATH_MAX];
+	struct stat status;
+
+	if (!FindUserPrefsFile(pathname, sizeof(pathname), &status)) {
+		return NULL;
+	}
+
+	if (actual_pathname)
+	{
+		// Return the actual preferences pathname for error messages
+		CopyString(actual_pathname, pathname, actual_size);
+	}
+
+	return fopen(pathname, "r");
 }
 
 FILE *OpenLogFile()
@@ -586,10 +601,29 @@ void InitLUTPaths(DECODER *decoder)
 		CopyString(decoder->LUTsPathStr, LUT_PATH_STRING, sizeof(decoder->LUTsPathStr));
 		CopyString(decoder->UserDBPathStr, DATABASE_PATH_STRING, sizeof(decoder->UserDBPathStr));
 
-		// Open the first users preferences file that exists
+		// Find the first users preferences file that exists
 		//FILE *file = fopen(SETTINGS_PATH_STRING, "r");
 		char pathname[PATH_MAX];
-		FILE *file = OpenUserPrefsFile(pathname, sizeof(pathname));
+		struct stat status;
+		if (!FindUserPrefsFile(pathname, sizeof(pathname), &status)) {
+			return;
+		}
+
+		// The paths are checked on every refresh so only parse the file again if it changed
+		CAutoLock lock(user_prefs_lock);
+		if (user_prefs.valid &&
+			strcmp(user_prefs.pathname, pathname) == 0 &&
+			user_prefs.status.st_ino == status.st_ino &&
+			user_prefs.status.st_size == status.st_size &&
+			user_prefs.status.st_mtime == status.st_mtime)
+		{
+			CopyString(decoder->OverridePathStr, user_prefs.OverridePathStr, sizeof(decoder->OverridePathStr));
+			CopyString(decoder->LUTsPathStr, user_prefs.LUTsPathStr, sizeof(decoder->LUTsPathStr));
+			CopyString(decoder->UserDBPathStr, user_prefs.UserDBPathStr, sizeof(decoder->UserDBPathStr));
+			return;
+		}
+
+		FILE *file = fopen(pathname, "r");
 		if (file)
 		{
 			SCANNER scanner;
@@ -614,6 +648,14 @@ void InitLUTPaths(DECODER *decoder)
 			}
 
 			fclose(file);
+
+			// Remember the paths from this version of the preferences file
+			CopyString(user_prefs.pathname, pathname, sizeof(user_prefs.pathname));
+			user_prefs.status = status;
+			CopyString(user_prefs.OverridePathStr, decoder->OverridePathStr, sizeof(user_prefs.OverridePathStr));
+			CopyString(user_prefs.LUTsPathStr, decoder->LUTsPathStr, sizeof(user_prefs.LUTsPathStr));
+			CopyString(user_prefs.UserDBPathStr, decoder->UserDBPathStr, sizeof(user_prefs.UserDBPathStr));
+			user_prefs.valid = true;
 		}
 #endif
 	}
@@ -1060,24 +1102,26 @@ void CopyMetadataChunks(DECODER *decoder, DECODER *parentDecoder)
     int i;
     for (i=0;i<decoder->metadatachunks; i++)
     {
-#if _ALLOCATOR
-        if(decoder->mdc[i])
-            Free(decoder->allocator, decoder->mdc[i]);
-#else
-        if(decoder->mdc[i])
-            MEMORY_FREE(decoder->mdc[i]);
-#endif
         decoder->mdc_size[i]=0;
     }
     decoder->metadatachunks = 0;
     
     if (parentDecoder) {
         for (i=0; i<parentDecoder->metadatachunks; i++) {
+            // Reuse the buffers from the previous frame if they are large enough
+            if (decoder->mdc[decoder->metadatachunks] == NULL || decoder->mdc_limit[decoder->metadatachunks] < parentDecoder->mdc_size[i])
+            {
 #if _ALLOCATOR
-            decoder->mdc[decoder->metadatachunks] = (unsigned char *)Alloc(decoder->allocator, parentDecoder->mdc_size[i]);
+                if(decoder->mdc[decoder->metadatachunks])
+                    Free(decoder->allocator, decoder->mdc[decoder->metadatachunks]);
+                decoder->mdc[decoder->metadatachunks] = (unsigned char *)Alloc(decoder->allocator, parentDecoder->mdc_size[i]);
 #else
-            decoder->mdc[decoder->metadatachunks] = (unsigned char *)MEMORY_ALLOC(parentDecoder->mdc_size[i]);
+                if(decoder->mdc[decoder->metadatachunks])
+                    MEMORY_FREE(decoder->mdc[decoder->metadatachunks]);
+                decoder->mdc[decoder->metadatachunks] = (unsigned char *)MEMORY_ALLOC(parentDecoder->mdc_size[i]);
 #endif
+                decoder->mdc_limit[decoder->metadatachunks] = decoder->mdc[decoder->metadatachunks] ? parentDecoder->mdc_size[i] : 0;
+            }
             if(decoder->mdc[decoder->metadatachunks] && parentDecoder->mdc[i])
                 memcpy(decoder->mdc[decoder->metadatachunks], parentDecoder->mdc[i], parentDecoder->mdc_size[i]);
             decoder->mdc_size[decoder->metadatachunks] = parentDecoder->mdc_size[i];
@@ -1093,9 +1137,25 @@ void CopyMetadataChunks(DECODER *decoder, DECODER *parentDecoder)
 bool LoadDiskMetadata(DECODER *decoder, int priority, char *filename)
 {
 	bool ret = false;
-	long int len;			// Must be large enough to hold file pointer from ftell()
+	DISK_DATABASE *database = NULL;
+
+	// The database files are shared by all decoders and reread only when the files change
+	if(strlen(filename) && decoder->hasFileDB[priority] <= 1)
+	{
+		database = AcquireDiskDatabase(filename);
+	}
 
-    if(decoder->DataBases[priority])
+	if(database && decoder->DataBases[priority] &&
+	   decoder->DataBasesGeneration[priority] == database->generation &&
+	   decoder->DataBasesSize[priority] == database->size)
+	{
+		// The decoder already has a copy of the current file contents
+		decoder->hasFileDB[priority] = 1;
+		ReleaseDiskDatabase(database);
+		return true;
+	}
+
+    if(decoder->DataBases[priority] && (database == NULL || database->size == 0))
     {
 #if _ALLOCATOR
 		Free(decoder->allocator, decoder->DataBases[priority]);
@@ -1104,147 +1164,234 @@ bool LoadDiskMetadata(DECODER *decoder, int priority, char *filename)
 #endif
             
         decoder->DataBases[priority] = NULL;
-        decoder->DataBasesSize[priority] = 0;
         decoder->DataBasesAllocSize[priority] = 0;
     }
+	decoder->DataBasesSize[priority] = 0;
+	decoder->DataBasesGeneration[priority] = 0;
 
+	if(database)
 	{
-		unsigned int *size;
-		unsigned int *allocSize;
-		unsigned char **buffer = NULL;
-		//char ext[8] = "";
-		
-		buffer = &decoder->DataBases[priority]; 
-		if(buffer && strlen(filename) && decoder->hasFileDB[priority] <= 1)
+		unsigned int len = (unsigned int)database->size;
+
+		if(len)
 		{
-			FILE *fp;
-			int first = 1;
-			int retry = 0;
-#ifdef _WIN32
-			int openfail = 0;
-#endif
-			size = &decoder->DataBasesSize[priority];
-			allocSize = &decoder->DataBasesAllocSize[priority];
-			do
+			// Keep the buffer for the previous contents if the new contents fit
+			if(decoder->DataBases[priority] == NULL || decoder->DataBasesAllocSize[priority] < len)
 			{
-				int err = 0;
-				retry = 0;
-#ifdef _WIN32
-				openfail = 0;
-				err = fopen_s(&fp, filename, "rb");
-#else
-				fp = fopen(filename, "rb");
-#endif
-
-				if (err == 0 && fp)
+				if(decoder->DataBases[priority])
 				{
-//					if(0==first)
-//                      fprintf(stderr,"OK\n");
-					fseek (fp, 0, SEEK_END);
-					len = ftell(fp);
-                    
-//                  fprintf(stderr, "Ok open %s len %d\n",filenameGUID,len);
+			#if _ALLOCATOR
+					Free(decoder->allocator, decoder->DataBases[priority]);
+			#else
+					MEMORY_FREE(decoder->DataBases[priority]);
+			#endif
+				}
+				decoder->DataBasesAllocSize[priority] = (len + 511) & ~0xff;
+			#if _ALLOCATOR
+				decoder->DataBases[priority] = (unsigned char *)Alloc(decoder->allocator, decoder->DataBasesAllocSize[priority]);
+			#else
+				decoder->DataBases[priority] = (unsigned char *)MEMORY_ALLOC(decoder->DataBasesAllocSize[priority]);
+			#endif
+			}
 
-					if(len > (long)*allocSize || *buffer == NULL)
-					{
-						if(*buffer)
-						{		
-							#if _ALLOCATOR
-							Free(decoder->allocator, *buffer);
-							#else
-							MEMORY_FREE(*buffer);
-							#endif
-							*buffer = NULL;
-						}
+			if(decoder->DataBases[priority])
+			{
+				memcpy(decoder->DataBases[priority], database->data, len);
+				decoder->DataBasesSize[priority] = len;
+				decoder->DataBasesGeneration[priority] = database->generation;
+				decoder->hasFileDB[priority] = 1;
+				ret = true;
+			}
+			else
+			{
+				decoder->DataBasesAllocSize[priority] = 0;
+			}
+		}
 
-						*allocSize = (len + 511) & ~0xff;
-						#if _ALLOCATOR
-						*buffer = (unsigned char *)Alloc(decoder->allocator, *allocSize);
-						#else
-						*buffer = (unsigned char *)MEMORY_ALLOC(*allocSize);
-						#endif
+		ReleaseDiskDatabase(database);
+	}
+	
+	return ret;
+}
 
-						if(*buffer == NULL)
-							break;
-					}
+// Tags that change on every frame without changing the decoder settings
+#define IS_FRAME_VARYING_TAG(tag)	((tag) == TAG_UNIQUE_FRAMENUM || (tag) == TAG_TIMECODE)
 
-					if(len && len <= (long)*allocSize)
-					{
-						fseek (fp, 0, SEEK_SET);
-						*size = (unsigned int)fread(*buffer,1,len,fp);
-						if(*size != len)
-                        {
-                            // DAN20090529 -- Test for partially read files.
-							retry = 1;
-                            fprintf(stderr, "Length short\n");
-                        }
-						else
-						{
-							decoder->hasFileDB[priority] = 1;
-							ret = true;
-						}
-					}
-					else
-					{
-						if(len == 0)
-							retry = 0;
-						if(*size != 0)
-							retry = 1;
-						*size = 0;
-					}
+// Add the metadata tags to the hash of the active metadata using the same loop as UpdateCFHDDATA
+static uint64_t HashMetadataTags(uint64_t hash, unsigned char *ptr, int len, bool skip_frame_varying)
+{
+	int pos = 0;
 
+	hash = (hash ^ (uint64_t)len) * 0x100000001b3ULL;
 
-					fclose(fp);
-//								break;
-				}
-				else
-				{
-                    int  theErr = errno;
-                    
-                    if (theErr==ENOENT) {
-                        // file does not exist so just bail
-                        *size = 0;
-#ifdef _WIN32
-                        openfail = 1;
-#endif
-                        retry = 0;
-                    } else {
-//                      fprintf(stderr,"no %d\n",theErr);
-                        if(decoder->hasFileDB[priority] == 1)
-                        {
-#ifdef _WIN32
-                            openfail = 1;
-#endif
-                            if(first)
-                            {
-//                              fprintf(stderr, "retryf\n");
-                                first = 0;
-                                retry = 1;
+	while(pos+12 <= len)
+	{
+		uint32_t tag = MAKETAG(ptr[0],ptr[1],ptr[2],ptr[3]);
+		int size = ptr[4] + (ptr[5]<<8) + (ptr[6]<<16);
+		int next = (8 + size + 3) & 0xfffffc;
+		int count = (next < len - pos) ? next : len - pos;
+
+		if(tag == 0)
+			break;
+
+		if(!(skip_frame_varying && IS_FRAME_VARYING_TAG(tag)))
+		{
+			int i;
+			for(i = 0; i < count; i++)
+			{
+				hash = (hash ^ ptr[i]) * 0x100000001b3ULL;
+			}
+		}
+
+		ptr += next;
+		pos += next;
+	}
+
+	return hash;
+}
+
+// Compute a hash of all of the metadata that OverrideCFHDDATA applies to the decoder
+static uint64_t HashActiveMetadata(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWordsUsed)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	size_t metadatasize = 0;
+	void *metadatastart;
+	METADATA_TAG tag;
+	METADATA_TYPE type;
+	METADATA_SIZE size;
+	unsigned char *buf = lpCurrentBuffer;
+	unsigned int samplesize = nWordsUsed;
+	int i;
+
+	while ((metadatastart = MetaDataFindFirst(buf, samplesize, &metadatasize, &tag, &size, &type)))
+	{
+		buf = (unsigned char *)metadatastart;
+		buf -= 8; // Point to the tag not the data
+
+		hash = HashMetadataTags(hash, buf, (int)metadatasize, true);
+		buf += metadatasize;
+		samplesize -= (unsigned int)metadatasize;
+	}
+
+	for(i=0; i<=METADATA_PRIORITY_MAX; i++)
+	{
+		if(decoder->DataBases[i] && decoder->DataBasesSize[i])
+		{
+			// The frame databases are copied from the sample
+			bool frame = (i >= METADATA_PRIORITY_FRAME && i <= METADATA_PRIORITY_FRAME_2);
+
+			hash = (hash ^ (uint64_t)i) * 0x100000001b3ULL;
+			hash = HashMetadataTags(hash, decoder->DataBases[i], decoder->DataBasesSize[i], frame);
+		}
+	}
+
+	if(decoder->overrideData && decoder->overrideSize)
+	{
+		hash = HashMetadataTags(hash, decoder->overrideData, decoder->overrideSize, false);
+	}
+
+	hash = (hash ^ (uint32_t)decoder->cfhddata.process_path_flags_mask) * 0x100000001b3ULL;
+
+	return hash;
+}
+
+// Apply the tags that change on every frame in the same order as the full metadata update
+static void UpdateFrameVaryingTags(DECODER *decoder, unsigned char *ptr, int len)
+{
+	int pos = 0;
+
+	if(ptr == NULL)
+		return;
+
+	while(pos+12 <= len)
+	{
+		uint32_t tag = MAKETAG(ptr[0],ptr[1],ptr[2],ptr[3]);
+		int size = ptr[4] + (ptr[5]<<8) + (ptr[6]<<16);
+
+		if(tag == 0)
+			break;
+
+		switch(tag)
+		{
+		case TAG_UNIQUE_FRAMENUM:
+			decoder->codec.unique_framenumber = *((uint32_t *)&ptr[8]);
+			break;
+
+		case TAG_TIMECODE:
 #ifdef _WIN32
-                                Sleep(1);
+			strncpy_s(decoder->cfhddata.FileTimecodeData.orgtime, sizeof(decoder->cfhddata.FileTimecodeData.orgtime), (char *)&ptr[8], 15);
 #else
-                                usleep(1000);
+			strncpy(decoder->cfhddata.FileTimecodeData.orgtime, (char *)&ptr[8], 15);
 #endif
-                            }
-//                          if(*size != 0)
-//                          {
-//    //                       fprintf(stderr, "retrys\n");
-//                             retry = 1;
-//                          }
-                            *size = 0;
-                        }
-                        else
-                        {
-                            *size = 0;
-                        }
-                    }
-				}
-			}
-			while(retry);
+			break;
 		}
+
+		ptr += (8 + size + 3) & 0xfffffc;
+		pos += (8 + size + 3) & 0xfffffc;
 	}
-	
-	return ret;
+}
+
+// Update the frame number and timecode if the rest of the active metadata has not changed
+static bool UpdateUnchangedMetadata(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWordsUsed)
+{
+	CFHDDATA *cfhddata = &decoder->cfhddata;
+	size_t metadatasize = 0;
+	void *metadatastart;
+	METADATA_TAG tag;
+	METADATA_TYPE type;
+	METADATA_SIZE size;
+	unsigned char *buf = lpCurrentBuffer;
+	unsigned int samplesize = nWordsUsed;
+	int firstmetadatachunk = 1;
+	int i;
+
+	if(!decoder->metadata_hash_valid ||
+	   decoder->MDPdefault.initialized == 0 ||
+	   decoder->image_dev_only ||
+	   cfhddata->force_disk_database ||
+	   cfhddata->force_metadata_refresh)
+	{
+		return false;
+	}
+
+	if(HashActiveMetadata(decoder, lpCurrentBuffer, nWordsUsed) != decoder->metadata_hash)
+		return false;
+
+	while ((metadatastart = MetaDataFindFirst(buf, samplesize, &metadatasize, &tag, &size, &type)))
+	{
+		buf = (unsigned char *)metadatastart;
+		buf -= 8; // Point to the tag not the data
+
+		if(firstmetadatachunk)
+		{
+			firstmetadatachunk = 0;
+			decoder->codec.unique_framenumber = UINT32_MAX;
+
+			// The hash includes the size so the frame database has room for the sample metadata
+			if(decoder->DataBases[METADATA_PRIORITY_FRAME] && decoder->DataBasesSize[METADATA_PRIORITY_FRAME] == metadatasize)
+				memcpy(decoder->DataBases[METADATA_PRIORITY_FRAME], buf, metadatasize);
+		}
+
+		UpdateFrameVaryingTags(decoder, buf, (int)metadatasize);
+		buf += metadatasize;
+		samplesize -= (unsigned int)metadatasize;
+	}
+
+	if(decoder->overrideData && decoder->overrideSize)
+	{
+		UpdateFrameVaryingTags(decoder, decoder->overrideData, decoder->overrideSize);
+		UpdateFrameVaryingTags(decoder, decoder->DataBases[METADATA_PRIORITY_OVERRIDE_1], decoder->DataBasesSize[METADATA_PRIORITY_OVERRIDE_1]);
+		UpdateFrameVaryingTags(decoder, decoder->DataBases[METADATA_PRIORITY_OVERRIDE_2], decoder->DataBasesSize[METADATA_PRIORITY_OVERRIDE_2]);
+	}
+	else
+	{
+		for(i=0; i<=METADATA_PRIORITY_MAX; i++)
+		{
+			UpdateFrameVaryingTags(decoder, decoder->DataBases[i], decoder->DataBasesSize[i]);
+		}
+	}
+
+	return true;
 }
 
 void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWordsUsed)
@@ -1254,6 +1401,7 @@ void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWor
 	int process_path_flags_mask = decoder->cfhddata.process_path_flags_mask;
 	int checkdiskinfo = 0;	
 	int checkdiskinfotime = 0;
+	bool metadata_unchanged = false;
 	decoder->drawmetadataobjects = 0; // fix for metadata display on P frames.
 
 	decoder->codec.PFrame = IsSampleKeyFrame(lpCurrentBuffer, nWordsUsed) ? 0 : (1-decoder->image_dev_only);
@@ -1270,6 +1418,14 @@ void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWor
 
 #define MS_DIFF	(CLOCKS_PER_SEC / 10)
 
+	// Most frames in a clip carry the same active metadata so only the frame number and timecode need updating
+	if(!(diff > MS_DIFF || *last_set_time==0 || now!=decoder->last_time_t) &&
+	   UpdateUnchangedMetadata(decoder, lpCurrentBuffer, nWordsUsed))
+	{
+		metadata_unchanged = true;
+		goto apply_settings;
+	}
+
     // Pre-processing
     //  See if the decoder has been initialized.  If not, initialize it and the cfhddata structures
     //  Read the first chunk of metadata, clear out the cfhddata structure and init from the metadata
@@ -1958,6 +2114,7 @@ void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWor
 		}
 	}
 
+apply_settings:
 	if ((uint32_t)decoder->frame.colorspace != cfhddata->colorspace && cfhddata->colorspace) {
 		if(cfhddata->colorspace & COLORSPACE_MASK)
 			decoder->frame.colorspace = cfhddata->colorspace;		// colorspace and 422->444
@@ -1975,7 +2132,8 @@ void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWor
 		decoder->thread_cntrl.set_thread_params = 1;
 	}
 
-	
+	if(metadata_unchanged)
+		return;
 		
 #if WARPSTUFF
 	{
@@ -2040,6 +2198,19 @@ void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWor
 		decoder->cfhddata.doMesh = doMesh;
 	}
 #endif
+
+	{
+		// The framing and lens settings above are moved between fields on the first update,
+		// so later frames reuse the settings only after two updates applied the same metadata.
+		// Metadata that draws objects or uses control points depends on the current frame.
+		uint64_t hash = HashActiveMetadata(decoder, lpCurrentBuffer, nWordsUsed);
+
+		decoder->metadata_hash_valid = (hash == decoder->metadata_hash &&
+										decoder->drawmetadataobjects == 0 &&
+										decoder->Keyframes.keyframetypecount == 0 &&
+										!decoder->image_dev_only);
+		decoder->metadata_hash = hash;
+	}
 }
 
 void OverrideCFHDDATAUsingParent(struct decoder *decoder, struct decoder *parentDecoder, unsigned char *lpCurrentBuffer, int nWordsUsed)
@@ -2052,6 +2223,9 @@ void OverrideCFHDDATAUsingParent(struct decoder *decoder, struct decoder *parent
     myGUID lastGUID = cfhddata->clip_guid;
     int i;
 
+	// The settings are copied from the parent decoder
+	decoder->metadata_hash_valid = 0;
+
     decoder->codec.PFrame = IsSampleKeyFrame(lpCurrentBuffer, nWordsUsed) ? 0 : 1;
 	if(decoder->codec.PFrame && decoder->codec.unique_framenumber != UINT32_MAX && (decoder->codec.unique_framenumber & 1) == 0)
 	{
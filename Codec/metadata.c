@@ -579,10 +579,13 @@ int ValidMetadataLength(void *data, size_t len)
 	return pos;
 }
 
-void *MetaDataFindInSample(void *data, size_t datasize,
-						   METADATA_TAG findmetadatatag,
-						   METADATA_SIZE *retsize,
-						   METADATA_TYPE *rettype)
+// Routine called for each metadata chunk in a sample (return non-null to stop the search)
+typedef void *(* METADATA_CHUNK_PROC)(void *chunk_data, size_t chunk_size, void *param);
+
+// Walk the sample and call the routine for each metadata chunk
+static void *ForEachMetadataChunk(void *data, size_t datasize,
+								  METADATA_CHUNK_PROC proc,
+								  void *param)
 {
 	BITSTREAM myinput, *pinput = &myinput;
 	TAGVALUE segment;
@@ -646,7 +649,7 @@ void *MetaDataFindInSample(void *data, size_t datasize,
 			if(tag == (int)CODEC_TAG_METADATA || tag == (int)CODEC_TAG_METADATA_LARGE)
 			{
 				unsigned int *idata =  (unsigned int *)pinput->lpCurrentWord;
-				void *retptr = MetadataFind(idata, chunksize*4, findmetadatatag, retsize, rettype);
+				void *retptr = proc(idata, chunksize*4, param);
 
 				if(retptr)
 					return retptr;
@@ -688,6 +691,35 @@ void *MetaDataFindInSample(void *data, size_t datasize,
 	return NULL;
 }
 
+// Parameters for finding a tag in the metadata chunks of a sample
+typedef struct metadata_find_param
+{
+	METADATA_TAG tag;
+	METADATA_SIZE *retsize;
+	METADATA_TYPE *rettype;
+
+} METADATA_FIND_PARAM;
+
+static void *FindMetadataChunkProc(void *chunk_data, size_t chunk_size, void *param)
+{
+	METADATA_FIND_PARAM *find = (METADATA_FIND_PARAM *)param;
+	return MetadataFind(chunk_data, chunk_size, find->tag, find->retsize, find->rettype);
+}
+
+void *MetaDataFindInSample(void *data, size_t datasize,
+						   METADATA_TAG findmetadatatag,
+						   METADATA_SIZE *retsize,
+						   METADATA_TYPE *rettype)
+{
+	METADATA_FIND_PARAM find;
+
+	find.tag = findmetadatatag;
+	find.retsize = retsize;
+	find.rettype = rettype;
+
+	return ForEachMetadataChunk(data, datasize, FindMetadataChunkProc, &find);
+}
+
 void *MetaDataFindTag(void *data, size_t datasize,
 					  METADATA_TAG findmetadatatag,
 					  METADATA_SIZE *retsize,
@@ -761,3 +793,129 @@ bool FindMetadata(METADATA *metadata,
 
 	return false;
 }
+
+// Hash a metadata tag into a slot in the index
+#define METADATA_INDEX_HASH(tag)	(((tag) * 2654435761U) >> 24)
+
+void MetadataIndexReset(METADATA_INDEX *index)
+{
+	index->count = -1;
+	index->complete = false;
+}
+
+static void MetadataIndexClear(METADATA_INDEX *index)
+{
+	memset(index->entry, 0, sizeof(index->entry));
+	index->count = 0;
+	index->complete = true;
+}
+
+// Add the tag to the index unless the tag is already in the index
+static void MetadataIndexInsert(METADATA_INDEX *index, METADATA_TAG tag,
+								METADATA_TYPE type, METADATA_SIZE size, void *data)
+{
+	int slot = METADATA_INDEX_HASH(tag) & (METADATA_INDEX_SIZE - 1);
+
+	// The empty slot is marked by a zero tag
+	if (tag == 0) {
+		return;
+	}
+
+	while (index->entry[slot].tag != 0)
+	{
+		// Only the first occurrence of a tag is recorded in the index
+		if (index->entry[slot].tag == tag) {
+			return;
+		}
+		slot = (slot + 1) & (METADATA_INDEX_SIZE - 1);
+	}
+
+	if (index->count >= METADATA_INDEX_LIMIT)
+	{
+		// Lookups must fall back to the linear search
+		index->complete = false;
+		return;
+	}
+
+	index->entry[slot].tag = tag;
+	index->entry[slot].type = type;
+	index->entry[slot].size = size;
+	index->entry[slot].data = data;
+	index->count++;
+}
+
+// Add the tags in a metadata chunk to the index using the same loop as MetadataFind
+static void *MetadataIndexChunkProc(void *chunk_data, size_t chunk_size, void *param)
+{
+	METADATA_INDEX *index = (METADATA_INDEX *)param;
+	uint32_t *idata = chunk_data;
+	int pos = 0;
+	unsigned int tag;
+	unsigned int typesize;
+	int size,offset;
+	unsigned char type;
+
+	if(idata==NULL || chunk_size==0)
+		return NULL;
+
+	do
+	{
+		tag = *idata++; pos += 4;
+		typesize = *idata++; pos += 4;
+
+		type = (typesize >> 24) & 0xff;
+		size = typesize & 0xffffff;
+
+		MetadataIndexInsert(index, tag, type, size, idata);
+
+		offset = (size + 3) & 0xfffffc;
+
+		pos += offset;
+		idata += (offset >> 2);
+	}
+	while((size_t)pos < chunk_size);
+
+	// Continue with the next metadata chunk
+	return NULL;
+}
+
+bool MetadataIndexChunk(METADATA_INDEX *index, void *chunk_data, size_t chunk_size)
+{
+	MetadataIndexClear(index);
+	MetadataIndexChunkProc(chunk_data, chunk_size, index);
+	return index->complete;
+}
+
+bool MetadataIndexSample(METADATA_INDEX *index, void *sample_data, size_t sample_size)
+{
+	MetadataIndexClear(index);
+	if (sample_data != NULL && sample_size > 0) {
+		ForEachMetadataChunk(sample_data, sample_size, MetadataIndexChunkProc, index);
+	}
+	return index->complete;
+}
+
+void *MetadataIndexFind(METADATA_INDEX *index,
+						METADATA_TAG tag,
+						METADATA_SIZE *retsize,
+						METADATA_TYPE *rettype)
+{
+	int slot = METADATA_INDEX_HASH(tag) & (METADATA_INDEX_SIZE - 1);
+
+	if (tag == 0) {
+		return NULL;
+	}
+
+	while (index->entry[slot].tag != 0)
+	{
+		if (index->entry[slot].tag == tag)
+		{
+			*rettype = index->entry[slot].type;
+			*retsize = index->entry[slot].size;
+			return index->entry[slot].data;
+		}
+		slot = (slot + 1) & (METADATA_INDEX_SIZE - 1);
+	}
+
+	return NULL;
+}
@@ -62,6 +62,37 @@ typedef struct metadata
 #define METADATA_INITIALIZER	{NULL, 0, 0}
 #endif
 
+/*!
+	@brief Index of the metadata tags in a sample or a metadata chunk
+
+	The index is an open addressed hash table that maps each tag to the first
+	occurrence of the tag, so the result of a lookup is the same as a linear
+	search with MetadataFind or MetaDataFindInSample.  The index is built in
+	one pass over the tags and then reused for every lookup until the metadata
+	changes.  If there are too many tags to fit in the table then the index is
+	marked as incomplete and the caller must use the linear search instead.
+*/
+#define METADATA_INDEX_SIZE		256		//!< Number of slots in the table (power of two)
+#define METADATA_INDEX_LIMIT	192		//!< Maximum number of tags in the table
+
+typedef struct metadata_index_entry
+{
+	METADATA_TAG tag;		//!< Metadata tag (zero if the slot is empty)
+	METADATA_TYPE type;		//!< Metadata type code
+	METADATA_SIZE size;		//!< Size of the metadata (in bytes)
+	void *data;				//!< Pointer to the metadata
+
+} METADATA_INDEX_ENTRY;
+
+typedef struct metadata_index
+{
+	int count;				//!< Number of tags in the index (negative if the index has not been built)
+	bool complete;			//!< False if some of the tags did not fit in the index
+
+	METADATA_INDEX_ENTRY entry[METADATA_INDEX_SIZE];
+
+} METADATA_INDEX;
+
 #define METADATA_EYE_BOTH		0
 #define METADATA_EYE_LEFT		1
 #define METADATA_EYE_RGHT		2
@@ -160,6 +191,9 @@ void AllocMetadata(ALLOCATOR *allocator, METADATA *metadata, size_t size);
 void AllocMetadata(METADATA *metadata, size_t size);
 #endif
 
+// Enlarge the metadata block (if necessary) so that it can hold the specified number of bytes
+bool ReserveMetadata(METADATA *metadata, size_t size);
+
 bool AddMetadata(METADATA *metadata,
 				 uint32_t tag,
 				 unsigned char type,
@@ -182,6 +216,21 @@ void FreeMetadata(METADATA *metadata);
 
 void UpdateCFHDDATA(struct decoder *decoder, unsigned char *ptr, int len, int delta, int priority);
 
+// Mark the index as not built so that it will be rebuilt by the next lookup
+void MetadataIndexReset(METADATA_INDEX *index);
+
+// Build the index for a metadata chunk (same search order as MetadataFind)
+bool MetadataIndexChunk(METADATA_INDEX *index, void *chunk_data, size_t chunk_size);
+
+// Build the index for all of the metadata chunks in a sample (same search order as MetaDataFindInSample)
+bool MetadataIndexSample(METADATA_INDEX *index, void *sample_data, size_t sample_size);
+
+// Find the first occurrence of the tag in the index
+void *MetadataIndexFind(METADATA_INDEX *index,
+						METADATA_TAG tag,
+						METADATA_SIZE *retsize,
+						METADATA_TYPE *rettype);
+
 #ifdef __cplusplus
 }
 #endif
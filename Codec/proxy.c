@@ -0,0 +1,470 @@
+/*! @file proxy.c
+
+*  @brief Create reduced resolution proxy samples by rewriting the bitstream
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "config.h"
+#include "bitstream.h"
+#include "decoder.h"
+#include "encoder.h"
+#include "codebooks.h"
+#include "swap.h"
+#include "proxy.h"
+
+/*
+	The highpass bands that are not needed to decode a sample at half or quarter
+	resolution are replaced by bands that contain a single run of zeros.  All other
+	tags and chunks are copied unchanged.  The size chunks that enclose a replaced
+	band are closed with SizeTagPush and SizeTagPop, as in the encoder, and the
+	channel sizes in the sample index are reduced by the number of bytes removed
+	from each channel.
+*/
+
+// Table of run length codes indexed by the length of the run
+typedef struct proxy_runbook
+{
+	RLCBOOK header;
+	RLC entries[PROXY_RUNBOOK_LENGTH];
+
+} PROXY_RUNBOOK;
+
+// State of the proxy sample while it is written
+typedef struct proxy_state
+{
+	BITSTREAM output;					// Bitstream for the proxy sample
+
+	uint32_t subband_mask;				// Highpass bands that are copied unchanged
+
+	int channel;						// Current channel in the sample
+	uint8_t *index;						// Channel sizes in the proxy sample index
+	int index_count;					// Number of channel sizes in the index
+	uint32_t removed[CODEC_MAX_CHANNELS];	// Number of bytes removed from each channel
+
+	PROXY_RUNBOOK *runsbook[CODEC_NUM_CODESETS];	// Run length codes for each codeset
+
+} PROXY_STATE;
+
+
+// Return the codeset that corresponds to the active codebook in the band header
+static CODESET *GetProxyCodeset(int index)
+{
+	switch (index)
+	{
+	case 0:
+		return &CURRENT_CODESET;
+#if CODEC_NUM_CODESETS >= 2
+	case 1:
+		return &SECOND_CODESET;
+#endif
+#if CODEC_NUM_CODESETS >= 3
+	case 2:
+		return &THIRD_CODESET;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+// Compute the table of run length codes for the codeset (same table as the encoder)
+static PROXY_RUNBOOK *GetProxyRunbook(PROXY_STATE *state, int index)
+{
+	CODESET *cs = GetProxyCodeset(index);
+	PROXY_RUNBOOK *runsbook;
+
+	if (cs == NULL) {
+		return NULL;
+	}
+
+	if (state->runsbook[index] != NULL) {
+		return state->runsbook[index];
+	}
+
+	runsbook = (PROXY_RUNBOOK *)MEMORY_ALLOC(sizeof(PROXY_RUNBOOK));
+	if (runsbook != NULL)
+	{
+		RLE *old_codes = (RLE *)(((char *)cs->src_codebook->runbook) + sizeof(RLCBOOK));
+		int old_length = cs->src_codebook->runbook->length;
+
+		// Get the codebook entry for an isolated zero
+		VLC *code = (VLC *)(((char *)cs->magsbook) + sizeof(VLCBOOK));
+
+		runsbook->header.length = PROXY_RUNBOOK_LENGTH;
+
+#if _ALLOCATOR
+		ComputeRunLengthCodeTable(NULL, old_codes, old_length,
+								  runsbook->entries, PROXY_RUNBOOK_LENGTH,
+								  code->bits, code->size);
+#else
+		ComputeRunLengthCodeTable(old_codes, old_length,
+								  runsbook->entries, PROXY_RUNBOOK_LENGTH,
+								  code->bits, code->size);
+#endif
+		state->runsbook[index] = runsbook;
+	}
+
+	return runsbook;
+}
+
+// Return the highpass bands that must be decoded at the specified resolution
+static uint32_t GetProxySubbandMask(int transform_type, int resolution)
+{
+	if (transform_type == TRANSFORM_TYPE_SPATIAL)
+	{
+		// Same masks as the decoder uses to skip the rest of the channel
+		if (resolution == DECODED_RESOLUTION_HALF) return 0x7F;
+		if (resolution == DECODED_RESOLUTION_QUARTER) return 0x0F;
+	}
+	else if (transform_type == TRANSFORM_TYPE_FIELDPLUS)
+	{
+		if (resolution == DECODED_RESOLUTION_HALF) return DECODED_SUBBAND_MASK_HALF;
+		if (resolution == DECODED_RESOLUTION_QUARTER) return DECODED_SUBBAND_MASK_QUARTER;
+	}
+
+	return 0;
+}
+
+// Read the tag value pair at the specified location in the sample
+static INLINE void GetProxySegment(const uint8_t *ptr, int *tag_out, int *value_out)
+{
+	uint32_t segment = SwapInt32BtoN(*((uint32_t *)ptr));
+	int tag = (int16_t)(segment >> 16);
+
+	// Optional tags are identified by their magnitude
+	*tag_out = (tag < 0) ? NEG(tag) : tag;
+	*value_out = (segment & CODEC_TAG_MASK);
+}
+
+// Copy a block of tags or chunk data into the proxy sample
+static bool PutProxyData(BITSTREAM *output, const uint8_t *data, size_t size)
+{
+	if (output->nWordsUsed + size > (size_t)output->dwBlockLength) {
+		output->error = BITSTREAM_ERROR_OVERFLOW;
+		return false;
+	}
+
+	memcpy(output->lpCurrentWord, data, size);
+	output->lpCurrentWord += size;
+	output->nWordsUsed += (int)size;
+
+	return true;
+}
+
+// Subtract the bytes removed from each channel from the channel sizes in the index
+static void UpdateProxyIndex(PROXY_STATE *state)
+{
+	int i;
+
+	if (state->index == NULL) {
+		return;
+	}
+
+	for (i = 0; i < state->index_count; i++)
+	{
+		uint32_t *entry = (uint32_t *)(state->index + i * sizeof(uint32_t));
+		uint32_t channel_size = SwapInt32BtoN(*entry);
+
+		assert(state->removed[i] <= channel_size);
+		*entry = SwapInt32NtoB(channel_size - state->removed[i]);
+	}
+
+	state->index = NULL;
+	state->index_count = 0;
+}
+
+// Copy a highpass band or replace it with an empty band if it is not needed
+static CODEC_ERROR PutProxyBand(PROXY_STATE *state, const uint8_t *sample, size_t sample_size, size_t *offset)
+{
+	BITSTREAM *output = &state->output;
+	size_t band_start = *offset;
+	size_t band_end = 0;
+	size_t position = band_start + 4;
+	int band = 0;
+	int width = 0;
+	int height = 0;
+	int subband = -1;
+	int encoding = 0;
+	int quantization = 0;
+	int scale = 0;
+	int coding_flags = 0;
+	int active_codebook;
+	int tag, value;
+
+	// Parse the band header that precedes the band data
+	for (;;)
+	{
+		if (position + 4 > sample_size) {
+			return CODEC_ERROR_INVALID_BITSTREAM;
+		}
+
+		GetProxySegment(sample + position, &tag, &value);
+		position += 4;
+
+		if ((tag & 0xFF00) == CODEC_TAG_SUBBAND_SIZE) {
+			band_end = position + ((((tag & 0xFF) << 16) | value) * 4);
+			break;
+		}
+
+		switch (tag)
+		{
+		case CODEC_TAG_BAND_NUMBER:			band = value;			break;
+		case CODEC_TAG_BAND_CODING_FLAGS:	coding_flags = value;	break;
+		case CODEC_TAG_BAND_WIDTH:			width = value;			break;
+		case CODEC_TAG_BAND_HEIGHT:			height = value;			break;
+		case CODEC_TAG_BAND_SUBBAND:		subband = value;		break;
+		case CODEC_TAG_BAND_ENCODING:		encoding = value;		break;
+		case CODEC_TAG_BAND_QUANTIZATION:	quantization = value;	break;
+		case CODEC_TAG_BAND_SCALE:			scale = value;			break;
+
+		default:
+			// The peak table offsets are not needed for an empty band
+			break;
+		}
+	}
+
+	if (band_end > sample_size) {
+		return CODEC_ERROR_INVALID_BITSTREAM;
+	}
+
+	// The peak table for the band follows the band trailer
+	if (band_end + 4 <= sample_size)
+	{
+		GetProxySegment(sample + band_end, &tag, &value);
+		if (tag == CODEC_TAG_PEAK_TABLE)
+		{
+			band_end += 4 + value * 4;
+			if (band_end > sample_size) {
+				return CODEC_ERROR_INVALID_BITSTREAM;
+			}
+		}
+	}
+
+	*offset = band_end;
+
+	// Copy the band if it is needed at the proxy resolution
+	if (subband < 0 || subband >= 32 || (state->subband_mask & SUBBAND_MASK(subband)) != 0 ||
+		encoding != BAND_ENCODING_RUNLENGTHS)
+	{
+		if (!PutProxyData(output, sample + band_start, band_end - band_start)) {
+			return CodecErrorBitstream(output);
+		}
+		return CODEC_ERROR_OKAY;
+	}
+
+	active_codebook = coding_flags & CBFLAG_TABLMASK;
+	if (GetProxyCodeset(active_codebook) == NULL) {
+		return CODEC_ERROR_INVALID_BITSTREAM;
+	}
+
+	// The empty band is never larger than the band that it replaces
+	if (output->nWordsUsed + (band_end - band_start) > (size_t)output->dwBlockLength) {
+		output->error = BITSTREAM_ERROR_OVERFLOW;
+		return CodecErrorBitstream(output);
+	}
+
+	{
+		CODESET *cs = GetProxyCodeset(active_codebook);
+		PROXY_RUNBOOK *runsbook = GetProxyRunbook(state, active_codebook);
+		int pos = cs->tagsbook[0] - 1;		// The last code in the tagsbook in the band_end_code
+		int start = output->nWordsUsed;
+
+		if (runsbook == NULL) {
+			return CODEC_ERROR_MEMORY_ALLOC;
+		}
+
+		// Output an empty band with the same parameters as the original band
+		PutVideoBandHeader(output, band, width, height, subband, encoding,
+						   quantization, scale, 0, NULL, active_codebook, 0);
+		PutZeroRun(output, width * height, &runsbook->header);
+		FinishEncodeBand(output, (unsigned int)cs->tagsbook[pos*2+2], (int)cs->tagsbook[pos*2+1]);
+		PutVideoBandTrailer(output);
+
+		if (0 <= state->channel && state->channel < CODEC_MAX_CHANNELS) {
+			state->removed[state->channel] += (uint32_t)((band_end - band_start) - (output->nWordsUsed - start));
+		}
+	}
+
+	return CodecErrorBitstream(output);
+}
+
+CODEC_ERROR GenerateProxySample(void *sample_ptr,
+								size_t sample_size,
+								void *output_buffer,
+								size_t output_size,
+								int resolution,
+								size_t *actual_size_out)
+{
+	const uint8_t *sample = (const uint8_t *)sample_ptr;
+	PROXY_STATE state;
+	CODEC_ERROR error = CODEC_ERROR_OKAY;
+	size_t chunk_end[NESTING_LEVELS];
+	int chunk_depth = 0;
+	size_t offset = 0;
+	int i;
+
+	if (sample_ptr == NULL || output_buffer == NULL) {
+		return CODEC_ERROR_NULLPTR;
+	}
+
+	if (resolution != DECODED_RESOLUTION_HALF && resolution != DECODED_RESOLUTION_QUARTER) {
+		return CODEC_ERROR_RESOLUTION;
+	}
+
+	memset(&state, 0, sizeof(state));
+	InitBitstreamBuffer(&state.output, (uint8_t *)output_buffer, output_size, BITSTREAM_ACCESS_WRITE);
+
+	// Copy all bands until the transform type is known
+	state.subband_mask = 0xFFFFFFFF;
+
+	while (error == CODEC_ERROR_OKAY && offset + 4 <= sample_size)
+	{
+		size_t size = 4;
+		int tag, value;
+
+		GetProxySegment(sample + offset, &tag, &value);
+
+		if (tag == CODEC_TAG_MARKER && offset + 8 <= sample_size)
+		{
+			int next_tag, next_value;
+
+			// Is this the start of a highpass band?
+			GetProxySegment(sample + offset + 4, &next_tag, &next_value);
+			if (next_tag == CODEC_TAG_BAND_NUMBER)
+			{
+				error = PutProxyBand(&state, sample, sample_size, &offset);
+				size = 0;
+			}
+		}
+		else if (tag == CODEC_TAG_TRANSFORM_TYPE)
+		{
+			state.subband_mask = GetProxySubbandMask(value, resolution);
+			if (state.subband_mask == 0) {
+				error = CODEC_ERROR_TRANSFORM_TYPE;
+				break;
+			}
+		}
+		else if (tag == CODEC_TAG_ENCODED_FORMAT)
+		{
+			// Bayer samples decode every band at half and quarter resolution
+			if (value == ENCODED_FORMAT_BAYER) {
+				error = CODEC_ERROR_UNSUPPORTED_FORMAT;
+				break;
+			}
+		}
+		else if (tag == CODEC_TAG_INDEX)
+		{
+			// Finish the index from the previous sample in the buffer
+			UpdateProxyIndex(&state);
+			memset(state.removed, 0, sizeof(state.removed));
+			state.channel = 0;
+
+			state.index = state.output.lpCurrentWord + 4;
+			state.index_count = (value < CODEC_MAX_CHANNELS) ? value : CODEC_MAX_CHANNELS;
+			size += value * 4;
+		}
+		else if (tag == CODEC_TAG_CHANNEL)
+		{
+			state.channel = value;
+		}
+		else if (tag & CODEC_TAG_CHUNK)
+		{
+			// Copy metadata and other custom chunks
+			if ((tag & CODEC_TAG_CUSTOM_CHUNK24BIT) == CODEC_TAG_CUSTOM_CHUNK24BIT) {
+				size += (((tag & 0xFF) << 16) | value) * 4;
+			}
+			else {
+				size += value * 4;
+			}
+		}
+		else if (tag & CODEC_TAG_CHUNK24BIT)
+		{
+			size_t chunk_size = (((tag & 0xFF) << 16) | value) * 4;
+
+			switch (tag & 0xFF00)
+			{
+			case CODEC_TAG_SUBBAND_SIZE:
+				// Copy the lowpass band
+				size += chunk_size;
+				break;
+
+			case CODEC_TAG_UNCOMPRESS:
+				error = CODEC_ERROR_UNSUPPORTED_FORMAT;
+				break;
+
+			default:
+				// Open a size chunk that will be closed after the enclosed data is copied
+				if (chunk_depth == NESTING_LEVELS || offset + 4 + chunk_size > sample_size) {
+					error = CODEC_ERROR_INVALID_BITSTREAM;
+					break;
+				}
+				SizeTagPush(&state.output, tag & 0xFF00);
+				chunk_end[chunk_depth++] = offset + 4 + chunk_size;
+				offset += 4;
+				size = 0;
+				break;
+			}
+
+			if (error != CODEC_ERROR_OKAY) {
+				break;
+			}
+		}
+
+		if (size > 0)
+		{
+			if (offset + size > sample_size) {
+				error = CODEC_ERROR_INVALID_BITSTREAM;
+				break;
+			}
+			if (!PutProxyData(&state.output, sample + offset, size)) {
+				error = CodecErrorBitstream(&state.output);
+				break;
+			}
+			offset += size;
+		}
+
+		// Close the size chunks that end at this point in the sample
+		while (chunk_depth > 0 && offset >= chunk_end[chunk_depth - 1])
+		{
+			SizeTagPop(&state.output);
+			chunk_depth--;
+		}
+	}
+
+	if (error == CODEC_ERROR_OKAY)
+	{
+		// Copy any padding after the last tag
+		if (offset < sample_size && !PutProxyData(&state.output, sample + offset, sample_size - offset)) {
+			error = CodecErrorBitstream(&state.output);
+		}
+
+		UpdateProxyIndex(&state);
+
+		if (actual_size_out) {
+			*actual_size_out = BitstreamByteCount(&state.output);
+		}
+	}
+
+	for (i = 0; i < CODEC_NUM_CODESETS; i++)
+	{
+		if (state.runsbook[i] != NULL) {
+			MEMORY_FREE(state.runsbook[i]);
+		}
+	}
+
+	return error;
+}
@@ -0,0 +1,57 @@
+/*! @file proxy.h
+
+*  @brief Create reduced resolution proxy samples by rewriting the bitstream
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _PROXY_H
+#define _PROXY_H
+
+#include "error.h"
+
+// Number of entries in the run length table used to encode the empty bands
+#define PROXY_RUNBOOK_LENGTH	3072
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+	@brief Copy a sample replacing the highpass bands that are not needed
+	at the requested resolution with empty bands
+
+	The resolution must be DECODED_RESOLUTION_HALF or DECODED_RESOLUTION_QUARTER.
+	The subband, level, and sample sizes and the channel index are rewritten so the
+	proxy is a valid sample with the same frame dimensions as the original.  Decoding
+	the proxy at the requested resolution (or lower) gives the same result as decoding
+	the original sample at that resolution.
+
+	The output buffer should be at least as large as the input sample.
+*/
+CODEC_ERROR GenerateProxySample(void *sample_ptr,
+								size_t sample_size,
+								void *output_buffer,
+								size_t output_size,
+								int resolution,
+								size_t *actual_size_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,201 @@
+/*! @file telemetry.c
+
+*  @brief Per-stage timing statistics for decoding and encoding
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "config.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#include <string.h>
+#include <assert.h>
+
+#include "telemetry.h"
+#include "CFHDTypes.h"
+
+// Heap allocations made by the codec in this process
+static volatile int64_t allocation_count = 0;
+
+
+void InitTelemetry(TELEMETRY *telemetry)
+{
+	CreateLock(&telemetry->lock);
+	memset(&telemetry->data, 0, sizeof(telemetry->data));
+}
+
+void ReleaseTelemetry(TELEMETRY *telemetry)
+{
+	DeleteLock(&telemetry->lock);
+}
+
+void ReadTelemetry(TELEMETRY *telemetry, TELEMETRY_DATA *data, bool reset)
+{
+	Lock(&telemetry->lock);
+
+	if (data) {
+		memcpy(data, &telemetry->data, sizeof(TELEMETRY_DATA));
+	}
+
+	if (reset) {
+		memset(&telemetry->data, 0, sizeof(telemetry->data));
+	}
+
+	Unlock(&telemetry->lock);
+}
+
+// Copy the statistics for one stage into the public data structure
+static void CopyStageStats(CFHD_StageStats *stats, const TELEMETRY_COUNTER *counter)
+{
+	stats->count = counter->count;
+	stats->totalTime = counter->total_time;
+	stats->maxTime = counter->max_time;
+	memcpy(stats->histogram, counter->histogram, sizeof(stats->histogram));
+}
+
+void ReadTelemetryStats(TELEMETRY *telemetry, struct CFHD_Stats *stats, bool reset)
+{
+	TELEMETRY_DATA data;
+	int index;
+
+	if (stats) {
+		memset(stats, 0, sizeof(CFHD_Stats));
+	}
+
+	// Statistics were never enabled for this decoder or encoder
+	if (telemetry == NULL) {
+		return;
+	}
+
+	ReadTelemetry(telemetry, &data, reset);
+
+	if (stats == NULL) {
+		return;
+	}
+
+	for (index = 0; index < CFHD_STATS_STAGE_COUNT; index++) {
+		CopyStageStats(&stats->stage[index], &data.stage[index]);
+	}
+	for (index = 0; index < CFHD_STATS_MAX_BANDS; index++) {
+		CopyStageStats(&stats->band[index], &data.band[index]);
+	}
+	for (index = 0; index < CFHD_STATS_MAX_LEVELS; index++) {
+		CopyStageStats(&stats->level[index], &data.level[index]);
+	}
+	stats->allocations = data.allocations;
+}
+
+uint64_t TelemetryTime(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER frequency = {0};
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&counter);
+
+	// Split the conversion to avoid overflow of the product
+	return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000 +
+		   (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+#elif __APPLE__
+	static mach_timebase_info_data_t timebase = {0, 0};
+
+	if (timebase.denom == 0) {
+		mach_timebase_info(&timebase);
+	}
+
+	return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+// Add one time to the statistics for a stage
+static void UpdateCounter(TELEMETRY_COUNTER *counter, uint64_t time)
+{
+	uint64_t microseconds = time / 1000;
+	int bin = 0;
+
+	// The bin is the number of bits in the time in microseconds
+	while (microseconds > 0 && bin < TELEMETRY_HISTOGRAM_BINS - 1)
+	{
+		microseconds >>= 1;
+		bin++;
+	}
+
+	counter->count++;
+	counter->total_time += time;
+	if (counter->max_time < time) {
+		counter->max_time = time;
+	}
+	counter->histogram[bin]++;
+}
+
+void RecordTelemetry(TELEMETRY *telemetry, TELEMETRY_STAGE stage, int index, uint64_t start_time)
+{
+	uint64_t stop_time = TelemetryTime();
+	uint64_t time = (stop_time > start_time) ? stop_time - start_time : 0;
+
+	assert(0 <= stage && stage < TELEMETRY_STAGE_COUNT);
+
+	Lock(&telemetry->lock);
+
+	UpdateCounter(&telemetry->data.stage[stage], time);
+
+	if (stage == TELEMETRY_STAGE_ENTROPY && 0 <= index && index < TELEMETRY_MAX_BANDS) {
+		UpdateCounter(&telemetry->data.band[index], time);
+	}
+	else if (stage == TELEMETRY_STAGE_TRANSFORM && 0 <= index && index < TELEMETRY_MAX_LEVELS) {
+		UpdateCounter(&telemetry->data.level[index], time);
+	}
+
+	Unlock(&telemetry->lock);
+}
+
+void CountMemoryAllocation(void)
+{
+#ifdef _WIN32
+	InterlockedIncrement64(&allocation_count);
+#else
+	__sync_fetch_and_add(&allocation_count, 1);
+#endif
+}
+
+uint64_t MemoryAllocationCount(void)
+{
+	return (uint64_t)allocation_count;
+}
+
+void RecordTelemetryAllocations(TELEMETRY *telemetry, uint64_t start_count)
+{
+	uint64_t count = MemoryAllocationCount();
+
+	Lock(&telemetry->lock);
+	telemetry->data.allocations += (count > start_count) ? count - start_count : 0;
+	Unlock(&telemetry->lock);
+}
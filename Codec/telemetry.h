@@ -0,0 +1,160 @@
+/*! @file telemetry.h
+
+*  @brief Per-stage timing statistics for decoding and encoding
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include "thread.h"
+
+/*
+	Unlike the timers in timing.h, the telemetry is compiled into release builds
+	and is kept per decoder or encoder instance.  The codec only records timing
+	if the telemetry pointer in the decoder or encoder is set, so the cost when
+	statistics are not collected is one test of the pointer for each stage.
+*/
+
+// Stages of decoding and encoding that are timed
+typedef enum telemetry_stage
+{
+	TELEMETRY_STAGE_FRAME = 0,		// Decode or encode one sample (all stages)
+	TELEMETRY_STAGE_HEADER,			// Parse or write the sample and channel headers
+	TELEMETRY_STAGE_ENTROPY,		// Entropy decode or encode the bands
+	TELEMETRY_STAGE_TRANSFORM,		// Inverse or forward wavelet transforms
+	TELEMETRY_STAGE_DEMOSAIC,		// Demosaic the Bayer rows into the output frame
+	TELEMETRY_STAGE_COLOR,			// Compute the color processing for the frame
+	TELEMETRY_STAGE_OUTPUT,			// Convert the decoded frame to the output format
+	TELEMETRY_STAGE_WARP,			// Lens correction and framing
+	TELEMETRY_STAGE_INPUT,			// Convert the input frame to the encoded format
+
+	TELEMETRY_STAGE_COUNT			// Number of stages
+} TELEMETRY_STAGE;
+
+#define TELEMETRY_MAX_BANDS			25		// Same as CODEC_MAX_SUBBANDS
+#define TELEMETRY_MAX_LEVELS		8		// Same as TRANSFORM_MAX_WAVELETS
+
+// Number of bins in the histogram of the times for each stage
+#define TELEMETRY_HISTOGRAM_BINS	24
+
+/*
+	Statistics for one stage.  The first histogram bin counts times less than
+	one microsecond and bin n counts times from 2^(n-1) up to 2^n microseconds.
+	The last bin also counts all longer times.
+*/
+typedef struct telemetry_counter
+{
+	uint64_t count;			// Number of times the stage was executed
+	uint64_t total_time;	// Total time in the stage (in nanoseconds)
+	uint64_t max_time;		// Longest time in the stage (in nanoseconds)
+	uint32_t histogram[TELEMETRY_HISTOGRAM_BINS];
+
+} TELEMETRY_COUNTER;
+
+// Statistics for all stages
+typedef struct telemetry_data
+{
+	TELEMETRY_COUNTER stage[TELEMETRY_STAGE_COUNT];
+	TELEMETRY_COUNTER band[TELEMETRY_MAX_BANDS];		// Entropy coding of each subband
+	TELEMETRY_COUNTER level[TELEMETRY_MAX_LEVELS];		// Transform of each wavelet
+	uint64_t allocations;								// Heap allocations while the samples were decoded or encoded
+
+} TELEMETRY_DATA;
+
+// Statistics shared by the threads that decode or encode one sample
+typedef struct telemetry
+{
+	LOCK lock;				// Serializes updates from the worker threads
+	TELEMETRY_DATA data;
+
+} TELEMETRY;
+
+// Statistics in the decoder and encoder interfaces (defined in CFHDTypes.h)
+struct CFHD_Stats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Create the lock and clear the statistics
+void InitTelemetry(TELEMETRY *telemetry);
+
+//! Delete the lock
+void ReleaseTelemetry(TELEMETRY *telemetry);
+
+//! Copy the statistics and optionally clear them
+void ReadTelemetry(TELEMETRY *telemetry, TELEMETRY_DATA *data, bool reset);
+
+/*!
+	@brief Copy the statistics into the data structure returned by the decoder and encoder interfaces
+
+	The statistics are cleared if the telemetry has not been allocated.  The
+	reset flag clears the telemetry after the statistics are copied.
+*/
+void ReadTelemetryStats(TELEMETRY *telemetry, struct CFHD_Stats *stats, bool reset);
+
+//! Return the time from a monotonic clock in nanoseconds
+uint64_t TelemetryTime(void);
+
+/*!
+	@brief Record the time since the start time in the statistics for the stage
+
+	The index selects the subband for the entropy coding stage or the wavelet
+	for the transform stage and is ignored by the other stages.  A negative
+	index only updates the total for the stage.
+*/
+void RecordTelemetry(TELEMETRY *telemetry, TELEMETRY_STAGE stage, int index, uint64_t start_time);
+
+/*!
+	@brief Return the number of heap allocations made by the codec in this process
+
+	The count is incremented by the memory allocation macros in config.h, by
+	the allocation routines in allocator.h (including calls to an allocator
+	provided by the application), by the conversion library allocator, and
+	by the allocation routines and new operators in the decoder and encoder
+	interfaces.  Allocations inside the C++ standard library are not
+	counted.  The count is shared by all decoders and encoders, so the
+	allocations recorded for one sample include the allocations made by other
+	instances that run at the same time.  A decoder or encoder that allocates
+	nothing while decoding or encoding records zero allocations.
+*/
+uint64_t MemoryAllocationCount(void);
+
+//! Add the allocations since the start count to the statistics
+void RecordTelemetryAllocations(TELEMETRY *telemetry, uint64_t start_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Return the start time if statistics are collected for this decoder or encoder
+#define TELEMETRY_START(telemetry)		((telemetry) ? TelemetryTime() : 0)
+
+// Record the time spent in the stage if statistics are collected
+#define TELEMETRY_STOP(telemetry, stage, index, start_time)			\
+	do { if (telemetry) RecordTelemetry(telemetry, stage, index, start_time); } while (0)
+
+// Return the allocation count at the start of a sample if statistics are collected
+#define TELEMETRY_ALLOCATIONS_START(telemetry)	((telemetry) ? MemoryAllocationCount() : 0)
+
+// Record the allocations made while decoding or encoding the sample
+#define TELEMETRY_ALLOCATIONS_STOP(telemetry, start_count)			\
+	do { if (telemetry) RecordTelemetryAllocations(telemetry, start_count); } while (0)
+
+#endif
@@ -29,6 +29,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "threadtrace.h"
+
 #ifdef _WIN32
  #ifdef _DEBUG
   #include <tchar.h>				// For printing debug string in the console window
@@ -668,11 +670,19 @@ typedef struct thread_pool
 	int work_unit_started[THREAD_JOB_LEVELS][THREAD_POOL_MAX];	 // optional usage for threads to determine the
 	int work_unit_completed[THREAD_JOB_LEVELS][THREAD_POOL_MAX]; //status of other threads. -1 if not set
 
+	const char *name;						// Name of the thread procedure (used to label traces)
+	THREAD_TRACE *trace;					// Timeline of the jobs if tracing is active (see threadtrace.h)
+
+	LOCK job_lock;							// Serializes the jobs of the clients that share the pool
+	void *job_param;						// Client parameter of the job that the threads are processing
+
 } THREAD_POOL;
 
 
-// Create a pool of worker threads
-THREAD_API(ThreadPoolCreate)(THREAD_POOL *pool, int count, THREAD_PROC proc, void *param)
+// Create a pool of worker threads (the pool is labeled with the name of the thread procedure in traces)
+#define ThreadPoolCreate(pool, count, proc, param)	ThreadPoolCreateNamed(pool, count, proc, param, #proc)
+
+THREAD_API(ThreadPoolCreateNamed)(THREAD_POOL *pool, int count, THREAD_PROC proc, void *param, const char *name)
 {
 	//THREAD_ERROR error = THREAD_ERROR_OKAY;
 	int i,j;
@@ -685,12 +695,22 @@ THREAD_API(ThreadPoolCreate)(THREAD_POOL *pool, int count, THREAD_PROC proc, voi
 	// Initialize the mutex that controls access to the thread pool data
 	CreateLock(&pool->mutex);
 
+	// Initialize the lock that serializes the jobs submitted to the pool
+	CreateLock(&pool->job_lock);
+
 	// Lock access to the thread pool data during initialization
 	Lock(&pool->mutex);
 
 	// Set the number of threads in the pool
 	pool->thread_count = count;
 
+	// The jobs are processed for the creator of the pool unless another client submits a job
+	pool->job_param = param;
+
+	// The trace is allocated when the pool is given work while tracing is active
+	pool->name = name;
+	pool->trace = NULL;
+
 	// Reset the number of active threads
 	pool->thread_index = 0;
 
@@ -739,6 +759,10 @@ THREAD_API(ThreadPoolSendMessage)(THREAD_POOL *pool, THREAD_MESSAGE message)
 {
 	int i;
 
+	if (pool->trace) {
+		ThreadTraceInstant(pool->trace, THREAD_TRACE_CONTROL, THREAD_TRACE_MESSAGE, message);
+	}
+
 	// Set the message to be received by the worker threads
 	Lock(&pool->mutex);
 	for (i = 0; i < pool->thread_count; i++)
@@ -777,6 +801,8 @@ THREAD_API(ThreadSendMessage)(THREAD_POOL *pool, int thread_index, THREAD_MESSAG
 THREAD_API(ThreadPoolWaitAllDone)(THREAD_POOL *pool)
 {
 	int i;
+	uint64_t start_time = pool->trace ? ThreadTraceTime() : 0;
+
 	for (i = 0; i < pool->thread_count; i++)
 	{
 		// Wait for the worker thread to finish
@@ -786,6 +812,10 @@ THREAD_API(ThreadPoolWaitAllDone)(THREAD_POOL *pool)
 		//ClearEvent(&pool->done_event[i]);
 	}
 
+	if (pool->trace) {
+		ThreadTraceSpan(pool->trace, THREAD_TRACE_CONTROL, THREAD_TRACE_WAIT_DONE, start_time, 0);
+	}
+
 	return THREAD_ERROR_OKAY;
 }
 
@@ -813,6 +843,18 @@ THREAD_API(ThreadPoolSetWorkCount)(THREAD_POOL *pool, int count)
 	int i,j;
 	//return SemaIncrement(&pool->sema, count);
 
+	// The worker threads are idle so the trace can be attached to the pool (or detached after tracing stopped)
+	if (pool->trace == NULL) {
+		pool->trace = ThreadTraceAttach(pool->name, pool->thread_count);
+	}
+	else if (!ThreadTraceActive()) {
+		ThreadTraceDetach(pool->trace);
+		pool->trace = NULL;
+	}
+	if (pool->trace) {
+		ThreadTraceInstant(pool->trace, THREAD_TRACE_CONTROL, THREAD_TRACE_WORK_COUNT, count);
+	}
+
 	// Set the count of units of work and reset the index to the next work unit
 	Lock(&pool->mutex);
 
@@ -847,6 +889,10 @@ THREAD_API(ThreadPoolAddWorkCount)(THREAD_POOL *pool, int count)
 	int j;
 	//return SemaIncrement(&pool->sema, count);
 
+	if (pool->trace) {
+		ThreadTraceInstant(pool->trace, THREAD_TRACE_CONTROL, THREAD_TRACE_ADD_WORK, count);
+	}
+
 	// Set the count of units of work and reset the index to the next work unit
 	Lock(&pool->mutex);
 
@@ -914,6 +960,11 @@ THREAD_API(ThreadPoolDelete)(THREAD_POOL *pool)
 
 	// Delete the mutex that controls access to the thread pool data
 	DeleteLock(&pool->mutex);
+	DeleteLock(&pool->job_lock);
+
+	// Keep the timeline of the pool until the trace is released
+	ThreadTraceDetach(pool->trace);
+	pool->trace = NULL;
 
 	return THREAD_ERROR_OKAY;
 }
@@ -921,6 +972,7 @@ THREAD_API(ThreadPoolDelete)(THREAD_POOL *pool)
 THREAD_API(PoolThreadWaitForMessage)(THREAD_POOL *pool, int thread_index, THREAD_MESSAGE *message_out)
 {
 	THREAD_ERROR error = THREAD_ERROR_OKAY;
+	uint64_t start_time = pool->trace ? ThreadTraceTime() : 0;
 
 	// Wait for the signal for the worker thread to start processing
 	error = EventWait(&pool->start_event[thread_index]);
@@ -935,6 +987,11 @@ THREAD_API(PoolThreadWaitForMessage)(THREAD_POOL *pool, int thread_index, THREAD
 	error = ClearEvent(&pool->start_event[thread_index]);
 	Unlock(&pool->mutex);
 
+	// The trace may have been attached while the thread was waiting
+	if (pool->trace && start_time > 0) {
+		ThreadTraceSpan(pool->trace, thread_index, THREAD_TRACE_IDLE, start_time, *message_out);
+	}
+
 	// Acknowledge the signal to start processing
 	return error;
 }
@@ -943,6 +1000,10 @@ THREAD_API(PoolThreadSignalDone)(THREAD_POOL *pool, int thread_index)
 {
 	THREAD_ERROR error = THREAD_ERROR_OKAY;
 
+	if (pool->trace) {
+		ThreadTraceJobEnd(pool->trace, thread_index);
+	}
+
 	Lock(&pool->mutex);
 	// Return the message that indicates what the thread should do
 	pool->message[thread_index] = THREAD_MESSAGE_NONE;
@@ -1011,7 +1072,16 @@ THREAD_API(PoolThreadGetDependentJob)(THREAD_POOL *pool, int *work_index_out, in
 	}
 
 	//return SemaTryWait(&pool->sema);
-	Lock(&pool->mutex);
+	if (pool->trace)
+	{
+		uint64_t start_time = ThreadTraceTime();
+		Lock(&pool->mutex);
+		ThreadTraceSpan(pool->trace, thread_index, THREAD_TRACE_LOCK, start_time, 0);
+	}
+	else
+	{
+		Lock(&pool->mutex);
+	}
 
 	// Asking for the next job also means the previous job on the same thread was finished
 	if(job_index > 0)
@@ -1030,6 +1100,10 @@ THREAD_API(PoolThreadGetDependentJob)(THREAD_POOL *pool, int *work_index_out, in
 			{
 				error = THREAD_ERROR_NOWORKYET; // this work has been sent out.
 
+				if (pool->trace) {
+					ThreadTraceStall(pool->trace, thread_index, job_index, work_index, pool->work_cmplt[job_index-1]);
+				}
+
 
 				//DAN20090130 -- this code does nothing
 				//if(pool->work_count[job_index-1] == 0)
@@ -1056,6 +1130,11 @@ THREAD_API(PoolThreadGetDependentJob)(THREAD_POOL *pool, int *work_index_out, in
 
 			// Return the index to the next unit of work
 			*work_index_out = work_index;
+
+			if (pool->trace) {
+				ThreadTraceJobBegin(pool->trace, thread_index, job_index, work_index,
+									(job_index > 0) ? pool->work_cmplt[job_index-1] : -1);
+			}
 			
 			// Indicate	that another unit of work is available
 			error = THREAD_ERROR_OKAY;
@@ -1065,6 +1144,10 @@ THREAD_API(PoolThreadGetDependentJob)(THREAD_POOL *pool, int *work_index_out, in
 	{
 		// No more work available
 		error = THREAD_ERROR_NOWORK;
+
+		if (pool->trace) {
+			ThreadTraceJobEnd(pool->trace, thread_index);
+		}
 	}
 
 	Unlock(&pool->mutex);
@@ -1097,4 +1180,46 @@ THREAD_API(PoolThreadGetIndex)(THREAD_POOL *pool, int *thread_index_out)
 	return THREAD_ERROR_OKAY;
 }
 
+/*
+	A pool can be shared by several clients.  Each client brackets the calls
+	that set the work count, start the threads, and wait for the threads to
+	finish with ThreadPoolBeginJob and ThreadPoolEndJob so that the jobs of
+	the clients are not interleaved.  The worker threads call
+	PoolThreadGetJobParam after the start message to obtain the parameter
+	of the client that submitted the job.
+*/
+
+// Obtain exclusive use of the pool for a job submitted by the client
+THREAD_API(ThreadPoolBeginJob)(THREAD_POOL *pool, void *param)
+{
+	Lock(&pool->job_lock);
+
+	Lock(&pool->mutex);
+	pool->job_param = param;
+	Unlock(&pool->mutex);
+
+	return THREAD_ERROR_OKAY;
+}
+
+// Release the pool after the worker threads have finished the job
+THREAD_API(ThreadPoolEndJob)(THREAD_POOL *pool)
+{
+	Unlock(&pool->job_lock);
+	return THREAD_ERROR_OKAY;
+}
+
+// Return the parameter of the client that submitted the job
+THREAD_API(PoolThreadGetJobParam)(THREAD_POOL *pool, void **param_out)
+{
+	if (param_out == NULL) {
+		return THREAD_ERROR_INVALID_ARGUMENT;
+	}
+
+	Lock(&pool->mutex);
+	*param_out = pool->job_param;
+	Unlock(&pool->mutex);
+
+	return THREAD_ERROR_OKAY;
+}
+
 #endif
@@ -0,0 +1,620 @@
+/*! @file threadtrace.c
+
+*  @brief Timelines of the jobs processed by the worker threads in thread pools
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "thread.h"
+#include "telemetry.h"
+#include "threadtrace.h"
+
+
+// One event in the ring buffer for a thread
+typedef struct thread_trace_event
+{
+	uint64_t start_time;		// Time when the event began (in nanoseconds)
+	uint64_t duration;			// Zero for events that have no duration
+	int32_t work_index;			// Unit of work (or -1 if the event is not for a unit of work)
+	int32_t value;				// Completed units of the previous level, work count, or message
+	uint8_t type;				// THREAD_TRACE_TYPE
+	int8_t level;				// Job level for dependent jobs
+
+} THREAD_TRACE_EVENT;
+
+// Ring buffer that is only written by one thread
+typedef struct thread_trace_ring
+{
+	THREAD_TRACE_EVENT *events;
+	volatile uint32_t count;	// Number of events recorded (the ring keeps the most recent)
+	uint32_t first;				// Count when the current trace was started (earlier events are discarded)
+
+	// Unit of work in progress on this thread
+	uint64_t job_start;			// Zero if the thread is not processing a unit of work
+	int job_level;
+	int job_index;
+	int job_completed;
+
+	// Wait for the previous job level in progress on this thread
+	uint64_t stall_start;		// Zero if the thread is not waiting
+	int stall_level;
+	int stall_index;
+	int stall_completed;
+
+} THREAD_TRACE_RING;
+
+struct thread_trace
+{
+	struct thread_trace *next;	// Next trace in the list of all traces
+	char name[64];				// Name of the thread procedure for the pool
+	int serial;					// Distinguishes pools with the same name
+	int thread_count;			// Number of worker threads in the pool
+	uint32_t capacity;			// Number of events in each ring buffer
+	bool retired;				// Set when the pool has been deleted (the rings only hold the recorded events)
+
+	// Ring buffer for each worker thread followed by the controlling thread
+	THREAD_TRACE_RING ring[THREAD_POOL_MAX + 1];
+};
+
+// State shared by all traces (the lock is created by the first call to start tracing)
+static volatile bool trace_active = false;
+static bool trace_lock_created = false;
+static LOCK trace_lock;
+static THREAD_TRACE *trace_list = NULL;
+static uint32_t trace_events = THREAD_TRACE_DEFAULT_EVENTS;
+static uint64_t trace_base_time = 0;
+static int trace_serial = 0;
+
+// Ring buffers released by deleted pools that are reused by the next pools (all have trace_events entries)
+#define THREAD_TRACE_SPARE_MAX		(4 * (THREAD_POOL_MAX + 1))
+static THREAD_TRACE_EVENT *spare_events[THREAD_TRACE_SPARE_MAX];
+static int spare_count = 0;
+
+
+// Return a ring buffer with room for the current number of events per thread (the caller must hold the lock)
+static THREAD_TRACE_EVENT *AllocRingEvents(void)
+{
+	if (spare_count > 0) {
+		return spare_events[--spare_count];
+	}
+
+	return (THREAD_TRACE_EVENT *)malloc(trace_events * sizeof(THREAD_TRACE_EVENT));
+}
+
+// Keep a ring buffer for reuse by a later pool (the caller must hold the lock)
+static void FreeRingEvents(THREAD_TRACE_EVENT *events, uint32_t capacity)
+{
+	if (events != NULL && capacity == trace_events && spare_count < THREAD_TRACE_SPARE_MAX) {
+		spare_events[spare_count++] = events;
+	}
+	else {
+		free(events);
+	}
+}
+
+static void FreeSpareEvents(void)
+{
+	while (spare_count > 0) {
+		free(spare_events[--spare_count]);
+	}
+}
+
+// Discard the events recorded before the trace was started
+static void ResetTrace(THREAD_TRACE *trace)
+{
+	int i;
+
+	// The worker threads may be recording events so the counts are not changed
+	for (i = 0; i <= trace->thread_count; i++) {
+		trace->ring[i].first = trace->ring[i].count;
+	}
+}
+
+// Return the number of recorded events in the ring that belong to the current trace
+static uint32_t RingEventCount(const THREAD_TRACE *trace, const THREAD_TRACE_RING *ring, uint32_t *first_event)
+{
+	uint32_t count = ring->count;
+	uint32_t first = ring->first;
+
+	if (count - first > trace->capacity) {
+		first = count - trace->capacity;
+	}
+
+	*first_event = first;
+	return count - first;
+}
+
+// Copy the recorded events into buffers that are just large enough and release the ring buffers
+static void CompactTrace(THREAD_TRACE *trace)
+{
+	uint32_t capacity = 1;
+	int i;
+
+	for (i = 0; i <= trace->thread_count; i++)
+	{
+		THREAD_TRACE_RING *ring = &trace->ring[i];
+		THREAD_TRACE_EVENT *events = NULL;
+		uint32_t first_event;
+		uint32_t count = RingEventCount(trace, ring, &first_event);
+		uint32_t k;
+
+		if (count > 0)
+		{
+			events = (THREAD_TRACE_EVENT *)malloc(count * sizeof(THREAD_TRACE_EVENT));
+			if (events == NULL) {
+				count = 0;
+			}
+			for (k = 0; k < count; k++) {
+				events[k] = ring->events[(first_event + k) % trace->capacity];
+			}
+		}
+
+		FreeRingEvents(ring->events, trace->capacity);
+		ring->events = events;
+		ring->first = 0;
+		ring->count = count;
+
+		if (capacity < count) {
+			capacity = count;
+		}
+	}
+
+	// The compacted events are not wrapped around
+	trace->capacity = capacity;
+}
+
+static void FreeTrace(THREAD_TRACE *trace)
+{
+	int i;
+
+	for (i = 0; i <= trace->thread_count; i++) {
+		FreeRingEvents(trace->ring[i].events, trace->capacity);
+	}
+
+	free(trace);
+}
+
+// Free the traces for pools that have been deleted (the caller must hold the lock)
+static void FreeRetiredTraces(void)
+{
+	THREAD_TRACE **link = &trace_list;
+
+	while (*link)
+	{
+		THREAD_TRACE *trace = *link;
+		if (trace->retired) {
+			*link = trace->next;
+			FreeTrace(trace);
+		}
+		else {
+			link = &trace->next;
+		}
+	}
+}
+
+bool ThreadTraceStart(uint32_t events_per_thread)
+{
+	THREAD_TRACE *trace;
+
+	if (!trace_lock_created) {
+		CreateLock(&trace_lock);
+		trace_lock_created = true;
+	}
+
+	Lock(&trace_lock);
+
+	// Discard the events from the previous trace
+	FreeRetiredTraces();
+	for (trace = trace_list; trace != NULL; trace = trace->next) {
+		ResetTrace(trace);
+	}
+
+	// The spare ring buffers cannot be reused if the number of events changed
+	events_per_thread = (events_per_thread > 0) ? events_per_thread : THREAD_TRACE_DEFAULT_EVENTS;
+	if (trace_events != events_per_thread) {
+		FreeSpareEvents();
+	}
+
+	trace_events = events_per_thread;
+	trace_base_time = ThreadTraceTime();
+	trace_active = true;
+
+	Unlock(&trace_lock);
+
+	return true;
+}
+
+void ThreadTraceStop(void)
+{
+	trace_active = false;
+}
+
+void ThreadTraceRelease(void)
+{
+	if (!trace_lock_created) {
+		return;
+	}
+
+	Lock(&trace_lock);
+	FreeRetiredTraces();
+	FreeSpareEvents();
+	Unlock(&trace_lock);
+}
+
+bool ThreadTraceActive(void)
+{
+	return trace_active;
+}
+
+uint64_t ThreadTraceTime(void)
+{
+	return TelemetryTime();
+}
+
+THREAD_TRACE *ThreadTraceAttach(const char *name, int thread_count)
+{
+	THREAD_TRACE *trace;
+	int i;
+
+	if (!trace_active) {
+		return NULL;
+	}
+
+	assert(0 < thread_count && thread_count <= THREAD_POOL_MAX);
+
+	trace = (THREAD_TRACE *)calloc(1, sizeof(THREAD_TRACE));
+	if (trace == NULL) {
+		return NULL;
+	}
+
+	Lock(&trace_lock);
+
+	trace->thread_count = thread_count;
+	trace->capacity = trace_events;
+	trace->serial = trace_serial++;
+	strncpy(trace->name, (name != NULL) ? name : "pool", sizeof(trace->name) - 1);
+
+	for (i = 0; i <= thread_count; i++)
+	{
+		trace->ring[i].events = AllocRingEvents();
+		if (trace->ring[i].events == NULL) {
+			FreeTrace(trace);
+			Unlock(&trace_lock);
+			return NULL;
+		}
+	}
+
+	trace->next = trace_list;
+	trace_list = trace;
+
+	Unlock(&trace_lock);
+
+	return trace;
+}
+
+void ThreadTraceDetach(THREAD_TRACE *trace)
+{
+	if (trace == NULL) {
+		return;
+	}
+
+	// Only keep the recorded events so that short lived pools do not hold full ring buffers
+	Lock(&trace_lock);
+	CompactTrace(trace);
+	trace->retired = true;
+	Unlock(&trace_lock);
+}
+
+// Return the ring buffer for the thread or NULL if events are not being recorded
+static THREAD_TRACE_RING *GetRing(THREAD_TRACE *trace, int thread_index)
+{
+	if (!trace_active) {
+		return NULL;
+	}
+
+	if (thread_index == THREAD_TRACE_CONTROL) {
+		return &trace->ring[trace->thread_count];
+	}
+
+	if (thread_index < 0 || thread_index >= trace->thread_count) {
+		return NULL;
+	}
+
+	return &trace->ring[thread_index];
+}
+
+static void RecordEvent(THREAD_TRACE *trace, THREAD_TRACE_RING *ring, THREAD_TRACE_TYPE type,
+						uint64_t start_time, uint64_t stop_time, int level, int work_index, int value)
+{
+	THREAD_TRACE_EVENT *event = &ring->events[ring->count % trace->capacity];
+
+	event->start_time = start_time;
+	event->duration = (stop_time > start_time) ? stop_time - start_time : 0;
+	event->work_index = work_index;
+	event->value = value;
+	event->type = (uint8_t)type;
+	event->level = (int8_t)level;
+
+	// The count is only changed by the thread that owns the ring
+	ring->count = ring->count + 1;
+}
+
+// Record the unit of work and the wait for the previous level that are in progress
+static void FinishEvents(THREAD_TRACE *trace, THREAD_TRACE_RING *ring, uint64_t time)
+{
+	if (ring->job_start > 0)
+	{
+		RecordEvent(trace, ring, THREAD_TRACE_JOB, ring->job_start, time,
+					ring->job_level, ring->job_index, ring->job_completed);
+		ring->job_start = 0;
+	}
+
+	if (ring->stall_start > 0)
+	{
+		RecordEvent(trace, ring, THREAD_TRACE_DEPENDENCY, ring->stall_start, time,
+					ring->stall_level, ring->stall_index, ring->stall_completed);
+		ring->stall_start = 0;
+	}
+}
+
+void ThreadTraceJobBegin(THREAD_TRACE *trace, int thread_index, int level, int work_index, int completed)
+{
+	THREAD_TRACE_RING *ring = GetRing(trace, thread_index);
+	uint64_t time;
+
+	if (ring == NULL) {
+		return;
+	}
+
+	time = ThreadTraceTime();
+	FinishEvents(trace, ring, time);
+
+	ring->job_start = time;
+	ring->job_level = level;
+	ring->job_index = work_index;
+	ring->job_completed = completed;
+}
+
+void ThreadTraceJobEnd(THREAD_TRACE *trace, int thread_index)
+{
+	THREAD_TRACE_RING *ring = GetRing(trace, thread_index);
+
+	if (ring == NULL) {
+		return;
+	}
+
+	FinishEvents(trace, ring, ThreadTraceTime());
+}
+
+void ThreadTraceStall(THREAD_TRACE *trace, int thread_index, int level, int work_index, int completed)
+{
+	THREAD_TRACE_RING *ring = GetRing(trace, thread_index);
+	uint64_t time;
+
+	if (ring == NULL) {
+		return;
+	}
+
+	time = ThreadTraceTime();
+
+	// The thread may poll many times before the previous level catches up
+	if (ring->job_start > 0)
+	{
+		RecordEvent(trace, ring, THREAD_TRACE_JOB, ring->job_start, time,
+					ring->job_level, ring->job_index, ring->job_completed);
+		ring->job_start = 0;
+	}
+
+	if (ring->stall_start == 0 || ring->stall_level != level || ring->stall_index != work_index)
+	{
+		if (ring->stall_start > 0) {
+			RecordEvent(trace, ring, THREAD_TRACE_DEPENDENCY, ring->stall_start, time,
+						ring->stall_level, ring->stall_index, ring->stall_completed);
+		}
+
+		ring->stall_start = time;
+		ring->stall_level = level;
+		ring->stall_index = work_index;
+	}
+
+	ring->stall_completed = completed;
+}
+
+void ThreadTraceSpan(THREAD_TRACE *trace, int thread_index, THREAD_TRACE_TYPE type, uint64_t start_time, int value)
+{
+	THREAD_TRACE_RING *ring = GetRing(trace, thread_index);
+	uint64_t time;
+
+	if (ring == NULL) {
+		return;
+	}
+
+	time = ThreadTraceTime();
+
+	if (type == THREAD_TRACE_LOCK && time - start_time < THREAD_TRACE_LOCK_THRESHOLD) {
+		return;
+	}
+
+	RecordEvent(trace, ring, type, start_time, time, -1, -1, value);
+}
+
+void ThreadTraceInstant(THREAD_TRACE *trace, int thread_index, THREAD_TRACE_TYPE type, int value)
+{
+	THREAD_TRACE_RING *ring = GetRing(trace, thread_index);
+	uint64_t time;
+
+	if (ring == NULL) {
+		return;
+	}
+
+	time = ThreadTraceTime();
+	RecordEvent(trace, ring, type, time, time, -1, -1, value);
+}
+
+// Convert a time in nanoseconds to microseconds since the start of the trace
+static double TraceMicroseconds(uint64_t time)
+{
+	return (time > trace_base_time) ? (double)(time - trace_base_time) / 1000.0 : 0.0;
+}
+
+static void WriteEvent(FILE *file, const THREAD_TRACE_EVENT *event, int tid)
+{
+	const char *separator = ",\n";
+	double ts = TraceMicroseconds(event->start_time);
+	double dur = (double)event->duration / 1000.0;
+
+	// Clip the events that were in progress when the trace was started
+	if (event->start_time < trace_base_time)
+	{
+		uint64_t stop_time = event->start_time + event->duration;
+		dur = (stop_time > trace_base_time) ? (double)(stop_time - trace_base_time) / 1000.0 : 0.0;
+	}
+
+	switch (event->type)
+	{
+	case THREAD_TRACE_JOB:
+		fprintf(file, "%s{\"name\":\"level %d\",\"cat\":\"job\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"work_index\":%d,\"previous_completed\":%d}}",
+				separator, event->level, tid, ts, dur, event->work_index, event->value);
+		break;
+
+	case THREAD_TRACE_DEPENDENCY:
+		fprintf(file, "%s{\"name\":\"wait for level %d\",\"cat\":\"wait\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"work_index\":%d,\"previous_completed\":%d}}",
+				separator, event->level - 1, tid, ts, dur, event->work_index, event->value);
+		break;
+
+	case THREAD_TRACE_LOCK:
+		fprintf(file, "%s{\"name\":\"lock\",\"cat\":\"wait\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"dur\":%.3f}",
+				separator, tid, ts, dur);
+		break;
+
+	case THREAD_TRACE_IDLE:
+		fprintf(file, "%s{\"name\":\"idle\",\"cat\":\"wait\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"message\":%d}}",
+				separator, tid, ts, dur, event->value);
+		break;
+
+	case THREAD_TRACE_WAIT_DONE:
+		fprintf(file, "%s{\"name\":\"wait for workers\",\"cat\":\"wait\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"dur\":%.3f}",
+				separator, tid, ts, dur);
+		break;
+
+	case THREAD_TRACE_WORK_COUNT:
+		fprintf(file, "%s{\"name\":\"set work count\",\"cat\":\"control\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"args\":{\"count\":%d}}",
+				separator, tid, ts, event->value);
+		break;
+
+	case THREAD_TRACE_ADD_WORK:
+		fprintf(file, "%s{\"name\":\"add work\",\"cat\":\"control\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"args\":{\"count\":%d}}",
+				separator, tid, ts, event->value);
+		break;
+
+	case THREAD_TRACE_MESSAGE:
+		fprintf(file, "%s{\"name\":\"send message\",\"cat\":\"control\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"args\":{\"message\":%d}}",
+				separator, tid, ts, event->value);
+		break;
+
+	default:
+		assert(0);
+		break;
+	}
+}
+
+static void WriteThreadName(FILE *file, const THREAD_TRACE *trace, int thread_index, int tid)
+{
+	const char *separator = ",\n";
+
+	if (thread_index == trace->thread_count) {
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+				"\"args\":{\"name\":\"%s %d control\"}}",
+				separator, tid, trace->name, trace->serial);
+	}
+	else {
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+				"\"args\":{\"name\":\"%s %d worker %d\"}}",
+				separator, tid, trace->name, trace->serial, thread_index);
+	}
+
+	fprintf(file, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+			"\"args\":{\"sort_index\":%d}}", tid, tid);
+}
+
+/*!
+	Events recorded while the trace is written may be partially written, so the
+	trace should be written after tracing is stopped or when the pools are idle.
+	Each pool is listed as a group of threads with the control thread first.
+*/
+bool ThreadTraceWrite(FILE *file)
+{
+	THREAD_TRACE *trace;
+
+	if (file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CineForm\"}}");
+
+	if (trace_lock_created)
+	{
+		Lock(&trace_lock);
+
+		for (trace = trace_list; trace != NULL; trace = trace->next)
+		{
+			int i;
+
+			for (i = 0; i <= trace->thread_count; i++)
+			{
+				const THREAD_TRACE_RING *ring = &trace->ring[i];
+				uint32_t first_event;
+				uint32_t count = RingEventCount(trace, ring, &first_event);
+				uint32_t k;
+
+				// The control thread is listed before the worker threads in the pool
+				int tid = trace->serial * (THREAD_POOL_MAX + 2) + ((i == trace->thread_count) ? 1 : i + 2);
+
+				if (count == 0) {
+					continue;
+				}
+
+				WriteThreadName(file, trace, i, tid);
+
+				for (k = 0; k < count; k++) {
+					WriteEvent(file, &ring->events[(first_event + k) % trace->capacity], tid);
+				}
+			}
+		}
+
+		Unlock(&trace_lock);
+	}
+
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	return (ferror(file) == 0);
+}
@@ -0,0 +1,131 @@
+/*! @file threadtrace.h
+
+*  @brief Timelines of the jobs processed by the worker threads in thread pools
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _THREADTRACE_H
+#define _THREADTRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+	The thread pool routines in thread.h record when each worker thread starts
+	and finishes a unit of work, how long it waits for a dependent job level or
+	for the pool mutex, and how long the controlling thread waits for the pool
+	to finish.  The events are written to a ring buffer for each thread in the
+	pool that only that thread writes, so recording does not take a lock.  The
+	controlling thread (the thread that sets the work count and waits for the
+	workers) has its own ring buffer.
+
+	Tracing is off by default.  A pool only allocates the ring buffers when it
+	is given work while tracing is active, so the cost when tracing is off is
+	one test of the trace pointer in the pool for each call.  The events are
+	written in the Chrome trace event format that can be opened in Perfetto
+	or in chrome://tracing.
+*/
+
+// Types of events recorded in the ring buffers
+typedef enum thread_trace_type
+{
+	THREAD_TRACE_JOB = 0,			// Worker processed one unit of work
+	THREAD_TRACE_DEPENDENCY,		// Worker waited for the previous job level
+	THREAD_TRACE_LOCK,				// Thread waited for the pool mutex
+	THREAD_TRACE_IDLE,				// Worker waited for a message from the pool
+	THREAD_TRACE_WAIT_DONE,			// Controlling thread waited for the workers to finish
+	THREAD_TRACE_WORK_COUNT,		// Controlling thread set the number of units of work
+	THREAD_TRACE_ADD_WORK,			// Controlling thread added units of work
+	THREAD_TRACE_MESSAGE,			// Controlling thread sent a message to the workers
+
+	THREAD_TRACE_TYPE_COUNT
+
+} THREAD_TRACE_TYPE;
+
+// Thread index for the events recorded by the controlling thread
+#define THREAD_TRACE_CONTROL			(-1)
+
+// Default number of events kept for each thread
+#define THREAD_TRACE_DEFAULT_EVENTS		16384
+
+// Lock waits shorter than this (in nanoseconds) are not recorded
+#define THREAD_TRACE_LOCK_THRESHOLD		2000
+
+typedef struct thread_trace THREAD_TRACE;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+	@brief Start recording the timelines of the thread pools
+
+	The events recorded by earlier traces are discarded.  Each thread keeps the
+	most recent events_per_thread events (or the default if zero).  Must not be
+	called at the same time as another call to start tracing.
+*/
+bool ThreadTraceStart(uint32_t events_per_thread);
+
+//! Stop recording events (the recorded events are kept until the trace is released)
+void ThreadTraceStop(void);
+
+//! Write the recorded events in the Chrome trace event format
+bool ThreadTraceWrite(FILE *file);
+
+//! Free the events recorded by pools that have been deleted
+void ThreadTraceRelease(void);
+
+//! Return true if events are being recorded
+bool ThreadTraceActive(void);
+
+//! Return the trace for a pool if tracing is active (called by the thread pool)
+THREAD_TRACE *ThreadTraceAttach(const char *name, int thread_count);
+
+/*!
+	@brief Keep the events recorded by a pool until the trace is released
+
+	Called when the pool is deleted or when the pool is given work after
+	tracing has stopped.  The recorded events are copied out and the ring
+	buffers are reused by the next pools that attach a trace.
+*/
+void ThreadTraceDetach(THREAD_TRACE *trace);
+
+//! Return the time used for the events in nanoseconds
+uint64_t ThreadTraceTime(void);
+
+//! Record the start of a unit of work (ends the previous unit of work on the thread)
+void ThreadTraceJobBegin(THREAD_TRACE *trace, int thread_index, int level, int work_index, int completed);
+
+//! Record the end of the unit of work in progress on the thread
+void ThreadTraceJobEnd(THREAD_TRACE *trace, int thread_index);
+
+//! Record that the next unit of work is waiting for the previous job level
+void ThreadTraceStall(THREAD_TRACE *trace, int thread_index, int level, int work_index, int completed);
+
+//! Record an event that began at the start time and ends now
+void ThreadTraceSpan(THREAD_TRACE *trace, int thread_index, THREAD_TRACE_TYPE type, uint64_t start_time, int value);
+
+//! Record an event that has no duration
+void ThreadTraceInstant(THREAD_TRACE *trace, int thread_index, THREAD_TRACE_TYPE type, int value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -104,6 +104,11 @@ bool GenerateThumbnail(void *sample_ptr,
 				int q_width = ((header.width+7)/8)*2;
 				int q_height = ((header.height+7)/8)*2;
 				int q_pitch = q_width * 4; 
+
+				// The thumbnail is every other pixel in the quarter resolution frame
+				if (output_size < (size_t)(q_width/2) * (q_height/2) * 4) {
+					return false;
+				}
 #ifdef __APPLE__
 				uint8_t *buffer = malloc(q_pitch * q_height);
 #else
@@ -215,6 +220,11 @@ bool GenerateThumbnail(void *sample_ptr,
 							rgb = ((r<<22)|(g<<12)|(b<<2));
 							*(optr++) = _bswap(rgb);
 
+							// Do not write past the end of rows with an odd width
+							if (x + 1 == width) {
+								continue;
+							}
+
 							r = (1192*y2 + 1836*u1)>>10;
 							g = (1192*y2 - 547*u1 - 218*v1)>>10;
 							b = (1192*y2 + 2166*v1)>>10;
@@ -444,6 +454,11 @@ bool GenerateThumbnail(void *sample_ptr,
 							rgb = ((r1<<22)|(g1<<12)|(b1<<2));
 							*(optr++) = _bswap(rgb);
 
+							// Do not write past the end of rows with an odd width
+							if (x + 1 == width) {
+								continue;
+							}
+
 							rgb = ((r2<<22)|(g2<<12)|(b2<<2));
 							*(optr++) = _bswap(rgb);
 						}
@@ -0,0 +1,493 @@
+/*! @file validate.c
+
+*  @brief Check the structure of encoded samples without decoding them
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "config.h"
+#include "codec.h"
+#include "encoder.h"
+#include "swap.h"
+#include "validate.h"
+
+/*
+	The sample is checked one tag at a time.  The band data is never read
+	except for the band header and trailer tags at the ends of each band chunk,
+	so the time to check a sample depends on the number of bands and not on the
+	amount of entropy coded data.
+*/
+
+// State of the sample while it is checked
+typedef struct validate_state
+{
+	const uint8_t *sample;				// Sample that is checked
+	size_t sample_size;					// Size of the sample (in bytes)
+
+	int num_channels;					// Number of channels from the sample header
+	int num_subbands;					// Number of subbands in each channel
+	bool uncompressed;					// The sample contains uncompressed image data
+
+	uint32_t index[CODEC_MAX_CHANNELS];	// Channel sizes from the sample index
+	int index_count;					// Number of channel sizes in the index
+
+	int channel;						// Current channel (-1 between channels)
+	int next_channel;					// Number of the channel that starts next
+	size_t channel_start;				// Offset to the start of the current channel
+	int channel_count;					// Number of channels found in the sample
+
+	int subband;						// Last subband found in the current channel
+	int subband_count;					// Number of subbands found in the current channel
+
+	int lowpass_width;					// Dimensions and precision of the lowpass band
+	int lowpass_height;
+	int pixel_depth;
+
+	int highpass_width;					// Dimensions of the bands in the current wavelet
+	int highpass_height;
+
+	size_t chunk_end[NESTING_LEVELS];	// Offsets to the ends of the enclosing size chunks
+	int chunk_depth;
+
+} VALIDATE_STATE;
+
+
+// Read the tag value pair at the specified location in the sample
+static INLINE void GetValidateSegment(const uint8_t *ptr, int *tag_out, int *value_out)
+{
+	uint32_t segment = SwapInt32BtoN(*((uint32_t *)ptr));
+	int tag = (int16_t)(segment >> 16);
+
+	// Optional tags are identified by their magnitude
+	*tag_out = (tag < 0) ? NEG(tag) : tag;
+	*value_out = (segment & CODEC_TAG_MASK);
+}
+
+// Return true if the chunk ends inside the sample and inside the enclosing chunk
+static bool IsChunkNested(VALIDATE_STATE *state, size_t chunk_end)
+{
+	if (chunk_end > state->sample_size) {
+		return false;
+	}
+
+	if (state->chunk_depth > 0 && chunk_end > state->chunk_end[state->chunk_depth - 1]) {
+		return false;
+	}
+
+	return true;
+}
+
+// Start a new channel at the lowpass band
+static CODEC_ERROR StartValidateChannel(VALIDATE_STATE *state, size_t offset)
+{
+	if (state->channel >= 0 || state->next_channel != state->channel_count) {
+		return CODEC_ERROR_DECODE_SAMPLE_CHANNEL_HEADER;
+	}
+
+	state->channel = state->next_channel;
+	state->channel_start = offset;
+	state->subband = -1;
+	state->subband_count = 0;
+
+	return CODEC_ERROR_OKAY;
+}
+
+// Check that the channel that ends at the specified offset is complete
+static CODEC_ERROR FinishValidateChannel(VALIDATE_STATE *state, size_t offset)
+{
+	int channel = state->channel;
+
+	if (channel < 0) {
+		return CODEC_ERROR_OKAY;
+	}
+
+	// Every subband must be present in the channel
+	if (state->num_subbands > 0 && state->subband_count != state->num_subbands) {
+		return CODEC_ERROR_NUM_SUBBANDS;
+	}
+
+	// The channel size in the index must match the channel in the sample
+	if (channel < state->index_count && state->index[channel] != offset - state->channel_start) {
+		return CODEC_ERROR_SAMPLE_INDEX;
+	}
+
+	state->channel = -1;
+	state->channel_count++;
+
+	return CODEC_ERROR_OKAY;
+}
+
+// Record the next subband in the current channel
+static CODEC_ERROR NextValidateSubband(VALIDATE_STATE *state, int subband)
+{
+	if (state->channel < 0) {
+		return CODEC_ERROR_BAND_NUMBER;
+	}
+
+	// The empty temporal highpass band written by the encoder is not a numbered subband
+	if (subband == 255) {
+		return CODEC_ERROR_OKAY;
+	}
+
+	if (subband <= state->subband) {
+		return CODEC_ERROR_BAND_NUMBER;
+	}
+
+	if (subband >= CODEC_MAX_SUBBANDS || (state->num_subbands > 0 && subband >= state->num_subbands)) {
+		return CODEC_ERROR_BAND_NUMBER;
+	}
+
+	state->subband = subband;
+	state->subband_count++;
+
+	return CODEC_ERROR_OKAY;
+}
+
+// Check a highpass band and advance the offset past the band
+static CODEC_ERROR ValidateHighpassBand(VALIDATE_STATE *state, size_t *offset)
+{
+	const uint8_t *sample = state->sample;
+	size_t position = *offset + 4;
+	size_t chunk_start = 0;
+	size_t band_end = 0;
+	int width = 0;
+	int height = 0;
+	int subband = -1;
+	int encoding = 0;
+	int tag, value;
+	CODEC_ERROR error;
+
+	// Parse the band header that precedes the band data
+	for (;;)
+	{
+		if (position + 4 > state->sample_size) {
+			*offset = position;
+			return CODEC_ERROR_INVALID_BITSTREAM;
+		}
+
+		GetValidateSegment(sample + position, &tag, &value);
+		position += 4;
+
+		if ((tag & 0xFF00) == CODEC_TAG_SUBBAND_SIZE) {
+			chunk_start = position;
+			band_end = position + ((((tag & 0xFF) << 16) | value) * 4);
+			break;
+		}
+
+		switch (tag)
+		{
+		case CODEC_TAG_BAND_WIDTH:		width = value;		break;
+		case CODEC_TAG_BAND_HEIGHT:		height = value;		break;
+		case CODEC_TAG_BAND_SUBBAND:	subband = value;	break;
+		case CODEC_TAG_BAND_ENCODING:	encoding = value;	break;
+
+		case CODEC_TAG_MARKER:
+		case CODEC_TAG_INDEX:
+		case CODEC_TAG_SAMPLE:
+		case CODEC_TAG_CHANNEL:
+			// The band header is not followed by the band data
+			*offset = position - 4;
+			return CODEC_ERROR_INVALID_BITSTREAM;
+
+		default:
+			break;
+		}
+	}
+
+	error = NextValidateSubband(state, subband);
+	if (error != CODEC_ERROR_OKAY) {
+		return error;
+	}
+
+	// The band must have the dimensions of the highpass bands in the wavelet
+	if (width != state->highpass_width || height != state->highpass_height) {
+		return CODEC_ERROR_HIGHPASS_BANDS;
+	}
+
+	*offset = chunk_start - 4;
+	if (!IsChunkNested(state, band_end)) {
+		return CODEC_ERROR_INVALID_BITSTREAM;
+	}
+
+	// Check the tags at both ends of the entropy coded data
+	if (encoding == BAND_ENCODING_RUNLENGTHS)
+	{
+		if (band_end < chunk_start + 8) {
+			return CODEC_ERROR_INVALID_BITSTREAM;
+		}
+
+		GetValidateSegment(sample + chunk_start, &tag, &value);
+		if (tag != CODEC_TAG_BAND_HEADER) {
+			return CODEC_ERROR_BAND_START_MARKER;
+		}
+
+		GetValidateSegment(sample + band_end - 4, &tag, &value);
+		if (tag != CODEC_TAG_BAND_TRAILER) {
+			return CODEC_ERROR_BAND_END_MARKER;
+		}
+	}
+
+	// The peak table for the band follows the band trailer
+	if (band_end + 4 <= state->sample_size)
+	{
+		GetValidateSegment(sample + band_end, &tag, &value);
+		if (tag == CODEC_TAG_PEAK_TABLE)
+		{
+			*offset = band_end;
+			band_end += 4 + value * 4;
+			if (!IsChunkNested(state, band_end)) {
+				return CODEC_ERROR_INVALID_BITSTREAM;
+			}
+		}
+	}
+
+	*offset = band_end;
+
+	return CODEC_ERROR_OKAY;
+}
+
+// Check the size of the lowpass band against its dimensions and precision
+static CODEC_ERROR ValidateLowpassBand(VALIDATE_STATE *state, size_t chunk_size)
+{
+	uint64_t bits = (uint64_t)state->lowpass_width * state->lowpass_height * state->pixel_depth;
+
+	if (state->channel < 0) {
+		return CODEC_ERROR_DECODE_SAMPLE_CHANNEL_HEADER;
+	}
+
+	if ((uint64_t)chunk_size * 8 < bits) {
+		return CODEC_ERROR_INVALID_BITSTREAM;
+	}
+
+	return CODEC_ERROR_OKAY;
+}
+
+CODEC_ERROR ValidateSample(void *sample_ptr,
+						   size_t sample_size,
+						   size_t *error_offset_out)
+{
+	VALIDATE_STATE state;
+	CODEC_ERROR error = CODEC_ERROR_OKAY;
+	size_t offset = 0;
+	bool trailer = false;
+	int i;
+
+	if (sample_ptr == NULL) {
+		return CODEC_ERROR_NULLPTR;
+	}
+
+	memset(&state, 0, sizeof(state));
+	state.sample = (const uint8_t *)sample_ptr;
+	state.sample_size = sample_size;
+	state.channel = -1;
+
+	while (offset + 4 <= sample_size)
+	{
+		size_t size = 4;
+		int tag, value;
+
+		GetValidateSegment(state.sample + offset, &tag, &value);
+
+		if (tag == CODEC_TAG_MARKER && offset + 8 <= sample_size)
+		{
+			int next_tag, next_value;
+
+			GetValidateSegment(state.sample + offset + 4, &next_tag, &next_value);
+			if (next_tag == CODEC_TAG_BAND_NUMBER)
+			{
+				error = ValidateHighpassBand(&state, &offset);
+				size = 0;
+			}
+			else if (next_tag == CODEC_TAG_LOWPASS_SUBBAND)
+			{
+				// Each channel starts with the lowpass band
+				error = StartValidateChannel(&state, offset);
+			}
+		}
+		else if (tag & CODEC_TAG_CHUNK)
+		{
+			// Skip metadata and other custom chunks
+			if ((tag & CODEC_TAG_CUSTOM_CHUNK24BIT) == CODEC_TAG_CUSTOM_CHUNK24BIT) {
+				size += (((tag & 0xFF) << 16) | value) * 4;
+			}
+			else {
+				size += value * 4;
+			}
+
+			if (!IsChunkNested(&state, offset + size)) {
+				error = CODEC_ERROR_INVALID_BITSTREAM;
+			}
+		}
+		else if (tag & CODEC_TAG_CHUNK24BIT)
+		{
+			size_t chunk_size = (((tag & 0xFF) << 16) | value) * 4;
+
+			if (!IsChunkNested(&state, offset + 4 + chunk_size)) {
+				error = CODEC_ERROR_INVALID_BITSTREAM;
+			}
+			else switch (tag & 0xFF00)
+			{
+			case CODEC_TAG_SUBBAND_SIZE:
+				// Highpass bands are handled with the band header so this is the lowpass band
+				error = ValidateLowpassBand(&state, chunk_size);
+				size += chunk_size;
+				break;
+
+			case CODEC_TAG_UNCOMPRESS:
+				// The channels are not encoded in the usual way
+				state.uncompressed = true;
+				size += chunk_size;
+				break;
+
+			default:
+				// Check the tags inside level and sample size chunks
+				if (state.chunk_depth == NESTING_LEVELS) {
+					error = CODEC_ERROR_INVALID_BITSTREAM;
+					break;
+				}
+				state.chunk_end[state.chunk_depth++] = offset + 4 + chunk_size;
+				break;
+			}
+		}
+		else switch (tag)
+		{
+		case CODEC_TAG_INDEX:
+			if (value > CODEC_MAX_CHANNELS) {
+				error = CODEC_ERROR_SAMPLE_INDEX;
+				break;
+			}
+			size += value * 4;
+			if (offset + size > sample_size) {
+				error = CODEC_ERROR_INVALID_BITSTREAM;
+				break;
+			}
+			for (i = 0; i < value; i++) {
+				state.index[i] = SwapInt32BtoN(*((uint32_t *)(state.sample + offset + 4 + i * 4)));
+			}
+			state.index_count = value;
+			break;
+
+		case CODEC_TAG_NUM_CHANNELS:
+			if (value < 1 || value > CODEC_MAX_CHANNELS) {
+				error = CODEC_ERROR_NUM_CHANNELS;
+			}
+			state.num_channels = value;
+			break;
+
+		case CODEC_TAG_NUM_SUBBANDS:
+			if (value < 1 || value > CODEC_MAX_SUBBANDS) {
+				error = CODEC_ERROR_NUM_SUBBANDS;
+			}
+			state.num_subbands = value;
+			break;
+
+		case CODEC_TAG_LOWPASS_SUBBAND:
+			error = NextValidateSubband(&state, value);
+			break;
+
+		case CODEC_TAG_LOWPASS_WIDTH:		state.lowpass_width = value;	break;
+		case CODEC_TAG_LOWPASS_HEIGHT:		state.lowpass_height = value;	break;
+		case CODEC_TAG_PIXEL_DEPTH:			state.pixel_depth = value;		break;
+		case CODEC_TAG_HIGHPASS_WIDTH:		state.highpass_width = value;	break;
+		case CODEC_TAG_HIGHPASS_HEIGHT:		state.highpass_height = value;	break;
+
+		case CODEC_TAG_SAMPLE:
+			// The channel ends at the header for the next channel
+			error = FinishValidateChannel(&state, offset);
+			break;
+
+		case CODEC_TAG_CHANNEL:
+			state.next_channel = value;
+			break;
+
+		case CODEC_TAG_FRAME_TRAILER:
+		case CODEC_TAG_GROUP_TRAILER:
+			// Data after the trailer (such as an appended thumbnail) is not checked
+			error = FinishValidateChannel(&state, offset);
+			trailer = true;
+			break;
+
+		default:
+			break;
+		}
+
+		if (error != CODEC_ERROR_OKAY || trailer) {
+			break;
+		}
+
+		offset += size;
+
+		// Pop the size chunks that end at this point in the sample
+		while (state.chunk_depth > 0 && offset >= state.chunk_end[state.chunk_depth - 1])
+		{
+			if (offset > state.chunk_end[state.chunk_depth - 1]) {
+				// The last tag crossed the end of the chunk
+				error = CODEC_ERROR_INVALID_BITSTREAM;
+				break;
+			}
+			state.chunk_depth--;
+		}
+
+		if (error != CODEC_ERROR_OKAY) {
+			break;
+		}
+	}
+
+	if (error == CODEC_ERROR_OKAY && !trailer)
+	{
+		// A sample without a trailer must end with the last size chunk
+		if (state.chunk_depth > 0) {
+			error = CODEC_ERROR_INVALID_BITSTREAM;
+		}
+		else {
+			error = FinishValidateChannel(&state, offset);
+		}
+	}
+
+	if (error == CODEC_ERROR_OKAY && !state.uncompressed && state.num_channels > 0)
+	{
+		// Every channel in the sample header and the index must be present
+		if (state.channel_count != state.num_channels ||
+			(state.index_count > 0 && state.index_count != state.num_channels)) {
+			error = CODEC_ERROR_NUM_CHANNELS;
+		}
+	}
+
+	if (error != CODEC_ERROR_OKAY && error_offset_out != NULL) {
+		*error_offset_out = offset;
+	}
+
+	return error;
+}
+
+uint32_t ComputeSampleCRC(void *sample_ptr, size_t sample_size)
+{
+	unsigned char *buffer = (unsigned char *)sample_ptr;
+	uint32_t crc = 0xFFFFFFFF;
+
+	// The encoder CRC routine takes the length as an integer
+	while (sample_size > 0)
+	{
+		int length = (sample_size > 0x40000000) ? 0x40000000 : (int)sample_size;
+
+		crc = update_crcA(crc, buffer, length);
+		buffer += length;
+		sample_size -= length;
+	}
+
+	return crc ^ 0xFFFFFFFF;
+}
@@ -0,0 +1,54 @@
+/*! @file validate.h
+
+*  @brief Check the structure of encoded samples without decoding them
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _VALIDATE_H
+#define _VALIDATE_H
+
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+	@brief Check that a sample is well formed without entropy decoding the bands
+
+	The tags are parsed using the size chunks to skip the band data.  The chunks
+	must be nested inside the sample, the channel sizes in the sample index must
+	match the channels in the sample, each channel must contain every subband in
+	order, and each band must have the dimensions of its wavelet and start with a
+	band header and end with a band trailer.
+
+	If the sample is not valid, the offset of the tag where the error was found
+	is returned in error_offset_out (which may be NULL).
+*/
+CODEC_ERROR ValidateSample(void *sample_ptr,
+						   size_t sample_size,
+						   size_t *error_offset_out);
+
+//! Return the CRC-32 of the sample (same checksum as gencrc in the encoder)
+uint32_t ComputeSampleCRC(void *sample_ptr, size_t sample_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -498,6 +498,39 @@ void AllocWaveletStack(IMAGE *wavelet, int width, int height, int level, int typ
 	}
 }
 
+// Return the number of bytes allocated by AllocWaveletStack for a wavelet of the specified type
+size_t WaveletStackSize(int width, int height, int type)
+{
+	int pitch = ALIGN16(width * sizeof(PIXEL));
+	int num_bands;
+	int image_height;
+	size_t band_size;
+
+	switch (type)
+	{
+	case WAVELET_TYPE_HORIZONTAL:
+	case WAVELET_TYPE_VERTICAL:
+	case WAVELET_TYPE_TEMPORAL:
+		num_bands = 2;
+		break;
+
+	default:
+		num_bands = 4;
+		break;
+	}
+
+	image_height = num_bands * height;
+	band_size = height * pitch;
+
+	// Same adjustment for cache line aligned bands as in AllocWaveletStack
+	if (!ISALIGNED(band_size, _CACHE_LINE_SIZE)) {
+		band_size = ALIGN(band_size, _CACHE_LINE_SIZE);
+		image_height = (int)(band_size * num_bands + pitch - 1) / pitch;
+	}
+
+	return ImageSize(pitch/sizeof(PIXEL), image_height);
+}
+
 // Create a four band wavelet image with each band width by height
 #if _ALLOCATOR
 IMAGE *CreateWavelet(ALLOCATOR *allocator, int width, int height, int level)
@@ -1625,6 +1658,63 @@ void AllocTransform(TRANSFORM *transform, int type, int width, int height, int n
 #endif
 }
 
+// Return the number of bytes allocated for the wavelets in a transform of the specified type
+// (the same wavelets as AllocTransform but without the image processing buffer)
+size_t TransformWaveletSize(int type, int width, int height, int num_spatial)
+{
+	size_t size = 0;
+	int wavelet_width = width / 2;
+	int wavelet_height = height / 2;
+	int i;
+
+	switch (type)
+	{
+	case TRANSFORM_TYPE_SPATIAL:
+		size += WaveletStackSize(wavelet_width, wavelet_height, WAVELET_TYPE_FRAME);
+		for (i = 0; i < num_spatial; i++)
+		{
+			wavelet_width /= 2;
+			wavelet_height /= 2;
+			size += WaveletStackSize(wavelet_width, wavelet_height, WAVELET_TYPE_SPATIAL);
+		}
+		break;
+
+	case TRANSFORM_TYPE_FIELD:
+		size += 2 * WaveletStackSize(wavelet_width, wavelet_height, WAVELET_TYPE_FRAME);
+		size += WaveletStackSize(wavelet_width, wavelet_height, WAVELET_TYPE_TEMPORAL);
+		for (i = 0; i < num_spatial; i++)
+		{
+			wavelet_width /= 2;
+			wavelet_height /= 2;
+			size += WaveletStackSize(wavelet_width, wavelet_height, WAVELET_TYPE_SPATIAL);
+		}
+		break;
+
+	case TRANSFORM_TYPE_FIELDPLUS:
+		size += 2 * WaveletStackSize(wavelet_width, wavelet_height, WAVELET_TYPE_FRAME);
+		size += WaveletStackSize(wavelet_width, wavelet_height, WAVELET_TYPE_TEMPORAL);
+		size += 2 * WaveletStackSize(wavelet_width/2, wavelet_height/2, WAVELET_TYPE_SPATIAL);
+		size += WaveletStackSize(wavelet_width/4, wavelet_height/4, WAVELET_TYPE_SPATIAL);
+		break;
+
+	default:
+		break;
+	}
+
+	return size;
+}
+
+// Return the number of bytes allocated by AllocTransform
+size_t TransformMemorySize(int type, int width, int height, int num_spatial)
+{
+	size_t size = TransformWaveletSize(type, width, height, num_spatial);
+
+	// Buffer for image processing
+	size += (size_t)height * ALIGN16(width * sizeof(PIXEL));
+
+	return size;
+}
+
 void SetTransformFrame(TRANSFORM *transform, int width, int height)
 {
 	transform->width = width;
@@ -419,6 +419,12 @@ void AllocTransform(ALLOCATOR *allocator, TRANSFORM *transform, int type,
 void AllocTransform(TRANSFORM *transform, int type, int width, int height, int num_frames, int num_spatial);
 #endif
 
+// Return the number of bytes allocated for the wavelets in a transform
+size_t TransformWaveletSize(int type, int width, int height, int num_spatial);
+
+// Return the number of bytes allocated by AllocTransform (wavelets and buffer)
+size_t TransformMemorySize(int type, int width, int height, int num_spatial);
+
 // Record the original (or requested) frame dimensions
 void SetTransformFrame(TRANSFORM *transform, int width, int height);
 
@@ -447,6 +453,9 @@ void AllocWaveletStack(IMAGE *wavelet, int width, int height, int level, int typ
 IMAGE *CreateWavelet(int width, int height, int level);
 #endif
 
+// Return the number of bytes allocated by AllocWaveletStack
+size_t WaveletStackSize(int width, int height, int type);
+
 #if _ALLOCATOR
 // Create a wavelet (four band) image with the same dimensions as an existing image
 IMAGE *CreateWaveletFromImage(ALLOCATOR *allocator, IMAGE *image);
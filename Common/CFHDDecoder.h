@@ -134,6 +134,14 @@ CFHD_DecodeSampleStub(CFHD_DecoderRef decoderRef,
 				  void *outputBuffer,
 				  int outputPitch);
 
+// Decode one frame of CineForm HD encoded video into several output images
+CFHD_Error
+CFHD_DecodeSampleOutputsStub(CFHD_DecoderRef decoderRef,
+							 void *samplePtr,
+							 size_t sampleSize,
+							 CFHD_OutputDescriptor *outputArray,
+							 int outputCount);
+
 // Set the license for the decoder, controlling time trials and decode resolutions, else watermarked
 CFHD_Error
 CFHD_SetLicenseStub(CFHD_DecoderRef decoderRef,
@@ -159,6 +167,75 @@ CFHD_GetThumbnailStub(CFHD_DecoderRef decoderRef,
 				  size_t *retHeight,
 				  size_t *retSize);
 
+CFHD_Error
+CFHD_GetThumbnailInFormatStub(CFHD_DecoderRef decoderRef,
+				  void *samplePtr,
+				  size_t sampleSize,
+				  void *outputBuffer,
+				  size_t outputBufferSize,
+				  uint32_t flags,
+				  CFHD_PixelFormat pixelFormat,
+				  size_t *retWidth,
+				  size_t *retHeight,
+				  size_t *retSize);
+
+CFHD_Error
+CFHD_GetThumbnailImagesStub(CFHD_DecoderRef decoderRef,
+				  void **samplePtrArray,
+				  size_t *sampleSizeArray,
+				  CFHD_OutputDescriptor *outputArray,
+				  CFHD_Error *errorArray,
+				  int count);
+
+CFHD_Error
+CFHD_GetProxySampleStub(CFHD_DecoderRef decoderRef,
+				  void *samplePtr,
+				  size_t sampleSize,
+				  CFHD_DecodedResolution resolution,
+				  void *outputBuffer,
+				  size_t outputBufferSize,
+				  size_t *retSize);
+
+CFHD_Error
+CFHD_ValidateSampleStub(CFHD_DecoderRef decoderRef,
+				  void *samplePtr,
+				  size_t sampleSize,
+				  CFHD_ValidateFlags flags,
+				  uint32_t *crc);
+
+CFHD_Error
+CFHD_GetStereoEyeSampleStub(CFHD_DecoderRef decoderRef,
+				  void *samplePtr,
+				  size_t sampleSize,
+				  CFHD_VideoSelect eye,
+				  void **eyeSamplePtr,
+				  size_t *eyeSampleSize);
+
+CFHD_Error
+CFHD_GetDecoderStatsStub(CFHD_DecoderRef decoderRef,
+				  CFHD_Stats *statsOut,
+				  CFHD_StatsFlags flags);
+
+CFHD_Error
+CFHD_GetDecoderRequiredMemoryStub(int encodedWidth,
+				  int encodedHeight,
+				  CFHD_EncodedFormat encodedFormat,
+				  CFHD_EncodingFlags encodingFlags,
+				  CFHD_PixelFormat outputFormat,
+				  CFHD_DecodedResolution decodedResolution,
+				  int threadCount,
+				  size_t *requiredMemoryOut);
+
+CFHD_Error
+CFHD_SetDecoderMemoryBudgetStub(CFHD_DecoderRef decoderRef,
+				  size_t memoryBudget);
+
+CFHD_Error
+CFHD_StartThreadTraceStub(uint32_t eventsPerThread);
+
+CFHD_Error
+CFHD_StopThreadTraceStub(const char *pathname);
+
 // Clear the metadata rules for the decoder
 CFHD_Error
 CFHD_ClearActiveMetadataStub(CFHD_DecoderRef decoderRef,
@@ -187,9 +264,20 @@ CFHD_CreateImageDeveloperStub(CFHD_DecoderRef decoderRef,
 #define CFHD_GetImagePitch			CFHD_GetImagePitchStub
 #define CFHD_GetImageSize			CFHD_GetImageSizeStub
 #define CFHD_DecodeSample			CFHD_DecodeSampleStub
+#define CFHD_DecodeSampleOutputs	CFHD_DecodeSampleOutputsStub
 #define CFHD_SetLicense				CFHD_SetLicenseStub
 #define CFHD_SetActiveMetadata		CFHD_SetActiveMetadataStub
 #define CFHD_GetThumbnail			CFHD_GetThumbnailStub
+#define CFHD_GetThumbnailInFormat	CFHD_GetThumbnailInFormatStub
+#define CFHD_GetThumbnailImages		CFHD_GetThumbnailImagesStub
+#define CFHD_GetProxySample			CFHD_GetProxySampleStub
+#define CFHD_ValidateSample			CFHD_ValidateSampleStub
+#define CFHD_GetStereoEyeSample		CFHD_GetStereoEyeSampleStub
+#define CFHD_GetDecoderStats		CFHD_GetDecoderStatsStub
+#define CFHD_GetDecoderRequiredMemory	CFHD_GetDecoderRequiredMemoryStub
+#define CFHD_SetDecoderMemoryBudget	CFHD_SetDecoderMemoryBudgetStub
+#define CFHD_StartThreadTrace		CFHD_StartThreadTraceStub
+#define CFHD_StopThreadTrace		CFHD_StopThreadTraceStub
 #define CFHD_ClearActiveMetadata	CFHD_ClearActiveMetadataStub
 #define CFHD_CloseDecoder			CFHD_CloseDecoderStub
 #define CFHD_CreateImageDeveloper	CFHD_CreateImageDeveloperStub
@@ -265,6 +353,14 @@ CFHD_DecodeSample(CFHD_DecoderRef decoderRef,
 				  void *outputBuffer,
 				  int32_t outputPitch);
 
+// Decode one frame of CineForm HD encoded video into several output images
+CFHDDECODER_API CFHD_Error
+CFHD_DecodeSampleOutputs(CFHD_DecoderRef decoderRef,
+						 void *samplePtr,
+						 size_t sampleSize,
+						 CFHD_OutputDescriptor *outputArray,
+						 int outputCount);
+
 // Set the license for the decoder, controlling time trials and decode resolutions, else watermarked
 CFHDDECODER_API CFHD_Error
 CFHD_SetLicense(CFHD_DecoderRef decoderRef,
@@ -290,6 +386,85 @@ CFHD_GetThumbnail(CFHD_DecoderRef decoderRef,
 				  size_t *retHeight,
 				  size_t *retSize);
 
+// Extract the thumbnail in any pixel format supported by the pixel converter
+CFHDDECODER_API CFHD_Error
+CFHD_GetThumbnailInFormat(CFHD_DecoderRef decoderRef,
+						  void *samplePtr,
+						  size_t sampleSize,
+						  void *outputBuffer,
+						  size_t outputBufferSize,
+						  uint32_t flags,
+						  CFHD_PixelFormat pixelFormat,
+						  size_t *retWidth,
+						  size_t *retHeight,
+						  size_t *retSize);
+
+// Extract the thumbnails from a batch of samples in any size and pixel format
+CFHDDECODER_API CFHD_Error
+CFHD_GetThumbnailImages(CFHD_DecoderRef decoderRef,
+						void **samplePtrArray,
+						size_t *sampleSizeArray,
+						CFHD_OutputDescriptor *outputArray,
+						CFHD_Error *errorArray,
+						int count);
+
+// Create a smaller sample for decoding at half or quarter resolution
+CFHDDECODER_API CFHD_Error
+CFHD_GetProxySample(CFHD_DecoderRef decoderRef,
+					void *samplePtr,
+					size_t sampleSize,
+					CFHD_DecodedResolution resolution,
+					void *outputBuffer,
+					size_t outputBufferSize,
+					size_t *retSize);
+
+// Check the structure of a sample without decoding it
+CFHDDECODER_API CFHD_Error
+CFHD_ValidateSample(CFHD_DecoderRef decoderRef,
+					void *samplePtr,
+					size_t sampleSize,
+					CFHD_ValidateFlags flags,
+					uint32_t *crc);
+
+// Return one eye of a stereo sample as a 2D sample (without copying)
+CFHDDECODER_API CFHD_Error
+CFHD_GetStereoEyeSample(CFHD_DecoderRef decoderRef,
+						void *samplePtr,
+						size_t sampleSize,
+						CFHD_VideoSelect eye,
+						void **eyeSamplePtr,
+						size_t *eyeSampleSize);
+
+// Return the time spent in each stage of decoding
+CFHDDECODER_API CFHD_Error
+CFHD_GetDecoderStats(CFHD_DecoderRef decoderRef,
+					 CFHD_Stats *statsOut,
+					 CFHD_StatsFlags flags);
+
+// Estimate the memory required to decode frames with the specified format
+CFHDDECODER_API CFHD_Error
+CFHD_GetDecoderRequiredMemory(int encodedWidth,
+							  int encodedHeight,
+							  CFHD_EncodedFormat encodedFormat,
+							  CFHD_EncodingFlags encodingFlags,
+							  CFHD_PixelFormat outputFormat,
+							  CFHD_DecodedResolution decodedResolution,
+							  int threadCount,
+							  size_t *requiredMemoryOut);
+
+// Limit the memory allocated by the decoder
+CFHDDECODER_API CFHD_Error
+CFHD_SetDecoderMemoryBudget(CFHD_DecoderRef decoderRef,
+							size_t memoryBudget);
+
+// Start recording the timelines of the worker threads in all thread pools
+CFHDDECODER_API CFHD_Error
+CFHD_StartThreadTrace(uint32_t eventsPerThread);
+
+// Stop recording the thread timelines and write them as a Chrome trace
+CFHDDECODER_API CFHD_Error
+CFHD_StopThreadTrace(const char *pathname);
+
 // Clear the metadata rules for the decoder
 CFHDDECODER_API CFHD_Error
 CFHD_ClearActiveMetadata(CFHD_DecoderRef decoderRef,
@@ -117,6 +117,21 @@ CFHD_Error CFHD_GetEncodeThumbnailStub(CFHD_EncoderRef encoderRef,
 						size_t *retHeight,
 						size_t *retSize);
 
+CFHD_Error CFHD_GetEncoderStatsStub(CFHD_EncoderRef encoderRef,
+						CFHD_Stats *statsOut,
+						CFHD_StatsFlags flags);
+
+CFHD_Error CFHD_GetEncoderRequiredMemoryStub(int frameWidth,
+						int frameHeight,
+						CFHD_PixelFormat inputFormat,
+						CFHD_EncodedFormat encodedFormat,
+						CFHD_EncodingFlags encodingFlags,
+						int encoderCount,
+						size_t *requiredMemoryOut);
+
+CFHD_Error CFHD_SetEncoderMemoryBudgetStub(CFHD_EncoderRef encoderRef,
+						size_t memoryBudget);
+
 CFHD_Error CFHD_MetadataOpenStub(CFHD_MetadataRef *metadataRefOut);
 
 CFHD_Error CFHD_MetadataAddStub(CFHD_MetadataRef metadataRef,
@@ -225,6 +240,9 @@ CFHD_Error CFHD_ReleaseEncoderPoolStub(CFHD_EncoderPoolRef encoderPoolRef);
 #define CFHD_GetSampleData				  CFHD_GetSampleDataStub
 #define CFHD_CloseEncoder				  CFHD_CloseEncoderStub
 #define CFHD_GetEncodeThumbnail			  CFHD_GetEncodeThumbnailStub
+#define CFHD_GetEncoderStats			  CFHD_GetEncoderStatsStub
+#define CFHD_GetEncoderRequiredMemory	  CFHD_GetEncoderRequiredMemoryStub
+#define CFHD_SetEncoderMemoryBudget		  CFHD_SetEncoderMemoryBudgetStub
 #define CFHD_MetadataOpen				  CFHD_MetadataOpenStub
 #define CFHD_MetadataAdd				  CFHD_MetadataAddStub
 #define CFHD_MetadataAttach				  CFHD_MetadataAttachStub
@@ -310,6 +328,27 @@ CFHD_GetEncodeThumbnail(CFHD_EncoderRef encoderRef,
 						size_t *retHeight,
 						size_t *retSize);
 
+// Return the time spent in each stage of encoding
+CFHDENCODER_API CFHD_Error
+CFHD_GetEncoderStats(CFHD_EncoderRef encoderRef,
+					 CFHD_Stats *statsOut,
+					 CFHD_StatsFlags flags);
+
+// Estimate the memory required to encode frames with the specified format
+CFHDENCODER_API CFHD_Error
+CFHD_GetEncoderRequiredMemory(int frameWidth,
+							  int frameHeight,
+							  CFHD_PixelFormat inputFormat,
+							  CFHD_EncodedFormat encodedFormat,
+							  CFHD_EncodingFlags encodingFlags,
+							  int encoderCount,
+							  size_t *requiredMemoryOut);
+
+// Limit the memory allocated by the encoder
+CFHDENCODER_API CFHD_Error
+CFHD_SetEncoderMemoryBudget(CFHD_EncoderRef encoderRef,
+							size_t memoryBudget);
+
 CFHDENCODER_API CFHD_Error
 CFHD_MetadataOpen(CFHD_MetadataRef *metadataRefOut);
 
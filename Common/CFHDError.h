@@ -45,6 +45,7 @@ typedef enum CFHD_Error
 	CFHD_ERROR_THREAD_WAIT_FAILED,
 	CFHD_ERROR_UNKNOWN_TAG,
 	CFHD_ERROR_LICENSING,
+	CFHD_ERROR_BAD_CRC,
 
 	// Error codes returned by the codec library
 	CFHD_ERROR_CODEC_ERROR = 2048,
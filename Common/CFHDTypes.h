@@ -488,4 +488,84 @@ enum
 
 typedef uint32_t CFHD_DecodingFlags;
 
+// Definitions of the flags for CFHD_ValidateFlags (see below)
+enum
+{
+	CFHD_VALIDATE_FLAGS_NONE = 0,
+	CFHD_VALIDATE_FLAGS_COMPUTE_CRC		= (1 << 0),		// Return the CRC of the sample
+	CFHD_VALIDATE_FLAGS_CHECK_CRC		= (1 << 1),		// Compare the CRC of the sample with the CRC provided
+
+};
+
+typedef uint32_t CFHD_ValidateFlags;
+
+// Description of one output image for decoding a sample into several images
+typedef struct CFHD_OutputDescriptor
+{
+	CFHD_PixelFormat pixelFormat;	// Pixel format of the output image
+	int32_t width;					// Width of the output image (in pixels)
+	int32_t height;					// Height of the output image (in rows)
+	void *buffer;					// Buffer for the output image (aligned to 16 bytes)
+	int32_t pitch;					// Pitch of the output buffer (in bytes)
+
+} CFHD_OutputDescriptor;
+
+// Stages of decoding and encoding in the statistics returned by the decoder and encoder
+typedef enum CFHD_StatsStage
+{
+	CFHD_STATS_STAGE_FRAME = 0,		// Decode or encode one sample (includes all other stages)
+	CFHD_STATS_STAGE_HEADER,		// Parse or write the sample and channel headers
+	CFHD_STATS_STAGE_ENTROPY,		// Entropy decode or encode the bands
+	CFHD_STATS_STAGE_TRANSFORM,		// Inverse or forward wavelet transforms
+	CFHD_STATS_STAGE_DEMOSAIC,		// Demosaic the Bayer channels (decoder only)
+	CFHD_STATS_STAGE_COLOR,			// Compute the color processing (decoder only)
+	CFHD_STATS_STAGE_OUTPUT,		// Convert to the output pixel format (decoder only)
+	CFHD_STATS_STAGE_WARP,			// Lens correction and framing (decoder only)
+	CFHD_STATS_STAGE_INPUT,			// Convert the input pixel format (encoder only)
+
+	CFHD_STATS_STAGE_COUNT			// Number of stages
+
+} CFHD_StatsStage;
+
+#define CFHD_STATS_HISTOGRAM_BINS	24		// Number of bins in the histogram of times
+#define CFHD_STATS_MAX_BANDS		25		// Maximum number of subbands in a channel
+#define CFHD_STATS_MAX_LEVELS		8		// Maximum number of wavelets in a transform
+
+/*
+	Statistics for one stage.  All times are in nanoseconds.  The first bin
+	of the histogram counts times less than one microsecond and bin n counts
+	times from 2^(n-1) up to 2^n microseconds.  The last bin also counts all
+	longer times.
+*/
+typedef struct CFHD_StageStats
+{
+	uint64_t count;			// Number of times the stage was executed
+	uint64_t totalTime;		// Total time spent in the stage
+	uint64_t maxTime;		// Longest time spent in the stage
+	uint32_t histogram[CFHD_STATS_HISTOGRAM_BINS];
+
+} CFHD_StageStats;
+
+// Statistics collected by a decoder or encoder since the statistics were reset
+typedef struct CFHD_Stats
+{
+	CFHD_StageStats stage[CFHD_STATS_STAGE_COUNT];	// Indexed by CFHD_StatsStage
+	CFHD_StageStats band[CFHD_STATS_MAX_BANDS];		// Entropy coding of each subband
+	CFHD_StageStats level[CFHD_STATS_MAX_LEVELS];	// Transform of each wavelet (frame wavelets are level zero)
+	uint64_t allocations;							// Heap allocations by the codec while the samples were processed (zero in the steady state)
+
+} CFHD_Stats;
+
+// Definitions of the flags for CFHD_StatsFlags (see below)
+enum
+{
+	CFHD_STATS_FLAGS_NONE = 0,
+	CFHD_STATS_FLAGS_ENABLE		= (1 << 0),		// Start collecting statistics
+	CFHD_STATS_FLAGS_DISABLE	= (1 << 1),		// Stop collecting statistics
+	CFHD_STATS_FLAGS_RESET		= (1 << 2),		// Clear the statistics after they are returned
+
+};
+
+typedef uint32_t CFHD_StatsFlags;
+
 #endif // CFHD_TYPES_H
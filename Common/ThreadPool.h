@@ -159,6 +159,7 @@ public:
 		if (result != 0) {
 			return CFHD_ERROR_THREAD_WAIT_FAILED;
 		}
+		running = false;
 		return CFHD_ERROR_OKAY;
 	}
 
@@ -32,6 +32,7 @@
 #include "ImageConverter.h"
 #include "ImageScaler.h"
 #include "Bilinear.h"
+#include "PixelConverter.h"
 
 #endif
 
@@ -0,0 +1,113 @@
+/*! @file FrameScaler.cpp
+
+*  @brief Scale decoded frames to any size and convert them to any pixel format
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "StdAfx.h"
+
+// Define an assert macro that can be controlled in this file
+#ifndef ASSERT
+#define ASSERT(x)	assert(x)
+#endif
+
+#include "ColorFlags.h"
+#include "FrameScaler.h"
+
+
+// Size of a row of RG48 pixels rounded up to a multiple of 16 bytes
+static inline size_t RG48Pitch(int width)
+{
+	return (((size_t)width * 6) + 15) & ~((size_t)15);
+}
+
+CFrameScaler::CFrameScaler(ColorFlags color_flags) :
+	converter(color_flags),
+	scaler(&allocator),
+	input_image(NULL),
+	input_image_size(0),
+	output_image(NULL),
+	output_image_size(0)
+{
+}
+
+CFrameScaler::~CFrameScaler()
+{
+	if (input_image) {
+		allocator.Free(input_image);
+	}
+	if (output_image) {
+		allocator.Free(output_image);
+	}
+}
+
+void *CFrameScaler::ReserveBuffer(void **buffer, size_t *allocated_size, size_t size)
+{
+	if (*buffer == NULL || *allocated_size < size)
+	{
+		if (*buffer) {
+			allocator.Free(*buffer);
+		}
+
+		*buffer = allocator.Alloc(size);
+		*allocated_size = (*buffer != NULL) ? size : 0;
+	}
+
+	return *buffer;
+}
+
+bool CFrameScaler::Scale(void *input_buffer, size_t input_pitch, CFHD_PixelFormat input_format,
+						 int input_width, int input_height,
+						 void *output_buffer, size_t output_pitch, CFHD_PixelFormat output_format,
+						 int output_width, int output_height)
+{
+	if (input_buffer == NULL || output_buffer == NULL ||
+		input_width <= 0 || input_height <= 0 ||
+		output_width <= 0 || output_height <= 0) {
+		return false;
+	}
+
+	if (!CPixelConverter::IsSupportedFormat(input_format) ||
+		!CPixelConverter::IsSupportedFormat(output_format)) {
+		return false;
+	}
+
+	size_t input_rg48_pitch = RG48Pitch(input_width);
+	size_t output_rg48_pitch = RG48Pitch(output_width);
+
+	uint8_t *input_rg48 = (uint8_t *)ReserveBuffer(&input_image, &input_image_size, input_rg48_pitch * input_height);
+	uint8_t *output_rg48 = (uint8_t *)ReserveBuffer(&output_image, &output_image_size, output_rg48_pitch * output_height);
+
+	if (input_rg48 == NULL || output_rg48 == NULL) {
+		return false;
+	}
+
+	if (!converter.Convert(input_buffer, input_pitch, input_format,
+						   input_rg48, input_rg48_pitch, CFHD_PIXEL_FORMAT_RG48,
+						   input_width, input_height)) {
+		return false;
+	}
+
+	scaler.ScaleToRG48(input_rg48, input_width, input_height, (int)input_rg48_pitch,
+					   output_rg48, output_width, output_height, (int)output_rg48_pitch,
+					   0);
+
+	return converter.Convert(output_rg48, output_rg48_pitch, CFHD_PIXEL_FORMAT_RG48,
+							 output_buffer, output_pitch, output_format,
+							 output_width, output_height);
+}
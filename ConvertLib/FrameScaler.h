@@ -0,0 +1,77 @@
+/*! @file FrameScaler.h
+
+*  @brief Scale decoded frames to any size and convert them to any pixel format
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#pragma once
+
+#include "ColorFlags.h"
+#include "CFHDTypes.h"
+#include "MemAlloc.h"
+#include "PixelConverter.h"
+#include "ImageScaler.h"
+
+/*!
+	@brief Scale decoded frames to the output dimensions and pixel format
+
+	The frame is converted to RG48 by the pixel converter, scaled with the
+	Lanczos filter of the RG48 scaler, and converted to the output format.
+	The converter, the scaler and its worker threads, and the RG48 images are
+	kept in the frame scaler and the images are only reallocated when a larger
+	frame is scaled, so a decoder that keeps the frame scaler does not set up
+	the scaling again for every frame.  The alpha channel is not scaled and
+	the output is opaque.
+*/
+class CFrameScaler
+{
+public:
+
+	CFrameScaler(ColorFlags color_flags = COLOR_FLAGS_DEFAULT);
+
+	~CFrameScaler();
+
+	// Scale and convert the input image to the output dimensions and pixel format
+	bool Scale(void *input_buffer, size_t input_pitch, CFHD_PixelFormat input_format,
+			   int input_width, int input_height,
+			   void *output_buffer, size_t output_pitch, CFHD_PixelFormat output_format,
+			   int output_width, int output_height);
+
+protected:
+
+	// Return a scratch buffer that is at least as large as the requested size
+	void *ReserveBuffer(void **buffer, size_t *allocated_size, size_t size);
+
+	// Memory for the scratch images and the scaler
+	CMemAlloc allocator;
+
+	// Converts the input and output images to and from RG48
+	CPixelConverter converter;
+
+	// Scales the RG48 images (keeps its worker threads between frames)
+	CImageScalerConverterRG48 scaler;
+
+	// Input image converted to RG48
+	void *input_image;
+	size_t input_image_size;
+
+	// Output image in RG48 before conversion to the output format
+	void *output_image;
+	size_t output_image_size;
+
+};
@@ -31,9 +31,30 @@
 #include "ImageConverter.h"
 #include "ImageScaler.h"
 //#include "cpuid.h"
+#include "../Common/Lock.h"
+#include <vector>
+
+#ifndef _XMMOPT
+#define _XMMOPT 1					// Use SIMD instructions in this program
+#endif
+
+#define XMMOPT (1 && _XMMOPT)		// Use SIMD instructions in this module
+
+#if XMMOPT
+#include <emmintrin.h>				// Include support for SSE2 intrinsics
+#endif
 
 #define CONVERT_709_TO_601	1
 
+// Maximum number of filter banks in the process-wide cache
+#define LANCZOS_FILTER_BANK_CACHE_SIZE	32
+
+// Maximum number of coefficients in the window for each output position
+#define LANCZOS_FILTER_BANK_MAX_TAPS	64
+
+// Number of pixels in each block of an output row that is scaled down the columns
+#define LANCZOS_COLUMN_BLOCK_WIDTH		256
+
 #if _WIN32
 
 #if !defined(_OPENMP)
@@ -119,14 +140,261 @@ int GetProcessorCount()
 #endif
 
 
+int _LanczosCoeff(int inputsize, int outputsize, int line,
+				  lanczosmix *lm, bool changefielddominance, bool interlaced, int ilobes);
+
+/*!
+	@brief Interpolation coefficients for every output position along a row or column
+
+	The coefficients depend only on the input and output sizes and the filter
+	parameters, so each filter bank is computed once and shared by all scalers
+	in the process.  The contents are never modified after the filter bank is
+	added to the cache.
+
+	The coefficients are also stored as a window with the same number of taps
+	at every output position so that the SIMD routines can interpolate along a
+	row without checking the number of coefficients at each output position.
+	Input positions that are not used by the Lanczos filter have coefficients
+	of zero in the window.
+*/
+typedef struct lanczos_filter_bank
+{
+	int inputsize;					// Number of input positions
+	int outputsize;					// Number of output positions
+	int lobes;						// Number of lobes in the Lanczos filter
+	bool changefielddominance;
+	bool interlaced;
+	int refcount;					// Number of references to this filter bank
+	uint32_t used;					// Sequence number of the last lookup
+	int *first;						// Index of the first coefficient for each output position
+	lanczosmix *coefficients;		// Coefficients for all output positions
+	int taps;						// Number of coefficients in each window (zero if there are no windows)
+	int *window_first;				// First input position in the window for each output position
+	int *window_total;				// Sum of the coefficients in the window for each output position
+	short *window_mix;				// Coefficients in the window for each output position
+
+} LANCZOS_FILTER_BANK;
+
+static CSimpleLock filter_bank_lock;
+static LANCZOS_FILTER_BANK *filter_bank_cache[LANCZOS_FILTER_BANK_CACHE_SIZE];
+static uint32_t filter_bank_sequence = 0;
+
+static bool IsSameFilterBank(LANCZOS_FILTER_BANK *bank, int inputsize, int outputsize,
+							 bool changefielddominance, bool interlaced, int lobes)
+{
+	return (bank->inputsize == inputsize &&
+			bank->outputsize == outputsize &&
+			bank->lobes == lobes &&
+			bank->changefielddominance == changefielddominance &&
+			bank->interlaced == interlaced);
+}
+
+static void ReleaseFilterBankLocked(LANCZOS_FILTER_BANK *bank)
+{
+	if (bank && --bank->refcount == 0) {
+		free(bank);
+	}
+}
+
+// Compute the coefficients for every output position
+static LANCZOS_FILTER_BANK *CreateFilterBank(int inputsize, int outputsize,
+											 bool changefielddominance, bool interlaced, int lobes)
+{
+	LANCZOS_FILTER_BANK *bank;
+	lanczosmix lm[200];
+	std::vector<lanczosmix> coefficients;
+	std::vector<int> first(outputsize + 1);
+	int span = 0;
+	int taps;
+
+	for (int line = 0; line < outputsize; line++)
+	{
+		int samples = _LanczosCoeff(inputsize, outputsize, line, lm, changefielddominance, interlaced, lobes);
+		first[line] = (int)coefficients.size();
+		coefficients.insert(coefficients.end(), lm, lm + samples);
+
+		// Find the largest range of input positions used for one output position
+		for (int i = 1; i < samples; i++)
+		{
+			int range = lm[i].srcline - lm[0].srcline;
+			if (range < 0) range = -range;
+			if (span < range + 1) span = range + 1;
+		}
+		if (samples > 0 && span < 1) span = 1;
+	}
+	first[outputsize] = (int)coefficients.size();
+
+	// The windows are only computed for interpolation along a row
+	taps = (span + 3) & ~3;
+	if (interlaced || taps > LANCZOS_FILTER_BANK_MAX_TAPS || taps > inputsize) {
+		taps = 0;
+	}
+
+	bank = (LANCZOS_FILTER_BANK *)malloc(sizeof(LANCZOS_FILTER_BANK) +
+										 first.size() * sizeof(int) +
+										 coefficients.size() * sizeof(lanczosmix) +
+										 2 * outputsize * sizeof(int) +
+										 outputsize * taps * sizeof(short));
+	if (bank == NULL) {
+		return NULL;
+	}
+
+	bank->inputsize = inputsize;
+	bank->outputsize = outputsize;
+	bank->lobes = lobes;
+	bank->changefielddominance = changefielddominance;
+	bank->interlaced = interlaced;
+	bank->refcount = 1;
+	bank->used = 0;
+	bank->coefficients = (lanczosmix *)(bank + 1);
+	bank->first = (int *)(bank->coefficients + coefficients.size());
+	bank->taps = taps;
+	bank->window_first = bank->first + first.size();
+	bank->window_total = bank->window_first + outputsize;
+	bank->window_mix = (short *)(bank->window_total + outputsize);
+
+	if (coefficients.size() > 0) {
+		memcpy(bank->coefficients, &coefficients[0], coefficients.size() * sizeof(lanczosmix));
+	}
+	memcpy(bank->first, &first[0], first.size() * sizeof(int));
+
+	if (taps > 0)
+	{
+		memset(bank->window_mix, 0, outputsize * taps * sizeof(short));
+
+		for (int line = 0; line < outputsize; line++)
+		{
+			lanczosmix *lm = bank->coefficients + bank->first[line];
+			int samples = bank->first[line + 1] - bank->first[line];
+			short *mix = bank->window_mix + line * taps;
+			int start = inputsize;
+			int total = 0;
+
+			for (int i = 0; i < samples; i++) {
+				if (start > lm[i].srcline) start = lm[i].srcline;
+			}
+
+			// The window must not extend past the end of the row
+			if (start > inputsize - taps) start = inputsize - taps;
+
+			for (int i = 0; i < samples; i++)
+			{
+				mix[lm[i].srcline - start] += lm[i].mixval;
+				total += lm[i].mixval;
+			}
+
+			bank->window_first[line] = start;
+			bank->window_total[line] = total;
+		}
+	}
+
+	return bank;
+}
+
+// Return the cached filter bank (must be called with the filter bank lock held)
+static LANCZOS_FILTER_BANK *FindFilterBankLocked(int inputsize, int outputsize,
+												 bool changefielddominance, bool interlaced, int lobes)
+{
+	int oldest = 0;
+
+	if (inputsize <= 0 || outputsize <= 0) {
+		return NULL;
+	}
+
+	for (int index = 0; index < LANCZOS_FILTER_BANK_CACHE_SIZE; index++)
+	{
+		LANCZOS_FILTER_BANK *bank = filter_bank_cache[index];
+
+		if (bank == NULL)
+		{
+			oldest = index;
+			break;
+		}
+
+		if (IsSameFilterBank(bank, inputsize, outputsize, changefielddominance, interlaced, lobes))
+		{
+			bank->used = ++filter_bank_sequence;
+			return bank;
+		}
+
+		if (bank->used < filter_bank_cache[oldest]->used) {
+			oldest = index;
+		}
+	}
+
+	// Replace the least recently used filter bank (scalers may still hold a reference)
+	LANCZOS_FILTER_BANK *bank = CreateFilterBank(inputsize, outputsize, changefielddominance, interlaced, lobes);
+	if (bank == NULL) {
+		return NULL;
+	}
+
+	ReleaseFilterBankLocked(filter_bank_cache[oldest]);
+	filter_bank_cache[oldest] = bank;
+	bank->used = ++filter_bank_sequence;
+
+	return bank;
+}
+
+// Copy the coefficients for one output position from the filter bank
+static int CopyFilterBankCoefficients(LANCZOS_FILTER_BANK *bank, int line, lanczosmix *lm)
+{
+	int samples = bank->first[line + 1] - bank->first[line];
+	memcpy(lm, bank->coefficients + bank->first[line], samples * sizeof(lanczosmix));
+	return samples;
+}
+
+void CLanczosScaler::AcquireFilterBank(struct lanczos_filter_bank **bank, int inputsize, int outputsize,
+									   bool interlaced, int lobes)
+{
+	ReleaseFilterBank(bank);
+
+	CAutoLock lock(filter_bank_lock);
+	*bank = FindFilterBankLocked(inputsize, outputsize, false, interlaced, lobes);
+	if (*bank) {
+		(*bank)->refcount++;
+	}
+}
+
+void CLanczosScaler::ReleaseFilterBank(struct lanczos_filter_bank **bank)
+{
+	if (*bank)
+	{
+		CAutoLock lock(filter_bank_lock);
+		ReleaseFilterBankLocked(*bank);
+		*bank = NULL;
+	}
+}
+
+void CLanczosScaler::AcquireColumnFilterBank(int inputHeight, int outputHeight, int renderFieldType, int lobes)
+{
+	// The column scale factors are not used if the height does not change
+	if (inputHeight == outputHeight || renderFieldType < 0 || renderFieldType > 2)
+	{
+		ReleaseFilterBank(&column_bank);
+		return;
+	}
+
+	AcquireFilterBank(&column_bank, inputHeight, outputHeight, (renderFieldType != 0), lobes);
+}
+
 void CLanczosScaler::ComputeRowScaleFactors(short *scaleFactors, int inputWidth, int outputWidth, int lobes=3)
 {
 	lanczosmix lmX[1024];
 	short *ptr = scaleFactors;
 
+	CAutoLock lock(filter_bank_lock);
+	LANCZOS_FILTER_BANK *bank = FindFilterBankLocked(inputWidth, outputWidth, false, false, lobes);
+
 	for (int x = 0; x < outputWidth; x++)
 	{
-		int nsamples = LanczosCoeff(inputWidth, outputWidth, x, lmX, false, false, lobes);
+		int nsamples;
+
+		if (bank) {
+			nsamples = CopyFilterBankCoefficients(bank, x, lmX);
+		}
+		else {
+			nsamples = _LanczosCoeff(inputWidth, outputWidth, x, lmX, false, false, lobes);
+		}
 
 		*ptr++ = x; // dst line number
 
@@ -489,10 +757,258 @@ int /*CLanczosScaler::*/_LanczosCoeff(int inputsize, int outputsize, int line,
 int CLanczosScaler::LanczosCoeff(int inputsize, int outputsize, int line,
 									 lanczosmix *lm, bool changefielddominance, bool interlaced, int lobes=3)
 {
+	if (0 <= line && line < outputsize)
+	{
+		// The filter bank held by this scaler does not change while the worker threads are running
+		LANCZOS_FILTER_BANK *bank = column_bank;
+		if (bank && IsSameFilterBank(bank, inputsize, outputsize, changefielddominance, interlaced, lobes)) {
+			return CopyFilterBankCoefficients(bank, line, lm);
+		}
+
+		CAutoLock lock(filter_bank_lock);
+		bank = FindFilterBankLocked(inputsize, outputsize, changefielddominance, interlaced, lobes);
+		if (bank) {
+			return CopyFilterBankCoefficients(bank, line, lm);
+		}
+	}
+
 	return _LanczosCoeff(inputsize, outputsize, line,
 						 lm, changefielddominance, interlaced, lobes);
 }
 
+void CLanczosScaler::ScaleColumnRow(unsigned short *input, int stride,
+									lanczosmix *lmY, int sampleCount,
+									unsigned short *output, int count)
+{
+	int column = 0;
+
+#if XMMOPT
+	// Pairs of input rows and the coefficients for each pair packed into one word
+	unsigned short *row_ptr[200 + 1];
+	int mix_pair[(200 + 1) / 2];
+	int pair_count = (sampleCount + 1) / 2;
+	int total = 0;
+
+	for (int i = 0; i < sampleCount; i++)
+	{
+		row_ptr[i] = input + stride * lmY[i].srcline;
+		total += lmY[i].mixval;
+	}
+
+	// An odd number of samples is padded with a coefficient of zero
+	if (sampleCount & 1) {
+		row_ptr[sampleCount] = row_ptr[sampleCount - 1];
+	}
+
+	for (int i = 0; i < pair_count; i++)
+	{
+		int mix0 = lmY[2 * i].mixval;
+		int mix1 = (2 * i + 1 < sampleCount) ? lmY[2 * i + 1].mixval : 0;
+		mix_pair[i] = (mix1 << 16) | (mix0 & 0xFFFF);
+	}
+
+	// The input values are biased to signed integers for the multiply and add instruction
+	const __m128i bias_epi16 = _mm_set1_epi16((short)0x8000);
+	const __m128i bias_epi32 = _mm_set1_epi32(total << 15);
+	const __m128i offset_epi32 = _mm_set1_epi32(32768);
+
+	for (; column + 8 <= count; column += 8)
+	{
+		__m128i sum1_epi32 = _mm_setzero_si128();
+		__m128i sum2_epi32 = _mm_setzero_si128();
+
+		for (int i = 0; i < pair_count; i++)
+		{
+			__m128i input1_epi16 = _mm_loadu_si128((__m128i *)(row_ptr[2 * i] + column));
+			__m128i input2_epi16 = _mm_loadu_si128((__m128i *)(row_ptr[2 * i + 1] + column));
+			__m128i mix_epi16 = _mm_set1_epi32(mix_pair[i]);
+
+			input1_epi16 = _mm_xor_si128(input1_epi16, bias_epi16);
+			input2_epi16 = _mm_xor_si128(input2_epi16, bias_epi16);
+
+			sum1_epi32 = _mm_add_epi32(sum1_epi32, _mm_madd_epi16(_mm_unpacklo_epi16(input1_epi16, input2_epi16), mix_epi16));
+			sum2_epi32 = _mm_add_epi32(sum2_epi32, _mm_madd_epi16(_mm_unpackhi_epi16(input1_epi16, input2_epi16), mix_epi16));
+		}
+
+		// Remove the bias and the scale factor in the coefficients
+		sum1_epi32 = _mm_srai_epi32(_mm_add_epi32(sum1_epi32, bias_epi32), 8);
+		sum2_epi32 = _mm_srai_epi32(_mm_add_epi32(sum2_epi32, bias_epi32), 8);
+
+		// Clamp to 16 bits using signed saturation
+		sum1_epi32 = _mm_sub_epi32(sum1_epi32, offset_epi32);
+		sum2_epi32 = _mm_sub_epi32(sum2_epi32, offset_epi32);
+		__m128i output_epi16 = _mm_xor_si128(_mm_packs_epi32(sum1_epi32, sum2_epi32), bias_epi16);
+
+		_mm_storeu_si128((__m128i *)(output + column), output_epi16);
+	}
+#endif
+
+	for (; column < count; column++)
+	{
+		int value = 0;
+
+		for (int i = 0; i < sampleCount; i++) {
+			value += input[stride * lmY[i].srcline + column] * lmY[i].mixval;
+		}
+
+		value >>= 8;
+		if (value < 0) value = 0;
+		else if (value > USHRT_MAX) value = USHRT_MAX;
+
+		output[column] = value;
+	}
+}
+
+#if XMMOPT
+
+// Load four pixels with four 16-bit components as two pairs of pixels
+struct Load4x16
+{
+	unsigned short *row;
+
+	void Load(int x, __m128i &input1_epi16, __m128i &input2_epi16) const
+	{
+		input1_epi16 = _mm_loadu_si128((__m128i *)(row + 4 * x));
+		input2_epi16 = _mm_loadu_si128((__m128i *)(row + 4 * x + 8));
+	}
+};
+
+// Load four pixels with four 8-bit components as two pairs of pixels
+struct Load4x8
+{
+	unsigned char *row;
+
+	void Load(int x, __m128i &input1_epi16, __m128i &input2_epi16) const
+	{
+		__m128i input_epi8 = _mm_loadu_si128((__m128i *)(row + 4 * x));
+		input1_epi16 = _mm_unpacklo_epi8(input_epi8, _mm_setzero_si128());
+		input2_epi16 = _mm_unpackhi_epi8(input_epi8, _mm_setzero_si128());
+	}
+};
+
+// Load four pixels with three 16-bit components (without reading past the end of the row)
+struct Load3x16
+{
+	unsigned short *row;
+	int last;
+
+	__m128i LoadPixel(int x) const
+	{
+		unsigned short *pixel = row + 3 * x;
+
+		if (x < last) {
+			return _mm_loadl_epi64((__m128i *)pixel);
+		}
+
+		return _mm_setr_epi16(pixel[0], pixel[1], pixel[2], 0, 0, 0, 0, 0);
+	}
+
+	void Load(int x, __m128i &input1_epi16, __m128i &input2_epi16) const
+	{
+		input1_epi16 = _mm_unpacklo_epi64(LoadPixel(x), LoadPixel(x + 1));
+		input2_epi16 = _mm_unpacklo_epi64(LoadPixel(x + 2), LoadPixel(x + 3));
+	}
+};
+
+/*!
+	@brief Interpolate the components in one output pixel along a row
+
+	The input pixels in the window for the output pixel are loaded four at a
+	time and the components are interpolated using the multiply and add
+	instruction.  The input values are biased to signed integers and the bias
+	is removed using the sum of the coefficients, so the result is the same as
+	the interpolation with integer arithmetic.
+*/
+template <class PixelLoader>
+static __m128i InterpolatePixel(const PixelLoader &loader, LANCZOS_FILTER_BANK *bank, int x)
+{
+	const __m128i bias_epi16 = _mm_set1_epi16((short)0x8000);
+	short *mix = bank->window_mix + x * bank->taps;
+	int first = bank->window_first[x];
+	__m128i sum_epi32 = _mm_setzero_si128();
+
+	for (int k = 0; k < bank->taps; k += 4)
+	{
+		__m128i input1_epi16;
+		__m128i input2_epi16;
+
+		loader.Load(first + k, input1_epi16, input2_epi16);
+		input1_epi16 = _mm_xor_si128(input1_epi16, bias_epi16);
+		input2_epi16 = _mm_xor_si128(input2_epi16, bias_epi16);
+
+		// Pair the coefficients for the first and third pixels and the second and fourth pixels
+		__m128i mix_epi16 = _mm_shufflelo_epi16(_mm_loadl_epi64((__m128i *)(mix + k)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i mix1_epi16 = _mm_shuffle_epi32(mix_epi16, _MM_SHUFFLE(0, 0, 0, 0));
+		__m128i mix2_epi16 = _mm_shuffle_epi32(mix_epi16, _MM_SHUFFLE(1, 1, 1, 1));
+
+		sum_epi32 = _mm_add_epi32(sum_epi32, _mm_madd_epi16(_mm_unpacklo_epi16(input1_epi16, input2_epi16), mix1_epi16));
+		sum_epi32 = _mm_add_epi32(sum_epi32, _mm_madd_epi16(_mm_unpackhi_epi16(input1_epi16, input2_epi16), mix2_epi16));
+	}
+
+	// Remove the bias that converted the input values to signed integers
+	return _mm_add_epi32(sum_epi32, _mm_set1_epi32(bank->window_total[x] << 15));
+}
+
+// Interpolate the luma in one output pixel along a row of YUYV pixels
+static int InterpolateLuma(unsigned short *row, LANCZOS_FILTER_BANK *bank, int x)
+{
+	const __m128i bias_epi16 = _mm_set1_epi16((short)0x8000);
+	short *mix = bank->window_mix + x * bank->taps;
+	unsigned short *input = row + 2 * bank->window_first[x];
+	__m128i sum_epi32 = _mm_setzero_si128();
+
+	for (int k = 0; k < bank->taps; k += 4)
+	{
+		__m128i input_epi16 = _mm_xor_si128(_mm_loadu_si128((__m128i *)(input + 2 * k)), bias_epi16);
+
+		// The coefficients for the chroma values are zero
+		__m128i mix_epi16 = _mm_unpacklo_epi16(_mm_loadl_epi64((__m128i *)(mix + k)), _mm_setzero_si128());
+
+		sum_epi32 = _mm_add_epi32(sum_epi32, _mm_madd_epi16(input_epi16, mix_epi16));
+	}
+
+	sum_epi32 = _mm_add_epi32(sum_epi32, _mm_shuffle_epi32(sum_epi32, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum_epi32 = _mm_add_epi32(sum_epi32, _mm_shuffle_epi32(sum_epi32, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	return _mm_cvtsi128_si32(sum_epi32) + (bank->window_total[x] << 15);
+}
+
+// Interpolate the chroma in one output pixel along a row of YUYV pixels (returns V and U)
+static __m128i InterpolateChroma(unsigned short *row, LANCZOS_FILTER_BANK *bank, int x)
+{
+	const __m128i bias_epi16 = _mm_set1_epi16((short)0x8000);
+	short *mix = bank->window_mix + x * bank->taps;
+	unsigned short *input = row + 4 * bank->window_first[x];
+	__m128i sum_epi32 = _mm_setzero_si128();
+
+	for (int k = 0; k < bank->taps; k += 2)
+	{
+		__m128i input_epi16 = _mm_xor_si128(_mm_loadu_si128((__m128i *)(input + 4 * k)), bias_epi16);
+
+		// The coefficients for the luma values are zero
+		__m128i mix_epi16 = _mm_cvtsi32_si128(*(int *)(mix + k));
+		mix_epi16 = _mm_unpacklo_epi16(mix_epi16, mix_epi16);
+		mix_epi16 = _mm_unpacklo_epi16(_mm_setzero_si128(), mix_epi16);
+
+		sum_epi32 = _mm_add_epi32(sum_epi32, _mm_madd_epi16(input_epi16, mix_epi16));
+	}
+
+	sum_epi32 = _mm_add_epi32(sum_epi32, _mm_shuffle_epi32(sum_epi32, _MM_SHUFFLE(1, 0, 3, 2)));
+
+	return _mm_add_epi32(sum_epi32, _mm_set1_epi32(bank->window_total[x] << 15));
+}
+
+// Clamp the interpolated components to 16 bits after removing the scale factor in the coefficients
+template <int shift>
+static inline __m128i ClampPixel(__m128i sum_epi32)
+{
+	sum_epi32 = _mm_srai_epi32(sum_epi32, shift);
+	sum_epi32 = _mm_sub_epi32(sum_epi32, _mm_set1_epi32(32768));
+	return _mm_xor_si128(_mm_packs_epi32(sum_epi32, sum_epi32), _mm_set1_epi16((short)0x8000));
+}
+
+#endif
+
 
 
 
@@ -592,7 +1108,7 @@ void CImageScalerYU64::ScaleRowValues(unsigned short *input, int inputWidth, int
 {
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -628,6 +1144,21 @@ void CImageScalerYU64::ScaleRowLuma(unsigned short *inputRow,
 	int srcmix;
 	int tmpY;
 
+#if XMMOPT
+	if (row_bank != NULL && row_bank->taps > 0)
+	{
+		for (dstx = 0; dstx < row_bank->outputsize; dstx++)
+		{
+			tmpY = InterpolateLuma(inputRow, row_bank, dstx) >> 8;
+			if(tmpY > 65535) tmpY = 65535;
+			if(tmpY < 0) tmpY = 0;
+
+			outputRow[dstx*3] = tmpY; ///now Y..Y..YUVYUV
+		}
+		return;
+	}
+#endif
+
 	while((dstx = *ptrL++) != -1)
 	{
 		tmpY = 0;
@@ -651,6 +1182,21 @@ void CImageScalerYU64::ScaleRowChroma(unsigned short *inputRow,
 {
 	short *ptrC = scalefactorsC;
 	int dstx;
+
+#if XMMOPT
+	if (chroma_bank != NULL && chroma_bank->taps > 0)
+	{
+		for (dstx = 0; dstx < chroma_bank->outputsize; dstx++)
+		{
+			__m128i vu_epi16 = ClampPixel<8>(InterpolateChroma(inputRow, chroma_bank, dstx));
+
+			outputRow[dstx*3+1] = _mm_extract_epi16(vu_epi16, 1);	//now.U..U.YUV
+			outputRow[dstx*3+2] = _mm_extract_epi16(vu_epi16, 0);	//now..V..VYUV
+		}
+		return;
+	}
+#endif
+
 	int srcx;
 	int srcmix;
 	int tmpU;
@@ -800,6 +1346,25 @@ void CImageScalerRGB32::ScaleRowValuesThread(int index)
 		outptr = output + (outputWidth * 3) * yy;
 		rgbptr = input + inputPitch * yy;
 
+#if XMMOPT
+		if (row_bank != NULL && row_bank->taps > 0)
+		{
+			Load4x8 loader = {rgbptr};
+
+			// The interpolated values retain the scale factor in the coefficients
+			for (dstx = 0; dstx < row_bank->outputsize; dstx++)
+			{
+				__m128i bgra_epi16 = ClampPixel<0>(InterpolatePixel(loader, row_bank, dstx));
+
+				outptr[dstx*3] = _mm_extract_epi16(bgra_epi16, 2);
+				outptr[dstx*3+1] = _mm_extract_epi16(bgra_epi16, 1);
+				outptr[dstx*3+2] = _mm_extract_epi16(bgra_epi16, 0);
+			}
+			return;
+		}
+#endif
+
+
 		while((dstx = *ptrL++) != -1)
 		{
 			tmpR = tmpG = tmpB = 0;
@@ -836,7 +1401,7 @@ void CImageScalerRGB32::ScaleRowValues(unsigned char *input, int inputWidth, int
 {
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -1375,7 +1940,7 @@ CImageScalerConverterYU64ToYUV::ScaleToNV12(void *input_buffer,
 
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -1554,7 +2119,7 @@ CImageScalerConverterYU64ToYUV::ScaleToYU64(void *input_buffer,
 
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -1822,7 +2387,7 @@ CImageScalerConverterYU64ToYUV::ScaleToCbYCrY_10bit_2_8(void *input_buffer,
 	
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -2064,7 +2629,7 @@ void CImageScalerConverterYU64ToRGB::ScaleToVUYA_4444_32f(unsigned char *inputBu
 	
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -2125,48 +2690,56 @@ void CImageScalerConverterYU64ToRGB::ScaleToBGRA64Thread(int index)
 
 		samples = ComputeColumnScaleFactors(yy, inputHeight, outputHeight, renderFieldType, lmY);
 
+		if (inputHeight == outputHeight)
+		{
+			// Copy the row from the horizontally scaled image
+			lmY[0].srcline = yy;
+			lmY[0].mixval = 256;
+			samples = 1;
+		}
+
 		unsigned short *sourceYUV = (unsigned short *)horizontalscale;
 		unsigned short *YUVptr;
 		int scaledstride = outputWidth * 3;
 
-		for(x = 0; x < outputWidth; x++)
+		for (int column = 0; column < outputWidth; column += LANCZOS_COLUMN_BLOCK_WIDTH)
 		{
-			int y, u, v;
-			int r, g, b;
+			unsigned short scaledYUV[LANCZOS_COLUMN_BLOCK_WIDTH * 3];
+			int width = outputWidth - column;
+			if (width > LANCZOS_COLUMN_BLOCK_WIDTH) width = LANCZOS_COLUMN_BLOCK_WIDTH;
 
-			if (inputHeight == outputHeight)
+			// Scale a block of pixels down the columns of the horizontally scaled image
+			ScaleColumnRow(sourceYUV + column * 3, scaledstride, lmY, samples, scaledYUV, width * 3);
+			YUVptr = scaledYUV;
+
+			for(x = 0; x < width; x++)
 			{
-				YUVptr = sourceYUV + scaledstride * yy;
+				int y, u, v;
+				int r, g, b;
+
 				y = *YUVptr++;
 				u = *YUVptr++;
 				v = *YUVptr++;
-			}
-			else
-			{
-				ScaleColumnValues(sourceYUV, scaledstride, lmY, samples, y, u, v);
-			}
-
-			// Advance to the next column
-			sourceYUV += 3;
 
-			// Convert the YU64 pixel to QuickTime BGRA64
-			ConvertToBGRA64(y, v, u, r, g, b);
+				// Convert the YU64 pixel to QuickTime BGRA64
+				ConvertToBGRA64(y, v, u, r, g, b);
 
-			if (swap_bytes_flag)
-			{
-				// Swap the bytes in each component of the output pixel
-				*(outptr++) = SwapInt16(alpha);
-				*(outptr++) = SwapInt16(r);
-				*(outptr++) = SwapInt16(g);
-				*(outptr++) = SwapInt16(b);
-			}
-			else
-			{
-				// Output the BGRA64 value without swapping bytes
-				*(outptr++) = alpha;
-				*(outptr++) = r;
-				*(outptr++) = g;
-				*(outptr++) = b;
+				if (swap_bytes_flag)
+				{
+					// Swap the bytes in each component of the output pixel
+					*(outptr++) = SwapInt16(alpha);
+					*(outptr++) = SwapInt16(r);
+					*(outptr++) = SwapInt16(g);
+					*(outptr++) = SwapInt16(b);
+				}
+				else
+				{
+					// Output the BGRA64 value without swapping bytes
+					*(outptr++) = alpha;
+					*(outptr++) = r;
+					*(outptr++) = g;
+					*(outptr++) = b;
+				}
 			}
 		}
 	}
@@ -2205,6 +2778,9 @@ void CImageScalerConverterYU64ToRGB::ScaleToBGRA64(unsigned char *inputBuffer,
 
 	ComputeRowScaleFactors(scalefactorsL, inputWidth, outputWidth);
 	ComputeRowScaleFactors(scalefactorsC, (inputWidth>>1), outputWidth);
+	AcquireFilterBank(&row_bank, inputWidth, outputWidth, false);
+	AcquireFilterBank(&chroma_bank, (inputWidth>>1), outputWidth, false);
+	AcquireColumnFilterBank(inputHeight, outputHeight, 0);
 
 	//unsigned short *outptr = (unsigned short *)horizontalscale;
 	//YU64ptr1 = (unsigned short *)fieldbase;
@@ -2214,7 +2790,7 @@ void CImageScalerConverterYU64ToRGB::ScaleToBGRA64(unsigned char *inputBuffer,
 	
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -2359,60 +2935,70 @@ void CImageScalerConverterRGB32ToQuickTime::ScaleToQuickTimeBGRAThread(int index
 
 		samples = ComputeColumnScaleFactors(yy, inputHeight, outputHeight, renderFieldType, lmY);
 
+		if (inputHeight == outputHeight)
+		{
+			// Copy the row from the horizontally scaled image
+			lmY[0].srcline = yy;
+			lmY[0].mixval = 256;
+			samples = 1;
+		}
+
 		unsigned short *sourceRGB = (unsigned short *)horizontalscale;
 		unsigned short *RGBptr;
 		int scaledstride = outputWidth * 3;
 
-		for(x=0;x<outputWidth; x++)
+		for (int column = 0; column < outputWidth; column += LANCZOS_COLUMN_BLOCK_WIDTH)
 		{
-			//float y,u,v,u1,v1;
-			int R,G,B;
+			unsigned short scaled[LANCZOS_COLUMN_BLOCK_WIDTH * 3];
+			int width = outputWidth - column;
+			if (width > LANCZOS_COLUMN_BLOCK_WIDTH) width = LANCZOS_COLUMN_BLOCK_WIDTH;
+
+			// Scale a block of pixels down the columns of the horizontally scaled image
+			ScaleColumnRow(sourceRGB + column * 3, scaledstride, lmY, samples, scaled, width * 3);
+			RGBptr = scaled;
 
-			if(inputHeight == outputHeight)
+			for(x=0;x<width; x++)
 			{
-				RGBptr = sourceRGB + scaledstride * yy;
+				//float y,u,v,u1,v1;
+				int R,G,B;
+
 				R = *RGBptr++;
 				G = *RGBptr++;
 				B = *RGBptr++;
-			}
-			else
-			{
-				ScaleColumnValues(sourceRGB, scaledstride, lmY, samples, R, G, B);
-			}
-			sourceRGB+=3;
-
-			//if(imageRec->pixformat == PrPixelFormat_BGRA32)
-			if (1)
-			{
-				bool usevideosystemsRGB = false;
 
-				if(usevideosystemsRGB)
+				//if(imageRec->pixformat == PrPixelFormat_BGRA32)
+				if (1)
 				{
-					R *= 3518; //219/255
-					R >>= 12;
-					R += 16<<5;
+					bool usevideosystemsRGB = false;
 
-					G *= 3518; //219/255
-					G >>= 12;
-					G += 16<<5;
+					if(usevideosystemsRGB)
+					{
+						R *= 3518; //219/255
+						R >>= 12;
+						R += 16<<5;
 
-					B *= 3518; //219/255
-					B >>= 12;
-					B += 16<<5;
-				}
+						G *= 3518; //219/255
+						G >>= 12;
+						G += 16<<5;
+
+						B *= 3518; //219/255
+						B >>= 12;
+						B += 16<<5;
+					}
 
-				R >>= 8;
-				G >>= 8;
-				B >>= 8;
+					R >>= 8;
+					G >>= 8;
+					B >>= 8;
 
-				if(R < 0) R=0; else if(R>255) R=255;
-				if(G < 0) G=0; else if(G>255) G=255;
-				if(B < 0) B=0; else if(B>255) B=255;
+					if(R < 0) R=0; else if(R>255) R=255;
+					if(G < 0) G=0; else if(G>255) G=255;
+					if(B < 0) B=0; else if(B>255) B=255;
 
-				*BGRA++ = B;
-				*BGRA++ = G;
-				*BGRA++ = R;
-				*BGRA++ = 255;
+					*BGRA++ = B;
+					*BGRA++ = G;
+					*BGRA++ = R;
+					*BGRA++ = 255;
+				}
 			}
 		}
 	}
@@ -2451,13 +3037,15 @@ void CImageScalerConverterRGB32ToQuickTime::ScaleToQuickTimeBGRA(unsigned char *
 	//TODO: Need to choose a scheme for error codes
 
 	ComputeRowScaleFactors(scaleFactors, inputWidth, outputWidth);
+	AcquireFilterBank(&row_bank, inputWidth, outputWidth, false);
+	AcquireColumnFilterBank(inputHeight, outputHeight, 0);
 
     ScaleRowValues(inputBuffer, inputWidth, inputHeight, inputPitch, horizontalscale, outputWidth);
 
 
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -2531,66 +3119,76 @@ void CImageScalerConverterRGB32ToQuickTime::ScaleToQuickTimeARGBThread(int index
 
 		samples = ComputeColumnScaleFactors(yy, inputHeight, outputHeight, renderFieldType, lmY);
 
+		if (inputHeight == outputHeight)
+		{
+			// Copy the row from the horizontally scaled image
+			lmY[0].srcline = yy;
+			lmY[0].mixval = 256;
+			samples = 1;
+		}
+
 		unsigned short *sourceRGB = (unsigned short *)horizontalscale;
 		unsigned short *RGBptr;
 		int scaledstride = outputWidth * 3;
 
-		for(x=0;x<outputWidth; x++)
+		for (int column = 0; column < outputWidth; column += LANCZOS_COLUMN_BLOCK_WIDTH)
 		{
-			//float y,u,v,u1,v1;
-			int R,G,B;
+			unsigned short scaled[LANCZOS_COLUMN_BLOCK_WIDTH * 3];
+			int width = outputWidth - column;
+			if (width > LANCZOS_COLUMN_BLOCK_WIDTH) width = LANCZOS_COLUMN_BLOCK_WIDTH;
+
+			// Scale a block of pixels down the columns of the horizontally scaled image
+			ScaleColumnRow(sourceRGB + column * 3, scaledstride, lmY, samples, scaled, width * 3);
+			RGBptr = scaled;
 
-			if(inputHeight == outputHeight)
+			for(x=0;x<width; x++)
 			{
-				RGBptr = sourceRGB + scaledstride * yy;
+				//float y,u,v,u1,v1;
+				int R,G,B;
+
 				R = *RGBptr++;
 				G = *RGBptr++;
 				B = *RGBptr++;
-			}
-			else
-			{
-				ScaleColumnValues(sourceRGB, scaledstride, lmY, samples, R, G, B);
-			}
-			sourceRGB+=3;
-
-			//if(imageRec->pixformat == PrPixelFormat_BGRA32)
-			if (1)
-			{
-				bool usevideosystemsRGB = false;
 
-				if(usevideosystemsRGB)
+				//if(imageRec->pixformat == PrPixelFormat_BGRA32)
+				if (1)
 				{
-					R *= 3518; //219/255
-					R >>= 12;
-					R += 16<<5;
+					bool usevideosystemsRGB = false;
 
-					G *= 3518; //219/255
-					G >>= 12;
-					G += 16<<5;
+					if(usevideosystemsRGB)
+					{
+						R *= 3518; //219/255
+						R >>= 12;
+						R += 16<<5;
 
-					B *= 3518; //219/255
-					B >>= 12;
-					B += 16<<5;
-				}
+						G *= 3518; //219/255
+						G >>= 12;
+						G += 16<<5;
 
-				R >>= 8;
-				G >>= 8;
-				B >>= 8;
+						B *= 3518; //219/255
+						B >>= 12;
+						B += 16<<5;
+					}
+
+					R >>= 8;
+					G >>= 8;
+					B >>= 8;
 
-				if(R < 0) R=0; else if(R>255) R=255;
-				if(G < 0) G=0; else if(G>255) G=255;
-				if(B < 0) B=0; else if(B>255) B=255;
+					if(R < 0) R=0; else if(R>255) R=255;
+					if(G < 0) G=0; else if(G>255) G=255;
+					if(B < 0) B=0; else if(B>255) B=255;
 #if 0
-				*BGRA++ = B;
-				*BGRA++ = G;
-				*BGRA++ = R;
-				*BGRA++ = 255;
+					*BGRA++ = B;
+					*BGRA++ = G;
+					*BGRA++ = R;
+					*BGRA++ = 255;
 #else
-				*BGRA++ = 255;
-				*BGRA++ = R;
-				*BGRA++ = G;
-				*BGRA++ = B;
+					*BGRA++ = 255;
+					*BGRA++ = R;
+					*BGRA++ = G;
+					*BGRA++ = B;
 #endif
+				}
 			}
 		}
 	}
@@ -2621,13 +3219,15 @@ void CImageScalerConverterRGB32ToQuickTime::ScaleToQuickTimeARGB(unsigned char *
 	//TODO: Need to choose a scheme for error codes
 
 	ComputeRowScaleFactors(scaleFactors, inputWidth, outputWidth);
+	AcquireFilterBank(&row_bank, inputWidth, outputWidth, false);
+	AcquireColumnFilterBank(inputHeight, outputHeight, 0);
 
     ScaleRowValues(inputBuffer, inputWidth, inputHeight, inputPitch, horizontalscale, outputWidth);
 
 	
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -2749,6 +3349,21 @@ void CImageScalerB64A::ScaleRowValuesThread(int index)
 		outptr = output + (outputWidth * 4) * yy;
 		rgbptr = (unsigned short *)(input + (inputPitch/2) * yy);
 
+#if XMMOPT
+		if (row_bank != NULL && row_bank->taps > 0)
+		{
+			Load4x16 loader = {rgbptr};
+
+			for (dstx = 0; dstx < row_bank->outputsize; dstx++)
+			{
+				__m128i argb_epi16 = ClampPixel<8>(InterpolatePixel(loader, row_bank, dstx));
+				_mm_storel_epi64((__m128i *)&outptr[dstx*4], argb_epi16);
+			}
+			return;
+		}
+#endif
+
+
 		while((dstx = *ptrL++) != -1)
 		{
 			tmpR = tmpG = tmpB = tmpA = 0;
@@ -2791,7 +3406,7 @@ void CImageScalerB64A::ScaleRowValues(unsigned char *input, int inputWidth, int
 {
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -2962,79 +3577,89 @@ void CImageScalerConverterB64A::ScaleToB64AThread(int index)
 
 		samples = ComputeColumnScaleFactors(yy, inputHeight, outputHeight, renderFieldType, lmY);
 
+		if (inputHeight == outputHeight)
+		{
+			// Copy the row from the horizontally scaled image
+			lmY[0].srcline = yy;
+			lmY[0].mixval = 256;
+			samples = 1;
+		}
+
 		unsigned short *sourceRGB = horizontalscale;
 		unsigned short *RGBptr;
 		int scaledstride = outputWidth * 4;
 
-		for(x=0;x<outputWidth; x++)
+		for (int column = 0; column < outputWidth; column += LANCZOS_COLUMN_BLOCK_WIDTH)
 		{
-			//float y,u,v,u1,v1;
-			int A,R,G,B;
+			unsigned short scaled[LANCZOS_COLUMN_BLOCK_WIDTH * 4];
+			int width = outputWidth - column;
+			if (width > LANCZOS_COLUMN_BLOCK_WIDTH) width = LANCZOS_COLUMN_BLOCK_WIDTH;
 
-			if(inputHeight == outputHeight)
+			// Scale a block of pixels down the columns of the horizontally scaled image
+			ScaleColumnRow(sourceRGB + column * 4, scaledstride, lmY, samples, scaled, width * 4);
+			RGBptr = scaled;
+
+			for(x=0;x<width; x++)
 			{
-				RGBptr = (unsigned short *)(sourceRGB + scaledstride * yy);
+				//float y,u,v,u1,v1;
+				int A,R,G,B;
+
 				A = *RGBptr++;
 				R = *RGBptr++;
 				G = *RGBptr++;
 				B = *RGBptr++;
-			}
-			else
-			{
-				ScaleColumnValues(sourceRGB, scaledstride, lmY, samples, A, R, G, B);
-			}
-			sourceRGB+=4;
 
-			//if(imageRec->pixformat == PrPixelFormat_BGRA32)
-			if (1)
-			{
-				bool usevideosystemsRGB = false;
-
-				if(usevideosystemsRGB)
+				//if(imageRec->pixformat == PrPixelFormat_BGRA32)
+				if (1)
 				{
-					R *= 3518; //219/255
-					R >>= 12;
-					R += 16<<5;
+					bool usevideosystemsRGB = false;
+
+					if(usevideosystemsRGB)
+					{
+						R *= 3518; //219/255
+						R >>= 12;
+						R += 16<<5;
 
-					G *= 3518; //219/255
-					G >>= 12;
-					G += 16<<5;
+						G *= 3518; //219/255
+						G >>= 12;
+						G += 16<<5;
 
-					B *= 3518; //219/255
-					B >>= 12;
-					B += 16<<5;
-				}
+						B *= 3518; //219/255
+						B >>= 12;
+						B += 16<<5;
+					}
 
-				//R >>= 8;
-				//G >>= 8;
-				//B >>= 8;
+					//R >>= 8;
+					//G >>= 8;
+					//B >>= 8;
 
-				if (A < 0) A = 0; else if (A > max_rgb) A = max_rgb;
-				if (R < 0) R = 0; else if (R > max_rgb) R = max_rgb;
-				if (G < 0) G = 0; else if (G > max_rgb) G = max_rgb;
-				if (B < 0) B = 0; else if (B > max_rgb) B = max_rgb;
+					if (A < 0) A = 0; else if (A > max_rgb) A = max_rgb;
+					if (R < 0) R = 0; else if (R > max_rgb) R = max_rgb;
+					if (G < 0) G = 0; else if (G > max_rgb) G = max_rgb;
+					if (B < 0) B = 0; else if (B > max_rgb) B = max_rgb;
 
 #ifdef _WIN32
-				if (!byte_swap_flag)
-				{
-					*(BGRA++) = A;
-					*(BGRA++) = R;
-					*(BGRA++) = G;
-					*(BGRA++) = B;
-				}
-				else
-				{
+					if (!byte_swap_flag)
+					{
+						*(BGRA++) = A;
+						*(BGRA++) = R;
+						*(BGRA++) = G;
+						*(BGRA++) = B;
+					}
+					else
+					{
+						*(BGRA++) = SwapInt16(A);
+						*(BGRA++) = SwapInt16(R);
+						*(BGRA++) = SwapInt16(G);
+						*(BGRA++) = SwapInt16(B);
+					}
+#else
 					*(BGRA++) = SwapInt16(A);
 					*(BGRA++) = SwapInt16(R);
 					*(BGRA++) = SwapInt16(G);
 					*(BGRA++) = SwapInt16(B);
-				}
-#else
-				*(BGRA++) = SwapInt16(A);
-				*(BGRA++) = SwapInt16(R);
-				*(BGRA++) = SwapInt16(G);
-				*(BGRA++) = SwapInt16(B);
 #endif
+				}
 			}
 		}
 	}
@@ -3066,6 +3691,8 @@ void CImageScalerConverterB64A::ScaleToB64A(unsigned char *inputBuffer,
 	//TODO: Need to choose a scheme for error codes
 
 	ComputeRowScaleFactors(scaleFactors, inputWidth, outputWidth);
+	AcquireFilterBank(&row_bank, inputWidth, outputWidth, false);
+	AcquireColumnFilterBank(inputHeight, outputHeight, 0);
 
     ScaleRowValues(inputBuffer, inputWidth, inputHeight, inputPitch, horizontalscale, outputWidth);
 
@@ -3073,7 +3700,7 @@ void CImageScalerConverterB64A::ScaleToB64A(unsigned char *inputBuffer,
 
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -3198,6 +3825,24 @@ void CImageScalerRG48::ScaleRowValuesThread(int index)
 		outptr = output + (outputWidth * 3) * yy;
 		rgbptr = (unsigned short *)(input + inputPitch * yy);
 
+#if XMMOPT
+		if (row_bank != NULL && row_bank->taps > 0)
+		{
+			Load3x16 loader = {rgbptr, row_bank->inputsize - 1};
+
+			for (dstx = 0; dstx < row_bank->outputsize; dstx++)
+			{
+				__m128i rgb_epi16 = ClampPixel<8>(InterpolatePixel(loader, row_bank, dstx));
+
+				outptr[dstx*3 + 0] = _mm_extract_epi16(rgb_epi16, 0);
+				outptr[dstx*3 + 1] = _mm_extract_epi16(rgb_epi16, 1);
+				outptr[dstx*3 + 2] = _mm_extract_epi16(rgb_epi16, 2);
+			}
+			return;
+		}
+#endif
+
+
 		while((dstx = *ptrL++) != -1)
 		{
 			tmpR = tmpG = tmpB = 0;
@@ -3239,7 +3884,7 @@ void CImageScalerRG48::ScaleRowValues(unsigned char *input, int inputWidth, int
 	
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -3402,83 +4047,93 @@ void CImageScalerConverterRG48::ScaleToRG48Thread(int index)
 
 		samples = ComputeColumnScaleFactors(yy, inputHeight, outputHeight, renderFieldType, lmY, lobes);
 
+		if (inputHeight == outputHeight)
+		{
+			// Copy the row from the horizontally scaled image
+			lmY[0].srcline = yy;
+			lmY[0].mixval = 256;
+			samples = 1;
+		}
+
 		unsigned short *sourceRGB = horizontalscale;
 		unsigned short *RGBptr;
 		int scaledstride = outputWidth * 3;
 
-		for(x=0;x<outputWidth; x++)
+		for (int column = 0; column < outputWidth; column += LANCZOS_COLUMN_BLOCK_WIDTH)
 		{
-			//float y,u,v,u1,v1;
-			int R,G,B;
+			unsigned short scaled[LANCZOS_COLUMN_BLOCK_WIDTH * 3];
+			int width = outputWidth - column;
+			if (width > LANCZOS_COLUMN_BLOCK_WIDTH) width = LANCZOS_COLUMN_BLOCK_WIDTH;
+
+			// Scale a block of pixels down the columns of the horizontally scaled image
+			ScaleColumnRow(sourceRGB + column * 3, scaledstride, lmY, samples, scaled, width * 3);
+			RGBptr = scaled;
 
-			if(inputHeight == outputHeight)
+			for(x=0;x<width; x++)
 			{
-				RGBptr = (unsigned short *)(sourceRGB + scaledstride * yy);
+				//float y,u,v,u1,v1;
+				int R,G,B;
+
 				R = *RGBptr++;
 				G = *RGBptr++;
 				B = *RGBptr++;
-			}
-			else
-			{
-				ScaleColumnValues(sourceRGB, scaledstride, lmY, samples, R, G, B);
-			}
-			sourceRGB+=3;
-
-			//if(imageRec->pixformat == PrPixelFormat_BGRA32)
-			if (1)
-			{
-				bool usevideosystemsRGB = false;
 
-				if(usevideosystemsRGB)
+				//if(imageRec->pixformat == PrPixelFormat_BGRA32)
+				if (1)
 				{
-					R *= 3518; //219/255
-					R >>= 12;
-					R += 16<<5;
+					bool usevideosystemsRGB = false;
 
-					G *= 3518; //219/255
-					G >>= 12;
-					G += 16<<5;
+					if(usevideosystemsRGB)
+					{
+						R *= 3518; //219/255
+						R >>= 12;
+						R += 16<<5;
 
-					B *= 3518; //219/255
-					B >>= 12;
-					B += 16<<5;
-				}
+						G *= 3518; //219/255
+						G >>= 12;
+						G += 16<<5;
 
-				//R >>= 8;
-				//G >>= 8;
-				//B >>= 8;
+						B *= 3518; //219/255
+						B >>= 12;
+						B += 16<<5;
+					}
+
+					//R >>= 8;
+					//G >>= 8;
+					//B >>= 8;
 
-				if (R < 0) R = 0; else if (R > max_rgb) R = max_rgb;
-				if (G < 0) G = 0; else if (G > max_rgb) G = max_rgb;
-				if (B < 0) B = 0; else if (B > max_rgb) B = max_rgb;
+					if (R < 0) R = 0; else if (R > max_rgb) R = max_rgb;
+					if (G < 0) G = 0; else if (G > max_rgb) G = max_rgb;
+					if (B < 0) B = 0; else if (B > max_rgb) B = max_rgb;
 
 #ifdef _WIN32
-				if (!byte_swap_flag)
-				{
-					*(BGRA++) = R;
-					*(BGRA++) = G;
-					*(BGRA++) = B;
-				}
-				else
-				{
-					*(BGRA++) = SwapInt16(R);
-					*(BGRA++) = SwapInt16(G);
-					*(BGRA++) = SwapInt16(B);
-				}
+					if (!byte_swap_flag)
+					{
+						*(BGRA++) = R;
+						*(BGRA++) = G;
+						*(BGRA++) = B;
+					}
+					else
+					{
+						*(BGRA++) = SwapInt16(R);
+						*(BGRA++) = SwapInt16(G);
+						*(BGRA++) = SwapInt16(B);
+					}
 #else
-				if (!byte_swap_flag)
-				{
-					*(BGRA++) = R;
-					*(BGRA++) = G;
-					*(BGRA++) = B;
-				}
-				else
-				{
-					*(BGRA++) = SwapInt16(R);
-					*(BGRA++) = SwapInt16(G);
-					*(BGRA++) = SwapInt16(B);
-				}
+					if (!byte_swap_flag)
+					{
+						*(BGRA++) = R;
+						*(BGRA++) = G;
+						*(BGRA++) = B;
+					}
+					else
+					{
+						*(BGRA++) = SwapInt16(R);
+						*(BGRA++) = SwapInt16(G);
+						*(BGRA++) = SwapInt16(B);
+					}
 #endif
+				}
 			}
 		}
 	}
@@ -3515,6 +4170,8 @@ void CImageScalerConverterRG48::ScaleToRG48(unsigned char *inputBuffer,
 	//TODO: Need to choose a scheme for error codes
 
 	ComputeRowScaleFactors(scaleFactors, inputWidth, outputWidth, lobes);
+	AcquireFilterBank(&row_bank, inputWidth, outputWidth, false, lobes);
+	AcquireColumnFilterBank(inputHeight, outputHeight, 0, lobes);
 
     ScaleRowValues(inputBuffer, inputWidth, inputHeight, inputPitch, horizontalscale, outputWidth);
 
@@ -3522,7 +4179,7 @@ void CImageScalerConverterRG48::ScaleToRG48(unsigned char *inputBuffer,
 	
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -3592,63 +4249,73 @@ void CImageScalerConverterB64A::ScaleToBGRAThread(int index)
 
 		samples = ComputeColumnScaleFactors(yy, inputHeight, outputHeight, renderFieldType, lmY);
 
+		if (inputHeight == outputHeight)
+		{
+			// Copy the row from the horizontally scaled image
+			lmY[0].srcline = yy;
+			lmY[0].mixval = 256;
+			samples = 1;
+		}
+
 		unsigned short *sourceRGB = horizontalscale;
 		unsigned short *RGBptr;
-		int scaledstride = outputWidth * 3;
+		int scaledstride = outputWidth * 4;
 
-		for(x=0;x<outputWidth; x++)
+		for (int column = 0; column < outputWidth; column += LANCZOS_COLUMN_BLOCK_WIDTH)
 		{
-			//float y,u,v,u1,v1;
-			int A,R,G,B;
+			unsigned short scaled[LANCZOS_COLUMN_BLOCK_WIDTH * 4];
+			int width = outputWidth - column;
+			if (width > LANCZOS_COLUMN_BLOCK_WIDTH) width = LANCZOS_COLUMN_BLOCK_WIDTH;
+
+			// Scale a block of pixels down the columns of the horizontally scaled image
+			ScaleColumnRow(sourceRGB + column * 4, scaledstride, lmY, samples, scaled, width * 4);
+			RGBptr = scaled;
 
-			if(inputHeight == outputHeight)
+			for(x=0;x<width; x++)
 			{
-				RGBptr = (unsigned short *)(sourceRGB + scaledstride * yy);
+				//float y,u,v,u1,v1;
+				int A,R,G,B;
+
 				A = *RGBptr++;
 				R = *RGBptr++;
 				G = *RGBptr++;
 				B = *RGBptr++;
-			}
-			else
-			{
-				ScaleColumnValues(sourceRGB, scaledstride, lmY, samples, A, R, G, B);
-			}
-			sourceRGB+=4;
-
-			//if(imageRec->pixformat == PrPixelFormat_BGRA32)
-			if (1)
-			{
-				bool usevideosystemsRGB = false;
 
-				if(usevideosystemsRGB)
+				//if(imageRec->pixformat == PrPixelFormat_BGRA32)
+				if (1)
 				{
-					R *= 3518; //219/255
-					R >>= 12;
-					R += 16<<5;
+					bool usevideosystemsRGB = false;
 
-					G *= 3518; //219/255
-					G >>= 12;
-					G += 16<<5;
+					if(usevideosystemsRGB)
+					{
+						R *= 3518; //219/255
+						R >>= 12;
+						R += 16<<5;
 
-					B *= 3518; //219/255
-					B >>= 12;
-					B += 16<<5;
-				}
+						G *= 3518; //219/255
+						G >>= 12;
+						G += 16<<5;
+
+						B *= 3518; //219/255
+						B >>= 12;
+						B += 16<<5;
+					}
 
-				A >>= 8;
-				R >>= 8;
-				G >>= 8;
-				B >>= 8;
+					A >>= 8;
+					R >>= 8;
+					G >>= 8;
+					B >>= 8;
 
-				if (A < 0) A = 0; else if (A > max_rgb) A = max_rgb;
-				if (R < 0) R = 0; else if (R > max_rgb) R = max_rgb;
-				if (G < 0) G = 0; else if (G > max_rgb) G = max_rgb;
-				if (B < 0) B = 0; else if (B > max_rgb) B = max_rgb;
+					if (A < 0) A = 0; else if (A > max_rgb) A = max_rgb;
+					if (R < 0) R = 0; else if (R > max_rgb) R = max_rgb;
+					if (G < 0) G = 0; else if (G > max_rgb) G = max_rgb;
+					if (B < 0) B = 0; else if (B > max_rgb) B = max_rgb;
 
-				*(BGRA++) = B;
-				*(BGRA++) = G;
-				*(BGRA++) = R;
-				*(BGRA++) = A;
+					*(BGRA++) = B;
+					*(BGRA++) = G;
+					*(BGRA++) = R;
+					*(BGRA++) = A;
+				}
 			}
 		}
 	}
@@ -3685,13 +4352,15 @@ void CImageScalerConverterB64A::ScaleToBGRA(unsigned char *inputBuffer,
 	//TODO: Need to choose a scheme for error codes
 
 	ComputeRowScaleFactors(scaleFactors, inputWidth, outputWidth);
+	AcquireFilterBank(&row_bank, inputWidth, outputWidth, false);
+	AcquireColumnFilterBank(inputHeight, outputHeight, 0);
 
     ScaleRowValues(inputBuffer, inputWidth, inputHeight, inputPitch, horizontalscale, outputWidth);
 
 	
 	if(mailbox.pool.thread_count == 0)
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -3841,7 +4510,7 @@ void CImageScalerYUV::ScaleRowValues(unsigned char *inputBuffer, int inputWidth,
 
 
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -4151,7 +4820,7 @@ void CImageScalerConverterYUV::ScaleToYUV_422_8u(unsigned char *inputBuffer,
 
 	
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -4327,7 +4996,7 @@ void CImageScalerConverterYUV::ScaleToCbYCrY_422_8u(void *inputBuffer,
 
 
 	{
-		mailbox.cpus = GetProcessorCount();
+		if (mailbox.cpus == 0) mailbox.cpus = GetProcessorCount();
 		CreateLock(&mailbox.lock);
 		ThreadPoolCreate(&mailbox.pool,
 						mailbox.cpus,
@@ -33,6 +33,9 @@ typedef struct {
 	int mixval;
 } lanczosmix;
 
+// Interpolation coefficients for every output position (defined in ImageScaler.cpp)
+struct lanczos_filter_bank;
+
 //
 //
 //	Regular C interface that can be used threaded follow the C++ routines
@@ -80,7 +83,10 @@ public:
 
 	CLanczosScaler(IMemAlloc *pMemAlloc) :
 		CImageScaler(pMemAlloc),
-		horizontalscale(NULL)
+		horizontalscale(NULL),
+		row_bank(NULL),
+		chroma_bank(NULL),
+		column_bank(NULL)
 	{
 	}
 
@@ -111,6 +117,10 @@ protected:
 			Free((char *)horizontalscale);
 			horizontalscale = NULL;
 		}
+
+		ReleaseFilterBank(&row_bank);
+		ReleaseFilterBank(&chroma_bank);
+		ReleaseFilterBank(&column_bank);
 	}
 
 	// Compute the scale factors for interpolating along a row
@@ -127,11 +137,31 @@ protected:
 	int LanczosCoeff(int inputsize, int outputsize, int line, lanczosmix *lm,
 					 bool changefielddominance, bool interlaced, int lobes);
 
+	// Hold the coefficients from the cache so that the worker threads can use them without locking
+	void AcquireFilterBank(struct lanczos_filter_bank **bank, int inputsize, int outputsize,
+						   bool interlaced, int lobes = 3);
+
+	// Release the coefficients held by this scaler
+	void ReleaseFilterBank(struct lanczos_filter_bank **bank);
+
+	// Hold the coefficients for the column scale factors
+	void AcquireColumnFilterBank(int inputHeight, int outputHeight, int renderFieldType, int lobes = 3);
+
+	// Scale a row of 16-bit values down the columns of the horizontally scaled image
+	static void ScaleColumnRow(unsigned short *input, int stride,
+							   lanczosmix *lmY, int sampleCount,
+							   unsigned short *output, int count);
+
 protected:
 
 	// Scratch memory for use by the interpolator
 	unsigned short *horizontalscale;
 
+	// Coefficients for the row and column scale factors (from the process-wide cache)
+	struct lanczos_filter_bank *row_bank;
+	struct lanczos_filter_bank *chroma_bank;
+	struct lanczos_filter_bank *column_bank;
+
 };
 
 
@@ -139,7 +169,7 @@ typedef struct
 {
 	THREAD_POOL pool;
 	LOCK lock;
-	int cpus;
+	int cpus;			// Threads in the pool (all processors if zero when the pool is created)
 	void *ptrs[10];
 	int vars[10];
 	int jobtype;
@@ -20,10 +20,13 @@
 */
 
 #include "StdAfx.h"
+#include "config.h"
 #include "MemAlloc.h"
 
 void *CMemAlloc::Alloc(size_t size)
 {
+	CountMemoryAllocation();
+
 #ifdef _WIN32
 	void *block = _aligned_malloc(size, m_alignment);
 #else
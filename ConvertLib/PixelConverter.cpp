@@ -0,0 +1,1119 @@
+/*! @file PixelConverter.cpp
+
+*  @brief Conversion between any two uncompressed pixel formats
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "StdAfx.h"
+
+// Define an assert macro that can be controlled in this file
+#ifndef ASSERT
+#define ASSERT(x)	assert(x)
+#endif
+
+#include "ColorFlags.h"
+#include "PixelConverter.h"
+#include "cpuid.h"
+
+#if !defined(_WIN64) // certain SIMD instructions are NOT supported in Win64...
+#ifndef _XMMOPT
+#define _XMMOPT 1					// Use SIMD instructions in this program
+#endif
+
+#define XMMOPT (1 && _XMMOPT)		// Use SIMD instructions in this module
+#endif
+
+#if XMMOPT
+#include <emmintrin.h>				// Include support for SSE2 intrinsics
+#endif
+
+
+// Number of pixels in each block of 16-bit components (multiple of the six pixels in a v210 group)
+#define PIXEL_BLOCK_WIDTH	384
+
+// Components are unpacked into RGBA or YCbCrA
+enum
+{
+	PIXEL_MODEL_RGB = 0,
+	PIXEL_MODEL_YUV,
+};
+
+/*!
+	@brief Block of pixels unpacked into 16-bit components
+
+	The first three components are R, G, B or Y, Cb, Cr and the fourth component
+	is alpha.  Chroma is unpacked at full resolution and subsampled when packed.
+*/
+typedef struct pixel_block
+{
+	uint16_t c[4][PIXEL_BLOCK_WIDTH];
+
+} PIXEL_BLOCK;
+
+
+// Return the address of the row (the inverted formats are stored bottom up)
+static inline uint8_t *RowAddress(const PIXEL_IMAGE &image, int row, bool inverted = false)
+{
+	if (inverted) {
+		row = image.height - 1 - row;
+	}
+	return image.buffer + row * image.pitch;
+}
+
+static inline uint16_t SwapBytes16(uint16_t value)
+{
+	return (uint16_t)((value << 8) | (value >> 8));
+}
+
+static inline uint32_t SwapBytes32(uint32_t value)
+{
+	return ((value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24));
+}
+
+static inline uint16_t Saturate16u(int32_t value)
+{
+	return (uint16_t)((value < 0) ? 0 : ((value > UINT16_MAX) ? UINT16_MAX : value));
+}
+
+static inline int16_t Saturate16s(int32_t value)
+{
+	return (int16_t)((value < INT16_MIN) ? INT16_MIN : ((value > INT16_MAX) ? INT16_MAX : value));
+}
+
+// RGB components are expanded to 16 bits by replicating the most significant bits
+static inline uint16_t ExpandRGB8(uint32_t value)
+{
+	return (uint16_t)(value * 257);
+}
+
+static inline uint16_t ExpandRGB10(uint32_t value)
+{
+	return (uint16_t)((value << 6) | (value >> 4));
+}
+
+// Luma and chroma are expanded to 16 bits without changing the video range
+static inline uint16_t ExpandYUV(uint8_t value)
+{
+	return (uint16_t)(value << 8);
+}
+
+static inline uint16_t ExpandYUV(uint16_t value)
+{
+	return value;
+}
+
+static inline void ReduceYUV(uint16_t value, uint8_t *output)
+{
+	*output = (uint8_t)(value >> 8);
+}
+
+static inline void ReduceYUV(uint16_t value, uint16_t *output)
+{
+	*output = value;
+}
+
+// Average two chroma samples when packing 4:2:2 formats
+static inline uint16_t Average2(uint16_t a, uint16_t b)
+{
+	return (uint16_t)((a + b + 1) >> 1);
+}
+
+// Average the chroma in one or two rows when packing 4:2:0 formats
+static inline uint16_t AverageChroma(const PIXEL_BLOCK *block, int rows, int component, int i)
+{
+	if (rows == 1) {
+		return Average2(block[0].c[component][i], block[0].c[component][i + 1]);
+	}
+	return (uint16_t)((block[0].c[component][i] + block[0].c[component][i + 1] +
+					   block[1].c[component][i] + block[1].c[component][i + 1] + 2) >> 2);
+}
+
+
+/*
+	Each pixel format is described by a layout class with a color model, the number
+	of rows that must be packed together, and routines that unpack pixels into a block
+	of 16-bit components and pack a block (or pair of blocks for 4:2:0) into pixels.
+	The column and count are always even.
+*/
+
+// 8-bit RGB with the components at the specified byte offsets (negative alpha offset if no alpha)
+template <int red, int green, int blue, int alpha, int pixel_size, bool inverted>
+struct RGB8_Layout
+{
+	enum {model = PIXEL_MODEL_RGB, rows = 1};
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const uint8_t *input = RowAddress(image, row, inverted) + pixel_size * column;
+
+		for (int i = 0; i < count; i++, input += pixel_size)
+		{
+			block->c[0][i] = ExpandRGB8(input[red]);
+			block->c[1][i] = ExpandRGB8(input[green]);
+			block->c[2][i] = ExpandRGB8(input[blue]);
+			block->c[3][i] = (alpha < 0) ? UINT16_MAX : ExpandRGB8(input[alpha]);
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		uint8_t *output = RowAddress(image, row, inverted) + pixel_size * column;
+
+		for (int i = 0; i < count; i++, output += pixel_size)
+		{
+			output[red] = (uint8_t)(block->c[0][i] >> 8);
+			output[green] = (uint8_t)(block->c[1][i] >> 8);
+			output[blue] = (uint8_t)(block->c[2][i] >> 8);
+			if (alpha >= 0) {
+				output[alpha] = (uint8_t)(block->c[3][i] >> 8);
+			}
+		}
+	}
+};
+
+// 16-bit RGB with the components at the specified offsets (negative alpha offset if no alpha)
+template <int red, int green, int blue, int alpha, int pixel_size, bool big_endian>
+struct RGB16_Layout
+{
+	enum {model = PIXEL_MODEL_RGB, rows = 1};
+
+	static inline uint16_t Load(uint16_t value)
+	{
+		return big_endian ? SwapBytes16(value) : value;
+	}
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const uint16_t *input = (const uint16_t *)RowAddress(image, row) + pixel_size * column;
+
+		for (int i = 0; i < count; i++, input += pixel_size)
+		{
+			block->c[0][i] = Load(input[red]);
+			block->c[1][i] = Load(input[green]);
+			block->c[2][i] = Load(input[blue]);
+			block->c[3][i] = (alpha < 0) ? UINT16_MAX : Load(input[alpha]);
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		uint16_t *output = (uint16_t *)RowAddress(image, row) + pixel_size * column;
+
+		for (int i = 0; i < count; i++, output += pixel_size)
+		{
+			output[red] = Load(block->c[0][i]);
+			output[green] = Load(block->c[1][i]);
+			output[blue] = Load(block->c[2][i]);
+			if (alpha >= 0) {
+				output[alpha] = Load(block->c[3][i]);
+			}
+		}
+	}
+};
+
+// 10-bit RGB packed into 32-bit words (the two bits of alpha are not populated)
+template <int red_shift, int green_shift, int blue_shift, bool big_endian>
+struct RGB10_Layout
+{
+	enum {model = PIXEL_MODEL_RGB, rows = 1};
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const uint32_t *input = (const uint32_t *)RowAddress(image, row) + column;
+
+		for (int i = 0; i < count; i++)
+		{
+			uint32_t word = big_endian ? SwapBytes32(input[i]) : input[i];
+
+			block->c[0][i] = ExpandRGB10((word >> red_shift) & 0x3FF);
+			block->c[1][i] = ExpandRGB10((word >> green_shift) & 0x3FF);
+			block->c[2][i] = ExpandRGB10((word >> blue_shift) & 0x3FF);
+			block->c[3][i] = UINT16_MAX;
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		uint32_t *output = (uint32_t *)RowAddress(image, row) + column;
+
+		for (int i = 0; i < count; i++)
+		{
+			uint32_t word = ((uint32_t)(block->c[0][i] >> 6) << red_shift) |
+							((uint32_t)(block->c[1][i] >> 6) << green_shift) |
+							((uint32_t)(block->c[2][i] >> 6) << blue_shift);
+
+			output[i] = big_endian ? SwapBytes32(word) : word;
+		}
+	}
+};
+
+// Signed 16-bit RGB with white at 1 << 13 (alpha is opaque at 1 << 13 - 1)
+template <int pixel_size>
+struct WP13_Layout
+{
+	enum {model = PIXEL_MODEL_RGB, rows = 1};
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const int16_t *input = (const int16_t *)RowAddress(image, row) + pixel_size * column;
+
+		for (int i = 0; i < count; i++, input += pixel_size)
+		{
+			// Values outside the range of the unsigned components are clipped
+			block->c[0][i] = Saturate16u(input[0] << 3);
+			block->c[1][i] = Saturate16u(input[1] << 3);
+			block->c[2][i] = Saturate16u(input[2] << 3);
+			block->c[3][i] = (pixel_size < 4) ? UINT16_MAX : Saturate16u(input[3] << 3);
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		int16_t *output = (int16_t *)RowAddress(image, row) + pixel_size * column;
+
+		for (int i = 0; i < count; i++, output += pixel_size)
+		{
+			output[0] = (int16_t)(block->c[0][i] >> 3);
+			output[1] = (int16_t)(block->c[1][i] >> 3);
+			output[2] = (int16_t)(block->c[2][i] >> 3);
+			if (pixel_size > 3) {
+				output[3] = (int16_t)(block->c[3][i] >> 3);
+			}
+		}
+	}
+};
+
+// Interleaved 4:2:2 with the components of each pair of pixels at the specified offsets
+template <typename ComponentType, int luma1, int cb, int luma2, int cr>
+struct YUV422_Layout
+{
+	enum {model = PIXEL_MODEL_YUV, rows = 1};
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const ComponentType *input = (const ComponentType *)RowAddress(image, row) + 2 * column;
+
+		for (int i = 0; i < count; i += 2, input += 4)
+		{
+			block->c[0][i] = ExpandYUV(input[luma1]);
+			block->c[0][i + 1] = ExpandYUV(input[luma2]);
+			block->c[1][i] = block->c[1][i + 1] = ExpandYUV(input[cb]);
+			block->c[2][i] = block->c[2][i + 1] = ExpandYUV(input[cr]);
+			block->c[3][i] = block->c[3][i + 1] = UINT16_MAX;
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		ComponentType *output = (ComponentType *)RowAddress(image, row) + 2 * column;
+
+		for (int i = 0; i < count; i += 2, output += 4)
+		{
+			ReduceYUV(block->c[0][i], &output[luma1]);
+			ReduceYUV(block->c[0][i + 1], &output[luma2]);
+			ReduceYUV(Average2(block->c[1][i], block->c[1][i + 1]), &output[cb]);
+			ReduceYUV(Average2(block->c[2][i], block->c[2][i + 1]), &output[cr]);
+		}
+	}
+};
+
+// Avid CbYCrY 4:2:2 in signed 2.14 fixed point
+struct CbYCrY_2_14_Layout
+{
+	enum {model = PIXEL_MODEL_YUV, rows = 1};
+
+	static inline uint16_t UnpackLuma(int32_t value)
+	{
+		return Saturate16u((219 * value + (1 << 18)) >> 6);
+	}
+
+	static inline uint16_t UnpackChroma(int32_t value)
+	{
+		return Saturate16u((224 * (value + 8192) + (1 << 18)) >> 6);
+	}
+
+	static inline int16_t PackLuma(int32_t value)
+	{
+		return Saturate16s(((value - 4096) << 6) / 219);
+	}
+
+	static inline int16_t PackChroma(int32_t value)
+	{
+		return Saturate16s((((value - 4096) << 6) / 224) - 8192);
+	}
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const int16_t *input = (const int16_t *)RowAddress(image, row) + 2 * column;
+
+		for (int i = 0; i < count; i += 2, input += 4)
+		{
+			block->c[0][i] = UnpackLuma(input[1]);
+			block->c[0][i + 1] = UnpackLuma(input[3]);
+			block->c[1][i] = block->c[1][i + 1] = UnpackChroma(input[0]);
+			block->c[2][i] = block->c[2][i + 1] = UnpackChroma(input[2]);
+			block->c[3][i] = block->c[3][i + 1] = UINT16_MAX;
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		int16_t *output = (int16_t *)RowAddress(image, row) + 2 * column;
+
+		for (int i = 0; i < count; i += 2, output += 4)
+		{
+			output[0] = PackChroma(Average2(block->c[1][i], block->c[1][i + 1]));
+			output[1] = PackLuma(block->c[0][i]);
+			output[2] = PackChroma(Average2(block->c[2][i], block->c[2][i + 1]));
+			output[3] = PackLuma(block->c[0][i + 1]);
+		}
+	}
+};
+
+// Avid CbYCrY 10-bit 4:2:2 with the two least significant bits in a separate upper plane
+struct CbYCrY_10bit_2_8_Layout
+{
+	enum {model = PIXEL_MODEL_YUV, rows = 1};
+
+	// The pitch is the pitch of the lower plane which has two bytes per pixel
+	static inline uint8_t *UpperRowAddress(const PIXEL_IMAGE &image, int row)
+	{
+		return image.buffer + row * (image.pitch / 4);
+	}
+
+	static inline uint8_t *LowerRowAddress(const PIXEL_IMAGE &image, int row)
+	{
+		return image.buffer + image.height * (image.pitch / 4) + row * image.pitch;
+	}
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const uint8_t *upper = UpperRowAddress(image, row) + column / 2;
+		const uint8_t *lower = LowerRowAddress(image, row) + 2 * column;
+
+		for (int i = 0; i < count; i += 2, upper++, lower += 4)
+		{
+			uint32_t bits = upper[0];
+
+			block->c[1][i] = block->c[1][i + 1] = (uint16_t)(((lower[0] << 2) | ((bits >> 6) & 0x03)) << 6);
+			block->c[0][i] = (uint16_t)(((lower[1] << 2) | ((bits >> 4) & 0x03)) << 6);
+			block->c[2][i] = block->c[2][i + 1] = (uint16_t)(((lower[2] << 2) | ((bits >> 2) & 0x03)) << 6);
+			block->c[0][i + 1] = (uint16_t)(((lower[3] << 2) | (bits & 0x03)) << 6);
+			block->c[3][i] = block->c[3][i + 1] = UINT16_MAX;
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		uint8_t *upper = UpperRowAddress(image, row) + column / 2;
+		uint8_t *lower = LowerRowAddress(image, row) + 2 * column;
+
+		for (int i = 0; i < count; i += 2, upper++, lower += 4)
+		{
+			uint16_t Cb = Average2(block->c[1][i], block->c[1][i + 1]);
+			uint16_t Y1 = block->c[0][i];
+			uint16_t Cr = Average2(block->c[2][i], block->c[2][i + 1]);
+			uint16_t Y2 = block->c[0][i + 1];
+
+			upper[0] = (uint8_t)((((Cb >> 6) & 0x03) << 6) | (((Y1 >> 6) & 0x03) << 4) |
+								 (((Cr >> 6) & 0x03) << 2) | ((Y2 >> 6) & 0x03));
+			lower[0] = (uint8_t)(Cb >> 8);
+			lower[1] = (uint8_t)(Y1 >> 8);
+			lower[2] = (uint8_t)(Cr >> 8);
+			lower[3] = (uint8_t)(Y2 >> 8);
+		}
+	}
+};
+
+// 10-bit 4:2:2 with six pixels packed into four 32-bit words
+struct V210_Layout
+{
+	enum {model = PIXEL_MODEL_YUV, rows = 1};
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const uint32_t *input = (const uint32_t *)RowAddress(image, row) + (column / 6) * 4;
+
+		for (int i = 0; i < count; i += 6, input += 4)
+		{
+			uint16_t Y[6], Cb[3], Cr[3];
+			int n = (count - i < 6) ? (count - i) : 6;
+
+			Cb[0] = (uint16_t)((input[0] & 0x3FF) << 6);
+			Y[0] = (uint16_t)(((input[0] >> 10) & 0x3FF) << 6);
+			Cr[0] = (uint16_t)(((input[0] >> 20) & 0x3FF) << 6);
+			Y[1] = (uint16_t)((input[1] & 0x3FF) << 6);
+			Cb[1] = (uint16_t)(((input[1] >> 10) & 0x3FF) << 6);
+			Y[2] = (uint16_t)(((input[1] >> 20) & 0x3FF) << 6);
+			Cr[1] = (uint16_t)((input[2] & 0x3FF) << 6);
+			Y[3] = (uint16_t)(((input[2] >> 10) & 0x3FF) << 6);
+			Cb[2] = (uint16_t)(((input[2] >> 20) & 0x3FF) << 6);
+			Y[4] = (uint16_t)((input[3] & 0x3FF) << 6);
+			Cr[2] = (uint16_t)(((input[3] >> 10) & 0x3FF) << 6);
+			Y[5] = (uint16_t)(((input[3] >> 20) & 0x3FF) << 6);
+
+			for (int k = 0; k < n; k++)
+			{
+				block->c[0][i + k] = Y[k];
+				block->c[1][i + k] = Cb[k / 2];
+				block->c[2][i + k] = Cr[k / 2];
+				block->c[3][i + k] = UINT16_MAX;
+			}
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		uint32_t *output = (uint32_t *)RowAddress(image, row) + (column / 6) * 4;
+
+		for (int i = 0; i < count; i += 6, output += 4)
+		{
+			uint32_t Y[6], Cb[3], Cr[3];
+			int n = (count - i < 6) ? (count - i) : 6;
+
+			// The last group in the row is padded with the last pair of pixels
+			for (int k = 0; k < 6; k += 2)
+			{
+				int j = i + ((k < n) ? k : (n - 2));
+
+				Y[k] = block->c[0][j] >> 6;
+				Y[k + 1] = block->c[0][j + 1] >> 6;
+				Cb[k / 2] = Average2(block->c[1][j], block->c[1][j + 1]) >> 6;
+				Cr[k / 2] = Average2(block->c[2][j], block->c[2][j + 1]) >> 6;
+			}
+
+			output[0] = Cb[0] | (Y[0] << 10) | (Cr[0] << 20);
+			output[1] = Y[1] | (Cb[1] << 10) | (Y[2] << 20);
+			output[2] = Cr[1] | (Y[3] << 10) | (Cb[2] << 20);
+			output[3] = Y[4] | (Cr[2] << 10) | (Y[5] << 20);
+		}
+	}
+};
+
+// 8-bit 4:4:4:4 with the components at the specified byte offsets and an offset subtracted from luma
+template <int luma, int cb, int cr, int alpha, int luma_offset>
+struct YUVA8_Layout
+{
+	enum {model = PIXEL_MODEL_YUV, rows = 1};
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const uint8_t *input = RowAddress(image, row) + 4 * column;
+
+		for (int i = 0; i < count; i++, input += 4)
+		{
+			block->c[0][i] = Saturate16u((input[luma] + luma_offset) << 8);
+			block->c[1][i] = ExpandYUV(input[cb]);
+			block->c[2][i] = ExpandYUV(input[cr]);
+			block->c[3][i] = ExpandRGB8(input[alpha]);
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		uint8_t *output = RowAddress(image, row) + 4 * column;
+
+		for (int i = 0; i < count; i++, output += 4)
+		{
+			int32_t Y = (block->c[0][i] >> 8) - luma_offset;
+
+			output[luma] = (uint8_t)((Y < 0) ? 0 : Y);
+			output[cb] = (uint8_t)(block->c[1][i] >> 8);
+			output[cr] = (uint8_t)(block->c[2][i] >> 8);
+			output[alpha] = (uint8_t)(block->c[3][i] >> 8);
+		}
+	}
+};
+
+// 8-bit 4:2:0 with a luma plane followed by a plane of interleaved Cb and Cr
+struct NV12_Layout
+{
+	enum {model = PIXEL_MODEL_YUV, rows = 2};
+
+	static inline uint8_t *ChromaRowAddress(const PIXEL_IMAGE &image, int row)
+	{
+		return image.buffer + image.height * image.pitch + (row / 2) * image.pitch;
+	}
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const uint8_t *luma = RowAddress(image, row) + column;
+		const uint8_t *chroma = ChromaRowAddress(image, row) + column;
+
+		for (int i = 0; i < count; i += 2)
+		{
+			block->c[0][i] = ExpandYUV(luma[i]);
+			block->c[0][i + 1] = ExpandYUV(luma[i + 1]);
+			block->c[1][i] = block->c[1][i + 1] = ExpandYUV(chroma[i]);
+			block->c[2][i] = block->c[2][i + 1] = ExpandYUV(chroma[i + 1]);
+			block->c[3][i] = block->c[3][i + 1] = UINT16_MAX;
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		uint8_t *chroma = ChromaRowAddress(image, row) + column;
+
+		for (int k = 0; k < rows; k++)
+		{
+			uint8_t *luma = RowAddress(image, row + k) + column;
+
+			for (int i = 0; i < count; i++) {
+				luma[i] = (uint8_t)(block[k].c[0][i] >> 8);
+			}
+		}
+
+		for (int i = 0; i < count; i += 2)
+		{
+			chroma[i] = (uint8_t)(AverageChroma(block, rows, 1, i) >> 8);
+			chroma[i + 1] = (uint8_t)(AverageChroma(block, rows, 2, i) >> 8);
+		}
+	}
+};
+
+// 8-bit 4:2:0 with a luma plane followed by a Cr plane and a Cb plane at half the pitch
+struct YV12_Layout
+{
+	enum {model = PIXEL_MODEL_YUV, rows = 2};
+
+	static inline uint8_t *CrRowAddress(const PIXEL_IMAGE &image, int row)
+	{
+		return image.buffer + image.height * image.pitch + (row / 2) * (image.pitch / 2);
+	}
+
+	static inline uint8_t *CbRowAddress(const PIXEL_IMAGE &image, int row)
+	{
+		return CrRowAddress(image, row) + ((image.height + 1) / 2) * (image.pitch / 2);
+	}
+
+	static void Unpack(const PIXEL_IMAGE &image, int row, int column, int count, PIXEL_BLOCK *block)
+	{
+		const uint8_t *luma = RowAddress(image, row) + column;
+		const uint8_t *Cb = CbRowAddress(image, row) + column / 2;
+		const uint8_t *Cr = CrRowAddress(image, row) + column / 2;
+
+		for (int i = 0; i < count; i += 2)
+		{
+			block->c[0][i] = ExpandYUV(luma[i]);
+			block->c[0][i + 1] = ExpandYUV(luma[i + 1]);
+			block->c[1][i] = block->c[1][i + 1] = ExpandYUV(Cb[i / 2]);
+			block->c[2][i] = block->c[2][i + 1] = ExpandYUV(Cr[i / 2]);
+			block->c[3][i] = block->c[3][i + 1] = UINT16_MAX;
+		}
+	}
+
+	static void Pack(const PIXEL_BLOCK *block, int rows, const PIXEL_IMAGE &image, int row, int column, int count)
+	{
+		uint8_t *Cb = CbRowAddress(image, row) + column / 2;
+		uint8_t *Cr = CrRowAddress(image, row) + column / 2;
+
+		for (int k = 0; k < rows; k++)
+		{
+			uint8_t *luma = RowAddress(image, row + k) + column;
+
+			for (int i = 0; i < count; i++) {
+				luma[i] = (uint8_t)(block[k].c[0][i] >> 8);
+			}
+		}
+
+		for (int i = 0; i < count; i += 2)
+		{
+			Cb[i / 2] = (uint8_t)(AverageChroma(block, rows, 1, i) >> 8);
+			Cr[i / 2] = (uint8_t)(AverageChroma(block, rows, 2, i) >> 8);
+		}
+	}
+};
+
+
+// Apply a color conversion matrix with 16-bit precision to a block of pixels
+static void TransformBlock(const float matrix[3][4], PIXEL_BLOCK *block, int count)
+{
+	int i = 0;
+
+#if XMMOPT
+	const __m128i zero_epi16 = _mm_setzero_si128();
+	const __m128i bias_epi32 = _mm_set1_epi32(32768);
+	const __m128i bias_epi16 = _mm_set1_epi16((short)0x8000);
+	const __m128 min_ps = _mm_setzero_ps();
+	const __m128 max_ps = _mm_set1_ps(65535.0f);
+	__m128 m_ps[3][4];
+
+	for (int k = 0; k < 3; k++) {
+		for (int j = 0; j < 4; j++) {
+			m_ps[k][j] = _mm_set1_ps(matrix[k][j]);
+		}
+	}
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128 input_ps[3][2];
+		__m128i output_epi16[3];
+
+		// Convert eight 16-bit values in each component to two sets of four floats
+		for (int j = 0; j < 3; j++)
+		{
+			__m128i input_epi16 = _mm_loadu_si128((__m128i *)&block->c[j][i]);
+			input_ps[j][0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(input_epi16, zero_epi16));
+			input_ps[j][1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(input_epi16, zero_epi16));
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			__m128i output_epi32[2];
+
+			for (int h = 0; h < 2; h++)
+			{
+				__m128 sum_ps = m_ps[k][3];
+				sum_ps = _mm_add_ps(sum_ps, _mm_mul_ps(m_ps[k][0], input_ps[0][h]));
+				sum_ps = _mm_add_ps(sum_ps, _mm_mul_ps(m_ps[k][1], input_ps[1][h]));
+				sum_ps = _mm_add_ps(sum_ps, _mm_mul_ps(m_ps[k][2], input_ps[2][h]));
+				sum_ps = _mm_min_ps(_mm_max_ps(sum_ps, min_ps), max_ps);
+
+				// Offset the results into the signed range for packing with saturation
+				output_epi32[h] = _mm_sub_epi32(_mm_cvtps_epi32(sum_ps), bias_epi32);
+			}
+
+			output_epi16[k] = _mm_xor_si128(_mm_packs_epi32(output_epi32[0], output_epi32[1]), bias_epi16);
+		}
+
+		// Store the results after all of the input components have been read
+		for (int k = 0; k < 3; k++) {
+			_mm_storeu_si128((__m128i *)&block->c[k][i], output_epi16[k]);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		float input[3] = {(float)block->c[0][i], (float)block->c[1][i], (float)block->c[2][i]};
+
+		for (int k = 0; k < 3; k++)
+		{
+			float sum = matrix[k][0] * input[0] + matrix[k][1] * input[1] + matrix[k][2] * input[2] + matrix[k][3];
+			block->c[k][i] = Saturate16u((int32_t)(sum + 0.5f));
+		}
+	}
+}
+
+// Color conversion between the color models (no conversion if the models are the same)
+template <int input_model, int output_model>
+struct ColorTransform
+{
+	static inline void Apply(const PIXEL_CONVERSION *conversion, PIXEL_BLOCK *block, int count)
+	{
+	}
+};
+
+template <>
+struct ColorTransform<PIXEL_MODEL_YUV, PIXEL_MODEL_RGB>
+{
+	static inline void Apply(const PIXEL_CONVERSION *conversion, PIXEL_BLOCK *block, int count)
+	{
+		TransformBlock(conversion->yuv_to_rgb, block, count);
+	}
+};
+
+template <>
+struct ColorTransform<PIXEL_MODEL_RGB, PIXEL_MODEL_YUV>
+{
+	static inline void Apply(const PIXEL_CONVERSION *conversion, PIXEL_BLOCK *block, int count)
+	{
+		TransformBlock(conversion->rgb_to_yuv, block, count);
+	}
+};
+
+/*!
+	@brief Convert a strip of rows from the input layout to the output layout
+
+	Each block of pixels is unpacked, color converted, and packed before the next
+	block is unpacked so the intermediate components stay in the processor cache.
+	The 4:2:0 layouts are converted in pairs of rows so the strips must start on
+	an even row.
+*/
+template <class InputLayout, class OutputLayout>
+static void ConvertRows(const PIXEL_CONVERSION *conversion, int first_row, int last_row)
+{
+	const int group_height = ((int)InputLayout::rows > (int)OutputLayout::rows) ?
+							 (int)InputLayout::rows : (int)OutputLayout::rows;
+	const int width = conversion->input.width;
+	PIXEL_BLOCK blocks[2];
+
+	for (int row = first_row; row < last_row; row += group_height)
+	{
+		const int rows = (last_row - row < group_height) ? (last_row - row) : group_height;
+
+		for (int column = 0; column < width; column += PIXEL_BLOCK_WIDTH)
+		{
+			const int count = (width - column < PIXEL_BLOCK_WIDTH) ? (width - column) : PIXEL_BLOCK_WIDTH;
+
+			for (int k = 0; k < rows; k++)
+			{
+				InputLayout::Unpack(conversion->input, row + k, column, count, &blocks[k]);
+				ColorTransform<InputLayout::model, OutputLayout::model>::Apply(conversion, &blocks[k], count);
+			}
+
+			if (OutputLayout::rows == 1)
+			{
+				for (int k = 0; k < rows; k++) {
+					OutputLayout::Pack(&blocks[k], 1, conversion->output, row + k, column, count);
+				}
+			}
+			else
+			{
+				OutputLayout::Pack(blocks, rows, conversion->output, row, column, count);
+			}
+		}
+	}
+}
+
+
+// Layouts for the pixel formats that have the same layout as other formats
+typedef RGB8_Layout<2, 1, 0, 3, 4, true> BGRA_Layout;
+typedef RGB8_Layout<2, 1, 0, 3, 4, false> BGRa_Layout;
+typedef RGB8_Layout<2, 1, 0, -1, 3, true> RG24_Layout;
+typedef RGB16_Layout<1, 2, 3, 0, 4, false> B64A_Layout;
+typedef RGB16_Layout<0, 1, 2, -1, 3, false> RG48_Layout;
+typedef RGB16_Layout<0, 1, 2, 3, 4, false> RG64_Layout;
+typedef RGB16_Layout<0, 1, 2, -1, 3, true> B48R_Layout;
+typedef RGB10_Layout<0, 10, 20, false> RG30_Layout;
+typedef RGB10_Layout<20, 10, 0, false> AR10_Layout;
+typedef RGB10_Layout<20, 10, 0, true> R210_Layout;
+typedef RGB10_Layout<22, 12, 2, true> DPX0_Layout;
+typedef WP13_Layout<3> WP13_RGB_Layout;
+typedef WP13_Layout<4> W13A_Layout;
+typedef YUV422_Layout<uint8_t, 1, 0, 3, 2> CbYCrY_8bit_Layout;
+typedef YUV422_Layout<uint8_t, 0, 1, 2, 3> YUYV_Layout;
+typedef YUV422_Layout<uint16_t, 0, 3, 2, 1> YU64_Layout;
+typedef YUV422_Layout<uint16_t, 1, 0, 3, 2> CbYCrY_16bit_Layout;
+typedef YUVA8_Layout<1, 2, 3, 0, 16> R408_Layout;
+typedef YUVA8_Layout<1, 0, 2, 3, 0> V408_Layout;
+
+// Table of the supported pixel formats and the layout for each format
+#define PIXEL_LAYOUT_TABLE(ENTRY) \
+	ENTRY(CFHD_PIXEL_FORMAT_BGRA, BGRA_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_BGRa, BGRa_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_RG24, RG24_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_2VUY, CbYCrY_8bit_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_YUY2, YUYV_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_B64A, B64A_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_RG48, RG48_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_YU64, YU64_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_V210, V210_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_RG30, RG30_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_AB10, RG30_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_AR10, AR10_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_R210, R210_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_DPX0, DPX0_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_NV12, NV12_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_YV12, YV12_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_R408, R408_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_V408, V408_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_WP13, WP13_RGB_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_W13A, W13A_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_YUYV, YUYV_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_B48R, B48R_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_RG64, RG64_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_CT_UCHAR, CbYCrY_8bit_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_CT_10BIT_2_8, CbYCrY_10bit_2_8_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_CT_SHORT_2_14, CbYCrY_2_14_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_CT_USHORT_10_6, CbYCrY_16bit_Layout) \
+	ENTRY(CFHD_PIXEL_FORMAT_CT_SHORT, CbYCrY_16bit_Layout)
+
+#define OUTPUT_LAYOUT_CASE(format, layout)	case format: return ConvertRows<InputLayout, layout>;
+#define INPUT_LAYOUT_CASE(format, layout)	case format: return GetConversionProc<layout>(output_format);
+#define SUPPORTED_FORMAT_CASE(format, layout)	case format:
+
+// Return the conversion routine from the input layout to the output pixel format
+template <class InputLayout>
+static PIXEL_CONVERSION_PROC GetConversionProc(CFHD_PixelFormat output_format)
+{
+	switch (output_format)
+	{
+	PIXEL_LAYOUT_TABLE(OUTPUT_LAYOUT_CASE)
+
+	default:
+		return NULL;
+	}
+}
+
+// Return the conversion routine for the pair of pixel formats
+static PIXEL_CONVERSION_PROC GetConversionProc(CFHD_PixelFormat input_format, CFHD_PixelFormat output_format)
+{
+	switch (input_format)
+	{
+	PIXEL_LAYOUT_TABLE(INPUT_LAYOUT_CASE)
+
+	default:
+		return NULL;
+	}
+}
+
+// Does the pixel format subsample chroma horizontally?
+static bool IsSubsampledFormat(CFHD_PixelFormat format)
+{
+	switch (format)
+	{
+	case CFHD_PIXEL_FORMAT_2VUY:
+	case CFHD_PIXEL_FORMAT_YUY2:
+	case CFHD_PIXEL_FORMAT_YUYV:
+	case CFHD_PIXEL_FORMAT_YU64:
+	case CFHD_PIXEL_FORMAT_V210:
+	case CFHD_PIXEL_FORMAT_NV12:
+	case CFHD_PIXEL_FORMAT_YV12:
+	case CFHD_PIXEL_FORMAT_CT_UCHAR:
+	case CFHD_PIXEL_FORMAT_CT_10BIT_2_8:
+	case CFHD_PIXEL_FORMAT_CT_SHORT_2_14:
+	case CFHD_PIXEL_FORMAT_CT_USHORT_10_6:
+	case CFHD_PIXEL_FORMAT_CT_SHORT:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+CPixelConverter::CPixelConverter(ColorFlags color_flags) :
+	conversion_proc(NULL)
+{
+	memset(&mailbox, 0, sizeof(MAILBOX));
+	memset(&conversion, 0, sizeof(conversion));
+	ComputeColorMatrices(color_flags);
+}
+
+CPixelConverter::~CPixelConverter()
+{
+	if (mailbox.pool.thread_count > 0)
+	{
+		ThreadPoolDelete(&mailbox.pool);
+		DeleteLock(&mailbox.lock);
+	}
+}
+
+bool CPixelConverter::IsSupportedFormat(CFHD_PixelFormat format)
+{
+	switch (format)
+	{
+	PIXEL_LAYOUT_TABLE(SUPPORTED_FORMAT_CASE)
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+/*!
+	@brief Compute the color conversion matrices for the color flags
+
+	Luma and chroma are video range (16 to 235 and 16 to 240 scaled to 16 bits)
+	and RGB is full range unless the color flags specify video safe RGB.  All of
+	the pixel formats use the same transfer function so there is no gamma stage.
+*/
+void CPixelConverter::ComputeColorMatrices(ColorFlags color_flags)
+{
+	const bool bt709 = (color_flags & COLOR_FLAGS_CS709) != 0;
+	const bool video_safe = (color_flags & COLOR_FLAGS_VSRGB) != 0;
+
+	// Luma coefficients for the color space
+	const double Kr = bt709 ? 0.2126 : 0.299;
+	const double Kb = bt709 ? 0.0722 : 0.114;
+	const double Kg = 1.0 - Kr - Kb;
+
+	// Scale and offset for luma, chroma, and RGB with 16-bit precision
+	const double yuv_scale[3] = {219 << 8, 224 << 8, 224 << 8};
+	const double yuv_offset[3] = {16 << 8, 128 << 8, 128 << 8};
+	const double rgb_scale = video_safe ? (219 << 8) : UINT16_MAX;
+	const double rgb_offset = video_safe ? (16 << 8) : 0;
+
+	// Normalized R'G'B' to Y'CbCr
+	const double forward[3][3] =
+	{
+		{Kr, Kg, Kb},
+		{-Kr / (2 * (1 - Kb)), -Kg / (2 * (1 - Kb)), 0.5},
+		{0.5, -Kg / (2 * (1 - Kr)), -Kb / (2 * (1 - Kr))},
+	};
+
+	// Normalized Y'CbCr to R'G'B'
+	const double inverse[3][3] =
+	{
+		{1.0, 0.0, 2 * (1 - Kr)},
+		{1.0, -2 * Kb * (1 - Kb) / Kg, -2 * Kr * (1 - Kr) / Kg},
+		{1.0, 2 * (1 - Kb), 0.0},
+	};
+
+	for (int i = 0; i < 3; i++)
+	{
+		double rgb_to_yuv_offset = yuv_offset[i];
+		double yuv_to_rgb_offset = rgb_offset;
+
+		for (int j = 0; j < 3; j++)
+		{
+			double rgb_to_yuv = yuv_scale[i] * forward[i][j] / rgb_scale;
+			double yuv_to_rgb = rgb_scale * inverse[i][j] / yuv_scale[j];
+
+			conversion.rgb_to_yuv[i][j] = (float)rgb_to_yuv;
+			conversion.yuv_to_rgb[i][j] = (float)yuv_to_rgb;
+
+			rgb_to_yuv_offset -= rgb_to_yuv * rgb_offset;
+			yuv_to_rgb_offset -= yuv_to_rgb * yuv_offset[j];
+		}
+
+		conversion.rgb_to_yuv[i][3] = (float)rgb_to_yuv_offset;
+		conversion.yuv_to_rgb[i][3] = (float)yuv_to_rgb_offset;
+	}
+}
+
+bool CPixelConverter::Convert(void *input_buffer, size_t input_pitch, CFHD_PixelFormat input_format,
+							  void *output_buffer, size_t output_pitch, CFHD_PixelFormat output_format,
+							  int width, int height)
+{
+	if (input_buffer == NULL || output_buffer == NULL || width <= 0 || height <= 0) {
+		return false;
+	}
+
+	// The 4:2:2 and 4:2:0 formats must have an even number of pixels per row
+	if ((width % 2) != 0 && (IsSubsampledFormat(input_format) || IsSubsampledFormat(output_format))) {
+		return false;
+	}
+
+	conversion_proc = GetConversionProc(input_format, output_format);
+	if (conversion_proc == NULL) {
+		return false;
+	}
+
+	conversion.input.buffer = (uint8_t *)input_buffer;
+	conversion.input.pitch = input_pitch;
+	conversion.input.width = width;
+	conversion.input.height = height;
+
+	conversion.output.buffer = (uint8_t *)output_buffer;
+	conversion.output.pitch = output_pitch;
+	conversion.output.width = width;
+	conversion.output.height = height;
+
+	int strip_count = (height + PIXEL_CONVERTER_STRIP_HEIGHT - 1) / PIXEL_CONVERTER_STRIP_HEIGHT;
+
+	if (mailbox.cpus == 0) {
+		mailbox.cpus = GetProcessorCount();
+	}
+
+	// Small images and single processor systems are converted without the worker threads
+	if (strip_count < 2 || mailbox.cpus < 2)
+	{
+		conversion_proc(&conversion, 0, height);
+		return true;
+	}
+
+	if (mailbox.pool.thread_count == 0)
+	{
+		CreateLock(&mailbox.lock);
+		ThreadPoolCreate(&mailbox.pool,
+						mailbox.cpus,
+						ConverterProc,
+						this);
+	}
+
+	// Post a message to the mailbox
+	mailbox.jobtype = ConvertStripThreadID;
+
+	// Set the work count to the number of strips to process
+	ThreadPoolSetWorkCount(&mailbox.pool, strip_count);
+	// Start the worker threads
+	ThreadPoolSendMessage(&mailbox.pool, THREAD_MESSAGE_START);
+	// Wait for all of the worker threads to finish
+	ThreadPoolWaitAllDone(&mailbox.pool);
+
+	return true;
+}
+
+// Convert one strip of rows
+void CPixelConverter::ConvertStripThread(int index)
+{
+	int first_row = index * PIXEL_CONVERTER_STRIP_HEIGHT;
+	int last_row = first_row + PIXEL_CONVERTER_STRIP_HEIGHT;
+
+	if (last_row > conversion.input.height) {
+		last_row = conversion.input.height;
+	}
+
+	conversion_proc(&conversion, first_row, last_row);
+}
+
+THREAD_PROC(CPixelConverter::ConverterProc, lpParam)
+{
+	CPixelConverter *myclass = (CPixelConverter *)lpParam;
+	MAILBOX *mailbox = (MAILBOX *)&myclass->mailbox;
+	THREAD_ERROR error = THREAD_ERROR_OKAY;
+	int thread_index;
+
+	// Determine the index of this worker thread
+	error = PoolThreadGetIndex(&mailbox->pool, &thread_index);
+	assert(error == THREAD_ERROR_OKAY);
+
+	// Check that the thread index is consistent with the size of the thread pool
+	assert(0 <= thread_index && thread_index < mailbox->pool.thread_count);
+
+	// The worker thread stays active while waiting for a message to start processing
+	for (;;)
+	{
+		// Wait for the signal to begin converting strips
+		THREAD_MESSAGE message = THREAD_MESSAGE_NONE;
+		error = PoolThreadWaitForMessage(&mailbox->pool, thread_index, &message);
+
+		if (error == THREAD_ERROR_OKAY && message == THREAD_MESSAGE_START)
+		{
+			for (;;)
+			{
+				int work_index;
+
+				// Wait for the next strip to convert
+				error = PoolThreadWaitForWork(&mailbox->pool, &work_index, thread_index);
+
+				if (error == THREAD_ERROR_OKAY)
+				{
+					switch (mailbox->jobtype)
+					{
+					case ConvertStripThreadID:
+						myclass->ConvertStripThread(work_index);
+						break;
+					}
+				}
+				else
+				{
+					// No more work to do
+					break;
+				}
+			}
+
+			// Signal that this thread is done
+			PoolThreadSignalDone(&mailbox->pool, thread_index);
+		}
+		else if (error == THREAD_ERROR_OKAY && message == THREAD_MESSAGE_STOP)
+		{
+			// The worker thread has been told to terminate itself
+			break;
+		}
+		else
+		{
+			// If the wait failed it probably means that the thread pool is shutting down
+			break;
+		}
+	}
+
+	return (THREAD_RETURN_TYPE)error;
+}
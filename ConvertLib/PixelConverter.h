@@ -0,0 +1,105 @@
+/*! @file PixelConverter.h
+
+*  @brief Conversion between any two uncompressed pixel formats
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#pragma once
+
+#include "ColorFlags.h"
+#include "CFHDTypes.h"
+
+// The pixel converter uses the same thread pool mailbox as the image scalers
+#include "MemAlloc.h"
+#include "ImageConverter.h"
+#include "ImageScaler.h"
+
+// Number of rows in each strip of the image assigned to a worker thread
+#define PIXEL_CONVERTER_STRIP_HEIGHT	16
+
+// Description of an image in one of the supported pixel formats
+typedef struct pixel_image
+{
+	uint8_t *buffer;		// Address of the first row (first plane for planar formats)
+	size_t pitch;			// Distance between rows (in bytes)
+	int width;				// Width of the image (in pixels)
+	int height;				// Height of the image (in rows)
+
+} PIXEL_IMAGE;
+
+// Parameters for converting an image between two pixel formats
+typedef struct pixel_conversion
+{
+	PIXEL_IMAGE input;
+	PIXEL_IMAGE output;
+
+	// Color conversion matrices with 16-bit precision (fourth column is the offset)
+	float yuv_to_rgb[3][4];
+	float rgb_to_yuv[3][4];
+
+} PIXEL_CONVERSION;
+
+// Routine that converts the rows in a strip for one pair of pixel formats
+typedef void (* PIXEL_CONVERSION_PROC)(const PIXEL_CONVERSION *conversion, int first_row, int last_row);
+
+/*!
+	@brief Convert images between any two uncompressed pixel formats
+
+	Each pixel format is described by a class that unpacks a block of pixels
+	into 16-bit components and packs 16-bit components into the pixel format.
+	The routine for each pair of pixel formats is a template instance that
+	combines unpacking, color conversion, and packing into one pass over blocks
+	of pixels that fit in the processor cache.  Strips of rows are converted in
+	parallel by the worker threads in the mailbox.
+
+	Compressed and Bayer pixel formats are not supported.
+*/
+class CPixelConverter
+{
+public:
+
+	CPixelConverter(ColorFlags color_flags = COLOR_FLAGS_DEFAULT);
+
+	~CPixelConverter();
+
+	// Can images in this pixel format be converted?
+	static bool IsSupportedFormat(CFHD_PixelFormat format);
+
+	// Convert the input image to the output pixel format
+	bool Convert(void *input_buffer, size_t input_pitch, CFHD_PixelFormat input_format,
+				 void *output_buffer, size_t output_pitch, CFHD_PixelFormat output_format,
+				 int width, int height);
+
+#define ConvertStripThreadID	1
+	void ConvertStripThread(int index);
+
+	MAILBOX mailbox;
+	static THREAD_PROC(ConverterProc, lpParam);
+
+protected:
+
+	// Initialize the color conversion matrices for the color flags
+	void ComputeColorMatrices(ColorFlags color_flags);
+
+	// Parameters for the conversion in progress
+	PIXEL_CONVERSION conversion;
+
+	// Routine for the pair of pixel formats in the conversion in progress
+	PIXEL_CONVERSION_PROC conversion_proc;
+
+};
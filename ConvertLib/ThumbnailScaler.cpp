@@ -0,0 +1,370 @@
+/*! @file ThumbnailScaler.cpp
+
+*  @brief Scale thumbnails to any size and convert them to any pixel format
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "StdAfx.h"
+
+// Define an assert macro that can be controlled in this file
+#ifndef ASSERT
+#define ASSERT(x)	assert(x)
+#endif
+
+#include <math.h>
+
+#include "ColorFlags.h"
+#include "ThumbnailScaler.h"
+
+#if !defined(_WIN64) // certain SIMD instructions are NOT supported in Win64...
+#ifndef _XMMOPT
+#define _XMMOPT 1					// Use SIMD instructions in this program
+#endif
+
+#define XMMOPT (1 && _XMMOPT)		// Use SIMD instructions in this module
+#endif
+
+#if XMMOPT
+#include <emmintrin.h>				// Include support for SSE2 intrinsics
+#endif
+
+
+// Size of a row of 16-bit RGBA pixels rounded up to a multiple of 16 bytes
+static inline size_t RGBA64Pitch(int width)
+{
+	return (((size_t)width * 8) + 15) & ~((size_t)15);
+}
+
+CThumbnailScaler::CThumbnailScaler(ColorFlags color_flags) :
+	converter(color_flags),
+	input_image(NULL),
+	input_image_size(0),
+	output_image(NULL),
+	output_image_size(0),
+	row_sums(NULL),
+	row_sums_size(0)
+{
+	memset(&row_filter, 0, sizeof(row_filter));
+	memset(&column_filter, 0, sizeof(column_filter));
+}
+
+CThumbnailScaler::~CThumbnailScaler()
+{
+	ReleaseFilter(&row_filter);
+	ReleaseFilter(&column_filter);
+
+	if (input_image) {
+		allocator.Free(input_image);
+	}
+	if (output_image) {
+		allocator.Free(output_image);
+	}
+	if (row_sums) {
+		allocator.Free(row_sums);
+	}
+}
+
+void *CThumbnailScaler::ReserveBuffer(void **buffer, size_t *allocated_size, size_t size)
+{
+	if (*buffer == NULL || *allocated_size < size)
+	{
+		if (*buffer) {
+			allocator.Free(*buffer);
+		}
+
+		*buffer = allocator.Alloc(size);
+		*allocated_size = (*buffer != NULL) ? size : 0;
+	}
+
+	return *buffer;
+}
+
+/*!
+	@brief Compute the coefficients of the tent filter
+
+	The width of the tent is the ratio of the input and output sizes when the
+	image is reduced, so every input pixel contributes to the output, and is
+	one input pixel when the image is enlarged, which is linear interpolation.
+	The window of input pixels for each output pixel is moved inside the image
+	and the weights for pixels outside the image are added to the edge pixels.
+*/
+bool CThumbnailScaler::ComputeFilter(THUMBNAIL_FILTER *filter, int input_size, int output_size)
+{
+	// Can reuse the coefficients from the previous thumbnail?
+	if (filter->input_size == input_size && filter->output_size == output_size) {
+		return true;
+	}
+
+	const double scale = (double)input_size / output_size;
+	const double radius = (scale > 1.0) ? scale : 1.0;
+
+	int taps = (int)ceil(2 * radius) + 1;
+	if (taps > input_size) {
+		taps = input_size;
+	}
+
+	size_t size = output_size * (sizeof(int) + taps * sizeof(float));
+
+	if (ReserveBuffer((void **)&filter->first, &filter->allocated_size, size) == NULL)
+	{
+		filter->input_size = 0;
+		filter->output_size = 0;
+		return false;
+	}
+
+	filter->weights = (float *)(filter->first + output_size);
+	filter->taps = taps;
+
+	for (int output = 0; output < output_size; output++)
+	{
+		const double center = (output + 0.5) * scale - 0.5;
+		const int lower = (int)floor(center - radius) + 1;
+		const int upper = (int)ceil(center + radius) - 1;
+
+		float *weights = filter->weights + output * taps;
+		double total = 0.0;
+
+		int first = lower;
+		if (first > input_size - taps) {
+			first = input_size - taps;
+		}
+		if (first < 0) {
+			first = 0;
+		}
+
+		memset(weights, 0, taps * sizeof(float));
+
+		for (int input = lower; input <= upper; input++)
+		{
+			double weight = 1.0 - fabs(input - center) / radius;
+			int index = input;
+
+			if (weight <= 0.0) {
+				continue;
+			}
+
+			// Replicate the pixels at the edges of the image
+			if (index < 0) {
+				index = 0;
+			}
+			if (index > input_size - 1) {
+				index = input_size - 1;
+			}
+
+			ASSERT(0 <= index - first && index - first < taps);
+			weights[index - first] += (float)weight;
+			total += weight;
+		}
+
+		// Normalize the weights so that the filter preserves the average
+		for (int k = 0; k < taps; k++) {
+			weights[k] = (float)(weights[k] / total);
+		}
+
+		filter->first[output] = first;
+	}
+
+	filter->input_size = input_size;
+	filter->output_size = output_size;
+
+	return true;
+}
+
+void CThumbnailScaler::ReleaseFilter(THUMBNAIL_FILTER *filter)
+{
+	if (filter->first) {
+		allocator.Free(filter->first);
+	}
+
+	memset(filter, 0, sizeof(THUMBNAIL_FILTER));
+}
+
+/*!
+	@brief Resample the 16-bit RGBA image
+
+	The input rows under each output row are summed down the columns and the
+	row of sums is filtered along the row, so the pixels are unpacked once per
+	input row used by the output row and each component is processed in one
+	lane of a four float vector.
+*/
+void CThumbnailScaler::ScaleImage(uint16_t *input, size_t input_pitch,
+								  uint16_t *output, size_t output_pitch)
+{
+	const int input_width = row_filter.input_size;
+	const int output_width = row_filter.output_size;
+	const int output_height = column_filter.output_size;
+
+	// Number of components in each input row
+	const int count = input_width * 4;
+
+	for (int row = 0; row < output_height; row++)
+	{
+		const float *column_weights = column_filter.weights + row * column_filter.taps;
+		uint16_t *output_row = (uint16_t *)((uint8_t *)output + row * output_pitch);
+
+		memset(row_sums, 0, count * sizeof(float));
+
+		// Sum the input rows weighted by the column filter
+		for (int k = 0; k < column_filter.taps; k++)
+		{
+			const float weight = column_weights[k];
+			const uint16_t *input_row;
+			int i = 0;
+
+			if (weight == 0.0f) {
+				continue;
+			}
+
+			input_row = (uint16_t *)((uint8_t *)input + (column_filter.first[row] + k) * input_pitch);
+
+#if XMMOPT
+			{
+				const __m128 weight_ps = _mm_set1_ps(weight);
+				const __m128i zero_epi16 = _mm_setzero_si128();
+
+				for (; i + 8 <= count; i += 8)
+				{
+					__m128i input_epi16 = _mm_loadu_si128((const __m128i *)&input_row[i]);
+					__m128 lower_ps = _mm_cvtepi32_ps(_mm_unpacklo_epi16(input_epi16, zero_epi16));
+					__m128 upper_ps = _mm_cvtepi32_ps(_mm_unpackhi_epi16(input_epi16, zero_epi16));
+
+					_mm_storeu_ps(&row_sums[i], _mm_add_ps(_mm_loadu_ps(&row_sums[i]), _mm_mul_ps(lower_ps, weight_ps)));
+					_mm_storeu_ps(&row_sums[i + 4], _mm_add_ps(_mm_loadu_ps(&row_sums[i + 4]), _mm_mul_ps(upper_ps, weight_ps)));
+				}
+			}
+#endif
+			for (; i < count; i++)
+			{
+				row_sums[i] += weight * input_row[i];
+			}
+		}
+
+		// Filter the row of sums to compute each output pixel
+		for (int column = 0; column < output_width; column++)
+		{
+			const float *row_weights = row_filter.weights + column * row_filter.taps;
+			const float *sums = row_sums + row_filter.first[column] * 4;
+
+#if XMMOPT
+			__m128 pixel_ps = _mm_setzero_ps();
+			__m128i pixel_epi32;
+
+			for (int k = 0; k < row_filter.taps; k++, sums += 4)
+			{
+				pixel_ps = _mm_add_ps(pixel_ps, _mm_mul_ps(_mm_loadu_ps(sums), _mm_set1_ps(row_weights[k])));
+			}
+
+			// Round to the nearest integer and pack with unsigned saturation using the signed pack
+			pixel_epi32 = _mm_sub_epi32(_mm_cvtps_epi32(pixel_ps), _mm_set1_epi32(0x8000));
+			pixel_epi32 = _mm_packs_epi32(pixel_epi32, pixel_epi32);
+			pixel_epi32 = _mm_xor_si128(pixel_epi32, _mm_set1_epi16((short)0x8000));
+
+			_mm_storel_epi64((__m128i *)&output_row[column * 4], pixel_epi32);
+#else
+			float pixel[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+			for (int k = 0; k < row_filter.taps; k++, sums += 4)
+			{
+				pixel[0] += row_weights[k] * sums[0];
+				pixel[1] += row_weights[k] * sums[1];
+				pixel[2] += row_weights[k] * sums[2];
+				pixel[3] += row_weights[k] * sums[3];
+			}
+
+			for (int i = 0; i < 4; i++)
+			{
+				float value = pixel[i] + 0.5f;
+				if (value < 0.0f) value = 0.0f;
+				if (value > 65535.0f) value = 65535.0f;
+				output_row[column * 4 + i] = (uint16_t)value;
+			}
+#endif
+		}
+	}
+}
+
+bool CThumbnailScaler::Scale(void *input_buffer, size_t input_pitch, CFHD_PixelFormat input_format,
+							 int input_width, int input_height,
+							 void *output_buffer, size_t output_pitch, CFHD_PixelFormat output_format,
+							 int output_width, int output_height)
+{
+	if (input_buffer == NULL || output_buffer == NULL ||
+		input_width <= 0 || input_height <= 0 ||
+		output_width <= 0 || output_height <= 0) {
+		return false;
+	}
+
+	if (!CPixelConverter::IsSupportedFormat(input_format) ||
+		!CPixelConverter::IsSupportedFormat(output_format)) {
+		return false;
+	}
+
+	// Only need to convert the pixel format if the dimensions are the same
+	if (input_width == output_width && input_height == output_height)
+	{
+		return converter.Convert(input_buffer, input_pitch, input_format,
+								 output_buffer, output_pitch, output_format,
+								 output_width, output_height);
+	}
+
+	if (!ComputeFilter(&row_filter, input_width, output_width) ||
+		!ComputeFilter(&column_filter, input_height, output_height)) {
+		return false;
+	}
+
+	if (ReserveBuffer((void **)&row_sums, &row_sums_size, input_width * 4 * sizeof(float)) == NULL) {
+		return false;
+	}
+
+	// Unpack the input image to 16-bit RGBA
+	uint16_t *input_rgba = (uint16_t *)input_buffer;
+	size_t input_rgba_pitch = input_pitch;
+
+	if (input_format != CFHD_PIXEL_FORMAT_RG64)
+	{
+		input_rgba_pitch = RGBA64Pitch(input_width);
+		input_rgba = (uint16_t *)ReserveBuffer(&input_image, &input_image_size, input_rgba_pitch * input_height);
+
+		if (input_rgba == NULL ||
+			!converter.Convert(input_buffer, input_pitch, input_format,
+							   input_rgba, input_rgba_pitch, CFHD_PIXEL_FORMAT_RG64,
+							   input_width, input_height)) {
+			return false;
+		}
+	}
+
+	// Scale directly into the output buffer if it is 16-bit RGBA
+	if (output_format == CFHD_PIXEL_FORMAT_RG64)
+	{
+		ScaleImage(input_rgba, input_rgba_pitch, (uint16_t *)output_buffer, output_pitch);
+		return true;
+	}
+
+	size_t output_rgba_pitch = RGBA64Pitch(output_width);
+	uint16_t *output_rgba = (uint16_t *)ReserveBuffer(&output_image, &output_image_size, output_rgba_pitch * output_height);
+
+	if (output_rgba == NULL) {
+		return false;
+	}
+
+	ScaleImage(input_rgba, input_rgba_pitch, output_rgba, output_rgba_pitch);
+
+	return converter.Convert(output_rgba, output_rgba_pitch, CFHD_PIXEL_FORMAT_RG64,
+							 output_buffer, output_pitch, output_format,
+							 output_width, output_height);
+}
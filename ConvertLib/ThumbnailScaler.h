@@ -0,0 +1,101 @@
+/*! @file ThumbnailScaler.h
+
+*  @brief Scale thumbnails to any size and convert them to any pixel format
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#pragma once
+
+#include "ColorFlags.h"
+#include "CFHDTypes.h"
+#include "MemAlloc.h"
+#include "PixelConverter.h"
+
+// Coefficients for resampling one dimension of the thumbnail
+typedef struct thumbnail_filter
+{
+	int input_size;			// Number of input samples used to compute the coefficients
+	int output_size;		// Number of output samples
+	int taps;				// Number of coefficients for each output sample
+	int *first;				// Index of the first input sample for each output sample
+	float *weights;			// Coefficients for each output sample (padded with zeros)
+	size_t allocated_size;	// Size of the memory block that contains the coefficients
+
+} THUMBNAIL_FILTER;
+
+/*!
+	@brief Scale thumbnails to the output dimensions and pixel format
+
+	The thumbnail is unpacked to 16-bit RGBA, resampled with a separable tent
+	filter that averages every input pixel under the output pixel when the
+	image is reduced, and converted to the output pixel format by the pixel
+	converter.  The filter coefficients and the scratch images are kept in
+	the scaler and only reallocated when a larger thumbnail is scaled, so a
+	scaler that is reused for many thumbnails does not allocate memory.
+*/
+class CThumbnailScaler
+{
+public:
+
+	CThumbnailScaler(ColorFlags color_flags = COLOR_FLAGS_DEFAULT);
+
+	~CThumbnailScaler();
+
+	// Scale and convert the input image to the output dimensions and pixel format
+	bool Scale(void *input_buffer, size_t input_pitch, CFHD_PixelFormat input_format,
+			   int input_width, int input_height,
+			   void *output_buffer, size_t output_pitch, CFHD_PixelFormat output_format,
+			   int output_width, int output_height);
+
+protected:
+
+	// Compute the filter coefficients for the input and output dimensions
+	bool ComputeFilter(THUMBNAIL_FILTER *filter, int input_size, int output_size);
+
+	// Release the memory allocated for the filter coefficients
+	void ReleaseFilter(THUMBNAIL_FILTER *filter);
+
+	// Return a scratch buffer that is at least as large as the requested size
+	void *ReserveBuffer(void **buffer, size_t *allocated_size, size_t size);
+
+	// Resample the 16-bit RGBA input image to the 16-bit RGBA output image
+	void ScaleImage(uint16_t *input, size_t input_pitch,
+					uint16_t *output, size_t output_pitch);
+
+	// Memory for the filter coefficients and scratch images
+	CMemAlloc allocator;
+
+	// Converts the input and output images to and from 16-bit RGBA
+	CPixelConverter converter;
+
+	THUMBNAIL_FILTER row_filter;
+	THUMBNAIL_FILTER column_filter;
+
+	// Input image unpacked to 16-bit RGBA
+	void *input_image;
+	size_t input_image_size;
+
+	// Output image in 16-bit RGBA before conversion to the output format
+	void *output_image;
+	size_t output_image_size;
+
+	// Sums of the input rows weighted by the column filter
+	float *row_sums;
+	size_t row_sums_size;
+
+};
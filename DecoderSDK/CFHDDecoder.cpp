@@ -63,6 +63,7 @@ extern "C" {
 #include "decoder.h"
 #include "swap.h"
 #include "thumbnail.h"
+#include "threadtrace.h"
 
 // Include declarations for the decoder component
 #include "CFHDDecoder.h"
@@ -154,6 +155,7 @@ CFHD_OpenDecoder(CFHD_DecoderRef *decoderRefOut,
 	}
 
 	// Allocate a new decoder data structure
+	CountMemoryAllocation();
 	CSampleDecoder *decoderRef = new CSampleDecoder;
 	if (decoderRef == NULL) {
 		return CFHD_ERROR_OUTOFMEMORY;
@@ -763,6 +765,62 @@ CFHD_DecodeSample(CFHD_DecoderRef decoderRef,
 	return CFHD_ERROR_OKAY;
 }
 
+/*!
+	@function CFHD_DecodeSampleOutputs
+
+	@brief Decode one frame of CineForm HD video into several output images.
+
+	@description The decoder must have been initialized by a call to
+	CFHD_PrepareToDecode.  The first output image must have the dimensions
+	and format returned by the call to CFHD_PrepareToDecode.  The sample is
+	decoded once, so each output image can have a different format and
+	resolution without repeating the entropy decoding.  An output image that
+	is smaller than the decoded frame is taken from the half or quarter
+	resolution lowpass bands computed while decoding the sample, as if the
+	decoder had been prepared for that output image, and the other output
+	images are converted and scaled from the decoded frame.
+
+	The first output image should have the highest resolution and precision,
+	since the other output images are computed from the decoded frame.
+
+	@param decoderRef
+	A reference to a decoder that was initialized by a call to
+	CFHD_PrepareToDecode.
+
+	@param samplePtr
+	Pointer to a sample containing one frame of encoded video in the
+	CineForm HD format.
+
+	@param sampleSize
+	Size of the encoded sample.
+
+	@param outputArray
+	Array of descriptors for the output images.  Each output buffer must
+	start on an address that is aligned to 16 bytes and the pitch must be
+	a multiple of 16 bytes.
+
+	@param outputCount
+	Number of descriptors in the output array.
+
+	@return Returns a CFHD error code.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_DecodeSampleOutputs(CFHD_DecoderRef decoderRef,
+						 void *samplePtr,
+						 size_t sampleSize,
+						 CFHD_OutputDescriptor *outputArray,
+						 int outputCount)
+{
+	// Check the input arguments
+	if (decoderRef == NULL || outputArray == NULL || outputCount < 1) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
+
+	return decoder->DecodeSampleOutputs(samplePtr, sampleSize, outputArray, outputCount);
+}
+
 /*!
 	@function CFHD_SetLicense
 
@@ -1547,6 +1605,7 @@ CFHD_GetThumbnail(CFHD_DecoderRef decoderRef,
 					outputBuffer,
 					outputBufferSize,
 					flags,
+					CFHD_PIXEL_FORMAT_UNKNOWN,
 					retWidth,
 					retHeight,
 					retSize);
@@ -1554,6 +1613,538 @@ CFHD_GetThumbnail(CFHD_DecoderRef decoderRef,
 	return errorCode;
 }
 
+/*!
+	@function CFHD_GetThumbnailInFormat
+
+	@brief Generate a thumbnail in the specified pixel format
+
+	@description Extract the base wavelet into a thumbnail image without
+	decompressing the sample and convert the thumbnail to the pixel format.
+	The thumbnail has the same dimensions as the thumbnail returned by
+	@ref CFHD_GetThumbnail.
+
+	@param decoderRef An opaque reference to a decoder created by a
+	call to @ref CFHD_OpenDecoder.
+
+	@param samplePtr
+	Pointer to a sample containing one frame of encoded video in the
+	CineForm HD format.
+
+	@param sampleSize
+	Size of the encoded sample.
+
+	@param outputBuffer
+	Buffer that will receive the thumbnail of size 1/8 x 1/8 the original frame.
+
+	@param outputBufferSize
+	Size of the output buffer.  The rows of the thumbnail are not padded, so the
+	size must be at least the width times the pixel size times the height.
+
+	@param flags
+	Thumbnail flags (future usage).
+
+	@param pixelFormat
+	Pixel format of the thumbnail.  Any pixel format supported by the pixel
+	converter can be used.  The 10-bit RGB format (DPX0) returns the same
+	thumbnail as @ref CFHD_GetThumbnail.
+
+	@param retWidth
+	If successful contains thumbnail width.
+
+	@param retHeight
+	If successful contains thumbnail Height.
+
+	@param retSize
+	If successful contains thumbnail size in bytes.
+
+	@return Returns a CFHD error code.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_GetThumbnailInFormat(CFHD_DecoderRef decoderRef,
+						  void *samplePtr,
+						  size_t sampleSize,
+						  void *outputBuffer,
+						  size_t outputBufferSize,
+						  uint32_t flags,
+						  CFHD_PixelFormat pixelFormat,
+						  size_t *retWidth,
+						  size_t *retHeight,
+						  size_t *retSize)
+{
+	// Check the input arguments
+	if (decoderRef == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+	if (samplePtr == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+	if (outputBuffer == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleDecoder *decoder = reinterpret_cast<CSampleDecoder *>(decoderRef);
+
+	// Have the thumbnail flags been set?
+	if (flags == THUMBNAIL_FLAGS_NONE)
+	{
+		// Use the default thumbnail flags
+		flags = THUMBNAIL_FLAGS_DEFAULT;
+	}
+
+	return decoder->GetThumbnail(samplePtr, sampleSize, outputBuffer, outputBufferSize,
+								 flags, pixelFormat, retWidth, retHeight, retSize);
+}
+
+/*!
+	@function CFHD_GetThumbnailImages
+
+	@brief Extract thumbnails from a batch of samples
+
+	@description Each thumbnail is computed from the lowpass bands of the
+	sample without decompressing the sample, scaled to the dimensions of
+	the output image, and converted to the pixel format of the output image.
+	The buffers used for scaling and converting the thumbnails are kept in
+	the decoder, so the decoder does not allocate memory when the batch (or
+	the next batch) contains thumbnails with the same dimensions and format.
+
+	The decoder does not have to be prepared for decoding by a call to
+	CFHD_PrepareToDecode.
+
+	@param decoderRef An opaque reference to a decoder created by a
+	call to @ref CFHD_OpenDecoder.
+
+	@param samplePtrArray
+	Array of pointers to samples containing one frame of encoded video in
+	the CineForm HD format.
+
+	@param sampleSizeArray
+	Array of the sizes of the encoded samples.
+
+	@param outputArray
+	Array of descriptors for the output images (one for each sample).  The
+	output image can have any dimensions and any pixel format supported by
+	the pixel converter.
+
+	@param errorArray
+	Array that receives the error code for each sample (may be NULL).
+
+	@param count
+	Number of samples in the batch.
+
+	@return Returns the first error code in the batch.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_GetThumbnailImages(CFHD_DecoderRef decoderRef,
+						void **samplePtrArray,
+						size_t *sampleSizeArray,
+						CFHD_OutputDescriptor *outputArray,
+						CFHD_Error *errorArray,
+						int count)
+{
+	// Check the input arguments
+	if (decoderRef == NULL || samplePtrArray == NULL || sampleSizeArray == NULL ||
+		outputArray == NULL || count < 0) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleDecoder *decoder = reinterpret_cast<CSampleDecoder *>(decoderRef);
+
+	return decoder->GetThumbnailImages(samplePtrArray, sampleSizeArray, outputArray, errorArray, count);
+}
+
+
+/*!
+	@function CFHD_GetProxySample
+
+	@brief Create a proxy sample for decoding at a reduced resolution
+
+	@description The highpass bands that are not needed to decode the sample
+	at the requested resolution are replaced with empty bands.  The sample is
+	not decoded, so the proxy is created much faster than by transcoding.
+	The proxy has the same frame dimensions as the original sample and decoding
+	the proxy at the requested resolution, or lower, gives the same image as
+	decoding the original sample.  Bayer and uncompressed samples are not supported.
+
+	@param decoderRef An opaque reference to a decoder created by a
+	call to @ref CFHD_OpenDecoder.
+
+	@param samplePtr
+	Pointer to a sample containing one frame of encoded video in the
+	CineForm HD format.
+
+	@param sampleSize
+	Size of the encoded sample.
+
+	@param resolution
+	Either CFHD_DECODED_RESOLUTION_HALF or CFHD_DECODED_RESOLUTION_QUARTER.
+
+	@param outputBuffer
+	Buffer that will receive the proxy sample.
+
+	@param outputBufferSize
+	Size of the output buffer, which should be at least the size of the sample.
+
+	@param retSize
+	If successful contains the size of the proxy sample in bytes.
+
+	@return Returns a CFHD error code.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_GetProxySample(CFHD_DecoderRef decoderRef,
+					void *samplePtr,
+					size_t sampleSize,
+					CFHD_DecodedResolution resolution,
+					void *outputBuffer,
+					size_t outputBufferSize,
+					size_t *retSize)
+{
+	// Check the input arguments
+	if (decoderRef == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+	if (samplePtr == NULL || sampleSize == 0) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+	if (outputBuffer == NULL || retSize == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleDecoder *decoder = reinterpret_cast<CSampleDecoder *>(decoderRef);
+
+	return decoder->GetProxySample(
+					samplePtr,
+					sampleSize,
+					resolution,
+					outputBuffer,
+					outputBufferSize,
+					retSize);
+}
+
+
+/*!
+	@function CFHD_ValidateSample
+
+	@brief Check that a sample is well formed without decoding it
+
+	@description The tags in the sample are parsed using the chunk sizes to
+	skip over the encoded bands, so validation runs at memory speed.  The chunks
+	must be nested inside the sample, the sizes in the channel index must match
+	the channels, each channel must contain all of its subbands in order, and the
+	bands must have the dimensions of their wavelets.  Corruption inside the
+	entropy coded band data is only detected by the optional CRC.
+
+	@param decoderRef An opaque reference to a decoder created by a
+	call to @ref CFHD_OpenDecoder.
+
+	@param samplePtr
+	Pointer to a sample containing one frame of encoded video in the
+	CineForm HD format.
+
+	@param sampleSize
+	Size of the encoded sample.
+
+	@param flags
+	If CFHD_VALIDATE_FLAGS_COMPUTE_CRC is set the CRC-32 of the sample is
+	returned in crc.  If CFHD_VALIDATE_FLAGS_CHECK_CRC is set the CRC-32 of
+	the sample is compared with the value in crc.
+
+	@param crc
+	Pointer to the CRC of the sample (may be NULL if no CRC flags are set).
+
+	@return Returns CFHD_ERROR_BADSAMPLE if the sample is not well formed and
+	CFHD_ERROR_BAD_CRC if the CRC does not match.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_ValidateSample(CFHD_DecoderRef decoderRef,
+					void *samplePtr,
+					size_t sampleSize,
+					CFHD_ValidateFlags flags,
+					uint32_t *crc)
+{
+	// Check the input arguments
+	if (decoderRef == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+	if (samplePtr == NULL || sampleSize == 0) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+	if (crc == NULL && (flags & (CFHD_VALIDATE_FLAGS_COMPUTE_CRC | CFHD_VALIDATE_FLAGS_CHECK_CRC))) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleDecoder *decoder = reinterpret_cast<CSampleDecoder *>(decoderRef);
+
+	return decoder->ValidateSample(samplePtr, sampleSize, flags, crc);
+}
+
+
+/*!
+	@function CFHD_GetStereoEyeSample
+
+	@brief Return one eye of a stereo sample as a 2D sample
+
+	@description Each eye of a stereo sample is encoded as a complete sample,
+	so the sample for one eye is returned as a pointer into the stereo sample
+	without copying.  The eye sample can be decoded by a separate decoder as a
+	2D sample, which allows the two eyes to be decoded in parallel or only one
+	eye to be stored or transmitted.  The left eye of a 2D sample is the entire sample.
+
+	A decoder that is given the stereo sample still decodes the second eye on
+	its own internal decoder, so this routine does not change the time taken
+	to decode both eyes of a stereo sample.
+
+	@param decoderRef An opaque reference to a decoder created by a
+	call to @ref CFHD_OpenDecoder.
+
+	@param samplePtr
+	Pointer to a sample containing one frame of encoded video in the
+	CineForm HD format.
+
+	@param sampleSize
+	Size of the encoded sample.
+
+	@param eye
+	VIDEO_SELECT_LEFT_EYE (or VIDEO_SELECT_DEFAULT) for the first eye in the
+	sample or VIDEO_SELECT_RIGHT_EYE for the second eye.
+
+	@param eyeSamplePtr
+	Returns the address of the sample for the eye within the stereo sample.
+
+	@param eyeSampleSize
+	Returns the size of the sample for the eye.
+
+	@return Returns CFHD_ERROR_BADFORMAT if the sample does not contain the eye.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_GetStereoEyeSample(CFHD_DecoderRef decoderRef,
+						void *samplePtr,
+						size_t sampleSize,
+						CFHD_VideoSelect eye,
+						void **eyeSamplePtr,
+						size_t *eyeSampleSize)
+{
+	// Check the input arguments
+	if (decoderRef == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+	if (samplePtr == NULL || sampleSize == 0) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+	if (eyeSamplePtr == NULL || eyeSampleSize == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleDecoder *decoder = reinterpret_cast<CSampleDecoder *>(decoderRef);
+
+	return decoder->GetStereoEyeSample(samplePtr, sampleSize, eye, eyeSamplePtr, eyeSampleSize);
+}
+
+/*!
+	@function CFHD_GetDecoderStats
+
+	@brief Return the time spent in each stage of decoding.
+
+	@description Statistics are collected for each decoder after they are
+	enabled by calling this routine with CFHD_STATS_FLAGS_ENABLE.  The time
+	for each stage is recorded with the count, total time, longest time, and
+	a histogram of the times, and the entropy decoding and inverse transform
+	are also broken down by subband and wavelet.  Stages that run on worker
+	threads are timed on each thread, so the sum of the stages can exceed the
+	frame time.  Statistics are not collected by default and the only cost of
+	the statistics while disabled is a test of a pointer for each stage.
+
+	@param decoderRef An opaque reference to a decoder created by a
+	call to @ref CFHD_OpenDecoder.
+
+	@param statsOut
+	Returns the statistics collected since the statistics were last reset.
+	The pointer may be NULL if the call is only used to change the flags.
+
+	@param flags
+	CFHD_STATS_FLAGS_ENABLE or CFHD_STATS_FLAGS_DISABLE to start or stop
+	collecting statistics and CFHD_STATS_FLAGS_RESET to clear the statistics
+	after they are returned.
+
+	@return Returns a CFHD error code.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_GetDecoderStats(CFHD_DecoderRef decoderRef,
+					 CFHD_Stats *statsOut,
+					 CFHD_StatsFlags flags)
+{
+	// Check the input arguments
+	if (decoderRef == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleDecoder *decoder = reinterpret_cast<CSampleDecoder *>(decoderRef);
+
+	return decoder->GetDecoderStats(statsOut, flags);
+}
+
+/*!
+	@function CFHD_GetDecoderRequiredMemory
+
+	@brief Estimate the memory required to decode frames with the specified format.
+
+	@description The estimate covers the decoder, the wavelets, the scratch
+	buffers used by each thread, and the intermediate buffers used for color
+	conversion at the decoded resolution.  The output buffer is not included.
+	The estimate is an upper bound for the memory allocated by a decoder
+	prepared for the same frames with the same number of threads.
+
+	@param encodedWidth
+	Width of the encoded frames.
+
+	@param encodedHeight
+	Height of the encoded frames.
+
+	@param encodedFormat
+	Internal representation of the encoded frames.
+
+	@param encodingFlags
+	CFHD_ENCODING_FLAGS_YUV_2FRAME_GOP if the 4:2:2 frames are encoded in
+	groups of two frames, which requires more wavelets than intra frames.
+
+	@param outputFormat
+	Pixel format of the decoded frames.
+
+	@param decodedResolution
+	Resolution of the decoded frames.
+
+	@param threadCount
+	Number of threads used by the decoder or zero for the number of processors.
+
+	@param requiredMemoryOut
+	Returns the estimated number of bytes.
+
+	@return Returns a CFHD error code.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_GetDecoderRequiredMemory(int encodedWidth,
+							  int encodedHeight,
+							  CFHD_EncodedFormat encodedFormat,
+							  CFHD_EncodingFlags encodingFlags,
+							  CFHD_PixelFormat outputFormat,
+							  CFHD_DecodedResolution decodedResolution,
+							  int threadCount,
+							  size_t *requiredMemoryOut)
+{
+	// Check the input arguments
+	if (encodedWidth <= 0 || encodedHeight <= 0 || requiredMemoryOut == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	return CSampleDecoder::GetRequiredMemory(encodedWidth, encodedHeight, encodedFormat, encodingFlags,
+											 outputFormat, decodedResolution, threadCount, requiredMemoryOut);
+}
+
+/*!
+	@function CFHD_SetDecoderMemoryBudget
+
+	@brief Limit the memory allocated by the decoder.
+
+	@description The budget is applied the next time that the decoder is
+	prepared by @ref CFHD_PrepareToDecode.  The decoder uses fewer threads
+	until the estimate returned by @ref CFHD_GetDecoderRequiredMemory fits
+	within the budget and does not keep the look table after the color cube
+	has been built.  If the decoder does not fit within the budget with one
+	thread, CFHD_PrepareToDecode returns CFHD_ERROR_OUTOFMEMORY before any
+	buffers are allocated.
+
+	@param decoderRef An opaque reference to a decoder created by a
+	call to @ref CFHD_OpenDecoder.
+
+	@param memoryBudget
+	Maximum number of bytes allocated by the decoder or zero for no limit.
+
+	@return Returns a CFHD error code.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_SetDecoderMemoryBudget(CFHD_DecoderRef decoderRef,
+							size_t memoryBudget)
+{
+	// Check the input arguments
+	if (decoderRef == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleDecoder *decoder = reinterpret_cast<CSampleDecoder *>(decoderRef);
+
+	return decoder->SetMemoryBudget(memoryBudget);
+}
+
+/*!
+	@function CFHD_StartThreadTrace
+
+	@brief Start recording the timelines of the worker threads.
+
+	@description Each worker thread in the thread pools used by the decoders
+	and encoders records when it starts and finishes each unit of work, how
+	long it waits for the jobs that it depends on or for the pool lock, and
+	how long it is idle.  The events are kept in a ring buffer for each thread,
+	so only the most recent events are kept if the trace runs for a long time.
+	Pools that are already running are traced from the next time that they
+	are given work.  Tracing is global and is off by default.
+
+	@param eventsPerThread
+	Number of events kept for each thread or zero for the default.
+
+	@return Returns a CFHD error code.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_StartThreadTrace(uint32_t eventsPerThread)
+{
+	if (!ThreadTraceStart(eventsPerThread)) {
+		return CFHD_ERROR_OUTOFMEMORY;
+	}
+
+	return CFHD_ERROR_OKAY;
+}
+
+/*!
+	@function CFHD_StopThreadTrace
+
+	@brief Stop recording the timelines of the worker threads.
+
+	@description The events are written in the Chrome trace event format
+	(JSON) which can be opened in Perfetto or in chrome://tracing.  Each pool
+	is shown as a group of threads labeled with the name of the thread
+	procedure.  The memory for the events recorded by pools that have been
+	deleted is released after the trace is written.
+
+	@param pathname
+	Name of the file for the trace or NULL to discard the events.
+
+	@return Returns a CFHD error code.
+*/
+CFHDDECODER_API CFHD_Error
+CFHD_StopThreadTrace(const char *pathname)
+{
+	CFHD_Error error = CFHD_ERROR_OKAY;
+
+	ThreadTraceStop();
+
+	if (pathname != NULL)
+	{
+		FILE *file = fopen(pathname, "w");
+		if (file == NULL) {
+			error = CFHD_ERROR_FILE_CREATE;
+		}
+		else
+		{
+			if (!ThreadTraceWrite(file)) {
+				error = CFHD_ERROR_WRITE_FAILURE;
+			}
+			fclose(file);
+		}
+	}
+
+	ThreadTraceRelease();
+
+	return error;
+}
+
 
 
 /*!
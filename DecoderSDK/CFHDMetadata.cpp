@@ -45,6 +45,7 @@
 #include "SampleMetadata.h"
 #include "../Codec/metadata.h"
 #include "../Codec/lutpath.h"
+#include "../Codec/dbcache.h"
 
 
 #define BUFSIZE	1024
@@ -120,6 +121,7 @@ CFHD_OpenMetadata(CFHD_MetadataRef *metadataRefOut)
 	}
 
 	// Allocate a new data structure for metadata
+	CountMemoryAllocation();
 	CSampleMetadata *metadataRef = new CSampleMetadata;
 	if (metadataRef == NULL) {
 		return CFHD_ERROR_OUTOFMEMORY;
@@ -174,6 +176,7 @@ CFHD_InitSampleMetadata(CFHD_MetadataRef metadataRef,
 
 	metadata->m_sampleData = reinterpret_cast<unsigned char *>(sampleData);
 	metadata->m_sampleSize = sampleSize;
+	MetadataIndexReset(&metadata->m_sampleIndex);
 	metadata->m_currentData = metadata->m_sampleData;
 	metadata->m_currentSize = metadata->m_sampleSize;
 	metadata->m_metadataStart = NULL;
@@ -390,34 +393,6 @@ void *LeftRightDelta(CSampleMetadata *metadata,
 	return ldata;
 }
 
-#if _WIN32
-uint32_t GetLastWriteTime(char *name)
-{
-    HANDLE hFile;
-    FILETIME ftCreate, ftAccess, ftWrite;
-	uint32_t ret = 0;
-
-    hFile = CreateFile(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
-    if(hFile == INVALID_HANDLE_VALUE)
-    {
-        return 0;
-    }        
-
-    // Retrieve the file times for the file.
-    if (!GetFileTime(hFile, &ftCreate, &ftAccess, &ftWrite))
-	{
-	    CloseHandle(hFile);    
-        return 0;
-	}
-
-	ret = ftWrite.dwLowDateTime;
-
-    CloseHandle(hFile);    
-
-	return ret;
-}
-#endif
-
 
 //TODO: Needs upgrade for stereo, col2, colb and global overrides.
 bool CSampleMetadata::GetClipDatabase()
@@ -430,8 +405,7 @@ bool CSampleMetadata::GetClipDatabase()
 		METADATA_SIZE size;
 		METADATA_TYPE type;
 
-		data = MetaDataFindInSample(m_sampleData, m_sampleSize,
-									TAG_CLIP_GUID, &size, &type);
+		data = FindInSample(TAG_CLIP_GUID, &size, &type);
 		if (data)
 		{
 			if(size == sizeof(m_currentClipGUID))
@@ -455,7 +429,6 @@ bool CSampleMetadata::GetClipDatabase()
 			InitGetLUTPaths(PathStr, (size_t)sizeof(PathStr), DBStr, (size_t)sizeof(DBStr));
 		}
 		//GetLUTPath(PathStr);
-		bool checkdiskinfo = false;
 
 #ifdef _WIN32
 		sprintf_s(filenameGUID, sizeof(filenameGUID), 
@@ -477,46 +450,27 @@ bool CSampleMetadata::GetClipDatabase()
 					m_currentClipGUID.Data4[7]);
 
 
-#if _WIN32
-		uint32_t write_time = GetLastWriteTime(filenameGUID);
-		//char t[100];
-		//sprintf(t,"last_write_time %d %s", last_write_time,filenameGUID);
-		//OutputDebugString(t);
-		if(write_time != last_write_time || m_databaseSize == 0)
-		{
-			last_write_time = write_time;
-			checkdiskinfo = true;
-		}
-#else
-		//TODO -- something like the above for Mac/Linux
+		// Only check the shared cache periodically since each check takes the process-wide cache lock
+		bool checkdiskinfo = false;
 		clock_t process_time = clock();
 		time_t now = time(NULL);
 		uint32_t diff = (uint32_t)process_time - (uint32_t)last_process_time;
 
 		#define MS_DIFF	(CLOCKS_PER_SEC / 15)
-		if(diff > MS_DIFF || last_process_time==0 || last_now_time != now) // only test every 1000ms
+		if(diff > MS_DIFF || last_process_time==0 || last_now_time != now)
 		{	
-			last_process_time = (unsigned int)process_time;
+			last_process_time = process_time;
 			last_now_time = now;
 			checkdiskinfo = true;
 		}
-#endif
 
-		if(checkdiskinfo)
+		// The database file is shared with the other decoders and reread only when the file changes
+		DISK_DATABASE *database = checkdiskinfo ? AcquireDiskDatabase(filenameGUID) : NULL;
+		if (database)
 		{
-			FILE *fp;
-			int err = 0;
-
-#ifdef _WIN32
-			err = fopen_s(&fp, filenameGUID, "rb");
-#else
-			fp = fopen(filenameGUID, "rb");
-#endif
-			if (err == 0 && fp != NULL)
+			if(database->generation != m_databaseGeneration || m_databaseData == NULL)
 			{
-				uint32_t len = 0;
-				fseek (fp, 0, SEEK_END);
-				len = ftell(fp);
+				uint32_t len = (uint32_t)database->size;
 
 				if(m_databaseSize > 0 && m_databaseSize < len && m_databaseData)
 				{
@@ -529,22 +483,20 @@ bool CSampleMetadata::GetClipDatabase()
 
 				if(m_databaseData)
 				{
-					fseek (fp, 0, SEEK_SET);
-#ifdef _MSC_VER
-					len = (uint32_t)fread_s(m_databaseData, len, 1, len, fp);
-#else
-					len = (uint32_t)fread(m_databaseData,1,len,fp);
-#endif
-
+					memcpy(m_databaseData, database->data, len);
 					m_databaseSize = ValidMetadataLength(m_databaseData, len);
+					m_databaseGeneration = database->generation;
 				}
 				else
 				{
 					m_databaseSize = 0;
 				}
 
-				fclose(fp);
+				// The database may have changed so the index must be rebuilt
+				MetadataIndexReset(&m_databaseIndex);
 			}
+
+			ReleaseDiskDatabase(database);
 		}
 
 	/*	DAN20120104 -- stop loading very old .COL1 and .COL2 files.
@@ -754,8 +706,7 @@ CFHD_ReadMetadata(CFHD_MetadataRef metadataRef,
 			METADATA_TYPE type;
 			METADATA_SIZE size;
 
-			data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-										TAG_PROCESS_PATH, &size, &type);
+			data = metadata->FindInSample(TAG_PROCESS_PATH, &size, &type);
 			if (data)
 			{
 				metadata->m_active_mask = *((unsigned int *)data);
@@ -768,8 +719,7 @@ CFHD_ReadMetadata(CFHD_MetadataRef metadataRef,
 			if(metadata->GetClipDatabase())
 			{
 //dan20100916 MetaDataFindInSample
-				data = MetadataFind(metadata->m_databaseData, metadata->m_databaseSize,
-											TAG_PROCESS_PATH, &size, &type);
+				data = metadata->FindInDatabase(TAG_PROCESS_PATH, &size, &type);
 				if (data)
 				{
 					metadata->m_active_mask = *((unsigned int *)data);
@@ -852,8 +802,7 @@ CFHD_ReadMetadata(CFHD_MetadataRef metadataRef,
 			METADATA_SIZE lsize;
 			METADATA_TYPE lctype;
 //dan20100916 was MetaDataFindInSample
-			ldata = MetadataFind(metadata->m_databaseData, metadata->m_databaseSize,
-										 *tag, &lsize, &lctype);
+			ldata = metadata->FindInDatabase(*tag, &lsize, &lctype);
 
 			if (ldata)
 			{
@@ -894,8 +843,7 @@ CFHD_ReadMetadata(CFHD_MetadataRef metadataRef,
 						void *data = NULL;
 						METADATA_TYPE type;
 						METADATA_SIZE size;
-						data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-											TAG_UNIQUE_FRAMENUM, &size, &type);
+						data = metadata->FindInSample(TAG_UNIQUE_FRAMENUM, &size, &type);
 						if (data)
 						{
 							metadata->m_currentUFRM = *(int *)data;
@@ -1087,8 +1035,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 				METADATA_TYPE type;
 				METADATA_SIZE size;
 				//unsigned int tag;
-				data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-											TAG_PROCESS_PATH, &size, &type);
+				data = metadata->FindInSample(TAG_PROCESS_PATH, &size, &type);
 				if (data)
 				{
 					metadata->m_active_mask = *((unsigned int *)data);
@@ -1101,8 +1048,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 				if(metadata->GetClipDatabase())
 				{
 //dan20100916 was MetaDataFindInSample
-					data = MetadataFind(metadata->m_databaseData, metadata->m_databaseSize,
-												TAG_PROCESS_PATH, &size, &type);
+					data = metadata->FindInDatabase(TAG_PROCESS_PATH, &size, &type);
 					if (data)
 					{
 						metadata->m_active_mask = *((unsigned int *)data);
@@ -1126,8 +1072,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 
 				if(metadata->m_sampleData && metadata->m_sampleSize) // which is absolutely should have
 				{
-					data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-												TAG_CLIP_GUID, &size, &type);
+					data = metadata->FindInSample(TAG_CLIP_GUID, &size, &type);
 					if (data)
 					{
 						if(size == sizeof(metadata->m_currentClipGUID))
@@ -1151,8 +1096,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 
 				if(metadata->m_sampleData && metadata->m_sampleSize) // which is absolutely should have
 				{
-					data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-												TAG_CLIP_GUID, &size, &type);
+					data = metadata->FindInSample(TAG_CLIP_GUID, &size, &type);
 					if (data)
 					{
 						uint16_t *sptr = (uint16_t *)data;
@@ -1177,8 +1121,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 		//	OutputDebugString(t);
 
 			//fprintf(stdout,"Call MetaDataFindInSample\n");
-			*data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-        			tag, size, &ctype);
+			*data = metadata->FindInSample(tag, size, &ctype);
 			//fprintf(stdout, "Metadata is at %08x\n",*data);
 		}
 		
@@ -1217,8 +1160,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 				}
 				else
 				{
-					ldata = MetadataFind(metadata->m_databaseData, metadata->m_databaseSize,
-												  tag, &lsize, &lctype);
+					ldata = metadata->FindInDatabase(tag, &lsize, &lctype);
 				}
 				if (ldata)
 				{
@@ -1260,8 +1202,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 							void *data = NULL;
 							METADATA_TYPE type;
 							METADATA_SIZE size;
-							data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-												TAG_UNIQUE_FRAMENUM, &size, &type);
+							data = metadata->FindInSample(TAG_UNIQUE_FRAMENUM, &size, &type);
 							if (data)
 							{
 								metadata->m_currentUFRM = *(int *)data;
@@ -66,6 +66,7 @@
 #include "ConvertLib.h"			// Color conversion routines
 //#include "ImageUtilities.h"
 #include "Conversion.h"
+#include "FrameScaler.h"
 
 
 #include "decoder.h"				// Decoder data structure and entry points
@@ -109,10 +110,71 @@ unsigned short _byteswap_ushort(unsigned short x)
 //TODO: Replace system log output with logfile output
 #define SYSLOG (0)
 
+// Return the pixel format used by the pixel converter for the decoded format
+static CFHD_PixelFormat ConverterPixelFormat(int decodedFormat)
+{
+	switch (decodedFormat)
+	{
+	case DECODED_FORMAT_UYVY:				return CFHD_PIXEL_FORMAT_2VUY;
+	case DECODED_FORMAT_YUYV:				return CFHD_PIXEL_FORMAT_YUY2;
+	case DECODED_FORMAT_RGB32:				return CFHD_PIXEL_FORMAT_BGRA;
+	case DECODED_FORMAT_RGB32_INVERTED:		return CFHD_PIXEL_FORMAT_BGRa;
+	case DECODED_FORMAT_RGB24:				return CFHD_PIXEL_FORMAT_RG24;
+	case DECODED_FORMAT_V210:				return CFHD_PIXEL_FORMAT_V210;
+	case DECODED_FORMAT_YU64:				return CFHD_PIXEL_FORMAT_YU64;
+	case DECODED_FORMAT_RG48:				return CFHD_PIXEL_FORMAT_RG48;
+	case DECODED_FORMAT_WP13:				return CFHD_PIXEL_FORMAT_WP13;
+	case DECODED_FORMAT_W13A:				return CFHD_PIXEL_FORMAT_W13A;
+	case DECODED_FORMAT_RG64:				return CFHD_PIXEL_FORMAT_RG64;
+	case DECODED_FORMAT_RG30:				return CFHD_PIXEL_FORMAT_RG30;
+	case DECODED_FORMAT_R210:				return CFHD_PIXEL_FORMAT_R210;
+	case DECODED_FORMAT_DPX0:				return CFHD_PIXEL_FORMAT_DPX0;
+	case DECODED_FORMAT_AR10:				return CFHD_PIXEL_FORMAT_AR10;
+	case DECODED_FORMAT_AB10:				return CFHD_PIXEL_FORMAT_AB10;
+	case DECODED_FORMAT_NV12:				return CFHD_PIXEL_FORMAT_NV12;
+	case DECODED_FORMAT_YV12:				return CFHD_PIXEL_FORMAT_YV12;
+	case DECODED_FORMAT_B64A:				return CFHD_PIXEL_FORMAT_B64A;
+	case DECODED_FORMAT_R408:				return CFHD_PIXEL_FORMAT_R408;
+	case DECODED_FORMAT_V408:				return CFHD_PIXEL_FORMAT_V408;
+	case DECODED_FORMAT_CT_UCHAR:			return CFHD_PIXEL_FORMAT_CT_UCHAR;
+	case DECODED_FORMAT_CT_SHORT:			return CFHD_PIXEL_FORMAT_CT_SHORT;
+	case DECODED_FORMAT_CT_10Bit_2_8:		return CFHD_PIXEL_FORMAT_CT_10BIT_2_8;
+	case DECODED_FORMAT_CT_SHORT_2_14:		return CFHD_PIXEL_FORMAT_CT_SHORT_2_14;
+	case DECODED_FORMAT_CT_USHORT_10_6:		return CFHD_PIXEL_FORMAT_CT_USHORT_10_6;
+
+	default:
+		return CFHD_PIXEL_FORMAT_UNKNOWN;
+	}
+}
+
+// Is there a conversion routine for this pair of formats that is used instead of the pixel converter?
+static bool IsDedicatedConversion(int inputFormat, CFHD_PixelFormat outputFormat)
+{
+	switch (inputFormat)
+	{
+	case DECODED_FORMAT_YU64:
+		return (outputFormat == CFHD_PIXEL_FORMAT_B64A || outputFormat == CFHD_PIXEL_FORMAT_CT_10BIT_2_8);
+
+	case DECODED_FORMAT_B64A:
+		return (outputFormat == CFHD_PIXEL_FORMAT_B64A);
+
+	case DECODED_FORMAT_CT_UCHAR:
+	case DECODED_FORMAT_CT_10Bit_2_8:
+	case DECODED_FORMAT_CT_SHORT_2_14:
+	case DECODED_FORMAT_CT_USHORT_10_6:
+	case DECODED_FORMAT_CT_SHORT:
+		return (outputFormat == ConverterPixelFormat(inputFormat));
+
+	default:
+		return false;
+	}
+}
+
 // Convert the input image format to the output format
 CFHD_Error ConvertToOutputBuffer(void *inputBuffer, int inputPitch, int inputFormat,
 								 void *outputBuffer, int outputPitch, CFHD_PixelFormat outputFormat,
-								 int width, int height, int byte_swap_flag)
+								 int width, int height, int byte_swap_flag,
+								 CPixelConverter *converter)
 {
 	CFHD_Error error = CFHD_ERROR_OKAY;
 
@@ -122,8 +184,24 @@ CFHD_Error ConvertToOutputBuffer(void *inputBuffer, int inputPitch, int inputFor
 			width, height, inputFormat, CStringFromOSType(outputFormat));
 #endif
 
+	// Use the pixel converter for the formats that do not have a dedicated conversion routine
+	if (!IsDedicatedConversion(inputFormat, outputFormat))
+	{
+		// The converter and its worker threads are reused for every frame
+		assert(converter != NULL);
+
+		if (!converter->Convert(inputBuffer, inputPitch, ConverterPixelFormat(inputFormat),
+								outputBuffer, outputPitch, outputFormat,
+								width, height))
+		{
+			// Unsupported input or output format
+			ASSERT(0);
+			error = CFHD_ERROR_BADFORMAT;
+		}
+	}
+
 	// Was the frame decoded to the YU64 pixel format?
-	if (inputFormat == DECODED_FORMAT_YU64)
+	else if (inputFormat == DECODED_FORMAT_YU64)
 	{
 		if (outputFormat == CFHD_PIXEL_FORMAT_B64A)
 		{
@@ -451,12 +529,33 @@ bail:
 	return error;
 }
 
+// Is there a scaling routine for this pair of formats that is used instead of the pixel converter?
+static bool IsDedicatedScaling(int inputFormat, CFHD_PixelFormat outputFormat)
+{
+	switch (inputFormat)
+	{
+	case DECODED_FORMAT_YU64:
+		return (outputFormat == CFHD_PIXEL_FORMAT_B64A);
+
+	case DECODED_FORMAT_RGBA:
+		return (outputFormat == CFHD_PIXEL_FORMAT_BGRA || outputFormat == CFHD_PIXEL_FORMAT_BGRa);
+
+	case DECODED_FORMAT_B64A:
+		return (outputFormat == CFHD_PIXEL_FORMAT_B64A ||
+				outputFormat == CFHD_PIXEL_FORMAT_BGRA ||
+				outputFormat == CFHD_PIXEL_FORMAT_BGRa);
+
+	default:
+		return false;
+	}
+}
+
 // Scale the input image to fit the dimensions of the output image
 CFHD_Error ScaleToOutputBuffer(void *inputBuffer, int inputWidth, int inputHeight,
 							   int inputPitch, int inputFormat,
 							   void *outputBuffer, int outputWidth, int outputHeight,
 							   int outputPitch, CFHD_PixelFormat outputFormat,
-							   int byte_swap_flag)
+							   int byte_swap_flag, CFrameScaler *scaler)
 {
 	CFHD_Error error = CFHD_ERROR_OKAY;
 
@@ -470,7 +569,20 @@ CFHD_Error ScaleToOutputBuffer(void *inputBuffer, int inputWidth, int inputHeigh
 			outputWidth, outputHeight, outputPitch, CStringFromOSType(outputFormat));
 #endif
 
-	if (inputFormat == DECODED_FORMAT_YU64)
+	// Use the frame scaler for the formats that do not have a dedicated scaling routine
+	if (!IsDedicatedScaling(inputFormat, outputFormat))
+	{
+		assert(scaler != NULL);
+		if (!scaler->Scale(inputBuffer, inputPitch, ConverterPixelFormat(inputFormat),
+						   inputWidth, inputHeight,
+						   outputBuffer, outputPitch, outputFormat,
+						   outputWidth, outputHeight))
+		{
+			error = CFHD_ERROR_BADFORMAT;
+		}
+		ASSERT(error == CFHD_ERROR_OKAY);
+	}
+	else if (inputFormat == DECODED_FORMAT_YU64)
 	{
 		// Allocate and initialize an image scaler with color conversion
 		CImageScalerConverterYU64ToRGB scaler(&allocator);
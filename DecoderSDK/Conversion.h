@@ -39,6 +39,9 @@
 #define k4444YpCbCrA32RPixelFormat 'r4fl'
 
 #ifdef __cplusplus
+class CPixelConverter;
+class CFrameScaler;
+
 extern "C"
 {
 #endif
@@ -87,17 +90,18 @@ __inline static const char *CStringFromOSType(unsigned int fourcc)
 	return string;
 }
 
-// Convert the input image format to the output format
+// Convert the input image format to the output format (the pixel converter is kept by the caller)
 CFHD_Error ConvertToOutputBuffer(void *inputBuffer, int inputPitch, int inputFormat,
 								 void *outputBuffer, int outputPitch, CFHD_PixelFormat outputFormat,
-								 int width, int height, int byte_swap_flag);
+								 int width, int height, int byte_swap_flag,
+								 CPixelConverter *converter);
 
-// Scale the input image to fit the dimensions of the output image
+// Scale the input image to fit the dimensions of the output image (the frame scaler is kept by the caller)
 CFHD_Error ScaleToOutputBuffer(void *inputBuffer, int inputWidth, int inputHeight,
 							   int inputPitch, int inputFormat,
 							   void *outputBuffer, int outputWidth, int outputHeight,
 							   int outputPitch, CFHD_PixelFormat outputFormat,
-							   int byte_swap_flag);
+							   int byte_swap_flag, CFrameScaler *scaler);
 
 #ifdef __cplusplus
 }
@@ -85,6 +85,12 @@ public:
 		void *outputBuffer,
 		int outputPitch) = 0;
 
+	virtual CFHD_Error DecodeSampleOutputs(
+		void *samplePtr,
+		size_t sampleSize,
+		CFHD_OutputDescriptor *outputArray,
+		int outputCount) = 0;
+
 	virtual CFHD_Error GetFrameFormat(int &width, int &height, CFHD_PixelFormat &format) = 0;
 
 	virtual CFHD_Error GetRequiredBufferSize(uint32_t &bytes) = 0;
@@ -56,7 +56,10 @@
 
 // Include files from the codec library
 #include "decoder.h"
+#include "cpuid.h"
 #include "thumbnail.h"
+#include "proxy.h"
+#include "validate.h"
 #include "metadata.h"
 
 // Include files for the encoder DLL
@@ -70,6 +73,14 @@
 #include "SampleDecoder.h"
 #include "Conversion.h"
 
+// Define the assert macro used by the conversion library
+#ifndef ASSERT
+#define ASSERT(x)	assert(x)
+#endif
+
+#include "ThumbnailScaler.h"
+#include "FrameScaler.h"
+
 //TODO: Need to add logfile capability
 #define LOGFILE 0
 
@@ -112,7 +123,7 @@ static struct decodedFormatEntry
 	{{CFHD_PIXEL_FORMAT_BGRa,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_RGB32_INVERTED,	4},	// BGRA
 	{{CFHD_PIXEL_FORMAT_RG24,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_RGB24,	3},	// RGB
 	{{CFHD_PIXEL_FORMAT_B64A,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_B64A,	8},	// b64a
-	{{CFHD_PIXEL_FORMAT_RG64,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_RG64,	8},	// RG64
+	{{CFHD_PIXEL_FORMAT_RG64,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_B64A,	8},	// RG64 (converted from b64a)
 	{{CFHD_PIXEL_FORMAT_R210,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_R210,	4},	// r210
 	{{CFHD_PIXEL_FORMAT_DPX0,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_DPX0,	4},	// DPX0
 	{{CFHD_PIXEL_FORMAT_RG30,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_RG30,	4},	// RG30
@@ -120,6 +131,7 @@ static struct decodedFormatEntry
 	{{CFHD_PIXEL_FORMAT_AR10,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_AR10,	4},	// AR10
 	{{CFHD_PIXEL_FORMAT_YU64,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_YU64,	4}, // YU64
 	{{CFHD_PIXEL_FORMAT_RG48,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_RG48,	6},	// RG48
+	{{CFHD_PIXEL_FORMAT_B48R,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_RG48,	6},	// b48r
 	{{CFHD_PIXEL_FORMAT_WP13,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_WP13,	6},	// WP13
 	{{CFHD_PIXEL_FORMAT_W13A,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_W13A,	8},	// W13A
 	{{CFHD_PIXEL_FORMAT_YUYV,	ENCODED_FORMAT_YUV_422},	DECODED_FORMAT_YUYV,	2},	// yuyv
@@ -130,7 +142,7 @@ static struct decodedFormatEntry
 	{{CFHD_PIXEL_FORMAT_YUY2,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_YUYV,	2},	// YUY2
 	{{CFHD_PIXEL_FORMAT_V210,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_V210,	3},	// v210
 	{{CFHD_PIXEL_FORMAT_B64A,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_B64A,	8},	// b64a
-	{{CFHD_PIXEL_FORMAT_RG64,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_RG64,	8},	// RG64
+	{{CFHD_PIXEL_FORMAT_RG64,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_B64A,	8},	// RG64 (converted from b64a)
 	{{CFHD_PIXEL_FORMAT_R210,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_R210,	4},	// r210
 	{{CFHD_PIXEL_FORMAT_DPX0,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_DPX0,	4},	// DPX0
 	{{CFHD_PIXEL_FORMAT_RG30,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_RG30,	4},	// RG30
@@ -141,6 +153,7 @@ static struct decodedFormatEntry
 	{{CFHD_PIXEL_FORMAT_BGRa,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_RGB32_INVERTED,	4},	// BGRA
 	{{CFHD_PIXEL_FORMAT_RG24,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_RGB24,	3},	// RGB
 	{{CFHD_PIXEL_FORMAT_RG48,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_RG48,	6},	// RG48
+	{{CFHD_PIXEL_FORMAT_B48R,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_RG48,	6},	// b48r
 	{{CFHD_PIXEL_FORMAT_WP13,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_WP13,	6},	// WP13
 	{{CFHD_PIXEL_FORMAT_W13A,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_W13A,	8},	// W13A
 	{{CFHD_PIXEL_FORMAT_YUYV,	ENCODED_FORMAT_RGB_444},	DECODED_FORMAT_YUYV,	2},	// yuyv
@@ -151,7 +164,7 @@ static struct decodedFormatEntry
 	{{CFHD_PIXEL_FORMAT_YUY2,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_YUYV,	2},	// YUY2
 	{{CFHD_PIXEL_FORMAT_V210,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_V210,	3},	// v210
 	{{CFHD_PIXEL_FORMAT_B64A,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_B64A,	8},	// b64a
-	{{CFHD_PIXEL_FORMAT_RG64,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_RG64,	8},	// RG64
+	{{CFHD_PIXEL_FORMAT_RG64,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_B64A,	8},	// RG64 (converted from b64a)
 	{{CFHD_PIXEL_FORMAT_R210,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_R210,	4},	// r210
 	{{CFHD_PIXEL_FORMAT_DPX0,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_DPX0,	4},	// DPX0
 	{{CFHD_PIXEL_FORMAT_RG30,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_RG30,	4},	// RG30
@@ -162,6 +175,7 @@ static struct decodedFormatEntry
 	{{CFHD_PIXEL_FORMAT_BGRa,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_RGB32_INVERTED,	4},	// BGRA
 	{{CFHD_PIXEL_FORMAT_RG24,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_RGB24,	3},	// RGB
 	{{CFHD_PIXEL_FORMAT_RG48,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_RG48,	6},	// RG48
+	{{CFHD_PIXEL_FORMAT_B48R,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_RG48,	6},	// b48r
 	{{CFHD_PIXEL_FORMAT_WP13,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_WP13,	6},	// WP13
 	{{CFHD_PIXEL_FORMAT_W13A,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_W13A,	8},	// W13A
 	{{CFHD_PIXEL_FORMAT_YUYV,	ENCODED_FORMAT_RGBA_4444},	DECODED_FORMAT_YUYV,	2},	// yuyv
@@ -172,7 +186,7 @@ static struct decodedFormatEntry
 	{{CFHD_PIXEL_FORMAT_YUY2,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_YUYV,	2},	// YUY2
 	{{CFHD_PIXEL_FORMAT_V210,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_V210,	3},	// v210
 	{{CFHD_PIXEL_FORMAT_B64A,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_B64A,	8},	// b64a
-	{{CFHD_PIXEL_FORMAT_RG64,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_RG64,	8},	// RG64
+	{{CFHD_PIXEL_FORMAT_RG64,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_B64A,	8},	// RG64 (converted from b64a)
 	{{CFHD_PIXEL_FORMAT_R210,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_R210,	4},	// r210
 	{{CFHD_PIXEL_FORMAT_DPX0,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_DPX0,	4},	// DPX0
 	{{CFHD_PIXEL_FORMAT_RG30,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_RG30,	4},	// RG30
@@ -182,6 +196,7 @@ static struct decodedFormatEntry
 	{{CFHD_PIXEL_FORMAT_BGRa,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_RGB32_INVERTED,	4},	// BGRA
 	{{CFHD_PIXEL_FORMAT_RG24,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_RGB24,	3},	// RGB
 	{{CFHD_PIXEL_FORMAT_RG48,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_RG48,	6},	// RG48
+	{{CFHD_PIXEL_FORMAT_B48R,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_RG48,	6},	// b48r
 	{{CFHD_PIXEL_FORMAT_WP13,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_WP13,	6},	// WP13
 	{{CFHD_PIXEL_FORMAT_W13A,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_W13A,	8},	// W13A
 	{{CFHD_PIXEL_FORMAT_YUYV,	ENCODED_FORMAT_BAYER},		DECODED_FORMAT_YUYV,	2},	// yuyv
@@ -315,6 +330,7 @@ switch (format)
 case CFHD_PIXEL_FORMAT_YUY2:
 case CFHD_PIXEL_FORMAT_2VUY:
 case CFHD_PIXEL_FORMAT_YUYV:
+case CFHD_PIXEL_FORMAT_CT_UCHAR:			// Avid 8-bit CbYCrY 4:2:2
 case CFHD_PIXEL_FORMAT_BYR2:
 case CFHD_PIXEL_FORMAT_BYR4:
 case CFHD_PIXEL_FORMAT_CT_10BIT_2_8:		// Avid format with two planes of 2-bit and 8-bit pixels
@@ -342,6 +358,7 @@ pixelSize = 4;
 break;
 
 case CFHD_PIXEL_FORMAT_RG48:
+case CFHD_PIXEL_FORMAT_B48R:
 case CFHD_PIXEL_FORMAT_WP13:
 pixelSize = 6;
 break;
@@ -384,6 +401,46 @@ __inline static size_t Align16(size_t x)
 	return ((x + 0x0F) & ~0x0F);
 }
 
+// Pitch of the buffer for a decoded frame that is converted to the output format
+static int32_t DecodedFramePitch(int width, CFHD_PixelFormat outputFormat, uint32_t decodedPixelSize)
+{
+	// The decoded pixels can be larger than the output pixels (av28 is decoded as YU64 from RGB samples)
+	int32_t outputPitch = GetFramePitch(width, outputFormat);
+	int32_t decodedPitch = (int32_t)Align16(width * decodedPixelSize);
+
+	return (outputPitch > decodedPitch) ? outputPitch : decodedPitch;
+}
+
+// Pitch of a thumbnail in the pixel format without padding at the end of each row
+static int ThumbnailPitch(int width, CFHD_PixelFormat format)
+{
+	switch (format)
+	{
+	case CFHD_PIXEL_FORMAT_V210:
+		return V210FramePitch(width);
+
+	case CFHD_PIXEL_FORMAT_NV12:
+	case CFHD_PIXEL_FORMAT_YV12:
+		// Pitch of the luma plane
+		return width;
+
+	default:
+		return width * GetPixelSize(format);
+	}
+}
+
+// Size of a thumbnail in the pixel format including the chroma planes
+static size_t ThumbnailSize(int width, int height, CFHD_PixelFormat format)
+{
+	size_t pitch = ThumbnailPitch(width, format);
+
+	if (format == CFHD_PIXEL_FORMAT_NV12 || format == CFHD_PIXEL_FORMAT_YV12) {
+		return pitch * (height + (height + 1) / 2);
+	}
+
+	return pitch * height;
+}
+
 CSampleDecoder::CSampleDecoder(CFHD_ALLOCATOR *allocator,
 							   CFHD_LicenseKey license,
 							   FILE *logfile) :
@@ -405,9 +462,20 @@ CSampleDecoder::CSampleDecoder(CFHD_ALLOCATOR *allocator,
 	m_decodedFramePitch(0),
 	m_decodingFlags(CFHD_DECODING_FLAGS_NONE),
 	m_preparedForThumbnails(false),
+	m_thumbnailBuffer(NULL),
+	m_thumbnailBufferSize(0),
+	m_thumbnailScaler(NULL),
+	m_pixelConverter(NULL),
+	m_frameScaler(NULL),
 	m_channelsActive(1),
-	m_channelMix(0)
+	m_channelMix(0),
+	m_telemetry(NULL),
+	m_telemetryEnabled(false),
+	m_memoryBudget(0)
 {
+	memset(m_lowpassFrameBuffer, 0, sizeof(m_lowpassFrameBuffer));
+	memset(m_lowpassFrameSize, 0, sizeof(m_lowpassFrameSize));
+
 	if (license)
 	{
 		// Copy the license provided as an argument
@@ -435,6 +503,20 @@ CSampleDecoder::CSampleDecoder(CFHD_ALLOCATOR *allocator,
 CSampleDecoder::~CSampleDecoder()
 {
 	ReleaseDecoder();
+
+	// Free the scratch memory used for thumbnails
+	if (m_thumbnailBuffer) {
+		::FreeAligned(m_allocator, m_thumbnailBuffer);
+		m_thumbnailBuffer = NULL;
+	}
+	delete m_thumbnailScaler;
+	delete m_pixelConverter;
+	delete m_frameScaler;
+
+	if (m_telemetry) {
+		ReleaseTelemetry(m_telemetry);
+		delete m_telemetry;
+	}
 }
 
 
@@ -853,6 +935,131 @@ finish:
 	return errorCode;
 }
 
+// Convert the sample decoder encoded format to the codec internal encoded format
+static ENCODED_FORMAT CodecEncodedFormat(CFHD_EncodedFormat encodedFormat)
+{
+	switch (encodedFormat)
+	{
+	case CFHD_ENCODED_FORMAT_RGB_444:
+		return ENCODED_FORMAT_RGB_444;
+
+	case CFHD_ENCODED_FORMAT_RGBA_4444:
+		return ENCODED_FORMAT_RGBA_4444;
+
+	case CFHD_ENCODED_FORMAT_BAYER:
+		return ENCODED_FORMAT_BAYER;
+
+	case CFHD_ENCODED_FORMAT_YUVA_4444:
+		return ENCODED_FORMAT_YUVA_4444;
+
+	case CFHD_ENCODED_FORMAT_YUV_422:
+	default:
+		return ENCODED_FORMAT_YUV_422;
+	}
+}
+
+// Number of threads used by a decoder that does not have a thread limit
+static int DefaultThreadCount()
+{
+	int processorCount = GetProcessorCount();
+
+	if (processorCount < 1) {
+		processorCount = 1;
+	}
+	if (processorCount > _MAX_CPUS) {
+		processorCount = _MAX_CPUS;
+	}
+
+	return processorCount;
+}
+
+// Estimate the memory allocated by PrepareDecoder and DecodeSample for the specified frames
+static size_t RequiredMemory(int encodedWidth, int encodedHeight, ENCODED_FORMAT encodedFormat,
+							 DECODED_FORMAT decodedFormat, uint32_t decodedPixelSize, int decodedResolution, bool group,
+							 int decodedWidth, int decodedHeight, CFHD_PixelFormat outputFormat,
+							 int threadCount)
+{
+	size_t size = DecoderSize();
+
+	size += DecoderMemorySize(encodedWidth, encodedHeight, encodedFormat, decodedFormat,
+							  decodedResolution, group, threadCount);
+
+	// Buffer for the decoded frame if it must be converted to the output format
+	if (!IsSameFormat(decodedFormat, outputFormat)) {
+		size += Align16(decodedHeight) * DecodedFramePitch((int)Align16(decodedWidth), outputFormat, decodedPixelSize);
+	}
+
+	return size;
+}
+
+/*!
+	@brief Estimate the memory required to decode frames with the specified format
+
+	The estimate includes the decoder, the wavelets, the scratch and thread buffers,
+	and the intermediate buffers used for color conversion, but not the output buffer.
+*/
+CFHD_Error
+CSampleDecoder::GetRequiredMemory(int encodedWidth,
+								  int encodedHeight,
+								  CFHD_EncodedFormat encodedFormat,
+								  CFHD_EncodingFlags encodingFlags,
+								  CFHD_PixelFormat outputFormat,
+								  CFHD_DecodedResolution decodedResolution,
+								  int threadCount,
+								  size_t *requiredMemoryOut)
+{
+	ENCODED_FORMAT codecEncodedFormat = CodecEncodedFormat(encodedFormat);
+	DECODED_FORMAT decodedFormat = DECODED_FORMAT_UNSUPPORTED;
+	uint32_t decodedPixelSize = 0;
+	int outputWidth = encodedWidth;
+	int outputHeight = encodedHeight;
+	int resolution;
+	bool group = (encodedFormat == CFHD_ENCODED_FORMAT_YUV_422 && (encodingFlags & CFHD_ENCODING_FLAGS_YUV_2FRAME_GOP) != 0);
+
+	if (encodedWidth <= 0 || encodedHeight <= 0 || requiredMemoryOut == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	GetDecodedFormat(codecEncodedFormat, outputFormat, &decodedFormat, &decodedPixelSize);
+	if (decodedFormat == DECODED_FORMAT_UNSUPPORTED) {
+		return CFHD_ERROR_BADFORMAT;
+	}
+
+	switch (decodedResolution)
+	{
+	case CFHD_DECODED_RESOLUTION_HALF:
+		outputWidth /= 2;
+		outputHeight /= 2;
+		break;
+
+	case CFHD_DECODED_RESOLUTION_QUARTER:
+		outputWidth /= 4;
+		outputHeight /= 4;
+		break;
+
+	default:
+		break;
+	}
+
+	resolution = DecodedResolution(encodedWidth, encodedHeight, outputWidth, outputHeight);
+	if (resolution == DECODED_RESOLUTION_UNSUPPORTED)
+	{
+		outputWidth = encodedWidth;
+		outputHeight = encodedHeight;
+		resolution = DECODED_RESOLUTION_FULL;
+	}
+
+	if (threadCount <= 0) {
+		threadCount = DefaultThreadCount();
+	}
+
+	*requiredMemoryOut = RequiredMemory(encodedWidth, encodedHeight, codecEncodedFormat, decodedFormat, decodedPixelSize,
+										resolution, group, outputWidth, outputHeight, outputFormat,
+										threadCount);
+
+	return CFHD_ERROR_OKAY;
+}
+
 CFHD_Error
 CSampleDecoder::PrepareDecoder(int outputWidth,
 							   int outputHeight,
@@ -878,6 +1085,12 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
 	ENCODED_FORMAT encodedFormat = ENCODED_FORMAT_UNKNOWN;
 	DECODED_FORMAT decodedFormat = DECODED_FORMAT_UNSUPPORTED;
 
+	// Assume that the samples are groups of frames unless the sample is an intra frame
+	bool group = true;
+
+	// Maximum number of threads that fit within the memory budget (zero if there is no budget)
+	int threadLimit = 0;
+
 	// Catch any errors in the decoder
 	try
 	{
@@ -892,11 +1105,17 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
 				*actualWidthOut = (int)wOut;
 			if(actualHeightOut)
 				*actualHeightOut = (int)hOut;
+			// Thumbnails can be output in any format supported by the pixel converter
+			if (!CPixelConverter::IsSupportedFormat(outputFormat)) {
+				outputFormat = CFHD_PIXEL_FORMAT_BGRA;
+			}
+
 			if(actualFormatOut)
-				*actualFormatOut = CFHD_PIXEL_FORMAT_BGRA; // currently *hardwired thumbail* output in BGRA format
+				*actualFormatOut = outputFormat;
 
 			m_outputWidth = (int)wOut;
 			m_outputHeight = (int)hOut;
+			m_outputFormat = outputFormat;
 			m_preparedForThumbnails = true;
 
 			m_decodingFlags = decodingFlags;
@@ -966,6 +1185,11 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
 				encodedFormat = header.encoded_format;
 			}
 
+			// Intra frames do not allocate the wavelets for the temporal transform
+			if (header.key_frame && header.droppable_frame) {
+				group = false;
+			}
+
 			// Should have determined the encoded dimensions and format
 			assert(encodedWidth > 0 && encodedHeight > 0 && encodedFormat != ENCODED_FORMAT_UNKNOWN);
 			if (! (encodedWidth > 0 && encodedHeight > 0 && encodedFormat != ENCODED_FORMAT_UNKNOWN)) {
@@ -1094,14 +1318,35 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
 		}
 #endif
 
+		// Reduce the number of threads until the decoder fits within the memory budget
+		if (m_memoryBudget > 0)
+		{
+			threadLimit = DefaultThreadCount();
+
+			while (threadLimit > 1 &&
+				   RequiredMemory(encodedWidth, encodedHeight, encodedFormat, decodedFormat, decodedPixelSize,
+								  decodedResolution, group, outputWidth, outputHeight, outputFormat, threadLimit) > m_memoryBudget)
+			{
+				threadLimit--;
+			}
+
+			if (RequiredMemory(encodedWidth, encodedHeight, encodedFormat, decodedFormat, decodedPixelSize,
+							   decodedResolution, group, outputWidth, outputHeight, outputFormat, threadLimit) > m_memoryBudget)
+			{
+				errorCode = CFHD_ERROR_OUTOFMEMORY;
+				goto finish;
+			}
+		}
+
 		// Has the decoder been allocated and initialized?
 		if (m_decoder != NULL)
 		{
-			// Have the decoding parameters changed?
+			// Have the decoding parameters changed or does the decoder use more threads than the budget allows?
 			if (encodedWidth != m_encodedWidth   ||
 				encodedHeight != m_encodedHeight ||
 				decodedFormat != m_decodedFormat ||
-				decodedResolution != m_decodedResolution)
+				decodedResolution != m_decodedResolution ||
+				(threadLimit > 0 && (m_decoder->thread_cntrl.capabilities >> 16) > threadLimit))
 			{
 				// Safest method is to destroy the decoder and let it be rebuilt
 				DecodeRelease(m_decoder, NULL, 0);
@@ -1130,6 +1375,13 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
 			//TODO: Fix bug in InitDecoder which sets the CPU parameters before clearing the decoder data structure
 			memset(m_decoder, 0, DecoderSize());
 
+			if (threadLimit > 0)
+			{
+				// The thread limit is preserved when DecodeInit clears the decoder
+				m_decoder->thread_cntrl.limit = threadLimit;
+				m_decoder->thread_cntrl.set_thread_params = 1;
+			}
+
 #if _ALLOCATOR
 			// Initialize the decoder using a memory allocator
 			ALLOCATOR *allocator = (ALLOCATOR *)m_allocator;
@@ -1179,6 +1431,9 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
 			m_decodedWidth = decodedWidth;
 			m_decodedHeight = decodedHeight;
 		}
+
+		// Do not keep tables that are only used to build the color cube when decoding within a budget
+		m_decoder->low_memory = (m_memoryBudget > 0);
 #if 1
 		// Allocate the buffer for the decoded frame
 		if (!IsSameFormat(decodedFormat, outputFormat) && m_decodedFrameBuffer == NULL)
@@ -1194,7 +1449,7 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
 			widthRoundedUp = (int)Align16(decodedWidth);
 			heightRoundedUp = (int)Align16(decodedHeight);
 
-			decodedRowSize = (int32_t)GetFramePitch(widthRoundedUp, outputFormat);
+			decodedRowSize = DecodedFramePitch(widthRoundedUp, outputFormat, decodedPixelSize);
 			decodedFrameSize = heightRoundedUp * decodedRowSize;
 
 			assert(decodedRowSize > 0 && decodedFrameSize > 0);
@@ -1392,85 +1647,17 @@ CSampleDecoder::DecodeSample(void *samplePtr,
 		// short circuit this if this decoder was prepared for thumbnails
 		if(m_preparedForThumbnails)
 		{
-			// REMEMBER: we are currently hardwired to create CFHD_PIXEL_FORMAT_BGRA thumbnail images
-
 			// for thumbnails, if we are set to ignore output, do nothing?
 			if(m_decodingFlags&CFHD_DECODING_FLAGS_IGNORE_OUTPUT)
 				return CFHD_ERROR_OKAY;
 
 			// here we can test only the pitch and if the pitch is off, fail
-			if (m_outputWidth * GetPixelSize(CFHD_PIXEL_FORMAT_BGRA) > outputPitch) {
+			if (ThumbnailPitch(m_outputWidth, m_outputFormat) > outputPitch) {
 				return CFHD_ERROR_INVALID_ARGUMENT;
 			}
 
-			uint32_t rawThumbnailNumPix = m_outputWidth * m_outputHeight;
-			uint32_t * rawThumbnailPix = NULL;
-			
-			if(m_allocator)
-				rawThumbnailPix = reinterpret_cast<uint32_t*>(::Alloc(m_allocator, rawThumbnailNumPix * sizeof(uint32_t)));
-			else
-				rawThumbnailPix = new uint32_t [rawThumbnailNumPix];
-			
-			if(!rawThumbnailPix)
-				return CFHD_ERROR_OUTOFMEMORY;
-
-			if(!GenerateThumbnail(samplePtr, sampleSize, rawThumbnailPix, rawThumbnailNumPix * sizeof(uint32_t), THUMBNAIL_FLAGS_DEFAULT, NULL, NULL, NULL))
-			{
-				if(m_allocator)
-					::Free(m_allocator, rawThumbnailPix);
-				else
-					delete [] rawThumbnailPix;
-				rawThumbnailPix = NULL;
-				return CFHD_ERROR_INTERNAL;
-			}
-
-			// convert the 10-bit packed thumbnail info returned from GetThumbnail into BGRA
-			uint32_t val;
-			unsigned char * dest = (unsigned char *)outputBuffer;
-			unsigned char * destRowPtr = dest + ((m_outputHeight-1) * outputPitch);
-			uint32_t * src = rawThumbnailPix;
-			for (int i = 0; i < m_outputHeight; i++)
-			{
-				for (int j = 0; j < m_outputWidth; j++)
-				{
-					// get the value
-					val = *src++;
-
-					// swap it
-					val = (((val&0xFF000000)>>24)|((val&0x00FF0000)>>8)|((val&0x0000FF00)<<8)|((val&0x000000FF)<<24));
-					
-					// get rid of our two garbage bits
-					val >>= 2;
-
-					// 10-bits B, 10-bits G, 10-bit R
-					// are now packed into val
-
-					// B
-					dest[0] = val>>2; 
-
-					// G
-					dest[1] = val>>12;
-
-					// R
-					dest[2] = val>>22; 
-
-					// a
-					dest[3] = 255;
-
-					dest+=4;
-				}
-
-				destRowPtr -= outputPitch;
-				dest = destRowPtr;
-			}
-
-			if(m_allocator)
-				::Free(m_allocator, rawThumbnailPix);
-			else
-				delete [] rawThumbnailPix;
-			rawThumbnailPix = NULL;
-
-			return CFHD_ERROR_OKAY;
+			return DecodeThumbnail(samplePtr, sampleSize, outputBuffer,
+								   m_outputWidth, m_outputHeight, outputPitch, m_outputFormat);
 		}
 		
 		//CFHD_Error errorCode = CFHD_ERROR_OKAY;
@@ -1513,13 +1700,7 @@ CSampleDecoder::DecodeSample(void *samplePtr,
 		bool conversionIsRequired;
 
 		// Can the sample be decoded directly to the output buffer?
-		if (
-#if _SCALING
-			m_decodedWidth != m_outputWidth ||
-			m_decodedHeight != m_outputHeight ||
-#endif
-			IsSameFormat(m_decodedFormat, m_outputFormat)
-			)
+		if (IsDecodedToOutputBuffer())
 		{
 			// Decode the sample into the output buffer
 			decodedFrameBuffer = (uint8_t *)outputBuffer;
@@ -1551,6 +1732,11 @@ CSampleDecoder::DecodeSample(void *samplePtr,
 			return CFHD_ERROR_INTERNAL;
 		}
 
+		// The decoder is cleared when it is initialized so set the statistics before every decode
+		m_decoder->telemetry = m_telemetryEnabled ? m_telemetry : NULL;
+		uint64_t telemetry_start = TELEMETRY_START(m_decoder->telemetry);
+		uint64_t allocations_start = TELEMETRY_ALLOCATIONS_START(m_decoder->telemetry);
+
 		try
 		{
 			// Decode the sample
@@ -1592,8 +1778,12 @@ CSampleDecoder::DecodeSample(void *samplePtr,
 		// Was the frame decoded into a temporary buffer for color conversion and scaling?
 		if (conversionIsRequired)
 		{
+			uint64_t output_start = TELEMETRY_START(m_decoder->telemetry);
+
 			// Convert and scale the decoded frame into the output buffer
 			CopyToOutputBuffer(decodedFrameBuffer, decodedFramePitch, outputBuffer, outputPitch);
+
+			TELEMETRY_STOP(m_decoder->telemetry, TELEMETRY_STAGE_OUTPUT, -1, output_start);
 		}
 
 		//HACK TODO -- support W13A decodes natively
@@ -1606,6 +1796,9 @@ CSampleDecoder::DecodeSample(void *samplePtr,
 			}
 		}
 
+		TELEMETRY_STOP(m_decoder->telemetry, TELEMETRY_STAGE_FRAME, -1, telemetry_start);
+		TELEMETRY_ALLOCATIONS_STOP(m_decoder->telemetry, allocations_start);
+
 		// Indicate that the frame has been decoded
 		return CFHD_ERROR_OKAY;
 	}
@@ -1620,6 +1813,226 @@ CSampleDecoder::DecodeSample(void *samplePtr,
 	}
 }
 
+/*!
+	@brief Decode the sample into several output images
+
+	The first output image must have the dimensions and pixel format that were
+	used to prepare the decoder.  The sample is decoded once into the first
+	output image (or the buffer for color conversion and scaling), so the
+	entropy decoding and inverse transform are not repeated for each output.
+
+	Each other output image is taken from the same decoded resolution that the
+	decoder would use if it were prepared for that output image.  The half and
+	quarter resolution frames are the lowpass bands computed while decoding
+	the sample, so a smaller output image is converted and scaled from the
+	lowpass bands instead of being scaled down from the decoded frame.
+*/
+CFHD_Error
+CSampleDecoder::DecodeSampleOutputs(void *samplePtr,
+									size_t sampleSize,
+									CFHD_OutputDescriptor *outputArray,
+									int outputCount)
+{
+	CFHD_Error errorCode = CFHD_ERROR_OKAY;
+
+	// Check the input arguments
+	if (outputArray == NULL || outputCount < 1) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CFHD_OutputDescriptor *primary = &outputArray[0];
+
+	// The first output image must match the output format of the decoder
+	if (primary->pixelFormat != m_outputFormat ||
+		primary->width != m_outputWidth ||
+		primary->height != m_outputHeight) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	// The thumbnail decoder does not keep the decoded frame
+	if (m_preparedForThumbnails && outputCount > 1) {
+		return CFHD_ERROR_UNEXPECTED;
+	}
+
+	// Check the other output images before decoding the sample
+	for (int index = 1; index < outputCount; index++)
+	{
+		CFHD_OutputDescriptor *output = &outputArray[index];
+
+		if (output->buffer == NULL || output->pitch == 0 ||
+			output->width <= 0 || output->height <= 0) {
+			return CFHD_ERROR_INVALID_ARGUMENT;
+		}
+	}
+
+	errorCode = DecodeSample(samplePtr, sampleSize, primary->buffer, primary->pitch);
+	if (errorCode != CFHD_ERROR_OKAY || outputCount == 1) {
+		return errorCode;
+	}
+
+	if (m_decodingFlags & CFHD_DECODING_FLAGS_IGNORE_OUTPUT) {
+		return CFHD_ERROR_OKAY;
+	}
+
+	// The decoded frame is in the first output image if conversion was not required
+	void *decodedBuffer = m_decodedFrameBuffer;
+	int decodedPitch = m_decodedFramePitch;
+
+	if (IsDecodedToOutputBuffer())
+	{
+		decodedBuffer = primary->buffer;
+		decodedPitch = primary->pitch;
+	}
+
+	// Frames output from the lowpass bands at half and quarter resolution for this sample
+	void *lowpassBuffer[2] = {NULL, NULL};
+	int lowpassWidth[2] = {0, 0};
+	int lowpassHeight[2] = {0, 0};
+	int lowpassPitch[2] = {0, 0};
+	bool lowpassTried[2] = {false, false};
+
+	try
+	{
+		for (int index = 1; index < outputCount; index++)
+		{
+			CFHD_OutputDescriptor *output = &outputArray[index];
+
+			void *inputBuffer = decodedBuffer;
+			int inputWidth = m_decodedWidth;
+			int inputHeight = m_decodedHeight;
+			int inputPitch = decodedPitch;
+
+			// Use the resolution that would be decoded for this output image if it is below the decoded resolution
+			int resolution = DecodedScale(m_encodedWidth, m_encodedHeight, output->width, output->height);
+
+			if (resolution > m_decodedResolution &&
+				(resolution == DECODED_RESOLUTION_HALF || resolution == DECODED_RESOLUTION_QUARTER))
+			{
+				int level = resolution - DECODED_RESOLUTION_HALF;
+
+				if (!lowpassTried[level])
+				{
+					lowpassBuffer[level] = ReconstructLowpassFrame(resolution, &lowpassWidth[level],
+																   &lowpassHeight[level], &lowpassPitch[level]);
+					lowpassTried[level] = true;
+				}
+
+				// Scale the decoded frame if the lowpass bands cannot be output for this sample
+				if (lowpassBuffer[level] != NULL)
+				{
+					inputBuffer = lowpassBuffer[level];
+					inputWidth = lowpassWidth[level];
+					inputHeight = lowpassHeight[level];
+					inputPitch = lowpassPitch[level];
+				}
+			}
+
+			// The codec outputs b64a in native byte order so the converted b64a must match
+			errorCode = CopyToOutputBuffer(inputBuffer, inputWidth, inputHeight, inputPitch,
+										   output->buffer, output->width, output->height,
+										   output->pitch, output->pixelFormat, false);
+			if (errorCode != CFHD_ERROR_OKAY) {
+				return errorCode;
+			}
+		}
+	}
+	catch (...)
+	{
+#if _WIN32
+		OutputDebugString("CSampleDecoder::DecodeSampleOutputs caught internal error\n");
+#endif
+		return CFHD_ERROR_INTERNAL;
+	}
+
+	return CFHD_ERROR_OKAY;
+}
+
+/*!
+	@brief Output the decoded frame at half or quarter resolution
+
+	The frame is reconstructed from the lowpass bands in the decoded format
+	into a buffer that is kept for the next sample.  Returns NULL if the codec
+	cannot output the last decoded frame from the lowpass bands, in which case
+	the caller scales the decoded frame.
+*/
+void *CSampleDecoder::ReconstructLowpassFrame(int resolution, int *widthOut, int *heightOut, int *pitchOut)
+{
+	DECODED_FORMAT decodedFormat;
+	uint32_t decodedPixelSize;
+	int width;
+	int height;
+
+	assert(resolution == DECODED_RESOLUTION_HALF || resolution == DECODED_RESOLUTION_QUARTER);
+	int level = resolution - DECODED_RESOLUTION_HALF;
+
+	ComputeDecodedDimensions(m_encodedWidth, m_encodedHeight, resolution, &width, &height);
+	GetDecodedFormat(m_encodedFormat, m_outputFormat, &decodedFormat, &decodedPixelSize);
+
+	// Same buffer dimensions as the decoded frame buffer when the decoder is prepared for this resolution
+	int32_t pitch = DecodedFramePitch((int)Align16(width), m_outputFormat, decodedPixelSize);
+	size_t size = Align16(height) * pitch;
+
+	if (m_lowpassFrameBuffer[level] == NULL || m_lowpassFrameSize[level] < size)
+	{
+		if (m_lowpassFrameBuffer[level]) {
+			AlignFree(m_lowpassFrameBuffer[level]);
+		}
+
+		m_lowpassFrameBuffer[level] = AlignAlloc(size, 16);
+		m_lowpassFrameSize[level] = (m_lowpassFrameBuffer[level] != NULL) ? size : 0;
+
+		if (m_lowpassFrameBuffer[level] == NULL) {
+			return NULL;
+		}
+	}
+
+	uint64_t telemetry_start = TELEMETRY_START(m_decoder->telemetry);
+
+	bool result = ::ReconstructLowpassFrameToBuffer(m_decoder, resolution,
+													(uint8_t *)m_lowpassFrameBuffer[level], pitch);
+
+	TELEMETRY_STOP(m_decoder->telemetry, TELEMETRY_STAGE_TRANSFORM, -1, telemetry_start);
+
+	if (!result) {
+		return NULL;
+	}
+
+	*widthOut = width;
+	*heightOut = height;
+	*pitchOut = pitch;
+
+	return m_lowpassFrameBuffer[level];
+}
+
+/*!
+	@brief Return the statistics for each stage of decoding
+
+	Statistics are only collected while enabled, so the decoder does not read
+	the clock unless the caller has asked for statistics.  The statistics are
+	returned before the reset flag is applied, so one call can read and clear
+	the statistics for an interval.
+*/
+CFHD_Error CSampleDecoder::GetDecoderStats(CFHD_Stats *statsOut, CFHD_StatsFlags flags)
+{
+	if ((flags & CFHD_STATS_FLAGS_ENABLE) && m_telemetry == NULL)
+	{
+		CountMemoryAllocation();
+		m_telemetry = new TELEMETRY;
+		InitTelemetry(m_telemetry);
+	}
+
+	if (flags & CFHD_STATS_FLAGS_ENABLE) {
+		m_telemetryEnabled = true;
+	}
+	if (flags & CFHD_STATS_FLAGS_DISABLE) {
+		m_telemetryEnabled = false;
+	}
+
+	ReadTelemetryStats(m_telemetry, statsOut, (flags & CFHD_STATS_FLAGS_RESET) != 0);
+
+	return CFHD_ERROR_OKAY;
+}
+
 ENCODED_FORMAT CSampleDecoder::GetEncodedFormat(void *samplePtr,
 												size_t sampleSize)
 {
@@ -1666,24 +2079,22 @@ CFHD_Error CSampleDecoder::ConvertWhitePoint(void *decodedBuffer, int decodedPit
 }
 
 
+bool CSampleDecoder::IsDecodedToOutputBuffer()
+{
+	return (
+#if _SCALING
+		m_decodedWidth != m_outputWidth ||
+		m_decodedHeight != m_outputHeight ||
+#endif
+		IsSameFormat(m_decodedFormat, m_outputFormat));
+}
+
 CFHD_Error CSampleDecoder::CopyToOutputBuffer(void *decodedBuffer, int decodedPitch,
 											  void *outputBuffer, int outputPitch)
 {
 	// Enable or disable byte swapping for the b64a output format
 	bool byte_swap_flag = false;
 
-	int decodedHeight = m_decodedHeight;
-
-	// Ignore extra lines at the bottom of the frame
-	if (m_decodedWidth == m_outputWidth)
-	{
-		int extraHeight = decodedHeight - m_outputHeight;
-
-		if (0 < extraHeight && extraHeight < 8) {
-			decodedHeight = m_outputHeight;
-		}
-	}
-
 #if _WIN32
 	// Do not swap bytes on Windows
 	byte_swap_flag = false;
@@ -1692,7 +2103,26 @@ CFHD_Error CSampleDecoder::CopyToOutputBuffer(void *decodedBuffer, int decodedPi
 	byte_swap_flag = true;
 #endif
 
-	if (m_decodedWidth == m_outputWidth && decodedHeight == m_outputHeight)
+	return CopyToOutputBuffer(decodedBuffer, m_decodedWidth, m_decodedHeight, decodedPitch,
+							  outputBuffer, m_outputWidth, m_outputHeight,
+							  outputPitch, m_outputFormat, byte_swap_flag);
+}
+
+CFHD_Error CSampleDecoder::CopyToOutputBuffer(void *decodedBuffer, int decodedWidth, int decodedHeight, int decodedPitch,
+											  void *outputBuffer, int outputWidth, int outputHeight,
+											  int outputPitch, CFHD_PixelFormat outputFormat, bool byte_swap_flag)
+{
+	// Ignore extra lines at the bottom of the frame
+	if (decodedWidth == outputWidth)
+	{
+		int extraHeight = decodedHeight - outputHeight;
+
+		if (0 < extraHeight && extraHeight < 8) {
+			decodedHeight = outputHeight;
+		}
+	}
+
+	if (decodedWidth == outputWidth && decodedHeight == outputHeight)
 	{
 #if (0 && LOGFILE)
 		if (m_logfile) {
@@ -1702,9 +2132,16 @@ CFHD_Error CSampleDecoder::CopyToOutputBuffer(void *decodedBuffer, int decodedPi
 					(unsigned int)glob, inputFormat, formatString);
 		}
 #endif
-		return ConvertToOutputBuffer(m_decodedFrameBuffer, m_decodedFramePitch, m_decodedFormat,
-									 outputBuffer, outputPitch, m_outputFormat,
-									 m_decodedWidth, decodedHeight, byte_swap_flag);
+		// The dedicated conversions to B64A also use the 709 color space and full range RGB
+		if (m_pixelConverter == NULL) {
+			CountMemoryAllocation();
+			m_pixelConverter = new CPixelConverter(COLOR_FLAGS_CS_709);
+		}
+
+		return ConvertToOutputBuffer(decodedBuffer, decodedPitch, m_decodedFormat,
+									 outputBuffer, outputPitch, outputFormat,
+									 decodedWidth, decodedHeight, byte_swap_flag,
+									 m_pixelConverter);
 	}
 	else
 	{
@@ -1716,9 +2153,15 @@ CFHD_Error CSampleDecoder::CopyToOutputBuffer(void *decodedBuffer, int decodedPi
 					(unsigned int)glob, inputFormat, formatString);
 		}
 #endif
-		return ScaleToOutputBuffer(m_decodedFrameBuffer,  m_decodedWidth, decodedHeight, m_decodedFramePitch, m_decodedFormat,
-								   outputBuffer, m_outputWidth, m_outputHeight, outputPitch, m_outputFormat,
-								   byte_swap_flag);
+		// The frame scaler uses the same color space as the pixel converter
+		if (m_frameScaler == NULL) {
+			CountMemoryAllocation();
+			m_frameScaler = new CFrameScaler(COLOR_FLAGS_CS_709);
+		}
+
+		return ScaleToOutputBuffer(decodedBuffer, decodedWidth, decodedHeight, decodedPitch, m_decodedFormat,
+								   outputBuffer, outputWidth, outputHeight, outputPitch, outputFormat,
+								   byte_swap_flag, m_frameScaler);
 	}
 }
 
@@ -1742,10 +2185,59 @@ CSampleDecoder::GetThumbnail(void *samplePtr,
 		void *outputBuffer,
 		size_t outputSize, 
 		size_t flags,
+		CFHD_PixelFormat format,
 		size_t *retWidth,
 		size_t *retHeight,
 		size_t *retSize)
 {
+	// Convert the thumbnail if a pixel format other than 10-bit RGB was requested
+	if (format != CFHD_PIXEL_FORMAT_UNKNOWN && format != CFHD_PIXEL_FORMAT_DPX0)
+	{
+		if (!CPixelConverter::IsSupportedFormat(format)) {
+			return CFHD_ERROR_BADFORMAT;
+		}
+
+		try
+		{
+			size_t width, height;
+			CFHD_Error errorCode;
+
+			if (!GetThumbnailInfo(samplePtr, sampleSize, 0, &width, &height, NULL)) {
+				return CFHD_ERROR_CODEC_ERROR;
+			}
+
+			// The rows in the output buffer are not padded
+			int pitch = ThumbnailPitch((int)width, format);
+			size_t size = ThumbnailSize((int)width, (int)height, format);
+
+			if (outputSize < size) {
+				return CFHD_ERROR_INVALID_ARGUMENT;
+			}
+
+			errorCode = DecodeThumbnail(samplePtr, sampleSize, outputBuffer,
+										(int)width, (int)height, pitch, format);
+			if (errorCode != CFHD_ERROR_OKAY) {
+				return errorCode;
+			}
+
+			if (retWidth) {
+				*retWidth = width;
+			}
+			if (retHeight) {
+				*retHeight = height;
+			}
+			if (retSize) {
+				*retSize = size;
+			}
+
+			return CFHD_ERROR_OKAY;
+		}
+		catch (...)
+		{
+			return CFHD_ERROR_INTERNAL;
+		}
+	}
+
 	if(GenerateThumbnail(
 			samplePtr,
 			sampleSize,
@@ -1761,6 +2253,256 @@ CSampleDecoder::GetThumbnail(void *samplePtr,
 }
 
 
+/*!
+	@brief Extract the thumbnails from a batch of samples
+
+	Each thumbnail is scaled to the dimensions and converted to the pixel format
+	in its output descriptor.  The scratch buffers for the thumbnails are kept in
+	the decoder, so extracting thumbnails of the same size in the same format does
+	not allocate memory after the first thumbnail.  The error code for each sample
+	is returned in the error array (if provided) and the first error is returned.
+*/
+CFHD_Error
+CSampleDecoder::GetThumbnailImages(void **samplePtrArray,
+		size_t *sampleSizeArray,
+		CFHD_OutputDescriptor *outputArray,
+		CFHD_Error *errorArray,
+		int count)
+{
+	CFHD_Error result = CFHD_ERROR_OKAY;
+
+	for (int index = 0; index < count; index++)
+	{
+		CFHD_OutputDescriptor *output = &outputArray[index];
+		CFHD_Error errorCode = CFHD_ERROR_OKAY;
+
+		try
+		{
+			if (samplePtrArray[index] == NULL || output->buffer == NULL ||
+				output->width <= 0 || output->height <= 0)
+			{
+				errorCode = CFHD_ERROR_INVALID_ARGUMENT;
+			}
+			else if (!CPixelConverter::IsSupportedFormat(output->pixelFormat))
+			{
+				errorCode = CFHD_ERROR_BADFORMAT;
+			}
+			else if (output->pitch < ThumbnailPitch(output->width, output->pixelFormat))
+			{
+				errorCode = CFHD_ERROR_INVALID_ARGUMENT;
+			}
+			else
+			{
+				errorCode = DecodeThumbnail(samplePtrArray[index], sampleSizeArray[index],
+											output->buffer, output->width, output->height,
+											output->pitch, output->pixelFormat);
+			}
+		}
+		catch (...)
+		{
+			errorCode = CFHD_ERROR_INTERNAL;
+		}
+
+		if (errorArray) {
+			errorArray[index] = errorCode;
+		}
+
+		if (result == CFHD_ERROR_OKAY) {
+			result = errorCode;
+		}
+	}
+
+	return result;
+}
+
+/*!
+	@brief Extract the thumbnail and scale it to the output image
+
+	The thumbnail is computed from the lowpass bands into a buffer that is kept
+	for the next thumbnail, so the sample header is only parsed again to get the
+	thumbnail dimensions if the buffer is too small.
+*/
+CFHD_Error
+CSampleDecoder::DecodeThumbnail(void *samplePtr, size_t sampleSize,
+								void *outputBuffer, int outputWidth, int outputHeight,
+								int outputPitch, CFHD_PixelFormat outputFormat)
+{
+	size_t thumbnailWidth = 0;
+	size_t thumbnailHeight = 0;
+	size_t thumbnailSize = 0;
+
+	if (m_thumbnailScaler == NULL) {
+		CountMemoryAllocation();
+		m_thumbnailScaler = new CThumbnailScaler(COLOR_FLAGS_CS_709);
+	}
+
+	if (m_thumbnailBuffer == NULL ||
+		!GenerateThumbnail(samplePtr, sampleSize, m_thumbnailBuffer, m_thumbnailBufferSize,
+						   THUMBNAIL_FLAGS_DEFAULT, &thumbnailWidth, &thumbnailHeight, &thumbnailSize))
+	{
+		if (!GetThumbnailInfo(samplePtr, sampleSize, 0, &thumbnailWidth, &thumbnailHeight, &thumbnailSize)) {
+			return CFHD_ERROR_CODEC_ERROR;
+		}
+
+		// Could not extract the thumbnail even though the buffer was large enough?
+		if (thumbnailSize <= m_thumbnailBufferSize) {
+			return CFHD_ERROR_CODEC_ERROR;
+		}
+
+		if (m_thumbnailBuffer) {
+			::FreeAligned(m_allocator, m_thumbnailBuffer);
+			m_thumbnailBufferSize = 0;
+		}
+
+		// Use the allocator provided when the decoder was opened
+		CountMemoryAllocation();
+		m_thumbnailBuffer = ::AllocAligned(m_allocator, thumbnailSize, 16);
+		if (m_thumbnailBuffer == NULL) {
+			return CFHD_ERROR_OUTOFMEMORY;
+		}
+		m_thumbnailBufferSize = thumbnailSize;
+
+		if (!GenerateThumbnail(samplePtr, sampleSize, m_thumbnailBuffer, m_thumbnailBufferSize,
+							   THUMBNAIL_FLAGS_DEFAULT, &thumbnailWidth, &thumbnailHeight, &thumbnailSize)) {
+			return CFHD_ERROR_CODEC_ERROR;
+		}
+	}
+
+	// The thumbnail is 10-bit RGB packed into the DPX0 pixel format without padding
+	if (!m_thumbnailScaler->Scale(m_thumbnailBuffer, thumbnailWidth * 4, CFHD_PIXEL_FORMAT_DPX0,
+								  (int)thumbnailWidth, (int)thumbnailHeight,
+								  outputBuffer, outputPitch, outputFormat,
+								  outputWidth, outputHeight)) {
+		return CFHD_ERROR_BADFORMAT;
+	}
+
+	return CFHD_ERROR_OKAY;
+}
+
+
+CFHD_Error
+CSampleDecoder::GetProxySample(void *samplePtr,
+		size_t sampleSize,
+		int resolution,
+		void *outputBuffer,
+		size_t outputSize,
+		size_t *retSize)
+{
+	CODEC_ERROR error;
+
+	switch (resolution)
+	{
+	case CFHD_DECODED_RESOLUTION_HALF:
+		resolution = DECODED_RESOLUTION_HALF;
+		break;
+
+	case CFHD_DECODED_RESOLUTION_QUARTER:
+		resolution = DECODED_RESOLUTION_QUARTER;
+		break;
+
+	default:
+		return CFHD_ERROR_BAD_RESOLUTION;
+	}
+
+	error = GenerateProxySample(samplePtr, sampleSize, outputBuffer, outputSize, resolution, retSize);
+
+	switch (error)
+	{
+	case CODEC_ERROR_OKAY:
+		return CFHD_ERROR_OKAY;
+
+	case CODEC_ERROR_RESOLUTION:
+		return CFHD_ERROR_BAD_RESOLUTION;
+
+	case CODEC_ERROR_UNSUPPORTED_FORMAT:
+	case CODEC_ERROR_TRANSFORM_TYPE:
+		return CFHD_ERROR_BADFORMAT;
+
+	case CODEC_ERROR_INVALID_BITSTREAM:
+		return CFHD_ERROR_BADSAMPLE;
+
+	default:
+		// The proxy did not fit in the output buffer
+		if ((error & CODEC_ERROR_BITSTREAM) == CODEC_ERROR_BITSTREAM)
+			return CFHD_ERROR_DECODE_BUFFER_SIZE;
+		return CFHD_ERROR_CODEC_ERROR;
+	}
+}
+
+
+CFHD_Error
+CSampleDecoder::ValidateSample(void *samplePtr,
+		size_t sampleSize,
+		uint32_t flags,
+		uint32_t *crc)
+{
+	CODEC_ERROR error;
+
+	error = ::ValidateSample(samplePtr, sampleSize, NULL);
+	if (error != CODEC_ERROR_OKAY) {
+		return CFHD_ERROR_BADSAMPLE;
+	}
+
+	if (flags & (CFHD_VALIDATE_FLAGS_COMPUTE_CRC | CFHD_VALIDATE_FLAGS_CHECK_CRC))
+	{
+		uint32_t sample_crc = ComputeSampleCRC(samplePtr, sampleSize);
+
+		if (flags & CFHD_VALIDATE_FLAGS_CHECK_CRC)
+		{
+			if (sample_crc != *crc) {
+				return CFHD_ERROR_BAD_CRC;
+			}
+		}
+		else
+		{
+			*crc = sample_crc;
+		}
+	}
+
+	return CFHD_ERROR_OKAY;
+}
+
+
+CFHD_Error
+CSampleDecoder::GetStereoEyeSample(void *samplePtr,
+		size_t sampleSize,
+		CFHD_VideoSelect eye,
+		void **eyeSamplePtr,
+		size_t *eyeSampleSize)
+{
+	size_t offset = 0;
+	size_t size = 0;
+	int channel;
+	int channels;
+
+	switch (eye)
+	{
+	case VIDEO_SELECT_DEFAULT:
+	case VIDEO_SELECT_LEFT_EYE:
+		channel = 0;
+		break;
+
+	case VIDEO_SELECT_RIGHT_EYE:
+		channel = 1;
+		break;
+
+	default:
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	channels = FindVideoChannel((uint8_t *)samplePtr, sampleSize, channel, &offset, &size);
+	if (channel >= channels) {
+		// The sample does not contain the requested eye
+		return CFHD_ERROR_BADFORMAT;
+	}
+
+	*eyeSamplePtr = (uint8_t *)samplePtr + offset;
+	*eyeSampleSize = size;
+
+	return CFHD_ERROR_OKAY;
+}
+
+
 // Return the dimensions and format of the output frame
 CFHD_Error CSampleDecoder::GetFrameFormat(int &width, int &height, CFHD_PixelFormat &format)
 {
@@ -1779,6 +2521,12 @@ CFHD_Error CSampleDecoder::GetRequiredBufferSize(uint32_t &bytes)
 
 	bytes = 0;
 
+	// Thumbnails are not decoded into a frame buffer
+	if (m_preparedForThumbnails) {
+		bytes = (uint32_t)ThumbnailSize(m_outputWidth, m_outputHeight, m_outputFormat);
+		return CFHD_ERROR_OKAY;
+	}
+
 	GetChannelsActive(active);
 	GetChannelMix(mix);
 	if(active == 3 && mix == 0)
@@ -1938,6 +2686,7 @@ ISampleDecoder *CSampleDecoder::CreateSampleDecoder(IAllocator *allocator, CFHD_
 	CSampleDecoder *pSampleDecoder = NULL;
 
 	// Allocate the sample decoder using the default allocator
+	CountMemoryAllocation();
 	pSampleDecoder = new CSampleDecoder((CFHD_ALLOCATOR *)allocator, license, logfile);
 
 	return dynamic_cast<ISampleDecoder *>(pSampleDecoder);
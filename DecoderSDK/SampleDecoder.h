@@ -39,6 +39,11 @@ typedef enum decoded_format DECODED_FORMAT;
 typedef enum decoded_resolution DECODED_RESOLUTION;
 typedef enum encoded_format ENCODED_FORMAT;
 
+// Scaler for thumbnails (defined in the conversion library)
+class CThumbnailScaler;
+class CPixelConverter;
+class CFrameScaler;
+
 
 class CSampleDecoder : public ISampleDecoder
 {
@@ -92,10 +97,35 @@ public:
 							  void *outputBuffer,
 							  size_t outputSize, 
 							  size_t flags,
+							  CFHD_PixelFormat format,
 							  size_t *retWidth,
 							  size_t *retHeight,
 							  size_t *retSize);
 
+	CFHD_Error GetThumbnailImages(void **samplePtrArray,
+							  size_t *sampleSizeArray,
+							  CFHD_OutputDescriptor *outputArray,
+							  CFHD_Error *errorArray,
+							  int count);
+
+	CFHD_Error GetProxySample(void *samplePtr,
+							  size_t sampleSize,
+							  int resolution,
+							  void *outputBuffer,
+							  size_t outputSize,
+							  size_t *retSize);
+
+	CFHD_Error ValidateSample(void *samplePtr,
+							  size_t sampleSize,
+							  uint32_t flags,
+							  uint32_t *crc);
+
+	CFHD_Error GetStereoEyeSample(void *samplePtr,
+							  size_t sampleSize,
+							  CFHD_VideoSelect eye,
+							  void **eyeSamplePtr,
+							  size_t *eyeSampleSize);
+
 	CFHD_Error SetAllocator(CFHD_ALLOCATOR * allocator)
 	{
 		m_allocator = allocator;
@@ -116,12 +146,36 @@ public:
 							void *outputBuffer,
 							int outputPitch);
 
+	CFHD_Error DecodeSampleOutputs(void *samplePtr,
+								   size_t sampleSize,
+								   CFHD_OutputDescriptor *outputArray,
+								   int outputCount);
+
+	CFHD_Error GetDecoderStats(CFHD_Stats *statsOut, CFHD_StatsFlags flags);
+
 	CFHD_Error SetDecoderOverrides(unsigned char *databaseData, int databaseSize);
 
 	CFHD_Error GetFrameFormat(int &width, int &height, CFHD_PixelFormat &format);
 
 	CFHD_Error GetRequiredBufferSize(uint32_t &bytes);
 
+	// Estimate the memory required to decode frames with the specified format
+	static CFHD_Error GetRequiredMemory(int encodedWidth,
+										int encodedHeight,
+										CFHD_EncodedFormat encodedFormat,
+										CFHD_EncodingFlags encodingFlags,
+										CFHD_PixelFormat outputFormat,
+										CFHD_DecodedResolution decodedResolution,
+										int threadCount,
+										size_t *requiredMemoryOut);
+
+	// Limit the memory allocated by the decoder (zero for no limit)
+	CFHD_Error SetMemoryBudget(size_t budget)
+	{
+		m_memoryBudget = budget;
+		return CFHD_ERROR_OKAY;
+	}
+
 	
 	CFHD_Error SetChannelsActive(uint32_t data)
 	{
@@ -171,8 +225,22 @@ protected:
 
 	CFHD_Error CopyToOutputBuffer(void *decodedBuffer, int decodedPitch,
 								  void *outputBuffer, int outputPitch);
+	CFHD_Error CopyToOutputBuffer(void *decodedBuffer, int decodedWidth, int decodedHeight, int decodedPitch,
+								  void *outputBuffer, int outputWidth, int outputHeight,
+								  int outputPitch, CFHD_PixelFormat outputFormat, bool byte_swap_flag);
+
+	// Output the decoded frame at half or quarter resolution from the lowpass bands
+	void *ReconstructLowpassFrame(int resolution, int *widthOut, int *heightOut, int *pitchOut);
 	CFHD_Error ConvertWhitePoint(void *decodedBuffer, int decodedPitch);
 
+	// Extract the thumbnail and scale it to the output dimensions and pixel format
+	CFHD_Error DecodeThumbnail(void *samplePtr, size_t sampleSize,
+							   void *outputBuffer, int outputWidth, int outputHeight,
+							   int outputPitch, CFHD_PixelFormat outputFormat);
+
+	// Can the sample be decoded directly into the output buffer?
+	bool IsDecodedToOutputBuffer();
+
 	void ReleaseFrameBuffer()
 	{
 		if (m_decodedFrameBuffer)
@@ -189,10 +257,22 @@ protected:
 			m_decodedFrameBuffer = NULL;
 			m_decodedFrameSize = 0;
 		}
+
+		for (int index = 0; index < 2; index++)
+		{
+			if (m_lowpassFrameBuffer[index])
+			{
+				AlignFree(m_lowpassFrameBuffer[index]);
+				m_lowpassFrameBuffer[index] = NULL;
+				m_lowpassFrameSize[index] = 0;
+			}
+		}
 	}
 
 	void *Alloc(size_t size)
 	{
+		CountMemoryAllocation();
+
 #if _ALLOCATOR
 		// Use the allocator if it is available
 		if (m_allocator) {
@@ -219,6 +299,8 @@ protected:
 
 	void *AlignAlloc(size_t size, size_t alignment)
 	{
+		CountMemoryAllocation();
+
 #if _ALLOCATOR
 		// Use the allocator if it is available
 		if (m_allocator) {
@@ -296,8 +378,32 @@ private:
 	// Decoder has been prepared for Thumbnail decodes
 	bool m_preparedForThumbnails;
 
+	// Thumbnail extracted from the lowpass bands (reused for every thumbnail)
+	void *m_thumbnailBuffer;
+	size_t m_thumbnailBufferSize;
+
+	// Scales and converts the thumbnails to the output format
+	CThumbnailScaler *m_thumbnailScaler;
+
+	// Converts the decoded frames to the output formats that the codec does not decode directly
+	CPixelConverter *m_pixelConverter;
+
+	// Scales the decoded frames to output dimensions that are not a decoded resolution
+	CFrameScaler *m_frameScaler;
+
+	// Frames output at half and quarter resolution from the lowpass bands (reused for every sample)
+	void *m_lowpassFrameBuffer[2];
+	size_t m_lowpassFrameSize[2];
+
 	uint32_t m_channelsActive;
 	uint32_t m_channelMix;
+
+	// Statistics for each stage of decoding (allocated when first enabled)
+	TELEMETRY *m_telemetry;
+	bool m_telemetryEnabled;
+
+	// Maximum memory allocated by the decoder (zero if there is no budget)
+	size_t m_memoryBudget;
 };
 
 #endif //_SAMPLE_DEC_H
@@ -27,6 +27,7 @@
 #pragma once
 #define MAX_OVERRIDE_SIZE	16384
 #include "CFHDError.h"
+#include "../Codec/metadata.h"
 
 class CSampleMetadata
 {
@@ -53,7 +54,8 @@ public:
 		m_currentUFRM(-1),
 		m_hash(0),
 		last_process_time(0),
-		last_write_time(0),
+		last_now_time(0),
+		m_databaseGeneration(0),
 		m_allocator(NULL)
 	{
 		memset(&m_currentClipGUID, 0, sizeof(myGUID));		
@@ -62,6 +64,9 @@ public:
 
 		memset(m_overrideData, 0, MAX_OVERRIDE_SIZE);
 		memset(m_workspaceData, 0, MAX_OVERRIDE_SIZE);
+
+		MetadataIndexReset(&m_sampleIndex);
+		MetadataIndexReset(&m_databaseIndex);
 	}
 
 public:
@@ -111,7 +116,34 @@ public:
 	clock_t last_process_time;
 	time_t last_now_time;
 
-	uint32_t last_write_time;
+	uint32_t m_databaseGeneration;	// Generation of the database file in the shared cache
+
+	METADATA_INDEX m_sampleIndex;	// Index of the tags in the sample (built on the first lookup)
+	METADATA_INDEX m_databaseIndex;	// Index of the tags in the color database
+
+	// Find the first occurrence of a tag in the sample
+	void *FindInSample(METADATA_TAG tag, METADATA_SIZE *retsize, METADATA_TYPE *rettype)
+	{
+		if (m_sampleIndex.count < 0) {
+			MetadataIndexSample(&m_sampleIndex, m_sampleData, m_sampleSize);
+		}
+		if (m_sampleIndex.complete) {
+			return MetadataIndexFind(&m_sampleIndex, tag, retsize, rettype);
+		}
+		return MetaDataFindInSample(m_sampleData, m_sampleSize, tag, retsize, rettype);
+	}
+
+	// Find the first occurrence of a tag in the color database
+	void *FindInDatabase(METADATA_TAG tag, METADATA_SIZE *retsize, METADATA_TYPE *rettype)
+	{
+		if (m_databaseIndex.count < 0) {
+			MetadataIndexChunk(&m_databaseIndex, m_databaseData, m_databaseSize);
+		}
+		if (m_databaseIndex.complete) {
+			return MetadataIndexFind(&m_databaseIndex, tag, retsize, rettype);
+		}
+		return MetadataFind(m_databaseData, m_databaseSize, tag, retsize, rettype);
+	}
 
 	CFHD_Error SetAllocator(CFHD_ALLOCATOR * allocator)
 	{
@@ -202,6 +234,8 @@ public:
 			m_databaseData = NULL;
 			m_databaseSize = 0;
 		}	
+		m_databaseGeneration = 0;
+		last_process_time = 0;
 		if(m_databaseSizeL && m_databaseDataL)
 		{
 			Free(m_databaseDataL);
@@ -215,6 +249,8 @@ public:
 			m_databaseSizeR = 0;
 		}
 
+		MetadataIndexReset(&m_databaseIndex);
+
 		
 		if(m_overrideSize)
 		{
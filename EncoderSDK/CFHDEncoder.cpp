@@ -129,6 +129,7 @@ CFHD_OpenEncoder(CFHD_EncoderRef *encoderRefOut,
 	}
 
 	// Allocate a new encoder data structure
+	CountMemoryAllocation();
 	CSampleEncoder *encoderRef = new CSampleEncoder;
 	if (encoderRef == NULL) {
 		return CFHD_ERROR_OUTOFMEMORY;
@@ -636,3 +637,142 @@ CFHD_GetEncodeThumbnail(CFHD_EncoderRef encoderRef,
 
 	return errorCode;
 }
+
+/*!
+	@function CFHD_GetEncoderStats
+
+	@brief Return the time spent in each stage of encoding.
+
+	@description Statistics are collected for each encoder after they are
+	enabled by calling this routine with CFHD_STATS_FLAGS_ENABLE.  The time
+	for each stage is recorded with the count, total time, longest time, and
+	a histogram of the times, and the entropy coding and forward transform
+	are also broken down by subband and wavelet.  The levels of the transform
+	for a group of frames are included in the transform stage without a
+	breakdown by wavelet.  Statistics are not collected by default.
+
+	@param encoderRef
+	Reference to an encoder created by a call to @ref CFHD_OpenEncoder.
+
+	@param statsOut
+	Returns the statistics collected since the statistics were last reset.
+	The pointer may be NULL if the call is only used to change the flags.
+
+	@param flags
+	CFHD_STATS_FLAGS_ENABLE or CFHD_STATS_FLAGS_DISABLE to start or stop
+	collecting statistics and CFHD_STATS_FLAGS_RESET to clear the statistics
+	after they are returned.
+
+	@return Returns a CFHD error code.
+*/
+CFHDENCODER_API CFHD_Error
+CFHD_GetEncoderStats(CFHD_EncoderRef encoderRef,
+					 CFHD_Stats *statsOut,
+					 CFHD_StatsFlags flags)
+{
+	// Check the input arguments
+	if (encoderRef == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleEncoder *encoder = (CSampleEncoder *)encoderRef;
+
+	return encoder->GetEncoderStats(statsOut, flags);
+}
+
+/*!
+	@function CFHD_GetEncoderRequiredMemory
+
+	@brief Estimate the memory required to encode frames with the specified format.
+
+	@description The estimate covers the encoder, the wavelet transforms, the
+	frame used for the converted input, the buffer for the encoded sample,
+	and the scratch buffer for input frames with the minimum pitch.  The
+	input frames are not included.  Each encoder in an encoder pool allocates
+	the same memory, so the estimate for a pool is the estimate for one
+	encoder times the number of encoders.
+
+	@param frameWidth
+	Width of the input frames.
+
+	@param frameHeight
+	Height of the input frames.
+
+	@param inputFormat
+	Pixel format of the input frames.
+
+	@param encodedFormat
+	Internal representation of the encoded frames.
+
+	@param encodingFlags
+	Flags passed to @ref CFHD_PrepareToEncode.
+
+	@param encoderCount
+	Number of encoders (for example the number of threads in an encoder pool)
+	or zero for one encoder.
+
+	@param requiredMemoryOut
+	Returns the estimated number of bytes.
+
+	@return Returns a CFHD error code.
+*/
+CFHDENCODER_API CFHD_Error
+CFHD_GetEncoderRequiredMemory(int frameWidth,
+							  int frameHeight,
+							  CFHD_PixelFormat inputFormat,
+							  CFHD_EncodedFormat encodedFormat,
+							  CFHD_EncodingFlags encodingFlags,
+							  int encoderCount,
+							  size_t *requiredMemoryOut)
+{
+	CFHD_Error errorCode;
+
+	// Check the input arguments
+	if (frameWidth <= 0 || frameHeight <= 0 || requiredMemoryOut == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	errorCode = CSampleEncoder::GetRequiredMemory(frameWidth, frameHeight, inputFormat,
+												  encodedFormat, encodingFlags, requiredMemoryOut);
+
+	if (errorCode == CFHD_ERROR_OKAY && encoderCount > 1) {
+		*requiredMemoryOut *= encoderCount;
+	}
+
+	return errorCode;
+}
+
+/*!
+	@function CFHD_SetEncoderMemoryBudget
+
+	@brief Limit the memory allocated by the encoder.
+
+	@description The budget is applied the next time that the encoder is
+	prepared by @ref CFHD_PrepareToEncode.  If the estimate returned by
+	@ref CFHD_GetEncoderRequiredMemory does not fit within the budget, the
+	buffer for the encoded sample is allocated for 3:1 compression and the
+	uncompressed quality flags are ignored.  If the encoder still does not
+	fit, CFHD_PrepareToEncode returns CFHD_ERROR_OUTOFMEMORY before any
+	buffers are allocated.
+
+	@param encoderRef
+	Reference to an encoder created by a call to @ref CFHD_OpenEncoder.
+
+	@param memoryBudget
+	Maximum number of bytes allocated by the encoder or zero for no limit.
+
+	@return Returns a CFHD error code.
+*/
+CFHDENCODER_API CFHD_Error
+CFHD_SetEncoderMemoryBudget(CFHD_EncoderRef encoderRef,
+							size_t memoryBudget)
+{
+	// Check the input arguments
+	if (encoderRef == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	CSampleEncoder *encoder = (CSampleEncoder *)encoderRef;
+
+	return encoder->SetMemoryBudget(memoryBudget);
+}
@@ -73,6 +73,7 @@ CFHD_MetadataOpen(CFHD_MetadataRef *metadataRefOut)
 	}
 
 	// Allocate a new encoder metadata structure
+	CountMemoryAllocation();
 	CSampleEncodeMetadata *metadataRef = new CSampleEncodeMetadata;
 	if (metadataRef == NULL) {
 		return CFHD_ERROR_OUTOFMEMORY;
@@ -109,6 +109,7 @@ CFHD_CreateEncoderPool(CFHD_EncoderPoolRef *encoderPoolRefOut,
 
 	try
 	{
+		CountMemoryAllocation();
 		encoderPool = new CEncoderPool(encoderThreadCount, jobQueueLength, allocator);
 		if (encoderPool == NULL) {
 			return CFHD_ERROR_OUTOFMEMORY;
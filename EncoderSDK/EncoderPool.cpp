@@ -260,6 +260,7 @@ CFHD_Error CEncoderPool::EncodeSample(uint32_t frameNumber,
 	}
 
 	// Create a new encoder job
+	CountMemoryAllocation();
 	EncoderJob *job = new EncoderJob(frameNumber, frameBuffer, framePitch, keyFrame, currentMetadata, m_nextFrameQuality);
 	if (job == NULL) {
 		error = CFHD_ERROR_OUTOFMEMORY;
@@ -398,6 +399,7 @@ CSampleEncodeMetadata *CEncoderPool::PrepareMetadata(CSampleEncodeMetadata *enco
 	if (m_encoderMetadata == NULL)
 	{
 		// Create a new metadata container for this encoder pool
+		CountMemoryAllocation();
 		m_encoderMetadata = new CSampleEncodeMetadata;
 		if (m_encoderMetadata == NULL) {
 			error = CFHD_ERROR_OUTOFMEMORY;
@@ -418,6 +420,7 @@ CSampleEncodeMetadata *CEncoderPool::PrepareMetadata(CSampleEncodeMetadata *enco
 	}
 
 	// Copy the current metadata for encoding the next frame
+	CountMemoryAllocation();
 	encoderMetadata = new CSampleEncodeMetadata(m_encoderMetadata);
 	if (encoderMetadata == NULL) {
 		error = CFHD_ERROR_OUTOFMEMORY;
@@ -462,7 +465,13 @@ CFHD_Error CEncoderPool::UpdateMetadata()
 
 	// Get the current time
 	time_t clock = time(NULL);
-	struct tm *time = localtime(&clock);
+	struct tm local_time;
+	struct tm *time = &local_time;
+#ifdef _WIN32
+	localtime_s(&local_time, &clock);
+#else
+	localtime_r(&clock, &local_time);
+#endif
 	char date_string[16];
 	char time_string[16];
 	char timecode[16];
@@ -34,6 +34,7 @@ public:
 	{
 		for (size_t index = 0; index < length; index++)
 		{
+			CountMemoryAllocation();
 			CAsyncEncoder *encoder = new CAsyncEncoder(pool, allocator);
 			assert(encoder);
 			if (encoder) {
@@ -111,6 +111,106 @@ CSampleEncoder::GetInputFormats(CFHD_PixelFormat *inputFormatArray,
 	return CFHD_ERROR_OKAY;
 }
 
+/*!
+	@brief Estimate the memory allocated by PrepareToEncode and EncodeSample
+
+	The encoding buffer is computed for input frames with the minimum pitch.  If the
+	reduced sample buffer flag is set, the sample buffer assumes 3:1 compression.
+*/
+size_t
+CSampleEncoder::RequiredMemory(int frameWidth,
+							   int frameHeight,
+							   CFHD_PixelFormat inputFormat,
+							   CFHD_EncodedFormat encodedFormat,
+							   CFHD_EncodingFlags encodingFlags,
+							   bool reducedSampleBuffer)
+{
+	int inputWidth = frameWidth;
+	int inputHeight = frameHeight;
+	int codecEncodedFormat = ENCODED_FORMAT_YUV_422;
+	int gopLength = 1;
+	bool progressive = true;
+	size_t pixelSize = PixelSize(inputFormat);
+	size_t size = 0;
+
+	switch (encodedFormat)
+	{
+	case CFHD_ENCODED_FORMAT_YUV_422:
+		codecEncodedFormat = ENCODED_FORMAT_YUV_422;
+		progressive = !(encodingFlags & CFHD_ENCODING_FLAGS_YUV_INTERLACED);
+		gopLength = (encodingFlags & CFHD_ENCODING_FLAGS_YUV_2FRAME_GOP) ? 2 : 1;
+		break;
+
+	case CFHD_ENCODED_FORMAT_RGB_444:
+		codecEncodedFormat = ENCODED_FORMAT_RGB_444;
+		break;
+
+	case CFHD_ENCODED_FORMAT_RGBA_4444:
+		codecEncodedFormat = ENCODED_FORMAT_RGBA_4444;
+		break;
+
+	case CFHD_ENCODED_FORMAT_BAYER:
+		codecEncodedFormat = ENCODED_FORMAT_BAYER;
+		inputWidth >>= 1;
+		inputHeight >>= 1;
+		break;
+
+	default:
+		break;
+	}
+
+	// Encoder, transforms, and the frame used for the converted input
+	size += sizeof(ENCODER) + FRAME_MAX_CHANNELS * sizeof(TRANSFORM);
+	size += EncoderMemorySize(inputWidth, inputHeight, codecEncodedFormat, gopLength);
+
+	if (encodingFlags & CFHD_ENCODING_FLAGS_LARGER_OUTPUT) {
+		inputHeight *= 2;
+	}
+
+	// Buffer for the encoded sample
+	size += sizeof(CSampleBuffer) + 16;
+	if (reducedSampleBuffer)
+		size += inputWidth * (inputHeight/3) * pixelSize + 65536;
+	else
+		size += inputWidth * inputHeight * pixelSize + 65536;
+
+	// Scratch buffer allocated by the first call to EncodeSample
+	if (inputFormat == CFHD_PIXEL_FORMAT_BYR5) {
+		inputHeight = inputHeight * 4 / 3;
+	}
+	size += TotalEncodingBufferSize(inputWidth, inputHeight, (int)(inputWidth * pixelSize),
+									EncoderColorFormat(inputFormat), gopLength, progressive);
+
+	// Metadata and other small allocations during encoding
+	size += 65536;
+
+	return size;
+}
+
+/*!
+	@brief Estimate the memory required to encode frames with the specified format
+*/
+CFHD_Error
+CSampleEncoder::GetRequiredMemory(int frameWidth,
+								  int frameHeight,
+								  CFHD_PixelFormat inputFormat,
+								  CFHD_EncodedFormat encodedFormat,
+								  CFHD_EncodingFlags encodingFlags,
+								  size_t *requiredMemoryOut)
+{
+	if (frameWidth <= 0 || frameHeight <= 0 || requiredMemoryOut == NULL) {
+		return CFHD_ERROR_INVALID_ARGUMENT;
+	}
+
+	if (EncoderColorFormat(inputFormat) == COLOR_FORMAT_UNKNOWN) {
+		return CFHD_ERROR_BADFORMAT;
+	}
+
+	*requiredMemoryOut = RequiredMemory(frameWidth, frameHeight, inputFormat, encodedFormat, encodingFlags, false);
+
+	return CFHD_ERROR_OKAY;
+}
+
 CFHD_Error
 CSampleEncoder::PrepareToEncode(int inputWidth,
 								int inputHeight,
@@ -136,6 +236,18 @@ CSampleEncoder::PrepareToEncode(int inputWidth,
 
 	bool result;
 
+	// Assume 3:1 compression for the sample buffer if the full size buffer does not fit within the memory budget
+	bool reducedSampleBuffer = false;
+
+	if (m_memoryBudget > 0 &&
+		RequiredMemory(inputWidth, inputHeight, inputFormat, encodedFormat, encodingFlags, false) > m_memoryBudget)
+	{
+		if (RequiredMemory(inputWidth, inputHeight, inputFormat, encodedFormat, encodingFlags, true) > m_memoryBudget) {
+			return CFHD_ERROR_OUTOFMEMORY;
+		}
+		reducedSampleBuffer = true;
+	}
+
 	// Has the encoder been allocated and initialized?
 	if (m_encoder != NULL)
 	{
@@ -326,6 +438,21 @@ CSampleEncoder::PrepareToEncode(int inputWidth,
 		return CFHD_ERROR_OKAY;
 	}
 
+	// Allocate the smaller sample buffer if the encoder must fit within the memory budget
+	if (m_sampleBuffer == NULL && reducedSampleBuffer)
+	{
+		if(encodingFlags & CFHD_ENCODING_FLAGS_LARGER_OUTPUT)
+			error = AllocateSampleBuffer(inputWidth, inputHeight*2/3, inputFormat);
+		else
+			error = AllocateSampleBuffer(inputWidth, inputHeight/3, inputFormat);
+
+		if(error != CFHD_ERROR_OKAY)
+			return error;
+
+		m_encodingQuality = (CFHD_EncodingQuality)(0xffff000f & (uint32_t)m_encodingQuality);  // remove uncompressed flags.
+		SetEncoderQuality(m_encoder, m_encodingQuality);
+	}
+
 	// Has a buffer for the encoded sample been allocated?
 	if (m_sampleBuffer == NULL)
 	{
@@ -388,6 +515,7 @@ CSampleEncoder::AllocateSampleBuffer(int inputWidth,
 
 		// Allocate the sample buffer using the allocator
 		//m_sampleBuffer = AllocAligned(sampleSize, sampleAlignment);
+		CountMemoryAllocation();
 		m_sampleBuffer = new CSampleBuffer(sampleSize, 16, m_allocator);
 		if (m_sampleBuffer == NULL) {
 			return CFHD_ERROR_OUTOFMEMORY;
@@ -562,6 +690,11 @@ CSampleEncoder::EncodeSample(void *frameBuffer,
 		return CFHD_ERROR_BADFORMAT;
 	}
 
+	// The encoder is cleared when it is initialized so set the statistics before every encode
+	m_encoder->telemetry = m_telemetryEnabled ? m_telemetry : NULL;
+	uint64_t telemetry_start = TELEMETRY_START(m_encoder->telemetry);
+	uint64_t allocations_start = TELEMETRY_ALLOCATIONS_START(m_encoder->telemetry);
+
 	try
 	{
 
@@ -591,10 +724,41 @@ CSampleEncoder::EncodeSample(void *frameBuffer,
 
 	m_sampleBuffer->SetActualSize(bitstream.nWordsUsed);
 
+	TELEMETRY_STOP(m_encoder->telemetry, TELEMETRY_STAGE_FRAME, -1, telemetry_start);
+	TELEMETRY_ALLOCATIONS_STOP(m_encoder->telemetry, allocations_start);
+
 	// Indicate that the frame has been encoded
 	return CFHD_ERROR_OKAY;
 }
 
+/*!
+	@brief Return the statistics for each stage of encoding
+
+	The statistics are allocated when they are first enabled and are only
+	updated by the encoder while enabled.  The statistics are returned before
+	the reset flag is applied.
+*/
+CFHD_Error CSampleEncoder::GetEncoderStats(CFHD_Stats *statsOut, CFHD_StatsFlags flags)
+{
+	if ((flags & CFHD_STATS_FLAGS_ENABLE) && m_telemetry == NULL)
+	{
+		CountMemoryAllocation();
+		m_telemetry = new TELEMETRY;
+		InitTelemetry(m_telemetry);
+	}
+
+	if (flags & CFHD_STATS_FLAGS_ENABLE) {
+		m_telemetryEnabled = true;
+	}
+	if (flags & CFHD_STATS_FLAGS_DISABLE) {
+		m_telemetryEnabled = false;
+	}
+
+	ReadTelemetryStats(m_telemetry, statsOut, (flags & CFHD_STATS_FLAGS_RESET) != 0);
+
+	return CFHD_ERROR_OKAY;
+}
+
 COLOR_FORMAT CSampleEncoder::EncoderColorFormat(CFHD_PixelFormat pixelFormat)
 {
 	COLOR_FORMAT colorFormat = COLOR_FORMAT_UNKNOWN;
@@ -769,11 +933,17 @@ CSampleEncoder::HandleMetadata()
 	// update the clock
 	{
 		time_t		clock;
-		struct tm	*	SystemTime;
+		struct tm		LocalTime;
+		struct tm	*	SystemTime = &LocalTime;
 		char datestr[16],timestr[16], tmpstr[16];
 
+		// The reentrant version does not reread the time zone (and allocate memory) on every frame
 		clock = time(NULL);
-		SystemTime = localtime( &clock );
+#ifdef _WIN32
+		localtime_s(&LocalTime, &clock);
+#else
+		localtime_r(&clock, &LocalTime);
+#endif
 
 #ifdef _WIN32
 		sprintf_s(datestr, sizeof(datestr), "%04d-%02d-%02d", SystemTime->tm_year + 1900, SystemTime->tm_mon + 1, SystemTime->tm_mday);
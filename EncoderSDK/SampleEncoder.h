@@ -23,6 +23,9 @@
 // Forward reference to the encoder in the code library
 typedef struct encoder ENCODER;
 
+// Forward reference to the encoding statistics in the codec library
+typedef struct telemetry TELEMETRY;
+
 
 typedef enum watermark_state
 {
@@ -68,7 +71,10 @@ public:
 		m_last_unique_frame(-1),
 		m_last_timecode_base(0),
 		m_last_timecode_frame(-1),
-		m_watermark(WATERMARK_UNCHECKED)
+		m_watermark(WATERMARK_UNCHECKED),
+		m_telemetry(NULL),
+		m_telemetryEnabled(false),
+		m_memoryBudget(0)
 	{
 		// Clear the array of wavelet transforms
 		memset(m_transformArray, 0, sizeof(m_transformArray));
@@ -115,7 +121,10 @@ public:
 		m_last_unique_frame(-1),
 		m_last_timecode_base(0),
 		m_last_timecode_frame(-1),
-		m_watermark(WATERMARK_UNCHECKED)
+		m_watermark(WATERMARK_UNCHECKED),
+		m_telemetry(NULL),
+		m_telemetryEnabled(false),
+		m_memoryBudget(0)
 	{
 		// Clear the array of wavelet transforms
 		memset(m_transformArray, 0, sizeof(m_transformArray));
@@ -163,6 +172,12 @@ public:
 		// Release the scratch buffer used by the encoder
 		ReleaseScratchBuffer();
 
+		// Release the encoding statistics
+		if (m_telemetry) {
+			ReleaseTelemetry(m_telemetry);
+			delete m_telemetry;
+		}
+
 		// Release the allocator if it is only referenced by this sample encoder
 	//	if (m_allocator && m_privateAllocatorFlag) {
 	//		//delete m_allocator; //DAN fixed memory trash
@@ -192,6 +207,8 @@ public:
 							CFHD_EncodingQuality frameQuality = CFHD_ENCODING_QUALITY_FIXED);
 
 	uint32_t SetLicense(unsigned char *license);
+
+	CFHD_Error GetEncoderStats(CFHD_Stats *statsOut, CFHD_StatsFlags flags);
 	
 	CFHD_Error GetThumbnail(void *samplePtr,
 							  size_t sampleSize,
@@ -284,10 +301,33 @@ public:
 		return CFHD_ERROR_INVALID_ARGUMENT;
 	}
 
-	size_t PixelSize(CFHD_PixelFormat pixelFormat);
+	static size_t PixelSize(CFHD_PixelFormat pixelFormat);
+
+	// Estimate the memory required to encode frames with the specified format
+	static CFHD_Error GetRequiredMemory(int frameWidth,
+										int frameHeight,
+										CFHD_PixelFormat inputFormat,
+										CFHD_EncodedFormat encodedFormat,
+										CFHD_EncodingFlags encodingFlags,
+										size_t *requiredMemoryOut);
+
+	// Limit the memory allocated by the encoder (zero for no limit)
+	CFHD_Error SetMemoryBudget(size_t budget)
+	{
+		m_memoryBudget = budget;
+		return CFHD_ERROR_OKAY;
+	}
 	
 protected:
 
+	// Estimate the memory allocated by PrepareToEncode and EncodeSample
+	static size_t RequiredMemory(int frameWidth,
+								 int frameHeight,
+								 CFHD_PixelFormat inputFormat,
+								 CFHD_EncodedFormat encodedFormat,
+								 CFHD_EncodingFlags encodingFlags,
+								 bool reducedSampleBuffer);
+
 	// Allocate a buffer for the encoded sample
 	CFHD_Error AllocateSampleBuffer(int inputWidth,
 								    int inputHeight,
@@ -307,6 +347,8 @@ protected:
 
 	void *Alloc(size_t size)
 	{
+		CountMemoryAllocation();
+
 #if _ALLOCATOR
 		// Use the allocator if it is available
 		if (m_allocator) {
@@ -332,6 +374,8 @@ protected:
 
 	void *AllocAligned(size_t size, size_t alignment)
 	{
+		CountMemoryAllocation();
+
 #if _ALLOCATOR
 		// Use the aligned allocator if it is available
 		if (m_allocator != NULL) {
@@ -364,7 +408,7 @@ protected:
 	}
 
 	// Convert the four character code to the color format used by the encoder
-	COLOR_FORMAT EncoderColorFormat(CFHD_PixelFormat pixelFormat);
+	static COLOR_FORMAT EncoderColorFormat(CFHD_PixelFormat pixelFormat);
 
 	// Draw a watermark on the image before encoding
 	static void ApplyWatermark(void *frameBuffer,
@@ -444,4 +488,9 @@ private:
 	int	m_watermark;
 
 	uint8_t	m_licenseFeatures[8];
+
+	TELEMETRY *m_telemetry;				//!< Statistics for each stage (allocated when first enabled)
+	bool m_telemetryEnabled;			//!< Collect statistics during encoding?
+
+	size_t m_memoryBudget;				//!< Maximum memory allocated by the encoder (zero if no budget)
 };
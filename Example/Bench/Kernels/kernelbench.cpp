@@ -0,0 +1,1220 @@
+/*! @file kernelbench.cpp
+
+*  @brief Microbenchmarks of the codec kernels with checks against golden output hashes
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+/*
+	Each kernel is called on one thread with inputs generated from a fixed seed
+	for every strip width and quantizer on the command line.  Each call is timed
+	with the processor time stamp counter and the median and minimum are reported
+	in cycles per pixel, where the pixels are the rows times the width of the
+	largest buffer read or written by the kernel.
+
+	The output of the first call is hashed and compared with the hash recorded
+	in kernelgolden.h for the same kernel, width, height and quantizer, so that
+	a change that makes a kernel faster but changes its output is reported as a
+	failure.  Combinations that are not in the table are reported as unchecked.
+	After an intentional change to the output of a kernel, run the benchmark
+	with --record to print a new table.
+
+	DemosaicRAW is a worker thread procedure that reads the decoder state, so it
+	is run inside a decoder that decodes a Bayer sample of a 16:9 frame with the
+	strip width on one thread.  The time is the demosaic stage in the decoder
+	statistics and the hash is of the decoded frame.
+
+	GetBits, PeekBits and GetTagValue read an encoded sample of a 16:9 frame
+	with the strip width, so the pixels are those of the frame.  The hash is
+	of the fields or the tag value pairs that were read from the sample.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+#ifdef __APPLE__
+#include <sys/time.h>
+#endif
+
+#include "config.h"
+#include "decoder.h"
+#include "codec.h"
+#include "vlc.h"
+#include "codebooks.h"
+#include "color.h"
+#include "image.h"
+#include "spatial.h"
+#include "quantize.h"
+#include "convert.h"
+#include "wavelet.h"
+#include "bitstream.h"
+#include "RGB2YUV.h"
+#include "GeoMesh.h"
+#include "metadata.h"
+
+#include "CFHDDecoder.h"
+#include "CFHDEncoder.h"
+#include "CFHDMetadata.h"
+
+#define KERNEL_DEFAULT_HEIGHT		64
+#define KERNEL_DEFAULT_SECONDS		0.25	// Minimum time spent timing each combination
+#define KERNEL_MIN_CALLS			5		// Minimum number of timed calls for each combination
+#define KERNEL_ALIGNMENT			64		// Alignment of every buffer and row
+#define KERNEL_SEED					0x43464844
+
+// Hash of the output of a kernel for one combination of the parameters
+typedef struct
+{
+	const char *name;
+	int width;
+	int height;
+	int quant;
+	uint64_t hash;
+
+} KERNEL_GOLDEN;
+
+#include "kernelgolden.h"
+
+// Buffer aligned for the SIMD loads and stores in the kernels
+typedef struct
+{
+	std::vector<uint8_t> storage;
+	uint8_t *data;
+	size_t size;
+
+} KERNEL_BUFFER;
+
+// Buffers and parameters for one combination
+typedef struct
+{
+	int width;
+	int height;
+	int quant;
+
+	KERNEL_BUFFER input[4];
+	KERNEL_BUFFER output;			// Hashed after the first call
+	KERNEL_BUFFER scratch;
+	int inputPitch;					// Distance between rows in bytes
+	int outputPitch;
+
+	BITSTREAM stream;				// Encoded band for the entropy decoder
+	void *mesh;						// Lens correction mesh for the warp kernels
+	int meshFormat;
+
+	CFHD_DecoderRef decoderRef;		// Decoder for the demosaic
+	CFHD_MetadataRef metadataRef;
+	std::vector<uint8_t> sample;
+	double stageSeconds;			// Time reported by the decoder (negative if not used)
+
+} KERNEL_STATE;
+
+typedef struct
+{
+	const char *name;
+	bool quantized;							// Is the kernel run for each quantizer?
+	bool (*setup)(KERNEL_STATE *state);
+	void (*prepare)(KERNEL_STATE *state);	// Called before each call (optional)
+	bool (*run)(KERNEL_STATE *state);
+	void (*release)(KERNEL_STATE *state);	// Optional
+
+} KERNEL;
+
+typedef struct
+{
+	std::vector<char *> kernels;		// Substrings of the kernel names to run (all if empty)
+	std::vector<int> widths;
+	std::vector<int> quants;
+	int height;
+	double seconds;
+	bool record;
+	const char *outputName;
+
+} KERNEL_OPTIONS;
+
+typedef struct
+{
+	int calls;
+	double medianCycles;		// Cycles for one call
+	double minCycles;
+	double medianSeconds;
+	uint64_t hash;
+
+} KERNEL_RESULT;
+
+
+static double TimestampFrequency = 0.0;		// Time stamp counter ticks per second (zero if not available)
+
+
+double gettime(void)
+{
+#ifdef __APPLE__
+	timeval ts;
+	gettimeofday(&ts, NULL);
+	return (double)ts.tv_sec + (double)ts.tv_usec / 1000000.0;
+#elif _WIN32
+	LARGE_INTEGER precision, ts;
+	::QueryPerformanceCounter(&ts);
+	::QueryPerformanceFrequency(&precision);
+	return static_cast<double>(ts.QuadPart)/static_cast<double>(precision.QuadPart);
+#else
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+static inline uint64_t ReadTimestamp(void)
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// Measure the rate of the time stamp counter against the system clock
+static void CalibrateTimestamp(void)
+{
+	double start = gettime();
+	uint64_t first = ReadTimestamp();
+	double elapsed;
+
+	do {
+		elapsed = gettime() - start;
+	} while (elapsed < 0.05);
+
+	TimestampFrequency = (double)(ReadTimestamp() - first) / elapsed;
+}
+
+static uint8_t *AllocBuffer(KERNEL_BUFFER *buffer, size_t size)
+{
+	uintptr_t address;
+
+	buffer->storage.assign(size + KERNEL_ALIGNMENT, 0);
+	address = (uintptr_t)&buffer->storage[0];
+	address = (address + KERNEL_ALIGNMENT - 1) & ~(uintptr_t)(KERNEL_ALIGNMENT - 1);
+	buffer->data = (uint8_t *)address;
+	buffer->size = size;
+
+	return buffer->data;
+}
+
+// Round the size of a row up so that every row is aligned
+static int AlignPitch(size_t size)
+{
+	return (int)((size + KERNEL_ALIGNMENT - 1) & ~(size_t)(KERNEL_ALIGNMENT - 1));
+}
+
+static uint32_t NextRandom(uint32_t *seed)
+{
+	uint32_t x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return (*seed = x);
+}
+
+// Fill rows with a smooth ramp plus noise in the range zero to maximum
+static void FillImage(uint8_t *buffer, int width, int height, int pitch, int maximum, uint32_t *seed)
+{
+	int noise = maximum / 16 + 1;
+
+	for (int row = 0; row < height; row++)
+	{
+		PIXEL16U *rowptr = (PIXEL16U *)(buffer + (size_t)row * pitch);
+		for (int column = 0; column < width; column++)
+		{
+			int value = (int)((int64_t)maximum * (column + row) / (width + height));
+			value += (int)(NextRandom(seed) % noise) - noise / 2;
+			rowptr[column] = (PIXEL16U)((value < 0) ? 0 : ((value > maximum) ? maximum : value));
+		}
+	}
+}
+
+// Fill rows with highpass coefficients that are mostly zero and mostly small
+static void FillHighpass(uint8_t *buffer, int width, int height, int pitch, int maximum, uint32_t *seed)
+{
+	for (int row = 0; row < height; row++)
+	{
+		PIXEL *rowptr = (PIXEL *)(buffer + (size_t)row * pitch);
+		for (int column = 0; column < width; column++)
+		{
+			uint32_t random = NextRandom(seed);
+			int magnitude = 0;
+
+			if ((random & 3) == 0)
+			{
+				// Occasional large coefficients at edges in the image
+				if (((random >> 2) & 15) == 0)
+					magnitude = (int)((random >> 8) % maximum) + 1;
+				else
+					magnitude = (int)((random >> 8) & 7) + 1;
+			}
+			rowptr[column] = (PIXEL)((random & (1 << 30)) ? -magnitude : magnitude);
+		}
+	}
+}
+
+static void FillBytes(uint8_t *buffer, size_t size, uint32_t *seed)
+{
+	for (size_t i = 0; i < size; i++) {
+		buffer[i] = (uint8_t)(NextRandom(seed) >> 24);
+	}
+}
+
+// 64-bit FNV-1a hash of the output
+static uint64_t HashBuffer(const uint8_t *data, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+
+// Decoder that only holds the finite state machine for the entropy decoder
+static DECODER *FsmDecoder = NULL;
+static CODESET FsmCodesets[CODEC_NUM_CODESETS];
+
+static bool InitFsmDecoder(void)
+{
+	if (FsmDecoder != NULL) {
+		return true;
+	}
+
+	// Same initialization as DecodeInit for the first codeset
+	memcpy(&FsmCodesets[0], &CURRENT_CODESET, sizeof(CODESET));
+#if CODEC_NUM_CODESETS >= 2
+	memcpy(&FsmCodesets[1], &SECOND_CODESET, sizeof(CODESET));
+#endif
+#if CODEC_NUM_CODESETS >= 3
+	memcpy(&FsmCodesets[2], &THIRD_CODESET, sizeof(CODESET));
+#endif
+
+	FsmDecoder = (DECODER *)calloc(1, sizeof(DECODER));
+	if (FsmDecoder == NULL) {
+		return false;
+	}
+
+	InitDecoder(FsmDecoder, NULL, FsmCodesets);
+#if _ALLOCATOR
+	if (!InitCodebooks(NULL, FsmCodesets)) return false;
+#else
+	if (!InitCodebooks(FsmCodesets)) return false;
+#endif
+	if (!InitDecoderFSM(FsmDecoder, FsmCodesets)) return false;
+
+	InitFSM(&FsmDecoder->fsm[0], FsmCodesets[0].fsm_table);
+#if _COMPANDING
+	ScaleFSM(&FsmDecoder->fsm[0].table);
+#endif
+
+	return true;
+}
+
+// Encode a band of coefficients the same way as EncodeQuantizedCoefficients
+static bool SetupDecodeBand(KERNEL_STATE *state)
+{
+	RLCBOOK *runsbook;
+	VALBOOK *valuebook;
+	BITSTREAM stream;
+	uint32_t seed = KERNEL_SEED;
+	size_t count = (size_t)state->width * state->height;
+	size_t size = count * sizeof(PIXEL) + 1024;
+	const PIXEL *coefficients;
+	int zeros = 0;
+
+	if (!InitFsmDecoder()) {
+		return false;
+	}
+	runsbook = FsmCodesets[0].codebook_runbook;
+	valuebook = FsmCodesets[0].valuebook;
+
+	// The band has no gap between rows
+	state->outputPitch = state->width * sizeof(PIXEL);
+	AllocBuffer(&state->output, (size_t)state->outputPitch * state->height);
+
+	AllocBuffer(&state->input[0], count * sizeof(PIXEL));
+	FillHighpass(state->input[0].data, state->width, state->height, state->outputPitch, 100, &seed);
+	coefficients = (const PIXEL *)state->input[0].data;
+
+	AllocBuffer(&state->input[1], size);
+	InitBitstreamBuffer(&stream, state->input[1].data, size, BITSTREAM_ACCESS_WRITE);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (coefficients[i] == 0) {
+			zeros++;
+			continue;
+		}
+		if (zeros > 0) {
+			PutZeroRun(&stream, zeros, runsbook);
+			zeros = 0;
+		}
+		PutVlcByte(&stream, coefficients[i], valuebook);
+	}
+	if (zeros > 0) {
+		PutZeroRun(&stream, zeros, runsbook);
+	}
+
+	FinishEncodeBand(&stream, FsmDecoder->band_end_code[0], FsmDecoder->band_end_size[0]);
+	FlushBitstream(&stream);
+
+	DeQuantFSM(&FsmDecoder->fsm[0], state->quant);
+
+	return true;
+}
+
+static void PrepareDecodeBand(KERNEL_STATE *state)
+{
+	// The decoder skips the runs of zeros
+	memset(state->output.data, 0, state->output.size);
+	InitBitstreamBuffer(&state->stream, state->input[1].data, state->input[1].size, BITSTREAM_ACCESS_READ);
+}
+
+static bool RunDecodeBand(KERNEL_STATE *state)
+{
+#if _DEBUG
+	return DecodeBandFSM16sNoGap(&FsmDecoder->fsm[0], &state->stream, (PIXEL16S *)state->output.data,
+								 state->width, state->height, state->outputPitch, NULL);
+#else
+	return DecodeBandFSM16sNoGap(&FsmDecoder->fsm[0], &state->stream, (PIXEL16S *)state->output.data,
+								 state->width, state->height, state->outputPitch);
+#endif
+}
+
+// Widths of the fields read by the bitstream kernels (the peeks are limited to 16 bits)
+static const int BitstreamFieldWidths[] = {1, 3, 5, 8, 11, 13, 16, 12};
+#define BITSTREAM_FIELD_COUNT	(int)(sizeof(BitstreamFieldWidths) / sizeof(BitstreamFieldWidths[0]))
+
+// Clear the metadata that the encoder sets from the clock and a random GUID so that the sample is the same in every run
+static void ClearSampleClock(uint8_t *sample, size_t size)
+{
+	static const METADATA_TAG tags[] = {TAG_CLIP_GUID, TAG_ENCODE_DATE, TAG_ENCODE_TIME, TAG_TIMECODE, TAG_UNIQUE_FRAMENUM};
+
+	for (size_t i = 0; i < sizeof(tags) / sizeof(tags[0]); i++)
+	{
+		METADATA_SIZE itemSize = 0;
+		METADATA_TYPE itemType = 0;
+		void *data = MetaDataFindInSample(sample, size, tags[i], &itemSize, &itemType);
+		if (data != NULL) {
+			memset(data, 0, itemSize);
+		}
+	}
+}
+
+// Encode a YUV 4:2:2 sample of a 16:9 frame with the strip width for the bitstream readers.
+// The output has one longword for each field or tag value pair read from the sample.
+static bool SetupBitstreamSample(KERNEL_STATE *state, bool tags)
+{
+	CFHD_EncoderRef encoderRef = NULL;
+	uint32_t seed = KERNEL_SEED;
+	int framePitch = state->width * 3 * sizeof(uint16_t);
+	void *sampleBuffer = NULL;
+	size_t sampleSize = 0;
+	size_t count = 0;
+	CFHD_Error error;
+
+	state->height = (state->width * 9 / 16) & ~7;
+
+	AllocBuffer(&state->input[0], (size_t)framePitch * state->height);
+	FillImage(state->input[0].data, state->width * 3, state->height, framePitch, 65535, &seed);
+
+	error = CFHD_OpenEncoder(&encoderRef, NULL);
+	if (error) return false;
+
+	error = CFHD_PrepareToEncode(encoderRef, state->width, state->height, CFHD_PIXEL_FORMAT_RG48,
+								 CFHD_ENCODED_FORMAT_YUV_422, CFHD_ENCODING_FLAGS_NONE, CFHD_ENCODING_QUALITY_FILMSCAN1);
+	if (error == CFHD_ERROR_OKAY) {
+		error = CFHD_EncodeSample(encoderRef, state->input[0].data, framePitch);
+	}
+	if (error == CFHD_ERROR_OKAY) {
+		error = CFHD_GetSampleData(encoderRef, &sampleBuffer, &sampleSize);
+	}
+	if (error == CFHD_ERROR_OKAY) {
+		memcpy(AllocBuffer(&state->input[1], sampleSize), sampleBuffer, sampleSize);
+		ClearSampleClock(state->input[1].data, sampleSize);
+	}
+	CFHD_CloseEncoder(encoderRef);
+	if (error) return false;
+
+	if (tags)
+	{
+		count = sampleSize / sizeof(uint32_t);
+	}
+	else
+	{
+		// Stop before a field that would read past the end of the sample
+		size_t bits = 0;
+		while (bits + 32 <= 8 * sampleSize) {
+			bits += BitstreamFieldWidths[count++ % BITSTREAM_FIELD_COUNT];
+		}
+	}
+
+	AllocBuffer(&state->output, count * sizeof(uint32_t));
+
+	return true;
+}
+
+static bool SetupBitstreamFields(KERNEL_STATE *state) { return SetupBitstreamSample(state, false); }
+static bool SetupBitstreamTags(KERNEL_STATE *state) { return SetupBitstreamSample(state, true); }
+
+static void PrepareBitstream(KERNEL_STATE *state)
+{
+	InitBitstreamBuffer(&state->stream, state->input[1].data, state->input[1].size, BITSTREAM_ACCESS_READ);
+}
+
+// Read the sample as a sequence of fields with the widths in the table
+static bool RunGetBits(KERNEL_STATE *state)
+{
+	uint32_t *output = (uint32_t *)state->output.data;
+	size_t count = state->output.size / sizeof(uint32_t);
+
+	for (size_t i = 0; i < count; i++) {
+		output[i] = GetBits(&state->stream, BitstreamFieldWidths[i % BITSTREAM_FIELD_COUNT]);
+	}
+
+	return (state->stream.error == BITSTREAM_ERROR_OKAY);
+}
+
+// Peek at a table index and skip the bits in the codeword like the codebook lookups
+static bool RunPeekBits(KERNEL_STATE *state)
+{
+	uint32_t *output = (uint32_t *)state->output.data;
+	size_t count = state->output.size / sizeof(uint32_t);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		output[i] = PeekBits(&state->stream, 16);
+		SkipBits(&state->stream, BitstreamFieldWidths[i % BITSTREAM_FIELD_COUNT]);
+	}
+
+	return (state->stream.error == BITSTREAM_ERROR_OKAY);
+}
+
+// Scan the sample as tag value pairs (the optional pairs are skipped inside GetTagValue)
+static bool RunGetTagValue(KERNEL_STATE *state)
+{
+	uint32_t *output = (uint32_t *)state->output.data;
+	size_t count = 0;
+
+	memset(output, 0, state->output.size);
+
+	while (state->stream.nWordsUsed >= (int)sizeof(uint32_t))
+	{
+		TAGVALUE segment = GetTagValue(&state->stream);
+		if (state->stream.error != BITSTREAM_ERROR_OKAY) {
+			break;
+		}
+		output[count++] = segment.longword;
+	}
+
+	return (count > 0);
+}
+
+// Horizontal lowpass and highpass rows with half the output width
+static bool SetupInvertHorizontal(KERNEL_STATE *state)
+{
+	uint32_t seed = KERNEL_SEED;
+	int halfWidth = state->width / 2;
+
+	state->inputPitch = AlignPitch(halfWidth * sizeof(PIXEL));
+	state->outputPitch = AlignPitch(state->width * sizeof(PIXEL));
+
+	AllocBuffer(&state->input[0], (size_t)state->inputPitch * state->height);
+	AllocBuffer(&state->input[1], (size_t)state->inputPitch * state->height);
+	AllocBuffer(&state->output, (size_t)state->outputPitch * state->height);
+
+	FillImage(state->input[0].data, halfWidth, state->height, state->inputPitch, 8191, &seed);
+	FillHighpass(state->input[1].data, halfWidth, state->height, state->inputPitch, 256, &seed);
+
+	return true;
+}
+
+static bool RunInvertHorizontal(KERNEL_STATE *state)
+{
+	ROI strip = {state->width / 2, state->height};
+
+	InvertHorizontalStrip16s((PIXEL *)state->input[0].data, state->inputPitch,
+							 (PIXEL *)state->input[1].data, state->inputPitch,
+							 (PIXEL *)state->output.data, state->outputPitch, strip);
+	return true;
+}
+
+// Four quantized bands with half the output width and height
+static bool SetupInvertSpatial(KERNEL_STATE *state)
+{
+	uint32_t seed = KERNEL_SEED;
+	int bandWidth = state->width / 2;
+	int bandHeight = state->height / 2;
+
+	state->inputPitch = AlignPitch(bandWidth * sizeof(PIXEL));
+	state->outputPitch = AlignPitch(state->width * sizeof(PIXEL));
+
+	for (int band = 0; band < 4; band++)
+	{
+		AllocBuffer(&state->input[band], (size_t)state->inputPitch * bandHeight);
+		if (band == 0)
+			FillImage(state->input[band].data, bandWidth, bandHeight, state->inputPitch, 16383, &seed);
+		else
+			FillHighpass(state->input[band].data, bandWidth, bandHeight, state->inputPitch, 64, &seed);
+	}
+
+	AllocBuffer(&state->output, (size_t)state->outputPitch * state->height);
+	AllocBuffer(&state->scratch, 16 * (size_t)state->outputPitch);
+
+	return true;
+}
+
+static bool RunInvertSpatial(KERNEL_STATE *state)
+{
+	ROI roi = {state->width / 2, state->height / 2};
+	int quantization[4] = {1, 1, 1, 1};		// Not used since the bands are dequantized by the entropy decoder
+
+	InvertSpatialQuant16s((PIXEL *)state->input[0].data, state->inputPitch,
+						  (PIXEL *)state->input[1].data, state->inputPitch,
+						  (PIXEL *)state->input[2].data, state->inputPitch,
+						  (PIXEL *)state->input[3].data, state->inputPitch,
+						  (PIXEL *)state->output.data, state->outputPitch,
+						  roi, (PIXEL *)state->scratch.data, state->scratch.size, quantization);
+	return true;
+}
+
+// Image rows that are transformed into four bands stored one after the other in the output
+static bool SetupFilterSpatial(KERNEL_STATE *state)
+{
+	uint32_t seed = KERNEL_SEED;
+
+	state->inputPitch = AlignPitch(state->width * sizeof(PIXEL));
+	state->outputPitch = AlignPitch((state->width / 2) * sizeof(PIXEL));
+
+	AllocBuffer(&state->input[0], (size_t)state->inputPitch * state->height);
+	FillImage(state->input[0].data, state->width, state->height, state->inputPitch, 4095, &seed);
+
+	AllocBuffer(&state->output, 4 * (size_t)state->outputPitch * (state->height / 2));
+	AllocBuffer(&state->scratch, ForwardSpatialBufferSize(state->width));
+
+	return true;
+}
+
+static bool RunFilterSpatial(KERNEL_STATE *state)
+{
+	ROI roi = {state->width, state->height};
+	int quantization[4] = {1, state->quant, state->quant, state->quant};
+	size_t bandSize = (size_t)state->outputPitch * (state->height / 2);
+	uint8_t *bands = state->output.data;
+
+	FilterSpatialQuant16s((PIXEL *)state->input[0].data, state->inputPitch,
+						  (PIXEL *)(bands + 0 * bandSize), state->outputPitch,
+						  (PIXEL *)(bands + 1 * bandSize), state->outputPitch,
+						  (PIXEL *)(bands + 2 * bandSize), state->outputPitch,
+						  (PIXEL *)(bands + 3 * bandSize), state->outputPitch,
+						  (PIXEL *)state->scratch.data, state->scratch.size, roi, quantization);
+	return true;
+}
+
+static bool SetupQuantizeRow(KERNEL_STATE *state)
+{
+	uint32_t seed = KERNEL_SEED;
+
+	state->inputPitch = AlignPitch(state->width * sizeof(PIXEL));
+	state->outputPitch = state->inputPitch;
+
+	AllocBuffer(&state->input[0], (size_t)state->inputPitch * state->height);
+	AllocBuffer(&state->output, (size_t)state->outputPitch * state->height);
+	FillHighpass(state->input[0].data, state->width, state->height, state->inputPitch, 2048, &seed);
+
+	return true;
+}
+
+static bool RunQuantizeRow(KERNEL_STATE *state)
+{
+	for (int row = 0; row < state->height; row++)
+	{
+		QuantizeRow16sTo16s((PIXEL *)(state->input[0].data + (size_t)row * state->inputPitch),
+							(PIXEL *)(state->output.data + (size_t)row * state->outputPitch),
+							state->width, state->quant);
+	}
+	return true;
+}
+
+// Planes of 10-bit luma and chroma packed into rows of V210
+static bool SetupConvertV210(KERNEL_STATE *state)
+{
+	uint32_t seed = KERNEL_SEED;
+
+	state->inputPitch = AlignPitch(state->width * sizeof(PIXEL));
+	state->outputPitch = ((state->width + 47) / 48) * 128;
+
+	AllocBuffer(&state->input[0], (size_t)state->inputPitch * state->height);
+	AllocBuffer(&state->input[1], (size_t)state->inputPitch * state->height);
+	AllocBuffer(&state->input[2], (size_t)state->inputPitch * state->height);
+	AllocBuffer(&state->output, (size_t)state->outputPitch * state->height);
+
+	FillImage(state->input[0].data, state->width, state->height, state->inputPitch, 1023, &seed);
+	FillImage(state->input[1].data, state->width / 2, state->height, state->inputPitch, 1023, &seed);
+	FillImage(state->input[2].data, state->width / 2, state->height, state->inputPitch, 1023, &seed);
+
+	return true;
+}
+
+static bool RunConvertV210(KERNEL_STATE *state)
+{
+	PIXEL *planes[3] = {(PIXEL *)state->input[0].data, (PIXEL *)state->input[1].data, (PIXEL *)state->input[2].data};
+	int pitches[3] = {state->inputPitch, state->inputPitch, state->inputPitch};
+	ROI roi = {state->width, state->height};
+
+	ConvertPlanarYUVToV210(planes, pitches, roi, state->output.data, state->width, state->outputPitch,
+						   COLOR_FORMAT_V210, COLOR_SPACE_CG_709, false, CODEC_PRECISION_10BIT);
+	return true;
+}
+
+static bool SetupChunkyBGRA(KERNEL_STATE *state)
+{
+	uint32_t seed = KERNEL_SEED;
+
+	state->inputPitch = AlignPitch(state->width * 4);
+	state->outputPitch = AlignPitch(state->width * 3 * sizeof(unsigned short));
+
+	AllocBuffer(&state->input[0], (size_t)state->inputPitch * state->height);
+	AllocBuffer(&state->output, (size_t)state->outputPitch * state->height);
+	FillBytes(state->input[0].data, state->input[0].size, &seed);
+
+	return true;
+}
+
+static bool RunChunkyBGRA(KERNEL_STATE *state)
+{
+	for (int row = 0; row < state->height; row++)
+	{
+		ChunkyBGRA8toPlanarRGB16(state->input[0].data + (size_t)row * state->inputPitch,
+								 (unsigned short *)(state->output.data + (size_t)row * state->outputPitch),
+								 state->width);
+	}
+	return true;
+}
+
+// Encode a Bayer frame with the sensor dimensions and prepare to decode it with one thread.
+// The whole frame is decoded so the height is that of a 16:9 frame instead of a strip.
+static bool SetupDemosaic(KERNEL_STATE *state)
+{
+	CFHD_EncoderRef encoderRef = NULL;
+	CFHD_PixelFormat actualFormat = CFHD_PIXEL_FORMAT_UNKNOWN;
+	uint32_t seed = KERNEL_SEED;
+	uint32_t maxcpus = 1;
+	int framePitch = state->width * sizeof(uint16_t);
+	int actualWidth = 0;
+	int actualHeight = 0;
+	int32_t pitch = 0;
+	uint32_t imageSize = 0;
+	void *sampleBuffer = NULL;
+	size_t sampleSize = 0;
+	CFHD_Error error;
+
+	state->height = (state->width * 9 / 16) & ~7;
+
+	// The 16-bit mosaic rows use the top bits like a camera
+	AllocBuffer(&state->input[0], (size_t)framePitch * state->height);
+	FillImage(state->input[0].data, state->width, state->height, framePitch, 65535, &seed);
+
+	error = CFHD_OpenEncoder(&encoderRef, NULL);
+	if (error) return false;
+
+	error = CFHD_PrepareToEncode(encoderRef, state->width / 2, state->height / 2, CFHD_PIXEL_FORMAT_BYR4,
+								 CFHD_ENCODED_FORMAT_BAYER, CFHD_ENCODING_FLAGS_NONE, CFHD_ENCODING_QUALITY_FILMSCAN1);
+	if (error == CFHD_ERROR_OKAY) {
+		error = CFHD_EncodeSample(encoderRef, state->input[0].data, framePitch);
+	}
+	if (error == CFHD_ERROR_OKAY) {
+		error = CFHD_GetSampleData(encoderRef, &sampleBuffer, &sampleSize);
+	}
+	if (error == CFHD_ERROR_OKAY) {
+		state->sample.assign((uint8_t *)sampleBuffer, (uint8_t *)sampleBuffer + sampleSize);
+	}
+	CFHD_CloseEncoder(encoderRef);
+	if (error) return false;
+
+	if (CFHD_OpenDecoder(&state->decoderRef, NULL) != CFHD_ERROR_OKAY) return false;
+	if (CFHD_OpenMetadata(&state->metadataRef) != CFHD_ERROR_OKAY) return false;
+
+	// The 16-bit output formats use the high quality demosaic
+	error = CFHD_PrepareToDecode(state->decoderRef, 0, 0, CFHD_PIXEL_FORMAT_B64A, CFHD_DECODED_RESOLUTION_FULL,
+								 CFHD_DECODING_FLAGS_NONE, &state->sample[0], state->sample.size(),
+								 &actualWidth, &actualHeight, &actualFormat);
+	if (error) return false;
+
+	error = CFHD_InitSampleMetadata(state->metadataRef, METADATATYPE_ORIGINAL, &state->sample[0], state->sample.size());
+	if (error) return false;
+
+	error = CFHD_SetActiveMetadata(state->decoderRef, state->metadataRef, TAG_CPU_MAX, METADATATYPE_UINT32,
+								   &maxcpus, sizeof(maxcpus));
+	if (error) return false;
+
+	error = CFHD_GetImagePitch(actualWidth, actualFormat, &pitch);
+	if (error) return false;
+
+	error = CFHD_GetImageSize(actualWidth, actualHeight, actualFormat, VIDEO_SELECT_DEFAULT,
+							  STEREO3D_TYPE_DEFAULT, &imageSize);
+	if (error) return false;
+
+	state->outputPitch = pitch;
+	AllocBuffer(&state->output, imageSize);
+
+	return (CFHD_GetDecoderStats(state->decoderRef, NULL, CFHD_STATS_FLAGS_ENABLE) == CFHD_ERROR_OKAY);
+}
+
+static void PrepareDemosaic(KERNEL_STATE *state)
+{
+	// The inverse transform dithers with rand() and the encoder seeds it from the sample metadata
+	srand(KERNEL_SEED);
+}
+
+static bool RunDemosaic(KERNEL_STATE *state)
+{
+	CFHD_Stats stats;
+
+	if (CFHD_DecodeSample(state->decoderRef, &state->sample[0], state->sample.size(),
+						  state->output.data, state->outputPitch) != CFHD_ERROR_OKAY) {
+		return false;
+	}
+
+	if (CFHD_GetDecoderStats(state->decoderRef, &stats, CFHD_STATS_FLAGS_RESET) != CFHD_ERROR_OKAY) {
+		return false;
+	}
+
+	// The sample must have been decoded through the demosaic
+	if (stats.stage[CFHD_STATS_STAGE_DEMOSAIC].count == 0) {
+		return false;
+	}
+
+	state->stageSeconds = (double)stats.stage[CFHD_STATS_STAGE_DEMOSAIC].totalTime / 1.0e9;
+	return true;
+}
+
+static void ReleaseDemosaic(KERNEL_STATE *state)
+{
+	if (state->decoderRef) CFHD_CloseDecoder(state->decoderRef);
+	if (state->metadataRef) CFHD_CloseMetadata(state->metadataRef);
+}
+
+// Mesh with the same size and transform as the decoder uses for rectilinear lens correction
+static bool SetupWarp(KERNEL_STATE *state, int format, int bytesPerPixel)
+{
+	uint32_t seed = KERNEL_SEED;
+	int status = WARPLIB_SUCCESS;
+
+	state->inputPitch = AlignPitch((size_t)state->width * bytesPerPixel);
+	state->outputPitch = state->inputPitch;
+
+	AllocBuffer(&state->input[0], (size_t)state->inputPitch * state->height);
+	AllocBuffer(&state->output, (size_t)state->outputPitch * state->height);
+	FillBytes(state->input[0].data, state->input[0].size, &seed);
+
+	if (state->width >= 2496)
+		state->mesh = geomesh_create(199, 99);
+	else if (state->width >= 1272)
+		state->mesh = geomesh_create(99, 49);
+	else
+		state->mesh = geomesh_create(49, 25);
+
+	if (state->mesh == NULL) {
+		return false;
+	}
+	state->meshFormat = format;
+
+	status |= geomesh_init(state->mesh, state->width, state->height, state->inputPitch, format,
+						   state->width, state->height, state->outputPitch, format, 0);
+	status |= geomesh_transform_gopro_to_rectilinear(state->mesh, 1.0f);
+	status |= geomesh_cache_init_bilinear(state->mesh);
+
+	return (status == WARPLIB_SUCCESS);
+}
+
+static void ReleaseWarp(KERNEL_STATE *state)
+{
+	if (state->mesh) geomesh_destroy(state->mesh);
+}
+
+static bool SetupWarpYUY2(KERNEL_STATE *state) { return SetupWarp(state, WARPLIB_FORMAT_YUY2, 2); }
+static bool SetupWarp2vuy(KERNEL_STATE *state) { return SetupWarp(state, WARPLIB_FORMAT_2vuy, 2); }
+static bool SetupWarpBGRA(KERNEL_STATE *state) { return SetupWarp(state, WARPLIB_FORMAT_32BGRA, 4); }
+static bool SetupWarpARGB(KERNEL_STATE *state) { return SetupWarp(state, WARPLIB_FORMAT_64ARGB, 8); }
+static bool SetupWarpRG48(KERNEL_STATE *state) { return SetupWarp(state, WARPLIB_FORMAT_RG48, 6); }
+static bool SetupWarpW13A(KERNEL_STATE *state) { return SetupWarp(state, WARPLIB_FORMAT_W13A, 8); }
+static bool SetupWarpWP13(KERNEL_STATE *state) { return SetupWarp(state, WARPLIB_FORMAT_WP13, 6); }
+
+#define WARP_KERNEL(name)																		\
+	static bool RunWarp_##name(KERNEL_STATE *state)												\
+	{																							\
+		return (geomesh_apply_bilinear_##name(state->mesh, state->input[0].data,				\
+											  state->output.data, 0, state->height) == WARPLIB_SUCCESS); \
+	}
+
+WARP_KERNEL(yuy2)
+WARP_KERNEL(2vuy)
+WARP_KERNEL(32BGRA)
+WARP_KERNEL(64ARGB)
+WARP_KERNEL(RG48)
+WARP_KERNEL(W13A)
+WARP_KERNEL(WP13)
+
+static const KERNEL Kernels[] =
+{
+	{"DecodeBandFSM16sNoGap",				true,	SetupDecodeBand,		PrepareDecodeBand,	RunDecodeBand,			NULL},
+	{"InvertHorizontalStrip16s",			false,	SetupInvertHorizontal,	NULL,				RunInvertHorizontal,	NULL},
+	{"InvertSpatialQuant16s",				false,	SetupInvertSpatial,		NULL,				RunInvertSpatial,		NULL},
+	{"FilterSpatialQuant16s",				true,	SetupFilterSpatial,		NULL,				RunFilterSpatial,		NULL},
+	{"QuantizeRow16sTo16s",					true,	SetupQuantizeRow,		NULL,				RunQuantizeRow,			NULL},
+	{"ConvertPlanarYUVToV210",				false,	SetupConvertV210,		NULL,				RunConvertV210,			NULL},
+	{"ChunkyBGRA8toPlanarRGB16",			false,	SetupChunkyBGRA,		NULL,				RunChunkyBGRA,			NULL},
+	{"GetBits",								false,	SetupBitstreamFields,	PrepareBitstream,	RunGetBits,				NULL},
+	{"PeekBits",							false,	SetupBitstreamFields,	PrepareBitstream,	RunPeekBits,			NULL},
+	{"GetTagValue",							false,	SetupBitstreamTags,		PrepareBitstream,	RunGetTagValue,			NULL},
+	{"DemosaicRAW",							false,	SetupDemosaic,			PrepareDemosaic,	RunDemosaic,			ReleaseDemosaic},
+	{"geomesh_apply_bilinear_yuy2",			false,	SetupWarpYUY2,			NULL,				RunWarp_yuy2,			ReleaseWarp},
+	{"geomesh_apply_bilinear_2vuy",			false,	SetupWarp2vuy,			NULL,				RunWarp_2vuy,			ReleaseWarp},
+	{"geomesh_apply_bilinear_32BGRA",		false,	SetupWarpBGRA,			NULL,				RunWarp_32BGRA,			ReleaseWarp},
+	{"geomesh_apply_bilinear_64ARGB",		false,	SetupWarpARGB,			NULL,				RunWarp_64ARGB,			ReleaseWarp},
+	{"geomesh_apply_bilinear_RG48",			false,	SetupWarpRG48,			NULL,				RunWarp_RG48,			ReleaseWarp},
+	{"geomesh_apply_bilinear_W13A",			false,	SetupWarpW13A,			NULL,				RunWarp_W13A,			ReleaseWarp},
+	{"geomesh_apply_bilinear_WP13",			false,	SetupWarpWP13,			NULL,				RunWarp_WP13,			ReleaseWarp},
+	{NULL, false, NULL, NULL, NULL, NULL}
+};
+
+
+// Split a comma separated list into the tokens (the list is modified)
+static std::vector<char *> SplitList(char *list)
+{
+	std::vector<char *> tokens;
+	char *token = strtok(list, ",");
+
+	while (token != NULL) {
+		tokens.push_back(token);
+		token = strtok(NULL, ",");
+	}
+
+	return tokens;
+}
+
+static bool ParseNumbers(char *list, std::vector<int> &numbers, int minimum)
+{
+	std::vector<char *> tokens = SplitList(list);
+
+	numbers.clear();
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		int number = atoi(tokens[i]);
+		if (number < minimum) {
+			fprintf(stderr, "values must be at least %d: %s\n", minimum, tokens[i]);
+			return false;
+		}
+		numbers.push_back(number);
+	}
+
+	return !numbers.empty();
+}
+
+static void SetDefaultOptions(KERNEL_OPTIONS *options)
+{
+	// Luma widths of HD and UHD frames and typical highpass quantizers
+	options->widths.push_back(1920);
+	options->widths.push_back(3840);
+	options->quants.push_back(1);
+	options->quants.push_back(24);
+	options->height = KERNEL_DEFAULT_HEIGHT;
+	options->seconds = KERNEL_DEFAULT_SECONDS;
+	options->record = false;
+	options->outputName = NULL;
+}
+
+static void Usage(const char *program)
+{
+	printf("usage: %s [options]\n", program);
+	printf("          --kernels=Invert,geomesh .. run the kernels with names that contain any of the strings\n");
+	printf("          --widths=1920,3840 ......... strip widths in pixels (multiples of 48)\n");
+	printf("          --height=%d ................ rows processed by each call\n", KERNEL_DEFAULT_HEIGHT);
+	printf("          --quant=1,24 ............... quantizers for the kernels that quantize or dequantize\n");
+	printf("          --seconds=%.2f ............. minimum time to spend timing each combination\n", KERNEL_DEFAULT_SECONDS);
+	printf("          --record=1 ................. print the golden table for kernelgolden.h instead of timing\n");
+	printf("          --output=file.json ......... write the results to a file instead of stdout\n");
+}
+
+static bool ParseOptions(int argc, char **argv, KERNEL_OPTIONS *options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		char *arg = argv[i];
+		char *value = strchr(arg, '=');
+		bool okay = true;
+
+		if (strncmp(arg, "--", 2) != 0 || value == NULL) {
+			return false;
+		}
+		*value++ = '\0';
+
+		if (strcmp(arg, "--kernels") == 0) options->kernels = SplitList(value);
+		else if (strcmp(arg, "--widths") == 0) okay = ParseNumbers(value, options->widths, 48);
+		else if (strcmp(arg, "--height") == 0) okay = (options->height = atoi(value)) >= 16;
+		else if (strcmp(arg, "--quant") == 0) okay = ParseNumbers(value, options->quants, 1);
+		else if (strcmp(arg, "--seconds") == 0) okay = (options->seconds = atof(value)) > 0.0;
+		else if (strcmp(arg, "--record") == 0) options->record = (atoi(value) != 0);
+		else if (strcmp(arg, "--output") == 0) options->outputName = value;
+		else okay = false;
+
+		if (!okay) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool SelectedKernel(const KERNEL_OPTIONS *options, const KERNEL *kernel)
+{
+	if (options->kernels.empty()) {
+		return true;
+	}
+
+	for (size_t i = 0; i < options->kernels.size(); i++) {
+		if (strstr(kernel->name, options->kernels[i]) != NULL) return true;
+	}
+
+	return false;
+}
+
+static const KERNEL_GOLDEN *FindGolden(const char *name, int width, int height, int quant)
+{
+	for (const KERNEL_GOLDEN *golden = KernelGolden; golden->name != NULL; golden++)
+	{
+		if (strcmp(golden->name, name) == 0 && golden->width == width &&
+			golden->height == height && golden->quant == quant) {
+			return golden;
+		}
+	}
+	return NULL;
+}
+
+static double Median(std::vector<double> &values)
+{
+	size_t middle = values.size() / 2;
+	std::nth_element(values.begin(), values.begin() + middle, values.end());
+	return values[middle];
+}
+
+// Call the kernel once to hash the output and then time the calls
+static bool MeasureKernel(const KERNEL *kernel, KERNEL_STATE *state, const KERNEL_OPTIONS *options,
+						  KERNEL_RESULT *result)
+{
+	std::vector<double> cycles;
+	std::vector<double> seconds;
+	double total = 0.0;
+
+	if (kernel->prepare) kernel->prepare(state);
+	if (!kernel->run(state)) {
+		return false;
+	}
+	result->hash = HashBuffer(state->output.data, state->output.size);
+
+	if (options->record) {
+		return true;
+	}
+
+	while ((int)seconds.size() < KERNEL_MIN_CALLS || total < options->seconds)
+	{
+		double start;
+		double elapsed;
+		uint64_t first;
+		uint64_t last;
+
+		if (kernel->prepare) kernel->prepare(state);
+
+		state->stageSeconds = -1.0;		// Set by the kernel if the time is measured by the decoder
+		start = gettime();
+		first = ReadTimestamp();
+
+		if (!kernel->run(state)) {
+			return false;
+		}
+
+		last = ReadTimestamp();
+		elapsed = gettime() - start;
+		total += elapsed;
+
+		// Use the time measured by the decoder if the kernel runs inside the decoder
+		if (state->stageSeconds >= 0.0) {
+			elapsed = state->stageSeconds;
+			cycles.push_back(elapsed * TimestampFrequency);
+		}
+		else {
+			cycles.push_back((double)(last - first));
+		}
+		seconds.push_back(elapsed);
+	}
+
+	result->calls = (int)seconds.size();
+	result->minCycles = *std::min_element(cycles.begin(), cycles.end());
+	result->medianCycles = Median(cycles);
+	result->medianSeconds = Median(seconds);
+
+	return true;
+}
+
+static void WriteResult(FILE *file, bool first, const KERNEL *kernel, const KERNEL_STATE *state,
+						bool okay, const KERNEL_RESULT *result, const char *check)
+{
+	double pixels = (double)state->width * state->height;
+
+	fprintf(file, "%s    {\"kernel\": \"%s\", \"width\": %d, \"height\": %d, \"quant\": %d",
+			first ? "" : ",\n", kernel->name, state->width, state->height, state->quant);
+
+	if (!okay)
+	{
+		fprintf(file, ", \"error\": true}");
+		return;
+	}
+
+	fprintf(file, ", \"calls\": %d", result->calls);
+	if (TimestampFrequency > 0.0) {
+		fprintf(file, ", \"cycles_per_pixel\": %.3f, \"min_cycles_per_pixel\": %.3f",
+				result->medianCycles / pixels, result->minCycles / pixels);
+	}
+	fprintf(file, ", \"ns_per_pixel\": %.4f, \"mpixels_per_sec\": %.2f, \"hash\": \"%016llx\", \"golden\": \"%s\"}",
+			result->medianSeconds * 1.0e9 / pixels, pixels / result->medianSeconds / 1.0e6,
+			(unsigned long long)result->hash, check);
+}
+
+int main(int argc, char **argv)
+{
+	KERNEL_OPTIONS options;
+	FILE *file = stdout;
+	bool first = true;
+	int failures = 0;
+
+	SetDefaultOptions(&options);
+
+	if (!ParseOptions(argc, argv, &options))
+	{
+		Usage(argv[0]);
+		return 1;
+	}
+
+	if (options.outputName && !options.record)
+	{
+		file = fopen(options.outputName, "w");
+		if (file == NULL) {
+			fprintf(stderr, "could not create %s\n", options.outputName);
+			return 1;
+		}
+	}
+
+	if (ReadTimestamp() != 0) {
+		CalibrateTimestamp();
+	}
+
+	if (!options.record) {
+		fprintf(file, "{\n  \"height\": %d,\n  \"timestamp_ghz\": %.3f,\n  \"cpus\": %u,\n  \"results\": [\n",
+				options.height, TimestampFrequency / 1.0e9, std::thread::hardware_concurrency());
+	}
+
+	for (const KERNEL *kernel = Kernels; kernel->name != NULL; kernel++)
+	{
+		if (!SelectedKernel(&options, kernel)) {
+			continue;
+		}
+
+		for (size_t w = 0; w < options.widths.size(); w++)
+		for (size_t q = 0; q < (kernel->quantized ? options.quants.size() : 1); q++)
+		{
+			KERNEL_STATE state = KERNEL_STATE();
+			KERNEL_RESULT result;
+			const KERNEL_GOLDEN *golden;
+			const char *check = "none";
+			bool okay;
+
+			memset(&result, 0, sizeof(result));
+			state.width = options.widths[w];
+			state.height = options.height;
+			state.quant = kernel->quantized ? options.quants[q] : 0;
+
+			// The setup can change the height (the demosaic decodes a whole frame)
+			okay = kernel->setup(&state);
+
+			fprintf(stderr, "%s width %d height %d quant %d\n", kernel->name, state.width, state.height, state.quant);
+
+			okay = okay && MeasureKernel(kernel, &state, &options, &result);
+
+			if (kernel->release) {
+				kernel->release(&state);
+			}
+
+			if (!okay)
+			{
+				fprintf(stderr, "%s failed\n", kernel->name);
+				failures++;
+			}
+			else if (options.record)
+			{
+				printf("\t{\"%s\", %d, %d, %d, 0x%016llxULL},\n", kernel->name, state.width, state.height,
+					   state.quant, (unsigned long long)result.hash);
+				continue;
+			}
+			else if ((golden = FindGolden(kernel->name, state.width, state.height, state.quant)) != NULL)
+			{
+				check = (golden->hash == result.hash) ? "pass" : "fail";
+				if (golden->hash != result.hash) {
+					fprintf(stderr, "%s output does not match the golden hash\n", kernel->name);
+					failures++;
+				}
+			}
+
+			if (!options.record)
+			{
+				WriteResult(file, first, kernel, &state, okay, &result, check);
+				first = false;
+				fflush(file);
+			}
+		}
+	}
+
+	if (!options.record) {
+		fprintf(file, "\n  ]\n}\n");
+	}
+
+	if (file != stdout) {
+		fclose(file);
+	}
+
+	return (failures > 0) ? 2 : 0;
+}
@@ -0,0 +1,68 @@
+/*! @file kernelgolden.h
+
+*  @brief Hashes of the kernel outputs checked by the kernel microbenchmarks
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+// Generated by cfhd-kernelbench --record=1 for the default widths, height and quantizers
+static const KERNEL_GOLDEN KernelGolden[] =
+{
+	{"DecodeBandFSM16sNoGap", 1920, 64, 1, 0x0e3e10394e8d5222ULL},
+	{"DecodeBandFSM16sNoGap", 1920, 64, 24, 0xa9977d840b513bd7ULL},
+	{"DecodeBandFSM16sNoGap", 3840, 64, 1, 0x3312bc57c6aa26feULL},
+	{"DecodeBandFSM16sNoGap", 3840, 64, 24, 0xcf70b15fe2e955f5ULL},
+	{"InvertHorizontalStrip16s", 1920, 64, 0, 0x8207e09d42d88597ULL},
+	{"InvertHorizontalStrip16s", 3840, 64, 0, 0x039f6807ce270f02ULL},
+	{"InvertSpatialQuant16s", 1920, 64, 0, 0xe2cb00ef6614cf6dULL},
+	{"InvertSpatialQuant16s", 3840, 64, 0, 0xecc5e15e921fd05aULL},
+	{"FilterSpatialQuant16s", 1920, 64, 1, 0x3ccb5f8cc39a5d2eULL},
+	{"FilterSpatialQuant16s", 1920, 64, 24, 0xf949b99be1f1d78aULL},
+	{"FilterSpatialQuant16s", 3840, 64, 1, 0x36a0cb658b6a9aa1ULL},
+	{"FilterSpatialQuant16s", 3840, 64, 24, 0xb2561ea08c6e396fULL},
+	{"QuantizeRow16sTo16s", 1920, 64, 1, 0x323238976b865acdULL},
+	{"QuantizeRow16sTo16s", 1920, 64, 24, 0xb9418d2ca1072d0dULL},
+	{"QuantizeRow16sTo16s", 3840, 64, 1, 0xaca7e13da6c14fadULL},
+	{"QuantizeRow16sTo16s", 3840, 64, 24, 0xe9fff99b149c0180ULL},
+	{"ConvertPlanarYUVToV210", 1920, 64, 0, 0x080906918ac6b4bcULL},
+	{"ConvertPlanarYUVToV210", 3840, 64, 0, 0x4cde8bc5116e1169ULL},
+	{"ChunkyBGRA8toPlanarRGB16", 1920, 64, 0, 0x1f4d96d1ca8295e1ULL},
+	{"ChunkyBGRA8toPlanarRGB16", 3840, 64, 0, 0x74e0e2b76fea8c5cULL},
+	{"GetBits", 1920, 1080, 0, 0x83393801b3e8c6b6ULL},
+	{"GetBits", 3840, 2160, 0, 0xb19de73052c187dfULL},
+	{"PeekBits", 1920, 1080, 0, 0x47367c1bc7796846ULL},
+	{"PeekBits", 3840, 2160, 0, 0xc0c26f94db9c1b5bULL},
+	{"GetTagValue", 1920, 1080, 0, 0x90bd697bbdea8fa4ULL},
+	{"GetTagValue", 3840, 2160, 0, 0x0e89c8511f05280fULL},
+	{"DemosaicRAW", 1920, 1080, 0, 0x038342024b59c629ULL},
+	{"DemosaicRAW", 3840, 2160, 0, 0xee505b18b8109098ULL},
+	{"geomesh_apply_bilinear_yuy2", 1920, 64, 0, 0x244f8221bf7e4552ULL},
+	{"geomesh_apply_bilinear_yuy2", 3840, 64, 0, 0x2c60ea9987bb6cf6ULL},
+	{"geomesh_apply_bilinear_2vuy", 1920, 64, 0, 0xd76f424a93934d2bULL},
+	{"geomesh_apply_bilinear_2vuy", 3840, 64, 0, 0x1058f63210620c96ULL},
+	{"geomesh_apply_bilinear_32BGRA", 1920, 64, 0, 0x9954fc83e94df658ULL},
+	{"geomesh_apply_bilinear_32BGRA", 3840, 64, 0, 0x903646fa80245df3ULL},
+	{"geomesh_apply_bilinear_64ARGB", 1920, 64, 0, 0xafcce9e2f4d9138eULL},
+	{"geomesh_apply_bilinear_64ARGB", 3840, 64, 0, 0xf1f09cca71675897ULL},
+	{"geomesh_apply_bilinear_RG48", 1920, 64, 0, 0x0b0b95eddaf4ef61ULL},
+	{"geomesh_apply_bilinear_RG48", 3840, 64, 0, 0x51623851c9910ea2ULL},
+	{"geomesh_apply_bilinear_W13A", 1920, 64, 0, 0x7c9add95ed8e780cULL},
+	{"geomesh_apply_bilinear_W13A", 3840, 64, 0, 0x757c43ab3a810512ULL},
+	{"geomesh_apply_bilinear_WP13", 1920, 64, 0, 0x464cd0dd14db7687ULL},
+	{"geomesh_apply_bilinear_WP13", 3840, 64, 0, 0x55cea088f4aecec8ULL},
+	{NULL, 0, 0, 0, 0}
+};
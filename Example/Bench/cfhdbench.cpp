@@ -0,0 +1,823 @@
+/*! @file cfhdbench.cpp
+
+*  @brief Benchmark of encoding and decoding synthetic frames with the results in JSON
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+/*
+	Every combination of the pixel formats, encoded formats, qualities, frame
+	sizes, decoded resolutions and thread counts on the command line is run
+	in turn.  The source frame is rendered by qbist with a fixed seed so the
+	results can be compared between runs and machines, and no media files are
+	needed.  Each combination encodes the frame with one encoder, encodes it
+	again with a pool of encoders if more than one thread is requested, and
+	decodes the encoded sample with the decoder limited to the thread count.
+
+	The results are written as one JSON object with an entry for each
+	combination, so the output can be compared against a baseline to catch
+	regressions.  The peak resident set size is for the whole process, so it
+	is the peak of all of the combinations that have been run so far.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __APPLE__
+#include <sys/time.h>
+#endif
+
+#include "CFHDDecoder.h"
+#include "CFHDEncoder.h"
+#include "CFHDMetadata.h"
+
+#include "utils.h"
+#include "qbist.h"
+
+#define BENCH_QBIST_SEED		50		// Same seed as TestCFHD
+#define BENCH_DEFAULT_FRAMES	10
+#define BENCH_DEFAULT_RATE		24.0	// Frame rate used to compute the bitrate
+
+#define PRINTF_PIXELFORMAT(k)	((k) >> 24) & 0xff, ((k) >> 16) & 0xff, ((k) >> 8) & 0xff, ((k) >> 0) & 0xff
+
+typedef struct
+{
+	const char *name;
+	int value;
+
+} BENCH_NAME;
+
+static const BENCH_NAME EncodedFormatNames[] =
+{
+	{"422",		CFHD_ENCODED_FORMAT_YUV_422},
+	{"444",		CFHD_ENCODED_FORMAT_RGB_444},
+	{"4444",	CFHD_ENCODED_FORMAT_RGBA_4444},
+	{"bayer",	CFHD_ENCODED_FORMAT_BAYER},
+	{NULL, 0}
+};
+
+static const BENCH_NAME QualityNames[] =
+{
+	{"low",			CFHD_ENCODING_QUALITY_LOW},
+	{"medium",		CFHD_ENCODING_QUALITY_MEDIUM},
+	{"high",		CFHD_ENCODING_QUALITY_HIGH},
+	{"filmscan1",	CFHD_ENCODING_QUALITY_FILMSCAN1},
+	{"filmscan2",	CFHD_ENCODING_QUALITY_FILMSCAN2},
+	{"filmscan3",	CFHD_ENCODING_QUALITY_FILMSCAN3},
+	{NULL, 0}
+};
+
+static const BENCH_NAME ResolutionNames[] =
+{
+	{"full",	CFHD_DECODED_RESOLUTION_FULL},
+	{"half",	CFHD_DECODED_RESOLUTION_HALF},
+	{"quarter",	CFHD_DECODED_RESOLUTION_QUARTER},
+	{NULL, 0}
+};
+
+// Names of the stages in the statistics (indexed by CFHD_StatsStage)
+static const char *StageNames[CFHD_STATS_STAGE_COUNT] =
+{
+	"frame", "header", "entropy", "transform", "demosaic", "color", "output", "warp", "input"
+};
+
+// Pixel formats that qbist can render (the Bayer source is made from RG48)
+static const CFHD_PixelFormat SourceFormats[] =
+{
+	CFHD_PIXEL_FORMAT_YUY2, CFHD_PIXEL_FORMAT_2VUY, CFHD_PIXEL_FORMAT_YU64,
+	CFHD_PIXEL_FORMAT_RG24, CFHD_PIXEL_FORMAT_BGRA, CFHD_PIXEL_FORMAT_BGRa,
+	CFHD_PIXEL_FORMAT_R210, CFHD_PIXEL_FORMAT_DPX0, CFHD_PIXEL_FORMAT_AB10,
+	CFHD_PIXEL_FORMAT_AR10, CFHD_PIXEL_FORMAT_RG48, CFHD_PIXEL_FORMAT_B64A,
+	CFHD_PIXEL_FORMAT_UNKNOWN
+};
+
+typedef struct
+{
+	int width;
+	int height;
+
+} BENCH_SIZE;
+
+// Lists of values that are combined into the benchmark matrix
+typedef struct
+{
+	std::vector<CFHD_PixelFormat> pixelFormats;
+	std::vector<int> encodedFormats;
+	std::vector<int> qualities;
+	std::vector<BENCH_SIZE> sizes;
+	std::vector<int> resolutions;
+	std::vector<int> threads;
+	int frames;
+	double frameRate;
+	const char *outputName;
+
+} BENCH_OPTIONS;
+
+// Times and sizes measured for one combination
+typedef struct
+{
+	double encodeSeconds;		// Time to encode all frames with one encoder
+	double poolSeconds;			// Time to encode all frames with a pool of encoders (zero if not run)
+	double decodeSeconds;		// Time to decode all frames
+	size_t inputSize;			// Size of the source frame in bytes
+	size_t sampleSize;			// Size of the encoded sample in bytes
+	size_t outputSize;			// Size of the decoded frame in bytes
+	int decodedWidth;
+	int decodedHeight;
+	CFHD_Stats encodeStats;
+	CFHD_Stats decodeStats;
+
+} BENCH_RESULT;
+
+
+double gettime(void)
+{
+#ifdef __APPLE__
+	timeval ts;
+	gettimeofday(&ts, NULL);
+	return (double)ts.tv_sec + (double)ts.tv_usec / 1000000.0;
+#elif _WIN32
+	LARGE_INTEGER precision, ts;
+	::QueryPerformanceCounter(&ts);
+	::QueryPerformanceFrequency(&precision);
+	return static_cast<double>(ts.QuadPart)/static_cast<double>(precision.QuadPart);
+#else
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+// Return the peak resident set size of the process in kilobytes
+static uint64_t PeakResidentKilobytes(void)
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return (uint64_t)counters.PeakWorkingSetSize / 1024;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#ifdef __APPLE__
+	return (uint64_t)usage.ru_maxrss / 1024;	// Reported in bytes
+#else
+	return (uint64_t)usage.ru_maxrss;			// Reported in kilobytes
+#endif
+#endif
+}
+
+static const char *FindName(const BENCH_NAME *names, int value)
+{
+	for (; names->name != NULL; names++) {
+		if (names->value == value) return names->name;
+	}
+	return "unknown";
+}
+
+static bool FindValue(const BENCH_NAME *names, const char *name, int *value)
+{
+	for (; names->name != NULL; names++)
+	{
+		if (strcmp(names->name, name) == 0) {
+			*value = names->value;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Split a comma separated list into the tokens (the list is modified)
+static std::vector<char *> SplitList(char *list)
+{
+	std::vector<char *> tokens;
+	char *token = strtok(list, ",");
+
+	while (token != NULL) {
+		tokens.push_back(token);
+		token = strtok(NULL, ",");
+	}
+
+	return tokens;
+}
+
+static bool ParseNames(const BENCH_NAME *names, char *list, std::vector<int> &values)
+{
+	std::vector<char *> tokens = SplitList(list);
+
+	values.clear();
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		int value;
+		if (!FindValue(names, tokens[i], &value)) {
+			fprintf(stderr, "unknown value: %s\n", tokens[i]);
+			return false;
+		}
+		values.push_back(value);
+	}
+
+	return !values.empty();
+}
+
+static bool ParsePixelFormats(char *list, std::vector<CFHD_PixelFormat> &formats)
+{
+	std::vector<char *> tokens = SplitList(list);
+
+	formats.clear();
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		const char *code = tokens[i];
+		CFHD_PixelFormat format;
+		int k;
+
+		if (strlen(code) != 4) {
+			fprintf(stderr, "pixel formats are four character codes: %s\n", code);
+			return false;
+		}
+
+		format = (CFHD_PixelFormat)(((uint32_t)code[0] << 24) | ((uint32_t)code[1] << 16) | ((uint32_t)code[2] << 8) | (uint32_t)code[3]);
+
+		for (k = 0; SourceFormats[k] != CFHD_PIXEL_FORMAT_UNKNOWN; k++) {
+			if (SourceFormats[k] == format) break;
+		}
+		if (SourceFormats[k] == CFHD_PIXEL_FORMAT_UNKNOWN)
+		{
+			fprintf(stderr, "unsupported pixel format: %s (use", code);
+			for (k = 0; SourceFormats[k] != CFHD_PIXEL_FORMAT_UNKNOWN; k++) {
+				fprintf(stderr, " %c%c%c%c", PRINTF_PIXELFORMAT(SourceFormats[k]));
+			}
+			fprintf(stderr, ")\n");
+			return false;
+		}
+
+		formats.push_back(format);
+	}
+
+	return !formats.empty();
+}
+
+static bool ParseSizes(char *list, std::vector<BENCH_SIZE> &sizes)
+{
+	std::vector<char *> tokens = SplitList(list);
+
+	sizes.clear();
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		BENCH_SIZE size;
+		if (sscanf(tokens[i], "%dx%d", &size.width, &size.height) != 2 ||
+			size.width < 16 || size.height < 16) {
+			fprintf(stderr, "sizes are WIDTHxHEIGHT: %s\n", tokens[i]);
+			return false;
+		}
+		sizes.push_back(size);
+	}
+
+	return !sizes.empty();
+}
+
+static bool ParseNumbers(char *list, std::vector<int> &numbers)
+{
+	std::vector<char *> tokens = SplitList(list);
+
+	numbers.clear();
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		int number = atoi(tokens[i]);
+		if (number < 1) {
+			fprintf(stderr, "thread counts must be positive: %s\n", tokens[i]);
+			return false;
+		}
+		numbers.push_back(number);
+	}
+
+	return !numbers.empty();
+}
+
+static void SetDefaultOptions(BENCH_OPTIONS *options)
+{
+	int cpus = (int)std::thread::hardware_concurrency();
+	BENCH_SIZE size = {1920, 1080};
+
+	options->pixelFormats.push_back(CFHD_PIXEL_FORMAT_YUY2);
+	options->pixelFormats.push_back(CFHD_PIXEL_FORMAT_B64A);
+	options->encodedFormats.push_back(CFHD_ENCODED_FORMAT_YUV_422);
+	options->encodedFormats.push_back(CFHD_ENCODED_FORMAT_RGB_444);
+	options->qualities.push_back(CFHD_ENCODING_QUALITY_FILMSCAN1);
+	options->sizes.push_back(size);
+	options->resolutions.push_back(CFHD_DECODED_RESOLUTION_FULL);
+	options->resolutions.push_back(CFHD_DECODED_RESOLUTION_HALF);
+	options->threads.push_back(1);
+	if (cpus > 1) {
+		options->threads.push_back(cpus);
+	}
+	options->frames = BENCH_DEFAULT_FRAMES;
+	options->frameRate = BENCH_DEFAULT_RATE;
+	options->outputName = NULL;
+}
+
+static void Usage(const char *program)
+{
+	printf("usage: %s [options]\n", program);
+	printf("          --formats=YUY2,b64a ...... pixel formats of the source and decoded frames\n");
+	printf("          --encoded=422,444 ........ encoded formats (422, 444, 4444, bayer)\n");
+	printf("          --quality=filmscan1 ...... low, medium, high, filmscan1, filmscan2, filmscan3\n");
+	printf("          --sizes=1920x1080 ........ frame sizes (the sensor size for bayer)\n");
+	printf("          --resolutions=full,half .. decoded resolutions (full, half, quarter)\n");
+	printf("          --threads=1,N ............ decoder threads and encoders in the pool\n");
+	printf("          --frames=%d .............. frames encoded and decoded for each combination\n", BENCH_DEFAULT_FRAMES);
+	printf("          --rate=%.0f ................ frame rate used to compute the bitrate\n", BENCH_DEFAULT_RATE);
+	printf("          --output=file.json ....... write the results to a file instead of stdout\n");
+}
+
+static bool ParseOptions(int argc, char **argv, BENCH_OPTIONS *options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		char *arg = argv[i];
+		char *value = strchr(arg, '=');
+		bool okay = true;
+
+		if (strncmp(arg, "--", 2) != 0 || value == NULL) {
+			return false;
+		}
+		*value++ = '\0';
+
+		if (strcmp(arg, "--formats") == 0) okay = ParsePixelFormats(value, options->pixelFormats);
+		else if (strcmp(arg, "--encoded") == 0) okay = ParseNames(EncodedFormatNames, value, options->encodedFormats);
+		else if (strcmp(arg, "--quality") == 0) okay = ParseNames(QualityNames, value, options->qualities);
+		else if (strcmp(arg, "--sizes") == 0) okay = ParseSizes(value, options->sizes);
+		else if (strcmp(arg, "--resolutions") == 0) okay = ParseNames(ResolutionNames, value, options->resolutions);
+		else if (strcmp(arg, "--threads") == 0) okay = ParseNumbers(value, options->threads);
+		else if (strcmp(arg, "--frames") == 0) okay = (options->frames = atoi(value)) > 0;
+		else if (strcmp(arg, "--rate") == 0) okay = (options->frameRate = atof(value)) > 0.0;
+		else if (strcmp(arg, "--output") == 0) options->outputName = value;
+		else okay = false;
+
+		if (!okay) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Can the encoder convert the pixel format to the encoded format?
+static bool SupportedCombination(CFHD_PixelFormat pixelFormat, int encodedFormat)
+{
+	bool yuv = (pixelFormat == CFHD_PIXEL_FORMAT_YUY2 ||
+				pixelFormat == CFHD_PIXEL_FORMAT_2VUY ||
+				pixelFormat == CFHD_PIXEL_FORMAT_YU64);
+
+	switch (encodedFormat)
+	{
+	case CFHD_ENCODED_FORMAT_RGB_444:
+		return !yuv;
+
+	case CFHD_ENCODED_FORMAT_RGBA_4444:
+		return (ChannelsInPixelFormat(pixelFormat) == 4);
+
+	default:
+		// The Bayer source is always BYR4 and is decoded to the pixel format
+		return true;
+	}
+}
+
+/*!
+	Render the source frame with qbist.  The Bayer source is a BYR4 frame with
+	the sensor dimensions and each 2x2 quad of the mosaic is made from one pixel
+	of an RG48 frame with the dimensions of the encoded channels.
+*/
+static bool RenderSource(std::vector<uint8_t> &frame, CFHD_PixelFormat pixelFormat, int encodedFormat,
+						 int width, int height, int *framePitch)
+{
+	int alpha = (encodedFormat == CFHD_ENCODED_FORMAT_RGBA_4444);
+
+	GetRand(BENCH_QBIST_SEED);
+	initBaseTransform();
+
+	if (encodedFormat == CFHD_ENCODED_FORMAT_BAYER)
+	{
+		int quadWidth = width / 2;
+		int quadHeight = height / 2;
+		int rgbPitch = FramePitch4PixelFormat(CFHD_PIXEL_FORMAT_RG48, quadWidth);
+		std::vector<uint8_t> rgb((size_t)quadWidth * quadHeight * 4 * 2);
+
+		RunQBist(quadWidth, quadHeight, rgbPitch, CFHD_PIXEL_FORMAT_RG48, 0, &rgb[0]);
+
+		// Each row of quads is two rows of the mosaic
+		*framePitch = quadWidth * 2 * sizeof(uint16_t);
+		frame.resize((size_t)(*framePitch) * quadHeight * 2);
+
+		for (int row = 0; row < quadHeight; row++)
+		{
+			const uint16_t *rgbRow = (const uint16_t *)&rgb[(size_t)row * rgbPitch];
+			uint16_t *upper = (uint16_t *)&frame[(size_t)(2 * row) * (*framePitch)];
+			uint16_t *lower = (uint16_t *)&frame[(size_t)(2 * row + 1) * (*framePitch)];
+
+			for (int column = 0; column < quadWidth; column++)
+			{
+				upper[2 * column + 0] = rgbRow[3 * column + 0];
+				upper[2 * column + 1] = rgbRow[3 * column + 1];
+				lower[2 * column + 0] = rgbRow[3 * column + 1];
+				lower[2 * column + 1] = rgbRow[3 * column + 2];
+			}
+		}
+
+		return true;
+	}
+
+	*framePitch = FramePitch4PixelFormat(pixelFormat, width);
+
+	// Enough space for the 64-bit RGBA pixels rendered by qbist
+	frame.resize((size_t)width * height * 4 * 2);
+	RunQBist(width, height, *framePitch, pixelFormat, alpha, &frame[0]);
+
+	return true;
+}
+
+static CFHD_Error EncodeFrames(const BENCH_OPTIONS *options, std::vector<uint8_t> &frame, int framePitch,
+							   CFHD_PixelFormat inputFormat, int encodedFormat, int quality,
+							   int width, int height, std::vector<uint8_t> &sample, BENCH_RESULT *result)
+{
+	CFHD_EncoderRef encoderRef = NULL;
+	CFHD_Error error;
+	void *sampleBuffer = NULL;
+	size_t sampleSize = 0;
+	double start;
+
+	error = CFHD_OpenEncoder(&encoderRef, NULL);
+	if (error) return error;
+
+	error = CFHD_PrepareToEncode(encoderRef, width, height, inputFormat, (CFHD_EncodedFormat)encodedFormat,
+								 CFHD_ENCODING_FLAGS_NONE, (CFHD_EncodingQuality)quality);
+	if (error) goto cleanup;
+
+	// Encode one frame before timing to allocate the buffers
+	error = CFHD_GetEncoderStats(encoderRef, NULL, CFHD_STATS_FLAGS_ENABLE);
+	if (error) goto cleanup;
+
+	error = CFHD_EncodeSample(encoderRef, &frame[0], framePitch);
+	if (error) goto cleanup;
+
+	error = CFHD_GetEncoderStats(encoderRef, NULL, CFHD_STATS_FLAGS_RESET);
+	if (error) goto cleanup;
+
+	start = gettime();
+	for (int i = 0; i < options->frames; i++)
+	{
+		error = CFHD_EncodeSample(encoderRef, &frame[0], framePitch);
+		if (error) goto cleanup;
+	}
+	result->encodeSeconds = gettime() - start;
+
+	error = CFHD_GetEncoderStats(encoderRef, &result->encodeStats, CFHD_STATS_FLAGS_NONE);
+	if (error) goto cleanup;
+
+	error = CFHD_GetSampleData(encoderRef, &sampleBuffer, &sampleSize);
+	if (error) goto cleanup;
+
+	sample.assign((uint8_t *)sampleBuffer, (uint8_t *)sampleBuffer + sampleSize);
+	result->sampleSize = sampleSize;
+
+cleanup:
+	CFHD_CloseEncoder(encoderRef);
+	return error;
+}
+
+// Encode the frames with one asynchronous encoder for each thread
+static CFHD_Error EncodeFramesPool(const BENCH_OPTIONS *options, std::vector<uint8_t> &frame, int framePitch,
+								   CFHD_PixelFormat inputFormat, int encodedFormat, int quality,
+								   int width, int height, int threads, BENCH_RESULT *result)
+{
+	CFHD_EncoderPoolRef encoderPoolRef = NULL;
+	CFHD_MetadataRef metadataRef = NULL;
+	CFHD_Error error;
+	int queueLength = threads * 2;
+	int queued = 0;
+	int submitted = 0;
+	int completed = 0;
+	double start;
+
+	error = CFHD_MetadataOpen(&metadataRef);
+	if (error) return error;
+
+	error = CFHD_CreateEncoderPool(&encoderPoolRef, threads, queueLength, NULL);
+	if (error) goto cleanup;
+
+	error = CFHD_PrepareEncoderPool(encoderPoolRef, width, height, inputFormat, (CFHD_EncodedFormat)encodedFormat,
+									CFHD_ENCODING_FLAGS_NONE, (CFHD_EncodingQuality)quality);
+	if (error) goto cleanup;
+
+	CFHD_AttachEncoderPoolMetadata(encoderPoolRef, metadataRef);
+
+	error = CFHD_StartEncoderPool(encoderPoolRef);
+	if (error) goto cleanup;
+
+	start = gettime();
+	while (completed < options->frames)
+	{
+		uint32_t frameNumber;
+		CFHD_SampleBufferRef sampleBufferRef = NULL;
+
+		// Keep the queue full so that every encoder is busy
+		if (submitted < options->frames && queued < queueLength)
+		{
+			error = CFHD_EncodeAsyncSample(encoderPoolRef, submitted, &frame[0], framePitch, metadataRef);
+			if (error) goto cleanup;
+
+			submitted++;
+			queued++;
+			continue;
+		}
+
+		error = CFHD_WaitForSample(encoderPoolRef, &frameNumber, &sampleBufferRef);
+		if (error) goto cleanup;
+
+		CFHD_ReleaseSampleBuffer(encoderPoolRef, sampleBufferRef);
+		queued--;
+		completed++;
+	}
+	result->poolSeconds = gettime() - start;
+
+cleanup:
+	if (encoderPoolRef) CFHD_ReleaseEncoderPool(encoderPoolRef);
+	if (metadataRef) CFHD_MetadataClose(metadataRef);
+	return error;
+}
+
+static CFHD_Error DecodeFrames(const BENCH_OPTIONS *options, std::vector<uint8_t> &sample,
+							   CFHD_PixelFormat pixelFormat, int resolution, int threads, BENCH_RESULT *result)
+{
+	CFHD_DecoderRef decoderRef = NULL;
+	CFHD_MetadataRef metadataRef = NULL;
+	CFHD_PixelFormat actualFormat = CFHD_PIXEL_FORMAT_UNKNOWN;
+	CFHD_Error error;
+	int actualWidth = 0;
+	int actualHeight = 0;
+	int32_t pitch = 0;
+	uint32_t imageSize = 0;
+	uint32_t maxcpus = threads;
+	std::vector<uint8_t> output;
+	double start;
+
+	error = CFHD_OpenDecoder(&decoderRef, NULL);
+	if (error) return error;
+
+	error = CFHD_OpenMetadata(&metadataRef);
+	if (error) goto cleanup;
+
+	error = CFHD_PrepareToDecode(decoderRef, 0, 0, pixelFormat, (CFHD_DecodedResolution)resolution,
+								 CFHD_DECODING_FLAGS_NONE, &sample[0], sample.size(),
+								 &actualWidth, &actualHeight, &actualFormat);
+	if (error) goto cleanup;
+
+	error = CFHD_InitSampleMetadata(metadataRef, METADATATYPE_ORIGINAL, &sample[0], sample.size());
+	if (error) goto cleanup;
+
+	error = CFHD_SetActiveMetadata(decoderRef, metadataRef, TAG_CPU_MAX, METADATATYPE_UINT32,
+								   &maxcpus, sizeof(maxcpus));
+	if (error) goto cleanup;
+
+	error = CFHD_GetImagePitch(actualWidth, actualFormat, &pitch);
+	if (error) goto cleanup;
+
+	error = CFHD_GetImageSize(actualWidth, actualHeight, actualFormat, VIDEO_SELECT_DEFAULT,
+							  STEREO3D_TYPE_DEFAULT, &imageSize);
+	if (error) goto cleanup;
+
+	output.resize(imageSize);
+
+	// Decode one frame before timing to start the worker threads
+	error = CFHD_GetDecoderStats(decoderRef, NULL, CFHD_STATS_FLAGS_ENABLE);
+	if (error) goto cleanup;
+
+	error = CFHD_DecodeSample(decoderRef, &sample[0], sample.size(), &output[0], pitch);
+	if (error) goto cleanup;
+
+	error = CFHD_GetDecoderStats(decoderRef, NULL, CFHD_STATS_FLAGS_RESET);
+	if (error) goto cleanup;
+
+	start = gettime();
+	for (int i = 0; i < options->frames; i++)
+	{
+		error = CFHD_DecodeSample(decoderRef, &sample[0], sample.size(), &output[0], pitch);
+		if (error) goto cleanup;
+	}
+	result->decodeSeconds = gettime() - start;
+
+	error = CFHD_GetDecoderStats(decoderRef, &result->decodeStats, CFHD_STATS_FLAGS_NONE);
+	if (error) goto cleanup;
+
+	result->decodedWidth = actualWidth;
+	result->decodedHeight = actualHeight;
+	result->outputSize = (size_t)imageSize;
+
+cleanup:
+	if (decoderRef) CFHD_CloseDecoder(decoderRef);
+	if (metadataRef) CFHD_CloseMetadata(metadataRef);
+	return error;
+}
+
+// Write the stages that were executed with the times in milliseconds
+static void WriteStages(FILE *file, const CFHD_Stats *stats, int frames)
+{
+	bool first = true;
+
+	fprintf(file, "\"stages\": {");
+	for (int stage = 0; stage < CFHD_STATS_STAGE_COUNT; stage++)
+	{
+		const CFHD_StageStats *counter = &stats->stage[stage];
+		if (counter->count == 0) {
+			continue;
+		}
+
+		fprintf(file, "%s\"%s\": {\"count\": %llu, \"ms_per_frame\": %.3f, \"max_ms\": %.3f}",
+				first ? "" : ", ", StageNames[stage], (unsigned long long)counter->count,
+				(double)counter->totalTime / 1.0e6 / frames, (double)counter->maxTime / 1.0e6);
+		first = false;
+	}
+	fprintf(file, "}");
+}
+
+static void WriteResult(FILE *file, const BENCH_OPTIONS *options, bool first,
+						CFHD_PixelFormat pixelFormat, int encodedFormat, int quality, const BENCH_SIZE *size,
+						int resolution, int threads, CFHD_Error error, const BENCH_RESULT *result)
+{
+	const int frames = options->frames;
+
+	fprintf(file, "%s    {\"pixel_format\": \"%c%c%c%c\", \"encoded_format\": \"%s\", \"quality\": \"%s\", "
+			"\"width\": %d, \"height\": %d, \"decoded_resolution\": \"%s\", \"threads\": %d",
+			first ? "" : ",\n", PRINTF_PIXELFORMAT(pixelFormat), FindName(EncodedFormatNames, encodedFormat),
+			FindName(QualityNames, quality), size->width, size->height,
+			FindName(ResolutionNames, resolution), threads);
+
+	if (error != CFHD_ERROR_OKAY)
+	{
+		fprintf(file, ", \"error\": %d}", error);
+		return;
+	}
+
+	double encodeFPS = frames / result->encodeSeconds;
+	double decodeFPS = frames / result->decodeSeconds;
+
+	fprintf(file, ",\n      \"sample_bytes\": %llu, \"bits_per_pixel\": %.3f, \"bitrate_mbps\": %.3f",
+			(unsigned long long)result->sampleSize,
+			(double)result->sampleSize * 8.0 / ((double)size->width * size->height),
+			(double)result->sampleSize * 8.0 * options->frameRate / 1.0e6);
+
+	fprintf(file, ",\n      \"encode\": {\"fps\": %.3f, \"mb_per_sec\": %.3f, ",
+			encodeFPS, (double)result->inputSize * encodeFPS / 1.0e6);
+	WriteStages(file, &result->encodeStats, frames);
+	fprintf(file, ", \"allocations\": %llu}", (unsigned long long)result->encodeStats.allocations);
+
+	if (result->poolSeconds > 0.0)
+	{
+		double poolFPS = frames / result->poolSeconds;
+		fprintf(file, ",\n      \"encode_pool\": {\"fps\": %.3f, \"mb_per_sec\": %.3f}",
+				poolFPS, (double)result->inputSize * poolFPS / 1.0e6);
+	}
+
+	fprintf(file, ",\n      \"decode\": {\"width\": %d, \"height\": %d, \"fps\": %.3f, \"mb_per_sec\": %.3f, ",
+			result->decodedWidth, result->decodedHeight, decodeFPS, (double)result->outputSize * decodeFPS / 1.0e6);
+	WriteStages(file, &result->decodeStats, frames);
+	fprintf(file, ", \"allocations\": %llu}", (unsigned long long)result->decodeStats.allocations);
+
+	fprintf(file, ",\n      \"peak_rss_kb\": %llu}", (unsigned long long)PeakResidentKilobytes());
+}
+
+int main(int argc, char **argv)
+{
+	BENCH_OPTIONS options;
+	FILE *file = stdout;
+	bool first = true;
+	int failures = 0;
+
+	SetDefaultOptions(&options);
+
+	if (!ParseOptions(argc, argv, &options))
+	{
+		Usage(argv[0]);
+		return 1;
+	}
+
+	if (options.outputName)
+	{
+		file = fopen(options.outputName, "w");
+		if (file == NULL) {
+			fprintf(stderr, "could not create %s\n", options.outputName);
+			return 1;
+		}
+	}
+
+	fprintf(file, "{\n  \"frames\": %d,\n  \"frame_rate\": %.3f,\n  \"cpus\": %u,\n  \"results\": [\n",
+			options.frames, options.frameRate, std::thread::hardware_concurrency());
+
+	for (size_t s = 0; s < options.sizes.size(); s++)
+	for (size_t p = 0; p < options.pixelFormats.size(); p++)
+	for (size_t e = 0; e < options.encodedFormats.size(); e++)
+	{
+		const BENCH_SIZE *size = &options.sizes[s];
+		CFHD_PixelFormat pixelFormat = options.pixelFormats[p];
+		int encodedFormat = options.encodedFormats[e];
+		CFHD_PixelFormat inputFormat = pixelFormat;
+		int encodedWidth = size->width;
+		int encodedHeight = size->height;
+		std::vector<uint8_t> frame;
+		int framePitch = 0;
+
+		if (!SupportedCombination(pixelFormat, encodedFormat))
+		{
+			fprintf(stderr, "skipping %c%c%c%c encoded as %s\n",
+					PRINTF_PIXELFORMAT(pixelFormat), FindName(EncodedFormatNames, encodedFormat));
+			continue;
+		}
+
+		// The Bayer channels are half the sensor dimensions
+		if (encodedFormat == CFHD_ENCODED_FORMAT_BAYER)
+		{
+			inputFormat = CFHD_PIXEL_FORMAT_BYR4;
+			encodedWidth = size->width / 2;
+			encodedHeight = size->height / 2;
+		}
+
+		RenderSource(frame, pixelFormat, encodedFormat, size->width, size->height, &framePitch);
+
+		for (size_t q = 0; q < options.qualities.size(); q++)
+		for (size_t t = 0; t < options.threads.size(); t++)
+		{
+			int quality = options.qualities[q];
+			int threads = options.threads[t];
+			std::vector<uint8_t> sample;
+			BENCH_RESULT result;
+			CFHD_Error error;
+
+			memset(&result, 0, sizeof(result));
+			result.inputSize = (size_t)framePitch * size->height;
+
+			fprintf(stderr, "%dx%d %c%c%c%c %s %s threads %d\n", size->width, size->height,
+					PRINTF_PIXELFORMAT(pixelFormat), FindName(EncodedFormatNames, encodedFormat),
+					FindName(QualityNames, quality), threads);
+
+			error = EncodeFrames(&options, frame, framePitch, inputFormat, encodedFormat, quality,
+								 encodedWidth, encodedHeight, sample, &result);
+
+			if (error == CFHD_ERROR_OKAY && threads > 1) {
+				error = EncodeFramesPool(&options, frame, framePitch, inputFormat, encodedFormat, quality,
+										 encodedWidth, encodedHeight, threads, &result);
+			}
+
+			// Every decoded resolution is decoded from the same sample
+			for (size_t r = 0; r < options.resolutions.size(); r++)
+			{
+				int resolution = options.resolutions[r];
+				CFHD_Error decodeError = error;
+
+				if (decodeError == CFHD_ERROR_OKAY) {
+					decodeError = DecodeFrames(&options, sample, pixelFormat, resolution, threads, &result);
+				}
+				if (decodeError != CFHD_ERROR_OKAY) {
+					failures++;
+				}
+
+				WriteResult(file, &options, first, pixelFormat, encodedFormat, quality, size,
+							resolution, threads, decodeError, &result);
+				first = false;
+				fflush(file);
+			}
+		}
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+
+	if (file != stdout) {
+		fclose(file);
+	}
+
+	return (failures > 0) ? 2 : 0;
+}
@@ -37,12 +37,15 @@
 #endif
 
 #include "mp4reader.h"
+#include "prefetch.h"
+#include "mp4writer.h"
 
 #define QBIST_SEED				50
 #define ENABLE_3D				0		//2D or 3D-stereoscope encodign
 
 #define QBIST_UNIQUE			1  //slower, but each frame get unique art to encode
 #define OUTPUT_CFHD				0
+#define OUTPUT_MOV				0		//write the samples from the encoder pool into a MOV for each pixel format
 #define DO_DECODE				1
 
 #define OUTPUT_3D_TYPE			STEREO3D_TYPE_DEFAULT	
@@ -394,12 +397,12 @@ CFHD_Error DecodeFrame(void **frameDecBuffer,
 		size_t retHeight = 0;
 		size_t retSize = 0;
 
-		error = CFHD_GetThumbnail(decoderRef,  // This only returns a DPX0 10-bit RGB thumbnail
+		error = CFHD_GetThumbnail(decoderRef,  // Returns a DPX0 10-bit RGB thumbnail
 			sampleBuffer,
 			sampleSize,
 			*frameDecBuffer,
 			allocSize,
-			CFHD_PIXEL_FORMAT_DPX0, // TODO: make this output other pixelformats
+			CFHD_PIXEL_FORMAT_DPX0, // or any pixel format supported by the pixel converter
 			&retWidth,
 			&retHeight,
 			&retSize);
@@ -438,8 +441,24 @@ CFHD_Error DecodeFrame(void **frameDecBuffer,
 }
 
 
+// Use the sample read ahead by the prefetcher or the sample in the mapped file, otherwise read the sample into the buffer
+static void *ReadSample(void *handle, void *prefetch, uint32_t **buffer, uint32_t index, uint32_t *size)
+{
+	const uint8_t *sample;
+
+	if (prefetch) return (void *)GetPrefetchedPayload(prefetch, index, size);
+
+	sample = GetPayloadPointer(handle, index, size);
+	if (sample) return (void *)sample;
+
+	*size = GetPayloadSize(handle, index);
+	*buffer = GetPayload(handle, *buffer, index);
+	return (void *)*buffer;
+}
+
+
 // Decode a series of CineForm frames from an MOV or MP4 sequence
-CFHD_Error DecodeMOVIE(char *filename, char *ext)
+CFHD_Error DecodeMOVIE(char *filename, char *ext, int readahead)
 {
 	CFHD_Error error = CFHD_ERROR_OKAY;
 	CFHD_DecoderRef decoderRef = NULL;
@@ -447,6 +466,8 @@ CFHD_Error DecodeMOVIE(char *filename, char *ext)
 	int resmode = 0, decmode = 0, dec_us = 0;
 	double dec_tot_us = 0;
 	uint32_t *payload = NULL; //buffer to store samples from the MP4.
+	void *sample = NULL; //sample in the mapped file or in the payload buffer
+	void *prefetch = NULL; //reads the samples ahead of the decoder
 	void *frameDecBuffer = NULL;
 	uint32_t AVI = 0;
 	float length;
@@ -463,6 +484,12 @@ CFHD_Error DecodeMOVIE(char *filename, char *ext)
 	else
 		handle = OpenMP4Source(filename, MOV_TRAK_TYPE, MOV_TRAK_SUBTYPE);
 
+	// Read the samples on I/O threads while decoding (for network storage), or use the samples in place if the file can be mapped into memory
+	if (readahead)
+		prefetch = OpenPrefetchSource(handle, 0, 0, 0);
+	else
+		MapSource(handle, 0, 0);
+
 	length = GetDuration(handle);
 
 	if (length > 0.0)
@@ -492,10 +519,9 @@ CFHD_Error DecodeMOVIE(char *filename, char *ext)
 				uint32_t payloadsize;
 				CFHD_PixelFormat pixelFormat = TestDecodeOnlyPixelFormat[decmode];
 
-				payloadsize = GetPayloadSize(handle, frame);
-				payload = GetPayload(handle, payload, frame);
+				sample = ReadSample(handle, prefetch, &payload, frame, &payloadsize);
 
-				if (payload == NULL)
+				if (sample == NULL)
 				{
 					error = CFHD_ERROR_OUTOFMEMORY;
 					goto cleanup;
@@ -517,7 +543,8 @@ CFHD_Error DecodeMOVIE(char *filename, char *ext)
 				sprintf(outputname, "%s-%s-%c%c%c%c-%04d.ppm", filename, restxt, (pixelFormat >> 24) & 0xff, (pixelFormat >> 16) & 0xff, (pixelFormat >> 8) & 0xff, (pixelFormat >> 0) & 0xff, frame);
 #endif
 
-				error = DecodeFrame(&frameDecBuffer, decoderRef, metadataDecRef, payload, (int)payloadsize, CFHD_ENCODED_FORMAT_UNKNOWN, pixelFormat, decode_res, outputname, &dec_us);
+				error = DecodeFrame(&frameDecBuffer, decoderRef, metadataDecRef, sample, (int)payloadsize, CFHD_ENCODED_FORMAT_UNKNOWN, pixelFormat, decode_res, outputname, &dec_us);
+				if (prefetch) ReleasePrefetchedPayload(prefetch, sample);
 				if (error)
 					goto cleanup;
 
@@ -559,6 +586,7 @@ cleanup:
 	if (decoderRef) CFHD_CloseDecoder(decoderRef);
 	if (metadataDecRef) CFHD_CloseMetadata(metadataDecRef);
 	
+	if (prefetch) ClosePrefetchSource(prefetch);
 	CloseSource(handle);
 
 	return error;
@@ -780,6 +808,246 @@ cleanup:
 }
 
 
+// Create half resolution proxies of the CineForm frames in an MOV, MP4 or AVI sequence
+CFHD_Error ProxyMOVIE(char *filename, char *ext)
+{
+	CFHD_Error error = CFHD_ERROR_OKAY;
+	CFHD_DecoderRef decoderRef = NULL;
+	uint32_t *payload = NULL; //buffer to store samples from the MP4.
+	void *sample = NULL; //sample in the mapped file or in the payload buffer
+	uint8_t *proxyBuffer = NULL;
+	size_t proxyBufferSize = 0;
+	double total_us = 0;
+	double total_in = 0, total_out = 0;
+	uint32_t AVI = 0;
+	float length;
+	void *handle;
+
+#ifdef _WIN32
+	if (0 == stricmp("AVI", ext))  AVI = 1;
+#else
+	if (0 == strcasecmp("AVI", ext))  AVI = 1;
+#endif
+
+	if (AVI)
+		handle = OpenAVISource(filename, AVI_TRAK_TYPE, AVI_TRAK_SUBTYPE);
+	else
+		handle = OpenMP4Source(filename, MOV_TRAK_TYPE, MOV_TRAK_SUBTYPE);
+
+	// Use the samples in place if the file can be mapped into memory
+	MapSource(handle, 0, 0);
+
+	length = GetDuration(handle);
+
+	if (length > 0.0)
+	{
+		int frame;
+		uint32_t numframes = GetNumberPayloads(handle);
+
+		printf("found %.2fs of video (%d frames) within %s\n", length, numframes, filename);
+
+		if (numframes > MAX_DEC_FRAMES)
+			numframes = MAX_DEC_FRAMES;
+
+		error = CFHD_OpenDecoder(&decoderRef, NULL);
+		if (error) goto cleanup;
+
+		for (frame = 0; frame < (int)numframes; frame++)
+		{
+			char outputname[250] = "";
+			uint32_t payloadsize;
+			size_t proxysize = 0;
+			double uptime;
+
+			sample = ReadSample(handle, NULL, &payload, frame, &payloadsize);
+
+			if (sample == NULL)
+			{
+				error = CFHD_ERROR_OUTOFMEMORY;
+				goto cleanup;
+			}
+
+			// The proxy is never larger than the original sample
+			if (proxyBufferSize < payloadsize)
+			{
+				if (proxyBuffer) free(proxyBuffer);
+				proxyBufferSize = payloadsize;
+				proxyBuffer = (uint8_t *)malloc(proxyBufferSize);
+				if (proxyBuffer == NULL)
+				{
+					error = CFHD_ERROR_OUTOFMEMORY;
+					goto cleanup;
+				}
+			}
+
+			uptime = gettime();
+			error = CFHD_GetProxySample(decoderRef, sample, payloadsize, CFHD_DECODED_RESOLUTION_HALF,
+										proxyBuffer, proxyBufferSize, &proxysize);
+			if (error) goto cleanup;
+			total_us += (gettime() - uptime)*1000000.0;
+
+			total_in += (double)payloadsize;
+			total_out += (double)proxysize;
+
+#ifdef _WIN32
+			sprintf_s(outputname, sizeof(outputname), "%s-PRXY-%04d.cfhd", filename, frame);
+#else
+			sprintf(outputname, "%s-PRXY-%04d.cfhd", filename, frame);
+#endif
+			{
+				FILE *fp = fopen(outputname, "wb");
+				if (fp)
+				{
+					fwrite(proxyBuffer, 1, proxysize, fp);
+					fclose(fp);
+				}
+			}
+
+			printf(".");
+		}
+
+		if (numframes > 0)
+		{
+			printf("\nAvg Proxy time %.3fms, size %.1f%% of the original\n",
+				(total_us / (double)numframes) / 1000.0, total_out * 100.0 / total_in);
+		}
+	}
+
+
+cleanup:
+	if (payload) FreePayload(payload); payload = NULL;
+	if (proxyBuffer) free(proxyBuffer); proxyBuffer = NULL;
+
+	if (decoderRef) CFHD_CloseDecoder(decoderRef);
+
+	CloseSource(handle);
+
+	return error;
+}
+
+
+CFHD_Error ValidateMOVIE(char *filename, char *ext)
+{
+	CFHD_Error error = CFHD_ERROR_OKAY;
+	CFHD_DecoderRef decoderRef = NULL;
+	uint32_t *payload = NULL; //buffer to store samples from the MP4.
+	void *sample = NULL; //sample in the mapped file or in the payload buffer
+	char crcname[260] = "";
+	FILE *crcfile = NULL;
+	int checkcrc = 0;
+	double total_bytes = 0;
+	double total_us = 0;
+	uint32_t AVI = 0;
+	float length;
+	void *handle;
+
+#ifdef _WIN32
+	if (0 == stricmp("AVI", ext))  AVI = 1;
+#else
+	if (0 == strcasecmp("AVI", ext))  AVI = 1;
+#endif
+
+	if (AVI)
+		handle = OpenAVISource(filename, AVI_TRAK_TYPE, AVI_TRAK_SUBTYPE);
+	else
+		handle = OpenMP4Source(filename, MOV_TRAK_TYPE, MOV_TRAK_SUBTYPE);
+
+	// Use the samples in place if the file can be mapped into memory
+	MapSource(handle, 0, 0);
+
+	length = GetDuration(handle);
+
+	if (length > 0.0)
+	{
+		int frame;
+		int corrupt = 0;
+		uint32_t numframes = GetNumberPayloads(handle);
+
+		printf("found %.2fs of video (%d frames) within %s\n", length, numframes, filename);
+
+		// Check the samples against the CRCs from a previous run or record the CRCs for the next run
+#ifdef _WIN32
+		sprintf_s(crcname, sizeof(crcname), "%s.crc", filename);
+#else
+		sprintf(crcname, "%s.crc", filename);
+#endif
+		crcfile = fopen(crcname, "r");
+		if (crcfile)
+			checkcrc = 1;
+		else
+			crcfile = fopen(crcname, "w");
+
+		error = CFHD_OpenDecoder(&decoderRef, NULL);
+		if (error) goto cleanup;
+
+		for (frame = 0; frame < (int)numframes; frame++)
+		{
+			CFHD_ValidateFlags flags = CFHD_VALIDATE_FLAGS_NONE;
+			uint32_t payloadsize;
+			uint32_t crc = 0;
+			double uptime;
+			CFHD_Error result;
+
+			sample = ReadSample(handle, NULL, &payload, frame, &payloadsize);
+
+			if (sample == NULL)
+			{
+				error = CFHD_ERROR_OUTOFMEMORY;
+				goto cleanup;
+			}
+
+			if (crcfile)
+			{
+				if (checkcrc && fscanf(crcfile, "%x", &crc) == 1)
+					flags = CFHD_VALIDATE_FLAGS_CHECK_CRC;
+				else if (!checkcrc)
+					flags = CFHD_VALIDATE_FLAGS_COMPUTE_CRC;
+			}
+
+			uptime = gettime();
+			result = CFHD_ValidateSample(decoderRef, sample, payloadsize, flags, &crc);
+			total_us += (gettime() - uptime)*1000000.0;
+			total_bytes += (double)payloadsize;
+
+			if (result == CFHD_ERROR_OKAY)
+			{
+				if (crcfile && !checkcrc)
+					fprintf(crcfile, "%08x\n", crc);
+			}
+			else
+			{
+				printf("frame %d: %s\n", frame, (result == CFHD_ERROR_BAD_CRC) ? "bad CRC" : "corrupt sample");
+				corrupt++;
+
+				// Keep the CRC file in step with the frames
+				if (crcfile && !checkcrc)
+					fprintf(crcfile, "%08x\n", 0);
+			}
+		}
+
+		printf("%d frames valid, %d corrupt", numframes - corrupt, corrupt);
+		if (crcfile)
+			printf(", CRCs %s %s", checkcrc ? "checked against" : "written to", crcname);
+		if (total_us > 0)
+			printf(", %.0f MB/s", total_bytes / total_us);
+		printf("\n");
+
+		if (corrupt) error = CFHD_ERROR_BADSAMPLE;
+	}
+
+
+cleanup:
+	if (payload) FreePayload(payload); payload = NULL;
+	if (crcfile) fclose(crcfile); crcfile = NULL;
+
+	if (decoderRef) CFHD_CloseDecoder(decoderRef);
+
+	CloseSource(handle);
+
+	return error;
+}
+
+
 CFHD_Error EncodeSpeedTest()
 {
 	int frmt = 0;
@@ -805,6 +1073,9 @@ CFHD_Error EncodeSpeedTest()
 	double tottime2;
 	int queuedFrames = 0;
 	int unique_frame = 0;
+#if OUTPUT_MOV
+	void *movieRef = NULL;
+#endif
 	
 	do
 	{
@@ -902,6 +1173,17 @@ CFHD_Error EncodeSpeedTest()
 				// Start the encoders in the pool of asynchronous encoders
 				CFHD_StartEncoderPool(encoderPoolRef);
 
+#if OUTPUT_MOV
+				{
+					char name[40];
+					sprintf(name, "%s-%c%c%c%c.mov", BASENAME_OUT, PRINTF_PIXELFORMAT(pixelFormat));
+					movieRef = OpenMP4Writer(name, frameWidth, frameHeight, alpha ? 32 : 24, 24, 1);
+
+					// Reserve space for the index before the samples so the movie can be played while it is copied
+					SetMP4WriterOptions(movieRef, MAX_ENC_FRAMES, 0, 0);
+				}
+#endif
+
 				// Generate a source image
 				framePitch = frameWidth * channels *(bitDepth / 8);
 				RunQBist(frameWidth, frameHeight, framePitch, pixelFormat, alpha, (unsigned char *)frameBuffer);
@@ -980,6 +1262,9 @@ CFHD_Error EncodeSpeedTest()
 					size_t sampleSize;
 					error = CFHD_GetEncodedSample(sampleBufferRef, (void **)&sampleBuffer, &sampleSize);
 					if (error) goto cleanup;
+#if OUTPUT_MOV
+					if (movieRef) WriteMP4Sample(movieRef, sampleBuffer, (uint32_t)sampleSize);
+#endif
 					printf(".");
 					if (((frame_number - 1) & 63) == 63) printf("\n");
 
@@ -1004,6 +1289,9 @@ CFHD_Error EncodeSpeedTest()
 						size_t sampleSize;
 						error = CFHD_GetEncodedSample(sampleBufferRef, (void **)&sampleBuffer, &sampleSize);
 						if (error) goto cleanup;
+#if OUTPUT_MOV
+						if (movieRef) WriteMP4Sample(movieRef, sampleBuffer, (uint32_t)sampleSize);
+#endif
 
 						printf(".");
 						if (((frame_number - 1) & 63) == 63) printf("\n");
@@ -1026,6 +1314,11 @@ CFHD_Error EncodeSpeedTest()
 		CFHD_ReleaseEncoderPool(encoderPoolRef);
 		encoderPoolRef = NULL;
 
+#if OUTPUT_MOV
+		if (movieRef) CloseMP4Writer(movieRef);
+		movieRef = NULL;
+#endif
+
 		frmt++;
 		printf("\n");
 
@@ -1042,6 +1335,9 @@ cleanup:
 	}
 
 	if (encoderPoolRef) CFHD_CloseEncoder(encoderPoolRef);
+#if OUTPUT_MOV
+	if (movieRef) CloseMP4Writer(movieRef);
+#endif
 
 	return error;
 }
@@ -1362,6 +1658,48 @@ int main(int argc, char **argv)
 
 			error = FuzzMOVIE(&argv[1][2], ext);
 		}
+		else if (argv[1][1] == 'p' || argv[1][1] == 'P')
+		{
+			char ext[4] = "";
+			int len = (int)strlen(argv[1]);
+			if (len > 6)
+			{
+				ext[0] = argv[1][len - 3];
+				ext[1] = argv[1][len - 2];
+				ext[2] = argv[1][len - 1];
+				ext[3] = 0;
+			}
+
+			error = ProxyMOVIE(&argv[1][2], ext);
+		}
+		else if (argv[1][1] == 'v' || argv[1][1] == 'V')
+		{
+			char ext[4] = "";
+			int len = (int)strlen(argv[1]);
+			if (len > 6)
+			{
+				ext[0] = argv[1][len - 3];
+				ext[1] = argv[1][len - 2];
+				ext[2] = argv[1][len - 1];
+				ext[3] = 0;
+			}
+
+			error = ValidateMOVIE(&argv[1][2], ext);
+		}
+		else if (argv[1][1] == 'r' || argv[1][1] == 'R')
+		{
+			char ext[4] = "";
+			int len = (int)strlen(argv[1]);
+			if (len > 4)
+			{
+				ext[0] = argv[1][len - 3];
+				ext[1] = argv[1][len - 2];
+				ext[2] = argv[1][len - 1];
+				ext[3] = 0;
+			}
+
+			error = DecodeMOVIE(&argv[1][2], ext, 1);
+		}
 		else
 			showusage = 1;
 	}
@@ -1377,7 +1715,7 @@ int main(int argc, char **argv)
 			ext[3] = 0;
 		}
 
-		error = DecodeMOVIE(argv[1], ext);
+		error = DecodeMOVIE(argv[1], ext, 0);
 	}
 
 	if (showusage)
@@ -1386,6 +1724,9 @@ int main(int argc, char **argv)
 		printf("          -D ... decoder tester\n");
 		printf("          -E ... encoder tester\n");
 		printf("          -Ffilename.MOV|MP4|AVI ... crude decode fuzzer\n");
+		printf("          -Pfilename.MOV|MP4|AVI ... half resolution proxies without decoding\n");
+		printf("          -Rfilename.MOV|MP4|AVI ... decode with the samples read ahead on I/O threads\n");
+		printf("          -Vfilename.MOV|MP4|AVI ... validate every sample (CRCs checked against filename.crc)\n");
 	}
 
 	if (error) printf("error code: %d\n", error);
@@ -0,0 +1,1038 @@
+/*! @file transcode.cpp
+
+*  @brief Transcode a CineForm movie with a pipeline of read, decode, scale, encode and write stages
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+/*
+	The stages run at the same time on their own threads:
+
+	  read     one thread reads the samples ahead of the decoders with the prefetcher
+	  decode   a set of decoders, each limited to one thread, decodes whole frames in parallel
+	  scale    a set of workers scales the decoded frames with the ConvertLib scalers
+	  encode   one thread submits the frames in order to the asynchronous encoder pool
+	  write    one thread waits for the encoded samples and appends them to the output movie
+
+	The frames are passed between the stages in queues.  A fixed number of frame
+	buffers circulate through the pipeline and the reader waits for the writer
+	to return a buffer when every buffer is in use, so a slow stage holds back
+	the reader instead of filling memory with frames, and the memory used does
+	not depend on the length of the movie.
+
+	The frames are decoded directly into the pixel format used by the encoder
+	(RG48, b64a for 4:4:4:4 or YU64 for 4:2:2 that is not scaled) at the
+	smallest decoded resolution that is not smaller than the output size, so
+	the scale stage only resamples the frames and does nothing if the sizes are
+	the same.
+
+	The decode and scale stages start a thread for every processor but only
+	some of the threads take frames.  Twice a second the tuner compares the
+	throughput of each thread in the two stages with the rate at which the
+	encoder pool delivers samples: a stage whose threads are always busy and
+	that has frames waiting is given another thread, and a stage that would
+	keep up with one thread fewer gives a thread up, so that the processors are
+	left to the encoders when they are the bottleneck.  The encoder pool cannot
+	be resized after it has started, so the number of encoders is fixed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <emmintrin.h>		// _mm_malloc
+
+#ifdef __APPLE__
+#include <sys/time.h>
+#endif
+
+#include "CFHDDecoder.h"
+#include "CFHDEncoder.h"
+#include "CFHDMetadata.h"
+
+// The ConvertLib headers use the assert macro defined by each module
+#ifndef ASSERT
+#define ASSERT(x)	assert(x)
+#endif
+
+#include "ConvertLib.h"
+
+#include "mp4reader.h"
+#include "mp4writer.h"
+#include "prefetch.h"
+
+#define TRANSCODE_DEFAULT_QUEUE		16			// Frames in flight between the reader and the writer
+#define TRANSCODE_TIMESCALE			240000		// Exact durations for 23.976, 24, 25, 29.97, 30, 50, 59.94 and 60 fps
+#define TRANSCODE_DEFAULT_DURATION	10000		// 24 fps if the source does not have a frame rate
+#define TRANSCODE_TUNE_INTERVAL		0.5			// Seconds between adjustments of the stage threads
+#define TRANSCODE_BUSY_THRESHOLD	0.9			// Utilization above which a stage with waiting frames gets another thread
+#define TRANSCODE_SPARE_RATIO		1.2			// Margin over the output rate that a stage must keep with one thread fewer
+
+#define PRINTF_PIXELFORMAT(k)	((k) >> 24) & 0xff, ((k) >> 16) & 0xff, ((k) >> 8) & 0xff, ((k) >> 0) & 0xff
+
+typedef struct
+{
+	const char *name;
+	int value;
+
+} TRANSCODE_NAME;
+
+static const TRANSCODE_NAME EncodedFormatNames[] =
+{
+	{"422",		CFHD_ENCODED_FORMAT_YUV_422},
+	{"444",		CFHD_ENCODED_FORMAT_RGB_444},
+	{"4444",	CFHD_ENCODED_FORMAT_RGBA_4444},
+	{NULL, 0}
+};
+
+static const TRANSCODE_NAME QualityNames[] =
+{
+	{"low",			CFHD_ENCODING_QUALITY_LOW},
+	{"medium",		CFHD_ENCODING_QUALITY_MEDIUM},
+	{"high",		CFHD_ENCODING_QUALITY_HIGH},
+	{"filmscan1",	CFHD_ENCODING_QUALITY_FILMSCAN1},
+	{"filmscan2",	CFHD_ENCODING_QUALITY_FILMSCAN2},
+	{"filmscan3",	CFHD_ENCODING_QUALITY_FILMSCAN3},
+	{NULL, 0}
+};
+
+typedef struct
+{
+	const char *inputName;
+	const char *outputName;
+	int width;					// Output dimensions (zero for the source dimensions)
+	int height;
+	int encodedFormat;			// Encoded format of the output (-1 for the encoded format of the source)
+	int quality;
+	int encoders;				// Encoders in the pool
+	int threads;				// Maximum threads in the decode and scale stages
+	int queue;					// Frames in flight
+	int frames;					// Maximum frames to transcode (zero for all frames)
+	bool verbose;				// Print the stage threads after every adjustment
+
+} TRANSCODE_OPTIONS;
+
+// Frame buffer that is passed from stage to stage
+typedef struct
+{
+	uint32_t index;					// Sample number in the source and output movies
+	std::vector<uint8_t> sample;	// Copy of the source sample
+	uint8_t *decoded;				// Frame decoded in the encoder input format
+	uint8_t *scaled;				// Frame scaled to the output size (NULL if the decoded frame is encoded)
+
+} TRANSCODE_FRAME;
+
+// Dimensions and formats shared by the stages
+typedef struct
+{
+	int encodedFormat;
+	CFHD_PixelFormat pixelFormat;		// Decoded and encoded pixel format
+	CFHD_DecodedResolution resolution;
+	int decodedWidth;
+	int decodedHeight;
+	int32_t decodedPitch;
+	int outputWidth;
+	int outputHeight;
+	int32_t outputPitch;
+
+} TRANSCODE_FORMAT;
+
+
+double gettime(void)
+{
+#ifdef __APPLE__
+	timeval ts;
+	gettimeofday(&ts, NULL);
+	return (double)ts.tv_sec + (double)ts.tv_usec / 1000000.0;
+#elif _WIN32
+	LARGE_INTEGER precision, ts;
+	::QueryPerformanceCounter(&ts);
+	::QueryPerformanceFrequency(&precision);
+	return static_cast<double>(ts.QuadPart)/static_cast<double>(precision.QuadPart);
+#else
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+// Queue of frames between two stages (the queues never hold more frames than there are buffers)
+class FrameQueue
+{
+public:
+	FrameQueue() : closed(false), discarded(false) {}
+
+	void Push(TRANSCODE_FRAME *frame)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		frames.push_back(frame);
+		ready.notify_one();
+	}
+
+	// Wait for the next frame (returns NULL when the queue has been closed and is empty)
+	TRANSCODE_FRAME *Pop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		ready.wait(lock, [this] { return !frames.empty() || closed; });
+		if (discarded || frames.empty()) {
+			return NULL;
+		}
+		TRANSCODE_FRAME *frame = frames.front();
+		frames.pop_front();
+		return frame;
+	}
+
+	// No more frames will be added (the frames in the queue are returned unless they are discarded)
+	void Close(bool discard = false)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		discarded = discarded || discard;
+		ready.notify_all();
+	}
+
+	bool Closed()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return closed;
+	}
+
+	size_t Size()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return frames.size();
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::deque<TRANSCODE_FRAME *> frames;
+	bool closed;
+	bool discarded;
+};
+
+// Counters for one stage and the threads that are allowed to take frames
+class Stage
+{
+public:
+	Stage(const char *name, int threads, int active) :
+		name(name), threads(threads), frames(0), busy(0), stall(0),
+		active(active), peak(active), running(threads) {}
+
+	// Wait until the worker is allowed to take frames or there are no more frames
+	void WaitForTurn(int worker, FrameQueue *input)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		// Closing the input queue does not signal the gate so the parked workers check the queue periodically
+		while (worker >= active && !input->Closed()) {
+			gate.wait_for(lock, std::chrono::milliseconds(100));
+		}
+	}
+
+	void SetActive(int count)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		active = count;
+		if (peak < active) peak = active;
+		gate.notify_all();
+	}
+
+	int Active()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return active;
+	}
+
+	int Peak()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return peak;
+	}
+
+	// Record the time spent on one frame and the time spent waiting before the frame was available
+	void Count(double busySeconds, double stallSeconds)
+	{
+		frames++;
+		busy += (uint64_t)(busySeconds * 1.0e6);
+		stall += (uint64_t)(stallSeconds * 1.0e6);
+	}
+
+	// Returns true for the last worker to finish
+	bool Finish()
+	{
+		return (--running == 0);
+	}
+
+	bool Running()
+	{
+		return (running > 0);
+	}
+
+	const char *name;
+	const int threads;						// Threads started for the stage
+	std::atomic<uint64_t> frames;
+	std::atomic<uint64_t> busy;				// Microseconds spent processing frames
+	std::atomic<uint64_t> stall;			// Microseconds spent waiting for frames
+
+private:
+	std::mutex mutex;
+	std::condition_variable gate;
+	int active;								// Threads allowed to take frames
+	int peak;
+	std::atomic<int> running;
+};
+
+// Scale frames on the calling thread with the ConvertLib scalers
+class FrameScaler
+{
+public:
+	FrameScaler() : rgb(&allocator), rgba(&allocator)
+	{
+		// Each scaler and its base class have a thread pool that is created on the first call
+		rgb.mailbox.cpus = 1;
+		rgb.CImageScalerRG48::mailbox.cpus = 1;
+		rgba.mailbox.cpus = 1;
+		rgba.CImageScalerB64A::mailbox.cpus = 1;
+	}
+
+	void Scale(const TRANSCODE_FORMAT *format, uint8_t *input, uint8_t *output)
+	{
+		if (format->pixelFormat == CFHD_PIXEL_FORMAT_RG48)
+		{
+			rgb.ScaleToRG48(input, format->decodedWidth, format->decodedHeight, format->decodedPitch,
+							output, format->outputWidth, format->outputHeight, format->outputPitch, 0);
+			return;
+		}
+
+		rgba.ScaleToB64A(input, format->decodedWidth, format->decodedHeight, format->decodedPitch,
+						 output, format->outputWidth, format->outputHeight, format->outputPitch, 0);
+#ifndef _WIN32
+		// The scaler swaps the bytes of the b64a pixels except on Windows
+		for (int row = 0; row < format->outputHeight; row++)
+		{
+			uint16_t *pixels = (uint16_t *)(output + (size_t)row * format->outputPitch);
+			for (int i = 0; i < format->outputWidth * 4; i++) {
+				pixels[i] = (uint16_t)((pixels[i] << 8) | (pixels[i] >> 8));
+			}
+		}
+#endif
+	}
+
+private:
+	CMemAlloc allocator;
+	CImageScalerConverterRG48 rgb;
+	CImageScalerConverterB64A rgba;
+};
+
+typedef struct
+{
+	const TRANSCODE_OPTIONS *options;
+	TRANSCODE_FORMAT format;
+	void *source;
+	void *prefetch;
+	void *movie;
+	CFHD_EncoderPoolRef encoderPoolRef;
+	uint32_t frameCount;
+
+	std::vector<TRANSCODE_FRAME> buffers;
+	FrameQueue freeQueue;			// Buffers returned by the writer
+	FrameQueue decodeQueue;			// Samples read from the source
+	FrameQueue scaleQueue;			// Decoded frames
+	FrameQueue encodeQueue;			// Scaled frames in any order
+	FrameQueue writeQueue;			// Frames submitted to the encoder pool in order
+
+	Stage *read;
+	Stage *decode;
+	Stage *scale;
+	Stage *encode;
+	Stage *write;
+
+	std::atomic<bool> failed;
+
+} TRANSCODE_PIPELINE;
+
+
+static const char *FindName(const TRANSCODE_NAME *names, int value)
+{
+	for (; names->name != NULL; names++) {
+		if (names->value == value) return names->name;
+	}
+	return "unknown";
+}
+
+static bool FindValue(const TRANSCODE_NAME *names, const char *name, int *value)
+{
+	for (; names->name != NULL; names++)
+	{
+		if (strcmp(names->name, name) == 0) {
+			*value = names->value;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void SetDefaultOptions(TRANSCODE_OPTIONS *options)
+{
+	int cpus = (int)std::thread::hardware_concurrency();
+
+	memset(options, 0, sizeof(*options));
+	options->encodedFormat = -1;
+	options->quality = CFHD_ENCODING_QUALITY_FILMSCAN1;
+	options->encoders = (cpus > 0) ? cpus : 1;
+	options->threads = (cpus > 0) ? cpus : 1;
+	options->queue = TRANSCODE_DEFAULT_QUEUE;
+}
+
+static void Usage(const char *program)
+{
+	printf("usage: %s [options] input.mov output.mov\n", program);
+	printf("          --size=WIDTHxHEIGHT ...... output frame size (default is the source size)\n");
+	printf("          --encoded=422 ............ encoded format (422, 444, 4444; default is the source format)\n");
+	printf("          --quality=filmscan1 ...... low, medium, high, filmscan1, filmscan2, filmscan3\n");
+	printf("          --encoders=N ............. encoders in the pool (default is the number of processors)\n");
+	printf("          --threads=N .............. maximum threads in the decode and scale stages\n");
+	printf("          --queue=%d ............... frames in flight between the reader and the writer\n", TRANSCODE_DEFAULT_QUEUE);
+	printf("          --frames=N ............... transcode the first N frames\n");
+	printf("          --verbose=1 .............. print the stage threads when they are adjusted\n");
+}
+
+static bool ParseOptions(int argc, char **argv, TRANSCODE_OPTIONS *options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		char *arg = argv[i];
+		char *value = strchr(arg, '=');
+		bool okay = true;
+
+		if (strncmp(arg, "--", 2) != 0)
+		{
+			// The input and output movies
+			if (options->inputName == NULL) options->inputName = arg;
+			else if (options->outputName == NULL) options->outputName = arg;
+			else return false;
+			continue;
+		}
+
+		if (value == NULL) {
+			return false;
+		}
+		*value++ = '\0';
+
+		if (strcmp(arg, "--size") == 0) okay = (sscanf(value, "%dx%d", &options->width, &options->height) == 2 &&
+												options->width >= 16 && options->height >= 16);
+		else if (strcmp(arg, "--encoded") == 0) okay = FindValue(EncodedFormatNames, value, &options->encodedFormat);
+		else if (strcmp(arg, "--quality") == 0) okay = FindValue(QualityNames, value, &options->quality);
+		else if (strcmp(arg, "--encoders") == 0) okay = (options->encoders = atoi(value)) > 0;
+		else if (strcmp(arg, "--threads") == 0) okay = (options->threads = atoi(value)) > 0;
+		else if (strcmp(arg, "--queue") == 0) okay = (options->queue = atoi(value)) > 1;
+		else if (strcmp(arg, "--frames") == 0) okay = (options->frames = atoi(value)) > 0;
+		else if (strcmp(arg, "--verbose") == 0) options->verbose = (atoi(value) != 0);
+		else okay = false;
+
+		if (!okay) {
+			return false;
+		}
+	}
+
+	return (options->inputName != NULL && options->outputName != NULL);
+}
+
+static void Fail(TRANSCODE_PIPELINE *pipeline, const char *stage, CFHD_Error error)
+{
+	if (!pipeline->failed.exchange(true)) {
+		fprintf(stderr, "%s failed: %d\n", stage, error);
+	}
+
+	// Stop the stages before the encoder pool (the writer waits for the frames that were submitted)
+	pipeline->freeQueue.Close(true);
+	pipeline->decodeQueue.Close(true);
+	pipeline->scaleQueue.Close(true);
+	pipeline->encodeQueue.Close(true);
+}
+
+static void ReadStage(TRANSCODE_PIPELINE *pipeline)
+{
+	Stage *stage = pipeline->read;
+
+	for (uint32_t index = 0; index < pipeline->frameCount; index++)
+	{
+		double start = gettime();
+		TRANSCODE_FRAME *frame = pipeline->freeQueue.Pop();
+		double ready = gettime();
+		const uint8_t *sample;
+		uint32_t size = 0;
+
+		if (frame == NULL) {
+			break;
+		}
+
+		sample = GetPrefetchedPayload(pipeline->prefetch, index, &size);
+		if (sample == NULL) {
+			Fail(pipeline, stage->name, CFHD_ERROR_READ_FAILURE);
+			break;
+		}
+
+		frame->index = index;
+		frame->sample.assign(sample, sample + size);
+		ReleasePrefetchedPayload(pipeline->prefetch, sample);
+
+		pipeline->decodeQueue.Push(frame);
+		stage->Count(gettime() - ready, ready - start);
+	}
+
+	stage->Finish();
+	pipeline->decodeQueue.Close();
+}
+
+static CFHD_Error OpenFrameDecoder(TRANSCODE_PIPELINE *pipeline, TRANSCODE_FRAME *frame,
+								   CFHD_DecoderRef *decoderRefOut, CFHD_MetadataRef *metadataRefOut)
+{
+	const TRANSCODE_FORMAT *format = &pipeline->format;
+	CFHD_PixelFormat actualFormat = CFHD_PIXEL_FORMAT_UNKNOWN;
+	CFHD_Error error;
+	int actualWidth = 0;
+	int actualHeight = 0;
+	uint32_t maxcpus = 1;
+
+	error = CFHD_OpenDecoder(decoderRefOut, NULL);
+	if (error) return error;
+
+	error = CFHD_OpenMetadata(metadataRefOut);
+	if (error) return error;
+
+	error = CFHD_PrepareToDecode(*decoderRefOut, 0, 0, format->pixelFormat, format->resolution,
+								 CFHD_DECODING_FLAGS_NONE, &frame->sample[0], frame->sample.size(),
+								 &actualWidth, &actualHeight, &actualFormat);
+	if (error) return error;
+
+	if (actualWidth != format->decodedWidth || actualHeight != format->decodedHeight ||
+		actualFormat != format->pixelFormat) {
+		return CFHD_ERROR_BADFORMAT;
+	}
+
+	// The frames are decoded in parallel by the stage instead of by the decoder
+	error = CFHD_InitSampleMetadata(*metadataRefOut, METADATATYPE_ORIGINAL, &frame->sample[0], frame->sample.size());
+	if (error) return error;
+
+	return CFHD_SetActiveMetadata(*decoderRefOut, *metadataRefOut, TAG_CPU_MAX, METADATATYPE_UINT32,
+								  &maxcpus, sizeof(maxcpus));
+}
+
+static void DecodeStage(TRANSCODE_PIPELINE *pipeline, int worker)
+{
+	const TRANSCODE_FORMAT *format = &pipeline->format;
+	Stage *stage = pipeline->decode;
+	CFHD_DecoderRef decoderRef = NULL;
+	CFHD_MetadataRef metadataRef = NULL;
+
+	for (;;)
+	{
+		stage->WaitForTurn(worker, &pipeline->decodeQueue);
+
+		double start = gettime();
+		TRANSCODE_FRAME *frame = pipeline->decodeQueue.Pop();
+		double ready = gettime();
+		CFHD_Error error = CFHD_ERROR_OKAY;
+
+		if (frame == NULL) {
+			break;
+		}
+
+		if (decoderRef == NULL) {
+			error = OpenFrameDecoder(pipeline, frame, &decoderRef, &metadataRef);
+		}
+		if (error == CFHD_ERROR_OKAY) {
+			error = CFHD_DecodeSample(decoderRef, &frame->sample[0], frame->sample.size(),
+									  frame->decoded, format->decodedPitch);
+		}
+		if (error) {
+			Fail(pipeline, stage->name, error);
+			break;
+		}
+
+		pipeline->scaleQueue.Push(frame);
+		stage->Count(gettime() - ready, ready - start);
+	}
+
+	if (decoderRef) CFHD_CloseDecoder(decoderRef);
+	if (metadataRef) CFHD_CloseMetadata(metadataRef);
+
+	if (stage->Finish()) {
+		pipeline->scaleQueue.Close();
+	}
+}
+
+static void ScaleStage(TRANSCODE_PIPELINE *pipeline, int worker)
+{
+	const TRANSCODE_FORMAT *format = &pipeline->format;
+	Stage *stage = pipeline->scale;
+	FrameScaler scaler;
+
+	for (;;)
+	{
+		stage->WaitForTurn(worker, &pipeline->scaleQueue);
+
+		double start = gettime();
+		TRANSCODE_FRAME *frame = pipeline->scaleQueue.Pop();
+		double ready = gettime();
+
+		if (frame == NULL) {
+			break;
+		}
+
+		if (frame->scaled) {
+			scaler.Scale(format, frame->decoded, frame->scaled);
+		}
+
+		pipeline->encodeQueue.Push(frame);
+		stage->Count(gettime() - ready, ready - start);
+	}
+
+	if (stage->Finish()) {
+		pipeline->encodeQueue.Close();
+	}
+}
+
+// Submit the frames to the encoder pool in the order of the source
+static void EncodeStage(TRANSCODE_PIPELINE *pipeline)
+{
+	const TRANSCODE_FORMAT *format = &pipeline->format;
+	Stage *stage = pipeline->encode;
+	std::map<uint32_t, TRANSCODE_FRAME *> pending;
+	uint32_t next = 0;
+	double start = gettime();
+
+	for (;;)
+	{
+		TRANSCODE_FRAME *frame = pipeline->encodeQueue.Pop();
+		if (frame == NULL) {
+			break;
+		}
+		pending[frame->index] = frame;
+
+		while (!pending.empty() && pending.begin()->first == next)
+		{
+			double ready = gettime();
+			CFHD_Error error;
+
+			frame = pending.begin()->second;
+			pending.erase(pending.begin());
+
+			error = CFHD_EncodeAsyncSample(pipeline->encoderPoolRef, frame->index,
+										   frame->scaled ? frame->scaled : frame->decoded,
+										   format->outputPitch, NULL);
+			if (error) {
+				Fail(pipeline, stage->name, error);
+				break;
+			}
+
+			pipeline->writeQueue.Push(frame);
+			stage->Count(gettime() - ready, ready - start);
+			start = gettime();
+			next++;
+		}
+	}
+
+	stage->Finish();
+	pipeline->writeQueue.Close();
+}
+
+static void WriteStage(TRANSCODE_PIPELINE *pipeline)
+{
+	Stage *stage = pipeline->write;
+
+	for (;;)
+	{
+		TRANSCODE_FRAME *frame = pipeline->writeQueue.Pop();
+		CFHD_SampleBufferRef sampleBufferRef = NULL;
+		uint32_t frameNumber = 0;
+		void *sample = NULL;
+		size_t size = 0;
+		double start, ready;
+		CFHD_Error error;
+
+		if (frame == NULL) {
+			break;
+		}
+
+		// The time spent waiting for the encoder pool is the stall time of the stage
+		start = gettime();
+		error = CFHD_WaitForSample(pipeline->encoderPoolRef, &frameNumber, &sampleBufferRef);
+		ready = gettime();
+
+		if (error == CFHD_ERROR_OKAY) {
+			error = CFHD_GetEncodedSample(sampleBufferRef, &sample, &size);
+		}
+		if (error == CFHD_ERROR_OKAY && frameNumber != frame->index) {
+			error = CFHD_ERROR_UNEXPECTED;
+		}
+		if (error == CFHD_ERROR_OKAY && !pipeline->failed &&
+			WriteMP4Sample(pipeline->movie, sample, (uint32_t)size) != 0) {
+			error = CFHD_ERROR_WRITE_FAILURE;
+		}
+		if (sampleBufferRef) {
+			CFHD_ReleaseSampleBuffer(pipeline->encoderPoolRef, sampleBufferRef);
+		}
+		if (error) {
+			Fail(pipeline, stage->name, error);
+		}
+
+		pipeline->freeQueue.Push(frame);
+		stage->Count(gettime() - ready, ready - start);
+	}
+
+	stage->Finish();
+}
+
+// Move threads between the decode and scale stages and the encoders
+static void TuneStage(TRANSCODE_PIPELINE *pipeline, Stage *stage, FrameQueue *input,
+					  uint64_t frames, uint64_t busy, double outputRate, double interval)
+{
+	int active = stage->Active();
+	double utilization = (double)busy / 1.0e6 / (interval * active);	// Frames are counted when they finish
+	if (utilization > 1.0) utilization = 1.0;
+	double threadRate = (busy > 0) ? (double)frames / ((double)busy / 1.0e6) : 0.0;
+
+	if (utilization > TRANSCODE_BUSY_THRESHOLD && input->Size() > 0 && active < stage->threads)
+	{
+		stage->SetActive(active + 1);
+	}
+	else if (active > 1 && outputRate > 0.0 && threadRate > 0.0 &&
+			 (active - 1) * threadRate >= TRANSCODE_SPARE_RATIO * outputRate)
+	{
+		stage->SetActive(active - 1);
+	}
+
+	if (pipeline->options->verbose) {
+		fprintf(stderr, "%-8s threads %2d -> %2d  utilization %5.1f%%  %7.1f fps per thread  queue %u\n",
+				stage->name, active, stage->Active(), 100.0 * utilization, threadRate, (unsigned int)input->Size());
+	}
+}
+
+static void TunePipeline(TRANSCODE_PIPELINE *pipeline, double *lastTime,
+						 uint64_t *lastDecodeFrames, uint64_t *lastDecodeBusy,
+						 uint64_t *lastScaleFrames, uint64_t *lastScaleBusy, uint64_t *lastWriteFrames)
+{
+	double now = gettime();
+	double interval = now - *lastTime;
+	uint64_t decodeFrames = pipeline->decode->frames, decodeBusy = pipeline->decode->busy;
+	uint64_t scaleFrames = pipeline->scale->frames, scaleBusy = pipeline->scale->busy;
+	uint64_t writeFrames = pipeline->write->frames;
+	double outputRate = (double)(writeFrames - *lastWriteFrames) / interval;
+
+	TuneStage(pipeline, pipeline->decode, &pipeline->decodeQueue, decodeFrames - *lastDecodeFrames,
+			  decodeBusy - *lastDecodeBusy, outputRate, interval);
+	TuneStage(pipeline, pipeline->scale, &pipeline->scaleQueue, scaleFrames - *lastScaleFrames,
+			  scaleBusy - *lastScaleBusy, outputRate, interval);
+
+	*lastTime = now;
+	*lastDecodeFrames = decodeFrames;
+	*lastDecodeBusy = decodeBusy;
+	*lastScaleFrames = scaleFrames;
+	*lastScaleBusy = scaleBusy;
+	*lastWriteFrames = writeFrames;
+}
+
+static void PrintReport(TRANSCODE_PIPELINE *pipeline, double seconds)
+{
+	Stage *stages[] = {pipeline->read, pipeline->decode, pipeline->scale, pipeline->encode, pipeline->write};
+
+	printf("%u frames in %.3f seconds, %.2f fps\n", (unsigned int)pipeline->write->frames, seconds,
+		   pipeline->write->frames / seconds);
+	printf("stage    threads  frames   busy (s)  fps/thread  utilization  stall (s)\n");
+
+	for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++)
+	{
+		Stage *stage = stages[i];
+		double busy = (double)stage->busy / 1.0e6;
+		int threads = stage->Peak();
+
+		printf("%-8s %4d/%-3d %6llu %10.3f %11.2f %11.1f%% %10.3f\n",
+			   stage->name, threads, stage->threads, (unsigned long long)stage->frames, busy,
+			   (busy > 0.0) ? stage->frames / busy : 0.0, 100.0 * busy / (seconds * threads),
+			   (double)stage->stall / 1.0e6);
+	}
+
+	printf("encoders %d (the write stage is busy writing and stalls while it waits for the encoders)\n",
+		   pipeline->options->encoders);
+}
+
+// Find the decoded resolution and the pixel formats from the first sample
+static CFHD_Error ChooseFormat(const TRANSCODE_OPTIONS *options, const uint8_t *sample, uint32_t size,
+							   TRANSCODE_FORMAT *format)
+{
+	static const CFHD_DecodedResolution resolutions[] =
+	{
+		CFHD_DECODED_RESOLUTION_QUARTER, CFHD_DECODED_RESOLUTION_HALF, CFHD_DECODED_RESOLUTION_FULL
+	};
+	CFHD_DecoderRef decoderRef = NULL;
+	CFHD_PixelFormat actualFormat;
+	CFHD_Error error;
+	int encodedFormat = CFHD_ENCODED_FORMAT_YUV_422;
+
+	error = CFHD_OpenDecoder(&decoderRef, NULL);
+	if (error) return error;
+
+	if (options->encodedFormat >= 0)
+	{
+		format->encodedFormat = options->encodedFormat;
+	}
+	else
+	{
+		// Bayer sources are encoded as 4:4:4
+		CFHD_GetSampleInfo(decoderRef, (void *)sample, size, CFHD_SAMPLE_ENCODED_FORMAT,
+						   &encodedFormat, sizeof(encodedFormat));
+		format->encodedFormat = (encodedFormat == CFHD_ENCODED_FORMAT_YUV_422 ||
+								 encodedFormat == CFHD_ENCODED_FORMAT_RGBA_4444) ?
+								encodedFormat : CFHD_ENCODED_FORMAT_RGB_444;
+	}
+
+	// Use the smallest decoded resolution that is at least as large as the output
+	for (size_t i = 0; i < sizeof(resolutions) / sizeof(resolutions[0]); i++)
+	{
+		format->resolution = resolutions[i];
+		error = CFHD_PrepareToDecode(decoderRef, 0, 0, CFHD_PIXEL_FORMAT_RG48, format->resolution,
+									 CFHD_DECODING_FLAGS_NONE, (void *)sample, size,
+									 &format->decodedWidth, &format->decodedHeight, &actualFormat);
+		if (error) {
+			continue;
+		}
+		if (options->width > 0 && format->decodedWidth >= options->width && format->decodedHeight >= options->height) {
+			break;
+		}
+	}
+	CFHD_CloseDecoder(decoderRef);
+	if (error) return error;
+
+	format->outputWidth = options->width ? options->width : format->decodedWidth;
+	format->outputHeight = options->height ? options->height : format->decodedHeight;
+
+	// The YU64 scaler filters the chroma even when the size does not change so scaled 4:2:2 frames are RG48
+	if (format->encodedFormat == CFHD_ENCODED_FORMAT_RGBA_4444) {
+		format->pixelFormat = CFHD_PIXEL_FORMAT_B64A;
+	} else if (format->encodedFormat == CFHD_ENCODED_FORMAT_YUV_422 &&
+			   format->decodedWidth == format->outputWidth && format->decodedHeight == format->outputHeight) {
+		format->pixelFormat = CFHD_PIXEL_FORMAT_YU64;
+	} else {
+		format->pixelFormat = CFHD_PIXEL_FORMAT_RG48;
+	}
+
+	error = CFHD_GetImagePitch(format->decodedWidth, format->pixelFormat, &format->decodedPitch);
+	if (error) return error;
+
+	return CFHD_GetImagePitch(format->outputWidth, format->pixelFormat, &format->outputPitch);
+}
+
+static CFHD_Error StartEncoderPool(TRANSCODE_PIPELINE *pipeline)
+{
+	const TRANSCODE_OPTIONS *options = pipeline->options;
+	const TRANSCODE_FORMAT *format = &pipeline->format;
+	CFHD_Error error;
+
+	// The queue holds every frame in flight so that submitting a frame does not wait for the encoders
+	error = CFHD_CreateEncoderPool(&pipeline->encoderPoolRef, options->encoders, options->queue, NULL);
+	if (error) return error;
+
+	error = CFHD_PrepareEncoderPool(pipeline->encoderPoolRef, format->outputWidth, format->outputHeight,
+									format->pixelFormat, (CFHD_EncodedFormat)format->encodedFormat,
+									CFHD_ENCODING_FLAGS_NONE, (CFHD_EncodingQuality)options->quality);
+	if (error) return error;
+
+	return CFHD_StartEncoderPool(pipeline->encoderPoolRef);
+}
+
+static CFHD_Error AllocateFrames(TRANSCODE_PIPELINE *pipeline)
+{
+	const TRANSCODE_FORMAT *format = &pipeline->format;
+	bool scaled = (format->decodedWidth != format->outputWidth || format->decodedHeight != format->outputHeight);
+
+	pipeline->buffers.resize(pipeline->options->queue);
+
+	for (size_t i = 0; i < pipeline->buffers.size(); i++)
+	{
+		TRANSCODE_FRAME *frame = &pipeline->buffers[i];
+
+		frame->decoded = (uint8_t *)_mm_malloc((size_t)format->decodedPitch * format->decodedHeight, 16);
+		frame->scaled = scaled ? (uint8_t *)_mm_malloc((size_t)format->outputPitch * format->outputHeight, 16) : NULL;
+
+		if (frame->decoded == NULL || (scaled && frame->scaled == NULL)) {
+			return CFHD_ERROR_OUTOFMEMORY;
+		}
+
+		pipeline->freeQueue.Push(frame);
+	}
+
+	return CFHD_ERROR_OKAY;
+}
+
+int main(int argc, char **argv)
+{
+	TRANSCODE_OPTIONS options;
+	TRANSCODE_PIPELINE *pipeline = new TRANSCODE_PIPELINE();
+	std::vector<std::thread> threads;
+	const uint8_t *sample;
+	uint32_t size = 0;
+	uint32_t frameduration = TRANSCODE_DEFAULT_DURATION;
+	float in = 0.0f, out = 0.0f;
+	char *ext;
+	double start, lastTime;
+	uint64_t lastDecodeFrames = 0, lastDecodeBusy = 0, lastScaleFrames = 0, lastScaleBusy = 0, lastWriteFrames = 0;
+	CFHD_Error error = CFHD_ERROR_OKAY;
+	int stageThreads;
+
+	SetDefaultOptions(&options);
+
+	if (!ParseOptions(argc, argv, &options))
+	{
+		Usage(argv[0]);
+		return 1;
+	}
+
+	pipeline->options = &options;
+	pipeline->failed = false;
+
+	ext = (char *)strrchr(options.inputName, '.');
+	if (ext && (0 == strcmp(ext, ".avi") || 0 == strcmp(ext, ".AVI"))) {
+		pipeline->source = OpenAVISource((char *)options.inputName, AVI_TRAK_TYPE, AVI_TRAK_SUBTYPE);
+	} else {
+		pipeline->source = OpenMP4Source((char *)options.inputName, MOV_TRAK_TYPE, MOV_TRAK_SUBTYPE);
+	}
+	if (pipeline->source == NULL || GetNumberPayloads(pipeline->source) == 0) {
+		fprintf(stderr, "could not open %s\n", options.inputName);
+		return 1;
+	}
+
+	pipeline->frameCount = GetNumberPayloads(pipeline->source);
+	if (options.frames > 0 && (uint32_t)options.frames < pipeline->frameCount) {
+		pipeline->frameCount = options.frames;
+	}
+
+	pipeline->prefetch = OpenPrefetchSource(pipeline->source, 0, options.queue, 0);
+	if (pipeline->prefetch == NULL) {
+		fprintf(stderr, "could not read %s\n", options.inputName);
+		return 1;
+	}
+
+	sample = GetPrefetchedPayload(pipeline->prefetch, 0, &size);
+	if (sample) {
+		error = ChooseFormat(&options, sample, size, &pipeline->format);
+		ReleasePrefetchedPayload(pipeline->prefetch, sample);
+	}
+	if (sample == NULL || error) {
+		fprintf(stderr, "could not decode %s: %d\n", options.inputName, error);
+		return 1;
+	}
+
+	if (GetPayloadTime(pipeline->source, 0, &in, &out) == 0 && out > in) {
+		frameduration = (uint32_t)((out - in) * TRANSCODE_TIMESCALE + 0.5f);
+	}
+
+	fprintf(stderr, "%s: %u frames decoded at %dx%d %c%c%c%c, encoded as %s at %dx%d\n",
+			options.inputName, pipeline->frameCount, pipeline->format.decodedWidth, pipeline->format.decodedHeight,
+			PRINTF_PIXELFORMAT(pipeline->format.pixelFormat), FindName(EncodedFormatNames, pipeline->format.encodedFormat),
+			pipeline->format.outputWidth, pipeline->format.outputHeight);
+
+	error = AllocateFrames(pipeline);
+	if (error == CFHD_ERROR_OKAY) {
+		error = StartEncoderPool(pipeline);
+	}
+	if (error) {
+		fprintf(stderr, "could not start the encoders: %d\n", error);
+		return 1;
+	}
+
+	pipeline->movie = OpenMP4Writer((char *)options.outputName, pipeline->format.outputWidth, pipeline->format.outputHeight,
+									(pipeline->format.encodedFormat == CFHD_ENCODED_FORMAT_RGBA_4444) ? 32 : 24,
+									TRANSCODE_TIMESCALE, frameduration);
+	if (pipeline->movie == NULL) {
+		fprintf(stderr, "could not create %s\n", options.outputName);
+		return 1;
+	}
+	SetMP4WriterOptions(pipeline->movie, pipeline->frameCount, 0, 0);
+
+	// Start with a quarter of the threads and let the tuner find the balance
+	stageThreads = options.threads;
+	pipeline->read = new Stage("read", 1, 1);
+	pipeline->decode = new Stage("decode", stageThreads, (stageThreads + 3) / 4);
+	pipeline->scale = new Stage("scale", stageThreads, (stageThreads + 3) / 4);
+	pipeline->encode = new Stage("encode", 1, 1);
+	pipeline->write = new Stage("write", 1, 1);
+
+	start = lastTime = gettime();
+
+	threads.push_back(std::thread(ReadStage, pipeline));
+	for (int i = 0; i < stageThreads; i++) {
+		threads.push_back(std::thread(DecodeStage, pipeline, i));
+	}
+	for (int i = 0; i < stageThreads; i++) {
+		threads.push_back(std::thread(ScaleStage, pipeline, i));
+	}
+	threads.push_back(std::thread(EncodeStage, pipeline));
+	threads.push_back(std::thread(WriteStage, pipeline));
+
+	// Adjust the stage threads until the writer has finished
+	while (pipeline->write->Running())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		if (gettime() - lastTime >= TRANSCODE_TUNE_INTERVAL) {
+			TunePipeline(pipeline, &lastTime, &lastDecodeFrames, &lastDecodeBusy,
+						 &lastScaleFrames, &lastScaleBusy, &lastWriteFrames);
+		}
+	}
+
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+
+	if (CloseMP4Writer(pipeline->movie) != 0 && !pipeline->failed) {
+		fprintf(stderr, "could not write %s\n", options.outputName);
+		pipeline->failed = true;
+	}
+
+	PrintReport(pipeline, gettime() - start);
+
+	CFHD_ReleaseEncoderPool(pipeline->encoderPoolRef);
+	ClosePrefetchSource(pipeline->prefetch);
+	CloseSource(pipeline->source);
+
+	for (size_t i = 0; i < pipeline->buffers.size(); i++)
+	{
+		_mm_free(pipeline->buffers[i].decoded);
+		if (pipeline->buffers[i].scaled) _mm_free(pipeline->buffers[i].scaled);
+	}
+
+	int result = (pipeline->failed || pipeline->write->frames != pipeline->frameCount) ? 2 : 0;
+
+	delete pipeline->read;
+	delete pipeline->decode;
+	delete pipeline->scale;
+	delete pipeline->encode;
+	delete pipeline->write;
+	delete pipeline;
+
+	return result;
+}
@@ -28,6 +28,11 @@ typedef CFHD_Error (*lpCFHD_DecodeSample)(CFHD_DecoderRef decoderRef,
 	size_t sampleSize,
 	void *outputBuffer,
 	int outputPitch);
+typedef CFHD_Error (*lpCFHD_DecodeSampleOutputs)(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	CFHD_OutputDescriptor *outputArray,
+	int outputCount);
 typedef CFHD_Error (*lpCFHD_GetOutputFormats)(CFHD_DecoderRef decoderRef,
 	void *samplePtr,
 	size_t sampleSize,
@@ -69,6 +74,54 @@ typedef CFHD_Error (*lpCFHD_GetThumbnail)(CFHD_DecoderRef decoderRef,
 	size_t *retWidth,
 	size_t *retHeight,
 	size_t *retSize);
+typedef CFHD_Error (*lpCFHD_GetThumbnailInFormat)(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	void *outputBuffer,
+	size_t outputBufferSize,
+	uint32_t flags,
+	CFHD_PixelFormat pixelFormat,
+	size_t *retWidth,
+	size_t *retHeight,
+	size_t *retSize);
+typedef CFHD_Error (*lpCFHD_GetThumbnailImages)(CFHD_DecoderRef decoderRef,
+	void **samplePtrArray,
+	size_t *sampleSizeArray,
+	CFHD_OutputDescriptor *outputArray,
+	CFHD_Error *errorArray,
+	int count);
+typedef CFHD_Error (*lpCFHD_GetProxySample)(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	CFHD_DecodedResolution resolution,
+	void *outputBuffer,
+	size_t outputBufferSize,
+	size_t *retSize);
+typedef CFHD_Error (*lpCFHD_ValidateSample)(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	CFHD_ValidateFlags flags,
+	uint32_t *crc);
+typedef CFHD_Error (*lpCFHD_GetStereoEyeSample)(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	CFHD_VideoSelect eye,
+	void **eyeSamplePtr,
+	size_t *eyeSampleSize);
+typedef CFHD_Error (*lpCFHD_GetDecoderStats)(CFHD_DecoderRef decoderRef,
+	CFHD_Stats *statsOut,
+	CFHD_StatsFlags flags);
+typedef CFHD_Error (*lpCFHD_GetDecoderRequiredMemory)(int encodedWidth,
+	int encodedHeight,
+	CFHD_EncodedFormat encodedFormat,
+	CFHD_EncodingFlags encodingFlags,
+	CFHD_PixelFormat outputFormat,
+	CFHD_DecodedResolution decodedResolution,
+	int threadCount,
+	size_t *requiredMemoryOut);
+typedef CFHD_Error (*lpCFHD_SetDecoderMemoryBudget)(CFHD_DecoderRef decoderRef, size_t memoryBudget);
+typedef CFHD_Error (*lpCFHD_StartThreadTrace)(uint32_t eventsPerThread);
+typedef CFHD_Error (*lpCFHD_StopThreadTrace)(const char *pathname);
 typedef CFHD_Error (*lpCFHD_GetSampleInfo)(CFHD_DecoderRef decoderRef,
 	void *samplePtr,
 	size_t sampleSize,
@@ -86,6 +139,7 @@ lpCFHD_OpenDecoder CF_OpenDecoder;
 lpCFHD_CloseDecoder CF_CloseDecoder;
 lpCFHD_PrepareToDecode CF_PrepareToDecode;
 lpCFHD_DecodeSample CF_DecodeSample;
+lpCFHD_DecodeSampleOutputs CF_DecodeSampleOutputs;
 lpCFHD_GetOutputFormats CF_GetOutputFormats;
 lpCFHD_OpenMetadata CF_OpenMetadata;
 lpCFHD_CloseMetadata CF_CloseMetadata;
@@ -95,6 +149,16 @@ lpCFHD_FindMetadata CF_FindMetadata;
 lpCFHD_SetActiveMetadata CF_SetActiveMetadata;
 lpCFHD_SetLicense CF_SetLicense;
 lpCFHD_GetThumbnail CF_GetThumbnail;
+lpCFHD_GetThumbnailInFormat CF_GetThumbnailInFormat;
+lpCFHD_GetThumbnailImages CF_GetThumbnailImages;
+lpCFHD_GetProxySample CF_GetProxySample;
+lpCFHD_ValidateSample CF_ValidateSample;
+lpCFHD_GetStereoEyeSample CF_GetStereoEyeSample;
+lpCFHD_GetDecoderStats CF_GetDecoderStats;
+lpCFHD_GetDecoderRequiredMemory CF_GetDecoderRequiredMemory;
+lpCFHD_SetDecoderMemoryBudget CF_SetDecoderMemoryBudget;
+lpCFHD_StartThreadTrace CF_StartThreadTrace;
+lpCFHD_StopThreadTrace CF_StopThreadTrace;
 lpCFHD_GetSampleInfo CF_GetSampleInfo;
 lpCFHD_GetPixelSize CF_GetPixelSize;
 lpCFHD_GetImageSize CF_GetImageSize;
@@ -133,6 +197,7 @@ CFHD_Error LoadDLL()
 		CF_CloseDecoder = (lpCFHD_CloseDecoder)getDLLEntry(pLib, "CFHD_CloseDecoder");
 		CF_PrepareToDecode = (lpCFHD_PrepareToDecode)getDLLEntry(pLib, "CFHD_PrepareToDecode");
 		CF_DecodeSample = (lpCFHD_DecodeSample)getDLLEntry(pLib, "CFHD_DecodeSample");
+		CF_DecodeSampleOutputs = (lpCFHD_DecodeSampleOutputs)getDLLEntry(pLib, "CFHD_DecodeSampleOutputs");
 		CF_GetOutputFormats = (lpCFHD_GetOutputFormats)getDLLEntry(pLib, "CFHD_GetOutputFormats");
 		CF_OpenMetadata = (lpCFHD_OpenMetadata)getDLLEntry(pLib, "CFHD_OpenMetadata");
 		CF_CloseMetadata = (lpCFHD_CloseMetadata)getDLLEntry(pLib, "CFHD_CloseMetadata");
@@ -142,6 +207,16 @@ CFHD_Error LoadDLL()
 		CF_SetActiveMetadata = (lpCFHD_SetActiveMetadata)getDLLEntry(pLib, "CFHD_SetActiveMetadata");
 		CF_SetLicense = (lpCFHD_SetLicense)getDLLEntry(pLib, "CFHD_SetLicense");
 		CF_GetThumbnail = (lpCFHD_GetThumbnail)getDLLEntry(pLib, "CFHD_GetThumbnail");
+		CF_GetThumbnailInFormat = (lpCFHD_GetThumbnailInFormat)getDLLEntry(pLib, "CFHD_GetThumbnailInFormat");
+		CF_GetThumbnailImages = (lpCFHD_GetThumbnailImages)getDLLEntry(pLib, "CFHD_GetThumbnailImages");
+		CF_GetProxySample = (lpCFHD_GetProxySample)getDLLEntry(pLib, "CFHD_GetProxySample");
+		CF_ValidateSample = (lpCFHD_ValidateSample)getDLLEntry(pLib, "CFHD_ValidateSample");
+		CF_GetStereoEyeSample = (lpCFHD_GetStereoEyeSample)getDLLEntry(pLib, "CFHD_GetStereoEyeSample");
+		CF_GetDecoderStats = (lpCFHD_GetDecoderStats)getDLLEntry(pLib, "CFHD_GetDecoderStats");
+		CF_GetDecoderRequiredMemory = (lpCFHD_GetDecoderRequiredMemory)getDLLEntry(pLib, "CFHD_GetDecoderRequiredMemory");
+		CF_SetDecoderMemoryBudget = (lpCFHD_SetDecoderMemoryBudget)getDLLEntry(pLib, "CFHD_SetDecoderMemoryBudget");
+		CF_StartThreadTrace = (lpCFHD_StartThreadTrace)getDLLEntry(pLib, "CFHD_StartThreadTrace");
+		CF_StopThreadTrace = (lpCFHD_StopThreadTrace)getDLLEntry(pLib, "CFHD_StopThreadTrace");
 		CF_GetSampleInfo = (lpCFHD_GetSampleInfo)getDLLEntry(pLib, "CFHD_GetSampleInfo");
 		CF_GetPixelSize = (lpCFHD_GetPixelSize)getDLLEntry(pLib, "CFHD_GetPixelSize");
 		CF_GetImageSize = (lpCFHD_GetImageSize)getDLLEntry(pLib, "CFHD_GetImageSize");
@@ -247,6 +322,7 @@ CFHD_Error LoadDLL()
 		CF_CloseDecoder = (lpCFHD_CloseDecoder)GetProcAddress((HMODULE)pLib, "CFHD_CloseDecoder");
 		CF_PrepareToDecode = (lpCFHD_PrepareToDecode)GetProcAddress((HMODULE)pLib, "CFHD_PrepareToDecode");
 		CF_DecodeSample = (lpCFHD_DecodeSample)GetProcAddress((HMODULE)pLib, "CFHD_DecodeSample");
+		CF_DecodeSampleOutputs = (lpCFHD_DecodeSampleOutputs)GetProcAddress((HMODULE)pLib, "CFHD_DecodeSampleOutputs");
 		CF_GetOutputFormats = (lpCFHD_GetOutputFormats)GetProcAddress((HMODULE)pLib, "CFHD_GetOutputFormats");
 		CF_OpenMetadata = (lpCFHD_OpenMetadata)GetProcAddress((HMODULE)pLib, "CFHD_OpenMetadata");
 		CF_CloseMetadata = (lpCFHD_CloseMetadata)GetProcAddress((HMODULE)pLib, "CFHD_CloseMetadata");
@@ -256,6 +332,16 @@ CFHD_Error LoadDLL()
 		CF_SetActiveMetadata = (lpCFHD_SetActiveMetadata)GetProcAddress((HMODULE)pLib, "CFHD_SetActiveMetadata");
 		CF_SetLicense = (lpCFHD_SetLicense)GetProcAddress((HMODULE)pLib, "CFHD_SetLicense");
 		CF_GetThumbnail = (lpCFHD_GetThumbnail)GetProcAddress((HMODULE)pLib, "CFHD_GetThumbnail");
+		CF_GetThumbnailInFormat = (lpCFHD_GetThumbnailInFormat)GetProcAddress((HMODULE)pLib, "CFHD_GetThumbnailInFormat");
+		CF_GetThumbnailImages = (lpCFHD_GetThumbnailImages)GetProcAddress((HMODULE)pLib, "CFHD_GetThumbnailImages");
+		CF_GetProxySample = (lpCFHD_GetProxySample)GetProcAddress((HMODULE)pLib, "CFHD_GetProxySample");
+		CF_ValidateSample = (lpCFHD_ValidateSample)GetProcAddress((HMODULE)pLib, "CFHD_ValidateSample");
+		CF_GetStereoEyeSample = (lpCFHD_GetStereoEyeSample)GetProcAddress((HMODULE)pLib, "CFHD_GetStereoEyeSample");
+		CF_GetDecoderStats = (lpCFHD_GetDecoderStats)GetProcAddress((HMODULE)pLib, "CFHD_GetDecoderStats");
+		CF_GetDecoderRequiredMemory = (lpCFHD_GetDecoderRequiredMemory)GetProcAddress((HMODULE)pLib, "CFHD_GetDecoderRequiredMemory");
+		CF_SetDecoderMemoryBudget = (lpCFHD_SetDecoderMemoryBudget)GetProcAddress((HMODULE)pLib, "CFHD_SetDecoderMemoryBudget");
+		CF_StartThreadTrace = (lpCFHD_StartThreadTrace)GetProcAddress((HMODULE)pLib, "CFHD_StartThreadTrace");
+		CF_StopThreadTrace = (lpCFHD_StopThreadTrace)GetProcAddress((HMODULE)pLib, "CFHD_StopThreadTrace");
 		CF_GetSampleInfo = (lpCFHD_GetSampleInfo)GetProcAddress((HMODULE)pLib, "CFHD_GetSampleInfo");
 		CF_GetPixelSize = (lpCFHD_GetPixelSize)GetProcAddress((HMODULE)pLib, "CFHD_GetPixelSize");
 		CF_GetImageSize = (lpCFHD_GetImageSize)GetProcAddress((HMODULE)pLib, "CFHD_GetImageSize");
@@ -364,6 +450,22 @@ CFHD_Error CFHD_DecodeSampleStub(CFHD_DecoderRef decoderRef,
 		outputPitch);
 }
 
+CFHD_Error CFHD_DecodeSampleOutputsStub(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	CFHD_OutputDescriptor *outputArray,
+	int outputCount)
+{
+	if(pLib == NULL || CF_DecodeSampleOutputs == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_DecodeSampleOutputs(
+		decoderRef,
+		samplePtr,
+		sampleSize,
+		outputArray,
+		outputCount);
+}
+
 CFHD_Error CFHD_GetOutputFormatsStub(CFHD_DecoderRef decoderRef,
 	void *samplePtr,
 	size_t sampleSize,
@@ -496,6 +598,160 @@ CFHD_Error CFHD_GetThumbnailStub(CFHD_DecoderRef decoderRef,
 		retSize);
 }
 
+CFHD_Error CFHD_GetThumbnailInFormatStub(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	void *outputBuffer,
+	size_t outputBufferSize,
+	uint32_t flags,
+	CFHD_PixelFormat pixelFormat,
+	size_t *retWidth,
+	size_t *retHeight,
+	size_t *retSize)
+{
+	if(pLib == NULL || CF_GetThumbnailInFormat == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_GetThumbnailInFormat(
+		decoderRef,
+		samplePtr,
+		sampleSize,
+		outputBuffer,
+		outputBufferSize,
+		flags,
+		pixelFormat,
+		retWidth,
+		retHeight,
+		retSize);
+}
+
+CFHD_Error CFHD_GetThumbnailImagesStub(CFHD_DecoderRef decoderRef,
+	void **samplePtrArray,
+	size_t *sampleSizeArray,
+	CFHD_OutputDescriptor *outputArray,
+	CFHD_Error *errorArray,
+	int count)
+{
+	if(pLib == NULL || CF_GetThumbnailImages == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_GetThumbnailImages(
+		decoderRef,
+		samplePtrArray,
+		sampleSizeArray,
+		outputArray,
+		errorArray,
+		count);
+}
+
+CFHD_Error CFHD_GetProxySampleStub(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	CFHD_DecodedResolution resolution,
+	void *outputBuffer,
+	size_t outputBufferSize,
+	size_t *retSize)
+{
+	if(pLib == NULL || CF_GetProxySample == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_GetProxySample(
+		decoderRef,
+		samplePtr,
+		sampleSize,
+		resolution,
+		outputBuffer,
+		outputBufferSize,
+		retSize);
+}
+
+CFHD_Error CFHD_ValidateSampleStub(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	CFHD_ValidateFlags flags,
+	uint32_t *crc)
+{
+	if(pLib == NULL || CF_ValidateSample == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_ValidateSample(
+		decoderRef,
+		samplePtr,
+		sampleSize,
+		flags,
+		crc);
+}
+
+CFHD_Error CFHD_GetStereoEyeSampleStub(CFHD_DecoderRef decoderRef,
+	void *samplePtr,
+	size_t sampleSize,
+	CFHD_VideoSelect eye,
+	void **eyeSamplePtr,
+	size_t *eyeSampleSize)
+{
+	if(pLib == NULL || CF_GetStereoEyeSample == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_GetStereoEyeSample(
+		decoderRef,
+		samplePtr,
+		sampleSize,
+		eye,
+		eyeSamplePtr,
+		eyeSampleSize);
+}
+
+CFHD_Error CFHD_GetDecoderStatsStub(CFHD_DecoderRef decoderRef,
+	CFHD_Stats *statsOut,
+	CFHD_StatsFlags flags)
+{
+	if(pLib == NULL || CF_GetDecoderStats == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_GetDecoderStats(
+		decoderRef,
+		statsOut,
+		flags);
+}
+
+CFHD_Error CFHD_GetDecoderRequiredMemoryStub(int encodedWidth,
+	int encodedHeight,
+	CFHD_EncodedFormat encodedFormat,
+	CFHD_EncodingFlags encodingFlags,
+	CFHD_PixelFormat outputFormat,
+	CFHD_DecodedResolution decodedResolution,
+	int threadCount,
+	size_t *requiredMemoryOut)
+{
+	if(pLib == NULL || CF_GetDecoderRequiredMemory == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_GetDecoderRequiredMemory(
+		encodedWidth,
+		encodedHeight,
+		encodedFormat,
+		encodingFlags,
+		outputFormat,
+		decodedResolution,
+		threadCount,
+		requiredMemoryOut);
+}
+
+CFHD_Error CFHD_SetDecoderMemoryBudgetStub(CFHD_DecoderRef decoderRef,
+	size_t memoryBudget)
+{
+	if(pLib == NULL || CF_SetDecoderMemoryBudget == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_SetDecoderMemoryBudget(decoderRef, memoryBudget);
+}
+
+CFHD_Error CFHD_StartThreadTraceStub(uint32_t eventsPerThread)
+{
+	if(pLib == NULL || CF_StartThreadTrace == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_StartThreadTrace(eventsPerThread);
+}
+
+CFHD_Error CFHD_StopThreadTraceStub(const char *pathname)
+{
+	if(pLib == NULL || CF_StopThreadTrace == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_StopThreadTrace(pathname);
+}
+
 CFHD_Error CFHD_GetSampleInfoStub(CFHD_DecoderRef decoderRef,
 	void *samplePtr,
 	size_t sampleSize,
@@ -549,4 +805,4 @@ CFHD_Error CFHD_ClearActiveMetadata(CFHD_DecoderRef decoderRef, CFHD_MetadataRef
 }
 
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
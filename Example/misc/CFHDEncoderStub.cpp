@@ -50,6 +50,17 @@ typedef CFHD_Error (*lpCFHD_GetEncodeThumbnail)(CFHD_EncoderRef encoderRef,
 	size_t *retWidth,
 	size_t *retHeight,
 	size_t *retSize);
+typedef CFHD_Error (*lpCFHD_GetEncoderStats)(CFHD_EncoderRef encoderRef,
+	CFHD_Stats *statsOut,
+	CFHD_StatsFlags flags);
+typedef CFHD_Error (*lpCFHD_GetEncoderRequiredMemory)(int frameWidth,
+	int frameHeight,
+	CFHD_PixelFormat inputFormat,
+	CFHD_EncodedFormat encodedFormat,
+	CFHD_EncodingFlags encodingFlags,
+	int encoderCount,
+	size_t *requiredMemoryOut);
+typedef CFHD_Error (*lpCFHD_SetEncoderMemoryBudget)(CFHD_EncoderRef encoderRef, size_t memoryBudget);
 typedef CFHD_Error (*lpCFHD_MetadataOpen)(CFHD_MetadataRef *metadataRefOut);
 typedef CFHD_Error (*lpCFHD_MetadataAdd)(CFHD_MetadataRef metadataRef,
 	uint32_t tag,
@@ -139,6 +150,9 @@ lpCFHD_EncodeSample					CF_EncodeSample;
 lpCFHD_GetSampleData				CF_GetSampleData; 
 lpCFHD_CloseEncoder					CF_CloseEncoder; 
 lpCFHD_GetEncodeThumbnail			CF_GetEncodeThumbnail; 
+lpCFHD_GetEncoderStats				CF_GetEncoderStats;
+lpCFHD_GetEncoderRequiredMemory		CF_GetEncoderRequiredMemory;
+lpCFHD_SetEncoderMemoryBudget		CF_SetEncoderMemoryBudget;
 lpCFHD_MetadataOpen					CF_MetadataOpen; 
 lpCFHD_MetadataAdd					CF_MetadataAdd; 
 lpCFHD_MetadataAttach				CF_MetadataAttach; 
@@ -198,6 +212,9 @@ CFHD_Error LoadDLL()
 		CF_GetSampleData = (lpCFHD_GetSampleData)getDLLEntry(pLib, "CFHD_GetSampleData");
 		CF_CloseEncoder = (lpCFHD_CloseEncoder)getDLLEntry(pLib, "CFHD_CloseEncoder");
 		CF_GetEncodeThumbnail = (lpCFHD_GetEncodeThumbnail)getDLLEntry(pLib, "CFHD_GetEncodeThumbnail");
+		CF_GetEncoderStats = (lpCFHD_GetEncoderStats)getDLLEntry(pLib, "CFHD_GetEncoderStats");
+		CF_GetEncoderRequiredMemory = (lpCFHD_GetEncoderRequiredMemory)getDLLEntry(pLib, "CFHD_GetEncoderRequiredMemory");
+		CF_SetEncoderMemoryBudget = (lpCFHD_SetEncoderMemoryBudget)getDLLEntry(pLib, "CFHD_SetEncoderMemoryBudget");
 		CF_MetadataOpen = (lpCFHD_MetadataOpen)getDLLEntry(pLib, "CFHD_MetadataOpen");
 		CF_MetadataAdd = (lpCFHD_MetadataAdd)getDLLEntry(pLib, "CFHD_MetadataAdd");
 		CF_MetadataAttach = (lpCFHD_MetadataAttach)getDLLEntry(pLib, "CFHD_MetadataAttach");
@@ -338,6 +355,9 @@ CFHD_Error LoadDLL()
 		CF_GetSampleData = (lpCFHD_GetSampleData)GetProcAddress((HMODULE)pLib, "CFHD_GetSampleData");
 		CF_CloseEncoder = (lpCFHD_CloseEncoder)GetProcAddress((HMODULE)pLib, "CFHD_CloseEncoder");
 		CF_GetEncodeThumbnail = (lpCFHD_GetEncodeThumbnail)GetProcAddress((HMODULE)pLib, "CFHD_GetEncodeThumbnail");
+		CF_GetEncoderStats = (lpCFHD_GetEncoderStats)GetProcAddress((HMODULE)pLib, "CFHD_GetEncoderStats");
+		CF_GetEncoderRequiredMemory = (lpCFHD_GetEncoderRequiredMemory)GetProcAddress((HMODULE)pLib, "CFHD_GetEncoderRequiredMemory");
+		CF_SetEncoderMemoryBudget = (lpCFHD_SetEncoderMemoryBudget)GetProcAddress((HMODULE)pLib, "CFHD_SetEncoderMemoryBudget");
 		CF_MetadataOpen = (lpCFHD_MetadataOpen)GetProcAddress((HMODULE)pLib, "CFHD_MetadataOpen");
 		CF_MetadataAdd = (lpCFHD_MetadataAdd)GetProcAddress((HMODULE)pLib, "CFHD_MetadataAdd");
 		CF_MetadataAttach = (lpCFHD_MetadataAttach)GetProcAddress((HMODULE)pLib, "CFHD_MetadataAttach");
@@ -540,6 +560,38 @@ CFHD_Error CFHD_GetEncodeThumbnailStub(CFHD_EncoderRef encoderRef,
 						retSize);
 }
 
+CFHD_Error CFHD_GetEncoderStatsStub(CFHD_EncoderRef encoderRef,
+						CFHD_Stats *statsOut,
+						CFHD_StatsFlags flags)
+{
+	// Not checked when the library is loaded since older libraries do not have statistics
+	if(pLib == NULL || CF_GetEncoderStats == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_GetEncoderStats(encoderRef, statsOut, flags);
+}
+
+CFHD_Error CFHD_GetEncoderRequiredMemoryStub(int frameWidth,
+						int frameHeight,
+						CFHD_PixelFormat inputFormat,
+						CFHD_EncodedFormat encodedFormat,
+						CFHD_EncodingFlags encodingFlags,
+						int encoderCount,
+						size_t *requiredMemoryOut)
+{
+	if(pLib == NULL || CF_GetEncoderRequiredMemory == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_GetEncoderRequiredMemory(frameWidth, frameHeight, inputFormat, encodedFormat,
+									   encodingFlags, encoderCount, requiredMemoryOut);
+}
+
+CFHD_Error CFHD_SetEncoderMemoryBudgetStub(CFHD_EncoderRef encoderRef,
+						size_t memoryBudget)
+{
+	if(pLib == NULL || CF_SetEncoderMemoryBudget == NULL)
+		return CFHD_ERROR_UNEXPECTED;
+	return CF_SetEncoderMemoryBudget(encoderRef, memoryBudget);
+}
+
 CFHD_Error CFHD_MetadataOpenStub(CFHD_MetadataRef *metadataRefOut)
 {
 	if(pLib == NULL)
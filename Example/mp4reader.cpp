@@ -27,6 +27,14 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "mp4reader.h"
 
 #define PRINT_MP4_STRUCTURE		0
@@ -575,6 +583,8 @@ void CloseSource(void *handle)
 	videoobject *mp4 = (videoobject *)handle;
 	if (mp4 == NULL) return;
 
+	UnmapSource(handle);
+
 	if (mp4->mediafp) fclose(mp4->mediafp), mp4->mediafp = NULL;
 	if (mp4->metasizes) free(mp4->metasizes), mp4->metasizes = 0;
 	if (mp4->metaoffsets) free(mp4->metaoffsets), mp4->metaoffsets = 0;
@@ -596,3 +606,159 @@ uint32_t GetPayloadTime(void *handle, uint32_t index, float *in, float *out)
 }
 
 
+uint32_t MapSource(void *handle, uint32_t readahead_frames, uint64_t readahead_bytes)
+{
+	videoobject *mp4 = (videoobject *)handle;
+	if (mp4 == NULL || mp4->mediafp == NULL || mp4->metaoffsets == NULL || mp4->metasizes == NULL) return 1;
+
+	if (mp4->mapbase == NULL)
+	{
+#ifdef _WIN32
+		HANDLE file = (HANDLE)_get_osfhandle(_fileno(mp4->mediafp));
+		LARGE_INTEGER filesize;
+		HANDLE mapping;
+		void *base;
+
+		if (!GetFileSizeEx(file, &filesize) || filesize.QuadPart <= 0 || (uint64_t)filesize.QuadPart > (uint64_t)SIZE_MAX) return 1;
+
+		mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL) return 1;
+
+		base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (base == NULL)
+		{
+			CloseHandle(mapping);
+			return 1;
+		}
+
+		mp4->maphandle = (void *)mapping;
+		mp4->mapbase = (uint8_t *)base;
+		mp4->mapsize = (uint64_t)filesize.QuadPart;
+#else
+		struct stat filestat;
+		uint32_t index, sequential = 1;
+		void *base;
+
+		if (fstat(fileno(mp4->mediafp), &filestat) != 0 || filestat.st_size <= 0 || (uint64_t)filestat.st_size > (uint64_t)SIZE_MAX) return 1;
+
+		base = mmap(NULL, (size_t)filestat.st_size, PROT_READ, MAP_SHARED, fileno(mp4->mediafp), 0);
+		if (base == MAP_FAILED) return 1;
+
+		mp4->mapbase = (uint8_t *)base;
+		mp4->mapsize = (uint64_t)filestat.st_size;
+
+		// The kernel read-ahead helps if the samples are stored in order, otherwise only the requested samples are read
+		for (index = 1; index < mp4->indexcount; index++)
+		{
+			if (mp4->metaoffsets[index] < mp4->metaoffsets[index - 1]) sequential = 0;
+		}
+		madvise(base, (size_t)mp4->mapsize, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+	}
+
+	mp4->readahead_frames = readahead_frames ? readahead_frames : MAP_READAHEAD_FRAMES;
+	mp4->readahead_bytes = readahead_bytes ? readahead_bytes : MAP_READAHEAD_BYTES;
+	mp4->readahead_next = 0;
+	mp4->readahead_last = 0;
+
+	return 0;
+}
+
+
+// Request the pages of the samples from the start to the end of the range
+static void AdviseRange(videoobject *mp4, uint64_t start, uint64_t end)
+{
+#ifdef _WIN32
+	// The pages of a mapped view are read when they are first used
+	(void)mp4, (void)start, (void)end;
+#else
+	uint64_t pagesize = (uint64_t)sysconf(_SC_PAGESIZE);
+
+	start &= ~(pagesize - 1);
+	if (end > start)
+		madvise(mp4->mapbase + start, (size_t)(end - start), MADV_WILLNEED);
+#endif
+}
+
+
+// Request the samples in the read-ahead window that starts at the sample
+static void AdvisePayloads(videoobject *mp4, uint32_t index)
+{
+	uint64_t bytes = 0, start = 0, end = 0;
+	uint32_t last;
+
+	// Start a new window after a seek or a change of direction
+	if (index < mp4->readahead_last || index > mp4->readahead_next)
+		mp4->readahead_next = index;
+	mp4->readahead_last = index;
+
+	// The window ends at the frame or byte limit but always includes the sample
+	for (last = index; last < mp4->indexcount && last - index < mp4->readahead_frames; last++)
+	{
+		bytes += mp4->metasizes[last];
+		if (last > index && bytes > mp4->readahead_bytes) break;
+	}
+
+	// Combine the samples that are next to each other in the file into one request
+	for (; mp4->readahead_next < last; mp4->readahead_next++)
+	{
+		uint64_t offset = mp4->metaoffsets[mp4->readahead_next];
+		uint64_t size = mp4->metasizes[mp4->readahead_next];
+
+		if (offset >= mp4->mapsize) continue;
+		if (size > mp4->mapsize - offset) size = mp4->mapsize - offset;
+
+		if (end > start && offset >= start && offset <= end)
+		{
+			if (offset + size > end) end = offset + size;
+		}
+		else
+		{
+			AdviseRange(mp4, start, end);
+			start = offset;
+			end = offset + size;
+		}
+	}
+	AdviseRange(mp4, start, end);
+}
+
+
+const uint8_t *GetPayloadPointer(void *handle, uint32_t index, uint32_t *size)
+{
+	videoobject *mp4 = (videoobject *)handle;
+	if (mp4 == NULL || mp4->mapbase == NULL) return NULL;
+
+	if (index < mp4->indexcount && index < mp4->metasize_count)
+	{
+		uint64_t offset = mp4->metaoffsets[index];
+		uint32_t length = mp4->metasizes[index];
+
+		// The sample may be past the end of a truncated file
+		if (offset > mp4->mapsize || length > mp4->mapsize - offset) return NULL;
+
+		AdvisePayloads(mp4, index);
+
+		if (size) *size = length;
+		return mp4->mapbase + offset;
+	}
+	return NULL;
+}
+
+
+void UnmapSource(void *handle)
+{
+	videoobject *mp4 = (videoobject *)handle;
+	if (mp4 == NULL || mp4->mapbase == NULL) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mp4->mapbase);
+	CloseHandle((HANDLE)mp4->maphandle);
+	mp4->maphandle = NULL;
+#else
+	munmap(mp4->mapbase, (size_t)mp4->mapsize);
+#endif
+	mp4->mapbase = NULL;
+	mp4->mapsize = 0;
+}
+
+
@@ -62,6 +62,13 @@ typedef struct videoobject
 	uint32_t basemetadataduration;
 	uint32_t basemetadataoffset;
 	FILE *mediafp;
+	uint8_t *mapbase;				// File mapped by MapSource (NULL if the file is not mapped)
+	uint64_t mapsize;
+	void *maphandle;				// File mapping object (Windows only)
+	uint32_t readahead_frames;		// Maximum number of samples requested ahead of the current sample
+	uint64_t readahead_bytes;		// Maximum number of bytes requested ahead of the current sample
+	uint32_t readahead_next;		// First sample that has not been requested
+	uint32_t readahead_last;		// Sample returned by the previous call to GetPayloadPointer
 } videoobject;
 
 #define MAKEID(a,b,c,d)			(((d&0xff)<<24)|((c&0xff)<<16)|((b&0xff)<<8)|(a&0xff))
@@ -77,6 +84,9 @@ typedef struct videoobject
 #define AVI_TRAK_TYPE		MAKEID('v', 'i', 'd', 's')		// track is the type for video
 #define AVI_TRAK_SUBTYPE	MAKEID('c', 'f', 'h', 'd')		// subtype is CineForm HD
 
+#define MAP_READAHEAD_FRAMES	8				// Default number of samples read ahead from a mapped file
+#define MAP_READAHEAD_BYTES		(64 << 20)		// Default limit on the bytes read ahead from a mapped file
+
 #define NESTSIZE(x) { int i = nest; while (i > 0 && nestsize[i] > 0) { nestsize[i] -= x; if(nestsize[i]>=0 && nestsize[i] <= 8) { nestsize[i]=0; nest--; } i--; } }
 
 #define VALID_FOURCC(a)	(((((a>>24)&0xff)>='a'&&((a>>24)&0xff)<='z') || (((a>>24)&0xff)>='A'&&((a>>24)&0xff)<='Z') || (((a>>24)&0xff)>='0'&&((a>>24)&0xff)<='9') || (((a>>24)&0xff)==' ') ) && \
@@ -94,6 +104,12 @@ void FreePayload(uint32_t *lastpayload);
 uint32_t GetPayloadSize(void *handle, uint32_t index);
 uint32_t GetPayloadTime(void *handle, uint32_t index, float *in, float *out); //MP4 timestamps for the payload
 
+// Map the file into memory so that samples can be used without copying (returns 0 if the file was mapped)
+uint32_t MapSource(void *handle, uint32_t readahead_frames, uint64_t readahead_bytes);
+// Return a pointer to the sample in the mapped file and request the next samples from the file system
+const uint8_t *GetPayloadPointer(void *handle, uint32_t index, uint32_t *size);
+void UnmapSource(void *handle);
+
 #ifdef __cplusplus
 }
 #endif
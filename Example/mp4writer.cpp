@@ -0,0 +1,646 @@
+/*! @file mp4writer.cpp
+*
+*  @brief Minimal MOV writer for CineForm video tracks
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#include "mp4writer.h"
+
+// Atom type in the order the characters are written to the file
+#define ATOM(a,b,c,d)			(((uint32_t)(a) << 24) | ((b) << 16) | ((c) << 8) | (d))
+
+// Upper bound on the size of the movie header without the sample sizes and offsets
+#define MOOV_FIXED_SIZE			1024
+
+// Upper bound on the size of the movie header entries for each sample (stsz and co64)
+#define MOOV_SAMPLE_SIZE		12
+
+// Seconds from the QuickTime epoch (1904) to the Unix epoch (1970)
+#define QUICKTIME_EPOCH_OFFSET	2082844800U
+
+typedef struct mp4writer
+{
+#ifdef _WIN32
+	HANDLE file;
+#else
+	int fd;
+#endif
+	uint32_t width;
+	uint32_t height;
+	uint32_t depth;
+	uint32_t timescale;
+	uint32_t frameduration;
+
+	uint32_t reserve_frames;		// Number of samples in the movie header that fits in the reserved space
+	uint32_t batch_bytes;
+	uint64_t preallocate_bytes;
+
+	uint8_t *batch;					// Data that has not been written to the file
+	uint32_t fill;					// Number of bytes in the batch buffer
+	uint64_t flushed;				// File offset of the start of the batch buffer
+	uint64_t allocated;				// End of the disk space allocated for the file
+
+	uint64_t reserve_offset;		// Free atom reserved for the movie header (zero if the header is written at the end)
+	uint64_t reserve_size;
+	uint64_t mdat_offset;
+
+	uint32_t *sizes;
+	uint64_t *offsets;
+	uint32_t count;
+	uint32_t capacity;
+
+	int started;					// Set when the file type and media data headers have been written
+	int error;						// Set if a write has failed
+} mp4writer;
+
+
+static uint8_t *Put16(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t)(value >> 8);
+	p[1] = (uint8_t)value;
+	return p + 2;
+}
+
+
+static uint8_t *Put32(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t)(value >> 24);
+	p[1] = (uint8_t)(value >> 16);
+	p[2] = (uint8_t)(value >> 8);
+	p[3] = (uint8_t)value;
+	return p + 4;
+}
+
+
+static uint8_t *Put64(uint8_t *p, uint64_t value)
+{
+	p = Put32(p, (uint32_t)(value >> 32));
+	return Put32(p, (uint32_t)value);
+}
+
+
+static uint8_t *PutZeros(uint8_t *p, uint32_t length)
+{
+	memset(p, 0, length);
+	return p + length;
+}
+
+
+// Start an atom and return a pointer to the size that is set by EndAtom
+static uint8_t *BeginAtom(uint8_t **p, uint32_t tag)
+{
+	uint8_t *start = *p;
+	*p = Put32(*p, 0);
+	*p = Put32(*p, tag);
+	return start;
+}
+
+
+static void EndAtom(uint8_t *start, uint8_t *p)
+{
+	Put32(start, (uint32_t)(p - start));
+}
+
+
+static uint8_t *PutMatrix(uint8_t *p)
+{
+	p = Put32(p, 0x00010000); p = Put32(p, 0); p = Put32(p, 0);
+	p = Put32(p, 0); p = Put32(p, 0x00010000); p = Put32(p, 0);
+	p = Put32(p, 0); p = Put32(p, 0); p = Put32(p, 0x40000000);
+	return p;
+}
+
+
+static int WriteAt(mp4writer *mp4, uint64_t offset, const uint8_t *data, uint64_t length)
+{
+	while (length > 0)
+	{
+		uint32_t chunk = (length > (1U << 30)) ? (1U << 30) : (uint32_t)length;
+#ifdef _WIN32
+		OVERLAPPED overlapped;
+		DWORD count = 0;
+
+		memset(&overlapped, 0, sizeof(overlapped));
+		overlapped.Offset = (DWORD)(offset & 0xffffffff);
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+		if (!WriteFile(mp4->file, data, chunk, &count, &overlapped) || count == 0) return 1;
+#else
+		ssize_t count = pwrite(mp4->fd, data, chunk, (off_t)offset);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) return 1;
+#endif
+		data += count;
+		offset += count;
+		length -= count;
+	}
+	return 0;
+}
+
+
+// Allocate disk space ahead of the writes so that the file is not extended on every write
+static void Preallocate(mp4writer *mp4, uint64_t end)
+{
+	uint64_t start = mp4->allocated;
+
+	if (end <= mp4->allocated || mp4->preallocate_bytes == 0) return;
+
+	if (end < start + mp4->preallocate_bytes) end = start + mp4->preallocate_bytes;
+
+	// The file size is not changed and a failure only means the file system allocates the space as it is written
+#ifdef _WIN32
+	{
+		FILE_ALLOCATION_INFO info;
+		info.AllocationSize.QuadPart = (LONGLONG)end;
+		SetFileInformationByHandle(mp4->file, FileAllocationInfo, &info, sizeof(info));
+	}
+#elif __APPLE__
+	{
+		fstore_t store;
+		memset(&store, 0, sizeof(store));
+		store.fst_flags = F_ALLOCATECONTIG;
+		store.fst_posmode = F_PEOFPOSMODE;
+		store.fst_length = (off_t)(end - start);
+		if (fcntl(mp4->fd, F_PREALLOCATE, &store) == -1)
+		{
+			store.fst_flags = F_ALLOCATEALL;
+			fcntl(mp4->fd, F_PREALLOCATE, &store);
+		}
+	}
+#elif __linux__
+	fallocate(mp4->fd, FALLOC_FL_KEEP_SIZE, (off_t)start, (off_t)(end - start));
+#endif
+
+	mp4->allocated = end;
+}
+
+
+static void Flush(mp4writer *mp4)
+{
+	if (mp4->fill == 0) return;
+
+	Preallocate(mp4, mp4->flushed + mp4->fill);
+	if (WriteAt(mp4, mp4->flushed, mp4->batch, mp4->fill)) mp4->error = 1;
+
+	mp4->flushed += mp4->fill;
+	mp4->fill = 0;
+}
+
+
+// Append data to the file in batches that start on an aligned offset
+static void Append(mp4writer *mp4, const uint8_t *data, uint64_t length)
+{
+	while (length > 0)
+	{
+		uint64_t count;
+
+		if (mp4->fill == 0 && data && length >= MP4WRITER_ALIGNMENT)
+		{
+			// Write the aligned part of a large block without copying it into the batch buffer
+			count = length & ~(uint64_t)(MP4WRITER_ALIGNMENT - 1);
+
+			Preallocate(mp4, mp4->flushed + count);
+			if (WriteAt(mp4, mp4->flushed, data, count)) mp4->error = 1;
+
+			mp4->flushed += count;
+		}
+		else
+		{
+			count = mp4->batch_bytes - mp4->fill;
+			if (count > length) count = length;
+
+			if (data)
+				memcpy(mp4->batch + mp4->fill, data, (size_t)count);
+			else
+				memset(mp4->batch + mp4->fill, 0, (size_t)count);
+
+			mp4->fill += (uint32_t)count;
+			if (mp4->fill == mp4->batch_bytes) Flush(mp4);
+		}
+
+		if (data) data += count;
+		length -= count;
+	}
+}
+
+
+// Reserved space for a movie header that indexes the number of samples
+static uint64_t ReserveSize(uint32_t frames)
+{
+	return frames ? MOOV_FIXED_SIZE + (uint64_t)frames * MOOV_SAMPLE_SIZE : 0;
+}
+
+
+// Write the file type atom, the space reserved for the movie header and the start of the media data atom
+static void Begin(mp4writer *mp4)
+{
+	uint8_t header[32];
+	uint8_t *p = header;
+
+	mp4->started = 1;
+
+	p = Put32(p, 20);
+	p = Put32(p, ATOM('f','t','y','p'));
+	p = Put32(p, ATOM('q','t',' ',' '));
+	p = Put32(p, 0);
+	p = Put32(p, ATOM('q','t',' ',' '));
+	Append(mp4, header, p - header);
+
+	mp4->reserve_size = ReserveSize(mp4->reserve_frames);
+	if (mp4->reserve_size > 0)
+	{
+		mp4->reserve_offset = mp4->flushed + mp4->fill;
+
+		p = header;
+		p = Put32(p, (uint32_t)mp4->reserve_size);
+		p = Put32(p, ATOM('f','r','e','e'));
+		Append(mp4, header, p - header);
+		Append(mp4, NULL, mp4->reserve_size - 8);
+	}
+
+	// The media data atom always uses a 64-bit size so that the size can be set when the file is closed
+	mp4->mdat_offset = mp4->flushed + mp4->fill;
+
+	p = header;
+	p = Put32(p, 1);
+	p = Put32(p, ATOM('m','d','a','t'));
+	p = Put64(p, 0);
+	Append(mp4, header, p - header);
+}
+
+
+// Write the movie header into the buffer and return its size
+static uint32_t BuildMovieHeader(mp4writer *mp4, uint8_t *buffer)
+{
+	uint8_t *p = buffer;
+	uint8_t *moov, *trak, *mdia, *minf, *dinf, *dref, *stbl, *stsd, *entry, *atom;
+	uint32_t now = (uint32_t)((uint64_t)time(NULL) + QUICKTIME_EPOCH_OFFSET);
+	uint32_t duration = mp4->count * mp4->frameduration;
+	int large = (mp4->count > 0 && mp4->offsets[mp4->count - 1] > 0xffffffffULL);
+	uint32_t i;
+
+	moov = BeginAtom(&p, ATOM('m','o','o','v'));
+
+	atom = BeginAtom(&p, ATOM('m','v','h','d'));
+	p = Put32(p, 0);						// version and flags
+	p = Put32(p, now);						// creation time
+	p = Put32(p, now);						// modification time
+	p = Put32(p, mp4->timescale);
+	p = Put32(p, duration);
+	p = Put32(p, 0x00010000);				// preferred rate
+	p = Put16(p, 0x0100);					// preferred volume
+	p = PutZeros(p, 10);
+	p = PutMatrix(p);
+	p = PutZeros(p, 24);					// preview, poster, selection and current time
+	p = Put32(p, 2);						// next track ID
+	EndAtom(atom, p);
+
+	trak = BeginAtom(&p, ATOM('t','r','a','k'));
+
+	atom = BeginAtom(&p, ATOM('t','k','h','d'));
+	p = Put32(p, 0x0000000f);				// enabled, in movie, in preview and in poster
+	p = Put32(p, now);
+	p = Put32(p, now);
+	p = Put32(p, 1);						// track ID
+	p = Put32(p, 0);
+	p = Put32(p, duration);
+	p = PutZeros(p, 8);
+	p = Put16(p, 0);						// layer
+	p = Put16(p, 0);						// alternate group
+	p = Put16(p, 0);						// volume
+	p = Put16(p, 0);
+	p = PutMatrix(p);
+	p = Put32(p, mp4->width << 16);
+	p = Put32(p, mp4->height << 16);
+	EndAtom(atom, p);
+
+	mdia = BeginAtom(&p, ATOM('m','d','i','a'));
+
+	atom = BeginAtom(&p, ATOM('m','d','h','d'));
+	p = Put32(p, 0);
+	p = Put32(p, now);
+	p = Put32(p, now);
+	p = Put32(p, mp4->timescale);
+	p = Put32(p, duration);
+	p = Put16(p, 0);						// language
+	p = Put16(p, 0);						// quality
+	EndAtom(atom, p);
+
+	atom = BeginAtom(&p, ATOM('h','d','l','r'));
+	p = Put32(p, 0);
+	p = Put32(p, ATOM('m','h','l','r'));
+	p = Put32(p, ATOM('v','i','d','e'));
+	p = PutZeros(p, 12);
+	*p++ = 0;								// empty component name
+	EndAtom(atom, p);
+
+	minf = BeginAtom(&p, ATOM('m','i','n','f'));
+
+	atom = BeginAtom(&p, ATOM('v','m','h','d'));
+	p = Put32(p, 0x00000001);
+	p = Put16(p, 0x0040);					// graphics mode (dither copy)
+	p = PutZeros(p, 6);						// opcolor
+	EndAtom(atom, p);
+
+	atom = BeginAtom(&p, ATOM('h','d','l','r'));
+	p = Put32(p, 0);
+	p = Put32(p, ATOM('d','h','l','r'));
+	p = Put32(p, ATOM('a','l','i','s'));
+	p = PutZeros(p, 12);
+	*p++ = 0;
+	EndAtom(atom, p);
+
+	dinf = BeginAtom(&p, ATOM('d','i','n','f'));
+	dref = BeginAtom(&p, ATOM('d','r','e','f'));
+	p = Put32(p, 0);
+	p = Put32(p, 1);
+	atom = BeginAtom(&p, ATOM('a','l','i','s'));		// The media data is in this file
+	p = Put32(p, 0x00000001);
+	EndAtom(atom, p);
+	EndAtom(dref, p);
+	EndAtom(dinf, p);
+
+	stbl = BeginAtom(&p, ATOM('s','t','b','l'));
+
+	stsd = BeginAtom(&p, ATOM('s','t','s','d'));
+	p = Put32(p, 0);
+	p = Put32(p, 1);
+	entry = BeginAtom(&p, ATOM('C','F','H','D'));
+	p = PutZeros(p, 6);
+	p = Put16(p, 1);						// data reference index
+	p = Put16(p, 0);						// version
+	p = Put16(p, 0);						// revision level
+	p = Put32(p, 0);						// vendor
+	p = Put32(p, 0);						// temporal quality
+	p = Put32(p, 0x00000200);				// spatial quality (normal)
+	p = Put16(p, mp4->width);
+	p = Put16(p, mp4->height);
+	p = Put32(p, 0x00480000);				// 72 dpi
+	p = Put32(p, 0x00480000);
+	p = Put32(p, 0);						// data size
+	p = Put16(p, 1);						// frames per sample
+	memset(p, 0, 32);						// compressor name as a Pascal string
+	p[0] = 11;
+	memcpy(p + 1, "CineForm HD", 11);
+	p += 32;
+	p = Put16(p, mp4->depth);
+	p = Put16(p, 0xffff);					// no color table
+	EndAtom(entry, p);
+	EndAtom(stsd, p);
+
+	atom = BeginAtom(&p, ATOM('s','t','t','s'));
+	p = Put32(p, 0);
+	p = Put32(p, 1);
+	p = Put32(p, mp4->count);
+	p = Put32(p, mp4->frameduration);
+	EndAtom(atom, p);
+
+	// Each sample is in its own chunk
+	atom = BeginAtom(&p, ATOM('s','t','s','c'));
+	p = Put32(p, 0);
+	p = Put32(p, 1);
+	p = Put32(p, 1);
+	p = Put32(p, 1);
+	p = Put32(p, 1);
+	EndAtom(atom, p);
+
+	atom = BeginAtom(&p, ATOM('s','t','s','z'));
+	p = Put32(p, 0);
+	p = Put32(p, 0);
+	p = Put32(p, mp4->count);
+	for (i = 0; i < mp4->count; i++) p = Put32(p, mp4->sizes[i]);
+	EndAtom(atom, p);
+
+	atom = BeginAtom(&p, large ? ATOM('c','o','6','4') : ATOM('s','t','c','o'));
+	p = Put32(p, 0);
+	p = Put32(p, mp4->count);
+	for (i = 0; i < mp4->count; i++)
+	{
+		if (large)
+			p = Put64(p, mp4->offsets[i]);
+		else
+			p = Put32(p, (uint32_t)mp4->offsets[i]);
+	}
+	EndAtom(atom, p);
+
+	EndAtom(stbl, p);
+	EndAtom(minf, p);
+	EndAtom(mdia, p);
+	EndAtom(trak, p);
+	EndAtom(moov, p);
+
+	return (uint32_t)(p - buffer);
+}
+
+
+void *OpenMP4Writer(char *filename, uint32_t width, uint32_t height, uint32_t depth, uint32_t timescale, uint32_t frameduration)
+{
+	mp4writer *mp4;
+
+	if (filename == NULL || width == 0 || height == 0 || timescale == 0 || frameduration == 0) return NULL;
+
+	mp4 = (mp4writer *)malloc(sizeof(mp4writer));
+	if (mp4 == NULL) return NULL;
+	memset(mp4, 0, sizeof(mp4writer));
+
+#ifdef _WIN32
+	mp4->file = CreateFileA(filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mp4->file == INVALID_HANDLE_VALUE)
+#else
+	mp4->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (mp4->fd < 0)
+#endif
+	{
+		free(mp4);
+		return NULL;
+	}
+
+	mp4->width = width;
+	mp4->height = height;
+	mp4->depth = depth ? depth : 24;
+	mp4->timescale = timescale;
+	mp4->frameduration = frameduration;
+
+	if (SetMP4WriterOptions(mp4, 0, 0, 0) != 0)
+	{
+		CloseMP4Writer(mp4);
+		return NULL;
+	}
+
+	return mp4;
+}
+
+
+uint32_t SetMP4WriterOptions(void *handle, uint32_t reserve_frames, uint32_t batch_bytes, uint64_t preallocate_bytes)
+{
+	mp4writer *mp4 = (mp4writer *)handle;
+	if (mp4 == NULL || mp4->started) return 1;
+
+	if (batch_bytes == 0) batch_bytes = MP4WRITER_BATCH_BYTES;
+	batch_bytes = (batch_bytes + MP4WRITER_ALIGNMENT - 1) & ~(uint32_t)(MP4WRITER_ALIGNMENT - 1);
+
+	// The free atom that reserves space for the movie header has a 32-bit size
+	if (ReserveSize(reserve_frames) > 0xffffffffULL) return 1;
+
+	if (mp4->batch == NULL || mp4->batch_bytes != batch_bytes)
+	{
+		if (mp4->batch) free(mp4->batch);
+		mp4->batch = (uint8_t *)malloc(batch_bytes);
+		if (mp4->batch == NULL) return 1;
+	}
+
+	mp4->reserve_frames = reserve_frames;
+	mp4->batch_bytes = batch_bytes;
+	mp4->preallocate_bytes = preallocate_bytes ? preallocate_bytes : MP4WRITER_PREALLOCATE_BYTES;
+
+	return 0;
+}
+
+
+uint32_t WriteMP4Sample(void *handle, const void *sample, uint32_t size)
+{
+	mp4writer *mp4 = (mp4writer *)handle;
+	if (mp4 == NULL || mp4->batch == NULL || sample == NULL) return 1;
+
+	if (!mp4->started) Begin(mp4);
+
+	if (mp4->count == mp4->capacity)
+	{
+		uint32_t capacity = mp4->capacity ? mp4->capacity * 2 : 1024;
+		uint32_t *sizes = (uint32_t *)realloc(mp4->sizes, capacity * sizeof(uint32_t));
+		uint64_t *offsets;
+
+		if (sizes == NULL) return 1;
+		mp4->sizes = sizes;
+
+		offsets = (uint64_t *)realloc(mp4->offsets, capacity * sizeof(uint64_t));
+		if (offsets == NULL) return 1;
+		mp4->offsets = offsets;
+
+		mp4->capacity = capacity;
+	}
+
+	mp4->sizes[mp4->count] = size;
+	mp4->offsets[mp4->count] = mp4->flushed + mp4->fill;
+	mp4->count++;
+
+	Append(mp4, (const uint8_t *)sample, size);
+
+	return mp4->error ? 1 : 0;
+}
+
+
+uint32_t CloseMP4Writer(void *handle)
+{
+	mp4writer *mp4 = (mp4writer *)handle;
+	uint32_t result = 0;
+
+	if (mp4 == NULL) return 1;
+
+	if (mp4->batch)
+	{
+		uint8_t *moov = (uint8_t *)malloc((size_t)ReserveSize(mp4->count ? mp4->count : 1));
+		uint64_t end, mdat_size;
+		uint32_t moov_size = 0;
+		uint8_t header[8];
+
+		if (!mp4->started) Begin(mp4);
+
+		end = mp4->flushed + mp4->fill;
+		mdat_size = end - mp4->mdat_offset;
+
+		if (moov)
+		{
+			moov_size = BuildMovieHeader(mp4, moov);
+
+			// Use the reserved space if the movie header fits with room for the free atom that fills the rest of the space
+			if (mp4->reserve_size > 0 && (moov_size == mp4->reserve_size || moov_size + 8 <= mp4->reserve_size))
+			{
+				Flush(mp4);
+				if (WriteAt(mp4, mp4->reserve_offset, moov, moov_size)) mp4->error = 1;
+				if (moov_size < mp4->reserve_size)
+				{
+					Put32(header, (uint32_t)(mp4->reserve_size - moov_size));
+					Put32(header + 4, ATOM('f','r','e','e'));
+					if (WriteAt(mp4, mp4->reserve_offset + moov_size, header, 8)) mp4->error = 1;
+				}
+			}
+			else
+			{
+				Append(mp4, moov, moov_size);
+				end += moov_size;
+				Flush(mp4);
+			}
+			free(moov);
+		}
+		else
+		{
+			Flush(mp4);
+			mp4->error = 1;
+		}
+
+		Put64(header, mdat_size);
+		if (WriteAt(mp4, mp4->mdat_offset + 8, header, 8)) mp4->error = 1;
+
+		// Release the disk space that was allocated past the end of the file
+#ifdef _WIN32
+		{
+			LARGE_INTEGER position;
+			position.QuadPart = (LONGLONG)end;
+			if (!SetFilePointerEx(mp4->file, position, NULL, FILE_BEGIN) || !SetEndOfFile(mp4->file)) mp4->error = 1;
+		}
+#else
+		if (ftruncate(mp4->fd, (off_t)end) != 0) mp4->error = 1;
+#endif
+	}
+	else
+	{
+		mp4->error = 1;
+	}
+
+	result = mp4->error ? 1 : 0;
+
+#ifdef _WIN32
+	CloseHandle(mp4->file);
+#else
+	if (close(mp4->fd) != 0) result = 1;
+#endif
+
+	if (mp4->batch) free(mp4->batch);
+	if (mp4->sizes) free(mp4->sizes);
+	if (mp4->offsets) free(mp4->offsets);
+	free(mp4);
+
+	return result;
+}
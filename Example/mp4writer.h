@@ -0,0 +1,62 @@
+/*! @file mp4writer.h
+*
+*  @brief Minimal MOV writer for CineForm video tracks
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _MP4WRITER_H
+#define _MP4WRITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MP4WRITER_ALIGNMENT			4096			// File offsets and lengths of the batched writes are multiples of this size
+#define MP4WRITER_BATCH_BYTES		(8 << 20)		// Default size of the batched writes
+#define MP4WRITER_PREALLOCATE_BYTES	(512 << 20)		// Default amount of disk space allocated ahead of the samples
+
+/*
+	The writer creates a QuickTime movie with one CineForm video track.  The
+	samples are appended in decode order (the order returned by
+	CFHD_WaitForSample) and are not copied one at a time to the file: small
+	samples are gathered into a batch buffer, and the part of a large sample
+	that starts on an aligned offset is written directly from the caller's
+	buffer, so every write except the last has an aligned offset and length.
+	Disk space is allocated ahead of the samples so that the file system does
+	not have to extend the file on every write.
+
+	The movie header (moov) is written after the samples when the writer is
+	closed, unless space was reserved for it before the samples.  If the movie
+	header does not fit in the reserved space it is written at the end of the
+	file and the reserved space is left as a free atom.
+*/
+
+void *OpenMP4Writer(char *filename, uint32_t width, uint32_t height, uint32_t depth, uint32_t timescale, uint32_t frameduration);
+// Change the layout of the file before the first sample is written (zero for the defaults; returns 0 on success)
+uint32_t SetMP4WriterOptions(void *handle, uint32_t reserve_frames, uint32_t batch_bytes, uint64_t preallocate_bytes);
+// Append the sample to the video track (the sample can be released as soon as the call returns; returns 0 on success)
+uint32_t WriteMP4Sample(void *handle, const void *sample, uint32_t size);
+// Write the remaining samples and the movie header and close the file (returns 0 on success)
+uint32_t CloseMP4Writer(void *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,432 @@
+/*! @file prefetch.cpp
+*
+*  @brief Read the samples in an MP4|MOV|AVI file ahead of the decoder
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <vector>
+#include <queue>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+#include "CFHDError.h"
+#include "Lock.h"
+#include "Condition.h"
+#include "ThreadMessage.h"
+#include "MessageQueue.h"
+#include "ThreadPool.h"
+
+#include "mp4reader.h"
+#include "prefetch.h"
+
+// Buffers are allocated in multiples of this size so that they can be reused for most samples
+#define PREFETCH_BUFFER_ROUNDING	(64 * 1024)
+
+// States of the buffers used to read the samples
+enum
+{
+	PREFETCH_FREE = 0,		// Buffer is not assigned to a sample
+	PREFETCH_PENDING,		// Sample is waiting for an I/O thread
+	PREFETCH_READING,		// Sample is being read by an I/O thread
+	PREFETCH_READY,			// Sample has been read
+	PREFETCH_HELD,			// Sample has been returned to the caller and not released
+};
+
+typedef struct prefetch_slot
+{
+	uint32_t index;			// Sample assigned to the buffer
+	int state;
+	int error;				// Nonzero if the sample could not be read
+	int holds;				// Number of times the sample has been returned and not released
+	uint8_t *buffer;
+	uint32_t capacity;
+	uint32_t size;
+} PREFETCH_SLOT;
+
+typedef struct prefetch_source
+{
+	videoobject *mp4;
+#ifdef _WIN32
+	HANDLE file;
+#else
+	int fd;
+#endif
+	uint32_t count;						// Number of samples in the index
+	uint32_t readahead_frames;
+	uint64_t readahead_bytes;
+	uint32_t current;					// Sample most recently requested by the caller
+	int direction;						// Direction of travel through the file (1 or -1)
+	bool stop;							// Set to stop the I/O threads
+
+	std::vector<PREFETCH_SLOT> slots;
+	std::vector<uint32_t> window;		// Samples in the read-ahead window in the order they are needed
+
+	CSimpleLock lock;					// Controls access to the buffers and the window
+	ConditionVariable request;			// Signaled when a sample is assigned to a buffer
+	ConditionVariable complete;			// Signaled when an I/O thread has read a sample
+
+	std::vector<CThread> threads;
+	uint32_t started;					// Number of I/O threads that were started
+} PREFETCH_SOURCE;
+
+
+// Read the entire sample at the offset in the file without changing the file position
+static int ReadAt(PREFETCH_SOURCE *source, uint64_t offset, uint8_t *buffer, uint32_t length)
+{
+	while (length > 0)
+	{
+#ifdef _WIN32
+		OVERLAPPED overlapped;
+		DWORD count = 0;
+
+		memset(&overlapped, 0, sizeof(overlapped));
+		overlapped.Offset = (DWORD)(offset & 0xffffffff);
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+		if (!ReadFile(source->file, buffer, length, &count, &overlapped) || count == 0) return 1;
+#else
+		ssize_t count = pread(source->fd, buffer, length, (off_t)offset);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) return 1;
+#endif
+		buffer += count;
+		offset += count;
+		length -= (uint32_t)count;
+	}
+	return 0;
+}
+
+
+// Return the buffer that holds the sample (must be called with the lock held)
+static PREFETCH_SLOT *FindSample(PREFETCH_SOURCE *source, uint32_t index)
+{
+	for (size_t i = 0; i < source->slots.size(); i++)
+	{
+		if (source->slots[i].state != PREFETCH_FREE && source->slots[i].index == index) return &source->slots[i];
+	}
+	return NULL;
+}
+
+
+static bool InWindow(PREFETCH_SOURCE *source, uint32_t index)
+{
+	for (size_t i = 0; i < source->window.size(); i++)
+	{
+		if (source->window[i] == index) return true;
+	}
+	return false;
+}
+
+
+// Assign the samples in the window that starts at the current sample to buffers (must be called with the lock held)
+static void ScheduleWindow(PREFETCH_SOURCE *source)
+{
+	uint64_t bytes = 0;
+	size_t i;
+
+	source->window.clear();
+	for (uint32_t k = 0; k <= source->readahead_frames; k++)
+	{
+		int64_t index = (int64_t)source->current + (int64_t)k * source->direction;
+		uint32_t size;
+
+		if (index < 0 || index >= (int64_t)source->count) break;
+
+		size = source->mp4->metasizes[index];
+		if (k > 0)
+		{
+			if (bytes + size > source->readahead_bytes) break;
+			bytes += size;
+		}
+		source->window.push_back((uint32_t)index);
+	}
+
+	// Cancel the requests and drop the samples that are outside the window so the buffers can be reused
+	for (i = 0; i < source->slots.size(); i++)
+	{
+		PREFETCH_SLOT *slot = &source->slots[i];
+		if ((slot->state == PREFETCH_PENDING || slot->state == PREFETCH_READY) && !InWindow(source, slot->index))
+		{
+			slot->state = PREFETCH_FREE;
+		}
+	}
+
+	// The window is shortened if the caller holds more samples than the spare buffers
+	for (i = 0; i < source->window.size(); i++)
+	{
+		PREFETCH_SLOT *slot = NULL;
+		size_t j;
+
+		if (FindSample(source, source->window[i]) != NULL) continue;
+
+		for (j = 0; j < source->slots.size(); j++)
+		{
+			if (source->slots[j].state == PREFETCH_FREE)
+			{
+				slot = &source->slots[j];
+				break;
+			}
+		}
+		if (slot == NULL) break;
+
+		slot->index = source->window[i];
+		slot->state = PREFETCH_PENDING;
+		slot->error = 0;
+		slot->holds = 0;
+		source->request.Wake();
+	}
+}
+
+
+// Return the pending sample that is closest to the current sample (must be called with the lock held)
+static PREFETCH_SLOT *NextRequest(PREFETCH_SOURCE *source)
+{
+	PREFETCH_SLOT *next = NULL;
+	uint32_t distance = UINT32_MAX;
+
+	for (size_t i = 0; i < source->slots.size(); i++)
+	{
+		PREFETCH_SLOT *slot = &source->slots[i];
+		if (slot->state == PREFETCH_PENDING)
+		{
+			uint32_t d = (slot->index > source->current) ? slot->index - source->current : source->current - slot->index;
+			if (d < distance)
+			{
+				next = slot;
+				distance = d;
+			}
+		}
+	}
+	return next;
+}
+
+
+static CThread::ThreadReturnType STDCALL PrefetchThreadProc(void *param)
+{
+	PREFETCH_SOURCE *source = (PREFETCH_SOURCE *)param;
+
+	source->lock.Lock();
+	while (!source->stop)
+	{
+		PREFETCH_SLOT *slot = NextRequest(source);
+		uint64_t offset;
+		uint32_t size;
+		int error = 0;
+
+		if (slot == NULL)
+		{
+			source->request.Wait(source->lock);
+			continue;
+		}
+
+		// The buffer belongs to this thread until the sample has been read
+		slot->state = PREFETCH_READING;
+		offset = source->mp4->metaoffsets[slot->index];
+		size = source->mp4->metasizes[slot->index];
+		source->lock.Unlock();
+
+		if (slot->capacity < size)
+		{
+			uint32_t capacity = (size + PREFETCH_BUFFER_ROUNDING - 1) & ~(PREFETCH_BUFFER_ROUNDING - 1);
+			free(slot->buffer);
+			slot->buffer = (uint8_t *)malloc(capacity);
+			slot->capacity = slot->buffer ? capacity : 0;
+		}
+		error = (slot->buffer == NULL || ReadAt(source, offset, slot->buffer, size) != 0);
+
+		source->lock.Lock();
+		slot->size = size;
+		slot->error = error;
+		slot->state = PREFETCH_READY;
+		source->complete.Wake();
+	}
+	source->lock.Unlock();
+
+	return (CThread::ThreadReturnType)0;
+}
+
+
+void *OpenPrefetchSource(void *handle, uint32_t threads, uint32_t readahead_frames, uint64_t readahead_bytes)
+{
+	videoobject *mp4 = (videoobject *)handle;
+	PREFETCH_SOURCE *source;
+	uint32_t i;
+
+	if (mp4 == NULL || mp4->mediafp == NULL || mp4->metaoffsets == NULL || mp4->metasizes == NULL) return NULL;
+
+	source = new PREFETCH_SOURCE;
+	source->mp4 = mp4;
+#ifdef _WIN32
+	source->file = (HANDLE)_get_osfhandle(_fileno(mp4->mediafp));
+#else
+	source->fd = fileno(mp4->mediafp);
+#endif
+	source->count = (mp4->indexcount < mp4->metasize_count) ? mp4->indexcount : mp4->metasize_count;
+	source->readahead_frames = readahead_frames ? readahead_frames : PREFETCH_READAHEAD_FRAMES;
+	source->readahead_bytes = readahead_bytes ? readahead_bytes : PREFETCH_READAHEAD_BYTES;
+	source->current = 0;
+	source->direction = 1;
+	source->stop = false;
+	source->started = 0;
+
+	// One buffer for each sample in the window and a spare for the sample held by the caller
+	source->slots.resize(source->readahead_frames + 2);
+	for (i = 0; i < source->slots.size(); i++)
+	{
+		memset(&source->slots[i], 0, sizeof(PREFETCH_SLOT));
+	}
+	source->window.reserve(source->readahead_frames + 1);
+
+	if (threads == 0) threads = PREFETCH_THREADS;
+	source->threads.resize(threads);
+	for (i = 0; i < threads; i++)
+	{
+		if (source->threads[i].Start(PrefetchThreadProc, source) != CFHD_ERROR_OKAY) break;
+		source->started++;
+	}
+	if (source->started == 0)
+	{
+		ClosePrefetchSource(source);
+		return NULL;
+	}
+
+	return source;
+}
+
+
+const uint8_t *GetPrefetchedPayload(void *prefetch, uint32_t index, uint32_t *size)
+{
+	PREFETCH_SOURCE *source = (PREFETCH_SOURCE *)prefetch;
+	const uint8_t *sample = NULL;
+	PREFETCH_SLOT *slot;
+
+	if (source == NULL || index >= source->count) return NULL;
+
+	source->lock.Lock();
+
+	// Follow the direction of travel unless the caller has jumped to another part of the file
+	if (index < source->current && source->current - index <= source->readahead_frames) source->direction = -1;
+	if (index > source->current && index - source->current <= source->readahead_frames) source->direction = 1;
+	source->current = index;
+
+	for (;;)
+	{
+		bool reading = false;
+
+		ScheduleWindow(source);
+
+		slot = FindSample(source, index);
+		if (slot && (slot->state == PREFETCH_READY || slot->state == PREFETCH_HELD)) break;
+
+		for (size_t i = 0; i < source->slots.size(); i++)
+		{
+			if (source->slots[i].state == PREFETCH_READING) reading = true;
+		}
+
+		// Every buffer is held by the caller
+		if (slot == NULL && !reading)
+		{
+			source->lock.Unlock();
+			return NULL;
+		}
+
+		source->complete.Wait(source->lock);
+	}
+
+	if (slot->error)
+	{
+		// Read the sample again if it is requested again
+		if (slot->holds == 0) slot->state = PREFETCH_FREE;
+	}
+	else
+	{
+		slot->state = PREFETCH_HELD;
+		slot->holds++;
+		if (size) *size = slot->size;
+		sample = slot->buffer;
+	}
+
+	source->lock.Unlock();
+
+	return sample;
+}
+
+
+void ReleasePrefetchedPayload(void *prefetch, const void *sample)
+{
+	PREFETCH_SOURCE *source = (PREFETCH_SOURCE *)prefetch;
+	if (source == NULL || sample == NULL) return;
+
+	source->lock.Lock();
+	for (size_t i = 0; i < source->slots.size(); i++)
+	{
+		PREFETCH_SLOT *slot = &source->slots[i];
+		if (slot->state == PREFETCH_HELD && slot->buffer == sample)
+		{
+			if (--slot->holds == 0) slot->state = PREFETCH_READY;
+
+			// Use the buffer for the next sample in the window if the window was shortened
+			ScheduleWindow(source);
+			break;
+		}
+	}
+	source->lock.Unlock();
+}
+
+
+void ClosePrefetchSource(void *prefetch)
+{
+	PREFETCH_SOURCE *source = (PREFETCH_SOURCE *)prefetch;
+	uint32_t i;
+
+	if (source == NULL) return;
+
+	source->lock.Lock();
+	source->stop = true;
+	for (i = 0; i < source->started; i++)
+	{
+		source->request.Wake();
+	}
+	source->lock.Unlock();
+
+	for (i = 0; i < source->started; i++)
+	{
+		source->threads[i].Wait();
+	}
+
+	for (i = 0; i < source->slots.size(); i++)
+	{
+		free(source->slots[i].buffer);
+	}
+
+	delete source;
+}
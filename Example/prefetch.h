@@ -0,0 +1,61 @@
+/*! @file prefetch.h
+*
+*  @brief Read the samples in an MP4|MOV|AVI file ahead of the decoder
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _PREFETCH_H
+#define _PREFETCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PREFETCH_THREADS			2				// Default number of I/O threads
+#define PREFETCH_READAHEAD_FRAMES	8				// Default number of samples read ahead of the current sample
+#define PREFETCH_READAHEAD_BYTES	(64 << 20)		// Default limit on the bytes read ahead of the current sample
+
+/*
+	The prefetcher uses the sample index of a source opened by OpenMP4Source or
+	OpenAVISource and reads the samples that follow the current sample on a pool
+	of I/O threads while the caller decodes the current sample.  The samples are
+	read in the direction of travel, so stepping backwards through the file (for
+	example when scrubbing) reads the samples before the current sample.  A jump
+	of more than the read-ahead window is treated as a seek and keeps the last
+	direction of travel.
+
+	The read-ahead window is limited by a number of samples and a number of bytes
+	(the current sample is always read).  Each sample is read into one of a fixed
+	set of buffers that are reused for the later samples, so the memory used is
+	bounded by the window and the largest sample in the file.
+*/
+
+// Start reading samples from the source on I/O threads (zero for the defaults)
+void *OpenPrefetchSource(void *handle, uint32_t threads, uint32_t readahead_frames, uint64_t readahead_bytes);
+// Wait for the sample to be read and return it (the sample must be released before the buffer can be reused)
+const uint8_t *GetPrefetchedPayload(void *prefetch, uint32_t index, uint32_t *size);
+void ReleasePrefetchedPayload(void *prefetch, const void *sample);
+// Stop the I/O threads and free the buffers (the source must be closed separately)
+void ClosePrefetchSource(void *prefetch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,354 @@
+/*! @file TestConversion.cpp
+
+*  @brief Conformance test of the pixel converter against the hand-written conversions and the decoder
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+/*
+	The test image is a set of smooth RGB gradients with a strip of saturated
+	colors on the left edge.  The test checks that:
+
+	1.	Every supported pixel format survives a round trip from RG48 within the
+		precision of the format and its chroma subsampling.
+
+	2.	Converting with several worker threads gives the same result as one
+		thread, and converting a format to itself does not change the pixels.
+
+	3.	The pixel converter matches the hand-written ConvertLib routines that
+		ConvertToOutputBuffer still uses for YU64 to b64a and av28.
+
+	4.	Decoding a sample directly to each output format matches decoding the
+		sample to YU64 or RG48 and converting the result with the converter,
+		which is how the decoder produces the formats it cannot decode itself.
+
+	Two images are compared by converting both to 16-bit YUV or RGB with the
+	converter and taking the largest difference of any component.  The test
+	prints one line for each comparison and exits with a non-zero status if
+	any comparison is outside its tolerance.
+*/
+
+#include "StdAfx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+#ifndef ASSERT
+#define ASSERT(x)	assert(x)
+#endif
+
+#include "TestUtils.h"
+
+// Dimensions of the image used to test the converter (not a multiple of the block sizes or strip height)
+#define CONVERT_WIDTH			392
+#define CONVERT_HEIGHT			70
+
+// Dimensions of the frame encoded to test the decoder
+#define DECODE_WIDTH			1280
+#define DECODE_HEIGHT			720
+
+// Width of the strip of saturated colors on the left edge of the test image
+#define SATURATED_WIDTH			24
+
+static const TEST_FORMAT TestFormats[] =
+{
+	{CFHD_PIXEL_FORMAT_BGRA,			false},
+	{CFHD_PIXEL_FORMAT_BGRa,			false},
+	{CFHD_PIXEL_FORMAT_RG24,			false},
+	{CFHD_PIXEL_FORMAT_2VUY,			true},
+	{CFHD_PIXEL_FORMAT_YUY2,			true},
+	{CFHD_PIXEL_FORMAT_YUYV,			true},
+	{CFHD_PIXEL_FORMAT_B64A,			false},
+	{CFHD_PIXEL_FORMAT_RG48,			false},
+	{CFHD_PIXEL_FORMAT_B48R,			false},
+	{CFHD_PIXEL_FORMAT_RG64,			false},
+	{CFHD_PIXEL_FORMAT_YU64,			true},
+	{CFHD_PIXEL_FORMAT_V210,			true},
+	{CFHD_PIXEL_FORMAT_RG30,			false},
+	{CFHD_PIXEL_FORMAT_AB10,			false},
+	{CFHD_PIXEL_FORMAT_AR10,			false},
+	{CFHD_PIXEL_FORMAT_R210,			false},
+	{CFHD_PIXEL_FORMAT_DPX0,			false},
+	{CFHD_PIXEL_FORMAT_NV12,			true},
+	{CFHD_PIXEL_FORMAT_YV12,			true},
+	{CFHD_PIXEL_FORMAT_R408,			true},
+	{CFHD_PIXEL_FORMAT_V408,			true},
+	{CFHD_PIXEL_FORMAT_WP13,			false},
+	{CFHD_PIXEL_FORMAT_W13A,			false},
+	{CFHD_PIXEL_FORMAT_CT_UCHAR,		true},
+	{CFHD_PIXEL_FORMAT_CT_10BIT_2_8,	true},
+	{CFHD_PIXEL_FORMAT_CT_SHORT_2_14,	true},
+	{CFHD_PIXEL_FORMAT_CT_USHORT_10_6,	true},
+	{CFHD_PIXEL_FORMAT_CT_SHORT,		true},
+	{CFHD_PIXEL_FORMAT_UNKNOWN,			false}
+};
+
+static bool ReportResult(const char *name, CFHD_PixelFormat format, int difference, int tolerance)
+{
+	bool okay = (difference <= tolerance);
+	printf("%-36s %c%c%c%c  max difference %5d (tolerance %5d) %s\n",
+		   name, PRINTF_PIXELFORMAT(format), difference, tolerance, okay ? "ok" : "FAILED");
+	return okay;
+}
+
+// Convert the test image to each format and back to RG48
+static int TestRoundTrips(const std::vector<uint16_t> &image, int width, int height)
+{
+	CPixelConverter converter;
+	std::vector<uint16_t> result(width * height * 3);
+	int failures = 0;
+
+	for (const TEST_FORMAT *test = TestFormats; test->format != CFHD_PIXEL_FORMAT_UNKNOWN; test++)
+	{
+		const size_t pitch = ImagePitch(width, test->format);
+		std::vector<uint8_t> buffer(ImageSize(width, height, test->format));
+
+		if (!converter.Convert((void *)&image[0], width * 6, CFHD_PIXEL_FORMAT_RG48,
+							   &buffer[0], pitch, test->format, width, height) ||
+			!converter.Convert(&buffer[0], pitch, test->format,
+							   &result[0], width * 6, CFHD_PIXEL_FORMAT_RG48, width, height))
+		{
+			printf("Could not convert between RG48 and %c%c%c%c\n", PRINTF_PIXELFORMAT(test->format));
+			failures++;
+			continue;
+		}
+
+		// The saturated colors are not checked since the chroma is subsampled across the edge of the strip
+		int max_difference = 0;
+		for (int row = 0; row < height; row++)
+		{
+			for (int index = SATURATED_WIDTH * 3; index < width * 3; index++)
+			{
+				int difference = abs((int)result[row * width * 3 + index] - (int)image[row * width * 3 + index]);
+				if (max_difference < difference) {
+					max_difference = difference;
+				}
+			}
+		}
+
+		// Tolerance for 8-bit components and chroma subsampling of the gradients
+		const int tolerance = test->yuv ? 3500 : 260;
+
+		if (!ReportResult("Round trip from RG48", test->format, max_difference, tolerance)) {
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+// Compare conversions with several threads and with one thread, and conversions to the same format
+static int TestThreadsAndIdentity(const std::vector<uint16_t> &image, int width, int height)
+{
+	CPixelConverter converter1;
+	CPixelConverter converter4;
+	int failures = 0;
+
+	converter1.mailbox.cpus = 1;
+	converter4.mailbox.cpus = 4;
+
+	for (const TEST_FORMAT *test = TestFormats; test->format != CFHD_PIXEL_FORMAT_UNKNOWN; test++)
+	{
+		const size_t pitch = ImagePitch(width, test->format);
+		const size_t size = ImageSize(width, height, test->format);
+		std::vector<uint8_t> single(size), threaded(size), identity(size);
+
+		converter1.Convert((void *)&image[0], width * 6, CFHD_PIXEL_FORMAT_RG48, &single[0], pitch, test->format, width, height);
+		converter4.Convert((void *)&image[0], width * 6, CFHD_PIXEL_FORMAT_RG48, &threaded[0], pitch, test->format, width, height);
+		converter1.Convert(&single[0], pitch, test->format, &identity[0], pitch, test->format, width, height);
+
+		if (memcmp(&single[0], &threaded[0], size) != 0)
+		{
+			printf("Threaded conversion to %c%c%c%c differs from one thread  FAILED\n", PRINTF_PIXELFORMAT(test->format));
+			failures++;
+		}
+
+		// The 4:2:0 and av28 planes and the a214 fixed point values are not copied bit for bit
+		switch (test->format)
+		{
+		case CFHD_PIXEL_FORMAT_NV12:
+		case CFHD_PIXEL_FORMAT_YV12:
+		case CFHD_PIXEL_FORMAT_CT_10BIT_2_8:
+			break;
+
+		case CFHD_PIXEL_FORMAT_CT_SHORT_2_14:
+			if (!ReportResult("Identity conversion", test->format,
+							  CompareImages(converter1, test, width, height, 0, width, &single[0], &identity[0]), 300)) {
+				failures++;
+			}
+			break;
+
+		default:
+			if (memcmp(&single[0], &identity[0], pitch * height) != 0)
+			{
+				printf("Identity conversion of %c%c%c%c changed the pixels  FAILED\n", PRINTF_PIXELFORMAT(test->format));
+				failures++;
+			}
+			break;
+		}
+	}
+
+	printf("Threaded and identity conversions checked\n");
+	return failures;
+}
+
+// Compare the converter with the hand-written routines that are used instead of the converter
+static int TestHandWrittenRoutines(const std::vector<uint16_t> &image, int width, int height)
+{
+	static const TEST_FORMAT b64a = {CFHD_PIXEL_FORMAT_B64A, false};
+	CPixelConverter converter(COLOR_FLAGS_CS_709);
+	std::vector<uint16_t> yu64(width * height * 2);
+	int failures = 0;
+
+	converter.Convert((void *)&image[0], width * 6, CFHD_PIXEL_FORMAT_RG48,
+					  &yu64[0], width * 4, CFHD_PIXEL_FORMAT_YU64, width, height);
+
+	// The dedicated conversion to b64a uses the 709 color space with 8-bit precision in the matrix
+	// and clamps the components a little below full scale, so the saturated colors are not compared
+	// and the tolerance allows four 8-bit codes near full scale
+	{
+		const int first_column = SATURATED_WIDTH + 8;
+		std::vector<uint16_t> routine(width * height * 4), converted(width * height * 4);
+		CImageConverterYU64ToRGB image_converter(true, false);
+
+		image_converter.ConvertToBGRA64((unsigned char *)&yu64[0], width * 4,
+										(unsigned char *)&routine[0], width * 8, width, height, 0);
+		converter.Convert(&yu64[0], width * 4, CFHD_PIXEL_FORMAT_YU64,
+						  &converted[0], width * 8, CFHD_PIXEL_FORMAT_B64A, width, height);
+
+		if (!ReportResult("Hand-written YU64 conversion", CFHD_PIXEL_FORMAT_B64A,
+						  CompareImages(converter, &b64a, width, height, first_column, width, &routine[0], &converted[0]), 1024)) {
+			failures++;
+		}
+	}
+
+	// The conversion to av28 only repacks the components so it must be exact
+	{
+		const size_t size = width * height * 5 / 2;
+		std::vector<uint8_t> routine(size), converted(size);
+		CImageConverterYU64ToYUV image_converter;
+
+		image_converter.ConvertToAvid_CbYCrY_10bit_2_8((uint8_t *)&yu64[0], width * 4, &routine[0], width * 2, width, height);
+		converter.Convert(&yu64[0], width * 4, CFHD_PIXEL_FORMAT_YU64,
+						  &converted[0], width * 2, CFHD_PIXEL_FORMAT_CT_10BIT_2_8, width, height);
+
+		if (!ReportResult("Hand-written YU64 conversion", CFHD_PIXEL_FORMAT_CT_10BIT_2_8,
+						  (memcmp(&routine[0], &converted[0], size) == 0) ? 0 : 1, 0)) {
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+// Compare decoding to each format with decoding to the codec format and converting
+static int TestDecodedFormats(const std::vector<uint16_t> &image, int width, int height)
+{
+	static const CFHD_EncodedFormat EncodedFormats[] = {CFHD_ENCODED_FORMAT_YUV_422, CFHD_ENCODED_FORMAT_RGB_444};
+	CPixelConverter converter;
+	int failures = 0;
+
+	// The decoder and the converter filter the chroma differently across the edge of the saturated colors,
+	// and the decoder routines that output YUV from RGB samples do not filter the last columns the same way
+	const int first_column = SATURATED_WIDTH + 8;
+	const int last_column = width - 8;
+
+	for (size_t index = 0; index < sizeof(EncodedFormats) / sizeof(EncodedFormats[0]); index++)
+	{
+		const CFHD_EncodedFormat encoded_format = EncodedFormats[index];
+		const bool encoded_yuv = (encoded_format == CFHD_ENCODED_FORMAT_YUV_422);
+		const CFHD_PixelFormat reference_format = encoded_yuv ? CFHD_PIXEL_FORMAT_YU64 : CFHD_PIXEL_FORMAT_RG48;
+		CFHD_EncoderRef encoder = NULL;
+		void *sample = NULL;
+		size_t size = 0;
+
+		if (EncodeTestImage(image, width, height, encoded_format, &encoder, &sample, &size) != CFHD_ERROR_OKAY)
+		{
+			printf("Could not encode the test image\n");
+			failures++;
+			continue;
+		}
+
+		std::vector<uint8_t> reference(ImageSize(width, height, reference_format));
+		if (DecodeToFormat(sample, size, reference_format, 0, 0, &reference[0], ImagePitch(width, reference_format)) != CFHD_ERROR_OKAY)
+		{
+			printf("Could not decode the sample to %c%c%c%c\n", PRINTF_PIXELFORMAT(reference_format));
+			CFHD_CloseEncoder(encoder);
+			failures++;
+			continue;
+		}
+
+		for (const TEST_FORMAT *test = TestFormats; test->format != CFHD_PIXEL_FORMAT_UNKNOWN; test++)
+		{
+			const size_t pitch = ImagePitch(width, test->format);
+			std::vector<uint8_t> decoded(ImageSize(width, height, test->format));
+			std::vector<uint8_t> converted(ImageSize(width, height, test->format));
+
+			// The decoder writes Cr before Cb in the Avid 16-bit formats, the reverse of the encoder
+			// and the 8-bit and 10-bit Avid formats, so these formats are not compared
+			if (test->format == CFHD_PIXEL_FORMAT_CT_SHORT_2_14 ||
+				test->format == CFHD_PIXEL_FORMAT_CT_USHORT_10_6 ||
+				test->format == CFHD_PIXEL_FORMAT_CT_SHORT) {
+				continue;
+			}
+
+			// Formats that the decoder does not output are not compared
+			if (DecodeToFormat(sample, size, test->format, 0, 0, &decoded[0], pitch) != CFHD_ERROR_OKAY) {
+				continue;
+			}
+
+			converter.Convert(&reference[0], ImagePitch(width, reference_format), reference_format,
+							  &converted[0], pitch, test->format, width, height);
+
+			// Allow three 8-bit codes for the rounding in the decoder output routines and
+			// more for the color conversion when the output is not in the encoded color space
+			const int tolerance = (test->yuv == encoded_yuv) ? 800 : 1600;
+			char name[64];
+			sprintf(name, "Decoded %s sample", encoded_yuv ? "4:2:2" : "4:4:4");
+
+			if (!ReportResult(name, test->format,
+							  CompareImages(converter, test, width, height, first_column, last_column,
+											&decoded[0], &converted[0]), tolerance)) {
+				failures++;
+			}
+		}
+
+		CFHD_CloseEncoder(encoder);
+	}
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<uint16_t> image;
+	int failures = 0;
+
+	MakeTestImage(image, CONVERT_WIDTH, CONVERT_HEIGHT, SATURATED_WIDTH, 0);
+	failures += TestRoundTrips(image, CONVERT_WIDTH, CONVERT_HEIGHT);
+	failures += TestThreadsAndIdentity(image, CONVERT_WIDTH, CONVERT_HEIGHT);
+	failures += TestHandWrittenRoutines(image, CONVERT_WIDTH, CONVERT_HEIGHT);
+
+	MakeTestImage(image, DECODE_WIDTH, DECODE_HEIGHT, SATURATED_WIDTH, 0);
+	failures += TestDecodedFormats(image, DECODE_WIDTH, DECODE_HEIGHT);
+
+	printf("%d failures\n", failures);
+	return (failures == 0) ? 0 : 1;
+}
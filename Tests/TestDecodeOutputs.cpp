@@ -0,0 +1,236 @@
+/*! @file TestDecodeOutputs.cpp
+
+*  @brief Test of decoding one sample into several output images
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+/*
+	The test encodes a frame of gradients and fine detail as a YUV 4:2:2 and
+	an RGB 4:4:4 sample, decodes each sample into several output images with
+	CFHD_DecodeSampleOutputs, and compares each output image with a decoder
+	that was prepared for that output image alone.
+
+	An output image with the same pixel format as the first output image is
+	decoded in the same decoded format, so it must be identical to the single
+	output decode at full, half, and quarter resolution.  This checks that the
+	smaller output images are taken from the lowpass bands and not scaled down
+	from the decoded frame.  The full resolution inverse transform rounds 8-bit
+	pixels with random values, so those may differ by one code.  An output
+	image in another pixel format is
+	converted from the decoded format of the first output image, so it is
+	compared within the tolerance used by the conversion test.
+*/
+
+#include "StdAfx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+#ifndef ASSERT
+#define ASSERT(x)	assert(x)
+#endif
+
+#include "TestUtils.h"
+
+// Dimensions of the encoded frame
+#define DECODE_WIDTH			1280
+#define DECODE_HEIGHT			720
+
+// Amplitude of the fine detail added to the test image for the highpass bands
+#define DETAIL_AMPLITUDE	4096
+
+// Number of output images decoded from each sample
+#define OUTPUT_COUNT		5
+
+typedef struct
+{
+	CFHD_EncodedFormat encoded_format;
+	CFHD_DecodedResolution resolution;	// Resolution of the first output image
+	TEST_FORMAT primary;				// Pixel format of the first output image
+	TEST_FORMAT other;					// Pixel format of the output images in another format
+	bool dithered;						// The first output image is rounded with random values at full resolution
+
+} TEST_CASE;
+
+static const TEST_CASE TestCases[] =
+{
+	{CFHD_ENCODED_FORMAT_YUV_422, CFHD_DECODED_RESOLUTION_FULL, {CFHD_PIXEL_FORMAT_YU64, true}, {CFHD_PIXEL_FORMAT_B64A, false}, false},
+	{CFHD_ENCODED_FORMAT_YUV_422, CFHD_DECODED_RESOLUTION_FULL, {CFHD_PIXEL_FORMAT_2VUY, true}, {CFHD_PIXEL_FORMAT_V210, true}, true},
+	{CFHD_ENCODED_FORMAT_YUV_422, CFHD_DECODED_RESOLUTION_HALF, {CFHD_PIXEL_FORMAT_BGRA, false}, {CFHD_PIXEL_FORMAT_YUY2, true}, false},
+	{CFHD_ENCODED_FORMAT_RGB_444, CFHD_DECODED_RESOLUTION_FULL, {CFHD_PIXEL_FORMAT_RG48, false}, {CFHD_PIXEL_FORMAT_YU64, true}, false},
+	{CFHD_ENCODED_FORMAT_RGB_444, CFHD_DECODED_RESOLUTION_FULL, {CFHD_PIXEL_FORMAT_B64A, false}, {CFHD_PIXEL_FORMAT_R210, false}, false},
+	{CFHD_ENCODED_FORMAT_RGB_444, CFHD_DECODED_RESOLUTION_HALF, {CFHD_PIXEL_FORMAT_DPX0, false}, {CFHD_PIXEL_FORMAT_BGRA, false}, false},
+};
+
+// Return the output dimensions for the decoded resolution
+static void ResolutionDimensions(CFHD_DecodedResolution resolution, int *width, int *height)
+{
+	int scale = (resolution == CFHD_DECODED_RESOLUTION_QUARTER) ? 4 :
+				(resolution == CFHD_DECODED_RESOLUTION_HALF) ? 2 : 1;
+
+	*width = DECODE_WIDTH / scale;
+	*height = DECODE_HEIGHT / scale;
+}
+
+// Decode the sample into several output images and compare each image with a single output decode
+static int TestOutputs(const TEST_CASE *test, void *sample, size_t size)
+{
+	CPixelConverter converter;
+	CFHD_OutputDescriptor outputs[OUTPUT_COUNT];
+	const TEST_FORMAT *output_formats[OUTPUT_COUNT];
+	CFHD_DecodedResolution output_resolutions[OUTPUT_COUNT];
+	std::vector<uint8_t> buffers[OUTPUT_COUNT];
+	int failures = 0;
+
+	// The first output image followed by the smaller resolutions in the same and the other format
+	int count = 0;
+	output_formats[count] = &test->primary;
+	output_resolutions[count++] = test->resolution;
+
+	output_formats[count] = &test->other;
+	output_resolutions[count++] = test->resolution;
+
+	if (test->resolution == CFHD_DECODED_RESOLUTION_FULL)
+	{
+		output_formats[count] = &test->primary;
+		output_resolutions[count++] = CFHD_DECODED_RESOLUTION_HALF;
+	}
+
+	output_formats[count] = &test->primary;
+	output_resolutions[count++] = CFHD_DECODED_RESOLUTION_QUARTER;
+
+	output_formats[count] = &test->other;
+	output_resolutions[count++] = CFHD_DECODED_RESOLUTION_QUARTER;
+
+	for (int index = 0; index < count; index++)
+	{
+		int width;
+		int height;
+
+		ResolutionDimensions(output_resolutions[index], &width, &height);
+
+		outputs[index].pixelFormat = output_formats[index]->format;
+		outputs[index].width = width;
+		outputs[index].height = height;
+		outputs[index].pitch = (int32_t)ImagePitch(width, output_formats[index]->format);
+
+		buffers[index].resize(outputs[index].pitch * height);
+		outputs[index].buffer = &buffers[index][0];
+	}
+
+	CFHD_DecoderRef decoder = NULL;
+	CFHD_PixelFormat actual_format;
+	int actual_width;
+	int actual_height;
+	CFHD_Error error = CFHD_OpenDecoder(&decoder, NULL);
+
+	if (error == CFHD_ERROR_OKAY) {
+		error = CFHD_PrepareToDecode(decoder, outputs[0].width, outputs[0].height, outputs[0].pixelFormat,
+									 CFHD_DECODED_RESOLUTION_FULL, 0, sample, size,
+									 &actual_width, &actual_height, &actual_format);
+	}
+
+	// Decode twice to check that the buffers kept by the decoder are reused correctly
+	for (int pass = 0; pass < 2 && error == CFHD_ERROR_OKAY; pass++) {
+		error = CFHD_DecodeSampleOutputs(decoder, sample, size, outputs, count);
+	}
+
+	if (decoder) {
+		CFHD_CloseDecoder(decoder);
+	}
+
+	if (error != CFHD_ERROR_OKAY)
+	{
+		printf("Could not decode the sample into %d outputs: %d\n", count, error);
+		return 1;
+	}
+
+	for (int index = 0; index < count; index++)
+	{
+		const TEST_FORMAT *format = output_formats[index];
+		std::vector<uint8_t> single(outputs[index].pitch * outputs[index].height);
+
+		if (DecodeToFormat(sample, size, format->format, outputs[index].width, outputs[index].height,
+						   &single[0], outputs[index].pitch) != CFHD_ERROR_OKAY)
+		{
+			printf("Could not decode the sample to %c%c%c%c\n", PRINTF_PIXELFORMAT(format->format));
+			failures++;
+			continue;
+		}
+
+		// Same tolerances as the conversion test for the formats converted from the first output format
+		int tolerance = 0;
+		if (format != &test->primary) {
+			tolerance = (format->yuv == test->primary.yuv) ? 800 : 1600;
+		}
+		else if (test->dithered && outputs[index].width == DECODE_WIDTH) {
+			// Two decodes can differ by one 8-bit code
+			tolerance = 256;
+		}
+
+		// The edge columns are filtered differently at each resolution
+		int difference = CompareImages(converter, format, outputs[index].width, outputs[index].height,
+									   8, outputs[index].width - 8, outputs[index].buffer, &single[0]);
+		bool okay = (difference <= tolerance);
+
+		printf("%s %c%c%c%c %4dx%-4d from %c%c%c%c  max difference %5d (tolerance %5d) %s\n",
+			   (test->encoded_format == CFHD_ENCODED_FORMAT_YUV_422) ? "4:2:2" : "4:4:4",
+			   PRINTF_PIXELFORMAT(format->format), outputs[index].width, outputs[index].height,
+			   PRINTF_PIXELFORMAT(test->primary.format), difference, tolerance, okay ? "ok" : "FAILED");
+
+		if (!okay) {
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<uint16_t> image;
+	int failures = 0;
+
+	MakeTestImage(image, DECODE_WIDTH, DECODE_HEIGHT, 0, DETAIL_AMPLITUDE);
+
+	for (size_t index = 0; index < sizeof(TestCases) / sizeof(TestCases[0]); index++)
+	{
+		const TEST_CASE *test = &TestCases[index];
+		CFHD_EncoderRef encoder = NULL;
+		void *sample = NULL;
+		size_t size = 0;
+
+		if (EncodeTestImage(image, DECODE_WIDTH, DECODE_HEIGHT, test->encoded_format,
+							&encoder, &sample, &size) != CFHD_ERROR_OKAY)
+		{
+			printf("Could not encode the test image\n");
+			failures++;
+			continue;
+		}
+
+		failures += TestOutputs(test, sample, size);
+
+		CFHD_CloseEncoder(encoder);
+	}
+
+	printf("%d failures\n", failures);
+	return (failures == 0) ? 0 : 1;
+}
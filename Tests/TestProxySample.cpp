@@ -0,0 +1,182 @@
+/*! @file TestProxySample.cpp
+
+*  @brief Test of the proxy samples created by dropping the highpass bands
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+/*
+	The test encodes a frame of gradients and fine detail as a YUV 4:2:2 and
+	an RGB 4:4:4 sample and creates a half and a quarter resolution proxy of
+	each sample with CFHD_GetProxySample.  The proxy must be smaller than the
+	sample, pass CFHD_ValidateSample, and decode to the same image as the
+	sample at the resolution of the proxy and at every lower resolution.
+
+	The images are decoded in a 16-bit format so that the rounding of the
+	8-bit formats does not hide a difference in the decoded bands.
+*/
+
+#include "StdAfx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+#ifndef ASSERT
+#define ASSERT(x)	assert(x)
+#endif
+
+#include "TestUtils.h"
+
+// Dimensions of the encoded frame
+#define DECODE_WIDTH			1280
+#define DECODE_HEIGHT			720
+
+// Amplitude of the fine detail added to the test image for the highpass bands
+#define DETAIL_AMPLITUDE	4096
+
+typedef struct
+{
+	CFHD_EncodedFormat encoded_format;
+	CFHD_PixelFormat decoded_format;	// Pixel format used to compare the decoded images
+
+} TEST_CASE;
+
+static const TEST_CASE TestCases[] =
+{
+	{CFHD_ENCODED_FORMAT_YUV_422, CFHD_PIXEL_FORMAT_YU64},
+	{CFHD_ENCODED_FORMAT_RGB_444, CFHD_PIXEL_FORMAT_RG48},
+};
+
+// Return the reduction in each dimension for the decoded resolution
+static int ResolutionScale(CFHD_DecodedResolution resolution)
+{
+	return (resolution == CFHD_DECODED_RESOLUTION_QUARTER) ? 4 :
+		   (resolution == CFHD_DECODED_RESOLUTION_HALF) ? 2 : 1;
+}
+
+// Create a proxy of the sample and compare the decoded proxy with the decoded sample
+static int TestProxy(const TEST_CASE *test, void *sample, size_t size, CFHD_DecodedResolution resolution)
+{
+	static const CFHD_DecodedResolution DecodedResolutions[] =
+	{
+		CFHD_DECODED_RESOLUTION_HALF,
+		CFHD_DECODED_RESOLUTION_QUARTER
+	};
+
+	const char *encoded_name = (test->encoded_format == CFHD_ENCODED_FORMAT_YUV_422) ? "4:2:2" : "4:4:4";
+	std::vector<uint8_t> proxy(size);
+	size_t proxy_size = 0;
+	int failures = 0;
+
+	CFHD_DecoderRef decoder = NULL;
+	CFHD_Error error = CFHD_OpenDecoder(&decoder, NULL);
+
+	if (error == CFHD_ERROR_OKAY) {
+		error = CFHD_GetProxySample(decoder, sample, size, resolution, &proxy[0], proxy.size(), &proxy_size);
+	}
+
+	if (error != CFHD_ERROR_OKAY)
+	{
+		printf("Could not create the 1/%d resolution proxy of the %s sample: %d  FAILED\n",
+			   ResolutionScale(resolution), encoded_name, error);
+		if (decoder) CFHD_CloseDecoder(decoder);
+		return 1;
+	}
+
+	// The proxy must be a well formed sample that is smaller than the sample
+	CFHD_Error validate_error = CFHD_ValidateSample(decoder, &proxy[0], proxy_size, CFHD_VALIDATE_FLAGS_NONE, NULL);
+	bool okay = (validate_error == CFHD_ERROR_OKAY && proxy_size < size);
+
+	printf("%s 1/%d resolution proxy  size %7d of %7d  validate %d %s\n",
+		   encoded_name, ResolutionScale(resolution), (int)proxy_size, (int)size, validate_error, okay ? "ok" : "FAILED");
+
+	if (!okay) {
+		failures++;
+	}
+
+	CFHD_CloseDecoder(decoder);
+
+	// Decode the proxy at its resolution and at each lower resolution
+	for (size_t index = 0; index < sizeof(DecodedResolutions) / sizeof(DecodedResolutions[0]); index++)
+	{
+		const int scale = ResolutionScale(DecodedResolutions[index]);
+		if (scale < ResolutionScale(resolution)) {
+			continue;
+		}
+
+		const int width = DECODE_WIDTH / scale;
+		const int height = DECODE_HEIGHT / scale;
+		const size_t pitch = ImagePitch(width, test->decoded_format);
+		std::vector<uint8_t> decoded_sample(pitch * height);
+		std::vector<uint8_t> decoded_proxy(pitch * height);
+
+		if (DecodeToFormat(sample, size, test->decoded_format, width, height, &decoded_sample[0], pitch) != CFHD_ERROR_OKAY ||
+			DecodeToFormat(&proxy[0], proxy_size, test->decoded_format, width, height, &decoded_proxy[0], pitch) != CFHD_ERROR_OKAY)
+		{
+			printf("Could not decode the sample and the proxy at %dx%d  FAILED\n", width, height);
+			failures++;
+			continue;
+		}
+
+		okay = (memcmp(&decoded_sample[0], &decoded_proxy[0], pitch * height) == 0);
+
+		printf("%s 1/%d resolution proxy  decoded %c%c%c%c %4dx%-4d %s\n",
+			   encoded_name, ResolutionScale(resolution), PRINTF_PIXELFORMAT(test->decoded_format),
+			   width, height, okay ? "identical ok" : "differs FAILED");
+
+		if (!okay) {
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<uint16_t> image;
+	int failures = 0;
+
+	MakeTestImage(image, DECODE_WIDTH, DECODE_HEIGHT, 0, DETAIL_AMPLITUDE);
+
+	for (size_t index = 0; index < sizeof(TestCases) / sizeof(TestCases[0]); index++)
+	{
+		const TEST_CASE *test = &TestCases[index];
+		CFHD_EncoderRef encoder = NULL;
+		void *sample = NULL;
+		size_t size = 0;
+
+		if (EncodeTestImage(image, DECODE_WIDTH, DECODE_HEIGHT, test->encoded_format,
+							&encoder, &sample, &size) != CFHD_ERROR_OKAY)
+		{
+			printf("Could not encode the test image\n");
+			failures++;
+			continue;
+		}
+
+		failures += TestProxy(test, sample, size, CFHD_DECODED_RESOLUTION_HALF);
+		failures += TestProxy(test, sample, size, CFHD_DECODED_RESOLUTION_QUARTER);
+
+		CFHD_CloseEncoder(encoder);
+	}
+
+	printf("%d failures\n", failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+/*! @file TestUtils.h
+
+*  @brief Test images, image comparison, and decoding routines shared by the tests
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "CFHDDecoder.h"
+#include "CFHDEncoder.h"
+#include "ConvertLib.h"
+
+#define PRINTF_PIXELFORMAT(k)	((k) >> 24) & 0xff, ((k) >> 16) & 0xff, ((k) >> 8) & 0xff, ((k) >> 0) & 0xff
+
+typedef struct
+{
+	CFHD_PixelFormat format;
+	bool yuv;				// Compared as YUV instead of RGB
+
+} TEST_FORMAT;
+
+// Return the pitch of an image in the pixel format (the planar formats use the pitch of the luma plane)
+static inline size_t ImagePitch(int width, CFHD_PixelFormat format)
+{
+	int32_t pitch = 0;
+
+	switch (format)
+	{
+	case CFHD_PIXEL_FORMAT_V210:
+		return ((width + 47) / 48) * 128;
+
+	case CFHD_PIXEL_FORMAT_NV12:
+	case CFHD_PIXEL_FORMAT_YV12:
+		return width;
+
+	case CFHD_PIXEL_FORMAT_B48R:
+		return width * 6;
+
+	case CFHD_PIXEL_FORMAT_CT_UCHAR:
+		return width * 2;
+
+	default:
+		CFHD_GetImagePitch(width, format, &pitch);
+		return pitch;
+	}
+}
+
+// Return a buffer size that is large enough for the planar formats
+static inline size_t ImageSize(int width, int height, CFHD_PixelFormat format)
+{
+	return ImagePitch(width, format) * height * 2 + 4096;
+}
+
+/*
+	Fill the RG48 image with smooth RGB gradients.  The columns on the left
+	edge are a strip of saturated colors if saturated_width is not zero and
+	a checkerboard with the amplitude of the detail argument is added to the
+	gradients so that the encoded sample has energy in the highpass bands.
+*/
+static inline void MakeTestImage(std::vector<uint16_t> &image, int width, int height,
+								 int saturated_width, int detail)
+{
+	const int scale = 65535 - detail;
+
+	image.resize(width * height * 3);
+
+	for (int row = 0; row < height; row++)
+	{
+		for (int column = 0; column < width; column++)
+		{
+			uint16_t *pixel = &image[(row * width + column) * 3];
+
+			if (column < saturated_width)
+			{
+				pixel[0] = (row & 1) ? 65535 : 0;
+				pixel[1] = (row & 2) ? 65535 : 0;
+				pixel[2] = (row & 4) ? 65535 : 0;
+			}
+			else
+			{
+				int offset = (((row / 3) + (column / 5)) & 1) ? detail : 0;
+
+				pixel[0] = (uint16_t)(column * scale / (width - 1) + offset);
+				pixel[1] = (uint16_t)(row * scale / (height - 1) + offset);
+				pixel[2] = (uint16_t)((width - 1 - column + row) * scale / (width + height - 2) + offset);
+			}
+		}
+	}
+}
+
+// Return the largest difference between two images in the same pixel format within a range of columns
+static inline int CompareImages(CPixelConverter &converter, const TEST_FORMAT *test, int width, int height,
+								int first_column, int last_column, void *image1, void *image2)
+{
+	const CFHD_PixelFormat reference_format = test->yuv ? CFHD_PIXEL_FORMAT_YU64 : CFHD_PIXEL_FORMAT_RG64;
+	const size_t pitch = ImagePitch(width, test->format);
+	std::vector<uint16_t> reference1(width * height * 4);
+	std::vector<uint16_t> reference2(width * height * 4);
+
+	converter.Convert(image1, pitch, test->format, &reference1[0], width * 8, reference_format, width, height);
+	converter.Convert(image2, pitch, test->format, &reference2[0], width * 8, reference_format, width, height);
+
+	// Components in each row (YU64 has two per pixel and the alpha channel of RG64 is skipped)
+	const int components = test->yuv ? 2 : 4;
+	int max_difference = 0;
+
+	for (int row = 0; row < height; row++)
+	{
+		for (int index = first_column * components; index < last_column * components; index++)
+		{
+			if (!test->yuv && (index & 3) == 3) continue;
+
+			int difference = abs((int)reference1[row * width * 4 + index] - (int)reference2[row * width * 4 + index]);
+			if (max_difference < difference) {
+				max_difference = difference;
+			}
+		}
+	}
+
+	return max_difference;
+}
+
+// Encode the RG48 image as one sample that is valid until the encoder is closed
+static inline CFHD_Error EncodeTestImage(const std::vector<uint16_t> &image, int width, int height,
+										 CFHD_EncodedFormat encoded_format, CFHD_EncoderRef *encoder_out,
+										 void **sample_out, size_t *size_out)
+{
+	CFHD_EncoderRef encoder = NULL;
+
+	CFHD_Error error = CFHD_OpenEncoder(&encoder, NULL);
+	if (error != CFHD_ERROR_OKAY) {
+		return error;
+	}
+
+	error = CFHD_PrepareToEncode(encoder, width, height, CFHD_PIXEL_FORMAT_RG48, encoded_format,
+								 CFHD_ENCODING_FLAGS_NONE, CFHD_ENCODING_QUALITY_FILMSCAN2);
+	if (error == CFHD_ERROR_OKAY) {
+		error = CFHD_EncodeSample(encoder, (void *)&image[0], width * 6);
+	}
+	if (error == CFHD_ERROR_OKAY) {
+		error = CFHD_GetSampleData(encoder, sample_out, size_out);
+	}
+
+	if (error != CFHD_ERROR_OKAY)
+	{
+		CFHD_CloseEncoder(encoder);
+		return error;
+	}
+
+	*encoder_out = encoder;
+	return CFHD_ERROR_OKAY;
+}
+
+/*
+	Decode the sample to the pixel format with a decoder prepared for that
+	output image.  The sample is decoded at full resolution if the width and
+	height are zero, otherwise the decoder must be able to output an image
+	with those dimensions.
+*/
+static inline CFHD_Error DecodeToFormat(void *sample, size_t size, CFHD_PixelFormat format,
+										int width, int height, void *output, size_t pitch)
+{
+	CFHD_DecoderRef decoder = NULL;
+	CFHD_PixelFormat actual_format;
+	int actual_width;
+	int actual_height;
+
+	CFHD_Error error = CFHD_OpenDecoder(&decoder, NULL);
+	if (error != CFHD_ERROR_OKAY) {
+		return error;
+	}
+
+	error = CFHD_PrepareToDecode(decoder, width, height, format, CFHD_DECODED_RESOLUTION_FULL, 0,
+								 sample, size, &actual_width, &actual_height, &actual_format);
+	if (error == CFHD_ERROR_OKAY)
+	{
+		if (actual_format != format || (width != 0 && (actual_width != width || actual_height != height))) {
+			error = CFHD_ERROR_BADFORMAT;
+		}
+		else {
+			error = CFHD_DecodeSample(decoder, sample, size, output, (int)pitch);
+		}
+	}
+
+	CFHD_CloseDecoder(decoder);
+	return error;
+}
@@ -0,0 +1,381 @@
+/*! @file TestValidateSample.cpp
+
+*  @brief Test of the structural checks of encoded samples and the sample CRC
+*
+*  @version 1.0.0
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+/*
+	The test encodes a frame as a YUV 4:2:2 and an RGB 4:4:4 sample and checks:
+
+	1.	The sample is valid and CFHD_ValidateSample returns the CRC of the sample.
+
+	2.	A copy of the sample with one corrupted field returns the error code for
+		that field: the size of a highpass band, the channel sizes in the sample
+		index, the band header and trailer tags, and a truncated sample.  The
+		errors are checked with the codec routine, which returns the reason, and
+		with CFHD_ValidateSample, which returns CFHD_ERROR_BADSAMPLE.
+
+	3.	The CRC computed eight bytes at a time matches a CRC computed one byte
+		at a time for every length from 0 to 64 bytes at every alignment, which
+		covers the bytes left over after the last group of eight bytes.
+
+	The corrupted fields are found by walking the tags of the sample and skipping
+	the size chunks of the bands, in the same way as the sample is validated.
+*/
+
+#include "StdAfx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+#ifndef ASSERT
+#define ASSERT(x)	assert(x)
+#endif
+
+#include "config.h"
+#include "codec.h"
+#include "encoder.h"
+#include "validate.h"
+
+#include "TestUtils.h"
+
+// Dimensions of the encoded frame
+#define DECODE_WIDTH			1280
+#define DECODE_HEIGHT			720
+
+// Amplitude of the fine detail added to the test image for the highpass bands
+#define DETAIL_AMPLITUDE	4096
+
+// Offsets to the fields in the sample that are corrupted by the test
+typedef struct
+{
+	size_t index;				// Offset to the sample index tag
+	size_t band_size;			// Offset to the size chunk tag of the first highpass band
+	size_t band_header;			// Offset to the band header tag at the start of the band data
+	size_t band_trailer;		// Offset to the band trailer tag at the end of the band data
+
+} SAMPLE_FIELDS;
+
+// Read the tag and value at the offset in the sample (the tag of an optional tuple is positive)
+static void ReadSegment(const std::vector<uint8_t> &sample, size_t offset, int *tag_out, int *value_out)
+{
+	const uint8_t *ptr = &sample[offset];
+	int tag = (int16_t)((ptr[0] << 8) | ptr[1]);
+
+	*tag_out = (tag < 0) ? -tag : tag;
+	*value_out = (ptr[2] << 8) | ptr[3];
+}
+
+// Write a 32-bit word at the offset in the sample in the byte order of the bitstream
+static void WriteWord(std::vector<uint8_t> &sample, size_t offset, uint32_t word)
+{
+	sample[offset + 0] = (uint8_t)(word >> 24);
+	sample[offset + 1] = (uint8_t)(word >> 16);
+	sample[offset + 2] = (uint8_t)(word >> 8);
+	sample[offset + 3] = (uint8_t)(word);
+}
+
+static uint32_t ReadWord(const std::vector<uint8_t> &sample, size_t offset)
+{
+	return ((uint32_t)sample[offset + 0] << 24) | ((uint32_t)sample[offset + 1] << 16) |
+		   ((uint32_t)sample[offset + 2] << 8) | (uint32_t)sample[offset + 3];
+}
+
+// Find the sample index and the first highpass band in the sample
+static bool FindSampleFields(const std::vector<uint8_t> &sample, SAMPLE_FIELDS *fields)
+{
+	size_t offset = 0;
+	bool index_found = false;
+
+	while (offset + 8 <= sample.size())
+	{
+		size_t size = 4;
+		int tag, value;
+
+		ReadSegment(sample, offset, &tag, &value);
+
+		if (tag == CODEC_TAG_INDEX && !index_found)
+		{
+			fields->index = offset;
+			index_found = true;
+		}
+		else if (tag == CODEC_TAG_MARKER)
+		{
+			int next_tag, next_value;
+
+			ReadSegment(sample, offset + 4, &next_tag, &next_value);
+			if (next_tag == CODEC_TAG_BAND_NUMBER)
+			{
+				// Skip the band header to the size chunk of the band data
+				for (size_t position = offset + 4; position + 4 <= sample.size(); position += 4)
+				{
+					ReadSegment(sample, position, &tag, &value);
+					if ((tag & 0xFF00) == CODEC_TAG_SUBBAND_SIZE)
+					{
+						size_t band_end = position + 4 + ((((tag & 0xFF) << 16) | value) * 4);
+
+						fields->band_size = position;
+						fields->band_header = position + 4;
+						fields->band_trailer = band_end - 4;
+						return index_found;
+					}
+				}
+				return false;
+			}
+		}
+		else if (tag & CODEC_TAG_CHUNK)
+		{
+			// Skip metadata and other custom chunks
+			if ((tag & CODEC_TAG_CUSTOM_CHUNK24BIT) == CODEC_TAG_CUSTOM_CHUNK24BIT) {
+				size += (((tag & 0xFF) << 16) | value) * 4;
+			}
+			else {
+				size += value * 4;
+			}
+		}
+		else if ((tag & CODEC_TAG_CHUNK24BIT) && (tag & 0xFF00) == CODEC_TAG_SUBBAND_SIZE)
+		{
+			// Skip the lowpass band (the tags inside level and sample size chunks are walked)
+			size += (((tag & 0xFF) << 16) | value) * 4;
+		}
+
+		offset += size;
+	}
+
+	return false;
+}
+
+typedef struct
+{
+	const char *name;
+	CODEC_ERROR expected;
+
+} CORRUPTION;
+
+enum
+{
+	CORRUPT_BAND_SIZE_SHORTER = 0,
+	CORRUPT_BAND_SIZE_LONGER,
+	CORRUPT_CHANNEL_INDEX,
+	CORRUPT_BAND_HEADER,
+	CORRUPT_BAND_TRAILER,
+	CORRUPT_TRUNCATED,
+	CORRUPTION_COUNT
+};
+
+static const CORRUPTION Corruptions[CORRUPTION_COUNT] =
+{
+	{"Band size one word shorter",		CODEC_ERROR_BAND_END_MARKER},
+	{"Band size past the sample end",	CODEC_ERROR_INVALID_BITSTREAM},
+	{"Channel index size changed",		CODEC_ERROR_SAMPLE_INDEX},
+	{"Band header tag overwritten",		CODEC_ERROR_BAND_START_MARKER},
+	{"Band trailer tag overwritten",	CODEC_ERROR_BAND_END_MARKER},
+	{"Sample truncated in a band",		CODEC_ERROR_INVALID_BITSTREAM},
+};
+
+// Corrupt one field in a copy of the sample
+static void CorruptSample(std::vector<uint8_t> &sample, const SAMPLE_FIELDS *fields, int corruption)
+{
+	switch (corruption)
+	{
+	case CORRUPT_BAND_SIZE_SHORTER:
+		WriteWord(sample, fields->band_size, ReadWord(sample, fields->band_size) - 1);
+		break;
+
+	case CORRUPT_BAND_SIZE_LONGER:
+		WriteWord(sample, fields->band_size, ReadWord(sample, fields->band_size) | 0x00FF0000);
+		break;
+
+	case CORRUPT_CHANNEL_INDEX:
+		{
+			// Change the size of the last channel in the index
+			int tag, value;
+			ReadSegment(sample, fields->index, &tag, &value);
+			size_t offset = fields->index + 4 * value;
+			WriteWord(sample, offset, ReadWord(sample, offset) + 4);
+		}
+		break;
+
+	case CORRUPT_BAND_HEADER:
+		WriteWord(sample, fields->band_header, 0);
+		break;
+
+	case CORRUPT_BAND_TRAILER:
+		WriteWord(sample, fields->band_trailer, 0);
+		break;
+
+	case CORRUPT_TRUNCATED:
+		sample.resize(fields->band_trailer);
+		break;
+
+	default:
+		assert(0);
+		break;
+	}
+}
+
+// Compute the CRC-32 one byte at a time without tables
+static uint32_t ReferenceCRC(const uint8_t *buffer, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	for (size_t index = 0; index < length; index++)
+	{
+		crc ^= buffer[index];
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 1) ? (0xEDB88320 ^ (crc >> 1)) : (crc >> 1);
+		}
+	}
+
+	return crc ^ 0xFFFFFFFF;
+}
+
+// Check the valid sample and each corruption of the sample
+static int TestSample(CFHD_EncodedFormat encoded_format, const std::vector<uint8_t> &sample)
+{
+	const char *encoded_name = (encoded_format == CFHD_ENCODED_FORMAT_YUV_422) ? "4:2:2" : "4:4:4";
+	SAMPLE_FIELDS fields;
+	int failures = 0;
+
+	CFHD_DecoderRef decoder = NULL;
+	if (CFHD_OpenDecoder(&decoder, NULL) != CFHD_ERROR_OKAY)
+	{
+		printf("Could not open the decoder\n");
+		return 1;
+	}
+
+	// The valid sample must pass and return the CRC of the sample
+	{
+		std::vector<uint8_t> copy(sample);
+		uint32_t crc = 0;
+		CODEC_ERROR codec_error = ValidateSample(&copy[0], copy.size(), NULL);
+		CFHD_Error error = CFHD_ValidateSample(decoder, &copy[0], copy.size(), CFHD_VALIDATE_FLAGS_COMPUTE_CRC, &crc);
+		bool okay = (codec_error == CODEC_ERROR_OKAY && error == CFHD_ERROR_OKAY &&
+					 crc == ReferenceCRC(&copy[0], copy.size()));
+
+		printf("%s %-32s codec error %3d  error %3d %s\n", encoded_name, "Valid sample and CRC",
+			   codec_error, error, okay ? "ok" : "FAILED");
+		if (!okay) failures++;
+
+		crc ^= 1;
+		error = CFHD_ValidateSample(decoder, &copy[0], copy.size(), CFHD_VALIDATE_FLAGS_CHECK_CRC, &crc);
+		okay = (error == CFHD_ERROR_BAD_CRC);
+
+		printf("%s %-32s codec error %3d  error %3d %s\n", encoded_name, "Wrong CRC",
+			   CODEC_ERROR_OKAY, error, okay ? "ok" : "FAILED");
+		if (!okay) failures++;
+	}
+
+	if (!FindSampleFields(sample, &fields))
+	{
+		printf("%s Could not find the sample index and the first highpass band  FAILED\n", encoded_name);
+		CFHD_CloseDecoder(decoder);
+		return failures + 1;
+	}
+
+	for (int corruption = 0; corruption < CORRUPTION_COUNT; corruption++)
+	{
+		std::vector<uint8_t> copy(sample);
+
+		CorruptSample(copy, &fields, corruption);
+
+		CODEC_ERROR codec_error = ValidateSample(&copy[0], copy.size(), NULL);
+		CFHD_Error error = CFHD_ValidateSample(decoder, &copy[0], copy.size(), CFHD_VALIDATE_FLAGS_NONE, NULL);
+		bool okay = (codec_error == Corruptions[corruption].expected && error == CFHD_ERROR_BADSAMPLE);
+
+		printf("%s %-32s codec error %3d  error %3d (expected %d) %s\n", encoded_name, Corruptions[corruption].name,
+			   codec_error, error, Corruptions[corruption].expected, okay ? "ok" : "FAILED");
+		if (!okay) failures++;
+	}
+
+	CFHD_CloseDecoder(decoder);
+	return failures;
+}
+
+// Compare the CRC computed eight bytes at a time with the reference for short lengths at every alignment
+static int TestCRC(const std::vector<uint8_t> &sample)
+{
+	int failures = 0;
+
+	for (size_t alignment = 0; alignment < 8; alignment++)
+	{
+		for (size_t length = 0; length <= 64; length++)
+		{
+			uint8_t *buffer = (uint8_t *)&sample[alignment];
+
+			if (ComputeSampleCRC(buffer, length) != ReferenceCRC(buffer, length) ||
+				(update_crcA(0xFFFFFFFF, buffer, (int)length) ^ 0xFFFFFFFF) != ReferenceCRC(buffer, length))
+			{
+				printf("CRC of %d bytes at alignment %d differs from one byte at a time  FAILED\n",
+					   (int)length, (int)alignment);
+				failures++;
+			}
+		}
+	}
+
+	// A length that is not a multiple of eight over the entire sample
+	size_t length = sample.size() - 3;
+	if (ComputeSampleCRC((void *)&sample[1], length) != ReferenceCRC(&sample[1], length))
+	{
+		printf("CRC of %d bytes differs from one byte at a time  FAILED\n", (int)length);
+		failures++;
+	}
+
+	printf("CRC checked for lengths 0 to 64 at each alignment and %d bytes\n", (int)length);
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	static const CFHD_EncodedFormat EncodedFormats[] = {CFHD_ENCODED_FORMAT_YUV_422, CFHD_ENCODED_FORMAT_RGB_444};
+	std::vector<uint16_t> image;
+	int failures = 0;
+
+	MakeTestImage(image, DECODE_WIDTH, DECODE_HEIGHT, 0, DETAIL_AMPLITUDE);
+
+	for (size_t index = 0; index < sizeof(EncodedFormats) / sizeof(EncodedFormats[0]); index++)
+	{
+		CFHD_EncoderRef encoder = NULL;
+		void *sample = NULL;
+		size_t size = 0;
+
+		if (EncodeTestImage(image, DECODE_WIDTH, DECODE_HEIGHT, EncodedFormats[index],
+							&encoder, &sample, &size) != CFHD_ERROR_OKAY)
+		{
+			printf("Could not encode the test image\n");
+			failures++;
+			continue;
+		}
+
+		// The sample is copied so that the corruptions do not change the encoder buffer
+		std::vector<uint8_t> copy((uint8_t *)sample, (uint8_t *)sample + size);
+		CFHD_CloseEncoder(encoder);
+
+		failures += TestSample(EncodedFormats[index], copy);
+
+		if (index == 0) {
+			failures += TestCRC(copy);
+		}
+	}
+
+	printf("%d failures\n", failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -57,6 +57,7 @@ int geomesh_dealloc_mesh(geomesh_t *gm)
 
     gm->mesh_allocated = 0;
     gm->mesh_initialized = 0;
+    gm->mesh_points_allocated = 0;
 
     return WARPLIB_SUCCESS;
 }
@@ -65,14 +66,27 @@ int geomesh_alloc_mesh(geomesh_t *gm)
 {
     GEOMESH_CHECK(gm, GEOMESH_CHECK_OBJ_EXISTS);
 
-    geomesh_dealloc_mesh(gm);
     if (gm->meshwidth <= 0 || gm->meshheight <= 0)
+    {
+        geomesh_dealloc_mesh(gm);
         return -1;
+    }
+
+    // keep the mesh arrays if they are large enough (the mesh must be initialized again)
+    if (gm->meshx != NULL && gm->meshy != NULL && gm->mesh_points_allocated >= gm->meshwidth * gm->meshheight)
+    {
+        gm->mesh_allocated = 1;
+        gm->mesh_initialized = 0;
+        return WARPLIB_SUCCESS;
+    }
+
+    geomesh_dealloc_mesh(gm);
 
     gm->meshx = (float *)malloc(gm->meshwidth * gm->meshheight * sizeof(float));
     gm->meshy = (float *)malloc(gm->meshwidth * gm->meshheight * sizeof(float));
 
     gm->mesh_allocated = 1;
+    gm->mesh_points_allocated = gm->meshwidth * gm->meshheight;
 
     return WARPLIB_SUCCESS;
 }
@@ -150,6 +164,8 @@ void * geomesh_create(int meshwidth, int meshheight)
     gm->mesh_initialized = 0;
     gm->num_elements_allocated = 0;
     gm->cache_initialized = 0;
+    gm->mesh_points_allocated = 0;
+    gm->cache_bytes_allocated = 0;
     gm->xstep = 0;
     gm->ystep = 0;
 
@@ -55,6 +55,7 @@ int geomesh_dealloc_cache(geomesh_t *gm)
 
     gm->num_elements_allocated = 0;
     gm->cache_initialized = 0;
+    gm->cache_bytes_allocated = 0;
 
     return WARPLIB_SUCCESS;
 }
@@ -63,11 +64,14 @@ int geomesh_dealloc_cache(geomesh_t *gm)
 int geomesh_alloc_cache(geomesh_t *gm)
 {
     int elements_per_pixel = 3;
+    size_t cache_bytes;
     GEOMESH_CHECK(gm, GEOMESH_CHECK_OBJ_EXISTS);
 
-    geomesh_dealloc_cache(gm);
     if (gm->destwidth <= 0 || gm->destheight <= 0)
+    {
+        geomesh_dealloc_cache(gm);
         return -1;
+    }
 
     if(gm->srcsubsampled)
         elements_per_pixel++;
@@ -75,8 +79,21 @@ int geomesh_alloc_cache(geomesh_t *gm)
     if(gm->backgroundfill)
         elements_per_pixel++;
 
-    gm->cache = (int *)malloc(elements_per_pixel * gm->destwidth * gm->destheight * sizeof(int));
+    cache_bytes = (size_t)elements_per_pixel * gm->destwidth * gm->destheight * sizeof(int);
+
+    // keep the cache if it is large enough (the cache must be initialized again)
+    if (gm->cache != NULL && gm->cache_bytes_allocated >= cache_bytes)
+    {
+        gm->num_elements_allocated = elements_per_pixel;
+        gm->cache_initialized = 0;
+        return WARPLIB_SUCCESS;
+    }
+
+    geomesh_dealloc_cache(gm);
+
+    gm->cache = (int *)malloc(cache_bytes);
     gm->num_elements_allocated = elements_per_pixel;
+    gm->cache_bytes_allocated = cache_bytes;
 
     return WARPLIB_SUCCESS;
 }
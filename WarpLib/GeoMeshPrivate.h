@@ -61,6 +61,8 @@ typedef struct geomesh_tag
     char         mesh_initialized;
     char         num_elements_allocated;
     char         cache_initialized;
+    int          mesh_points_allocated; // capacity of the mesh arrays (kept when the mesh is resized to the same or a smaller size)
+    size_t       cache_bytes_allocated; // capacity of the cache (kept when the cache is reallocated for the same or a smaller image)
     
     float        xstep; // step to bridge the discrepancy between the destination width and the mesh width
     float        ystep; // step to bridge the discrepancy between the destination height and the mesh height